@@ -33,6 +33,7 @@
 #include "interfaces/ihavediaginfo.h"
 #include "core.h"
 #include "coreproxy.h"
+#include "entityroutingcache.h"
 
 namespace LeechCraft
 {
@@ -215,6 +216,10 @@ namespace LeechCraft
 		text += QString ("Running on: %1\n").arg (Util::SysInfo::GetOSName ());
 		text += "--------------------------------\n\n";
 
+		text += "Entity routing:\n";
+		text += Core::Instance ().GetEntityRoutingCache ()->GetStatsString ();
+		text += "--------------------------------\n\n";
+
 		QStringList loadedModules;
 		QStringList unPathedModules;
 		PluginManager *pm = Core::Instance ().GetPluginManager ();
@@ -80,6 +80,7 @@
 #include "coreplugin2manager.h"
 #include "dockmanager.h"
 #include "entitymanager.h"
+#include "entityroutingcache.h"
 #include "rootwindowsmanager.h"
 
 using namespace LeechCraft::Util;
@@ -88,6 +89,7 @@ namespace LeechCraft
 {
 	Core::Core ()
 	: PluginManager_ (0)
+	, EntityRoutingCache_ (0)
 	, NetworkAccessManager_ (new NetworkAccessManager)
 	, StorageBackend_ (new SQLStorageBackend)
 	, LocalSocketHandler_ (new LocalSocketHandler)
@@ -131,6 +133,11 @@ namespace LeechCraft
 				paths << QString::fromUtf8 (plugin.c_str ());
 		}
 		PluginManager_ = new PluginManager (paths, this);
+		EntityRoutingCache_ = new EntityRoutingCache (PluginManager_, this);
+		connect (PluginManager_,
+				SIGNAL (initStageChanged (PluginManager::InitStage)),
+				EntityRoutingCache_,
+				SLOT (invalidate ()));
 	}
 
 	Core::~Core ()
@@ -151,6 +158,20 @@ namespace LeechCraft
 		LocalSocketHandler_.reset ();
 		XmlSettingsManager::Instance ()->setProperty ("FirstStart", "false");
 
+		const auto& routingStats = EntityRoutingCache_->GetStats ();
+		qDebug () << Q_FUNC_INFO
+				<< "dispatched"
+				<< routingStats.Dispatched_
+				<< "entities, spent"
+				<< routingStats.ProbeNsecs_ / 1000000
+				<< "ms in"
+				<< routingStats.Probes_
+				<< "handler probes; routing cache hits/misses:"
+				<< routingStats.CacheHits_
+				<< routingStats.CacheMisses_
+				<< "hit rate:"
+				<< routingStats.HitRate_;
+
 		PluginManager_->Release ();
 		delete PluginManager_;
 
@@ -206,6 +227,11 @@ namespace LeechCraft
 		return PluginManager_;
 	}
 
+	EntityRoutingCache* Core::GetEntityRoutingCache () const
+	{
+		return EntityRoutingCache_;
+	}
+
 	StorageBackend* Core::GetStorageBackend () const
 	{
 		return StorageBackend_.get ();
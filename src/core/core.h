@@ -54,6 +54,7 @@ namespace LeechCraft
 	class LocalSocketHandler;
 	class CoreInstanceObject;
 	class DockManager;
+	class EntityRoutingCache;
 
 	/** Contains all the plugins' models, maps from end-user's tree view
 	 * to plugins' models and much more.
@@ -63,6 +64,7 @@ namespace LeechCraft
 		Q_OBJECT
 
 		PluginManager *PluginManager_;
+		EntityRoutingCache *EntityRoutingCache_;
 		std::shared_ptr<QNetworkAccessManager> NetworkAccessManager_;
 		std::shared_ptr<StorageBackend> StorageBackend_;
 		std::shared_ptr<LocalSocketHandler> LocalSocketHandler_;
@@ -127,6 +129,11 @@ namespace LeechCraft
 		 */
 		PluginManager* GetPluginManager () const;
 
+		/** Returns the cache of the entity handlers and downloaders
+		 * used by the EntityManager.
+		 */
+		EntityRoutingCache* GetEntityRoutingCache () const;
+
 		/** Returns pointer to the storage backend of the Core.
 		 */
 		StorageBackend* GetStorageBackend () const;
@@ -31,6 +31,7 @@
 #include <functional>
 #include <algorithm>
 #include <QDesktopServices>
+#include <QElapsedTimer>
 #include <QUrl>
 #include "util/util.h"
 #include "util/sll/prelude.h"
@@ -41,6 +42,7 @@
 #include "interfaces/entitytesthandleresult.h"
 #include "core.h"
 #include "pluginmanager.h"
+#include "entityroutingcache.h"
 #include "xmlsettingsmanager.h"
 #include "handlerchoicedialog.h"
 
@@ -54,33 +56,45 @@ namespace LeechCraft
 	namespace
 	{
 		template<typename T, typename F>
-		QObjectList GetSubtype (const Entity& e, bool fullScan, const F& queryFunc)
+		QObjectList GetSubtype (const Entity& e, bool fullScan,
+				const EntityRoutingCache::Candidates_t& candidates, const F& queryFunc)
 		{
-			auto pm = Core::Instance ().GetPluginManager ();
+			auto cache = Core::Instance ().GetEntityRoutingCache ();
 			QMap<int, QObjectList> result;
 			int cutoffPriority = 0;
-			for (const auto& plugin : pm->GetAllCastableRoots<T> ())
+			for (const auto& candidate : candidates)
 			{
+				const auto plugin = candidate.Plugin_;
+
 				EntityTestHandleResult r;
-				try
-				{
-					r = queryFunc (e, qobject_cast<T> (plugin));
-				}
-				catch (const std::exception& e)
+				if (candidate.IsStatic_)
+					r = candidate.StaticResult_;
+				else
 				{
-					qWarning () << Q_FUNC_INFO
-						<< "could not query"
-						<< e.what ()
-						<< plugin;
-					continue;
-				}
-				catch (...)
-				{
-					qWarning () << Q_FUNC_INFO
-						<< "could not query"
-						<< plugin;
-					continue;
+					QElapsedTimer probeTimer;
+					probeTimer.start ();
+					try
+					{
+						r = queryFunc (e, qobject_cast<T> (plugin));
+					}
+					catch (const std::exception& e)
+					{
+						qWarning () << Q_FUNC_INFO
+							<< "could not query"
+							<< e.what ()
+							<< plugin;
+						continue;
+					}
+					catch (...)
+					{
+						qWarning () << Q_FUNC_INFO
+							<< "could not query"
+							<< plugin;
+						continue;
+					}
+					cache->RegisterProbe (probeTimer.nsecsElapsed ());
 				}
+
 				if (r.HandlePriority_ <= 0)
 					continue;
 
@@ -124,10 +138,12 @@ namespace LeechCraft
 				handlers.erase (remBegin, handlers.end ());
 			};
 
+			const auto& route = Core::Instance ().GetEntityRoutingCache ()->GetRoute (e);
+
 			QObjectList result;
 			if (!(e.Parameters_ & TaskParameter::OnlyHandle))
 			{
-				auto sub = GetSubtype<IDownload*> (e, true,
+				auto sub = GetSubtype<IDownload*> (e, true, route.Downloaders_,
 						[] (Entity e, IDownload *dl) { return dl->CouldDownload (e); });
 				removeUnwanted (sub);
 				if (downloaders)
@@ -136,7 +152,7 @@ namespace LeechCraft
 			}
 			if (!(e.Parameters_ & TaskParameter::OnlyDownload))
 			{
-				auto sub = GetSubtype<IEntityHandler*> (e, true,
+				auto sub = GetSubtype<IEntityHandler*> (e, true, route.Handlers_,
 						[] (Entity e, IEntityHandler *eh) { return eh->CouldHandle (e); });
 				removeUnwanted (sub);
 				if (handlers)
@@ -266,6 +282,8 @@ namespace LeechCraft
 		if (!CheckInitStage (e, desired, &EntityManager::DelegateEntity))
 			return {};
 
+		Core::Instance ().GetEntityRoutingCache ()->RegisterDispatch ();
+
 		e.Parameters_ |= OnlyDownload;
 		QObjectList handlers;
 		const bool foundOk = GetPreparedObjectList (e, desired, handlers, false);
@@ -299,6 +317,8 @@ namespace LeechCraft
 		if (!CheckInitStage (e, desired, &EntityManager::HandleEntity))
 			return false;
 
+		Core::Instance ().GetEntityRoutingCache ()->RegisterDispatch ();
+
 		QObjectList handlers;
 		const bool foundOk = GetPreparedObjectList (e, desired, handlers, true);
 		if (!foundOk || handlers.isEmpty ())
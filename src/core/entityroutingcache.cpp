@@ -0,0 +1,257 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "entityroutingcache.h"
+#include <QUrl>
+#include <QMutexLocker>
+#include <QtDebug>
+#include <interfaces/idownload.h>
+#include <interfaces/ientityhandler.h>
+#include <interfaces/core/ipluginsmanager.h>
+
+namespace LeechCraft
+{
+	EntityRoutingCache::Signature::Signature (const Entity& e)
+	: Mime_ (e.Mime_)
+	, IsUrl_ (e.Entity_.type () == QVariant::Url)
+	, Scheme_ (IsUrl_ ? e.Entity_.toUrl ().scheme () : QString ())
+	, Params_ (e.Parameters_)
+	{
+	}
+
+	bool operator== (const EntityRoutingCache::Signature& s1, const EntityRoutingCache::Signature& s2)
+	{
+		return s1.Params_ == s2.Params_ &&
+				s1.IsUrl_ == s2.IsUrl_ &&
+				s1.Mime_ == s2.Mime_ &&
+				s1.Scheme_ == s2.Scheme_;
+	}
+
+	uint qHash (const EntityRoutingCache::Signature& s)
+	{
+		return qHash (s.Mime_) ^
+				(qHash (s.Scheme_) << 1) ^
+				(static_cast<uint> (s.Params_) << 8) ^
+				static_cast<uint> (s.IsUrl_);
+	}
+
+	EntityRoutingCache::EntityRoutingCache (IPluginsManager *pm, QObject *parent)
+	: QObject (parent)
+	, PM_ (pm)
+	{
+		connect (PM_->GetQObject (),
+				SIGNAL (pluginInjected (QObject*)),
+				this,
+				SLOT (invalidate ()));
+		connect (PM_->GetQObject (),
+				SIGNAL (pluginAboutToBeUnloaded (QObject*)),
+				this,
+				SLOT (invalidate ()));
+
+		RateWindow_.start ();
+	}
+
+	EntityRoutingCache::Route EntityRoutingCache::GetRoute (const Entity& e)
+	{
+		const Signature sig { e };
+
+		QMutexLocker locker { &Lock_ };
+		const auto pos = Routes_.constFind (sig);
+		if (pos != Routes_.constEnd ())
+		{
+			++CacheHits_;
+			return *pos;
+		}
+
+		++CacheMisses_;
+		const auto& route = BuildRoute (sig);
+		Routes_ [sig] = route;
+		return route;
+	}
+
+	void EntityRoutingCache::RegisterDispatch ()
+	{
+		QMutexLocker locker { &Lock_ };
+		++Dispatched_;
+		++WindowDispatched_;
+
+		const auto elapsed = RateWindow_.elapsed ();
+		if (elapsed < 1000)
+			return;
+
+		LastRate_ = WindowDispatched_ * 1000.0 / elapsed;
+		WindowDispatched_ = 0;
+		RateWindow_.restart ();
+	}
+
+	void EntityRoutingCache::RegisterProbe (qint64 nsecs)
+	{
+		QMutexLocker locker { &Lock_ };
+		++Probes_;
+		ProbeNsecs_ += nsecs;
+	}
+
+	EntityRoutingCache::Stats EntityRoutingCache::GetStats () const
+	{
+		QMutexLocker locker { &Lock_ };
+
+		// The last full window is only replaced on the next dispatch, so
+		// the current one is used if it is already longer, letting the
+		// rate decay while no entities are dispatched.
+		const auto elapsed = RateWindow_.elapsed ();
+		const auto rate = elapsed >= 1000 ?
+				WindowDispatched_ * 1000.0 / elapsed :
+				LastRate_;
+
+		const auto lookups = CacheHits_ + CacheMisses_;
+		return
+		{
+			Dispatched_,
+			rate,
+			Probes_,
+			ProbeNsecs_,
+			CacheHits_,
+			CacheMisses_,
+			lookups ? static_cast<double> (CacheHits_) / lookups : 0
+		};
+	}
+
+	QString EntityRoutingCache::GetStatsString () const
+	{
+		const auto& stats = GetStats ();
+		return QString ("Dispatched entities: %1 (%2 per second)
+"
+					"Handler probes: %3, %4 ms total
+"
+					"Routing cache hits/misses: %5/%6 (hit rate %7%)
+")
+				.arg (stats.Dispatched_)
+				.arg (stats.DispatchedPerSecond_, 0, 'f', 1)
+				.arg (stats.Probes_)
+				.arg (stats.ProbeNsecs_ / 1000000)
+				.arg (stats.CacheHits_)
+				.arg (stats.CacheMisses_)
+				.arg (stats.HitRate_ * 100, 0, 'f', 1);
+	}
+
+	namespace
+	{
+		bool MimeMatches (const QStringList& mimes, const QString& mime)
+		{
+			if (mimes.isEmpty ())
+				return true;
+
+			for (const auto& candidate : mimes)
+			{
+				if (candidate.endsWith ('*'))
+				{
+					if (mime.startsWith (candidate.leftRef (candidate.size () - 1)))
+						return true;
+				}
+				else if (candidate == mime)
+					return true;
+			}
+
+			return false;
+		}
+
+		bool RuleMatches (const EntityRoutingRule& rule, const EntityRoutingCache::Signature& sig)
+		{
+			if ((sig.Params_ & rule.Required_) != rule.Required_)
+				return false;
+			if (sig.Params_ & rule.Forbidden_)
+				return false;
+
+			if (!rule.Schemes_.isEmpty () &&
+					(!sig.IsUrl_ || !rule.Schemes_.contains (sig.Scheme_)))
+				return false;
+
+			return MimeMatches (rule.Mimes_, sig.Mime_);
+		}
+	}
+
+	EntityRoutingCache::Route EntityRoutingCache::BuildRoute (const Signature& sig)
+	{
+		Route route;
+		if (!(sig.Params_ & TaskParameter::OnlyHandle))
+			route.Downloaders_ = BuildCandidates<IDownload*> (sig);
+		if (!(sig.Params_ & TaskParameter::OnlyDownload))
+			route.Handlers_ = BuildCandidates<IEntityHandler*> (sig);
+		return route;
+	}
+
+	template<typename T>
+	EntityRoutingCache::Candidates_t EntityRoutingCache::BuildCandidates (const Signature& sig)
+	{
+		Candidates_t result;
+		for (const auto plugin : PM_->GetAllCastableRoots<T> ())
+		{
+			const auto irr = qobject_cast<IEntityRoutingRules*> (plugin);
+			if (!irr)
+			{
+				result.append (Candidate { plugin, false, {} });
+				continue;
+			}
+
+			if (!Rules_.contains (plugin))
+				Rules_ [plugin] = irr->GetEntityRoutingRules ();
+
+			bool matched = false;
+			bool allStatic = true;
+			EntityTestHandleResult staticResult;
+			for (const auto& rule : Rules_ [plugin])
+			{
+				if (!RuleMatches (rule, sig))
+					continue;
+
+				matched = true;
+				if (rule.StaticResult_.HandlePriority_ <= 0)
+					allStatic = false;
+				else if (rule.StaticResult_.HandlePriority_ > staticResult.HandlePriority_)
+					staticResult = rule.StaticResult_;
+			}
+
+			if (!matched)
+				continue;
+
+			if (allStatic)
+				result.append (Candidate { plugin, true, staticResult });
+			else
+				result.append (Candidate { plugin, false, {} });
+		}
+		return result;
+	}
+
+	void EntityRoutingCache::invalidate ()
+	{
+		QMutexLocker locker { &Lock_ };
+		Routes_.clear ();
+		Rules_.clear ();
+	}
+}
@@ -0,0 +1,148 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <interfaces/structures.h>
+#include <interfaces/entitytesthandleresult.h>
+#include <interfaces/ientityroutingrules.h>
+
+class IPluginsManager;
+
+namespace LeechCraft
+{
+	/** Caches the lists of plugins that should be queried for entities
+	 * of a given kind, so that the plugins that have declared their
+	 * interests via IEntityRoutingRules aren't polled for each entity,
+	 * and the whole plugins list isn't filtered over and over again.
+	 *
+	 * The entities are grouped by their signature: the MIME type, the
+	 * URL scheme (if the entity is an URL) and the task parameters.
+	 *
+	 * The cache is dropped whenever a plugin is injected or is about to
+	 * be unloaded. The owner should also call invalidate() when the
+	 * plugins manager changes its init stage.
+	 *
+	 * All methods are thread-safe, since entities might be dispatched
+	 * from threads other than the GUI one.
+	 */
+	class EntityRoutingCache : public QObject
+	{
+		Q_OBJECT
+
+		IPluginsManager * const PM_;
+	public:
+		struct Candidate
+		{
+			QObject *Plugin_;
+
+			/** Whether StaticResult_ should be used instead of querying
+			 * the plugin.
+			 */
+			bool IsStatic_;
+			EntityTestHandleResult StaticResult_;
+		};
+		typedef QList<Candidate> Candidates_t;
+
+		struct Route
+		{
+			Candidates_t Downloaders_;
+			Candidates_t Handlers_;
+		};
+
+		struct Signature
+		{
+			QString Mime_;
+			bool IsUrl_;
+			QString Scheme_;
+			TaskParameters Params_;
+
+			Signature (const Entity&);
+		};
+
+		struct Stats
+		{
+			quint64 Dispatched_;
+			double DispatchedPerSecond_;
+
+			quint64 Probes_;
+			qint64 ProbeNsecs_;
+
+			quint64 CacheHits_;
+			quint64 CacheMisses_;
+
+			/** The share of the routes taken from the cache, from 0 to 1.
+			 */
+			double HitRate_;
+		};
+	private:
+		mutable QMutex Lock_;
+
+		QHash<Signature, Route> Routes_;
+		QHash<QObject*, QList<EntityRoutingRule>> Rules_;
+
+		quint64 Dispatched_ = 0;
+		quint64 Probes_ = 0;
+		qint64 ProbeNsecs_ = 0;
+		quint64 CacheHits_ = 0;
+		quint64 CacheMisses_ = 0;
+
+		QElapsedTimer RateWindow_;
+		quint64 WindowDispatched_ = 0;
+		double LastRate_ = 0;
+	public:
+		EntityRoutingCache (IPluginsManager*, QObject* = 0);
+
+		Route GetRoute (const Entity&);
+
+		void RegisterDispatch ();
+		void RegisterProbe (qint64 nsecs);
+
+		Stats GetStats () const;
+
+		/** Returns the human-readable statistics for the diagnostic
+		 * info.
+		 */
+		QString GetStatsString () const;
+	private:
+		Route BuildRoute (const Signature&);
+
+		template<typename T>
+		Candidates_t BuildCandidates (const Signature&);
+	public slots:
+		void invalidate ();
+	};
+
+	bool operator== (const EntityRoutingCache::Signature&, const EntityRoutingCache::Signature&);
+	uint qHash (const EntityRoutingCache::Signature&);
+}
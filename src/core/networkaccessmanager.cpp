@@ -53,6 +53,16 @@ Q_DECLARE_METATYPE (QNetworkReply*);
 using namespace LeechCraft;
 using namespace LeechCraft::Util;
 
+namespace
+{
+	const qint64 MinCookiesCompactSize = 64 * 1024;
+
+	QString GetCookiesPath ()
+	{
+		return QDir::homePath () + "/.leechcraft/core/cookies.txt";
+	}
+}
+
 NetworkAccessManager::NetworkAccessManager (QObject *parent)
 : QNetworkAccessManager (parent)
 , CookieSaveTimer_ (new QTimer (this))
@@ -114,10 +124,13 @@ NetworkAccessManager::NetworkAccessManager (QObject *parent)
 			<< "so continuing without cache";
 	}
 
-	QFile file (QDir::homePath () +
-			"/.leechcraft/core/cookies.txt");
+	QFile file (GetCookiesPath ());
 	if (file.open (QIODevice::ReadOnly))
-		CookieJar_->Load (file.readAll ());
+	{
+		const auto& data = file.readAll ();
+		CookieJar_->Load (data);
+		CookiesBaseSize_ = data.size ();
+	}
 	else
 		qWarning () << Q_FUNC_INFO
 			<< "could not open file"
@@ -219,7 +232,7 @@ void LeechCraft::NetworkAccessManager::handleSslErrors (QNetworkReply *replyObj,
 	new SslErrorsHandler { replyObj, errors };
 }
 
-void LeechCraft::NetworkAccessManager::saveCookies () const
+bool LeechCraft::NetworkAccessManager::WriteCookies (const QByteArray& data, bool append)
 {
 	QDir dir = QDir::home ();
 	dir.cd (".leechcraft");
@@ -227,22 +240,64 @@ void LeechCraft::NetworkAccessManager::saveCookies () const
 			!dir.mkdir ("core"))
 	{
 		emit error (tr ("Could not create Core directory."));
-		return;
+		return false;
 	}
 
-	QFile file (QDir::homePath () +
-			"/.leechcraft/core/cookies.txt");
-	if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+	QFile file (GetCookiesPath ());
+	if (!file.open (QIODevice::WriteOnly | (append ? QIODevice::Append : QIODevice::Truncate)))
 	{
 		emit error (tr ("Could not save cookies, error opening cookie file."));
 		qWarning () << Q_FUNC_INFO
 			<< file.errorString ();
-		return;
+		return false;
+	}
+
+	if (file.write (data) != data.size ())
+	{
+		qWarning () << Q_FUNC_INFO
+			<< "error writing cookies:"
+			<< file.errorString ();
+		return false;
 	}
 
+	return true;
+}
+
+void LeechCraft::NetworkAccessManager::saveCookies ()
+{
 	const bool saveEnabled = !XmlSettingsManager::Instance ()->
 			property ("DeleteCookiesOnExit").toBool ();
-	file.write (saveEnabled ? CookieJar_->Save () : QByteArray ());
+	if (!saveEnabled)
+	{
+		CookieJar_->TakeChanges ();
+		if ((CookiesBaseSize_ || CookiesJournalSize_) &&
+				WriteCookies ({}, false))
+			CookiesBaseSize_ = CookiesJournalSize_ = 0;
+		CookiesFileStale_ = true;
+		return;
+	}
+
+	// The changed cookies are appended to the file, and Load() lets the
+	// later entries override the earlier ones. Once the appended part
+	// gets bigger than the base one, the file is rewritten from scratch.
+	const bool fullSave = CookiesFileStale_ ||
+			CookieJar_->NeedsFullSave () ||
+			CookiesJournalSize_ > std::max (CookiesBaseSize_, MinCookiesCompactSize);
+	if (fullSave)
+	{
+		CookieJar_->TakeChanges ();
+
+		const auto& data = CookieJar_->Save ();
+		CookiesFileStale_ = !WriteCookies (data, false);
+		CookiesBaseSize_ = data.size ();
+		CookiesJournalSize_ = 0;
+	}
+	else if (CookieJar_->HasChanges ())
+	{
+		const auto& changes = CookieJar_->TakeChanges ();
+		CookiesFileStale_ = !WriteCookies (changes, true);
+		CookiesJournalSize_ += changes.size ();
+	}
 }
 
 void LeechCraft::NetworkAccessManager::handleFilterTrackingCookies ()
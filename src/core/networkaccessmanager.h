@@ -51,6 +51,10 @@ namespace LeechCraft
 		QTimer * const CookieSaveTimer_;
 
 		Util::CustomCookieJar *CookieJar_;
+
+		qint64 CookiesBaseSize_ = 0;
+		qint64 CookiesJournalSize_ = 0;
+		bool CookiesFileStale_ = false;
 	public:
 		NetworkAccessManager (QObject* = 0);
 		virtual ~NetworkAccessManager ();
@@ -59,12 +63,13 @@ namespace LeechCraft
 				const QNetworkRequest&, QIODevice*);
 	private:
 		void DoCommonAuth (const QString&, QAuthenticator*);
+		bool WriteCookies (const QByteArray&, bool append);
 	private slots:
 		void handleAuthentication (QNetworkReply*, QAuthenticator*);
 		void handleAuthentication (const QNetworkProxy&, QAuthenticator*);
 		void handleSslErrors (QNetworkReply*, const QList<QSslError>&);
 
-		void saveCookies () const;
+		void saveCookies ();
 		void handleFilterTrackingCookies ();
 		void setCookiesEnabled ();
 		void setMatchDomainExactly ();
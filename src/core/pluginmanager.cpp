@@ -442,6 +442,7 @@ namespace LeechCraft
 
 			qDebug () << "trying to unload"
 					<< object;
+			emit pluginAboutToBeUnloaded (object);
 			Obj2Loader_ [object]->Unload ();
 			Obj2Loader_.remove (object);
 
@@ -556,6 +557,7 @@ namespace LeechCraft
 					continue;
 				}
 				qDebug () << "Releasing" << ii->GetName ();
+				emit pluginAboutToBeUnloaded (obj);
 				ii->Release ();
 
 				const auto& loader = Obj2Loader_.value (obj);
@@ -703,6 +705,8 @@ namespace LeechCraft
 
 	void PluginManager::ReleasePlugin (QObject *object)
 	{
+		emit pluginAboutToBeUnloaded (object);
+
 		try
 		{
 			qDebug () << "Releasing"
@@ -178,6 +178,11 @@ namespace LeechCraft
 		QList<Plugins_t::iterator> FindProviders (const QSet<QByteArray>&);
 	signals:
 		void pluginInjected (QObject*);
+
+		/** Emitted before the plugin is released and its library is
+		 * unloaded, so that the pointers to it can be dropped.
+		 */
+		void pluginAboutToBeUnloaded (QObject*);
 		void loadProgress (const QString&);
 
 		void initStageChanged (PluginManager::InitStage);
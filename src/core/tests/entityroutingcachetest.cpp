@@ -0,0 +1,323 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "entityroutingcachetest.h"
+#include <QtTest>
+#include <QUrl>
+#include "../entityroutingcache.h"
+
+QTEST_MAIN (LeechCraft::EntityRoutingCacheTest)
+
+namespace LeechCraft
+{
+	QObjectList FakePluginsManager::GetAllPlugins () const
+	{
+		return Plugins_;
+	}
+
+	QObject* FakePluginsManager::GetPluginByID (const QByteArray&) const
+	{
+		return nullptr;
+	}
+
+	QString FakePluginsManager::GetPluginLibraryPath (const QObject*) const
+	{
+		return {};
+	}
+
+	void FakePluginsManager::InjectPlugin (QObject *plugin)
+	{
+		Plugins_ << plugin;
+		emit pluginInjected (plugin);
+	}
+
+	void FakePluginsManager::ReleasePlugin (QObject *plugin)
+	{
+		emit pluginAboutToBeUnloaded (plugin);
+		Plugins_.removeAll (plugin);
+	}
+
+	QObject* FakePluginsManager::GetQObject ()
+	{
+		return this;
+	}
+
+	void FakePluginsManager::OpenSettings (QObject*)
+	{
+	}
+
+	ILoadProgressReporter_ptr FakePluginsManager::CreateLoadProgressReporter (QObject*)
+	{
+		return {};
+	}
+
+	EntityTestHandleResult PlainHandler::CouldHandle (const Entity&) const
+	{
+		return {};
+	}
+
+	void PlainHandler::Handle (Entity)
+	{
+	}
+
+	RoutedHandler::RoutedHandler (const QList<EntityRoutingRule>& rules)
+	: Rules_ (rules)
+	{
+	}
+
+	EntityTestHandleResult RoutedHandler::CouldHandle (const Entity&) const
+	{
+		return {};
+	}
+
+	void RoutedHandler::Handle (Entity)
+	{
+	}
+
+	QList<EntityRoutingRule> RoutedHandler::GetEntityRoutingRules () const
+	{
+		++RulesQueries_;
+		return Rules_;
+	}
+
+	namespace
+	{
+		Entity MakeEntity (const QVariant& entity, const QString& mime = {},
+				TaskParameters params = NoParameters)
+		{
+			Entity e;
+			e.Entity_ = entity;
+			e.Mime_ = mime;
+			e.Parameters_ = params;
+			return e;
+		}
+
+		QObjectList GetHandlers (EntityRoutingCache& cache, const Entity& e)
+		{
+			QObjectList result;
+			for (const auto& candidate : cache.GetRoute (e).Handlers_)
+				result << candidate.Plugin_;
+			return result;
+		}
+	}
+
+	void EntityRoutingCacheTest::testSchemes ()
+	{
+		EntityRoutingRule rule;
+		rule.Schemes_ = QStringList { "http", "https" };
+
+		RoutedHandler handler { QList<EntityRoutingRule> { rule } };
+		FakePluginsManager pm;
+		pm.InjectPlugin (&handler);
+		EntityRoutingCache cache { &pm };
+
+		const QObjectList expected { &handler };
+		QCOMPARE (GetHandlers (cache, MakeEntity (QUrl { "http://example.com/" })), expected);
+		QCOMPARE (GetHandlers (cache, MakeEntity (QUrl { "https://example.com/" })), expected);
+		QCOMPARE (GetHandlers (cache, MakeEntity (QUrl { "ftp://example.com/" })), QObjectList {});
+
+		// A rule with schemes never matches non-URL entities.
+		QCOMPARE (GetHandlers (cache, MakeEntity (QString { "http://example.com/" })), QObjectList {});
+	}
+
+	void EntityRoutingCacheTest::testMimes ()
+	{
+		EntityRoutingRule notifications;
+		notifications.Mimes_ = QStringList { "x-leechcraft/notification*" };
+		EntityRoutingRule anything;
+
+		RoutedHandler notifHandler { QList<EntityRoutingRule> { notifications } };
+		RoutedHandler anyHandler { QList<EntityRoutingRule> { anything } };
+		FakePluginsManager pm;
+		pm.InjectPlugin (&notifHandler);
+		pm.InjectPlugin (&anyHandler);
+		EntityRoutingCache cache { &pm };
+
+		const QObjectList both { &notifHandler, &anyHandler };
+		const QObjectList any { &anyHandler };
+		QCOMPARE (GetHandlers (cache, MakeEntity ({}, "x-leechcraft/notification")), both);
+		QCOMPARE (GetHandlers (cache, MakeEntity ({}, "x-leechcraft/notification+advanced")), both);
+		QCOMPARE (GetHandlers (cache, MakeEntity ({}, "x-leechcraft/data-filter-request")), any);
+		QCOMPARE (GetHandlers (cache, MakeEntity (QString { "text" })), any);
+	}
+
+	void EntityRoutingCacheTest::testParameters ()
+	{
+		EntityRoutingRule rule;
+		rule.Required_ = FromUserInitiated;
+		rule.Forbidden_ = Internal;
+
+		RoutedHandler handler { QList<EntityRoutingRule> { rule } };
+		FakePluginsManager pm;
+		pm.InjectPlugin (&handler);
+		EntityRoutingCache cache { &pm };
+
+		const QObjectList expected { &handler };
+		QCOMPARE (GetHandlers (cache, MakeEntity ({}, {}, FromUserInitiated)), expected);
+		QCOMPARE (GetHandlers (cache, MakeEntity ({}, {}, FromUserInitiated | AutoAccept)), expected);
+		QCOMPARE (GetHandlers (cache, MakeEntity ({}, {}, NoParameters)), QObjectList {});
+		QCOMPARE (GetHandlers (cache, MakeEntity ({}, {}, FromUserInitiated | Internal)), QObjectList {});
+	}
+
+	void EntityRoutingCacheTest::testStaticResult ()
+	{
+		EntityRoutingRule queried;
+		queried.Mimes_ = QStringList { "text/plain" };
+
+		EntityRoutingRule fixed;
+		fixed.Mimes_ = QStringList { "x-leechcraft/notification" };
+		fixed.StaticResult_ = EntityTestHandleResult { EntityTestHandleResult::PHigh };
+
+		RoutedHandler handler { QList<EntityRoutingRule> { queried, fixed } };
+		FakePluginsManager pm;
+		pm.InjectPlugin (&handler);
+		EntityRoutingCache cache { &pm };
+
+		const auto& queriedRoute = cache.GetRoute (MakeEntity ({}, "text/plain")).Handlers_;
+		QCOMPARE (queriedRoute.size (), 1);
+		QVERIFY (!queriedRoute.at (0).IsStatic_);
+
+		const auto& fixedRoute = cache.GetRoute (MakeEntity ({}, "x-leechcraft/notification")).Handlers_;
+		QCOMPARE (fixedRoute.size (), 1);
+		QVERIFY (fixedRoute.at (0).IsStatic_);
+		QCOMPARE (fixedRoute.at (0).StaticResult_.HandlePriority_,
+				static_cast<int> (EntityTestHandleResult::PHigh));
+	}
+
+	void EntityRoutingCacheTest::testMixedStaticResult ()
+	{
+		EntityRoutingRule anyText;
+		anyText.Mimes_ = QStringList { "text/*" };
+
+		EntityRoutingRule fixed;
+		fixed.Mimes_ = QStringList { "text/plain", "text/html" };
+		fixed.StaticResult_ = EntityTestHandleResult { EntityTestHandleResult::PLow };
+
+		EntityRoutingRule fixedHigh;
+		fixedHigh.Mimes_ = QStringList { "text/html" };
+		fixedHigh.StaticResult_ = EntityTestHandleResult { EntityTestHandleResult::PHigh };
+
+		RoutedHandler mixed { QList<EntityRoutingRule> { fixed, anyText } };
+		RoutedHandler allStatic { QList<EntityRoutingRule> { fixed, fixedHigh } };
+		FakePluginsManager pm;
+		pm.InjectPlugin (&mixed);
+		pm.InjectPlugin (&allStatic);
+		EntityRoutingCache cache { &pm };
+
+		// A matching non-static rule wins over the static ones.
+		const auto& plainRoute = cache.GetRoute (MakeEntity ({}, "text/plain")).Handlers_;
+		QCOMPARE (plainRoute.size (), 2);
+		QCOMPARE (plainRoute.at (0).Plugin_, static_cast<QObject*> (&mixed));
+		QVERIFY (!plainRoute.at (0).IsStatic_);
+		QVERIFY (plainRoute.at (1).IsStatic_);
+		QCOMPARE (plainRoute.at (1).StaticResult_.HandlePriority_,
+				static_cast<int> (EntityTestHandleResult::PLow));
+
+		// If all the matching rules are static, the best result is used.
+		const auto& htmlRoute = cache.GetRoute (MakeEntity ({}, "text/html")).Handlers_;
+		QCOMPARE (htmlRoute.size (), 2);
+		QVERIFY (!htmlRoute.at (0).IsStatic_);
+		QVERIFY (htmlRoute.at (1).IsStatic_);
+		QCOMPARE (htmlRoute.at (1).StaticResult_.HandlePriority_,
+				static_cast<int> (EntityTestHandleResult::PHigh));
+	}
+
+	void EntityRoutingCacheTest::testPlainHandler ()
+	{
+		PlainHandler handler;
+		FakePluginsManager pm;
+		pm.InjectPlugin (&handler);
+		EntityRoutingCache cache { &pm };
+
+		const auto& route = cache.GetRoute (MakeEntity (QUrl { "magnet:?xt=urn:btih:0" }, "text/plain"));
+		QCOMPARE (route.Handlers_.size (), 1);
+		QCOMPARE (route.Handlers_.at (0).Plugin_, static_cast<QObject*> (&handler));
+		QVERIFY (!route.Handlers_.at (0).IsStatic_);
+		QVERIFY (route.Downloaders_.isEmpty ());
+	}
+
+	void EntityRoutingCacheTest::testHitRate ()
+	{
+		RoutedHandler handler { QList<EntityRoutingRule> { EntityRoutingRule {} } };
+		FakePluginsManager pm;
+		pm.InjectPlugin (&handler);
+		EntityRoutingCache cache { &pm };
+
+		QCOMPARE (cache.GetStats ().HitRate_, 0.0);
+
+		for (int i = 0; i < 4; ++i)
+			cache.GetRoute (MakeEntity (QUrl { QString { "http://example.com/%1" }.arg (i) }));
+		cache.GetRoute (MakeEntity (QUrl { "ftp://example.com/" }));
+
+		const auto& stats = cache.GetStats ();
+		QCOMPARE (stats.CacheHits_, quint64 { 3 });
+		QCOMPARE (stats.CacheMisses_, quint64 { 2 });
+		QCOMPARE (stats.HitRate_, 0.6);
+
+		// The rules are only asked for once per plugin.
+		QCOMPARE (handler.RulesQueries_, 1);
+	}
+
+	void EntityRoutingCacheTest::testInvalidateOnInject ()
+	{
+		PlainHandler first;
+		FakePluginsManager pm;
+		pm.InjectPlugin (&first);
+		EntityRoutingCache cache { &pm };
+
+		const auto& e = MakeEntity ({}, "text/plain");
+		QCOMPARE (GetHandlers (cache, e), QObjectList { &first });
+
+		PlainHandler second;
+		pm.InjectPlugin (&second);
+		QCOMPARE (GetHandlers (cache, e), (QObjectList { &first, &second }));
+	}
+
+	void EntityRoutingCacheTest::testInvalidateOnUnload ()
+	{
+		PlainHandler plain;
+		RoutedHandler routed { QList<EntityRoutingRule> { EntityRoutingRule {} } };
+		FakePluginsManager pm;
+		pm.InjectPlugin (&plain);
+		pm.InjectPlugin (&routed);
+		EntityRoutingCache cache { &pm };
+
+		const auto& e = MakeEntity ({}, "text/plain");
+		QCOMPARE (GetHandlers (cache, e), (QObjectList { &plain, &routed }));
+
+		pm.ReleasePlugin (&routed);
+		QCOMPARE (GetHandlers (cache, e), QObjectList { &plain });
+		QCOMPARE (cache.GetStats ().CacheMisses_, quint64 { 2 });
+
+		// The rules of the unloaded plugin must not be kept around either.
+		pm.InjectPlugin (&routed);
+		QCOMPARE (GetHandlers (cache, e), (QObjectList { &plain, &routed }));
+		QCOMPARE (routed.RulesQueries_, 2);
+	}
+}
@@ -0,0 +1,105 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <interfaces/ientityhandler.h>
+#include <interfaces/ientityroutingrules.h>
+#include <interfaces/core/ipluginsmanager.h>
+
+namespace LeechCraft
+{
+	class FakePluginsManager : public QObject
+							 , public IPluginsManager
+	{
+		Q_OBJECT
+		Q_INTERFACES (IPluginsManager)
+
+		QObjectList Plugins_;
+	public:
+		QObjectList GetAllPlugins () const;
+		QObject* GetPluginByID (const QByteArray&) const;
+		QString GetPluginLibraryPath (const QObject*) const;
+		void InjectPlugin (QObject*);
+		void ReleasePlugin (QObject*);
+		QObject* GetQObject ();
+		void OpenSettings (QObject*);
+		ILoadProgressReporter_ptr CreateLoadProgressReporter (QObject*);
+	signals:
+		void pluginInjected (QObject*);
+		void pluginAboutToBeUnloaded (QObject*);
+	};
+
+	/** A handler without any routing rules, queried for everything.
+	 */
+	class PlainHandler : public QObject
+					   , public IEntityHandler
+	{
+		Q_OBJECT
+		Q_INTERFACES (IEntityHandler)
+	public:
+		EntityTestHandleResult CouldHandle (const Entity&) const;
+		void Handle (Entity);
+	};
+
+	class RoutedHandler : public QObject
+						, public IEntityHandler
+						, public IEntityRoutingRules
+	{
+		Q_OBJECT
+		Q_INTERFACES (IEntityHandler IEntityRoutingRules)
+
+		const QList<EntityRoutingRule> Rules_;
+	public:
+		mutable int RulesQueries_ = 0;
+
+		explicit RoutedHandler (const QList<EntityRoutingRule>&);
+
+		EntityTestHandleResult CouldHandle (const Entity&) const;
+		void Handle (Entity);
+
+		QList<EntityRoutingRule> GetEntityRoutingRules () const;
+	};
+
+	class EntityRoutingCacheTest : public QObject
+	{
+		Q_OBJECT
+	private slots:
+		void testSchemes ();
+		void testMimes ();
+		void testParameters ();
+		void testStaticResult ();
+		void testMixedStaticResult ();
+		void testPlainHandler ();
+		void testHitRate ();
+		void testInvalidateOnInject ();
+		void testInvalidateOnUnload ();
+	};
+}
@@ -0,0 +1,124 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QList>
+#include <QStringList>
+#include <QtPlugin>
+#include "structures.h"
+#include "entitytesthandleresult.h"
+
+namespace LeechCraft
+{
+	/** @brief Describes a static entity routing rule.
+	 *
+	 * A routing rule describes a class of entities (by their MIME type,
+	 * URL scheme and task parameters) that a handler or a downloader is
+	 * interested in.
+	 *
+	 * If StaticResult_ has a positive priority, the entities matching
+	 * this rule are routed to the plugin without calling its
+	 * IEntityHandler::CouldHandle() or IDownload::CouldDownload(), and
+	 * StaticResult_ is used as the test result. Otherwise the plugin is
+	 * still queried for the matching entities as usual.
+	 *
+	 * If several rules of a plugin match an entity, the plugin is only
+	 * routed statically if all of them have a static result, and the
+	 * one with the highest priority is used then. A single matching
+	 * non-static rule makes the plugin be queried.
+	 *
+	 * @sa IEntityRoutingRules
+	 */
+	struct EntityRoutingRule
+	{
+		/** @brief The MIME types this rule matches.
+		 *
+		 * A MIME ending with the <code>*</code> character matches any
+		 * MIME type starting with the rest of it. An empty list matches
+		 * any MIME type, including the empty one.
+		 */
+		QStringList Mimes_;
+
+		/** @brief The URL schemes this rule matches.
+		 *
+		 * A non-empty list only matches entities that are a QUrl with
+		 * one of these schemes, so such a rule never matches non-URL
+		 * entities. An empty list matches any entity, including
+		 * non-URL ones.
+		 */
+		QStringList Schemes_;
+
+		/** @brief The task parameters that must be set on the entity.
+		 */
+		TaskParameters Required_ = NoParameters;
+
+		/** @brief The task parameters that must not be set on the entity.
+		 */
+		TaskParameters Forbidden_ = NoParameters;
+
+		/** @brief The result to use without querying the plugin.
+		 *
+		 * If the priority is zero or lower, the plugin is queried as
+		 * usual for the matching entities.
+		 */
+		EntityTestHandleResult StaticResult_;
+	};
+}
+
+/** @brief Interface for entity handlers declaring static routing rules.
+ *
+ * Entity handlers (IEntityHandler) and downloaders (IDownload) may
+ * implement this interface to let the Core avoid calling their
+ * CouldHandle() or CouldDownload() for the entities they are not
+ * interested in at all.
+ *
+ * A plugin implementing this interface is never queried for an entity
+ * that matches none of the rules returned by GetEntityRoutingRules().
+ *
+ * The rules are queried once after the plugins are loaded and are
+ * cached, so they should not depend on any runtime state like the
+ * plugin settings. The state-dependent checks should be performed in
+ * CouldHandle() or CouldDownload() instead.
+ *
+ * @sa LeechCraft::EntityRoutingRule, IEntityHandler, IDownload
+ */
+class Q_DECL_EXPORT IEntityRoutingRules
+{
+public:
+	virtual ~IEntityRoutingRules () {}
+
+	/** @brief Returns the list of the static routing rules.
+	 *
+	 * @return The list of routing rules of this plugin.
+	 */
+	virtual QList<LeechCraft::EntityRoutingRule> GetEntityRoutingRules () const = 0;
+};
+
+Q_DECLARE_INTERFACE (IEntityRoutingRules, "org.Deviant.LeechCraft.IEntityRoutingRules/1.0");
@@ -135,6 +135,15 @@ namespace AdvancedNotifications
 		GeneralHandler_->Handle (e);
 	}
 
+	QList<EntityRoutingRule> Plugin::GetEntityRoutingRules () const
+	{
+		// Not static: only the notifications carrying the event fields
+		// are handled, and those cancel the other handlers.
+		EntityRoutingRule rule;
+		rule.Mimes_ << "x-leechcraft/notification*";
+		return { rule };
+	}
+
 	Util::XmlSettingsDialog_ptr Plugin::GetSettingsDialog () const
 	{
 		return SettingsDialog_;
@@ -91,13 +91,12 @@ namespace AdvancedNotifications
 
 		QList<NotificationRule> result;
 
-		for (const auto& rule : RulesManager_->GetRulesList ())
+		const auto& rules = RulesManager_->GetRulesList ();
+		// Disabling a single-shot rule below rebuilds the index, but
+		// this list of indexes stays valid since no rules are moved.
+		for (const auto idx : RulesManager_->GetEnabledRules (type))
 		{
-			if (!rule.IsEnabled ())
-				continue;
-
-			if (!rule.GetTypes ().contains (type))
-				continue;
+			const auto& rule = rules.at (idx);
 
 			bool fieldsMatch = true;
 			for (const auto& match : rule.GetFieldMatches ())
@@ -114,10 +113,10 @@ namespace AdvancedNotifications
 			if (!fieldsMatch)
 				continue;
 
-			if (rule.IsSingleShot ())
-				RulesManager_->SetRuleEnabled (rule, false);
-
 			result << rule;
+
+			if (rule.IsSingleShot ())
+				RulesManager_->setRuleEnabled (idx, false);
 		}
 
 		return result;
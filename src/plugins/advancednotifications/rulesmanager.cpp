@@ -107,11 +107,16 @@ namespace AdvancedNotifications
 		return RulesModel_;
 	}
 
-	QList<NotificationRule> RulesManager::GetRulesList () const
+	const QList<NotificationRule>& RulesManager::GetRulesList () const
 	{
 		return Rules_;
 	}
 
+	QList<int> RulesManager::GetEnabledRules (const QString& type) const
+	{
+		return Type2EnabledRules_.value (type);
+	}
+
 	void RulesManager::SetRuleEnabled (const NotificationRule& rule, bool enabled)
 	{
 		const int idx = Rules_.indexOf (rule);
@@ -384,6 +389,8 @@ namespace AdvancedNotifications
 			LoadDefaultRules (rulesVersion++);
 		if (shouldSave)
 			SaveSettings ();
+		else
+			RebuildIndex ();
 
 		settings.setValue ("DefaultRulesVersion", currentDefVersion);
 		settings.endGroup ();
@@ -402,8 +409,10 @@ namespace AdvancedNotifications
 			RulesModel_->appendRow (RuleToRow (rule));
 	}
 
-	void RulesManager::SaveSettings () const
+	void RulesManager::SaveSettings ()
 	{
+		RebuildIndex ();
+
 		QSettings settings (QCoreApplication::organizationName (),
 				QCoreApplication::applicationName () + "_AdvancedNotifications");
 		settings.beginGroup ("rules");
@@ -413,6 +422,21 @@ namespace AdvancedNotifications
 		emit rulesChanged ();
 	}
 
+	void RulesManager::RebuildIndex ()
+	{
+		Type2EnabledRules_.clear ();
+
+		for (int i = 0; i < Rules_.size (); ++i)
+		{
+			const auto& rule = Rules_.at (i);
+			if (!rule.IsEnabled ())
+				continue;
+
+			for (const auto& type : rule.GetTypes ())
+				Type2EnabledRules_ [type] << i;
+		}
+	}
+
 	QList<QStandardItem*> RulesManager::RuleToRow (const NotificationRule& rule) const
 	{
 		const QStringList hrTypes { Util::Map (rule.GetTypes ().toList (), Util::AN::GetTypeName) };
@@ -438,6 +462,8 @@ namespace AdvancedNotifications
 	{
 		Rules_.prepend (NotificationRule ());
 		RulesModel_->insertRow (0, RuleToRow (NotificationRule ()));
+
+		RebuildIndex ();
 	}
 
 	void RulesManager::removeRule (const QModelIndex& index)
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <QObject>
+#include <QHash>
 #include "notificationrule.h"
 
 class QAbstractItemModel;
@@ -49,11 +50,14 @@ namespace AdvancedNotifications
 
 		QList<NotificationRule> Rules_;
 		QStandardItemModel *RulesModel_;
+
+		QHash<QString, QList<int>> Type2EnabledRules_;
 	public:
 		RulesManager (QObject* = 0);
 
 		QAbstractItemModel* GetRulesModel () const;
-		QList<NotificationRule> GetRulesList () const;
+		const QList<NotificationRule>& GetRulesList () const;
+		QList<int> GetEnabledRules (const QString& type) const;
 
 		void SetRuleEnabled (const NotificationRule&, bool);
 		void UpdateRule (const QModelIndex&, const NotificationRule&);
@@ -65,7 +69,8 @@ namespace AdvancedNotifications
 		void LoadDefaultRules (int = -1);
 		void LoadSettings ();
 		void ResetModel ();
-		void SaveSettings () const;
+		void SaveSettings ();
+		void RebuildIndex ();
 
 		QList<QStandardItem*> RuleToRow (const NotificationRule&) const;
 	public slots:
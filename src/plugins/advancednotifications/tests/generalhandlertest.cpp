@@ -0,0 +1,213 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "generalhandlertest.h"
+#include <QtTest>
+#include <QSettings>
+#include <QAbstractItemModel>
+#include <interfaces/structures.h>
+#include <interfaces/an/constants.h>
+#include "../core.h"
+#include "../generalhandler.h"
+#include "../rulesmanager.h"
+#include "../typedmatchers.h"
+
+QTEST_MAIN (LeechCraft::AdvancedNotifications::GeneralHandlerTest)
+
+namespace LeechCraft
+{
+namespace AdvancedNotifications
+{
+	namespace
+	{
+		const int ContactsCount = 300;
+		const int BurstSize = 1000;
+
+		const QString SourceField = "org.LC.Plugins.Azoth.Msg.Source";
+
+		FieldMatch MakeSourceMatch (const QRegExp& rx)
+		{
+			FieldMatch match { QVariant::String };
+			match.SetFieldName (SourceField);
+			match.GetMatcher ()->SetValue (ANStringFieldValue { rx, true });
+			return match;
+		}
+
+		QString MakeSource (int num)
+		{
+			return QString { "contact%1@example.com/resource" }.arg (num);
+		}
+
+		NotificationRule MakeContactRule (const QString& name, const QString& type, int num)
+		{
+			NotificationRule rule { name.arg (num), AN::CatIM, { type } };
+
+			// Every tenth rule uses a real regexp to cover both matcher paths.
+			const auto& rx = num % 10 ?
+					QRegExp { QString { "contact%1@" }.arg (num), Qt::CaseInsensitive, QRegExp::FixedString } :
+					QRegExp { QString { "^contact%1@" }.arg (num), Qt::CaseInsensitive, QRegExp::RegExp };
+			rule.AddFieldMatch (MakeSourceMatch (rx));
+			return rule;
+		}
+
+		void AddRule (const NotificationRule& rule)
+		{
+			const auto rm = Core::Instance ().GetRulesManager ();
+			rm->prependRule ();
+			rm->UpdateRule (rm->GetRulesModel ()->index (0, 0), rule);
+		}
+
+		int FindRule (const QString& name)
+		{
+			const auto& rules = Core::Instance ().GetRulesManager ()->GetRulesList ();
+			for (int i = 0; i < rules.size (); ++i)
+				if (rules.at (i).GetName () == name)
+					return i;
+			return -1;
+		}
+
+		Entity MakeEvent (const QString& type, const QString& source)
+		{
+			Entity e;
+			e.Mime_ = "x-leechcraft/notification";
+			e.Additional_ ["org.LC.AdvNotifications.SenderID"] = "org.LeechCraft.Azoth";
+			e.Additional_ ["org.LC.AdvNotifications.EventCategory"] = AN::CatIM;
+			e.Additional_ ["org.LC.AdvNotifications.EventType"] = type;
+			e.Additional_ [SourceField] = source;
+			return e;
+		}
+
+		QStringList GetRuleNames (const Entity& e)
+		{
+			QStringList result;
+			for (const auto& rule : Core::Instance ().GetRules (e))
+				result << rule.GetName ();
+			return result;
+		}
+	}
+
+	void GeneralHandlerTest::initTestCase ()
+	{
+		QCoreApplication::setApplicationName ("leechcraft_advancednotifications_test");
+
+		QSettings settings (QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "_AdvancedNotifications");
+		settings.clear ();
+
+		// Drop the default rules so that only the rules added by the
+		// tests below can match.
+		const auto rm = Core::Instance ().GetRulesManager ();
+		while (rm->GetRulesModel ()->rowCount ())
+			rm->removeRule (rm->GetRulesModel ()->index (0, 0));
+		QVERIFY (rm->GetRulesList ().isEmpty ());
+
+		// Per-contact rules with no notification methods, so that the
+		// handlers stay out of the way and only matching is measured.
+		for (int i = 0; i < ContactsCount; ++i)
+		{
+			AddRule (MakeContactRule ("MUC message from %1", AN::TypeIMMUCMsg, i));
+			AddRule (MakeContactRule ("Status of %1", AN::TypeIMStatusChange, i));
+		}
+	}
+
+	void GeneralHandlerTest::fixedStringMatch ()
+	{
+		QCOMPARE (GetRuleNames (MakeEvent (AN::TypeIMMUCMsg, MakeSource (42))),
+				QStringList { "MUC message from 42" });
+		QCOMPARE (GetRuleNames (MakeEvent (AN::TypeIMMUCMsg, MakeSource (4))),
+				QStringList { "MUC message from 4" });
+		QCOMPARE (GetRuleNames (MakeEvent (AN::TypeIMMUCMsg, "CONTACT42@EXAMPLE.COM")),
+				QStringList { "MUC message from 42" });
+	}
+
+	void GeneralHandlerTest::regexpMatch ()
+	{
+		QCOMPARE (GetRuleNames (MakeEvent (AN::TypeIMMUCMsg, MakeSource (40))),
+				QStringList { "MUC message from 40" });
+		QCOMPARE (GetRuleNames (MakeEvent (AN::TypeIMMUCMsg, "x" + MakeSource (40))),
+				QStringList {});
+	}
+
+	void GeneralHandlerTest::otherTypesIgnored ()
+	{
+		QCOMPARE (GetRuleNames (MakeEvent (AN::TypeIMStatusChange, MakeSource (42))),
+				QStringList { "Status of 42" });
+		QCOMPARE (GetRuleNames (MakeEvent ("org.LC.AdvNotifications.IM.Unknown", MakeSource (42))),
+				QStringList {});
+	}
+
+	void GeneralHandlerTest::disabledSkipped ()
+	{
+		const auto rm = Core::Instance ().GetRulesManager ();
+		const auto idx = FindRule ("MUC message from 7");
+		QVERIFY (idx >= 0);
+
+		rm->setRuleEnabled (idx, false);
+		QCOMPARE (GetRuleNames (MakeEvent (AN::TypeIMMUCMsg, MakeSource (7))),
+				QStringList {});
+
+		rm->setRuleEnabled (idx, true);
+		QCOMPARE (GetRuleNames (MakeEvent (AN::TypeIMMUCMsg, MakeSource (7))),
+				QStringList { "MUC message from 7" });
+	}
+
+	void GeneralHandlerTest::singleShot ()
+	{
+		auto rule = MakeContactRule ("Attention from %1", AN::TypeIMAttention, 1000);
+		rule.SetSingleShot (true);
+		AddRule (rule);
+
+		const auto& e = MakeEvent (AN::TypeIMAttention, MakeSource (1000));
+		QCOMPARE (GetRuleNames (e), QStringList { "Attention from 1000" });
+		QCOMPARE (GetRuleNames (e), QStringList {});
+
+		const auto idx = FindRule ("Attention from 1000");
+		QVERIFY (idx >= 0);
+		QVERIFY (!Core::Instance ().GetRulesManager ()->GetRulesList ().at (idx).IsEnabled ());
+	}
+
+	/* A chatty MUC: a burst of messages from different participants,
+	 * each of them checked against all the per-contact rules.
+	 */
+	void GeneralHandlerTest::benchmarkBurst ()
+	{
+		QList<Entity> burst;
+		for (int i = 0; i < BurstSize; ++i)
+			burst << MakeEvent (AN::TypeIMMUCMsg, MakeSource (i % (ContactsCount * 2)));
+
+		GeneralHandler handler { {} };
+
+		QBENCHMARK
+		{
+			for (const auto& e : burst)
+				handler.Handle (e);
+		}
+	}
+}
+}
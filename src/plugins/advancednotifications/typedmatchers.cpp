@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "typedmatchers.h"
+#include <algorithm>
 #include <boost/variant/static_visitor.hpp>
 #include <boost/variant/apply_visitor.hpp>
 #include <QStringList>
@@ -82,6 +83,7 @@ namespace AdvancedNotifications
 	: Value_ { {} }
 	, Allowed_ (variants)
 	{
+		Compile ();
 	}
 
 	QVariantMap StringLikeMatcher::Save () const
@@ -96,6 +98,7 @@ namespace AdvancedNotifications
 	{
 		Value_.Rx_ = map ["Rx"].toRegExp ();
 		Value_.Contains_ = map ["Cont"].toBool ();
+		Compile ();
 	}
 
 	namespace
@@ -125,6 +128,7 @@ namespace AdvancedNotifications
 	void StringLikeMatcher::SetValue (const ANFieldValue& value)
 	{
 		boost::apply_visitor (ValueSetVisitor<ANStringFieldValue> { Value_ }, value);
+		Compile ();
 	}
 
 	ANFieldValue StringLikeMatcher::GetValue () const
@@ -191,6 +195,8 @@ namespace AdvancedNotifications
 		else
 			Value_.Rx_ = QRegExp (Ui_->VariantsBox_->currentText (),
 					Qt::CaseSensitive, QRegExp::FixedString);
+
+		Compile ();
 	}
 
 	void StringLikeMatcher::SyncWidgetTo ()
@@ -242,6 +248,42 @@ namespace AdvancedNotifications
 		}
 	}
 
+	bool StringLikeMatcher::Contains (const QString& str) const
+	{
+		return IsFixedString_ ?
+				FixedMatcher_.indexIn (str) != -1 :
+				Value_.Rx_.indexIn (str) != -1;
+	}
+
+	bool StringLikeMatcher::ExactlyMatches (const QString& str) const
+	{
+		return IsFixedString_ ?
+				!str.compare (FixedMatcher_.pattern (), FixedMatcher_.caseSensitivity ()) :
+				Value_.Rx_.exactMatch (str);
+	}
+
+	/* Matchers are checked against each incoming notification, so
+	 * anything that can be prepared in advance is prepared here, when
+	 * the value changes. Plain strings don't need the regexp engine at
+	 * all, and regexps are compiled right away instead of on the first
+	 * match.
+	 */
+	void StringLikeMatcher::Compile ()
+	{
+		IsFixedString_ = Value_.Rx_.patternSyntax () == QRegExp::FixedString;
+		if (IsFixedString_)
+			FixedMatcher_ = QStringMatcher { Value_.Rx_.pattern (), Value_.Rx_.caseSensitivity () };
+		else
+		{
+			FixedMatcher_ = QStringMatcher {};
+			if (!Value_.Rx_.isValid ())
+				qWarning () << Q_FUNC_INFO
+						<< "invalid regexp"
+						<< Value_.Rx_.pattern ()
+						<< Value_.Rx_.errorString ();
+		}
+	}
+
 	StringMatcher::StringMatcher (const QStringList& list)
 	: StringLikeMatcher (list)
 	{
@@ -252,7 +294,7 @@ namespace AdvancedNotifications
 		if (!var.canConvert<QString> ())
 			return false;
 
-		bool res = Value_.Rx_.indexIn (var.toString ()) != -1;
+		bool res = Contains (var.toString ());
 		if (!Value_.Contains_)
 			res = !res;
 		return res;
@@ -276,7 +318,9 @@ namespace AdvancedNotifications
 		if (!var.canConvert<QStringList> ())
 			return false;
 
-		bool res = var.toStringList ().indexOf (Value_.Rx_) == -1;
+		const auto& list = var.toStringList ();
+		bool res = std::none_of (list.begin (), list.end (),
+				[this] (const QString& str) { return ExactlyMatches (str); });
 		if (!Value_.Contains_)
 			res = !res;
 		return res;
@@ -300,8 +344,8 @@ namespace AdvancedNotifications
 			return false;
 
 		const auto& url = var.toUrl ();
-		const auto contains = url.toString ().indexOf (Value_.Rx_) != -1 ||
-				QString::fromUtf8 (url.toEncoded ()).indexOf (Value_.Rx_) != -1;
+		const auto contains = Contains (url.toString ()) ||
+				Contains (QString::fromUtf8 (url.toEncoded ()));
 		return contains == Value_.Contains_;
 	}
 
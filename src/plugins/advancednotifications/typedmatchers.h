@@ -32,6 +32,7 @@
 #include <memory>
 #include <QString>
 #include <QRegExp>
+#include <QStringMatcher>
 #include <QVariant>
 #include <interfaces/an/ianemitter.h>
 
@@ -79,6 +80,9 @@ namespace AdvancedNotifications
 		const QStringList Allowed_;
 
 		std::shared_ptr<Ui::StringLikeMatcherConfigWidget> Ui_;
+
+		bool IsFixedString_ = false;
+		QStringMatcher FixedMatcher_;
 	public:
 		StringLikeMatcher (const QStringList& variants = {});
 
@@ -91,6 +95,11 @@ namespace AdvancedNotifications
 		QWidget* GetConfigWidget ();
 		void SyncToWidget ();
 		void SyncWidgetTo ();
+	protected:
+		bool Contains (const QString&) const;
+		bool ExactlyMatches (const QString&) const;
+	private:
+		void Compile ();
 	};
 
 	class StringMatcher : public StringLikeMatcher
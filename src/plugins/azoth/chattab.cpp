@@ -41,6 +41,7 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QKeyEvent>
+#include <QWheelEvent>
 #include <QTextBrowser>
 #include <QDesktopWidget>
 #include <QMimeData>
@@ -172,6 +173,7 @@ namespace Azoth
 	, EntryID_ (entryId)
 	, BgColor_ (QApplication::palette ().color (QPalette::Base))
 	, NumUnreadMsgs_ (Core::Instance ().GetUnreadCount (GetEntry<ICLEntry> ()))
+	, PendingMessagesTimer_ (new QTimer (this))
 	, CDF_ (new ContactDropFilter (entryId, this))
 	, TypeTimer_ (new QTimer (this))
 	{
@@ -183,6 +185,7 @@ namespace Azoth
 
 		Ui_.View_->installEventFilter (CDF_);
 		Ui_.MsgEdit_->installEventFilter (CDF_);
+		Ui_.View_->installEventFilter (this);
 
 		Ui_.SubjBox_->setVisible (false);
 		Ui_.SubjChange_->setEnabled (false);
@@ -230,6 +233,14 @@ namespace Azoth
 				this,
 				SLOT (typeTimeout ()));
 
+		// Messages arriving within a frame are rendered in one go.
+		PendingMessagesTimer_->setSingleShot (true);
+		PendingMessagesTimer_->setInterval (16);
+		connect (PendingMessagesTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (flushPendingMessages ()));
+
 		DummyMsgManager::Instance ().ClearMessages (GetCLEntry ());
 		PrepareTheme ();
 
@@ -281,6 +292,11 @@ namespace Azoth
 
 	void ChatTab::PrepareTheme ()
 	{
+		PendingMessages_.clear ();
+		PendingMessagesTimer_->stop ();
+		ShownItems_.clear ();
+		EvictedItems_.clear ();
+
 		QString data = Core::Instance ().GetSelectedChatTemplate (GetEntry<QObject> (),
 				Ui_.View_->page ()->mainFrame ());
 		if (data.isEmpty ())
@@ -521,10 +537,42 @@ namespace Azoth
 		return Ui_.VariantBox_->currentText ();
 	}
 
+	namespace
+	{
+		bool IsScrollUpEvent (QEvent *event)
+		{
+			switch (event->type ())
+			{
+			case QEvent::Wheel:
+				return static_cast<QWheelEvent*> (event)->delta () > 0;
+			case QEvent::KeyPress:
+				switch (static_cast<QKeyEvent*> (event)->key ())
+				{
+				case Qt::Key_Up:
+				case Qt::Key_PageUp:
+				case Qt::Key_Home:
+					return true;
+				default:
+					return false;
+				}
+			// The scrollbar of the view has been dragged or clicked.
+			case QEvent::MouseButtonRelease:
+				return true;
+			default:
+				return false;
+			}
+		}
+	}
+
 	bool ChatTab::eventFilter (QObject *obj, QEvent *event)
 	{
 		if (obj == MUCEventLog_ && event->type () == QEvent::Close)
 			Ui_.MUCEventsButton_->setChecked (false);
+		else if (obj == Ui_.View_ &&
+				!EvictedItems_.isEmpty () &&
+				IsScrollUpEvent (event) &&
+				IsScrolledToTop ())
+			PageInScrollback ();
 
 		return false;
 	}
@@ -733,41 +781,61 @@ namespace Azoth
 
 	void ChatTab::on_View__loadFinished (bool)
 	{
-		Q_FOREACH (IMessage *msg, HistoryMessages_)
-			AppendMessage (msg);
+		PendingMessages_.clear ();
+		PendingMessagesTimer_->stop ();
+		ShownItems_.clear ();
+		EvictedItems_.clear ();
 
-		ICLEntry *e = GetEntry<ICLEntry> ();
-		if (!e)
-		{
+		const auto frame = Ui_.View_->page ()->mainFrame ();
+
+		QFile scrollerJS (":/plugins/azoth/resources/scripts/scrollers.js");
+		const bool hasScrollers = scrollerJS.open (QIODevice::ReadOnly);
+		if (!hasScrollers)
 			qWarning () << Q_FUNC_INFO
-					<< "null entry";
-			return;
+					<< "unable to open script file"
+					<< scrollerJS.errorString ();
+		else
+		{
+			frame->evaluateJavaScript (scrollerJS.readAll ());
+			frame->evaluateJavaScript ("MarkScrollbackStart();");
 		}
 
-		auto messages = e->GetAllMessages ();
-
-		const auto& dummyMsgs = DummyMsgManager::Instance ().GetIMessages (e->GetQObject ());
-		if (!dummyMsgs.isEmpty ())
+		auto messages = HistoryMessages_;
+		if (const auto e = GetEntry<ICLEntry> ())
 		{
-			messages += dummyMsgs;
-			std::sort (messages.begin (), messages.end (),
-					[] (IMessage *left, IMessage *right)
-						{ return left->GetDateTime () < right->GetDateTime (); });
+			auto entryMessages = e->GetAllMessages ();
+
+			const auto& dummyMsgs = DummyMsgManager::Instance ().GetIMessages (e->GetQObject ());
+			if (!dummyMsgs.isEmpty ())
+			{
+				entryMessages += dummyMsgs;
+				std::sort (entryMessages.begin (), entryMessages.end (),
+						[] (IMessage *left, IMessage *right)
+							{ return left->GetDateTime () < right->GetDateTime (); });
+			}
+
+			messages += entryMessages;
 		}
+		else
+			qWarning () << Q_FUNC_INFO
+					<< "null entry";
 
+		QList<ScrollbackItem> items;
 		for (const auto msg : messages)
-			AppendMessage (msg);
+			CollectMessage (msg, items);
 
-		QFile scrollerJS (":/plugins/azoth/resources/scripts/scrollers.js");
-		if (!scrollerJS.open (QIODevice::ReadOnly))
-			qWarning () << Q_FUNC_INFO
-					<< "unable to open script file"
-					<< scrollerJS.errorString ();
-		else
+		// The history requested via the history back action is always shown.
+		const int limit = XmlSettingsManager::Instance ()
+				.property ("ChatScrollbackLimit").toInt ();
+		if (limit && !ScrollbackPos_ && items.size () > limit)
 		{
-			Ui_.View_->page ()->mainFrame ()->evaluateJavaScript (scrollerJS.readAll ());
-			Ui_.View_->page ()->mainFrame ()->evaluateJavaScript ("InstallEventListeners(); ScrollToBottom();");
+			EvictedItems_ = items.mid (0, items.size () - limit);
+			items = items.mid (items.size () - limit);
 		}
+		AppendItems (items);
+
+		if (hasScrollers)
+			frame->evaluateJavaScript ("InstallEventListeners(); ScrollToBottom();");
 
 		emit hookThemeReloaded (Util::DefaultHookProxy_ptr (new Util::DefaultHookProxy),
 				this, Ui_.View_, GetEntry<QObject> ());
@@ -864,7 +932,8 @@ namespace Azoth
 		CoreMessages_.clear ();
 		DummyMsgManager::Instance ().ClearMessages (GetCLEntry ());
 		LastDateTime_ = QDateTime ();
-		RequestLogs (ScrollbackPos_);
+		if (!RequestLogs (ScrollbackPos_))
+			PrepareTheme ();
 	}
 
 	void ChatTab::handleRichTextToggled ()
@@ -1058,7 +1127,23 @@ namespace Azoth
 				Ui_.VariantBox_->setCurrentIndex (idx);
 		}
 
-		AppendMessage (msg);
+		PendingMessages_ << msgObj;
+		if (!PendingMessagesTimer_->isActive ())
+			PendingMessagesTimer_->start ();
+	}
+
+	void ChatTab::flushPendingMessages ()
+	{
+		const auto pending = PendingMessages_;
+		PendingMessages_.clear ();
+
+		QList<ScrollbackItem> items;
+		for (const auto& msgObj : pending)
+			if (msgObj)
+				CollectMessage (qobject_cast<IMessage*> (msgObj), items);
+		AppendItems (items);
+
+		TrimScrollback ();
 	}
 
 	void ChatTab::handleVariantsChanged (QStringList variants)
@@ -1372,7 +1457,7 @@ namespace Azoth
 			}
 		}
 
-		if (!messages.isEmpty ())
+		if (!messages.isEmpty () || ScrollbackPos_)
 			PrepareTheme ();
 
 		disconnect (sender (),
@@ -1798,7 +1883,7 @@ namespace Azoth
 				this, "handleMinLinesHeightChanged");
 	}
 
-	void ChatTab::RequestLogs (int num)
+	bool ChatTab::RequestLogs (int num)
 	{
 		ICLEntry *entry = GetEntry<ICLEntry> ();
 		if (!entry)
@@ -1806,7 +1891,7 @@ namespace Azoth
 			qWarning () << Q_FUNC_INFO
 					<< "null entry for"
 					<< EntryID_;
-			return;
+			return false;
 		}
 
 		QObject *entryObj = entry->GetQObject ();
@@ -1814,6 +1899,7 @@ namespace Azoth
 		const QObjectList& histories = Core::Instance ().GetProxy ()->
 				GetPluginsManager ()->GetAllCastableRoots<IHistoryPlugin*> ();
 
+		bool requested = false;
 		Q_FOREACH (QObject *histObj, histories)
 		{
 			IHistoryPlugin *hist = qobject_cast<IHistoryPlugin*> (histObj);
@@ -1827,7 +1913,10 @@ namespace Azoth
 					Qt::UniqueConnection);
 
 			hist->RequestLastMessages (entryObj, num);
+			requested = true;
 		}
+
+		return requested;
 	}
 
 	namespace
@@ -1838,7 +1927,7 @@ namespace Azoth
 		}
 	}
 
-	void ChatTab::AppendMessage (IMessage *msg)
+	void ChatTab::CollectMessage (IMessage *msg, QList<ScrollbackItem>& items)
 	{
 		ICLEntry *other = qobject_cast<ICLEntry*> (msg->OtherPart ());
 		if (!other && msg->OtherPart ())
@@ -1903,8 +1992,6 @@ namespace Azoth
 				return;
 		}
 
-		QWebFrame *frame = Ui_.View_->page ()->mainFrame ();
-
 		const bool isActiveChat = Core::Instance ()
 				.GetChatTabsManager ()->IsActiveChat (GetEntry<ICLEntry> ());
 
@@ -1924,7 +2011,7 @@ namespace Azoth
 				isActiveChat,
 				ToggleRichText_->isChecked ()
 			};
-			Core::Instance ().AppendMessageByTemplate (frame, coreMessage, coreInfo);
+			items.append ({ coreMessage, coreInfo });
 			CoreMessages_ << coreMessage;
 		}
 
@@ -1941,10 +2028,82 @@ namespace Azoth
 		if (!links.isEmpty ())
 			LastLink_ = links.last ();
 
-		if (!Core::Instance ().AppendMessageByTemplate (frame,
-				msg->GetQObject (), info))
+		items.append ({ msg->GetQObject (), info });
+	}
+
+	void ChatTab::AppendItems (const QList<ScrollbackItem>& items)
+	{
+		QList<ScrollbackItem> shown;
+		QList<ChatMsgAppendItem> messages;
+		for (const auto& item : items)
+			if (item.Message_)
+			{
+				shown << item;
+				messages.append ({ item.Message_, item.Info_ });
+			}
+
+		if (messages.isEmpty ())
+			return;
+
+		if (!Core::Instance ().AppendMessagesByTemplate (Ui_.View_->page ()->mainFrame (),
+				GetEntry<QObject> (), messages))
 			qWarning () << Q_FUNC_INFO
 					<< "unhandled append message :(";
+
+		ShownItems_ += shown;
+	}
+
+	void ChatTab::TrimScrollback ()
+	{
+		const int limit = XmlSettingsManager::Instance ()
+				.property ("ChatScrollbackLimit").toInt ();
+		if (!limit)
+			return;
+
+		const auto removed = Ui_.View_->page ()->mainFrame ()->
+				evaluateJavaScript (QString ("TrimScrollback(%1);").arg (limit)).toInt ();
+		EvictedItems_ += ShownItems_.mid (0, removed);
+		ShownItems_ = ShownItems_.mid (removed);
+	}
+
+	void ChatTab::PageInScrollback ()
+	{
+		const int chunkSize = 50;
+		const auto chunk = EvictedItems_.mid (std::max (0, EvictedItems_.size () - chunkSize));
+		EvictedItems_ = EvictedItems_.mid (0, EvictedItems_.size () - chunk.size ());
+
+		QList<ScrollbackItem> shown;
+		QList<ChatMsgAppendItem> messages;
+		for (const auto& item : chunk)
+			if (item.Message_)
+			{
+				shown << item;
+				messages.append ({ item.Message_, item.Info_ });
+			}
+
+		if (messages.isEmpty ())
+			return;
+
+		const auto frame = Ui_.View_->page ()->mainFrame ();
+		const auto heightBefore = frame->evaluateJavaScript ("document.height").toInt ();
+		if (!Core::Instance ().PrependMessagesByTemplate (frame, GetEntry<QObject> (), messages))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unhandled prepend messages :(";
+			return;
+		}
+		ShownItems_ = shown + ShownItems_;
+
+		// Keep the messages the user has been reading in place.
+		const auto heightAfter = frame->evaluateJavaScript ("document.height").toInt ();
+		frame->setScrollBarValue (Qt::Vertical,
+				frame->scrollBarValue (Qt::Vertical) + heightAfter - heightBefore);
+	}
+
+	bool ChatTab::IsScrolledToTop () const
+	{
+		const auto frame = Ui_.View_->page ()->mainFrame ();
+		return frame->scrollBarValue (Qt::Vertical) == frame->scrollBarMinimum (Qt::Vertical);
 	}
 
 	QString ChatTab::ReformatTitle ()
@@ -2089,6 +2248,14 @@ namespace Azoth
 
 	void ChatTab::handleEditScroll (int direction)
 	{
+		if (direction < 0 &&
+				!EvictedItems_.isEmpty () &&
+				IsScrolledToTop ())
+		{
+			PageInScrollback ();
+			return;
+		}
+
 		int distance = Ui_.View_->size ().height () / 2 - 5;
 		Ui_.View_->page ()->mainFrame ()->scroll (0, distance * direction);
 	}
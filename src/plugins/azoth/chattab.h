@@ -40,6 +40,7 @@
 #include <interfaces/ihaverecoverabletabs.h>
 #include <interfaces/iwkfontssettable.h>
 #include "interfaces/azoth/azothcommon.h"
+#include "interfaces/azoth/ichatstyleresourcesource.h"
 #include "ui_chattab.h"
 
 class QTextBrowser;
@@ -102,6 +103,17 @@ namespace Azoth
 
 		QList<IMessage*> HistoryMessages_;
 		QDateTime LastDateTime_;
+
+		QList<QPointer<QObject>> PendingMessages_;
+		QTimer * const PendingMessagesTimer_;
+
+		struct ScrollbackItem
+		{
+			QPointer<QObject> Message_;
+			ChatMsgAppendInfo Info_;
+		};
+		QList<ScrollbackItem> ShownItems_;
+		QList<ScrollbackItem> EvictedItems_;
 		QList<CoreMessage*> CoreMessages_;
 
 		QIcon TabIcon_;
@@ -214,6 +226,7 @@ namespace Azoth
 		void handleFileNoLongerOffered (QObject*);
 		void handleOfferActionTriggered ();
 		void handleEntryMessage (QObject*);
+		void flushPendingMessages ();
 		void handleVariantsChanged (QStringList);
 		void handleNameChanged (const QString& name);
 		void handleStatusChanged (const EntryStatus&, const QString&);
@@ -247,14 +260,30 @@ namespace Azoth
 		void InitMsgEdit ();
 		void RegisterSettings ();
 
-		void RequestLogs (int);
+		bool RequestLogs (int);
 
 		void UpdateTextHeight ();
 		void SetChatPartState (ChatPartState);
 
-		/** Appends the message to the message view area.
+		/** Filters the message, runs the append hooks on it and adds it
+		 * to the items, preceded by a date separator if needed.
+		 */
+		void CollectMessage (IMessage*, QList<ScrollbackItem>&);
+
+		/** Appends the items to the message view area all at once.
+		 */
+		void AppendItems (const QList<ScrollbackItem>&);
+
+		/** Drops the oldest messages from the view if there are more of
+		 * them than the scrollback limit allows.
+		 */
+		void TrimScrollback ();
+
+		/** Puts the newest of the dropped messages back in front of the
+		 * ones in the view.
 		 */
-		void AppendMessage (IMessage*);
+		void PageInScrollback ();
+		bool IsScrolledToTop () const;
 
 		/** Updates the tab icon and other usages of state icon from the
 		 * TabIcon_.
@@ -98,6 +98,7 @@
 #include "resourcesmanager.h"
 #include "notificationsmanager.h"
 #include "avatarsmanager.h"
+#include "presencebatcher.h"
 
 Q_DECLARE_METATYPE (QPointer<QObject>);
 
@@ -208,6 +209,15 @@ namespace Azoth
 	, ActionsManager_ (new ActionsManager (AvatarsManager_, this))
 	, ItemIconManager_ (new AnimatedIconManager<QStandardItem*> ([] (QStandardItem *it, const QIcon& ic)
 						{ it->setIcon (ic); }))
+	, PresenceBatcher_ (new PresenceBatcher
+			{
+				[this] (QObject *entryObj) { return Entry2Items_.value (qobject_cast<ICLEntry*> (entryObj)); },
+				[] (QObject *entryObj) { return qobject_cast<ICLEntry*> (entryObj)->GetStatus ().State_ != SOffline; },
+				[this] (QObject *entryObj, const QList<QStandardItem*>& items)
+					{ ApplyStatusIcon (qobject_cast<ICLEntry*> (entryObj), items); },
+				CLRNumOnline,
+				this
+			})
 	, SmilesOptionsModel_ (new SourceTrackingModel<IEmoticonResourceSource> ({ tr ("Smile pack") }))
 	, ChatStylesOptionsModel_ (new SourceTrackingModel<IChatStyleResourceSource> ({ tr ("Chat style") }))
 	, PluginManager_ (new PluginManager)
@@ -776,19 +786,34 @@ namespace Azoth
 		return src->GetBaseURL (opt);
 	}
 
-	bool Core::AppendMessageByTemplate (QWebFrame *frame,
-			QObject *message, const ChatMsgAppendInfo& info)
+	bool Core::AppendMessagesByTemplate (QWebFrame *frame,
+			QObject *entry, const QList<ChatMsgAppendItem>& messages)
+	{
+		IChatStyleResourceSource *src = GetCurrentChatStyle (entry);
+		if (!src)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "empty result for"
+					<< entry;
+			return false;
+		}
+
+		return src->AppendMessages (frame, messages);
+	}
+
+	bool Core::PrependMessagesByTemplate (QWebFrame *frame,
+			QObject *entry, const QList<ChatMsgAppendItem>& messages)
 	{
-		IChatStyleResourceSource *src = GetCurrentChatStyle (qobject_cast<IMessage*> (message)->ParentCLEntry ());
+		IChatStyleResourceSource *src = GetCurrentChatStyle (entry);
 		if (!src)
 		{
 			qWarning () << Q_FUNC_INFO
 					<< "empty result for"
-					<< message;
+					<< entry;
 			return false;
 		}
 
-		return src->AppendMessage (frame, message, info);
+		return src->PrependMessages (frame, messages);
 	}
 
 	void Core::FrameFocused (QObject *entry, QWebFrame *frame)
@@ -1217,18 +1242,21 @@ namespace Azoth
 		emit hookEntryStatusChanged (Util::DefaultHookProxy_ptr (new Util::DefaultHookProxy),
 				entry->GetQObject (), variant);
 
-		const State state = entry->GetStatus ().State_;
-		const auto& icon = ResourcesManager::Instance ().GetIconPathForState (state);
-
-		for (auto item : Entry2Items_.value (entry))
-		{
-			ItemIconManager_->SetIcon (item, icon.get ());
-			RecalculateOnlineForCat (item->parent ());
-		}
+		PresenceBatcher_->Enqueue (entry->GetQObject ());
+	}
 
+	void Core::ApplyStatusIcon (ICLEntry *entry, const QList<QStandardItem*>& items)
+	{
 		const QString& id = entry->GetEntryID ();
 		if (!XferJobManager_->GetPendingIncomingJobsFor (id).isEmpty ())
+		{
 			CheckFileIcon (id);
+			return;
+		}
+
+		const auto& icon = ResourcesManager::Instance ().GetIconPathForState (entry->GetStatus ().State_);
+		for (auto item : items)
+			ItemIconManager_->SetIcon (item, icon.get ());
 	}
 
 	void Core::CheckFileIcon (const QString& id)
@@ -1332,19 +1360,6 @@ namespace Azoth
 		category->setData (sum, CLRUnreadMsgCount);
 	}
 
-	void Core::RecalculateOnlineForCat (QStandardItem *catItem)
-	{
-		int result = 0;
-		for (int i = 0; i < catItem->rowCount (); ++i)
-		{
-			auto entryObj = catItem->child (i)->
-					data (CLREntryObject).value<QObject*> ();
-			result += qobject_cast<ICLEntry*> (entryObj)->GetStatus ().State_ != SOffline;
-		}
-
-		catItem->setData (result, CLRNumOnline);
-	}
-
 	void Core::HandlePowerNotification (Entity e)
 	{
 		auto accs = GetAccountsPred (ProtocolPlugins_);
@@ -1378,6 +1393,7 @@ namespace Azoth
 		const int unread = item->data (CLRUnreadMsgCount).toInt ();
 
 		ItemIconManager_->Cancel (item);
+		PresenceBatcher_->RemoveItem (item);
 
 		ModelUpdateSafeguard guard (CLModel_);
 		category->removeRow (item->row ());
@@ -1386,6 +1402,7 @@ namespace Azoth
 		{
 			QStandardItem *account = category->parent ();
 			ItemIconManager_->Cancel (category);
+			PresenceBatcher_->RemoveCategory (category);
 
 			const QString& text = category->text ();
 
@@ -1718,6 +1735,8 @@ namespace Azoth
 			if (obj == accFace)
 			{
 				ItemIconManager_->Cancel (item);
+				for (int j = 0; j < item->rowCount (); ++j)
+					PresenceBatcher_->RemoveCategory (item->child (j));
 				{
 					ModelUpdateSafeguard guard (CLModel_);
 					CLModel_->removeRow (i);
@@ -83,6 +83,7 @@ namespace Azoth
 	class CoreCommandsManager;
 	class NotificationsManager;
 	class AvatarsManager;
+	class PresenceBatcher;
 
 	class Core : public QObject
 	{
@@ -119,6 +120,7 @@ namespace Azoth
 		Entry2SmoothAvatarCache_t Entry2SmoothAvatarCache_;
 
 		AnimatedIconManager<QStandardItem*> *ItemIconManager_;
+		PresenceBatcher *PresenceBatcher_;
 
 		QMap<State, int> StateCounter_;
 
@@ -257,7 +259,8 @@ namespace Azoth
 		QString GetSelectedChatTemplate (QObject *entry, QWebFrame *frame) const;
 		QUrl GetSelectedChatTemplateURL (QObject*) const;
 
-		bool AppendMessageByTemplate (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
+		bool AppendMessagesByTemplate (QWebFrame*, QObject *entry, const QList<ChatMsgAppendItem>&);
+		bool PrependMessagesByTemplate (QWebFrame*, QObject *entry, const QList<ChatMsgAppendItem>&);
 
 		void FrameFocused (QObject*, QWebFrame*);
 
@@ -318,6 +321,11 @@ namespace Azoth
 		void HandleStatusChanged (const EntryStatus& status,
 				ICLEntry *entry, const QString& variant);
 
+		/** Updates the status icons of the given items of the entry,
+		 * called by the PresenceBatcher.
+		 */
+		void ApplyStatusIcon (ICLEntry*, const QList<QStandardItem*>&);
+
 		/** Checks whether icon representing incoming file should be
 		 * drawn for the entry with the given id.
 		 */
@@ -328,8 +336,6 @@ namespace Azoth
 		 */
 		void RecalculateUnreadForParents (QStandardItem*);
 
-		void RecalculateOnlineForCat (QStandardItem*);
-
 		void HandlePowerNotification (Entity);
 
 		/** Removes one item representing the given CL entry.
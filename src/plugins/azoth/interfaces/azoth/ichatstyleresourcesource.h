@@ -56,6 +56,19 @@ namespace Azoth
 		bool UseRichTextBody_;
 	};
 
+	/** @brief A message to be inserted into the chat view.
+	 */
+	struct ChatMsgAppendItem
+	{
+		/** @brief The message object, implementing IMessage.
+		 */
+		QObject *Message_;
+
+		/** @brief Additional parameters of the message.
+		 */
+		ChatMsgAppendInfo Info_;
+	};
+
 	/** @brief Interface for chat style resource loaders and handlers.
 	 *
 	 * This interface should be implemented by resource sources that are
@@ -63,9 +76,15 @@ namespace Azoth
 	 *
 	 * The basic HTML template to be installed into the chat window
 	 * whenever a new chat window is created is returned by
-	 * GetHTMLTemplate. AppendMessage is used to append a message into
-	 * a chat window with an HTML template already set. FrameFocused is
-	 * called whenever user focuses on the given chat window.
+	 * GetHTMLTemplate. AppendMessages is used to append messages into
+	 * a chat window with an HTML template already set, and
+	 * PrependMessages is used to put older messages back in front of
+	 * them. FrameFocused is called whenever user focuses on the given
+	 * chat window.
+	 *
+	 * The markup of each message should have the data-azoth-msg
+	 * attribute set on one of its elements, so that Azoth can count
+	 * the messages in the chat view when trimming its scrollback.
 	 */
 	class IChatStyleResourceSource : public IResourceSource
 	{
@@ -117,18 +136,35 @@ namespace Azoth
 		virtual QString GetHTMLTemplate (const QString& style,
 				const QString& variant, QObject *entry, QWebFrame *frame) const = 0;
 
-		/** @brief Appends a new message to the chat view.
+		/** @brief Appends new messages to the chat view.
+		 *
+		 * This function is called whenever new messages should be
+		 * appended to the chat view located in the given frame. The
+		 * messages are ordered from the oldest to the newest one, and
+		 * they should be inserted into the document all at once rather
+		 * than one by one.
+		 *
+		 * @param[in] frame The chat view frame.
+		 * @param[in] messages The messages to be appended.
+		 * @return true on success, false otherwise.
+		 */
+		virtual bool AppendMessages (QWebFrame *frame,
+				const QList<ChatMsgAppendItem>& messages) = 0;
+
+		/** @brief Inserts older messages before the ones in the view.
 		 *
-		 * This function is called whenever a new message should be
-		 * appended to the chat view located in the given frame.
+		 * This function is called when the user scrolls back to the
+		 * messages that have been dropped from the chat view to limit
+		 * its size. The messages are ordered from the oldest to the
+		 * newest one, and all of them are older than any message
+		 * currently shown in the frame.
 		 *
 		 * @param[in] frame The chat view frame.
-		 * @param[in] message The message to be appended.
-		 * @param[in] info Additional chat message info structure.
+		 * @param[in] messages The messages to be inserted.
 		 * @return true on success, false otherwise.
 		 */
-		virtual bool AppendMessage (QWebFrame *frame, QObject *message,
-				const ChatMsgAppendInfo& info) = 0;
+		virtual bool PrependMessages (QWebFrame *frame,
+				const QList<ChatMsgAppendItem>& messages) = 0;
 
 		/** @brief Notifies about a frame obtaining user input focus.
 		 *
@@ -160,6 +196,6 @@ namespace Azoth
 }
 
 Q_DECLARE_INTERFACE (LeechCraft::Azoth::IChatStyleResourceSource,
-		"org.Deviant.LeechCraft.Azoth.IChatStyleResourceSource/1.0");
+		"org.Deviant.LeechCraft.Azoth.IChatStyleResourceSource/2.0");
 
 #endif
@@ -270,10 +270,179 @@ namespace AdiumStyles
 					IMessage::Direction::Out :
 					IMessage::Direction::In;
 		}
+
+		QString EscapeForJS (const QString& bodyS)
+		{
+			QString body;
+			body.reserve (bodyS.size () * 1.2);
+			for (int i = 0, size = bodyS.size (); i < size; ++i)
+			{
+				switch (bodyS.at (i).unicode ())
+				{
+				case L'\"':
+					body += "\\\"";
+					break;
+				case L'\n':
+					body += "\\n";
+					break;
+				case L'\t':
+					body += "\\t";
+					break;
+				case L'\\':
+					body += "\\\\";
+					break;
+				case L'\r':
+					body += "\\r";
+					break;
+				default:
+					body += bodyS.at (i);
+					break;
+				}
+			}
+
+			return body;
+		}
+
+		QRegExp GetInsertionPointRx ()
+		{
+			return QRegExp ("<([A-Za-z][\\w:-]*)[^>]*\\sid\\s*=\\s*[\"']insert[\"'][^>]*>\\s*</\\1\\s*>");
+		}
+
+		/* Marks the first element of the message markup so that the chat
+		 * view could count the messages it shows.
+		 */
+		void MarkMessage (QString& html)
+		{
+			QRegExp tagRx ("<[A-Za-z][\\w:-]*");
+			const int pos = tagRx.indexIn (html);
+			if (pos != -1)
+				html.insert (pos + tagRx.matchedLength (), " data-azoth-msg=\"1\"");
+		}
+
+		struct MessageGroup
+		{
+			QString HTML_;
+			bool IsNext_;
+		};
+
+		/* Merges the message into the last group the same way
+		 * appendMessage() and appendNextMessage() from the template would
+		 * merge it into the document: consecutive messages replace the
+		 * insertion point of the previous one, and other messages remove it.
+		 *
+		 * A group starting with a consecutive message continues the last
+		 * message already in the document, so nothing but consecutive
+		 * messages may be merged into it.
+		 */
+		void AddToGroups (QList<MessageGroup>& groups, const QString& html, bool isNext)
+		{
+			if (groups.isEmpty () ||
+					(!isNext && groups.last ().IsNext_))
+			{
+				groups.append ({ html, isNext });
+				return;
+			}
+
+			auto& last = groups.last ().HTML_;
+			if (!isNext)
+			{
+				last.remove (GetInsertionPointRx ());
+				last += html;
+				return;
+			}
+
+			auto rx = GetInsertionPointRx ();
+			const int pos = rx.lastIndexIn (last);
+			if (pos == -1)
+				last += html;
+			else
+				last.replace (pos, rx.matchedLength (), html);
+		}
+
+		void ApplyDeliveryStates (QWebFrame *frame, const QHash<QString, QString>& states)
+		{
+			for (auto i = states.begin (), end = states.end (); i != end; ++i)
+			{
+				const QString& selector = QString ("*[id=\"delivery_state_%1\"]")
+						.arg (i.key ());
+				QWebElement elem = frame->findFirstElement (selector);
+				elem.setInnerXml (i.value ());
+			}
+		}
 	}
 
-	bool AdiumStyleSource::AppendMessage (QWebFrame *frame,
-			QObject *msgObj, const ChatMsgAppendInfo& info)
+	bool AdiumStyleSource::AppendMessages (QWebFrame *frame,
+			const QList<ChatMsgAppendItem>& messages)
+	{
+		QList<MessageGroup> groups;
+		QHash<QString, QString> states;
+		for (const auto& item : messages)
+		{
+			bool isNext = false;
+			const auto& html = FormatMessage (frame, item.Message_, item.Info_, isNext, states);
+			if (!html.isNull ())
+				AddToGroups (groups, html, isNext);
+		}
+
+		if (groups.isEmpty ())
+			return false;
+
+		QString script;
+		for (const auto& group : groups)
+		{
+			const QString& command = group.IsNext_ ? "appendNextMessage(\"%1\");" : "appendMessage(\"%1\");";
+			script += command.arg (EscapeForJS (group.HTML_));
+		}
+		frame->evaluateJavaScript (script);
+
+		ApplyDeliveryStates (frame, states);
+		return true;
+	}
+
+	bool AdiumStyleSource::PrependMessages (QWebFrame *frame,
+			const QList<ChatMsgAppendItem>& messages)
+	{
+		const auto lastContact = Frame2LastContact_.take (frame);
+
+		QList<MessageGroup> groups;
+		QHash<QString, QString> states;
+		for (const auto& item : messages)
+		{
+			bool isNext = false;
+			const auto& html = FormatMessage (frame, item.Message_, item.Info_, isNext, states);
+			if (!html.isNull ())
+				AddToGroups (groups, html, isNext);
+		}
+
+		Frame2LastContact_.remove (frame);
+		if (lastContact)
+			Frame2LastContact_ [frame] = lastContact;
+
+		if (groups.isEmpty ())
+			return false;
+
+		QString html;
+		for (const auto& group : groups)
+			html += group.HTML_;
+		html.remove (GetInsertionPointRx ());
+
+		auto first = frame->findFirstElement ("#Chat [data-azoth-msg]");
+		if (!first.isNull ())
+			first.prependOutside (html);
+		else
+		{
+			auto chat = frame->findFirstElement ("#Chat");
+			if (chat.isNull ())
+				chat = frame->findFirstElement ("body");
+			chat.appendInside (html);
+		}
+
+		ApplyDeliveryStates (frame, states);
+		return true;
+	}
+
+	QString AdiumStyleSource::FormatMessage (QWebFrame *frame, QObject *msgObj,
+			const ChatMsgAppendInfo& info, bool& isNextMsg, QHash<QString, QString>& states)
 	{
 		IMessage *msg = qobject_cast<IMessage*> (msgObj);
 		if (!msg)
@@ -281,7 +450,7 @@ namespace AdiumStyles
 			qWarning () << Q_FUNC_INFO
 					<< msgObj
 					<< "doesn't implement IMessage";
-			return false;
+			return {};
 		}
 
 		const QString& pack = Frame2Pack_ [frame];
@@ -291,7 +460,7 @@ namespace AdiumStyles
 					<< "empty pack for"
 					<< msgObj
 					<< msg->OtherPart ();
-			return false;
+			return {};
 		}
 
 		connect (msgObj,
@@ -306,7 +475,7 @@ namespace AdiumStyles
 		const bool isSlashMe = msg->GetBody ().trimmed ().startsWith ("/me ");
 		const bool alwaysNotNext = isSlashMe ||
 				!(msg->GetMessageType () == IMessage::Type::ChatMessage || msg->GetMessageType () == IMessage::Type::MUCMessage);
-		const bool isNextMsg = !alwaysNotNext &&
+		isNextMsg = !alwaysNotNext &&
 				Frame2LastContact_.contains (frame) &&
 				kindaSender == Frame2LastContact_ [frame];
 
@@ -353,7 +522,7 @@ namespace AdiumStyles
 					<< "unable to load content template for"
 					<< pack
 					<< prefix;
-			return false;
+			return {};
 		}
 
 		if (!content->open (QIODevice::ReadOnly))
@@ -363,41 +532,13 @@ namespace AdiumStyles
 					<< pack
 					<< prefix
 					<< content->errorString ();
-			return false;
+			return {};
 		}
 
 		QString templ = QString::fromUtf8 (content->readAll ());
 		FixSelfClosing (templ);
-		QString bodyS = ParseMsgTemplate (templ, prefix, frame, msgObj, info);
-		QString body;
-		body.reserve (bodyS.size () * 1.2);
-		for (int i = 0, size = bodyS.size (); i < size; ++i)
-		{
-			switch (bodyS.at (i).unicode ())
-			{
-			case L'\"':
-				body += "\\\"";
-				break;
-			case L'\n':
-				body += "\\n";
-				break;
-			case L'\t':
-				body += "\\t";
-				break;
-			case L'\\':
-				body += "\\\\";
-				break;
-			case L'\r':
-				body += "\\r";
-				break;
-			default:
-				body += bodyS.at (i);
-				break;
-			}
-		}
-
-		const QString& command = isNextMsg ? "appendNextMessage(\"%1\");" : "appendMessage(\"%1\");";
-		frame->evaluateJavaScript (command.arg (body));
+		QString html = ParseMsgTemplate (templ, prefix, frame, msgObj, info);
+		MarkMessage (html);
 
 		if (templ.contains ("%stateElementId%"))
 		{
@@ -422,13 +563,10 @@ namespace AdiumStyles
 			if (content && content->open (QIODevice::ReadOnly))
 				replacement = QString::fromUtf8 (content->readAll ());
 
-			const QString& selector = QString ("*[id=\"delivery_state_%1\"]")
-					.arg (GetMessageID (msgObj));
-			QWebElement elem = frame->findFirstElement (selector);
-			elem.setInnerXml (replacement);
+			states [GetMessageID (msgObj)] = replacement;
 		}
 
-		return true;
+		return html;
 	}
 
 	void AdiumStyleSource::FrameFocused (QWebFrame*)
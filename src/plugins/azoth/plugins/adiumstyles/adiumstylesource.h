@@ -82,10 +82,13 @@ namespace AdiumStyles
 		QUrl GetBaseURL (const QString&) const;
 		QString GetHTMLTemplate (const QString&,
 				const QString&, QObject*, QWebFrame*) const;
-		bool AppendMessage (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
+		bool AppendMessages (QWebFrame*, const QList<ChatMsgAppendItem>&);
+		bool PrependMessages (QWebFrame*, const QList<ChatMsgAppendItem>&);
 		void FrameFocused (QWebFrame*);
 		QStringList GetVariantsForPack (const QString&);
 	private:
+		QString FormatMessage (QWebFrame*, QObject*, const ChatMsgAppendInfo&,
+				bool& isNextMsg, QHash<QString, QString>& deliveryStates);
 		void PercentTemplate (QString&, const QMap<QString, QString>&) const;
 		void SubstituteUserIcon (QString&,
 				const QString&, bool, ICLEntry*, IAccount*);
@@ -145,7 +145,61 @@ namespace StandardStyles
 		}
 	}
 
-	bool StandardStyleSource::AppendMessage (QWebFrame *frame,
+	bool StandardStyleSource::AppendMessages (QWebFrame *frame,
+			const QList<ChatMsgAppendItem>& messages)
+	{
+		const QString separator ("<hr class=\"lastSeparator\" />");
+
+		QString html;
+		int separatorPos = -1;
+		for (const auto& item : messages)
+		{
+			const auto msg = qobject_cast<IMessage*> (item.Message_);
+			if (msg->GetMessageType () == IMessage::Type::ChatMessage ||
+				msg->GetMessageType () == IMessage::Type::MUCMessage)
+			{
+				const auto isRead = Proxy_->IsMessageRead (item.Message_);
+				if (!item.Info_.IsActiveChat_ &&
+						!isRead && IsLastMsgRead_.value (frame, false))
+				{
+					if (separatorPos >= 0)
+						html.remove (separatorPos, separator.size ());
+					else
+					{
+						auto hr = frame->findFirstElement ("hr[class=\"lastSeparator\"]");
+						if (!hr.isNull ())
+							hr.removeFromDocument ();
+					}
+
+					separatorPos = html.size ();
+					html += separator;
+				}
+				IsLastMsgRead_ [frame] = isRead;
+			}
+
+			html += FormatMessage (frame, item.Message_, item.Info_);
+		}
+
+		frame->findFirstElement ("body").appendInside (html);
+		return true;
+	}
+
+	bool StandardStyleSource::PrependMessages (QWebFrame *frame,
+			const QList<ChatMsgAppendItem>& messages)
+	{
+		QString html;
+		for (const auto& item : messages)
+			html += FormatMessage (frame, item.Message_, item.Info_);
+
+		auto first = frame->findFirstElement ("body [data-azoth-msg]");
+		if (first.isNull ())
+			frame->findFirstElement ("body").appendInside (html);
+		else
+			first.prependOutside (html);
+		return true;
+	}
+
+	QString StandardStyleSource::FormatMessage (QWebFrame *frame,
 			QObject *msgObj, const ChatMsgAppendInfo& info)
 	{
 		QObject *azothSettings = Proxy_->GetSettingsManager ();
@@ -153,7 +207,6 @@ namespace StandardStyles
 		auto& formatter = Proxy_->GetFormatterProxy ();
 
 		const bool isHighlightMsg = info.IsHighlightMsg_;
-		const bool isActiveChat = info.IsActiveChat_;
 
 		const QString& msgId = GetMessageID (msgObj);
 
@@ -324,27 +377,9 @@ namespace StandardStyles
 					.arg (msgId));
 		string.append (body);
 
-		QWebElement elem = frame->findFirstElement ("body");
-
-		if (msg->GetMessageType () == IMessage::Type::ChatMessage ||
-			msg->GetMessageType () == IMessage::Type::MUCMessage)
-		{
-			const auto isRead = Proxy_->IsMessageRead (msgObj);
-			if (!isActiveChat &&
-					!isRead && IsLastMsgRead_.value (frame, false))
-			{
-				auto hr = elem.findFirst ("hr[class=\"lastSeparator\"]");
-				if (!hr.isNull ())
-					hr.removeFromDocument ();
-				elem.appendInside ("<hr class=\"lastSeparator\" />");
-			}
-			IsLastMsgRead_ [frame] = isRead;
-		}
-
-		elem.appendInside (QString ("<div class='%1' style='word-wrap: break-word;'>%2</div>")
+		return QString ("<div class='%1' data-azoth-msg='1' style='word-wrap: break-word;'>%2</div>")
 					.arg (divClass)
-					.arg (string));
-		return true;
+					.arg (string);
 	}
 
 	void StandardStyleSource::FrameFocused (QWebFrame *frame)
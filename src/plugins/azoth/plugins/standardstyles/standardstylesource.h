@@ -72,10 +72,12 @@ namespace StandardStyles
 		QUrl GetBaseURL (const QString&) const;
 		QString GetHTMLTemplate (const QString&,
 				const QString&, QObject*, QWebFrame*) const;
-		bool AppendMessage (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
+		bool AppendMessages (QWebFrame*, const QList<ChatMsgAppendItem>&);
+		bool PrependMessages (QWebFrame*, const QList<ChatMsgAppendItem>&);
 		void FrameFocused (QWebFrame*);
 		QStringList GetVariantsForPack (const QString&);
 	private:
+		QString FormatMessage (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
 		QList<QColor> CreateColors (const QString&, QWebFrame*);
 		QString GetMessageID (QObject*);
 		QString GetStatusImage (const QString&);
@@ -49,7 +49,7 @@ namespace Xoox
 		}
 
 		auto xmppClient = sharedPtr->GetClient ();
-		if (xmppClient->isConnected ())
+		if (sharedPtr->IsStreamEstablished ())
 			connect (xmppClient,
 					SIGNAL (disconnected ()),
 					this,
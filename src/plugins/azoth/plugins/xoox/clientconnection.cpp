@@ -95,6 +95,8 @@
 #include "xep0313manager.h"
 #include "carbonsmanager.h"
 #include "pingmanager.h"
+#include "rosterversionmanager.h"
+#include "xep0198manager.h"
 #include "xep0334utils.h"
 
 namespace LeechCraft
@@ -134,6 +136,8 @@ namespace Xoox
 	, Xep0313Manager_ (new Xep0313Manager)
 	, CarbonsManager_ (new CarbonsManager)
 	, PingManager_ (new PingManager)
+	, RosterVersionManager_ (new RosterVersionManager ([this] { return GetCachedRosterItems (); }))
+	, Xep0198Manager_ (new Xep0198Manager)
 	, CryptHandler_ (new CryptHandler (this))
 	, ErrorMgr_ (new ClientConnectionErrorMgr (this))
 	, InfoReqPolicyMgr_ (new InfoRequestPolicyManager (this))
@@ -223,6 +227,20 @@ namespace Xoox
 		Client_->addExtension (CarbonsManager_);
 		Client_->addExtension (PingManager_);
 
+		// Should go before the roster manager to see the replies to versioned requests.
+		Client_->insertExtension (0, RosterVersionManager_);
+		connect (RosterVersionManager_,
+				SIGNAL (versionChanged (QString)),
+				Account_,
+				SIGNAL (rosterSaveRequested ()));
+
+		// Should see all the incoming stanzas to count them.
+		Client_->insertExtension (0, Xep0198Manager_);
+		connect (Xep0198Manager_,
+				SIGNAL (streamResumed ()),
+				this,
+				SLOT (handleStreamResumed ()));
+
 		connect (CarbonsManager_,
 				SIGNAL (gotMessage (QXmppMessage)),
 				this,
@@ -271,7 +289,7 @@ namespace Xoox
 				this,
 				SLOT (handleGotRIEXItems (QString, QList<RIEXManager::Item>, bool)));
 
-		connect (&Client_->rosterManager (),
+		connect (RosterVersionManager_,
 				SIGNAL (rosterReceived ()),
 				this,
 				SLOT (handleRosterReceived ()));
@@ -367,7 +385,11 @@ namespace Xoox
 			pres.setPhotoHash (Settings_->GetPhotoHash ());
 		}
 
-		if (IsConnected_ ||
+		// QXmppClient would try to connect once again on a resumed stream.
+		if (Xep0198Manager_->IsStreamResumed () &&
+				state.State_ != SOffline)
+			Client_->sendPacket (pres);
+		else if (IsConnected_ ||
 				state.State_ == SOffline)
 			Client_->setClientPresence (pres);
 
@@ -584,6 +606,11 @@ namespace Xoox
 		return PingManager_;
 	}
 
+	RosterVersionManager* ClientConnection::GetRosterVersionManager () const
+	{
+		return RosterVersionManager_;
+	}
+
 	InfoRequestPolicyManager* ClientConnection::GetInfoReqPolicyManager () const
 	{
 		return InfoReqPolicyMgr_;
@@ -766,7 +793,9 @@ namespace Xoox
 			Xep0334::SetHint (msg, Xep0334::MessageHint::NoStorage);
 		}
 
-		Client_->sendPacket (msg);
+		const auto isSent = !Xep0198Manager_->IsResuming () && Client_->sendPacket (msg);
+		if (!isSent && !msgObj->IsOTRMessage ())
+			Xep0198Manager_->QueueForResend (msg);
 	}
 
 	QXmppClient* ClientConnection::GetClient () const
@@ -774,6 +803,11 @@ namespace Xoox
 		return Client_;
 	}
 
+	bool ClientConnection::IsStreamEstablished () const
+	{
+		return Client_->isConnected () || Xep0198Manager_->IsStreamResumed ();
+	}
+
 	QObject* ClientConnection::GetCLEntry (const QString& fullJid) const
 	{
 		QString bare;
@@ -976,6 +1010,16 @@ namespace Xoox
 		emit statusChanged (EntryStatus (SOffline, LastState_.Status_));
 	}
 
+	void ClientConnection::handleStreamResumed ()
+	{
+		// The server has kept our presence, the rooms and the roster
+		// subscription, so unlike handleConnected() there is nothing to
+		// redo apart from restoring the roster QXmpp has forgotten.
+		emit statusChanged ({ LastState_.State_, LastState_.Status_ });
+
+		RosterVersionManager_->HandleStreamResumed ();
+	}
+
 	void ClientConnection::handleIqReceived (const QXmppIq& iq)
 	{
 		ErrorMgr_->HandleIq (iq);
@@ -989,8 +1033,12 @@ namespace Xoox
 		for (const auto& bareJid : rm.getRosterBareJids ())
 		{
 			const auto& re = rm.getRosterEntry (bareJid);
+
+			// Entries restored from the roster cache are already known to the UI.
+			const bool isKnown = JID2CLEntry_.contains (bareJid) || ODSEntries_.contains (bareJid);
 			const auto entry = CreateCLEntry (re);
-			items << entry;
+			if (!isKnown)
+				items << entry;
 			const auto& presences = rm.getAllPresencesForBareJid (re.bareJid ());
 			for (const auto& resource : presences.keys ())
 				entry->SetClientInfo (resource, presences [resource]);
@@ -1019,7 +1067,8 @@ namespace Xoox
 				}
 			}
 		}
-		emit gotRosterItems (items);
+		if (!items.isEmpty ())
+			emit gotRosterItems (items);
 
 		for (const auto& msg : OfflineMsgQueue_)
 			handleMessageReceived (msg);
@@ -1192,7 +1241,7 @@ namespace Xoox
 			RoomHandlers_ [jid]->HandleMessage (msg, resource);
 		else if (JID2CLEntry_.contains (jid))
 			HandleMessageForEntry (JID2CLEntry_ [jid], msg, resource, this, forwarded);
-		else if (!Client_->rosterManager ().isRosterReceived ())
+		else if (!RosterVersionManager_->IsRosterReceived ())
 			OfflineMsgQueue_ << msg;
 		else if (jid == OurBareJID_)
 		{
@@ -1623,6 +1672,24 @@ namespace Xoox
 		JID2CLEntry_ [bareJID] = entry;
 		return entry;
 	}
+
+	QList<QXmppRosterIq::Item> ClientConnection::GetCachedRosterItems () const
+	{
+		QList<QXmppRosterIq::Item> result;
+		for (const auto entry : ODSEntries_)
+		{
+			const auto& ods = entry->ToOfflineDataSource ();
+
+			QXmppRosterIq::Item item;
+			item.setBareJid (entry->GetJID ());
+			if (ods->Name_ != entry->GetJID ())
+				item.setName (ods->Name_);
+			item.setGroups (ods->Groups_.toSet ());
+			item.setSubscriptionType (static_cast<QXmppRosterIq::Item::SubscriptionType> (ods->AuthStatus_));
+			result << item;
+		}
+		return result;
+	}
 }
 }
 }
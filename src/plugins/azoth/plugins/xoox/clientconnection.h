@@ -86,6 +86,8 @@ namespace Xoox
 	class Xep0313Manager;
 	class CarbonsManager;
 	class PingManager;
+	class RosterVersionManager;
+	class Xep0198Manager;
 
 	class InfoRequestPolicyManager;
 	class ClientConnectionErrorMgr;
@@ -135,6 +137,8 @@ namespace Xoox
 		Xep0313Manager *Xep0313Manager_;
 		CarbonsManager *CarbonsManager_;
 		PingManager *PingManager_;
+		RosterVersionManager *RosterVersionManager_;
+		Xep0198Manager *Xep0198Manager_;
 
 		CryptHandler *CryptHandler_;
 		ClientConnectionErrorMgr *ErrorMgr_;
@@ -230,6 +234,7 @@ namespace Xoox
 		SDManager* GetSDManager () const;
 		Xep0313Manager* GetXep0313Manager () const;
 		PingManager* GetPingManager () const;
+		RosterVersionManager* GetRosterVersionManager () const;
 
 		InfoRequestPolicyManager* GetInfoReqPolicyManager () const;
 
@@ -260,6 +265,13 @@ namespace Xoox
 		void SendMessage (GlooxMessage*);
 
 		QXmppClient* GetClient () const;
+
+		/** Returns whether the stream to the server is established,
+		 * including the case of a resumed XEP-0198 session, which
+		 * QXmppClient doesn't know about.
+		 */
+		bool IsStreamEstablished () const;
+
 		QObject* GetCLEntry (const QString& fullJid) const;
 		QObject* GetCLEntry (const QString& bareJid, const QString& variant) const;
 		GlooxCLEntry* AddODSCLEntry (OfflineDataSource_ptr);
@@ -287,6 +299,7 @@ namespace Xoox
 	private slots:
 		void handleConnected ();
 		void handleDisconnected ();
+		void handleStreamResumed ();
 		void handleIqReceived (const QXmppIq&);
 		void handleRosterReceived ();
 		void handleRosterChanged (const QString&);
@@ -326,6 +339,7 @@ namespace Xoox
 		GlooxCLEntry* CreateCLEntry (const QString&);
 		GlooxCLEntry* CreateCLEntry (const QXmppRosterIq::Item&);
 		GlooxCLEntry* ConvertFromODS (const QString&, const QXmppRosterIq::Item&);
+		QList<QXmppRosterIq::Item> GetCachedRosterItems () const;
 	signals:
 		void gotRosterItems (const QList<QObject*>&);
 		void rosterItemRemoved (QObject*);
@@ -198,7 +198,7 @@ namespace Xoox
 		const bool dontTryFurther = error.type () == QXmppStanza::Error::Cancel ||
 			(error.type () == QXmppStanza::Error::Auth &&
 			 error.condition () != QXmppStanza::Error::NotAuthorized);
-		if (dontTryFurther && !ClientConn_->GetClient ()->isConnected ())
+		if (dontTryFurther && !ClientConn_->IsStreamEstablished ())
 		{
 			GlooxAccountState state =
 			{
@@ -47,6 +47,7 @@
 #include "privacylistsmanager.h"
 #include "glooxmessage.h"
 #include "vcardstorage.h"
+#include "rosterversionmanager.h"
 
 namespace LeechCraft
 {
@@ -320,9 +321,9 @@ namespace Xoox
 		if (AuthRequested_)
 			return EntryStatus (SOnline, QString ());
 
-		QXmppRosterManager& rm = Account_->
-				GetClientConnection ()->GetClient ()->rosterManager ();
-		if (!rm.isRosterReceived ())
+		const auto conn = Account_->GetClientConnection ();
+		QXmppRosterManager& rm = conn->GetClient ()->rosterManager ();
+		if (!conn->GetRosterVersionManager ()->IsRosterReceived ())
 			return EntryBase::GetStatus (variant);
 
 		const QMap<QString, QXmppPresence>& press = rm.getAllPresencesForBareJid (GetJID ());
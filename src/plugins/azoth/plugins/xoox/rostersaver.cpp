@@ -36,6 +36,8 @@
 #include <interfaces/azoth/iproxyobject.h>
 #include "glooxprotocol.h"
 #include "glooxaccount.h"
+#include "clientconnection.h"
+#include "rosterversionmanager.h"
 
 namespace LeechCraft
 {
@@ -143,6 +145,11 @@ namespace Xoox
 				entry = entry.nextSiblingElement ("entry");
 			}
 
+			const auto& version = account.firstChildElement ("version");
+			if (!version.isNull ())
+				id2account [id]->GetClientConnection ()->
+						GetRosterVersionManager ()->SetVersion (version.text ());
+
 			account = account.nextSiblingElement ("account");
 		}
 	}
@@ -181,9 +188,15 @@ namespace Xoox
 		w.writeAttribute ("formatversion", "1");
 		for (auto accObj : Proto_->GetRegisteredAccounts ())
 		{
-			auto acc = qobject_cast<IAccount*> (accObj);
+			auto acc = qobject_cast<GlooxAccount*> (accObj);
 			w.writeStartElement ("account");
 				w.writeTextElement ("id", acc->GetAccountID ());
+
+				const auto& version = acc->GetClientConnection ()->
+						GetRosterVersionManager ()->GetVersion ();
+				if (!version.isEmpty ())
+					w.writeTextElement ("version", version);
+
 				w.writeStartElement ("entries");
 				for (auto entryObj : acc->GetCLEntries ())
 				{
@@ -0,0 +1,79 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QHash>
+#include <QXmppRosterIq.h>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	/** Keeps the roster items matching the roster version known to the
+	 * RosterVersionManager.
+	 *
+	 * The items are loaded from the roster cache on disk the first time
+	 * they are needed and are then kept up to date with the full rosters
+	 * and roster pushes received afterwards. Thus they still match the
+	 * version after a reconnect, when the cached entries have long been
+	 * turned into the online ones.
+	 */
+	class RosterSnapshot
+	{
+	public:
+		typedef std::function<QList<QXmppRosterIq::Item> ()> CachedItemsGetter_f;
+	private:
+		const CachedItemsGetter_f CachedItemsGetter_;
+
+		QHash<QString, QXmppRosterIq::Item> Items_;
+		bool IsLoaded_ = false;
+	public:
+		RosterSnapshot (const CachedItemsGetter_f&);
+
+		/** Returns the items of the roster as of the last known version.
+		 */
+		QList<QXmppRosterIq::Item> GetItems ();
+
+		/** Replaces the items with the ones of a full roster.
+		 */
+		void SetItems (const QList<QXmppRosterIq::Item>&);
+
+		/** Applies the roster push to the items.
+		 */
+		void HandlePush (const QXmppRosterIq&);
+	private:
+		void Load ();
+	};
+}
+}
+}
@@ -0,0 +1,267 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "rosterversionmanager.h"
+#include <QDomDocument>
+#include <QDomElement>
+#include <QXmlStreamWriter>
+#include <QtDebug>
+#include <QXmppClient.h>
+#include <QXmppRosterManager.h>
+#include <QXmppUtils.h>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	namespace
+	{
+		const QString NsRoster { "jabber:iq:roster" };
+	}
+
+	RosterVersionManager::RosterVersionManager (const CachedItemsGetter_f& getter)
+	: Snapshot_ { getter }
+	{
+	}
+
+	bool RosterVersionManager::handleStanza (const QDomElement& stanza)
+	{
+		if (stanza.tagName () != "iq")
+			return false;
+
+		// The "roster is up to date" reply has no <query/> child at all,
+		// so match it by the ID before checking the namespace.
+		if (!RequestId_.isEmpty () &&
+				stanza.attribute ("id") == RequestId_)
+		{
+			HandleResponse (stanza);
+			return true;
+		}
+
+		if (stanza.attribute ("type") != "set" ||
+				!QXmppRosterIq::isRosterIq (stanza))
+			return false;
+
+		const auto& from = stanza.attribute ("from");
+		if (!from.isEmpty () &&
+				QXmppUtils::jidToBareJid (from) != client ()->configuration ().jidBare ())
+			return false;
+
+		QXmppRosterIq push;
+		push.parse (stanza);
+		Snapshot_.HandlePush (push);
+
+		const auto& query = stanza.firstChildElement ("query");
+		if (query.hasAttribute ("ver"))
+			UpdateVersion (query.attribute ("ver"));
+
+		// The push itself is still handled by the roster manager.
+		return false;
+	}
+
+	void RosterVersionManager::SetVersion (const QString& version)
+	{
+		Version_ = version;
+	}
+
+	QString RosterVersionManager::GetVersion () const
+	{
+		return Version_;
+	}
+
+	bool RosterVersionManager::IsRosterReceived () const
+	{
+		return TookOver_ ?
+				IsRosterReceived_ :
+				RosterManager_ && RosterManager_->isRosterReceived ();
+	}
+
+	void RosterVersionManager::HandleStreamResumed ()
+	{
+		if (!TookOver_ || !RosterManager_)
+			return;
+
+		FeedCachedRoster ();
+
+		IsRosterReceived_ = true;
+		emit rosterReceived ();
+	}
+
+	void RosterVersionManager::setClient (QXmppClient *client)
+	{
+		QXmppClientExtension::setClient (client);
+
+		RosterManager_ = client->findExtension<QXmppRosterManager> ();
+		if (!RosterManager_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "no roster manager";
+			return;
+		}
+
+		TookOver_ = disconnect (client,
+				SIGNAL (connected ()),
+				RosterManager_,
+				SLOT (_q_connected ()));
+		if (!TookOver_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to take over the initial roster request, "
+						"roster versioning is disabled";
+			connect (RosterManager_,
+					SIGNAL (rosterReceived ()),
+					this,
+					SLOT (handleManagerRosterReceived ()));
+			return;
+		}
+
+		connect (client,
+				SIGNAL (connected ()),
+				this,
+				SLOT (handleConnected ()));
+		connect (client,
+				SIGNAL (disconnected ()),
+				this,
+				SLOT (handleDisconnected ()));
+	}
+
+	void RosterVersionManager::RequestRoster (bool versioned)
+	{
+		// An empty version still bootstraps versioning if we have no cache.
+		QXmppElement query;
+		query.setTagName ("query");
+		query.setAttribute ("xmlns", NsRoster);
+		if (versioned)
+			query.setAttribute ("ver", Version_);
+
+		QXmppIq iq { QXmppIq::Get };
+		iq.setFrom (client ()->configuration ().jid ());
+		iq.setExtensions ({ query });
+
+		RequestId_ = iq.id ();
+		RequestVersioned_ = versioned;
+		client ()->sendPacket (iq);
+	}
+
+	void RosterVersionManager::HandleResponse (const QDomElement& stanza)
+	{
+		RequestId_.clear ();
+
+		if (stanza.attribute ("type") == "error")
+		{
+			if (RequestVersioned_)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "versioned roster request failed, refetching the whole roster";
+				UpdateVersion ({});
+				RequestRoster (false);
+				return;
+			}
+
+			qWarning () << Q_FUNC_INFO
+					<< "roster request failed";
+		}
+		else
+		{
+			const auto& query = stanza.firstChildElement ("query");
+			if (query.isNull ())
+				FeedCachedRoster ();
+			else
+			{
+				QXmppRosterIq roster;
+				roster.parse (stanza);
+				Snapshot_.SetItems (roster.items ());
+
+				RosterManager_->handleStanza (stanza);
+
+				// A server not supporting versioning just omits the
+				// attribute, and the stale version should be dropped then.
+				UpdateVersion (query.attribute ("ver"));
+			}
+		}
+
+		IsRosterReceived_ = true;
+		emit rosterReceived ();
+	}
+
+	void RosterVersionManager::FeedCachedRoster ()
+	{
+		QXmppRosterIq iq;
+		iq.setType (QXmppIq::Result);
+		for (const auto& item : Snapshot_.GetItems ())
+			iq.addItem (item);
+
+		QByteArray data;
+		QXmlStreamWriter w { &data };
+		iq.toXml (&w);
+
+		QDomDocument doc;
+		if (!doc.setContent (data, true))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to parse the cached roster"
+					<< data;
+			return;
+		}
+
+		RosterManager_->handleStanza (doc.documentElement ());
+	}
+
+	void RosterVersionManager::UpdateVersion (const QString& version)
+	{
+		if (version == Version_)
+			return;
+
+		Version_ = version;
+		emit versionChanged (Version_);
+	}
+
+	void RosterVersionManager::handleConnected ()
+	{
+		if (!client ()->isAuthenticated ())
+			return;
+
+		RequestRoster (true);
+	}
+
+	void RosterVersionManager::handleDisconnected ()
+	{
+		RequestId_.clear ();
+		IsRosterReceived_ = false;
+	}
+
+	void RosterVersionManager::handleManagerRosterReceived ()
+	{
+		emit rosterReceived ();
+	}
+}
+}
+}
@@ -0,0 +1,104 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QXmppClientExtension.h>
+#include "rostersnapshot.h"
+
+class QXmppRosterManager;
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	/** Implements roster versioning as described in RFC 6121, section 2.6.
+	 *
+	 * This extension takes over the initial roster request from the
+	 * QXmppRosterManager: the request carries the version of the
+	 * roster cached on disk, so the server either replies with an empty
+	 * result (the cached roster is current and only the pushes since
+	 * that version follow) or with the full roster. In the former case
+	 * the roster manager is fed with the cached items, so the rest of
+	 * the code sees the usual roster manager state either way.
+	 *
+	 * The items matching the version are kept in a RosterSnapshot, so
+	 * that the roster manager, which forgets the roster on disconnect,
+	 * is fed the right items on reconnects too.
+	 */
+	class RosterVersionManager : public QXmppClientExtension
+	{
+		Q_OBJECT
+	public:
+		typedef RosterSnapshot::CachedItemsGetter_f CachedItemsGetter_f;
+	private:
+		RosterSnapshot Snapshot_;
+
+		QXmppRosterManager *RosterManager_ = nullptr;
+		bool TookOver_ = false;
+
+		QString Version_;
+		QString RequestId_;
+		bool RequestVersioned_ = false;
+		bool IsRosterReceived_ = false;
+	public:
+		RosterVersionManager (const CachedItemsGetter_f&);
+
+		bool handleStanza (const QDomElement&);
+
+		void SetVersion (const QString&);
+		QString GetVersion () const;
+
+		bool IsRosterReceived () const;
+
+		/** Feeds the roster manager with the roster it has dropped on
+		 * disconnect, since a resumed XEP-0198 session doesn't request
+		 * it again.
+		 */
+		void HandleStreamResumed ();
+	protected:
+		void setClient (QXmppClient*);
+	private:
+		void RequestRoster (bool);
+		void HandleResponse (const QDomElement&);
+		void FeedCachedRoster ();
+		void UpdateVersion (const QString&);
+	private slots:
+		void handleConnected ();
+		void handleDisconnected ();
+		void handleManagerRosterReceived ();
+	signals:
+		void rosterReceived ();
+		void versionChanged (const QString&);
+	};
+}
+}
+}
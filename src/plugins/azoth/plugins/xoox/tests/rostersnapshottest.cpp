@@ -0,0 +1,177 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "rostersnapshottest.h"
+#include <QtTest>
+#include "rostersnapshot.h"
+
+QTEST_MAIN (LeechCraft::Azoth::Xoox::RosterSnapshotTest)
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	namespace
+	{
+		QXmppRosterIq::Item MakeItem (const QString& jid, const QString& name = {},
+				QXmppRosterIq::Item::SubscriptionType type = QXmppRosterIq::Item::Both)
+		{
+			QXmppRosterIq::Item item;
+			item.setBareJid (jid);
+			item.setName (name);
+			item.setSubscriptionType (type);
+			return item;
+		}
+
+		QXmppRosterIq MakePush (const QXmppRosterIq::Item& item)
+		{
+			QXmppRosterIq iq;
+			iq.setType (QXmppIq::Set);
+			iq.addItem (item);
+			return iq;
+		}
+
+		QStringList GetJids (const QList<QXmppRosterIq::Item>& items)
+		{
+			QStringList result;
+			for (const auto& item : items)
+				result << item.bareJid ();
+			result.sort ();
+			return result;
+		}
+
+		QString GetName (const QList<QXmppRosterIq::Item>& items, const QString& jid)
+		{
+			for (const auto& item : items)
+				if (item.bareJid () == jid)
+					return item.name ();
+			return {};
+		}
+	}
+
+	void RosterSnapshotTest::cachedOnStartup ()
+	{
+		RosterSnapshot snapshot
+		{
+			[] { return QList<QXmppRosterIq::Item> { MakeItem ("a@x.org"), MakeItem ("b@x.org") }; }
+		};
+
+		QCOMPARE (GetJids (snapshot.GetItems ()), (QStringList { "a@x.org", "b@x.org" }));
+	}
+
+	void RosterSnapshotTest::cacheLoadedOnce ()
+	{
+		int loads = 0;
+		RosterSnapshot snapshot
+		{
+			[&loads]
+			{
+				++loads;
+				return QList<QXmppRosterIq::Item> { MakeItem ("a@x.org") };
+			}
+		};
+
+		snapshot.GetItems ();
+		snapshot.GetItems ();
+		QCOMPARE (loads, 1);
+	}
+
+	void RosterSnapshotTest::pushesApplied ()
+	{
+		RosterSnapshot snapshot
+		{
+			[] { return QList<QXmppRosterIq::Item> { MakeItem ("a@x.org"), MakeItem ("b@x.org") }; }
+		};
+		snapshot.GetItems ();
+
+		snapshot.HandlePush (MakePush (MakeItem ("c@x.org")));
+		snapshot.HandlePush (MakePush (MakeItem ("a@x.org", {}, QXmppRosterIq::Item::Remove)));
+		snapshot.HandlePush (MakePush (MakeItem ("b@x.org", "Bob")));
+
+		const auto& items = snapshot.GetItems ();
+		QCOMPARE (GetJids (items), (QStringList { "b@x.org", "c@x.org" }));
+		QCOMPARE (GetName (items, "b@x.org"), QString { "Bob" });
+	}
+
+	void RosterSnapshotTest::pushesBeforeLoadApplied ()
+	{
+		RosterSnapshot snapshot
+		{
+			[] { return QList<QXmppRosterIq::Item> { MakeItem ("a@x.org") }; }
+		};
+
+		snapshot.HandlePush (MakePush (MakeItem ("b@x.org")));
+
+		QCOMPARE (GetJids (snapshot.GetItems ()), (QStringList { "a@x.org", "b@x.org" }));
+	}
+
+	void RosterSnapshotTest::reconnectKeepsItems ()
+	{
+		// After the first connect the cached offline entries become the
+		// online ones, so the cache has nothing to offer anymore.
+		bool isConnected = false;
+		RosterSnapshot snapshot
+		{
+			[&isConnected]
+			{
+				return isConnected ?
+						QList<QXmppRosterIq::Item> {} :
+						QList<QXmppRosterIq::Item> { MakeItem ("a@x.org"), MakeItem ("b@x.org") };
+			}
+		};
+
+		// The first connect: the roster is unchanged since the cache.
+		QCOMPARE (snapshot.GetItems ().size (), 2);
+		isConnected = true;
+
+		snapshot.HandlePush (MakePush (MakeItem ("c@x.org")));
+
+		// The reconnect: the roster is unchanged since the last push.
+		QCOMPARE (GetJids (snapshot.GetItems ()), (QStringList { "a@x.org", "b@x.org", "c@x.org" }));
+	}
+
+	void RosterSnapshotTest::fullRosterReplaces ()
+	{
+		RosterSnapshot snapshot
+		{
+			[] { return QList<QXmppRosterIq::Item> { MakeItem ("a@x.org"), MakeItem ("b@x.org") }; }
+		};
+
+		snapshot.SetItems ({ MakeItem ("c@x.org") });
+		QCOMPARE (GetJids (snapshot.GetItems ()), QStringList { "c@x.org" });
+
+		snapshot.HandlePush (MakePush (MakeItem ("d@x.org")));
+		snapshot.SetItems ({ MakeItem ("a@x.org") });
+		QCOMPARE (GetJids (snapshot.GetItems ()), QStringList { "a@x.org" });
+	}
+}
+}
+}
@@ -0,0 +1,164 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "xep0198queuetest.h"
+#include <QtTest>
+#include "xep0198queue.h"
+
+QTEST_MAIN (LeechCraft::Azoth::Xoox::Xep0198QueueTest)
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	namespace
+	{
+		QString MakeMessage (int num)
+		{
+			return QString { "<message id=\"m%1\" to=\"a@b.c\"><body>%1</body></message>" }
+					.arg (num);
+		}
+
+		void SendMessages (Xep0198Queue& queue, int from, int count)
+		{
+			for (int i = from; i < from + count; ++i)
+				queue.HandleOutgoing (MakeMessage (i));
+		}
+	}
+
+	void Xep0198QueueTest::partialAcks ()
+	{
+		Xep0198Queue queue;
+		SendMessages (queue, 0, 5);
+		QCOMPARE (queue.GetOutCount (), 5u);
+		QCOMPARE (queue.GetUnackedCount (), 5);
+
+		QVERIFY (queue.Ack (3));
+		QCOMPARE (queue.GetUnackedCount (), 2);
+
+		QVERIFY (queue.Ack (5));
+		QCOMPARE (queue.GetUnackedCount (), 0);
+	}
+
+	void Xep0198QueueTest::repeatedAck ()
+	{
+		Xep0198Queue queue;
+		SendMessages (queue, 0, 4);
+
+		QVERIFY (queue.Ack (2));
+		QVERIFY (queue.Ack (2));
+		QCOMPARE (queue.GetUnackedCount (), 2);
+
+		QVERIFY (queue.Ack (0));
+		QCOMPARE (queue.GetUnackedCount (), 2);
+	}
+
+	void Xep0198QueueTest::incomingCounted ()
+	{
+		Xep0198Queue queue;
+		for (int i = 0; i < 7; ++i)
+			queue.HandleIncoming ();
+		QCOMPARE (queue.GetInCount (), 7u);
+		QCOMPARE (queue.GetOutCount (), 0u);
+	}
+
+	void Xep0198QueueTest::unackedTaken ()
+	{
+		Xep0198Queue queue;
+		SendMessages (queue, 0, 2);
+		queue.HandleOutgoing ("<presence/>");
+		SendMessages (queue, 2, 1);
+		queue.HandleOutgoing ("<iq type=\"get\" id=\"q\"/>");
+
+		QVERIFY (queue.Ack (1));
+
+		const auto& unacked = queue.TakeUnacked ();
+		QCOMPARE (unacked, (QStringList { MakeMessage (1), "<presence/>", MakeMessage (2), "<iq type=\"get\" id=\"q\"/>" }));
+		QCOMPARE (queue.GetUnackedCount (), 0);
+
+		// The taken stanzas are counted anew once resent.
+		QCOMPARE (queue.GetOutCount (), 1u);
+		SendMessages (queue, 1, 2);
+		QVERIFY (queue.Ack (3));
+		QCOMPARE (queue.GetUnackedCount (), 0);
+	}
+
+	void Xep0198QueueTest::staleAckKeepsRewind ()
+	{
+		Xep0198Queue queue;
+		SendMessages (queue, 0, 4);
+
+		QVERIFY (queue.Ack (3));
+		QVERIFY (queue.Ack (1));
+
+		QCOMPARE (queue.TakeUnacked (), QStringList { MakeMessage (3) });
+		QCOMPARE (queue.GetOutCount (), 3u);
+	}
+
+	void Xep0198QueueTest::bogusAckClears ()
+	{
+		Xep0198Queue queue;
+		SendMessages (queue, 0, 3);
+
+		QVERIFY (!queue.Ack (10));
+		QCOMPARE (queue.GetUnackedCount (), 0);
+		QVERIFY (queue.TakeUnacked ().isEmpty ());
+	}
+
+	void Xep0198QueueTest::capDropsOldest ()
+	{
+		Xep0198Queue queue { 3 };
+		SendMessages (queue, 0, 5);
+		QCOMPARE (queue.GetUnackedCount (), 3);
+		QCOMPARE (queue.GetOutCount (), 5u);
+
+		QVERIFY (queue.Ack (3));
+		QCOMPARE (queue.TakeUnacked (), (QStringList { MakeMessage (3), MakeMessage (4) }));
+	}
+
+	void Xep0198QueueTest::resetClears ()
+	{
+		Xep0198Queue queue;
+		SendMessages (queue, 0, 3);
+		queue.HandleIncoming ();
+
+		queue.Reset ();
+		QCOMPARE (queue.GetOutCount (), 0u);
+		QCOMPARE (queue.GetInCount (), 0u);
+		QCOMPARE (queue.GetUnackedCount (), 0);
+
+		SendMessages (queue, 0, 1);
+		QVERIFY (queue.Ack (1));
+		QCOMPARE (queue.GetUnackedCount (), 0);
+	}
+}
+}
+}
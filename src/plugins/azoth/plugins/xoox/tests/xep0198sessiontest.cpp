@@ -0,0 +1,294 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "xep0198sessiontest.h"
+#include <QtTest>
+#include <QDomDocument>
+#include <QDomElement>
+#include "xep0198session.h"
+
+QTEST_MAIN (LeechCraft::Azoth::Xoox::Xep0198SessionTest)
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	namespace
+	{
+		const QString NsSM { "urn:xmpp:sm:3" };
+
+		QDomElement Parse (const QByteArray& data)
+		{
+			QDomDocument doc;
+			if (!doc.setContent (data, true))
+				qWarning () << Q_FUNC_INFO
+						<< "unable to parse"
+						<< data;
+			return doc.documentElement ();
+		}
+
+		QByteArray MakeMessage (int num)
+		{
+			return QString { "<message id=\"m%1\" to=\"a@b.c\"><body>%1</body></message>" }
+					.arg (num)
+					.toUtf8 ();
+		}
+
+		/* Stands for the stream: everything written to it is recorded
+		 * and reported back to the session, just like the
+		 * Xep0198Manager does with the QXmpp stream.
+		 */
+		class Stream
+		{
+		public:
+			QList<QByteArray> Written_;
+			Xep0198Session Session_;
+
+			Stream ()
+			: Session_ { [this] (const QByteArray& data) { Write (data); } }
+			{
+			}
+
+			void Write (const QByteArray& data)
+			{
+				Written_ << data;
+				Session_.HandleOutgoing (data);
+			}
+
+			void SendMessages (int from, int count)
+			{
+				for (int i = from; i < from + count; ++i)
+					Write (MakeMessage (i));
+			}
+
+			void ReceiveStanzas (int count)
+			{
+				for (int i = 0; i < count; ++i)
+					Session_.HandleIncomingStanza ();
+			}
+
+			Xep0198Session::Event Receive (const QString& nonza)
+			{
+				return Session_.HandleNonza (Parse (nonza.arg (NsSM).toUtf8 ()));
+			}
+
+			QDomElement GetLastWritten () const
+			{
+				return Written_.isEmpty () ? QDomElement {} : Parse (Written_.last ());
+			}
+		};
+
+		void Enable (Stream& stream, bool resumable)
+		{
+			stream.Session_.Enable ();
+
+			const auto event = stream.Receive (resumable ?
+					"<enabled xmlns='%1' id='session1' resume='true'/>" :
+					"<enabled xmlns='%1'/>");
+			QCOMPARE (event, Xep0198Session::Event::Enabled);
+			QCOMPARE (stream.Session_.GetState (), Xep0198Session::State::Enabled);
+		}
+
+		/* Enables a resumable session, sends five messages with two of
+		 * them acked, receives three stanzas and drops the connection.
+		 */
+		void Interrupt (Stream& stream)
+		{
+			Enable (stream, true);
+
+			stream.SendMessages (0, 5);
+			stream.ReceiveStanzas (3);
+			stream.Receive ("<a xmlns='%1' h='2'/>");
+
+			stream.Session_.HandleDisconnected ();
+			stream.Written_.clear ();
+		}
+	}
+
+	void Xep0198SessionTest::enableRequestsResumption ()
+	{
+		Stream stream;
+		stream.Session_.Enable ();
+
+		const auto& enable = stream.GetLastWritten ();
+		QCOMPARE (enable.tagName (), QString { "enable" });
+		QCOMPARE (enable.namespaceURI (), NsSM);
+		QCOMPARE (enable.attribute ("resume"), QString { "true" });
+		QCOMPARE (stream.Session_.GetState (), Xep0198Session::State::Requested);
+
+		QCOMPARE (stream.Receive ("<enabled xmlns='%1' id='session1' resume='true'/>"),
+				Xep0198Session::Event::Enabled);
+		QVERIFY (stream.Session_.IsResumable ());
+	}
+
+	void Xep0198SessionTest::nonStanzasNotCounted ()
+	{
+		Stream stream;
+
+		// Nothing is counted before stream management is requested.
+		stream.SendMessages (0, 1);
+		QCOMPARE (stream.Session_.GetOutCount (), 0u);
+
+		Enable (stream, true);
+
+		stream.Write ("<?xml version='1.0'?><stream:stream xmlns='jabber:client' "
+				"xmlns:stream='http://etherx.jabber.org/streams' to='b.c' version='1.0'>");
+		stream.Write ("<r xmlns='urn:xmpp:sm:3'/>");
+		stream.Write ("</stream:stream>");
+		QCOMPARE (stream.Session_.GetOutCount (), 0u);
+
+		stream.SendMessages (0, 1);
+		stream.Write ("<presence/>");
+		stream.Write ("<iq type='get' id='q1'><ping xmlns='urn:xmpp:ping'/></iq>");
+		QCOMPARE (stream.Session_.GetOutCount (), 3u);
+	}
+
+	void Xep0198SessionTest::ackRequestAnswered ()
+	{
+		Stream stream;
+		Enable (stream, false);
+
+		stream.ReceiveStanzas (3);
+		stream.Receive ("<r xmlns='%1'/>");
+
+		const auto& ack = stream.GetLastWritten ();
+		QCOMPARE (ack.tagName (), QString { "a" });
+		QCOMPARE (ack.attribute ("h"), QString { "3" });
+	}
+
+	void Xep0198SessionTest::resumeResendsUnacked ()
+	{
+		Stream stream;
+		Interrupt (stream);
+
+		QCOMPARE (stream.Session_.GetState (), Xep0198Session::State::Disabled);
+		QVERIFY (stream.Session_.IsResumable ());
+		QCOMPARE (stream.Session_.GetUnackedCount (), 3);
+
+		stream.Session_.Resume ();
+		QCOMPARE (stream.Written_.size (), 1);
+
+		const auto& resume = stream.GetLastWritten ();
+		QCOMPARE (resume.tagName (), QString { "resume" });
+		QCOMPARE (resume.namespaceURI (), NsSM);
+		QCOMPARE (resume.attribute ("previd"), QString { "session1" });
+		QCOMPARE (resume.attribute ("h"), QString { "3" });
+
+		// The server got one more message than it has acked.
+		QCOMPARE (stream.Receive ("<resumed xmlns='%1' previd='session1' h='3'/>"),
+				Xep0198Session::Event::Resumed);
+		QCOMPARE (stream.Session_.GetState (), Xep0198Session::State::Enabled);
+
+		stream.Written_.removeFirst ();
+		QCOMPARE (stream.Written_, (QList<QByteArray> { MakeMessage (3), MakeMessage (4) }));
+	}
+
+	void Xep0198SessionTest::resumedCountsResentAnew ()
+	{
+		Stream stream;
+		Interrupt (stream);
+
+		stream.Session_.Resume ();
+		stream.Receive ("<resumed xmlns='%1' previd='session1' h='3'/>");
+
+		QCOMPARE (stream.Session_.GetOutCount (), 5u);
+		QCOMPARE (stream.Session_.GetUnackedCount (), 2);
+
+		stream.SendMessages (5, 1);
+		stream.Receive ("<a xmlns='%1' h='6'/>");
+		QCOMPARE (stream.Session_.GetUnackedCount (), 0);
+
+		// The incoming counter goes on from where it was, too.
+		stream.ReceiveStanzas (1);
+		stream.Receive ("<r xmlns='%1'/>");
+		QCOMPARE (stream.GetLastWritten ().attribute ("h"), QString { "4" });
+	}
+
+	void Xep0198SessionTest::noResendBeforeResumed ()
+	{
+		Stream stream;
+		Interrupt (stream);
+
+		stream.Session_.Resume ();
+		QCOMPARE (stream.Session_.GetState (), Xep0198Session::State::Resuming);
+
+		// Acks aren't answered and requested until the session is back.
+		stream.Receive ("<r xmlns='%1'/>");
+		stream.Session_.RequestAck ();
+		QCOMPARE (stream.Written_.size (), 1);
+		QCOMPARE (stream.GetLastWritten ().tagName (), QString { "resume" });
+	}
+
+	void Xep0198SessionTest::resumeFailureDropsUnacked ()
+	{
+		Stream stream;
+		Interrupt (stream);
+
+		stream.Session_.Resume ();
+		QCOMPARE (stream.Receive ("<failed xmlns='%1'><item-not-found "
+					"xmlns='urn:ietf:params:xml:ns:xmpp-stanzas'/></failed>"),
+				Xep0198Session::Event::ResumeFailed);
+
+		QCOMPARE (stream.Written_.size (), 1);
+		QCOMPARE (stream.Session_.GetState (), Xep0198Session::State::Disabled);
+		QVERIFY (!stream.Session_.IsResumable ());
+		QCOMPARE (stream.Session_.GetUnackedCount (), 0);
+	}
+
+	void Xep0198SessionTest::unresumableDropsUnacked ()
+	{
+		Stream stream;
+		Enable (stream, false);
+		stream.SendMessages (0, 2);
+
+		stream.Session_.HandleDisconnected ();
+
+		QVERIFY (!stream.Session_.IsResumable ());
+		QCOMPARE (stream.Session_.GetUnackedCount (), 0);
+	}
+
+	void Xep0198SessionTest::enableDropsPreviousSession ()
+	{
+		Stream stream;
+		Interrupt (stream);
+
+		// The server hasn't offered stream management this time, or the
+		// resumption was refused and a new stream has been bound.
+		stream.Session_.Enable ();
+
+		QVERIFY (!stream.Session_.IsResumable ());
+		QCOMPARE (stream.Session_.GetUnackedCount (), 0);
+		QCOMPARE (stream.Session_.GetOutCount (), 0u);
+		QCOMPARE (stream.Written_.size (), 1);
+	}
+}
+}
+}
@@ -0,0 +1,285 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "xep0198manager.h"
+#include <QDomElement>
+#include <QTimer>
+#include <QtDebug>
+#include <QXmppClient.h>
+#include <QXmppStream.h>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	namespace
+	{
+		const QString NsSM { "urn:xmpp:sm:3" };
+		const QString NsStream { "http://etherx.jabber.org/streams" };
+		const QString NsBind { "urn:ietf:params:xml:ns:xmpp-bind" };
+
+		// Request an ack right away after this many unacked stanzas...
+		const int AckThreshold = 10;
+		// ...or after this timeout otherwise.
+		const int AckTimeout = 3000;
+	}
+
+	Xep0198Manager::Xep0198Manager ()
+	: Session_ { [this] (const QByteArray& data) { WriteData (data); } }
+	, AckTimer_ { new QTimer { this } }
+	{
+		AckTimer_->setSingleShot (true);
+		connect (AckTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (requestAck ()));
+	}
+
+	bool Xep0198Manager::handleStanza (const QDomElement& stanza)
+	{
+		const auto& ns = stanza.namespaceURI ();
+		if (ns == NsSM)
+		{
+			if (stanza.tagName () == "a")
+				AckRequested_ = false;
+
+			HandleEvent (Session_.HandleNonza (stanza));
+
+			if (Session_.GetUnackedCount () >= AckThreshold)
+				AckTimer_->start (0);
+			return true;
+		}
+
+		if (ns == NsStream && stanza.tagName () == "features")
+			return HandleFeatures (stanza);
+
+		const auto& tag = stanza.tagName ();
+		if (tag == "message" || tag == "iq" || tag == "presence")
+			Session_.HandleIncomingStanza ();
+
+		return false;
+	}
+
+	bool Xep0198Manager::IsEnabled () const
+	{
+		return Session_.GetState () == Xep0198Session::State::Enabled;
+	}
+
+	bool Xep0198Manager::IsResuming () const
+	{
+		return Session_.GetState () == Xep0198Session::State::Resuming;
+	}
+
+	bool Xep0198Manager::IsStreamResumed () const
+	{
+		return IsResumed_;
+	}
+
+	void Xep0198Manager::QueueForResend (const QXmppMessage& msg)
+	{
+		Resend_ << msg;
+	}
+
+	void Xep0198Manager::setClient (QXmppClient *client)
+	{
+		QXmppClientExtension::setClient (client);
+
+		connect (client,
+				SIGNAL (connected ()),
+				this,
+				SLOT (handleConnected ()));
+		connect (client,
+				SIGNAL (disconnected ()),
+				this,
+				SLOT (handleDisconnected ()));
+
+		// QXmpp has no hooks for outgoing stanzas, but the stream itself
+		// reports each chunk of data right as it's written in sendData(),
+		// regardless of the logger settings, and each chunk is a single
+		// stanza or nonza.
+		Stream_ = client->findChild<QXmppStream*> ();
+		if (!Stream_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "no stream found, stream management is disabled";
+			return;
+		}
+
+		connect (Stream_,
+				SIGNAL (logMessage (QXmppLogger::MessageType, QString)),
+				this,
+				SLOT (handleStreamData (QXmppLogger::MessageType, QString)));
+	}
+
+	void Xep0198Manager::HandleEvent (Xep0198Session::Event event)
+	{
+		switch (event)
+		{
+		case Xep0198Session::Event::None:
+			break;
+		case Xep0198Session::Event::Enabled:
+			emit stateChanged (true);
+			flushResend ();
+			break;
+		case Xep0198Session::Event::EnableFailed:
+			flushResend ();
+			break;
+		case Xep0198Session::Event::Resumed:
+			IsResumed_ = true;
+			emit stateChanged (true);
+			emit streamResumed ();
+			flushResend ();
+			break;
+		case Xep0198Session::Event::ResumeFailed:
+			StartReconnect ();
+			break;
+		}
+	}
+
+	bool Xep0198Manager::HandleFeatures (const QDomElement& features)
+	{
+		ServerSupportsSM_ = !features.elementsByTagNameNS (NsSM, "sm").isEmpty ();
+
+		// Resumption replaces resource binding, which is only offered
+		// after authentication.
+		if (features.elementsByTagNameNS (NsBind, "bind").isEmpty () ||
+				!Session_.IsResumable ())
+			return false;
+
+		if (!ServerSupportsSM_ || !Stream_)
+		{
+			Session_.Forget ();
+			return false;
+		}
+
+		// Hiding the features from QXmpp keeps it from binding a resource.
+		Session_.Resume ();
+		return true;
+	}
+
+	void Xep0198Manager::WriteData (const QByteArray& data)
+	{
+		Stream_->sendData (data);
+	}
+
+	void Xep0198Manager::StartReconnect ()
+	{
+		// QXmpp hasn't seen the stream features, so it won't bind a
+		// resource on this stream anymore, and a new one is needed.
+		ReconnectPending_ = true;
+		ReconnectPresence_ = client ()->clientPresence ();
+		Stream_->disconnectFromHost ();
+	}
+
+	void Xep0198Manager::flushResend ()
+	{
+		const auto resend = Resend_;
+		Resend_.clear ();
+
+		for (const auto& msg : resend)
+			client ()->sendPacket (msg);
+	}
+
+	void Xep0198Manager::handleConnected ()
+	{
+		AckRequested_ = false;
+
+		// Let the rooms be rejoined first, so that the resent groupchat
+		// messages aren't rejected.
+		if (!ServerSupportsSM_ || !Stream_)
+		{
+			Session_.Forget ();
+			QTimer::singleShot (0,
+					this,
+					SLOT (flushResend ()));
+			return;
+		}
+
+		Session_.Enable ();
+	}
+
+	void Xep0198Manager::handleDisconnected ()
+	{
+		AckTimer_->stop ();
+		AckRequested_ = false;
+		ServerSupportsSM_ = false;
+		IsResumed_ = false;
+
+		const auto wasEnabled = IsEnabled ();
+		Session_.HandleDisconnected ();
+		if (wasEnabled)
+			emit stateChanged (false);
+
+		if (ReconnectPending_)
+		{
+			ReconnectPending_ = false;
+			QTimer::singleShot (0,
+					this,
+					SLOT (reconnect ()));
+		}
+	}
+
+	void Xep0198Manager::handleStreamData (QXmppLogger::MessageType type, const QString& data)
+	{
+		if (type != QXmppLogger::SentMessage)
+			return;
+
+		Session_.HandleOutgoing (data.toUtf8 ());
+
+		if (!IsEnabled () || !Session_.GetUnackedCount ())
+			return;
+
+		// This is called before the data hits the socket, so the request
+		// is always deferred to the event loop to not go before the stanza.
+		if (Session_.GetUnackedCount () >= AckThreshold)
+			AckTimer_->start (0);
+		else if (!AckTimer_->isActive ())
+			AckTimer_->start (AckTimeout);
+	}
+
+	void Xep0198Manager::requestAck ()
+	{
+		if (!IsEnabled () ||
+				AckRequested_ ||
+				!Session_.GetUnackedCount ())
+			return;
+
+		AckRequested_ = true;
+		Session_.RequestAck ();
+	}
+
+	void Xep0198Manager::reconnect ()
+	{
+		client ()->connectToServer (client ()->configuration (), ReconnectPresence_);
+	}
+}
+}
+}
@@ -0,0 +1,117 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QXmppClientExtension.h>
+#include <QXmppLogger.h>
+#include <QXmppMessage.h>
+#include <QXmppPresence.h>
+#include "xep0198session.h"
+
+class QTimer;
+class QXmppStream;
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	/** Implements XEP-0198 stream management with session resumption.
+	 *
+	 * The stanzas we send are tracked until the server acks them. If
+	 * the connection drops meanwhile, the next connection resumes the
+	 * session in place of resource binding, and the stanzas the server
+	 * hasn't got are resent once it confirms the resumption. If it
+	 * refuses to, the connection is reestablished from scratch.
+	 *
+	 * QXmpp doesn't know about a resumed stream and still considers
+	 * itself connecting, so the streamResumed() signal should be
+	 * handled in place of QXmppClient::connected() in that case.
+	 *
+	 * The messages sent while there was no connection at all are sent
+	 * once it's established.
+	 */
+	class Xep0198Manager : public QXmppClientExtension
+	{
+		Q_OBJECT
+
+		QXmppStream *Stream_ = nullptr;
+		Xep0198Session Session_;
+
+		bool ServerSupportsSM_ = false;
+		bool IsResumed_ = false;
+
+		bool ReconnectPending_ = false;
+		QXmppPresence ReconnectPresence_;
+
+		QList<QXmppMessage> Resend_;
+
+		QTimer * const AckTimer_;
+		bool AckRequested_ = false;
+	public:
+		Xep0198Manager ();
+
+		bool handleStanza (const QDomElement&);
+
+		bool IsEnabled () const;
+
+		/** Returns whether the session is being resumed, so that no
+		 * stanzas should be sent yet.
+		 */
+		bool IsResuming () const;
+
+		/** Returns whether the current stream is a resumed one, which
+		 * QXmppClient doesn't consider to be connected.
+		 */
+		bool IsStreamResumed () const;
+
+		void QueueForResend (const QXmppMessage&);
+	protected:
+		void setClient (QXmppClient*);
+	private:
+		void HandleEvent (Xep0198Session::Event);
+		bool HandleFeatures (const QDomElement&);
+		void WriteData (const QByteArray&);
+		void StartReconnect ();
+	private slots:
+		void flushResend ();
+		void handleConnected ();
+		void handleDisconnected ();
+		void handleStreamData (QXmppLogger::MessageType, const QString&);
+		void requestAck ();
+		void reconnect ();
+	signals:
+		void stateChanged (bool);
+		void streamResumed ();
+	};
+}
+}
+}
@@ -0,0 +1,120 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "xep0198queue.h"
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	namespace
+	{
+		// Serial number arithmetic: is seq at or before h modulo 2^32?
+		bool IsCoveredBy (quint32 seq, quint32 h)
+		{
+			return static_cast<qint32> (h - seq) >= 0;
+		}
+	}
+
+	Xep0198Queue::Xep0198Queue (int maxSize)
+	: MaxSize_ { maxSize }
+	{
+	}
+
+	void Xep0198Queue::Reset ()
+	{
+		Unacked_.clear ();
+		OutCount_ = 0;
+		InCount_ = 0;
+		LastAcked_ = 0;
+	}
+
+	void Xep0198Queue::HandleOutgoing (const QString& data)
+	{
+		Unacked_.append (Item { ++OutCount_, data });
+		if (Unacked_.size () > MaxSize_)
+			Unacked_.removeFirst ();
+	}
+
+	void Xep0198Queue::HandleIncoming ()
+	{
+		++InCount_;
+	}
+
+	quint32 Xep0198Queue::GetOutCount () const
+	{
+		return OutCount_;
+	}
+
+	quint32 Xep0198Queue::GetInCount () const
+	{
+		return InCount_;
+	}
+
+	int Xep0198Queue::GetUnackedCount () const
+	{
+		return Unacked_.size ();
+	}
+
+	bool Xep0198Queue::Ack (quint32 h)
+	{
+		if (!IsCoveredBy (h, OutCount_))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "server acked"
+					<< h
+					<< "stanzas, but only"
+					<< OutCount_
+					<< "were sent";
+			Unacked_.clear ();
+			return false;
+		}
+
+		while (!Unacked_.isEmpty () && IsCoveredBy (Unacked_.first ().Seq_, h))
+			Unacked_.removeFirst ();
+		if (IsCoveredBy (LastAcked_, h))
+			LastAcked_ = h;
+		return true;
+	}
+
+	QStringList Xep0198Queue::TakeUnacked ()
+	{
+		QStringList result;
+		for (const auto& item : Unacked_)
+			result << item.Data_;
+		Unacked_.clear ();
+		OutCount_ = LastAcked_;
+		return result;
+	}
+}
+}
+}
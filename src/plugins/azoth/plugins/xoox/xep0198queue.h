@@ -0,0 +1,90 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QList>
+#include <QStringList>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	/** Keeps the XEP-0198 stanza counters and the stanzas sent but not
+	 * yet acknowledged by the server.
+	 *
+	 * Sequence numbers wrap around at 2^32 as required by the XEP, and
+	 * the queue is capped: the oldest stanzas are forgotten once the
+	 * server falls too far behind with its acks.
+	 */
+	class Xep0198Queue
+	{
+		struct Item
+		{
+			quint32 Seq_;
+			QString Data_;
+		};
+		QList<Item> Unacked_;
+		const int MaxSize_;
+
+		quint32 OutCount_ = 0;
+		quint32 InCount_ = 0;
+		quint32 LastAcked_ = 0;
+	public:
+		Xep0198Queue (int maxSize = 1000);
+
+		void Reset ();
+
+		void HandleOutgoing (const QString& data);
+		void HandleIncoming ();
+
+		quint32 GetOutCount () const;
+		quint32 GetInCount () const;
+		int GetUnackedCount () const;
+
+		/** Drops the stanzas acknowledged by the given server's h value.
+		 *
+		 * Returns false if the server acknowledges more stanzas than we
+		 * have sent. The queue is cleared in this case, since its state
+		 * can't be trusted anymore.
+		 */
+		bool Ack (quint32 h);
+
+		/** Takes all the stanzas not acknowledged yet.
+		 *
+		 * The outgoing counter is rewound to the last acknowledged
+		 * stanza, so that the taken ones are counted anew when resent.
+		 */
+		QStringList TakeUnacked ();
+	};
+}
+}
+}
@@ -0,0 +1,255 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "xep0198session.h"
+#include <QDomElement>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	namespace
+	{
+		const QString NsSM { "urn:xmpp:sm:3" };
+
+		bool IsStanza (const QString& name)
+		{
+			return name == "message" || name == "iq" || name == "presence";
+		}
+
+		/* Returns the name of the top-level element the data starts,
+		 * if any. The data written to the stream is either a single
+		 * stanza or a nonza, or the stream header or trailer.
+		 */
+		QString GetStartElementName (const QByteArray& data)
+		{
+			QXmlStreamReader reader { data };
+			reader.setNamespaceProcessing (false);
+			while (!reader.atEnd ())
+				switch (reader.readNext ())
+				{
+				case QXmlStreamReader::StartElement:
+					return reader.qualifiedName ().toString ();
+				case QXmlStreamReader::EndElement:
+				case QXmlStreamReader::Invalid:
+					return {};
+				default:
+					break;
+				}
+			return {};
+		}
+
+		bool IsTrue (const QString& attr)
+		{
+			return attr == "true" || attr == "1";
+		}
+	}
+
+	Xep0198Session::Xep0198Session (const Writer_f& writer)
+	: Writer_ { writer }
+	{
+	}
+
+	Xep0198Session::State Xep0198Session::GetState () const
+	{
+		return State_;
+	}
+
+	bool Xep0198Session::IsResumable () const
+	{
+		return !ResumeId_.isEmpty ();
+	}
+
+	quint32 Xep0198Session::GetInCount () const
+	{
+		return Queue_.GetInCount ();
+	}
+
+	quint32 Xep0198Session::GetOutCount () const
+	{
+		return Queue_.GetOutCount ();
+	}
+
+	int Xep0198Session::GetUnackedCount () const
+	{
+		return Queue_.GetUnackedCount ();
+	}
+
+	void Xep0198Session::Enable ()
+	{
+		Forget ();
+
+		// The outgoing counter starts right after <enable/> is sent.
+		State_ = State::Requested;
+		WriteNonza ("enable", { { "resume", "true" } });
+	}
+
+	void Xep0198Session::Resume ()
+	{
+		if (!IsResumable ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "no session to resume";
+			return;
+		}
+
+		State_ = State::Resuming;
+		WriteNonza ("resume",
+				{
+					{ "previd", ResumeId_ },
+					{ "h", QString::number (Queue_.GetInCount ()) }
+				});
+	}
+
+	void Xep0198Session::Forget ()
+	{
+		ResumeId_.clear ();
+		Queue_.Reset ();
+	}
+
+	void Xep0198Session::HandleDisconnected ()
+	{
+		State_ = State::Disabled;
+
+		if (!IsResumable ())
+			Queue_.Reset ();
+	}
+
+	void Xep0198Session::HandleOutgoing (const QByteArray& data)
+	{
+		if (State_ != State::Requested && State_ != State::Enabled)
+			return;
+
+		const auto& name = GetStartElementName (data);
+		if (IsStanza (name))
+			Queue_.HandleOutgoing (QString::fromUtf8 (data));
+	}
+
+	void Xep0198Session::HandleIncomingStanza ()
+	{
+		if (State_ == State::Enabled)
+			Queue_.HandleIncoming ();
+	}
+
+	Xep0198Session::Event Xep0198Session::HandleNonza (const QDomElement& elem)
+	{
+		const auto& tag = elem.tagName ();
+		if (tag == "r")
+		{
+			if (State_ == State::Enabled)
+				WriteNonza ("a", { { "h", QString::number (Queue_.GetInCount ()) } });
+		}
+		else if (tag == "a")
+		{
+			bool ok = false;
+			const auto h = elem.attribute ("h").toUInt (&ok);
+			if (!ok)
+				qWarning () << Q_FUNC_INFO
+						<< "invalid h value"
+						<< elem.attribute ("h");
+			else
+				Queue_.Ack (h);
+		}
+		else if (tag == "enabled")
+		{
+			if (State_ != State::Requested)
+				return Event::None;
+
+			State_ = State::Enabled;
+			if (IsTrue (elem.attribute ("resume")))
+				ResumeId_ = elem.attribute ("id");
+			return Event::Enabled;
+		}
+		else if (tag == "resumed")
+		{
+			if (State_ != State::Resuming)
+				return Event::None;
+
+			bool ok = false;
+			const auto h = elem.attribute ("h").toUInt (&ok);
+			if (!ok || !Queue_.Ack (h))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "invalid h value in <resumed/>"
+						<< elem.attribute ("h");
+				Queue_.Reset ();
+			}
+
+			State_ = State::Enabled;
+
+			// Resent stanzas are counted anew as they go out.
+			for (const auto& data : Queue_.TakeUnacked ())
+				Writer_ (data.toUtf8 ());
+
+			return Event::Resumed;
+		}
+		else if (tag == "failed")
+		{
+			const auto wasResuming = State_ == State::Resuming;
+
+			qWarning () << Q_FUNC_INFO
+					<< (wasResuming ?
+							"unable to resume the session" :
+							"unable to enable stream management");
+
+			State_ = State::Disabled;
+			Forget ();
+
+			return wasResuming ? Event::ResumeFailed : Event::EnableFailed;
+		}
+
+		return Event::None;
+	}
+
+	void Xep0198Session::RequestAck ()
+	{
+		if (State_ == State::Enabled)
+			WriteNonza ("r");
+	}
+
+	void Xep0198Session::WriteNonza (const QString& name, const QList<QPair<QString, QString>>& attrs)
+	{
+		QByteArray data;
+		QXmlStreamWriter w { &data };
+		w.writeStartElement (name);
+		w.writeAttribute ("xmlns", NsSM);
+		for (const auto& attr : attrs)
+			w.writeAttribute (attr.first, attr.second);
+		w.writeEndElement ();
+
+		Writer_ (data);
+	}
+}
+}
+}
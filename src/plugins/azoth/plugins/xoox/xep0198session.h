@@ -0,0 +1,133 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QByteArray>
+#include <QString>
+#include "xep0198queue.h"
+
+class QDomElement;
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	/** The client side of an XEP-0198 session, independent of QXmpp.
+	 *
+	 * The session is fed the data written to the stream and the nonzas
+	 * received from the server, and writes its own nonzas as well as the
+	 * stanzas to be resent via the writer function.
+	 *
+	 * A session enabled with resumption support outlives the connection:
+	 * the stanzas not acknowledged by the server are kept until the next
+	 * connection either resumes the session, in which case they are
+	 * resent, or fails to, in which case they are dropped.
+	 */
+	class Xep0198Session
+	{
+	public:
+		typedef std::function<void (QByteArray)> Writer_f;
+
+		enum class State
+		{
+			Disabled,
+			Requested,
+			Enabled,
+			Resuming
+		};
+
+		enum class Event
+		{
+			None,
+			Enabled,
+			EnableFailed,
+			Resumed,
+			ResumeFailed
+		};
+	private:
+		const Writer_f Writer_;
+
+		State State_ = State::Disabled;
+		Xep0198Queue Queue_;
+
+		QString ResumeId_;
+	public:
+		Xep0198Session (const Writer_f&);
+
+		State GetState () const;
+
+		/** Returns whether the session can be resumed by the next
+		 * connection.
+		 */
+		bool IsResumable () const;
+
+		quint32 GetInCount () const;
+		quint32 GetOutCount () const;
+		int GetUnackedCount () const;
+
+		/** Requests enabling stream management on a freshly bound
+		 * stream, dropping the previous session.
+		 */
+		void Enable ();
+
+		/** Requests resuming the previous session on a freshly
+		 * authenticated stream instead of binding a resource.
+		 */
+		void Resume ();
+
+		/** Drops the previous session, if any, so that the stanzas it
+		 * hasn't got acked are never resent.
+		 */
+		void Forget ();
+
+		void HandleDisconnected ();
+
+		/** Counts the stanza if the data written to the stream is one
+		 * and stream management is active.
+		 */
+		void HandleOutgoing (const QByteArray&);
+		void HandleIncomingStanza ();
+
+		/** Handles a nonza in the XEP-0198 namespace.
+		 */
+		Event HandleNonza (const QDomElement&);
+
+		/** Requests an ack from the server.
+		 */
+		void RequestAck ();
+	private:
+		void WriteNonza (const QString&, const QList<QPair<QString, QString>>& = {});
+	};
+}
+}
+}
@@ -0,0 +1,182 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "presencebatcher.h"
+#include <algorithm>
+#include <QTimer>
+#include <QStandardItem>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	PresenceBatcher::PresenceBatcher (const ItemsGetter_f& itemsGetter,
+			const OnlineGetter_f& onlineGetter,
+			const IconApplier_f& iconApplier,
+			int onlineRole,
+			QObject *parent)
+	: QObject { parent }
+	, ItemsGetter_ { itemsGetter }
+	, OnlineGetter_ { onlineGetter }
+	, IconApplier_ { iconApplier }
+	, OnlineRole_ { onlineRole }
+	, Timer_ { new QTimer { this } }
+	{
+		// Roughly a frame, so that a batch doesn't cause visible stalls.
+		Timer_->setInterval (16);
+		Timer_->setSingleShot (true);
+		connect (Timer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (processBatch ()));
+	}
+
+	void PresenceBatcher::Enqueue (QObject *entry)
+	{
+		if (Queued_.contains (entry))
+			return;
+
+		Queued_ [entry] = entry;
+		Queue_ << entry;
+
+		if (!Timer_->isActive ())
+			Timer_->start ();
+	}
+
+	void PresenceBatcher::RemoveItem (QStandardItem *item)
+	{
+		const auto pos = Items_.find (item);
+		if (pos == Items_.end ())
+			return;
+
+		if (pos->IsOnline_)
+		{
+			--CategoryOnline_ [pos->Category_];
+			DirtyCategories_ << pos->Category_;
+
+			if (!Timer_->isActive ())
+				Timer_->start ();
+		}
+
+		Items_.erase (pos);
+	}
+
+	void PresenceBatcher::RemoveCategory (QStandardItem *category)
+	{
+		for (auto i = Items_.begin (); i != Items_.end (); )
+			if (i->Category_ == category)
+				i = Items_.erase (i);
+			else
+				++i;
+
+		CategoryOnline_.remove (category);
+		DirtyCategories_.remove (category);
+	}
+
+	void PresenceBatcher::Flush ()
+	{
+		Timer_->stop ();
+
+		while (!Queue_.isEmpty ())
+			Process (Queued_.take (Queue_.takeFirst ()));
+
+		CommitCategories ();
+	}
+
+	int PresenceBatcher::GetQueueSize () const
+	{
+		return Queue_.size ();
+	}
+
+	int PresenceBatcher::GetOnlineCount (QStandardItem *category) const
+	{
+		return CategoryOnline_.value (category);
+	}
+
+	void PresenceBatcher::SetBatchSize (int size)
+	{
+		BatchSize_ = std::max (size, 1);
+	}
+
+	void PresenceBatcher::Process (QObject *entry)
+	{
+		if (!entry)
+			return;
+
+		const auto& items = ItemsGetter_ (entry);
+		if (items.isEmpty ())
+			return;
+
+		const auto isOnline = OnlineGetter_ (entry);
+		for (const auto item : items)
+		{
+			const auto category = item->parent ();
+			if (!category)
+				continue;
+
+			auto pos = Items_.find (item);
+			if (pos == Items_.end ())
+				pos = Items_.insert (item, { category, false });
+
+			if (pos->IsOnline_ == isOnline)
+				continue;
+
+			pos->IsOnline_ = isOnline;
+			CategoryOnline_ [category] += isOnline ? 1 : -1;
+			DirtyCategories_ << category;
+		}
+
+		IconApplier_ (entry, items);
+	}
+
+	void PresenceBatcher::CommitCategories ()
+	{
+		for (const auto category : DirtyCategories_)
+		{
+			const auto count = CategoryOnline_.value (category);
+			if (category->data (OnlineRole_).toInt () != count)
+				category->setData (count, OnlineRole_);
+		}
+		DirtyCategories_.clear ();
+	}
+
+	void PresenceBatcher::processBatch ()
+	{
+		for (int i = 0; i < BatchSize_ && !Queue_.isEmpty (); ++i)
+		{
+			Process (Queued_.take (Queue_.takeFirst ()));
+		}
+
+		CommitCategories ();
+
+		if (!Queue_.isEmpty ())
+			Timer_->start ();
+	}
+}
+}
@@ -0,0 +1,133 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QPointer>
+
+class QTimer;
+class QStandardItem;
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	/** @brief Coalesces presence changes of contact list entries.
+	 *
+	 * Status changes are queued instead of being applied right away, and
+	 * the queue is processed in small batches from the event loop. An
+	 * entry changing its status several times before it is processed is
+	 * handled only once, with its latest status.
+	 *
+	 * The number of online entries in each category is maintained
+	 * incrementally, and each category item is updated at most once per
+	 * batch.
+	 */
+	class PresenceBatcher : public QObject
+	{
+		Q_OBJECT
+	public:
+		typedef std::function<QList<QStandardItem*> (QObject*)> ItemsGetter_f;
+		typedef std::function<bool (QObject*)> OnlineGetter_f;
+		typedef std::function<void (QObject*, const QList<QStandardItem*>&)> IconApplier_f;
+	private:
+		const ItemsGetter_f ItemsGetter_;
+		const OnlineGetter_f OnlineGetter_;
+		const IconApplier_f IconApplier_;
+		const int OnlineRole_;
+
+		QTimer * const Timer_;
+		int BatchSize_ = 200;
+
+		QList<QObject*> Queue_;
+		QHash<QObject*, QPointer<QObject>> Queued_;
+
+		struct ItemState
+		{
+			QStandardItem *Category_;
+			bool IsOnline_;
+		};
+		QHash<QStandardItem*, ItemState> Items_;
+		QHash<QStandardItem*, int> CategoryOnline_;
+		QSet<QStandardItem*> DirtyCategories_;
+	public:
+		/** @brief Constructs the batcher.
+		 *
+		 * @param[in] itemsGetter Returns the contact list items of an
+		 * entry.
+		 * @param[in] onlineGetter Returns whether the entry is online
+		 * now.
+		 * @param[in] iconApplier Updates the status icons of the entry's
+		 * items.
+		 * @param[in] onlineRole The data role of the category items the
+		 * number of online entries is stored in.
+		 * @param[in] parent The parent object.
+		 */
+		PresenceBatcher (const ItemsGetter_f& itemsGetter,
+				const OnlineGetter_f& onlineGetter,
+				const IconApplier_f& iconApplier,
+				int onlineRole,
+				QObject *parent = nullptr);
+
+		/** Schedules updating the given entry's items.
+		 */
+		void Enqueue (QObject *entry);
+
+		/** Forgets about the given item. Should be called before the item
+		 * is removed from its category.
+		 */
+		void RemoveItem (QStandardItem *item);
+
+		/** Forgets about the given category and all its items. Should be
+		 * called before the category is removed from the model.
+		 */
+		void RemoveCategory (QStandardItem *category);
+
+		/** Processes all the queued entries right away.
+		 */
+		void Flush ();
+
+		int GetQueueSize () const;
+
+		int GetOnlineCount (QStandardItem *category) const;
+
+		void SetBatchSize (int);
+	private:
+		void Process (QObject*);
+		void CommitCategories ();
+	private slots:
+		void processBatch ();
+	};
+}
+}
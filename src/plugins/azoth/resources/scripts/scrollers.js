@@ -4,13 +4,77 @@ function ScrollToBottom() {
 	if (window.ShouldScroll)
 		document.body.scrollTop = document.height - window.innerHeight;
 }
+function ScheduleScrollToBottom() {
+	if (window.ScrollScheduled)
+		return;
+
+	window.ScrollScheduled = true;
+	setTimeout(function () {
+			window.ScrollScheduled = false;
+			ScrollToBottom();
+		}, 0);
+}
 function TestScroll() {
 	window.ShouldScroll = document.height <= (window.innerHeight + window.pageYOffset + window.innerHeight / 5);
 }
 function InstallEventListeners() {
 	window.ShouldScroll = true;
-	document.body.addEventListener ("DOMNodeInserted", function () { setTimeout (ScrollToBottom, 0); }, false);
-	document.body.addEventListener ("DOMSubtreeModified", function () { setTimeout (ScrollToBottom, 0); }, false);
-	window.addEventListener ("resize", function () { setTimeout (ScrollToBottom, 0); });
+	document.body.addEventListener ("DOMNodeInserted", ScheduleScrollToBottom, false);
+	document.body.addEventListener ("DOMSubtreeModified", ScheduleScrollToBottom, false);
+	window.addEventListener ("resize", ScheduleScrollToBottom);
 	window.addEventListener ("scroll", TestScroll);
 }
+
+function ScrollbackContainer() {
+	return document.getElementById ("Chat") || document.body;
+}
+function MarkScrollbackStart() {
+	window.ScrollbackStart = ScrollbackContainer().lastChild;
+}
+function IsRemovableNode(node) {
+	if (node.nodeType != Node.ELEMENT_NODE)
+		return true;
+	var name = node.nodeName.toUpperCase();
+	return name != "SCRIPT" && name != "STYLE" && name != "LINK";
+}
+// Chat styles mark each message with the data-azoth-msg attribute, and
+// a single node may hold several messages, like consecutive messages in
+// Adium styles.
+function CountMessages(node) {
+	if (node.nodeType != Node.ELEMENT_NODE)
+		return 0;
+	var count = node.querySelectorAll("[data-azoth-msg]").length;
+	if (node.hasAttribute("data-azoth-msg"))
+		++count;
+	return count;
+}
+// Removes the nodes of the oldest messages so that at least limit of
+// them are left, unless the user is reading the backlog. Returns the
+// number of removed messages.
+function TrimScrollback(limit) {
+	if (!window.ShouldScroll)
+		return 0;
+
+	var container = ScrollbackContainer();
+	var first = window.ScrollbackStart ? window.ScrollbackStart.nextSibling : container.firstChild;
+
+	var count = 0;
+	for (var node = first; node; node = node.nextSibling)
+		count += CountMessages(node);
+
+	var removed = 0;
+	var node = first;
+	while (node && count > limit) {
+		var next = node.nextSibling;
+		var messages = CountMessages(node);
+		if (count - messages < limit)
+			break;
+		if (IsRemovableNode(node)) {
+			container.removeChild(node);
+			count -= messages;
+			removed += messages;
+		}
+		node = next;
+	}
+	return removed;
+}
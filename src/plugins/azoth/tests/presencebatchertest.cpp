@@ -0,0 +1,230 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "presencebatchertest.h"
+#include <random>
+#include <memory>
+#include <QtTest>
+#include <QStandardItemModel>
+#include "presencebatcher.h"
+
+QTEST_MAIN (LeechCraft::Azoth::PresenceBatcherTest)
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	namespace
+	{
+		const int OnlineRole = Qt::UserRole + 1;
+
+		class FakeEntry : public QObject
+		{
+		public:
+			bool IsOnline_ = false;
+			QList<QStandardItem*> Items_;
+		};
+
+		/* A contact list with the given number of entries evenly spread
+		 * over the given number of categories.
+		 */
+		struct Roster
+		{
+			QStandardItemModel Model_;
+			QList<QStandardItem*> Categories_;
+			QList<FakeEntry*> Entries_;
+			QHash<QObject*, int> IconUpdates_;
+
+			std::unique_ptr<PresenceBatcher> Batcher_;
+
+			Roster (int entries, int categories)
+			{
+				for (int i = 0; i < categories; ++i)
+				{
+					const auto cat = new QStandardItem { QString::number (i) };
+					Model_.appendRow (cat);
+					Categories_ << cat;
+				}
+
+				for (int i = 0; i < entries; ++i)
+				{
+					const auto entry = new FakeEntry;
+					entry->setParent (&Model_);
+
+					const auto item = new QStandardItem { QString::number (i) };
+					Categories_ [i % categories]->appendRow (item);
+					entry->Items_ << item;
+
+					Entries_ << entry;
+				}
+
+				Batcher_.reset (new PresenceBatcher
+					{
+						[] (QObject *entry) { return static_cast<FakeEntry*> (entry)->Items_; },
+						[] (QObject *entry) { return static_cast<FakeEntry*> (entry)->IsOnline_; },
+						[this] (QObject *entry, const QList<QStandardItem*>&) { ++IconUpdates_ [entry]; },
+						OnlineRole
+					});
+			}
+
+			void SetOnline (int entry, bool online)
+			{
+				Entries_ [entry]->IsOnline_ = online;
+				Batcher_->Enqueue (Entries_ [entry]);
+			}
+
+			/* Replays a flood of random presence changes.
+			 */
+			void Flood (int changes, unsigned seed)
+			{
+				std::mt19937 gen { seed };
+				std::uniform_int_distribution<int> entryDist { 0, Entries_.size () - 1 };
+				std::bernoulli_distribution onlineDist;
+
+				for (int i = 0; i < changes; ++i)
+					SetOnline (entryDist (gen), onlineDist (gen));
+			}
+
+			int Recount (QStandardItem *category) const
+			{
+				int result = 0;
+				for (const auto entry : Entries_)
+					for (const auto item : entry->Items_)
+						if (item->parent () == category && entry->IsOnline_)
+							++result;
+				return result;
+			}
+		};
+	}
+
+	void PresenceBatcherTest::countersMatchRecount ()
+	{
+		Roster roster { 3000, 10 };
+
+		for (unsigned round = 0; round < 5; ++round)
+		{
+			roster.Flood (10000, round);
+			roster.Batcher_->Flush ();
+
+			for (const auto cat : roster.Categories_)
+			{
+				QCOMPARE (roster.Batcher_->GetOnlineCount (cat), roster.Recount (cat));
+				QCOMPARE (cat->data (OnlineRole).toInt (), roster.Recount (cat));
+			}
+		}
+	}
+
+	void PresenceBatcherTest::changesCoalesced ()
+	{
+		Roster roster { 10, 2 };
+
+		for (int i = 0; i < 10; ++i)
+			roster.SetOnline (0, i % 2);
+		QCOMPARE (roster.Batcher_->GetQueueSize (), 1);
+
+		roster.Batcher_->Flush ();
+
+		QCOMPARE (roster.IconUpdates_.value (roster.Entries_ [0]), 1);
+		QCOMPARE (roster.Batcher_->GetOnlineCount (roster.Categories_ [0]), 1);
+	}
+
+	void PresenceBatcherTest::batchesProcessedFromEventLoop ()
+	{
+		Roster roster { 1000, 4 };
+		roster.Batcher_->SetBatchSize (100);
+
+		QSignalSpy spy { &roster.Model_, SIGNAL (dataChanged (QModelIndex, QModelIndex)) };
+
+		for (int i = 0; i < roster.Entries_.size (); ++i)
+			roster.SetOnline (i, true);
+
+		QCOMPARE (spy.count (), 0);
+		QTRY_COMPARE (roster.Batcher_->GetQueueSize (), 0);
+
+		// At most one update per category per batch.
+		int categoryUpdates = 0;
+		for (const auto& args : spy)
+			if (!args.value (0).value<QModelIndex> ().parent ().isValid ())
+				++categoryUpdates;
+		QVERIFY (categoryUpdates <= 10 * roster.Categories_.size ());
+
+		for (const auto cat : roster.Categories_)
+			QCOMPARE (cat->data (OnlineRole).toInt (), 250);
+	}
+
+	void PresenceBatcherTest::removedItemsUncounted ()
+	{
+		Roster roster { 10, 2 };
+		for (int i = 0; i < 10; ++i)
+			roster.SetOnline (i, true);
+		roster.Batcher_->Flush ();
+
+		const auto cat = roster.Categories_ [0];
+		QCOMPARE (cat->data (OnlineRole).toInt (), 5);
+
+		const auto entry = roster.Entries_ [0];
+		const auto item = entry->Items_.takeFirst ();
+		roster.Batcher_->RemoveItem (item);
+		cat->removeRow (item->row ());
+		roster.Batcher_->Flush ();
+
+		QCOMPARE (cat->data (OnlineRole).toInt (), 4);
+
+		roster.Batcher_->RemoveCategory (cat);
+		QCOMPARE (roster.Batcher_->GetOnlineCount (cat), 0);
+	}
+
+	void PresenceBatcherTest::deletedEntriesSkipped ()
+	{
+		Roster roster { 10, 2 };
+		roster.SetOnline (0, true);
+		roster.SetOnline (1, true);
+
+		const auto deleted = roster.Entries_.takeFirst ();
+		delete deleted;
+
+		roster.Batcher_->Flush ();
+
+		QCOMPARE (roster.IconUpdates_.size (), 1);
+		QCOMPARE (roster.Batcher_->GetOnlineCount (roster.Categories_ [1]), 1);
+	}
+
+	void PresenceBatcherTest::floodBenchmark ()
+	{
+		Roster roster { 3000, 20 };
+
+		unsigned seed = 0;
+		QBENCHMARK
+		{
+			roster.Flood (30000, ++seed);
+			roster.Batcher_->Flush ();
+		}
+	}
+}
+}
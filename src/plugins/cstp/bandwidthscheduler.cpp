@@ -0,0 +1,216 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "bandwidthscheduler.h"
+#include <algorithm>
+#include <QTimer>
+#include "xmlsettingsmanager.h"
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	namespace
+	{
+		const int TickInterval = 100;
+		const qint64 IdleTimeout = 2000;
+		const qint64 MinGrant = 4 * 1024;
+
+		qint64 GetLimit (const char *prop)
+		{
+			return XmlSettingsManager::Instance ().property (prop).toLongLong () * 1024;
+		}
+	}
+
+	BandwidthScheduler::BandwidthScheduler (QObject *parent)
+	: QObject { parent }
+	, Timer_ { new QTimer { this } }
+	{
+		Clock_.start ();
+
+		connect (Timer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (handleTick ()));
+
+		XmlSettingsManager::Instance ().RegisterObject (QList<QByteArray> { "GlobalSpeedLimit", "PerTaskSpeedLimit" },
+				this, "handleLimitsChanged");
+		handleLimitsChanged ();
+	}
+
+	qint64 BandwidthScheduler::Acquire (QObject *client, qint64 wanted)
+	{
+		if (wanted <= 0)
+			return 0;
+
+		const auto now = Clock_.elapsed ();
+		auto& info = GetClient (client);
+		info.LastActive_ = now;
+
+		auto granted = std::min (wanted, info.Bucket_.GetAvailable (now));
+		if (Global_.IsLimited ())
+		{
+			const auto fairShare = std::max (Global_.GetRate () / std::max (Clients_.size (), 1), MinGrant);
+			granted = std::min ({ granted, Global_.GetAvailable (now), fairShare });
+		}
+
+		if (granted > 0)
+		{
+			Global_.Take (granted, now);
+			info.Bucket_.Take (granted, now);
+			info.Meter_.Add (granted);
+			GlobalMeter_.Add (granted);
+		}
+
+		if (granted < wanted && !Waiting_.contains (client))
+			Waiting_ << client;
+
+		EnsureTimer ();
+		return granted;
+	}
+
+	void BandwidthScheduler::Consume (QObject *client, qint64 bytes)
+	{
+		if (bytes <= 0)
+			return;
+
+		const auto now = Clock_.elapsed ();
+		auto& info = GetClient (client);
+		info.LastActive_ = now;
+
+		Global_.Force (bytes, now);
+		info.Bucket_.Force (bytes, now);
+		info.Meter_.Add (bytes);
+		GlobalMeter_.Add (bytes);
+
+		EnsureTimer ();
+	}
+
+	void BandwidthScheduler::RemoveClient (QObject *client)
+	{
+		Clients_.remove (client);
+		Waiting_.removeAll (client);
+	}
+
+	double BandwidthScheduler::GetRate () const
+	{
+		return GlobalMeter_.GetRate ();
+	}
+
+	double BandwidthScheduler::GetRate (QObject *client) const
+	{
+		const auto pos = Clients_.find (client);
+		return pos == Clients_.end () ? 0 : pos->Meter_.GetRate ();
+	}
+
+	BandwidthScheduler::Stats BandwidthScheduler::GetStats () const
+	{
+		Stats stats
+		{
+			GlobalMeter_.GetRate (),
+			Global_.GetRate (),
+			GetLimit ("PerTaskSpeedLimit"),
+			{}
+		};
+		for (auto i = Clients_.begin (), end = Clients_.end (); i != end; ++i)
+			stats.Clients_.append ({ i.key (), i->Meter_.GetRate (), Waiting_.contains (i.key ()) });
+		return stats;
+	}
+
+	BandwidthScheduler::ClientInfo& BandwidthScheduler::GetClient (QObject *client)
+	{
+		auto pos = Clients_.find (client);
+		if (pos == Clients_.end ())
+		{
+			const auto now = Clock_.elapsed ();
+
+			ClientInfo info {};
+			info.Bucket_.SetRate (GetLimit ("PerTaskSpeedLimit"), now);
+			info.Meter_.Update (now);
+			pos = Clients_.insert (client, info);
+		}
+		return *pos;
+	}
+
+	void BandwidthScheduler::EnsureTimer ()
+	{
+		if (!Timer_->isActive ())
+		{
+			GlobalMeter_.Update (Clock_.elapsed ());
+			Timer_->start (TickInterval);
+		}
+	}
+
+	void BandwidthScheduler::handleTick ()
+	{
+		const auto now = Clock_.elapsed ();
+
+		GlobalMeter_.Update (now);
+		for (auto i = Clients_.begin (); i != Clients_.end (); )
+		{
+			i->Meter_.Update (now);
+
+			if (now - i->LastActive_ > IdleTimeout && !Waiting_.contains (i.key ()))
+				i = Clients_.erase (i);
+			else
+				++i;
+		}
+
+		emit ratesUpdated ();
+
+		if (Clients_.isEmpty ())
+		{
+			Timer_->stop ();
+			return;
+		}
+
+		// The notified clients will get back to the end of the queue if
+		// they still don't get enough budget, so everyone gets a chance.
+		const auto waiting = Waiting_;
+		Waiting_.clear ();
+		for (const auto client : waiting)
+			QMetaObject::invokeMethod (client,
+					"handleBudgetAvailable",
+					Qt::QueuedConnection);
+	}
+
+	void BandwidthScheduler::handleLimitsChanged ()
+	{
+		const auto now = Clock_.elapsed ();
+
+		Global_.SetRate (GetLimit ("GlobalSpeedLimit"), now);
+
+		const auto perTask = GetLimit ("PerTaskSpeedLimit");
+		for (auto& info : Clients_)
+			info.Bucket_.SetRate (perTask, now);
+
+		handleTick ();
+	}
+}
+}
@@ -0,0 +1,119 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QElapsedTimer>
+#include "tokenbucket.h"
+
+class QTimer;
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	/** Shares the download bandwidth between the tasks.
+	 *
+	 * Tasks ask for a budget before reading data from their replies. If
+	 * there is no budget left, the task leaves the data in the reply
+	 * (which eventually stalls the connection) and its
+	 * handleBudgetAvailable() slot is invoked once the budget is
+	 * refilled. Waiting tasks are served in round-robin order and each
+	 * one gets at most its fair share of the global budget at a time.
+	 */
+	class BandwidthScheduler : public QObject
+	{
+		Q_OBJECT
+
+		QElapsedTimer Clock_;
+		QTimer * const Timer_;
+
+		TokenBucket Global_;
+		RateMeter GlobalMeter_;
+
+		struct ClientInfo
+		{
+			TokenBucket Bucket_;
+			RateMeter Meter_;
+			qint64 LastActive_;
+		};
+		QHash<QObject*, ClientInfo> Clients_;
+		QList<QObject*> Waiting_;
+	public:
+		struct ClientStats
+		{
+			QObject *Client_;
+			double Rate_;
+			bool Waiting_;
+		};
+
+		struct Stats
+		{
+			double Rate_;
+			qint64 Limit_;
+			qint64 PerTaskLimit_;
+			QList<ClientStats> Clients_;
+		};
+
+		BandwidthScheduler (QObject* = nullptr);
+
+		/** Returns how many of the \em wanted bytes the \em client may
+		 * read now and charges them to its budget.
+		 *
+		 * If the returned value is less than \em wanted, the client will
+		 * be notified when more budget is available.
+		 */
+		qint64 Acquire (QObject *client, qint64 wanted);
+
+		/** Charges \em bytes to the budget of the \em client regardless
+		 * of the available budget, like when the reply has finished and
+		 * its data must be read anyway.
+		 */
+		void Consume (QObject *client, qint64 bytes);
+
+		void RemoveClient (QObject *client);
+
+		double GetRate () const;
+		double GetRate (QObject *client) const;
+
+		Stats GetStats () const;
+	private:
+		ClientInfo& GetClient (QObject*);
+		void EnsureTimer ();
+	private slots:
+		void handleTick ();
+		void handleLimitsChanged ();
+	signals:
+		void ratesUpdated ();
+	};
+}
+}
@@ -54,6 +54,7 @@
 #include "task.h"
 #include "xmlsettingsmanager.h"
 #include "addtask.h"
+#include "bandwidthscheduler.h"
 
 Q_DECLARE_METATYPE (QNetworkReply*)
 Q_DECLARE_METATYPE (QToolBar*)
@@ -77,12 +78,21 @@ namespace CSTP
 	: Headers_ { "URL", tr ("State"), tr ("Progress") }
 	, SaveScheduled_ (false)
 	, Toolbar_ (0)
+	, Scheduler_ (new BandwidthScheduler (this))
 	{
 		setObjectName ("CSTP Core");
 		qRegisterMetaType<std::shared_ptr<QFile>> ("std::shared_ptr<QFile>");
 		qRegisterMetaType<QNetworkReply*> ("QNetworkReply*");
 
 		ReadSettings ();
+
+		XmlSettingsManager::Instance ().RegisterObject ("MaxConcurrentTasks",
+				this, "startQueued");
+
+		connect (Scheduler_,
+				SIGNAL (ratesUpdated ()),
+				this,
+				SLOT (handleRatesUpdated ()));
 	}
 
 	Core& Core::Instance ()
@@ -105,6 +115,12 @@ namespace CSTP
 				SIGNAL (finished (QNetworkReply*)),
 				this,
 				SLOT (finishedReply (QNetworkReply*)));
+
+		// Resume the tasks that were queued when LeechCraft was closed
+		// once the rest of the plugin is initialized.
+		QMetaObject::invokeMethod (this,
+				"startQueued",
+				Qt::QueuedConnection);
 	}
 
 	ICoreProxy_ptr Core::GetCoreProxy () const
@@ -326,6 +342,10 @@ namespace CSTP
 				SIGNAL (updateInterface ()),
 				this,
 				SLOT (updateInterface ()));
+		connect (td.Task_.get (),
+				SIGNAL (segmentsChanged ()),
+				this,
+				SLOT (handleSegmentsChanged ()));
 
 		beginInsertRows (QModelIndex (), rowCount (), rowCount ());
 		ActiveTasks_.push_back (td);
@@ -353,9 +373,7 @@ namespace CSTP
 
 	qint64 Core::GetTotalDownloadSpeed () const
 	{
-		return std::accumulate (ActiveTasks_.begin (), ActiveTasks_.end (), 0,
-				[] (qint64 acc, const Core::TaskDescr& td)
-					{ return acc + td.Task_->GetSpeed (); });
+		return Scheduler_->GetRate ();
 	}
 
 	namespace
@@ -426,6 +444,37 @@ namespace CSTP
 		FinishedReplies_.remove (rep);
 	}
 
+	bool Core::AcquireHostConnection (const QString& host, bool force)
+	{
+		auto& count = HostConnections_ [host];
+		if (!force &&
+				count >= XmlSettingsManager::Instance ().property ("MaxConnectionsPerHost").toInt ())
+			return false;
+
+		++count;
+		return true;
+	}
+
+	void Core::ReleaseHostConnection (const QString& host)
+	{
+		const auto pos = HostConnections_.find (host);
+		if (pos == HostConnections_.end ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "no connections to"
+					<< host;
+			return;
+		}
+
+		if (!--*pos)
+			HostConnections_.erase (pos);
+	}
+
+	BandwidthScheduler* Core::GetScheduler () const
+	{
+		return Scheduler_;
+	}
+
 	int Core::columnCount (const QModelIndex&) const
 	{
 		return Headers_.size ();
@@ -452,16 +501,22 @@ namespace CSTP
 				if (td.ErrorFlag_)
 					return task->GetErrorString ();
 
+				if (td.Queued_)
+					return tr ("Queued");
+
 				if (!task->IsRunning ())
 					return QVariant ();
 
 				qint64 done = task->GetDone (),
 						total = task->GetTotal ();
-				double speed = task->GetSpeed ();
+				double speed = GetSpeed (td);
 
-				qint64 rem = (total - done) / speed;
+				qint64 rem = speed > 0 ? (total - done) / speed : 0;
 
-				return tr ("%1 (ETA: %2)")
+				const auto& pattern = td.Throttled_ ?
+						tr ("%1, throttled (ETA: %2)") :
+						tr ("%1 (ETA: %2)");
+				return pattern
 					.arg (task->GetState ())
 					.arg (Util::MakeTimeFromLong (rem));
 			}
@@ -477,7 +532,7 @@ namespace CSTP
 							.arg (progress)
 							.arg (Util::MakePrettySize (done))
 							.arg (Util::MakePrettySize (total))
-							.arg (Util::MakePrettySize (task->GetSpeed ()) + tr ("/s"));
+							.arg (Util::MakePrettySize (GetSpeed (td)) + tr ("/s"));
 					else
 						return QString ("%1")
 							.arg (Util::MakePrettySize (done));
@@ -579,10 +634,30 @@ namespace CSTP
 			i = Selected_.row ();
 		}
 
-		TaskDescr selected = TaskAt (i);
+		auto& selected = TaskAt (i);
 		if (selected.Task_->IsRunning ())
 			return;
-		if (!selected.File_->open (QIODevice::ReadWrite))
+
+		if (!CanStartMore ())
+		{
+			if (!selected.Queued_)
+			{
+				selected.Queued_ = true;
+				emit dataChanged (index (i, 0), index (i, columnCount () - 1));
+				ScheduleSave ();
+			}
+			return;
+		}
+
+		if (selected.Queued_)
+		{
+			selected.Queued_ = false;
+			ScheduleSave ();
+		}
+		// The file is still open if the task is finishing writing after
+		// being stopped.
+		if (!selected.File_->isOpen () &&
+				!selected.File_->open (QIODevice::ReadWrite))
 		{
 			QString msg = tr ("Could not open file %1: %2")
 				.arg (selected.File_->fileName ())
@@ -604,11 +679,20 @@ namespace CSTP
 			i = Selected_.row ();
 		}
 
-		TaskDescr selected = TaskAt (i);
+		auto& selected = TaskAt (i);
+		if (selected.Queued_)
+		{
+			selected.Queued_ = false;
+			emit dataChanged (index (i, 0), index (i, columnCount () - 1));
+			ScheduleSave ();
+			return;
+		}
+
 		if (!selected.Task_->IsRunning ())
 			return;
 		selected.Task_->Stop ();
-		selected.File_->close ();
+
+		startQueued ();
 	}
 
 	void Core::startAllTriggered ()
@@ -716,6 +800,10 @@ namespace CSTP
 			if (taskdscr->Parameters_ & LeechCraft::NotPersistent)
 				Remove (taskdscr);
 		}
+
+		QMetaObject::invokeMethod (this,
+				"startQueued",
+				Qt::QueuedConnection);
 	}
 
 	void Core::updateInterface ()
@@ -748,6 +836,7 @@ namespace CSTP
 			settings.setValue ("Comment", i->Comment_);
 			settings.setValue ("ErrorFlag", i->ErrorFlag_);
 			settings.setValue ("Tags", i->Tags_);
+			settings.setValue ("Queued", i->Queued_);
 		}
 		SaveScheduled_ = false;
 		settings.endArray ();
@@ -758,6 +847,37 @@ namespace CSTP
 		FinishedReplies_.insert (rep);
 	}
 
+	void Core::handleSegmentsChanged ()
+	{
+		ScheduleSave ();
+	}
+
+	void Core::startQueued ()
+	{
+		for (int i = 0, size = ActiveTasks_.size (); i < size && CanStartMore (); ++i)
+			if (TaskAt (i).Queued_)
+				startTriggered (i);
+	}
+
+	void Core::handleRatesUpdated ()
+	{
+		QHash<QObject*, BandwidthScheduler::ClientStats> clients;
+		for (const auto& client : Scheduler_->GetStats ().Clients_)
+			clients [client.Client_] = client;
+
+		for (int i = 0, size = ActiveTasks_.size (); i < size; ++i)
+		{
+			auto& td = TaskAt (i);
+			const auto& client = clients.value (td.Task_.get ());
+			if (td.Rate_ == client.Rate_ && td.Throttled_ == client.Waiting_)
+				continue;
+
+			td.Rate_ = client.Rate_;
+			td.Throttled_ = client.Waiting_;
+			emit dataChanged (index (i, HState), index (i, HProgress));
+		}
+	}
+
 	void Core::ReadSettings ()
 	{
 		QSettings settings (QCoreApplication::organizationName (),
@@ -789,12 +909,17 @@ namespace CSTP
 					SIGNAL (updateInterface ()),
 					this,
 					SLOT (updateInterface ()));
+			connect (td.Task_.get (),
+					SIGNAL (segmentsChanged ()),
+					this,
+					SLOT (handleSegmentsChanged ()));
 
 			td.File_ = std::make_shared<QFile> (settings.value ("Filename").toString ());
 
 			td.Comment_ = settings.value ("Comment").toString ();
 			td.ErrorFlag_ = settings.value ("ErrorFlag").toBool ();
 			td.Tags_ = settings.value ("Tags").toStringList ();
+			td.Queued_ = settings.value ("Queued").toBool ();
 
 			ActiveTasks_.push_back (td);
 		}
@@ -807,9 +932,29 @@ namespace CSTP
 		if (SaveScheduled_)
 			return;
 
+		SaveScheduled_ = true;
 		QTimer::singleShot (100, this, SLOT (writeSettings ()));
 	}
 
+	double Core::GetSpeed (const TaskDescr& td) const
+	{
+		return td.Task_->IsRunning () && td.Rate_ > 0 ?
+				td.Rate_ :
+				td.Task_->GetSpeed ();
+	}
+
+	int Core::GetRunningCount () const
+	{
+		return std::count_if (ActiveTasks_.begin (), ActiveTasks_.end (),
+				[] (const TaskDescr& td) { return td.Task_->IsRunning () && !td.ErrorFlag_; });
+	}
+
+	bool Core::CanStartMore () const
+	{
+		const auto max = XmlSettingsManager::Instance ().property ("MaxConcurrentTasks").toInt ();
+		return max <= 0 || GetRunningCount () < max;
+	}
+
 	Core::tasks_t::const_iterator Core::FindTask (QObject *task) const
 	{
 		return std::find_if (ActiveTasks_.begin (), ActiveTasks_.end (),
@@ -832,6 +977,10 @@ namespace CSTP
 		CoreProxy_->FreeID (id);
 
 		ScheduleSave ();
+
+		QMetaObject::invokeMethod (this,
+				"startQueued",
+				Qt::QueuedConnection);
 	}
 
 	Core::tasks_t::const_reference Core::TaskAt (int pos) const
@@ -36,6 +36,7 @@
 #include <QNetworkProxy>
 #include <QNetworkAccessManager>
 #include <QSet>
+#include <QHash>
 #include <QUrl>
 #include <interfaces/iinfo.h>
 #include <interfaces/structures.h>
@@ -59,6 +60,7 @@ namespace LeechCraft
 namespace CSTP
 {
 	class Task;
+	class BandwidthScheduler;
 
 	class Core : public QAbstractItemModel
 	{
@@ -75,6 +77,11 @@ namespace CSTP
 			LeechCraft::TaskParameters Parameters_;
 			quint32 ID_;
 			QStringList Tags_;
+			bool Queued_ = false;
+
+			// As reported by the bandwidth scheduler.
+			double Rate_ = 0;
+			bool Throttled_ = false;
 		};
 		typedef std::vector<TaskDescr> tasks_t;
 		tasks_t ActiveTasks_;
@@ -82,6 +89,8 @@ namespace CSTP
 		QNetworkAccessManager *NetworkAccessManager_;
 		QToolBar *Toolbar_;
 		QSet<QNetworkReply*> FinishedReplies_;
+		QHash<QString, int> HostConnections_;
+		BandwidthScheduler *Scheduler_;
 		QModelIndex Selected_;
 		ICoreProxy_ptr CoreProxy_;
 
@@ -117,6 +126,17 @@ namespace CSTP
 		bool HasFinishedReply (QNetworkReply*) const;
 		void RemoveFinishedReply (QNetworkReply*);
 
+		/** Reserves a connection to the given host for a download segment.
+		 *
+		 * If \em force is true, the connection is reserved even if the
+		 * per-host limit is already reached. Returns whether the
+		 * connection has been reserved.
+		 */
+		bool AcquireHostConnection (const QString& host, bool force);
+		void ReleaseHostConnection (const QString& host);
+
+		BandwidthScheduler* GetScheduler () const;
+
 		virtual int columnCount (const QModelIndex& = QModelIndex ()) const;
 		virtual QVariant data (const QModelIndex&, int = Qt::DisplayRole) const;
 		virtual Qt::ItemFlags flags (const QModelIndex&) const;
@@ -137,6 +157,9 @@ namespace CSTP
 		void updateInterface ();
 		void writeSettings ();
 		void finishedReply (QNetworkReply*);
+		void handleSegmentsChanged ();
+		void startQueued ();
+		void handleRatesUpdated ();
 	private:
 		int AddTask (const QUrl&,
 				const QString&,
@@ -152,8 +175,11 @@ namespace CSTP
 				const QStringList&,
 				LeechCraft::TaskParameters = LeechCraft::NoParameters);
 		int AddTask (TaskDescr&);
+		double GetSpeed (const TaskDescr&) const;
 		void ReadSettings ();
 		void ScheduleSave ();
+		int GetRunningCount () const;
+		bool CanStartMore () const;
 		tasks_t::const_iterator FindTask (QObject*) const;
 		tasks_t::iterator FindTask (QObject*);
 		void Remove (tasks_t::iterator);
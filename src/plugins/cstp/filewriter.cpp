@@ -0,0 +1,373 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "filewriter.h"
+#include <atomic>
+#include <algorithm>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QFile>
+#include <QMap>
+#include <QtDebug>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	namespace
+	{
+		const qint64 ChunkSize = 1024 * 1024;
+		const qint64 MaxPending = 8 * ChunkSize;
+
+		class IOThread : public QThread
+		{
+			QMutex Mutex_;
+			QWaitCondition JobsWC_;
+			QQueue<std::function<void ()>> Jobs_;
+			bool Quit_ = false;
+		public:
+			IOThread ()
+			{
+				setObjectName ("CSTP I/O thread");
+				start ();
+			}
+
+			~IOThread ()
+			{
+				{
+					QMutexLocker locker { &Mutex_ };
+					Quit_ = true;
+				}
+				JobsWC_.wakeAll ();
+				wait ();
+			}
+
+			static IOThread& Instance ()
+			{
+				static IOThread thread;
+				return thread;
+			}
+
+			void Schedule (const std::function<void ()>& job)
+			{
+				{
+					QMutexLocker locker { &Mutex_ };
+					Jobs_.enqueue (job);
+				}
+				JobsWC_.wakeOne ();
+			}
+		protected:
+			void run () override
+			{
+				while (true)
+				{
+					std::function<void ()> job;
+					{
+						QMutexLocker locker { &Mutex_ };
+						while (Jobs_.isEmpty () && !Quit_)
+							JobsWC_.wait (&Mutex_);
+
+						if (Jobs_.isEmpty ())
+							return;
+
+						job = Jobs_.dequeue ();
+					}
+					job ();
+				}
+			}
+		};
+
+		void Preallocate (QFile& file, qint64 size, bool extend)
+		{
+			if (file.size () >= size)
+				return;
+
+#ifdef Q_OS_LINUX
+			if (!fallocate (file.handle (), extend ? 0 : FALLOC_FL_KEEP_SIZE, 0, size))
+				return;
+#endif
+
+			if (extend && !file.resize (size))
+				qWarning () << Q_FUNC_INFO
+						<< "unable to preallocate"
+						<< size
+						<< "bytes for"
+						<< file.fileName ()
+						<< file.errorString ();
+		}
+	}
+
+	struct FileWriter::State
+	{
+		QMutex Mutex_;
+		QMap<qint64, qint64> Queued_;
+		QString Error_;
+		// Reset by the destructor of the writer, so the signals aren't
+		// emitted on a dead object.
+		FileWriter *Owner_ = nullptr;
+
+		// Accessed from the I/O thread only.
+		std::shared_ptr<QFile> File_;
+
+		std::atomic<qint64> Written_ { 0 };
+		std::atomic<qint64> Pending_ { 0 };
+		std::atomic<bool> Throttled_ { false };
+		std::atomic<bool> Failed_ { false };
+
+		void Notify (void (FileWriter::*signal) ());
+		void HandleIOError (const QString&);
+	};
+
+	void FileWriter::State::Notify (void (FileWriter::*signal) ())
+	{
+		QMutexLocker locker { &Mutex_ };
+		if (Owner_)
+			(Owner_->*signal) ();
+	}
+
+	void FileWriter::State::HandleIOError (const QString& error)
+	{
+		qWarning () << Q_FUNC_INFO
+				<< error;
+
+		{
+			QMutexLocker locker { &Mutex_ };
+			Error_ = error;
+		}
+
+		if (!Failed_.exchange (true))
+			Notify (&FileWriter::failed);
+	}
+
+	FileWriter::FileWriter (const std::shared_ptr<QFile>& file,
+			qint64 preallocate, bool extend, QObject *parent)
+	: QObject { parent }
+	, State_ { std::make_shared<State> () }
+	{
+		State_->Owner_ = this;
+
+		Schedule ([file, preallocate, extend] (State& state)
+				{
+					if (!file->isWritable ())
+					{
+						state.HandleIOError (tr ("%1 is not opened for writing")
+								.arg (file->fileName ()));
+						return;
+					}
+
+					state.File_ = file;
+					if (preallocate > 0)
+						Preallocate (*file, preallocate, extend);
+				});
+	}
+
+	FileWriter::~FileWriter ()
+	{
+		Close ();
+
+		QMutexLocker locker { &State_->Mutex_ };
+		State_->Owner_ = nullptr;
+	}
+
+	qint64 FileWriter::Append (QIODevice& dev, qint64 pos, qint64 max)
+	{
+		if (Closed_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "the writer is already closed";
+			return -1;
+		}
+
+		qint64 total = 0;
+		while (total < max)
+		{
+			const auto curPos = pos + total;
+			auto buffer = std::find_if (Buffers_.begin (), Buffers_.end (),
+					[curPos] (const Buffer& buf) { return buf.Pos_ + buf.Data_.size () == curPos; });
+			if (buffer == Buffers_.end ())
+			{
+				Buffers_.append ({ curPos, {} });
+				buffer = Buffers_.end () - 1;
+				buffer->Data_.reserve (ChunkSize);
+			}
+
+			const auto oldSize = buffer->Data_.size ();
+			const auto boundary = (curPos / ChunkSize + 1) * ChunkSize;
+			const auto toRead = std::min (max - total, boundary - curPos);
+
+			buffer->Data_.resize (oldSize + toRead);
+			const auto read = dev.read (buffer->Data_.data () + oldSize, toRead);
+			buffer->Data_.resize (oldSize + std::max<qint64> (read, 0));
+
+			if (read <= 0)
+			{
+				if (buffer->Data_.isEmpty ())
+					Buffers_.erase (buffer);
+				if (read < 0 && !total)
+					return -1;
+				break;
+			}
+
+			total += read;
+			State_->Pending_ += read;
+
+			if (curPos + read == boundary)
+			{
+				Submit (*buffer);
+				Buffers_.erase (buffer);
+			}
+
+			if (read < toRead)
+				break;
+		}
+
+		if (State_->Pending_ >= MaxPending)
+			Sync ();
+
+		return total;
+	}
+
+	bool FileWriter::CanAccept () const
+	{
+		if (State_->Pending_ < MaxPending)
+			return true;
+
+		State_->Throttled_ = true;
+		// The I/O thread might have drained the queue before noticing the flag.
+		return State_->Pending_ < MaxPending / 2 && State_->Throttled_.exchange (false);
+	}
+
+	void FileWriter::Sync ()
+	{
+		for (const auto& buffer : Buffers_)
+			Submit (buffer);
+		Buffers_.clear ();
+	}
+
+	void FileWriter::Close ()
+	{
+		if (Closed_)
+			return;
+
+		Sync ();
+		Closed_ = true;
+
+		Schedule ([] (State& state)
+				{
+					if (state.File_ &&
+							!state.Failed_ &&
+							!state.File_->flush ())
+						state.HandleIOError (state.File_->errorString ());
+					state.File_.reset ();
+
+					state.Notify (&FileWriter::closed);
+				});
+	}
+
+	bool FileWriter::IsClosed () const
+	{
+		return Closed_;
+	}
+
+	qint64 FileWriter::GetWritten () const
+	{
+		return State_->Written_;
+	}
+
+	qint64 FileWriter::GetFirstPending (qint64 from, qint64 to) const
+	{
+		qint64 result = -1;
+		auto consider = [&result, from, to] (qint64 pos)
+		{
+			if (pos >= from && pos < to && (result < 0 || pos < result))
+				result = pos;
+		};
+
+		for (const auto& buffer : Buffers_)
+			consider (buffer.Pos_);
+
+		QMutexLocker locker { &State_->Mutex_ };
+		const auto pos = State_->Queued_.lowerBound (from);
+		if (pos != State_->Queued_.end ())
+			consider (pos.key ());
+
+		return result;
+	}
+
+	QString FileWriter::GetErrorString () const
+	{
+		QMutexLocker locker { &State_->Mutex_ };
+		return State_->Error_;
+	}
+
+	void FileWriter::Submit (const Buffer& buffer)
+	{
+		{
+			QMutexLocker locker { &State_->Mutex_ };
+			State_->Queued_ [buffer.Pos_] = buffer.Data_.size ();
+		}
+
+		const auto pos = buffer.Pos_;
+		const auto data = buffer.Data_;
+		Schedule ([pos, data] (State& state)
+				{
+					if (!state.Failed_ && state.File_)
+					{
+						if (state.File_->seek (pos) &&
+								state.File_->write (data) == data.size ())
+							state.Written_ += data.size ();
+						else
+							state.HandleIOError (state.File_->errorString ());
+					}
+
+					{
+						QMutexLocker locker { &state.Mutex_ };
+						state.Queued_.remove (pos);
+					}
+
+					const auto pending = state.Pending_ -= data.size ();
+					if (pending < MaxPending / 2 &&
+							state.Throttled_.exchange (false))
+						state.Notify (&FileWriter::drained);
+				});
+	}
+
+	void FileWriter::Schedule (const std::function<void (State&)>& job)
+	{
+		const auto state = State_;
+		IOThread::Instance ().Schedule ([state, job] { job (*state); });
+	}
+}
+}
@@ -0,0 +1,137 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <functional>
+#include <QObject>
+#include <QList>
+#include <QByteArray>
+
+class QIODevice;
+class QFile;
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	/** Writes downloaded data to a file on a dedicated I/O thread.
+	 *
+	 * The data is read from the network replies directly into chunk
+	 * buffers on the GUI thread. A buffer is handed over to the I/O
+	 * thread once it reaches a chunk boundary, so the writes are large
+	 * and aligned. Several regions of the file (like in segmented
+	 * downloads) are buffered independently.
+	 *
+	 * The amount of data that's not written yet is bounded: CanAccept()
+	 * returns false once the limit is reached, and drained() is emitted
+	 * when the I/O thread catches up.
+	 *
+	 * The writer uses the file passed to the constructor from the I/O
+	 * thread, so the file must not be touched by anyone else until the
+	 * writer is closed and has emitted closed().
+	 *
+	 * The signals are emitted from the I/O thread. Neither closing nor
+	 * destroying the writer blocks: the queued data is written in the
+	 * background after that, and closed() is emitted if the writer is
+	 * still alive by then.
+	 */
+	class FileWriter : public QObject
+	{
+		Q_OBJECT
+
+		struct State;
+		const std::shared_ptr<State> State_;
+
+		struct Buffer
+		{
+			qint64 Pos_;
+			QByteArray Data_;
+		};
+		QList<Buffer> Buffers_;
+
+		bool Closed_ = false;
+	public:
+		/** Writes to the \em file, which should already be opened for
+		 * writing.
+		 *
+		 * If \em preallocate is positive, disk space for that many bytes
+		 * is reserved. The size of the file is changed only if
+		 * \em extend is true.
+		 */
+		FileWriter (const std::shared_ptr<QFile>& file, qint64 preallocate, bool extend, QObject* = nullptr);
+
+		/** Closes the writer without waiting for the queued data to be
+		 * written.
+		 */
+		~FileWriter ();
+
+		/** Reads at most \em max bytes from \em dev and queues them for
+		 * writing at the offset \em pos in the file.
+		 *
+		 * @return The number of bytes read or -1 on read error.
+		 */
+		qint64 Append (QIODevice& dev, qint64 pos, qint64 max);
+
+		bool CanAccept () const;
+
+		/** Queues partially filled buffers for writing.
+		 */
+		void Sync ();
+
+		/** Queues partially filled buffers and flushes the file after
+		 * they are written, emitting closed(). No data is accepted after
+		 * this call.
+		 */
+		void Close ();
+
+		bool IsClosed () const;
+
+		/** Returns the number of bytes written so far. This function
+		 * doesn't lock.
+		 */
+		qint64 GetWritten () const;
+
+		/** Returns the lowest offset in [from; to) of the data that's
+		 * queued but not written yet, or -1 if there is no such data.
+		 */
+		qint64 GetFirstPending (qint64 from, qint64 to) const;
+
+		QString GetErrorString () const;
+	private:
+		void Submit (const Buffer&);
+		void Schedule (const std::function<void (State&)>&);
+	signals:
+		void drained ();
+		void failed ();
+		void closed ();
+	};
+}
+}
@@ -0,0 +1,198 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "segmentmap.h"
+#include <algorithm>
+#include <QDataStream>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	void SegmentMap::Init (qint64 total, qint64 done)
+	{
+		TotalSize_ = total;
+		Segments_.clear ();
+		Segments_ [0] = { 0, total, std::min (done, total) };
+	}
+
+	void SegmentMap::Clear ()
+	{
+		TotalSize_ = -1;
+		Segments_.clear ();
+	}
+
+	bool SegmentMap::IsEmpty () const
+	{
+		return Segments_.isEmpty ();
+	}
+
+	bool SegmentMap::IsComplete () const
+	{
+		return !IsEmpty () &&
+				std::all_of (Segments_.begin (), Segments_.end (),
+						[] (const Segment& seg) { return seg.Pos_ >= seg.End_; });
+	}
+
+	qint64 SegmentMap::GetTotalSize () const
+	{
+		return TotalSize_;
+	}
+
+	qint64 SegmentMap::GetDone () const
+	{
+		qint64 result = 0;
+		for (const auto& seg : Segments_)
+			result += seg.Pos_ - seg.Start_;
+		return result;
+	}
+
+	SegmentMap::Segment SegmentMap::GetSegment (qint64 start) const
+	{
+		return Segments_.value (start, { start, start, start });
+	}
+
+	QList<SegmentMap::Segment> SegmentMap::GetSegments () const
+	{
+		return Segments_.values ();
+	}
+
+	QList<qint64> SegmentMap::GetIncompleteSegments () const
+	{
+		QList<qint64> result;
+		for (const auto& seg : Segments_)
+			if (seg.Pos_ < seg.End_)
+				result << seg.Start_;
+		return result;
+	}
+
+	qint64 SegmentMap::GetRemaining (qint64 start) const
+	{
+		const auto pos = Segments_.find (start);
+		return pos == Segments_.end () ?
+				0 :
+				std::max<qint64> (pos->End_ - pos->Pos_, 0);
+	}
+
+	void SegmentMap::Advance (qint64 start, qint64 bytes)
+	{
+		const auto pos = Segments_.find (start);
+		if (pos == Segments_.end ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown segment"
+					<< start;
+			return;
+		}
+
+		pos->Pos_ = std::min (pos->Pos_ + bytes, pos->End_);
+	}
+
+	void SegmentMap::Rewind (qint64 start, qint64 pos)
+	{
+		const auto seg = Segments_.find (start);
+		if (seg == Segments_.end ())
+			return;
+
+		seg->Pos_ = std::max (seg->Start_, std::min (seg->Pos_, pos));
+	}
+
+	qint64 SegmentMap::Split (qint64 start, qint64 minSize)
+	{
+		const auto pos = Segments_.find (start);
+		if (pos == Segments_.end ())
+			return -1;
+
+		const auto remaining = pos->End_ - pos->Pos_;
+		if (remaining < 2 * std::max<qint64> (minSize, 1))
+			return -1;
+
+		const auto middle = pos->Pos_ + remaining / 2;
+		const Segment newSeg { middle, pos->End_, middle };
+		pos->End_ = middle;
+		Segments_ [middle] = newSeg;
+		return middle;
+	}
+
+	QByteArray SegmentMap::Serialize () const
+	{
+		QByteArray result;
+		QDataStream out { &result, QIODevice::WriteOnly };
+		out << static_cast<quint8> (1)
+				<< TotalSize_
+				<< static_cast<quint32> (Segments_.size ());
+		for (const auto& seg : Segments_)
+			out << seg.Start_
+					<< seg.End_
+					<< seg.Pos_;
+		return result;
+	}
+
+	bool SegmentMap::Deserialize (const QByteArray& data)
+	{
+		Clear ();
+		if (data.isEmpty ())
+			return true;
+
+		QDataStream in { data };
+		quint8 version = 0;
+		in >> version;
+		if (version != 1)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown version"
+					<< version;
+			return false;
+		}
+
+		quint32 count = 0;
+		in >> TotalSize_
+				>> count;
+		for (quint32 i = 0; i < count && in.status () == QDataStream::Ok; ++i)
+		{
+			Segment seg;
+			in >> seg.Start_
+					>> seg.End_
+					>> seg.Pos_;
+			Segments_ [seg.Start_] = seg;
+		}
+
+		if (in.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "corrupted segment map";
+			Clear ();
+			return false;
+		}
+
+		return true;
+	}
+}
+}
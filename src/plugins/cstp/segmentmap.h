@@ -0,0 +1,102 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QMap>
+#include <QList>
+#include <QByteArray>
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	/** Tracks which byte ranges of a file being downloaded in several
+	 * segments are already written.
+	 *
+	 * Segments are identified by their start offsets, which never
+	 * change once a segment is created.
+	 */
+	class SegmentMap
+	{
+	public:
+		struct Segment
+		{
+			qint64 Start_;
+			qint64 End_;
+			qint64 Pos_;
+		};
+	private:
+		qint64 TotalSize_ = -1;
+		QMap<qint64, Segment> Segments_;
+	public:
+		/** Initializes the map with a single segment spanning the whole
+		 * file of \em total bytes, of which \em done first bytes are
+		 * already written.
+		 */
+		void Init (qint64 total, qint64 done);
+		void Clear ();
+
+		bool IsEmpty () const;
+		bool IsComplete () const;
+
+		qint64 GetTotalSize () const;
+		qint64 GetDone () const;
+
+		Segment GetSegment (qint64 start) const;
+		QList<Segment> GetSegments () const;
+		QList<qint64> GetIncompleteSegments () const;
+
+		/** Returns the number of bytes left to download in the segment.
+		 */
+		qint64 GetRemaining (qint64 start) const;
+
+		/** Marks \em bytes more bytes of the segment as written.
+		 */
+		void Advance (qint64 start, qint64 bytes);
+
+		/** Moves the write position of the segment back to \em pos, for
+		 * instance, if the data after \em pos hasn't hit the disk yet.
+		 */
+		void Rewind (qint64 start, qint64 pos);
+
+		/** Splits the remaining part of the segment in two halves if each
+		 * half is at least \em minSize bytes long. The first half stays
+		 * in the original segment.
+		 *
+		 * @return The start of the newly created segment or -1 if the
+		 * segment is too small to be split.
+		 */
+		qint64 Split (qint64 start, qint64 minSize);
+
+		QByteArray Serialize () const;
+		bool Deserialize (const QByteArray&);
+	};
+}
+}
@@ -35,6 +35,7 @@
 #include <QFileInfo>
 #include <QDataStream>
 #include <QDir>
+#include <QPointer>
 #include <QTimer>
 #include <QtDebug>
 #include <util/xpc/util.h>
@@ -45,6 +46,8 @@
 #include <interfaces/core/icoreproxy.h>
 #include <interfaces/core/ientitymanager.h>
 #include "core.h"
+#include "filewriter.h"
+#include "bandwidthscheduler.h"
 #include "xmlsettingsmanager.h"
 
 namespace LeechCraft
@@ -72,6 +75,10 @@ namespace CSTP
 
 			return map;
 		}
+
+		const int MaxSegmentFailures = 5;
+
+		const qint64 ReplyBufferSize = 4 * 1024 * 1024;
 	}
 
 	Task::Task (const QUrl& url, const QVariantMap& params)
@@ -92,7 +99,7 @@ namespace CSTP
 		connect (Timer_,
 				SIGNAL (timeout ()),
 				this,
-				SIGNAL (updateInterface ()));
+				SLOT (handleTimer ()));
 	}
 
 	Task::Task (QNetworkReply *reply)
@@ -114,19 +121,45 @@ namespace CSTP
 		connect (Timer_,
 				SIGNAL (timeout ()),
 				this,
-				SIGNAL (updateInterface ()));
+				SLOT (handleTimer ()));
 	}
 
 	Task::~Task ()
 	{
+		AbortSegments ();
+		Core::Instance ().GetScheduler ()->RemoveClient (this);
+
 		if (Reply_)
 			Core::Instance ().RemoveFinishedReply (Reply_.get ());
 	}
 
 	void Task::Start (const std::shared_ptr<QFile>& tof)
 	{
+		// The previous writer might still be writing to the file.
+		if (Writer_)
+		{
+			ResetWriter ([this, tof]
+					{
+						if (!tof->isOpen () && !tof->open (QIODevice::ReadWrite))
+						{
+							Error_ = tof->errorString ();
+							ReportWriteError (Error_);
+							emit done (true);
+							return;
+						}
+
+						Start (tof);
+					});
+			return;
+		}
+
+		WriteFailed_ = false;
 		FileSizeAtStart_ = tof->size ();
 		To_ = tof;
+		StreamStart_ = WritePos_ = URL_.isEmpty () ? 0 : FileSizeAtStart_;
+
+		if (!Reply_ && ResumeSegmented ())
+			return;
 
 		if (!Reply_)
 		{
@@ -138,32 +171,12 @@ namespace CSTP
 				return;
 			}
 
-			auto ua = XmlSettingsManager::Instance ().property ("UserUserAgent").toString ();
-			if (ua.isEmpty ())
-				ua = XmlSettingsManager::Instance ().property ("PredefinedUserAgent").toString ();
-
-			if (ua == "%leechcraft%")
-				ua = "LeechCraft.CSTP/" + Core::Instance ().GetCoreProxy ()->GetVersion ();
-
-			QNetworkRequest req { URL_ };
+			auto req = MakeRequest ();
 			if (tof->size ())
 				req.setRawHeader ("Range", QString ("bytes=%1-").arg (tof->size ()).toLatin1 ());
-			req.setRawHeader ("User-Agent", ua.toLatin1 ());
-
-			if (Referer_.isEmpty ())
-				req.setRawHeader ("Referer", QString (QString ("http://") + URL_.host ()).toLatin1 ());
-			else
-				req.setRawHeader ("Referer", Referer_.toEncoded ());
-
-			req.setRawHeader ("Host", URL_.host ().toLatin1 ());
-			req.setRawHeader ("Origin", URL_.scheme ().toLatin1 () + "://" + URL_.host ().toLatin1 ());
-			req.setRawHeader ("Accept", "*/*");
 
 			StartTime_.restart ();
 
-			for (const auto& pair : Util::Stlize (Headers_))
-				req.setRawHeader (pair.first.toLatin1 (), pair.second.toByteArray ());
-
 			auto nam = Core::Instance ().GetNetworkAccessManager ();
 			switch (Operation_)
 			{
@@ -205,6 +218,7 @@ namespace CSTP
 			Timer_->start (3000);
 
 		Reply_->setParent (nullptr);
+		Reply_->setReadBufferSize (ReplyBufferSize);
 		connect (Reply_.get (),
 				SIGNAL (downloadProgress (qint64, qint64)),
 				this,
@@ -229,8 +243,22 @@ namespace CSTP
 
 	void Task::Stop ()
 	{
+		if (!Connections_.isEmpty ())
+		{
+			AbortSegments ();
+			emit updateInterface ();
+		}
+
 		if (Reply_)
 			Reply_->abort ();
+
+		// The file is shared with the writer, so it's closed only after
+		// the writer is done with it.
+		ResetWriter ([this]
+				{
+					if (To_)
+						To_->close ();
+				});
 	}
 
 	void Task::ForbidNameChanges ()
@@ -240,16 +268,27 @@ namespace CSTP
 
 	QByteArray Task::Serialize () const
 	{
+		// Only the data that has actually hit the disk is considered done.
+		auto segments = Segments_;
+		if (Writer_)
+			for (const auto& seg : Segments_.GetSegments ())
+			{
+				const auto pending = Writer_->GetFirstPending (seg.Start_, seg.Pos_);
+				if (pending >= 0)
+					segments.Rewind (seg.Start_, pending);
+			}
+
 		QByteArray result;
 		{
 			QDataStream out (&result, QIODevice::WriteOnly);
-			out << 2
+			out << 3
 				<< URL_
 				<< StartTime_
-				<< Done_
+				<< GetDone ()
 				<< Total_
 				<< Speed_
-				<< CanChangeName_;
+				<< CanChangeName_
+				<< segments.Serialize ();
 		}
 		return result;
 	}
@@ -259,7 +298,7 @@ namespace CSTP
 		QDataStream in (&data, QIODevice::ReadOnly);
 		int version = 0;
 		in >> version;
-		if (version < 1 || version > 2)
+		if (version < 1 || version > 3)
 			throw std::runtime_error ("Unknown version");
 
 		in >> URL_
@@ -270,6 +309,13 @@ namespace CSTP
 
 		if (version >= 2)
 			in >> CanChangeName_;
+
+		if (version >= 3)
+		{
+			QByteArray segments;
+			in >> segments;
+			Segments_.Deserialize (segments);
+		}
 	}
 
 	double Task::GetSpeed () const
@@ -279,7 +325,7 @@ namespace CSTP
 
 	qint64 Task::GetDone () const
 	{
-		return Done_;
+		return Writer_ ? WriteBase_ + Writer_->GetWritten () : Done_;
 	}
 
 	qint64 Task::GetTotal () const
@@ -289,9 +335,9 @@ namespace CSTP
 
 	QString Task::GetState () const
 	{
-		if (!Reply_)
+		if (!Reply_ && Connections_.isEmpty ())
 			return tr ("Stopped");
-		else if (Done_ == Total_)
+		else if (GetDone () == Total_)
 			return tr ("Finished");
 		else
 			return tr ("Running");
@@ -309,12 +355,43 @@ namespace CSTP
 
 	bool Task::IsRunning () const
 	{
-		return Reply_ && !URL_.isEmpty ();
+		return (Reply_ || !Connections_.isEmpty ()) && !URL_.isEmpty ();
 	}
 
 	QString Task::GetErrorString () const
 	{
-		return Reply_ ? Reply_->errorString () : tr ("Task isn't initialized properly");
+		if (Reply_)
+			return Reply_->errorString ();
+		if (!Error_.isEmpty ())
+			return Error_;
+		return tr ("Task isn't initialized properly");
+	}
+
+	QNetworkRequest Task::MakeRequest () const
+	{
+		auto ua = XmlSettingsManager::Instance ().property ("UserUserAgent").toString ();
+		if (ua.isEmpty ())
+			ua = XmlSettingsManager::Instance ().property ("PredefinedUserAgent").toString ();
+
+		if (ua == "%leechcraft%")
+			ua = "LeechCraft.CSTP/" + Core::Instance ().GetCoreProxy ()->GetVersion ();
+
+		QNetworkRequest req { URL_ };
+		req.setRawHeader ("User-Agent", ua.toLatin1 ());
+
+		if (Referer_.isEmpty ())
+			req.setRawHeader ("Referer", QString (QString ("http://") + URL_.host ()).toLatin1 ());
+		else
+			req.setRawHeader ("Referer", Referer_.toEncoded ());
+
+		req.setRawHeader ("Host", URL_.host ().toLatin1 ());
+		req.setRawHeader ("Origin", URL_.scheme ().toLatin1 () + "://" + URL_.host ().toLatin1 ());
+		req.setRawHeader ("Accept", "*/*");
+
+		for (const auto& pair : Util::Stlize (Headers_))
+			req.setRawHeader (pair.first.toLatin1 (), pair.second.toByteArray ());
+
+		return req;
 	}
 
 	void Task::Reset ()
@@ -329,14 +406,14 @@ namespace CSTP
 
 	void Task::RecalculateSpeed ()
 	{
-		Speed_ = static_cast<double> (Done_ * 1000) / static_cast<double> (StartTime_.elapsed ());
+		Speed_ = static_cast<double> (GetDone () * 1000) / static_cast<double> (StartTime_.elapsed ());
 	}
 
-	void Task::HandleMetadataRedirection ()
+	bool Task::HandleMetadataRedirection ()
 	{
 		const auto& newUrl = Reply_->rawHeader ("Location");
 		if (!newUrl.size ())
-			return;
+			return false;
 
 		const auto code = Reply_->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ();
 		if (code > 399 || code < 300)
@@ -346,7 +423,7 @@ namespace CSTP
 					<< newUrl
 					<< code
 					<< Reply_->attribute (QNetworkRequest::HttpReasonPhraseAttribute);
-			return;
+			return false;
 		}
 
 		if (!QUrl { newUrl }.isValid ())
@@ -380,6 +457,8 @@ namespace CSTP
 					Qt::QueuedConnection,
 					Q_ARG (QByteArray, newUrl));
 		}
+
+		return true;
 	}
 
 	namespace
@@ -465,6 +544,15 @@ namespace CSTP
 			return;
 		}
 
+		if (Writer_)
+		{
+			qDebug () << Q_FUNC_INFO
+					<< "the data is already being written to"
+					<< oldPath
+					<< ", skipping renaming";
+			return;
+		}
+
 		const auto openMode = To_->openMode ();
 		To_->close ();
 
@@ -487,8 +575,8 @@ namespace CSTP
 
 	void Task::handleDataTransferProgress (qint64 done, qint64 total)
 	{
-		Done_ = done;
-		Total_ = total;
+		Done_ = StreamStart_ + done;
+		Total_ = total > 0 ? StreamStart_ + total : total;
 
 		RecalculateSpeed ();
 
@@ -498,6 +586,12 @@ namespace CSTP
 
 	void Task::redirectedConstruction (const QByteArray& newUrl)
 	{
+		if (Writer_)
+		{
+			ResetWriter ([this, newUrl] { redirectedConstruction (newUrl); });
+			return;
+		}
+
 		if (To_ && FileSizeAtStart_ >= 0)
 		{
 			To_->close ();
@@ -512,10 +606,464 @@ namespace CSTP
 		Start (To_);
 	}
 
+	void Task::ReportWriteError (const QString& error)
+	{
+		qWarning () << Q_FUNC_INFO
+				<< "Error writing to file:"
+				<< To_->fileName ()
+				<< error;
+
+		const auto& errString = tr ("Error writing to file %1: %2")
+				.arg (To_->fileName ())
+				.arg (error);
+		const auto& e = Util::MakeNotification ("LeechCraft CSTP",
+				errString,
+				PCritical_);
+		Core::Instance ().GetCoreProxy ()->GetEntityManager ()->HandleEntity (e);
+	}
+
+	namespace
+	{
+		/** Returns the offset of the first byte in the reply body or -1 if
+		 * the reply is neither a partial content reply nor a full one.
+		 */
+		qint64 GetRangeStart (const QNetworkReply& reply, qint64 *total = nullptr)
+		{
+			const auto code = reply.attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ();
+			if (code == 200)
+			{
+				if (total)
+					*total = reply.header (QNetworkRequest::ContentLengthHeader).toLongLong ();
+				return 0;
+			}
+
+			if (code != 206)
+				return -1;
+
+			// Content-Range: bytes 100-199/1000
+			const auto& range = reply.rawHeader ("Content-Range").trimmed ();
+			const auto spacePos = range.indexOf (' ');
+			const auto dashPos = range.indexOf ('-', spacePos);
+			const auto slashPos = range.indexOf ('/', dashPos);
+			if (spacePos == -1 || dashPos == -1 || slashPos == -1)
+				return -1;
+
+			bool ok = false;
+			const auto start = range.mid (spacePos + 1, dashPos - spacePos - 1).toLongLong (&ok);
+			if (!ok)
+				return -1;
+
+			if (total)
+			{
+				*total = range.mid (slashPos + 1).toLongLong (&ok);
+				if (!ok)
+					*total = -1;
+			}
+			return start;
+		}
+	}
+
+	FileWriter& Task::GetWriter ()
+	{
+		if (Writer_)
+			return *Writer_;
+
+		const bool segmented = !Segments_.IsEmpty ();
+		WriteBase_ = segmented ? Segments_.GetDone () : WritePos_;
+		Writer_.reset (new FileWriter
+				{
+					To_,
+					segmented ? Segments_.GetTotalSize () : Total_,
+					segmented
+				});
+
+		connect (Writer_.get (),
+				SIGNAL (drained ()),
+				this,
+				SLOT (handleWriterDrained ()),
+				Qt::QueuedConnection);
+		connect (Writer_.get (),
+				SIGNAL (failed ()),
+				this,
+				SLOT (handleWriterFailed ()),
+				Qt::QueuedConnection);
+		connect (Writer_.get (),
+				SIGNAL (closed ()),
+				this,
+				SLOT (handleWriterClosed ()),
+				Qt::QueuedConnection);
+
+		return *Writer_;
+	}
+
+	bool Task::ReadReply (bool force)
+	{
+		while (Reply_->bytesAvailable () > 0)
+		{
+			auto& writer = GetWriter ();
+			if (!force && !writer.CanAccept ())
+				break;
+
+			const auto scheduler = Core::Instance ().GetScheduler ();
+			const auto toRead = force ?
+					Reply_->bytesAvailable () :
+					scheduler->Acquire (this, Reply_->bytesAvailable ());
+			if (!toRead)
+				break;
+
+			const auto read = writer.Append (*Reply_, WritePos_, toRead);
+			if (force && read > 0)
+				scheduler->Consume (this, read);
+			if (read < 0)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error reading from"
+						<< Reply_->url ()
+						<< Reply_->errorString ();
+				return false;
+			}
+			if (!read)
+				break;
+
+			WritePos_ += read;
+		}
+
+		return true;
+	}
+
+	void Task::ResetWriter (const std::function<void ()>& then)
+	{
+		if (!Writer_)
+		{
+			if (then)
+				then ();
+			return;
+		}
+
+		if (then)
+			WriterClosedHandlers_ << then;
+
+		if (Writer_->IsClosed ())
+			return;
+
+		disconnect (Writer_.get (),
+				SIGNAL (drained ()),
+				this,
+				SLOT (handleWriterDrained ()));
+		Writer_->Close ();
+	}
+
+	void Task::FinishWriting ()
+	{
+		ResetWriter ([this]
+				{
+					Segments_.Clear ();
+					emit done (WriteFailed_);
+				});
+	}
+
+	bool Task::TryStartSegmented ()
+	{
+		if (URL_.isEmpty () ||
+				Writer_ ||
+				Operation_ != QNetworkAccessManager::GetOperation ||
+				!Segments_.IsEmpty ())
+			return false;
+
+		const auto& xsm = XmlSettingsManager::Instance ();
+		if (xsm.property ("MaxSegments").toInt () < 2)
+			return false;
+
+		const auto& encoding = Reply_->rawHeader ("Content-Encoding").trimmed ().toLower ();
+		if (!encoding.isEmpty () && encoding != "identity")
+			return false;
+
+		const auto code = Reply_->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ();
+		if (code == 200 &&
+				(FileSizeAtStart_ > 0 || Reply_->rawHeader ("Accept-Ranges").trimmed ().toLower () != "bytes"))
+			return false;
+
+		qint64 total = -1;
+		const auto offset = GetRangeStart (*Reply_, &total);
+		if (offset < 0 ||
+				offset != std::max<qint64> (FileSizeAtStart_, 0) ||
+				total <= 0)
+			return false;
+
+		const auto minSize = xsm.property ("MinSegmentSize").toLongLong () * 1024;
+		if (total - offset < 2 * minSize)
+			return false;
+
+		Segments_.Init (total, offset);
+		SegmentFailures_ = 0;
+		Error_.clear ();
+
+		disconnect (Reply_.get (),
+				0,
+				this,
+				0);
+		Core::Instance ().AcquireHostConnection (URL_.host (), true);
+		AddConnection ({ Reply_.release (), &LateDelete }, 0, offset);
+
+		emit segmentsChanged ();
+
+		QMetaObject::invokeMethod (this,
+				"spawnSegments",
+				Qt::QueuedConnection);
+		return true;
+	}
+
+	bool Task::ResumeSegmented ()
+	{
+		if (Segments_.IsEmpty ())
+			return false;
+
+		const auto& segments = Segments_.GetSegments ();
+		const bool consistent = std::all_of (segments.begin (), segments.end (),
+				[this] (const SegmentMap::Segment& seg)
+					{ return seg.Pos_ == seg.Start_ || seg.Pos_ <= To_->size (); });
+		if (!consistent || To_->size () > Segments_.GetTotalSize ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "file"
+					<< To_->fileName ()
+					<< "doesn't match the saved segments, restarting";
+			Segments_.Clear ();
+			To_->resize (0);
+			FileSizeAtStart_ = 0;
+			emit segmentsChanged ();
+			return false;
+		}
+
+		StartTime_.restart ();
+		SegmentFailures_ = 0;
+		Error_.clear ();
+
+		spawnSegments ();
+
+		if (!Timer_->isActive ())
+			Timer_->start (3000);
+
+		return true;
+	}
+
+	qint64 Task::PickSegment (qint64 minSize)
+	{
+		for (auto segment : Segments_.GetIncompleteSegments ())
+			if (std::none_of (Connections_.begin (), Connections_.end (),
+					[segment] (const SegmentConnection& conn) { return conn.Segment_ == segment; }))
+				return segment;
+
+		if (SegmentFailures_)
+			return -1;
+
+		// Help the connection that would otherwise finish last.
+		QList<QPair<double, qint64>> etas;
+		for (const auto& conn : Connections_)
+		{
+			const auto speed = conn.Received_ * 1000. / std::max (conn.Started_.elapsed (), 1);
+			etas.append ({ Segments_.GetRemaining (conn.Segment_) / std::max (speed, 1.), conn.Segment_ });
+		}
+		std::sort (etas.begin (), etas.end (),
+				[] (const QPair<double, qint64>& left, const QPair<double, qint64>& right)
+					{ return left.first > right.first; });
+
+		for (const auto& eta : etas)
+		{
+			const auto newSegment = Segments_.Split (eta.second, minSize);
+			if (newSegment >= 0)
+			{
+				emit segmentsChanged ();
+				return newSegment;
+			}
+		}
+
+		return -1;
+	}
+
+	void Task::StartSegmentConnection (qint64 segment)
+	{
+		const auto& seg = Segments_.GetSegment (segment);
+
+		auto req = MakeRequest ();
+		req.setRawHeader ("Range",
+				QString ("bytes=%1-%2").arg (seg.Pos_).arg (seg.End_ - 1).toLatin1 ());
+
+		const auto nam = Core::Instance ().GetNetworkAccessManager ();
+		AddConnection ({ nam->get (req), &LateDelete }, segment, seg.Pos_);
+	}
+
+	void Task::AddConnection (const std::shared_ptr<QNetworkReply>& reply,
+			qint64 segment, qint64 requestedFrom)
+	{
+		reply->setParent (nullptr);
+		reply->setReadBufferSize (ReplyBufferSize);
+
+		connect (reply.get (),
+				SIGNAL (metaDataChanged ()),
+				this,
+				SLOT (handleSegmentMetaDataChanged ()));
+		connect (reply.get (),
+				SIGNAL (readyRead ()),
+				this,
+				SLOT (handleSegmentReadyRead ()));
+		connect (reply.get (),
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleSegmentFinished ()));
+
+		QTime started;
+		started.start ();
+		Connections_.append ({ reply, segment, requestedFrom, 0, started });
+	}
+
+	int Task::FindConnection (QObject *reply) const
+	{
+		for (int i = 0; i < Connections_.size (); ++i)
+			if (Connections_.at (i).Reply_.get () == reply)
+				return i;
+		return -1;
+	}
+
+	bool Task::WriteSegmentData (int idx, bool force)
+	{
+		auto& conn = Connections_ [idx];
+		const auto& seg = Segments_.GetSegment (conn.Segment_);
+
+		// The segment might have been split after the request was sent.
+		auto toRead = std::min (seg.End_ - seg.Pos_, conn.Reply_->bytesAvailable ());
+		if (toRead <= 0)
+			return true;
+
+		auto& writer = GetWriter ();
+		if (!force && !writer.CanAccept ())
+			return true;
+
+		const auto scheduler = Core::Instance ().GetScheduler ();
+		if (!force)
+			toRead = scheduler->Acquire (this, toRead);
+		if (!toRead)
+			return true;
+
+		const auto read = writer.Append (*conn.Reply_, seg.Pos_, toRead);
+		if (read < 0)
+		{
+			HandleSegmentFailure (idx, conn.Reply_->errorString ());
+			return false;
+		}
+		if (force)
+			scheduler->Consume (this, read);
+
+		Segments_.Advance (conn.Segment_, read);
+		conn.Received_ += read;
+		Total_ = Segments_.GetTotalSize ();
+		return true;
+	}
+
+	void Task::ProcessSegmentData (int idx)
+	{
+		if (!WriteSegmentData (idx, false))
+			return;
+
+		if (Segments_.GetRemaining (Connections_.at (idx).Segment_))
+			return;
+
+		FinishConnection (idx);
+		CheckSegmentsState ();
+	}
+
+	void Task::FinishConnection (int idx)
+	{
+		const auto conn = Connections_.takeAt (idx);
+		disconnect (conn.Reply_.get (),
+				0,
+				this,
+				0);
+		conn.Reply_->abort ();
+
+		Core::Instance ().ReleaseHostConnection (URL_.host ());
+	}
+
+	void Task::AbortSegments ()
+	{
+		while (!Connections_.isEmpty ())
+			FinishConnection (Connections_.size () - 1);
+	}
+
+	void Task::HandleSegmentFailure (int idx, const QString& error)
+	{
+		qWarning () << Q_FUNC_INFO
+				<< "segment"
+				<< Connections_.at (idx).Segment_
+				<< "of"
+				<< URL_
+				<< "failed:"
+				<< error;
+
+		Error_ = error;
+		++SegmentFailures_;
+		FinishConnection (idx);
+
+		if (SegmentFailures_ < MaxSegmentFailures)
+		{
+			CheckSegmentsState ();
+			return;
+		}
+
+		AbortSegments ();
+		emit updateInterface ();
+
+		// Might be called from a writer callback, so don't let the task be
+		// destroyed under our feet.
+		ResetWriter ([this]
+				{
+					QMetaObject::invokeMethod (this,
+							"done",
+							Qt::QueuedConnection,
+							Q_ARG (bool, true));
+				});
+	}
+
+	void Task::CheckSegmentsState ()
+	{
+		emit segmentsChanged ();
+
+		if (!Segments_.IsComplete ())
+		{
+			spawnSegments ();
+			return;
+		}
+
+		AbortSegments ();
+		Timer_->stop ();
+		emit updateInterface ();
+		FinishWriting ();
+	}
+
 	void Task::handleMetaDataChanged ()
 	{
-		HandleMetadataRedirection ();
+		if (HandleMetadataRedirection ())
+			return;
+
 		HandleMetadataFilename ();
+
+		qint64 total = -1;
+		const auto start = GetRangeStart (*Reply_, &total);
+		if (start >= 0 && !Writer_)
+		{
+			// The server has ignored the Range header and sends everything.
+			if (!start && FileSizeAtStart_ > 0)
+			{
+				To_->resize (0);
+				FileSizeAtStart_ = 0;
+			}
+
+			StreamStart_ = WritePos_ = start;
+			if (total > 0)
+				Total_ = total;
+		}
+
+		TryStartSegmented ();
 	}
 
 	void Task::handleLocalTransfer ()
@@ -580,27 +1128,10 @@ namespace CSTP
 
 	bool Task::handleReadyRead ()
 	{
-		if (Reply_)
+		if (Reply_ && !ReadReply (false))
 		{
-			quint64 avail = Reply_->bytesAvailable ();
-			quint64 res = To_->write (Reply_->readAll ());
-			if (static_cast<quint64> (-1) == res ||
-					res != avail)
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "Error writing to file:"
-						<< To_->fileName ()
-						<< To_->errorString ();
-
-				const auto& errString = tr ("Error writing to file %1: %2")
-						.arg (To_->fileName ())
-						.arg (To_->errorString ());
-				const auto& e = Util::MakeNotification ("LeechCraft CSTP",
-						errString,
-						PCritical_);
-				Core::Instance ().GetCoreProxy ()->GetEntityManager ()->HandleEntity (e);
-				emit done (true);
-			}
+			handleError ();
+			return true;
 		}
 		if (URL_.isEmpty () &&
 				Core::Instance ().HasFinishedReply (Reply_.get ()))
@@ -613,12 +1144,188 @@ namespace CSTP
 
 	void Task::handleFinished ()
 	{
-		emit done (false);
+		if (Reply_)
+		{
+			// handleError() has already taken care of it.
+			if (Reply_->error () != QNetworkReply::NoError)
+				return;
+
+			if (!ReadReply (true))
+			{
+				handleError ();
+				return;
+			}
+		}
+
+		FinishWriting ();
 	}
 
 	void Task::handleError ()
 	{
-		emit done (true);
+		ResetWriter ([this] { emit done (true); });
+	}
+
+	void Task::handleTimer ()
+	{
+		RecalculateSpeed ();
+		spawnSegments ();
+		emit updateInterface ();
+	}
+
+	void Task::PullData ()
+	{
+		if (Writer_ && Writer_->IsClosed ())
+			return;
+
+		if (Reply_ && handleReadyRead ())
+			return;
+
+		const auto& replies = Util::Map (Connections_,
+				[] (const SegmentConnection& conn) { return conn.Reply_; });
+		for (const auto& reply : replies)
+		{
+			const auto idx = FindConnection (reply.get ());
+			if (idx >= 0)
+				ProcessSegmentData (idx);
+		}
+	}
+
+	void Task::handleWriterDrained ()
+	{
+		if (sender () == Writer_.get ())
+			PullData ();
+	}
+
+	void Task::handleBudgetAvailable ()
+	{
+		PullData ();
+	}
+
+	void Task::handleWriterFailed ()
+	{
+		if (sender () != Writer_.get ())
+			return;
+
+		Error_ = Writer_->GetErrorString ();
+		ReportWriteError (Error_);
+		WriteFailed_ = true;
+
+		// The writer is already being closed, and the handlers of that
+		// will finish the task.
+		if (Writer_->IsClosed ())
+			return;
+
+		if (Reply_)
+		{
+			disconnect (Reply_.get (),
+					0,
+					this,
+					0);
+			Reply_->abort ();
+			Reply_.reset ();
+		}
+		AbortSegments ();
+		Timer_->stop ();
+		emit updateInterface ();
+
+		ResetWriter ([this] { emit done (true); });
+	}
+
+	void Task::handleWriterClosed ()
+	{
+		if (sender () != Writer_.get ())
+			return;
+
+		Done_ = GetDone ();
+		Writer_.reset ();
+
+		emit updateInterface ();
+
+		// A handler might finish the task and get it destroyed.
+		const QPointer<Task> guard { this };
+		const auto handlers = WriterClosedHandlers_;
+		WriterClosedHandlers_.clear ();
+		for (const auto& handler : handlers)
+		{
+			if (!guard)
+				return;
+			handler ();
+		}
+	}
+
+	void Task::spawnSegments ()
+	{
+		if (Segments_.IsEmpty () ||
+				Segments_.IsComplete () ||
+				!To_ ||
+				!To_->isOpen ())
+			return;
+
+		const auto& xsm = XmlSettingsManager::Instance ();
+		const auto maxSegments = std::max (xsm.property ("MaxSegments").toInt (), 1);
+		const auto minSize = std::max<qint64> (xsm.property ("MinSegmentSize").toLongLong () * 1024, 1);
+
+		auto& core = Core::Instance ();
+		const auto& host = URL_.host ();
+		while (Connections_.size () < maxSegments)
+		{
+			if (!core.AcquireHostConnection (host, Connections_.isEmpty ()))
+				break;
+
+			const auto segment = PickSegment (minSize);
+			if (segment < 0)
+			{
+				core.ReleaseHostConnection (host);
+				break;
+			}
+
+			StartSegmentConnection (segment);
+		}
+	}
+
+	void Task::handleSegmentMetaDataChanged ()
+	{
+		const auto idx = FindConnection (sender ());
+		if (idx < 0)
+			return;
+
+		const auto& conn = Connections_.at (idx);
+		if (conn.Reply_->attribute (QNetworkRequest::HttpStatusCodeAttribute).isNull ())
+			return;
+
+		if (GetRangeStart (*conn.Reply_) != conn.RequestedFrom_)
+			HandleSegmentFailure (idx, tr ("Server doesn't support partial downloads."));
+	}
+
+	void Task::handleSegmentReadyRead ()
+	{
+		const auto idx = FindConnection (sender ());
+		if (idx >= 0)
+			ProcessSegmentData (idx);
+	}
+
+	void Task::handleSegmentFinished ()
+	{
+		const auto idx = FindConnection (sender ());
+		if (idx < 0)
+			return;
+
+		const auto reply = Connections_.at (idx).Reply_;
+		if (reply->error () == QNetworkReply::NoError &&
+				!WriteSegmentData (idx, true))
+			return;
+
+		if (Segments_.GetRemaining (Connections_.at (idx).Segment_))
+		{
+			HandleSegmentFailure (idx,
+					reply->error () == QNetworkReply::NoError ?
+						tr ("Connection closed before the segment was downloaded.") :
+						reply->errorString ());
+			return;
+		}
+
+		FinishConnection (idx);
+		CheckSegmentsState ();
 	}
 }
 }
@@ -30,12 +30,14 @@
 #pragma once
 
 #include <memory>
+#include <functional>
 #include <QObject>
 #include <QUrl>
 #include <QTime>
 #include <QNetworkReply>
 #include <QStringList>
 #include <interfaces/structures.h>
+#include "segmentmap.h"
 
 class QAuthenticator;
 class QNetworkProxy;
@@ -47,6 +49,8 @@ namespace LeechCraft
 {
 namespace CSTP
 {
+	class FileWriter;
+
 	class Task : public QObject
 	{
 		Q_OBJECT
@@ -69,6 +73,26 @@ namespace CSTP
 		const QVariantMap Headers_;
 
 		const QByteArray UploadData_ = {};
+
+		struct SegmentConnection
+		{
+			std::shared_ptr<QNetworkReply> Reply_;
+			qint64 Segment_;
+			qint64 RequestedFrom_;
+			qint64 Received_;
+			QTime Started_;
+		};
+		QList<SegmentConnection> Connections_;
+		SegmentMap Segments_;
+		int SegmentFailures_ = 0;
+		QString Error_;
+
+		std::unique_ptr<FileWriter> Writer_;
+		QList<std::function<void ()>> WriterClosedHandlers_;
+		bool WriteFailed_ = false;
+		qint64 StreamStart_ = 0;
+		qint64 WritePos_ = 0;
+		qint64 WriteBase_ = 0;
 	public:
 		explicit Task (const QUrl& url = QUrl (), const QVariantMap& params = QVariantMap ());
 		explicit Task (QNetworkReply*);
@@ -90,10 +114,32 @@ namespace CSTP
 		bool IsRunning () const;
 		QString GetErrorString () const;
 	private:
+		QNetworkRequest MakeRequest () const;
+
 		void Reset ();
 		void RecalculateSpeed ();
-		void HandleMetadataRedirection ();
+		bool HandleMetadataRedirection ();
 		void HandleMetadataFilename ();
+		void ReportWriteError (const QString&);
+
+		FileWriter& GetWriter ();
+		bool ReadReply (bool force);
+		void ResetWriter (const std::function<void ()>& then = std::function<void ()> ());
+		void FinishWriting ();
+		void PullData ();
+
+		bool TryStartSegmented ();
+		bool ResumeSegmented ();
+		qint64 PickSegment (qint64 minSize);
+		void StartSegmentConnection (qint64 segment);
+		void AddConnection (const std::shared_ptr<QNetworkReply>&, qint64 segment, qint64 requestedFrom);
+		int FindConnection (QObject*) const;
+		bool WriteSegmentData (int, bool force);
+		void ProcessSegmentData (int);
+		void FinishConnection (int);
+		void AbortSegments ();
+		void HandleSegmentFailure (int, const QString&);
+		void CheckSegmentsState ();
 	private slots:
 		void handleDataTransferProgress (qint64, qint64);
 		void redirectedConstruction (const QByteArray&);
@@ -104,9 +150,25 @@ namespace CSTP
 		bool handleReadyRead ();
 		void handleFinished ();
 		void handleError ();
+
+		void handleTimer ();
+		void handleWriterDrained ();
+		void handleBudgetAvailable ();
+		void handleWriterFailed ();
+		void handleWriterClosed ();
+
+		void spawnSegments ();
+		void handleSegmentMetaDataChanged ();
+		void handleSegmentReadyRead ();
+		void handleSegmentFinished ();
 	signals:
 		void updateInterface ();
 		void done (bool);
+
+		/** Emitted whenever the segments layout changes, that is, a
+		 * segment is split or finished.
+		 */
+		void segmentsChanged ();
 	};
 }
 }
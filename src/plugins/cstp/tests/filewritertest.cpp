@@ -0,0 +1,252 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "filewritertest.h"
+#include <QtTest>
+#include <QBuffer>
+#include <QTemporaryFile>
+#include "filewriter.h"
+
+QTEST_MAIN (LeechCraft::CSTP::FileWriterTest)
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	namespace
+	{
+		QByteArray MakeData (int size, char seed)
+		{
+			QByteArray result;
+			result.reserve (size);
+			for (int i = 0; i < size; ++i)
+				result.append (static_cast<char> (seed + i % 251));
+			return result;
+		}
+
+		QByteArray ReadFile (const QString& path)
+		{
+			QFile file { path };
+			file.open (QIODevice::ReadOnly);
+			return file.readAll ();
+		}
+
+		std::shared_ptr<QTemporaryFile> MakeFile ()
+		{
+			const auto file = std::make_shared<QTemporaryFile> ();
+			file->open ();
+			return file;
+		}
+
+		void CloseAndWait (FileWriter& writer)
+		{
+			QSignalSpy spy { &writer, SIGNAL (closed ()) };
+			writer.Close ();
+			QTRY_COMPARE (spy.count (), 1);
+		}
+	}
+
+	void FileWriterTest::sequentialWrite ()
+	{
+		const auto file = MakeFile ();
+		QVERIFY (file->isOpen ());
+
+		const auto& data = MakeData (3 * 1024 * 1024 + 17, 'a');
+		QBuffer source;
+		source.setData (data);
+		source.open (QIODevice::ReadOnly);
+
+		FileWriter writer { file, 0, false };
+		qint64 pos = 0;
+		while (!source.atEnd ())
+		{
+			const auto read = writer.Append (source, pos, 100000);
+			QVERIFY (read > 0);
+			pos += read;
+		}
+		QCOMPARE (pos, qint64 { data.size () });
+
+		CloseAndWait (writer);
+		QCOMPARE (writer.GetWritten (), qint64 { data.size () });
+		QCOMPARE (ReadFile (file->fileName ()), data);
+	}
+
+	void FileWriterTest::unalignedStart ()
+	{
+		const auto file = MakeFile ();
+		QVERIFY (file->isOpen ());
+		const auto& prefix = MakeData (1000, 'p');
+		file->write (prefix);
+		file->flush ();
+
+		const auto& data = MakeData (2 * 1024 * 1024, 'x');
+		QBuffer source;
+		source.setData (data);
+		source.open (QIODevice::ReadOnly);
+
+		FileWriter writer { file, 0, false };
+		QCOMPARE (writer.Append (source, prefix.size (), data.size ()), qint64 { data.size () });
+		CloseAndWait (writer);
+
+		QCOMPARE (ReadFile (file->fileName ()), prefix + data);
+	}
+
+	void FileWriterTest::interleavedRegions ()
+	{
+		const auto file = MakeFile ();
+		QVERIFY (file->isOpen ());
+
+		const int half = 1536 * 1024;
+		const auto& first = MakeData (half, 'a');
+		const auto& second = MakeData (half, 'k');
+
+		QBuffer firstSource;
+		firstSource.setData (first);
+		firstSource.open (QIODevice::ReadOnly);
+		QBuffer secondSource;
+		secondSource.setData (second);
+		secondSource.open (QIODevice::ReadOnly);
+
+		FileWriter writer { file, 2 * half, true };
+		qint64 firstPos = 0;
+		qint64 secondPos = half;
+		while (!firstSource.atEnd () || !secondSource.atEnd ())
+		{
+			firstPos += writer.Append (firstSource, firstPos, 4096);
+			secondPos += writer.Append (secondSource, secondPos, 7000);
+		}
+
+		CloseAndWait (writer);
+		QCOMPARE (ReadFile (file->fileName ()), first + second);
+	}
+
+	void FileWriterTest::preallocation ()
+	{
+		const auto file = MakeFile ();
+		QVERIFY (file->isOpen ());
+
+		{
+			FileWriter writer { file, 5000, false };
+			CloseAndWait (writer);
+		}
+		QCOMPARE (QFileInfo { file->fileName () }.size (), qint64 { 0 });
+
+		{
+			FileWriter writer { file, 5000, true };
+			CloseAndWait (writer);
+		}
+		QCOMPARE (QFileInfo { file->fileName () }.size (), qint64 { 5000 });
+	}
+
+	void FileWriterTest::pendingData ()
+	{
+		const auto file = MakeFile ();
+		QVERIFY (file->isOpen ());
+
+		QBuffer source;
+		source.setData (MakeData (100, 'a'));
+		source.open (QIODevice::ReadOnly);
+
+		FileWriter writer { file, 0, false };
+		QCOMPARE (writer.Append (source, 10, 100), qint64 { 100 });
+		QCOMPARE (writer.GetFirstPending (0, 200), qint64 { 10 });
+		QCOMPARE (writer.GetFirstPending (11, 200), qint64 { -1 });
+		QCOMPARE (writer.GetWritten (), qint64 { 0 });
+
+		CloseAndWait (writer);
+		QCOMPARE (writer.GetFirstPending (0, 200), qint64 { -1 });
+		QCOMPARE (writer.GetWritten (), qint64 { 100 });
+	}
+
+	void FileWriterTest::closeSignal ()
+	{
+		const auto file = MakeFile ();
+		QVERIFY (file->isOpen ());
+
+		const auto& data = MakeData (1000, 'c');
+		QBuffer source;
+		source.setData (data);
+		source.open (QIODevice::ReadOnly);
+
+		FileWriter writer { file, 0, false };
+		QSignalSpy spy { &writer, SIGNAL (closed ()) };
+		writer.Append (source, 0, data.size ());
+		writer.Close ();
+
+		QTRY_COMPARE (spy.count (), 1);
+		QCOMPARE (ReadFile (file->fileName ()), data);
+		QCOMPARE (writer.Append (source, 0, 1), qint64 { -1 });
+	}
+
+	void FileWriterTest::sharedFile ()
+	{
+		const auto file = MakeFile ();
+		QVERIFY (file->isOpen ());
+
+		const auto& data = MakeData (1000, 's');
+		QBuffer source;
+		source.setData (data);
+		source.open (QIODevice::ReadOnly);
+
+		FileWriter writer { file, 0, false };
+		writer.Append (source, 0, data.size ());
+		CloseAndWait (writer);
+
+		QVERIFY (file->isOpen ());
+		QVERIFY (file->seek (0));
+		QCOMPARE (file->readAll (), data);
+	}
+
+	void FileWriterTest::destroyWithoutWaiting ()
+	{
+		const auto file = MakeFile ();
+		QVERIFY (file->isOpen ());
+
+		const auto& data = MakeData (3 * 1024 * 1024 + 17, 'd');
+		QBuffer source;
+		source.setData (data);
+		source.open (QIODevice::ReadOnly);
+
+		{
+			FileWriter writer { file, 0, false };
+			QCOMPARE (writer.Append (source, 0, data.size ()), qint64 { data.size () });
+		}
+
+		QTRY_COMPARE (ReadFile (file->fileName ()), data);
+	}
+
+	void FileWriterTest::notOpenedFile ()
+	{
+		const auto file = std::make_shared<QTemporaryFile> ();
+
+		FileWriter writer { file, 0, false };
+		QTRY_VERIFY (!writer.GetErrorString ().isEmpty ());
+	}
+}
+}
@@ -0,0 +1,164 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "segmentmaptest.h"
+#include <QtTest>
+#include "segmentmap.h"
+
+QTEST_MAIN (LeechCraft::CSTP::SegmentMapTest)
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	void SegmentMapTest::initResumed ()
+	{
+		SegmentMap map;
+		QVERIFY (map.IsEmpty ());
+
+		map.Init (1000, 100);
+		QVERIFY (!map.IsEmpty ());
+		QCOMPARE (map.GetTotalSize (), qint64 { 1000 });
+		QCOMPARE (map.GetDone (), qint64 { 100 });
+		QCOMPARE (map.GetRemaining (0), qint64 { 900 });
+		QCOMPARE (map.GetIncompleteSegments (), QList<qint64> { 0 });
+	}
+
+	void SegmentMapTest::advanceClamps ()
+	{
+		SegmentMap map;
+		map.Init (1000, 0);
+		map.Advance (0, 600);
+		map.Advance (0, 600);
+		QCOMPARE (map.GetDone (), qint64 { 1000 });
+		QCOMPARE (map.GetRemaining (0), qint64 { 0 });
+	}
+
+	void SegmentMapTest::rewind ()
+	{
+		SegmentMap map;
+		map.Init (1000, 0);
+		map.Split (0, 100);
+		map.Advance (500, 300);
+
+		map.Rewind (500, 600);
+		QCOMPARE (map.GetSegment (500).Pos_, qint64 { 600 });
+
+		map.Rewind (500, 900);
+		QCOMPARE (map.GetSegment (500).Pos_, qint64 { 600 });
+
+		map.Rewind (500, 0);
+		QCOMPARE (map.GetSegment (500).Pos_, qint64 { 500 });
+		QCOMPARE (map.GetDone (), qint64 { 0 });
+	}
+
+	void SegmentMapTest::splitHalves ()
+	{
+		SegmentMap map;
+		map.Init (1000, 0);
+
+		QCOMPARE (map.Split (0, 100), qint64 { 500 });
+		QCOMPARE (map.GetSegment (0).End_, qint64 { 500 });
+
+		const auto& second = map.GetSegment (500);
+		QCOMPARE (second.Start_, qint64 { 500 });
+		QCOMPARE (second.Pos_, qint64 { 500 });
+		QCOMPARE (second.End_, qint64 { 1000 });
+
+		QCOMPARE (map.Split (500, 100), qint64 { 750 });
+		QCOMPARE (map.GetIncompleteSegments (), (QList<qint64> { 0, 500, 750 }));
+	}
+
+	void SegmentMapTest::splitTooSmall ()
+	{
+		SegmentMap map;
+		map.Init (1000, 0);
+		QCOMPARE (map.Split (0, 600), qint64 { -1 });
+		QCOMPARE (map.Split (42, 1), qint64 { -1 });
+		QCOMPARE (map.GetSegments ().size (), 1);
+	}
+
+	void SegmentMapTest::splitAfterProgress ()
+	{
+		SegmentMap map;
+		map.Init (1000, 200);
+
+		QCOMPARE (map.Split (0, 100), qint64 { 600 });
+		QCOMPARE (map.GetRemaining (0), qint64 { 400 });
+		QCOMPARE (map.GetRemaining (600), qint64 { 400 });
+		QCOMPARE (map.GetDone (), qint64 { 200 });
+	}
+
+	void SegmentMapTest::completion ()
+	{
+		SegmentMap map;
+		QVERIFY (!map.IsComplete ());
+
+		map.Init (1000, 0);
+		map.Split (0, 100);
+		map.Advance (500, 500);
+		QVERIFY (!map.IsComplete ());
+		QCOMPARE (map.GetIncompleteSegments (), QList<qint64> { 0 });
+
+		map.Advance (0, 500);
+		QVERIFY (map.IsComplete ());
+		QCOMPARE (map.GetDone (), qint64 { 1000 });
+	}
+
+	void SegmentMapTest::serialization ()
+	{
+		SegmentMap map;
+		map.Init (1000, 10);
+		map.Split (0, 100);
+		map.Advance (505, 20);
+
+		SegmentMap restored;
+		QVERIFY (restored.Deserialize (map.Serialize ()));
+		QCOMPARE (restored.GetTotalSize (), map.GetTotalSize ());
+		QCOMPARE (restored.GetDone (), map.GetDone ());
+		QCOMPARE (restored.GetIncompleteSegments (), map.GetIncompleteSegments ());
+		QCOMPARE (restored.GetSegment (505).Pos_, qint64 { 525 });
+
+		QVERIFY (restored.Deserialize ({}));
+		QVERIFY (restored.IsEmpty ());
+	}
+
+	void SegmentMapTest::corruptedData ()
+	{
+		SegmentMap map;
+		map.Init (1000, 0);
+		map.Split (0, 100);
+		const auto& data = map.Serialize ();
+
+		SegmentMap restored;
+		QVERIFY (!restored.Deserialize (data.left (data.size () - 4)));
+		QVERIFY (restored.IsEmpty ());
+	}
+}
+}
@@ -0,0 +1,123 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "tokenbuckettest.h"
+#include <QtTest>
+#include "tokenbucket.h"
+
+QTEST_MAIN (LeechCraft::CSTP::TokenBucketTest)
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	void TokenBucketTest::unlimited ()
+	{
+		TokenBucket bucket;
+		QVERIFY (!bucket.IsLimited ());
+		QCOMPARE (bucket.Take (1 << 30, 0), qint64 { 1 << 30 });
+
+		bucket.SetRate (0, 0);
+		bucket.Force (1 << 30, 0);
+		QCOMPARE (bucket.Take (1000, 0), qint64 { 1000 });
+	}
+
+	void TokenBucketTest::startsFull ()
+	{
+		TokenBucket bucket;
+		bucket.SetRate (100 * 1024, 0);
+		QVERIFY (bucket.IsLimited ());
+
+		// Half a second worth of burst.
+		QCOMPARE (bucket.Take (1 << 20, 0), qint64 { 50 * 1024 });
+		QCOMPARE (bucket.Take (1, 0), qint64 { 0 });
+	}
+
+	void TokenBucketTest::refill ()
+	{
+		TokenBucket bucket;
+		bucket.SetRate (100 * 1024, 0);
+		bucket.Take (1 << 20, 0);
+
+		QCOMPARE (bucket.GetAvailable (100), qint64 { 10 * 1024 });
+		QCOMPARE (bucket.Take (4 * 1024, 100), qint64 { 4 * 1024 });
+		QCOMPARE (bucket.GetAvailable (200), qint64 { 16 * 1024 });
+	}
+
+	void TokenBucketTest::capacityCap ()
+	{
+		TokenBucket bucket;
+		bucket.SetRate (1024, 0);
+
+		// The capacity never goes below 16 KiB so that reads aren't too small.
+		QCOMPARE (bucket.GetAvailable (0), qint64 { 16 * 1024 });
+		QCOMPARE (bucket.GetAvailable (1000000), qint64 { 16 * 1024 });
+	}
+
+	void TokenBucketTest::forcedDebt ()
+	{
+		TokenBucket bucket;
+		bucket.SetRate (100 * 1024, 0);
+		bucket.Force (70 * 1024, 0);
+
+		QCOMPARE (bucket.GetAvailable (0), qint64 { 0 });
+		QCOMPARE (bucket.GetAvailable (200), qint64 { 0 });
+		QCOMPARE (bucket.GetAvailable (300), qint64 { 10 * 1024 });
+	}
+
+	void TokenBucketTest::rateChange ()
+	{
+		TokenBucket bucket;
+		bucket.SetRate (100 * 1024, 0);
+		bucket.SetRate (40 * 1024, 0);
+		QCOMPARE (bucket.GetAvailable (0), qint64 { 20 * 1024 });
+
+		bucket.SetRate (0, 0);
+		QVERIFY (!bucket.IsLimited ());
+	}
+
+	void TokenBucketTest::rateMeter ()
+	{
+		RateMeter meter;
+		meter.Update (0);
+		QCOMPARE (meter.GetRate (), 0.);
+
+		meter.Add (1000);
+		meter.Update (1000);
+		QCOMPARE (meter.GetRate (), 300.);
+
+		meter.Add (2000);
+		meter.Update (2000);
+		QCOMPARE (meter.GetRate (), 810.);
+
+		meter.Update (2000);
+		QCOMPARE (meter.GetRate (), 810.);
+	}
+}
+}
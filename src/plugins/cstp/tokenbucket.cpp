@@ -0,0 +1,128 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "tokenbucket.h"
+#include <algorithm>
+#include <limits>
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	namespace
+	{
+		const qint64 MinCapacity = 16 * 1024;
+		const qint64 BurstMSecs = 500;
+	}
+
+	void TokenBucket::SetRate (qint64 bytesPerSecond, qint64 now)
+	{
+		const bool first = LastRefill_ < 0;
+		Refill (now);
+
+		Rate_ = std::max<qint64> (bytesPerSecond, 0);
+		Capacity_ = std::max (Rate_ * BurstMSecs / 1000, MinCapacity);
+		Tokens_ = first ? Capacity_ : std::min (Tokens_, Capacity_);
+	}
+
+	qint64 TokenBucket::GetRate () const
+	{
+		return Rate_;
+	}
+
+	bool TokenBucket::IsLimited () const
+	{
+		return Rate_ > 0;
+	}
+
+	qint64 TokenBucket::GetAvailable (qint64 now)
+	{
+		if (!IsLimited ())
+			return std::numeric_limits<qint64>::max ();
+
+		Refill (now);
+		return std::max<qint64> (Tokens_, 0);
+	}
+
+	qint64 TokenBucket::Take (qint64 wanted, qint64 now)
+	{
+		const auto taken = std::min (wanted, GetAvailable (now));
+		if (IsLimited ())
+			Tokens_ -= taken;
+		return taken;
+	}
+
+	void TokenBucket::Force (qint64 bytes, qint64 now)
+	{
+		if (!IsLimited ())
+			return;
+
+		Refill (now);
+		Tokens_ -= bytes;
+	}
+
+	void TokenBucket::Refill (qint64 now)
+	{
+		if (LastRefill_ >= 0 && now > LastRefill_)
+			Tokens_ = std::min (Capacity_, Tokens_ + (now - LastRefill_) * Rate_ / 1000);
+		if (now > LastRefill_)
+			LastRefill_ = now;
+	}
+
+	void RateMeter::Add (qint64 bytes)
+	{
+		Accumulated_ += bytes;
+	}
+
+	void RateMeter::Update (qint64 now)
+	{
+		if (LastUpdate_ < 0)
+		{
+			LastUpdate_ = now;
+			Accumulated_ = 0;
+			return;
+		}
+
+		const auto elapsed = now - LastUpdate_;
+		if (elapsed <= 0)
+			return;
+
+		const auto current = Accumulated_ * 1000. / elapsed;
+		Rate_ = Rate_ * 0.7 + current * 0.3;
+
+		Accumulated_ = 0;
+		LastUpdate_ = now;
+	}
+
+	double RateMeter::GetRate () const
+	{
+		return Rate_;
+	}
+}
+}
@@ -0,0 +1,88 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QtGlobal>
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	/** A token bucket limiting the rate of data transfers.
+	 *
+	 * Tokens are bytes. The bucket is refilled at the configured rate up
+	 * to its capacity, which allows short bursts. A rate of zero means
+	 * no limit.
+	 *
+	 * Time is passed explicitly as milliseconds from an arbitrary
+	 * monotonic origin.
+	 */
+	class TokenBucket
+	{
+		qint64 Rate_ = 0;
+		qint64 Capacity_ = 0;
+		qint64 Tokens_ = 0;
+		qint64 LastRefill_ = -1;
+	public:
+		void SetRate (qint64 bytesPerSecond, qint64 now);
+		qint64 GetRate () const;
+		bool IsLimited () const;
+
+		/** Returns the number of bytes that can be taken at the moment.
+		 */
+		qint64 GetAvailable (qint64 now);
+
+		/** Takes at most \em wanted bytes from the bucket and returns the
+		 * number of bytes actually taken.
+		 */
+		qint64 Take (qint64 wanted, qint64 now);
+
+		/** Takes \em bytes from the bucket even if there isn't enough
+		 * tokens, so the debt is paid off by the following refills.
+		 */
+		void Force (qint64 bytes, qint64 now);
+	private:
+		void Refill (qint64 now);
+	};
+
+	/** Measures the transfer rate as an exponentially smoothed average.
+	 */
+	class RateMeter
+	{
+		qint64 Accumulated_ = 0;
+		qint64 LastUpdate_ = -1;
+		double Rate_ = 0;
+	public:
+		void Add (qint64 bytes);
+		void Update (qint64 now);
+		double GetRate () const;
+	};
+}
+}
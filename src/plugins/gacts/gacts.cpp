@@ -127,6 +127,14 @@ namespace GActs
 		RegisterChildren (sh, e);
 	}
 
+	QList<EntityRoutingRule> Plugin::GetEntityRoutingRules () const
+	{
+		EntityRoutingRule rule;
+		rule.Mimes_ << "x-leechcraft/global-action-register"
+				<< "x-leechcraft/global-action-unregister";
+		return { rule };
+	}
+
 	void Plugin::RegisterChildren (QxtGlobalShortcut *sh, const Entity& e)
 	{
 		for (const auto& seqVar : e.Additional_ ["AltShortcuts"].toList ())
@@ -32,6 +32,7 @@
 #include <QObject>
 #include <interfaces/iinfo.h>
 #include <interfaces/ientityhandler.h>
+#include <interfaces/ientityroutingrules.h>
 
 class QxtGlobalShortcut;
 
@@ -42,9 +43,10 @@ namespace GActs
 	class Plugin : public QObject
 				 , public IInfo
 				 , public IEntityHandler
+				 , public IEntityRoutingRules
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IEntityHandler)
+		Q_INTERFACES (IInfo IEntityHandler IEntityRoutingRules)
 
 		LC_PLUGIN_METADATA ("org.LeechCraft.GActs")
 
@@ -60,6 +62,8 @@ namespace GActs
 
 		EntityTestHandleResult CouldHandle (const Entity&) const;
 		void Handle (Entity);
+
+		QList<EntityRoutingRule> GetEntityRoutingRules () const;
 	private:
 		void RegisterChildren (QxtGlobalShortcut*, const Entity&);
 	private slots:
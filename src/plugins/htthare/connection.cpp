@@ -35,14 +35,23 @@ namespace LeechCraft
 {
 namespace HttHare
 {
+	namespace
+	{
+		// Big enough to hold a few pipelined requests.
+		const size_t MaxBufferedRequests = 16 * 1024;
+	}
+
 	Connection::Connection (boost::asio::io_service& service,
-			const StorageManager& stMgr, IconResolver *resolver, TrManager *trMgr)
+			const StorageManager& stMgr, IconResolver *resolver, TrManager *trMgr,
+			const KeepAliveParams& keepAlive)
 	: Strand_ { service }
 	, Socket_ { service }
+	, IdleTimer_ { service }
 	, StorageMgr_ (stMgr)
 	, IconResolver_ { resolver }
 	, TrManager_ { trMgr }
-	, Buf_ { 2 * 1024 }
+	, KeepAlive_ (keepAlive)
+	, Buf_ { MaxBufferedRequests }
 	{
 	}
 
@@ -71,9 +80,29 @@ namespace HttHare
 		return StorageMgr_;
 	}
 
+	bool Connection::CanKeepAlive () const
+	{
+		return ServedRequests_ + 1 < KeepAlive_.MaxRequests_;
+	}
+
+	const KeepAliveParams& Connection::GetKeepAliveParams () const
+	{
+		return KeepAlive_;
+	}
+
 	void Connection::Start ()
 	{
 		auto conn = shared_from_this ();
+
+		// Only idle keep-alive connections are timed out, the very first
+		// request is waited for as long as it takes, as before.
+		if (ServedRequests_)
+		{
+			IdleTimer_.expires_from_now (KeepAlive_.Timeout_);
+			IdleTimer_.async_wait (Strand_.wrap ([conn] (const boost::system::error_code& ec)
+						{ conn->HandleIdleTimeout (ec); }));
+		}
+
 		boost::asio::async_read_until (Socket_,
 				Buf_,
 				std::string { "\r\n\r\n" },
@@ -81,8 +110,35 @@ namespace HttHare
 					{ conn->HandleHeader (ec, transferred); }));
 	}
 
-	void Connection::HandleHeader (const boost::system::error_code&, unsigned long transferred)
+	void Connection::FinishRequest (bool keepAlive)
 	{
+		auto conn = shared_from_this ();
+		Strand_.dispatch ([conn, keepAlive]
+				{
+					++conn->ServedRequests_;
+
+					if (keepAlive && conn->Socket_.is_open ())
+						conn->Start ();
+					else
+						conn->Close ();
+				});
+	}
+
+	void Connection::HandleHeader (const boost::system::error_code& ec, unsigned long transferred)
+	{
+		boost::system::error_code iec;
+		IdleTimer_.cancel (iec);
+
+		if (ec)
+		{
+			if (ec != boost::asio::error::eof &&
+					ec != boost::asio::error::operation_aborted)
+				qWarning () << Q_FUNC_INFO
+						<< ec.message ().c_str ();
+			Close ();
+			return;
+		}
+
 		QByteArray data;
 		data.resize (transferred);
 
@@ -91,5 +147,22 @@ namespace HttHare
 
 		RequestHandler { shared_from_this () } (data);
 	}
+
+	void Connection::HandleIdleTimeout (const boost::system::error_code& ec)
+	{
+		if (ec == boost::asio::error::operation_aborted)
+			return;
+
+		// Cancels the pending read, which then releases the connection.
+		Close ();
+	}
+
+	void Connection::Close ()
+	{
+		boost::system::error_code ec;
+		IdleTimer_.cancel (ec);
+		Socket_.shutdown (boost::asio::socket_base::shutdown_both, ec);
+		Socket_.close (ec);
+	}
 }
 }
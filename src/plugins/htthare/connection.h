@@ -30,7 +30,9 @@
 #pragma once
 
 #include <memory>
+#include <chrono>
 #include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 namespace LeechCraft
 {
@@ -40,18 +42,29 @@ namespace HttHare
 	class IconResolver;
 	class TrManager;
 
+	struct KeepAliveParams
+	{
+		std::chrono::seconds Timeout_;
+		int MaxRequests_;
+	};
+
 	class Connection : public std::enable_shared_from_this<Connection>
 	{
 		boost::asio::io_service::strand Strand_;
 		boost::asio::ip::tcp::socket Socket_;
+		boost::asio::steady_timer IdleTimer_;
 
 		const StorageManager& StorageMgr_;
 		IconResolver * const IconResolver_;
 		TrManager * const TrManager_;
 
+		const KeepAliveParams KeepAlive_;
+		int ServedRequests_ = 0;
+
 		boost::asio::streambuf Buf_;
 	public:
-		Connection (boost::asio::io_service&, const StorageManager&, IconResolver*, TrManager*);
+		Connection (boost::asio::io_service&, const StorageManager&,
+				IconResolver*, TrManager*, const KeepAliveParams&);
 
 		Connection (const Connection&) = delete;
 		Connection& operator= (const Connection&) = delete;
@@ -63,9 +76,27 @@ namespace HttHare
 
 		const StorageManager& GetStorageManager () const;
 
+		/** Returns whether the connection may be kept open after the
+		 * response to the current request.
+		 */
+		bool CanKeepAlive () const;
+		const KeepAliveParams& GetKeepAliveParams () const;
+
+		/** Waits for the next request on this connection.
+		 *
+		 * Requests that are already buffered (pipelined by the client)
+		 * are handled right away.
+		 */
 		void Start ();
+
+		/** Should be called by the request handler once the response is
+		 * completely written.
+		 */
+		void FinishRequest (bool keepAlive);
 	private:
 		void HandleHeader (const boost::system::error_code&, unsigned long);
+		void HandleIdleTimeout (const boost::system::error_code&);
+		void Close ();
 	};
 
 	typedef std::shared_ptr<Connection> Connection_ptr;
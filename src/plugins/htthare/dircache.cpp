@@ -0,0 +1,95 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "dircache.h"
+#include <algorithm>
+#include <QDir>
+#include <QFileInfo>
+#include "mimecache.h"
+
+namespace LeechCraft
+{
+namespace HttHare
+{
+	namespace
+	{
+		// The cost of a listing is the number of its entries.
+		const int MaxCachedEntries = 200 * 1000;
+	}
+
+	DirCache::DirCache (MimeCache& mimes)
+	: Mimes_ (mimes)
+	, Cache_ { MaxCachedEntries }
+	{
+	}
+
+	DirListing_ptr DirCache::GetListing (const QFileInfo& fi)
+	{
+		const auto& path = fi.absoluteFilePath ();
+		const auto& mtime = fi.lastModified ();
+
+		{
+			QMutexLocker locker { &Mutex_ };
+			if (const auto item = Cache_.object (path))
+				if (item->MTime_ == mtime)
+					return item->Listing_;
+		}
+
+		const auto& now = QDateTime::currentDateTime ();
+		const auto& listing = Scan (path);
+
+		// A directory modified during the same second it was scanned in
+		// may have changed without its mtime changing, so don't cache it.
+		if (mtime.secsTo (now) < 2)
+			return listing;
+
+		QMutexLocker locker { &Mutex_ };
+		Cache_.insert (path, new Item { mtime, listing }, std::max (listing->size (), 1));
+		return listing;
+	}
+
+	DirListing_ptr DirCache::Scan (const QString& path)
+	{
+		const auto& entries = QDir { path }
+				.entryInfoList (QDir::AllEntries | QDir::NoDot,
+						QDir::Name | QDir::DirsFirst);
+
+		std::shared_ptr<QList<DirEntry>> result { new QList<DirEntry> };
+		result->reserve (entries.size ());
+		for (const auto& entry : entries)
+			result->append ({
+					entry.fileName (),
+					entry.size (),
+					entry.created (),
+					Mimes_.GetMime (entry)
+				});
+		return result;
+	}
+}
+}
@@ -0,0 +1,87 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QCache>
+#include <QDateTime>
+#include <QList>
+#include <QMutex>
+
+class QFileInfo;
+
+namespace LeechCraft
+{
+namespace HttHare
+{
+	class MimeCache;
+
+	struct DirEntry
+	{
+		QString Name_;
+		qint64 Size_;
+		QDateTime Created_;
+		QByteArray Mime_;
+	};
+
+	typedef std::shared_ptr<const QList<DirEntry>> DirListing_ptr;
+
+	/** Caches directory listings along with the MIME types of the
+	 * entries.
+	 *
+	 * A listing is rescanned once the modification time of the
+	 * directory changes, so entries that are modified in place keep
+	 * their old size until something is added, removed or renamed. The
+	 * class is thread-safe.
+	 */
+	class DirCache
+	{
+		MimeCache& Mimes_;
+
+		struct Item
+		{
+			QDateTime MTime_;
+			DirListing_ptr Listing_;
+		};
+
+		QMutex Mutex_;
+		QCache<QString, Item> Cache_;
+	public:
+		DirCache (MimeCache&);
+
+		DirCache (const DirCache&) = delete;
+		DirCache& operator= (const DirCache&) = delete;
+
+		DirListing_ptr GetListing (const QFileInfo&);
+	private:
+		DirListing_ptr Scan (const QString&);
+	};
+}
+}
@@ -60,6 +60,8 @@ namespace HttHare
 
 		XmlSettingsManager::Instance ().RegisterObject ("EnableServer",
 				this, "handleEnableServerChanged");
+		XmlSettingsManager::Instance ().RegisterObject (QList<QByteArray> { "KeepAliveTimeout", "MaxKeepAliveRequests" },
+				this, "reapplyAddresses");
 		handleEnableServerChanged ();
 	}
 
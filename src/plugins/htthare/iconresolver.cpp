@@ -28,34 +28,130 @@
  **********************************************************************/
 
 #include "iconresolver.h"
-#include <QImage>
+#include <algorithm>
+#include <QBuffer>
 #include <QIcon>
+#include <QPainter>
+#include <QStringList>
 #include <QtDebug>
-#include <util/util.h>
 
 namespace LeechCraft
 {
 namespace HttHare
 {
-	IconResolver::IconResolver (QObject *parent)
+	IconResolver::IconResolver (int iconSize, QObject *parent)
 	: QObject (parent)
+	, IconSize_ { iconSize }
 	{
 	}
 
-	void IconResolver::resolveMime (QString mimetype, QByteArray& image, int dim)
+	QString IconResolver::GetClassName (QString mime)
 	{
-		mimetype.replace ('/', '-');
-		auto icon = QIcon::fromTheme (mimetype);
-		if (icon.isNull ())
+		return mime.replace ('/', '_')
+				.replace ('-', '_')
+				.replace ('.', '_')
+				.replace ('+', '_');
+	}
+
+	void IconResolver::RequestIcons (const QList<QByteArray>& mimes)
+	{
+		QStringList toResolve;
+
+		{
+			QMutexLocker locker { &Mutex_ };
+			for (const auto& mimeBa : mimes)
+			{
+				const auto& mime = QString::fromLatin1 (mimeBa);
+				if (Positions_.contains (mime) || Pending_.contains (mime))
+					continue;
+
+				Pending_ << mime;
+				toResolve << mime;
+			}
+		}
+
+		if (toResolve.isEmpty ())
+			return;
+
+		QMetaObject::invokeMethod (this,
+				"resolveMimes",
+				Qt::QueuedConnection,
+				Q_ARG (QStringList, toResolve));
+	}
+
+	int IconResolver::GetVersion () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Icons_.size ();
+	}
+
+	QByteArray IconResolver::GetStylesheet (const QString& imageUrl) const
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		QByteArray css;
+		for (auto i = Positions_.begin (); i != Positions_.end (); ++i)
 		{
-			mimetype.replace ("x-", "");
-			icon = QIcon::fromTheme (mimetype);
+			css += "." + GetClassName (i.key ()).toLatin1 () + " {";
+			css += "background-image: url('" + imageUrl.toUtf8 () + "');";
+			css += "background-repeat: no-repeat;";
+			css += "background-position: 0 -" + QByteArray::number (i.value () * IconSize_) + "px;";
+			css += "padding-left: " + QByteArray::number (IconSize_ + 4) + "px;";
+			css += "}\n";
 		}
+		return css;
+	}
+
+	QByteArray IconResolver::GetImage () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		if (ImageVersion_ == Icons_.size ())
+			return Image_;
+
+		QImage sprite { IconSize_, std::max (IconSize_ * Icons_.size (), 1), QImage::Format_ARGB32 };
+		sprite.fill (Qt::transparent);
+		{
+			QPainter p { &sprite };
+			for (int i = 0; i < Icons_.size (); ++i)
+				p.drawImage (0, i * IconSize_, Icons_.at (i));
+		}
+
+		QBuffer buf;
+		buf.open (QIODevice::WriteOnly);
+		sprite.save (&buf, "PNG");
+
+		ImageVersion_ = Icons_.size ();
+		Image_ = buf.data ();
+		return Image_;
+	}
+
+	void IconResolver::resolveMimes (const QStringList& mimes)
+	{
+		QList<QImage> images;
+		for (auto mimetype : mimes)
+		{
+			mimetype.replace ('/', '-');
+			auto icon = QIcon::fromTheme (mimetype);
+			if (icon.isNull ())
+			{
+				mimetype.replace ("x-", "");
+				icon = QIcon::fromTheme (mimetype);
+			}
 
-		if (icon.isNull ())
-			icon = QIcon::fromTheme ("application-octet-stream");
+			if (icon.isNull ())
+				icon = QIcon::fromTheme ("application-octet-stream");
 
-		image = Util::GetAsBase64Src (icon.pixmap (dim, dim).toImage ()).toLatin1 ();
+			images << icon.pixmap (IconSize_, IconSize_).toImage ()
+					.scaled (IconSize_, IconSize_, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+		}
+
+		QMutexLocker locker { &Mutex_ };
+		for (int i = 0; i < mimes.size (); ++i)
+		{
+			Pending_.remove (mimes.at (i));
+			Positions_ [mimes.at (i)] = Icons_.size ();
+			Icons_ << images.at (i);
+		}
 	}
 }
 }
@@ -30,20 +30,54 @@
 #pragma once
 
 #include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QImage>
+#include <QMutex>
 
-class QImage;
+class QStringList;
 
 namespace LeechCraft
 {
 namespace HttHare
 {
+	/** Resolves icons for MIME types and combines them into a sprite.
+	 *
+	 * The object lives in the GUI thread, but the public methods may be
+	 * called from any thread. Icons are resolved asynchronously, and
+	 * each newly resolved icon bumps the version of the sprite, which is
+	 * meant to be used in the sprite and stylesheet URLs so that they
+	 * may be cached by the clients forever.
+	 */
 	class IconResolver : public QObject
 	{
 		Q_OBJECT
+
+		const int IconSize_;
+
+		mutable QMutex Mutex_;
+		QHash<QString, int> Positions_;
+		QSet<QString> Pending_;
+		QList<QImage> Icons_;
+
+		mutable int ImageVersion_ = -1;
+		mutable QByteArray Image_;
 	public:
-		IconResolver (QObject* = 0);
-	public slots:
-		void resolveMime (QString, QByteArray&, int);
+		IconResolver (int iconSize = 16, QObject* = 0);
+
+		static QString GetClassName (QString mime);
+
+		/** Schedules resolving the icons for the given MIME types
+		 * unless they are already known.
+		 */
+		void RequestIcons (const QList<QByteArray>& mimes);
+
+		int GetVersion () const;
+		QByteArray GetStylesheet (const QString& imageUrl) const;
+		QByteArray GetImage () const;
+	private slots:
+		void resolveMimes (const QStringList&);
 	};
 }
 }
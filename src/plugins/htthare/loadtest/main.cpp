@@ -0,0 +1,402 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+
+namespace
+{
+	namespace bpo = boost::program_options;
+	namespace ip = boost::asio::ip;
+
+	typedef std::chrono::steady_clock Clock_t;
+
+	struct Options
+	{
+		std::string Host_;
+		std::string Port_;
+		std::vector<std::string> Paths_;
+
+		int Connections_;
+		int Duration_;
+		int Requests_;
+		int Pipeline_;
+		bool KeepAlive_;
+	};
+
+	void ShowHelp (const bpo::options_description& desc)
+	{
+		std::cout << "LeechCraft (http://leechcraft.org)" << std::endl;
+		std::cout << std::endl;
+		std::cout << "This is a load testing tool for the HTThare HTTP server." << std::endl;
+		std::cout << std::endl;
+		std::cout << desc << std::endl;
+		std::exit (3);
+	}
+
+	Options ParseOptions (int argc, char **argv)
+	{
+		bpo::options_description desc ("Known options");
+		desc.add_options ()
+				("host", bpo::value<std::string> ()->default_value ("127.0.0.1"), "the host to connect to")
+				("port", bpo::value<std::string> ()->default_value ("14801"), "the port to connect to")
+				("path", bpo::value<std::vector<std::string>> (), "the path to request, may be given several times")
+				("connections,c", bpo::value<int> ()->default_value (8), "the number of concurrent connections")
+				("duration,d", bpo::value<int> ()->default_value (10), "the test duration in seconds")
+				("requests,n", bpo::value<int> ()->default_value (0), "stop after this many requests per connection (0 means no limit)")
+				("pipeline,p", bpo::value<int> ()->default_value (1), "the number of pipelined requests per connection")
+				("no-keepalive", "open a new connection for each request")
+				("help", "show help message");
+
+		bpo::positional_options_description pos;
+		pos.add ("path", -1);
+
+		bpo::variables_map vm;
+		try
+		{
+			bpo::store (bpo::command_line_parser (argc, argv)
+					.options (desc)
+					.positional (pos)
+					.run (), vm);
+			bpo::notify (vm);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what () << std::endl;
+			ShowHelp (desc);
+		}
+
+		if (vm.count ("help"))
+			ShowHelp (desc);
+
+		Options result
+		{
+			vm ["host"].as<std::string> (),
+			vm ["port"].as<std::string> (),
+			vm.count ("path") ?
+					vm ["path"].as<std::vector<std::string>> () :
+					std::vector<std::string> { "/" },
+			std::max (1, vm ["connections"].as<int> ()),
+			std::max (1, vm ["duration"].as<int> ()),
+			std::max (0, vm ["requests"].as<int> ()),
+			std::max (1, vm ["pipeline"].as<int> ()),
+			!vm.count ("no-keepalive")
+		};
+
+		if (!result.KeepAlive_)
+			result.Pipeline_ = 1;
+
+		return result;
+	}
+
+	struct Stats
+	{
+		uint64_t Requests_ = 0;
+		uint64_t Errors_ = 0;
+		uint64_t Bytes_ = 0;
+		uint64_t Reconnects_ = 0;
+		std::vector<double> Latencies_;
+
+		void Merge (const Stats& other)
+		{
+			Requests_ += other.Requests_;
+			Errors_ += other.Errors_;
+			Bytes_ += other.Bytes_;
+			Reconnects_ += other.Reconnects_;
+			Latencies_.insert (Latencies_.end (),
+					other.Latencies_.begin (), other.Latencies_.end ());
+		}
+	};
+
+	struct Response
+	{
+		int Status_ = 0;
+		bool Close_ = false;
+		uint64_t Size_ = 0;
+	};
+
+	std::string ToLower (std::string str)
+	{
+		std::transform (str.begin (), str.end (), str.begin (),
+				[] (char c) { return static_cast<char> (std::tolower (c)); });
+		return str;
+	}
+
+	class Worker
+	{
+		const Options& Opts_;
+		const ip::tcp::resolver::iterator& Endpoints_;
+
+		boost::asio::io_service IoService_;
+		ip::tcp::socket Socket_ { IoService_ };
+		boost::asio::streambuf Buf_;
+
+		size_t NextPath_;
+	public:
+		Stats Stats_;
+
+		Worker (const Options& opts, const ip::tcp::resolver::iterator& endpoints, size_t idx)
+		: Opts_ (opts)
+		, Endpoints_ (endpoints)
+		, NextPath_ { idx }
+		{
+		}
+
+		void Run (const std::atomic<bool>& stop)
+		{
+			int sent = 0;
+			while (!stop && (!Opts_.Requests_ || sent < Opts_.Requests_))
+			{
+				try
+				{
+					if (!Socket_.is_open ())
+						Connect ();
+
+					auto batch = Opts_.Pipeline_;
+					if (Opts_.Requests_)
+						batch = std::min (batch, Opts_.Requests_ - sent);
+					sent += batch;
+
+					const auto start = Clock_t::now ();
+					SendBatch (batch);
+
+					for (int i = 0; i < batch; ++i)
+					{
+						const auto& resp = ReadResponse ();
+						const std::chrono::duration<double, std::milli> elapsed = Clock_t::now () - start;
+
+						++Stats_.Requests_;
+						Stats_.Bytes_ += resp.Size_;
+						Stats_.Latencies_.push_back (elapsed.count ());
+						if (resp.Status_ >= 400)
+							++Stats_.Errors_;
+
+						if (resp.Close_)
+						{
+							// The rest of the batch is lost, count it as failed.
+							Stats_.Errors_ += batch - i - 1;
+							Disconnect ();
+							break;
+						}
+					}
+
+					if (!Opts_.KeepAlive_)
+						Disconnect ();
+				}
+				catch (const std::exception&)
+				{
+					++Stats_.Errors_;
+					Disconnect ();
+				}
+			}
+		}
+	private:
+		void Connect ()
+		{
+			boost::asio::connect (Socket_, Endpoints_);
+			Socket_.set_option (ip::tcp::no_delay (true));
+			++Stats_.Reconnects_;
+		}
+
+		void Disconnect ()
+		{
+			boost::system::error_code ec;
+			Socket_.close (ec);
+			Buf_.consume (Buf_.size ());
+		}
+
+		void SendBatch (int count)
+		{
+			std::string requests;
+			for (int i = 0; i < count; ++i)
+			{
+				const auto& path = Opts_.Paths_ [NextPath_++ % Opts_.Paths_.size ()];
+				requests += "GET " + path + " HTTP/1.1\r\n";
+				requests += "Host: " + Opts_.Host_ + "\r\n";
+				requests += Opts_.KeepAlive_ ?
+						"Connection: keep-alive\r\n" :
+						"Connection: close\r\n";
+				requests += "\r\n";
+			}
+
+			boost::asio::write (Socket_, boost::asio::buffer (requests));
+		}
+
+		Response ReadResponse ()
+		{
+			const auto headerSize = boost::asio::read_until (Socket_, Buf_, "\r\n\r\n");
+
+			std::string header (boost::asio::buffers_begin (Buf_.data ()),
+					boost::asio::buffers_begin (Buf_.data ()) + headerSize);
+			Buf_.consume (headerSize);
+
+			Response resp;
+
+			std::istringstream istr { header };
+			std::string line;
+			std::getline (istr, line);
+			const auto spacePos = line.find (' ');
+			if (line.compare (0, 5, "HTTP/") || spacePos == std::string::npos)
+				throw std::runtime_error { "malformed status line" };
+			resp.Status_ = std::atoi (line.c_str () + spacePos + 1);
+
+			bool hasLength = false;
+			while (std::getline (istr, line))
+			{
+				const auto colonPos = line.find (':');
+				if (colonPos == std::string::npos)
+					continue;
+
+				const auto& name = ToLower (line.substr (0, colonPos));
+				auto value = line.substr (colonPos + 1);
+				value.erase (0, value.find_first_not_of (" \t"));
+				value.erase (value.find_last_not_of (" \t\r") + 1);
+
+				if (name == "content-length")
+				{
+					resp.Size_ = std::stoull (value);
+					hasLength = true;
+				}
+				else if (name == "connection")
+					resp.Close_ = ToLower (value) == "close";
+			}
+
+			if (!hasLength)
+				throw std::runtime_error { "responses without Content-Length are not supported" };
+
+			if (Buf_.size () < resp.Size_)
+				boost::asio::read (Socket_, Buf_,
+						boost::asio::transfer_exactly (resp.Size_ - Buf_.size ()));
+			Buf_.consume (resp.Size_);
+
+			return resp;
+		}
+	};
+
+	double Percentile (const std::vector<double>& sorted, double p)
+	{
+		if (sorted.empty ())
+			return 0;
+
+		const auto idx = static_cast<size_t> (p * (sorted.size () - 1) + 0.5);
+		return sorted [std::min (idx, sorted.size () - 1)];
+	}
+
+	void Report (Stats stats, double seconds)
+	{
+		auto& lats = stats.Latencies_;
+		std::sort (lats.begin (), lats.end ());
+
+		std::cout << std::fixed << std::setprecision (2);
+		std::cout << "Requests:      " << stats.Requests_ << " in " << seconds << " s" << std::endl;
+		std::cout << "Errors:        " << stats.Errors_ << std::endl;
+		std::cout << "Connections:   " << stats.Reconnects_ << std::endl;
+		std::cout << "Transferred:   " << stats.Bytes_ / 1024.0 / 1024.0 << " MiB" << std::endl;
+		std::cout << "Requests/sec:  " << stats.Requests_ / seconds << std::endl;
+		std::cout << "Latency, ms:   "
+				<< "p50 " << Percentile (lats, 0.5)
+				<< ", p90 " << Percentile (lats, 0.9)
+				<< ", p99 " << Percentile (lats, 0.99)
+				<< ", max " << (lats.empty () ? 0 : lats.back ())
+				<< std::endl;
+	}
+}
+
+int main (int argc, char **argv)
+{
+	const auto& opts = ParseOptions (argc, argv);
+
+	boost::asio::io_service service;
+	ip::tcp::resolver::iterator endpoints;
+	try
+	{
+		endpoints = ip::tcp::resolver { service }.resolve ({ opts.Host_, opts.Port_ });
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "cannot resolve " << opts.Host_ << ": " << e.what () << std::endl;
+		return 1;
+	}
+
+	std::cout << "Running " << opts.Duration_ << " s test against "
+			<< opts.Host_ << ":" << opts.Port_
+			<< " with " << opts.Connections_ << " connections, pipeline depth " << opts.Pipeline_
+			<< (opts.KeepAlive_ ? "" : ", no keep-alive")
+			<< std::endl;
+
+	std::atomic<bool> stop { false };
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < opts.Connections_; ++i)
+		workers.emplace_back (new Worker { opts, endpoints, static_cast<size_t> (i) });
+
+	const auto start = Clock_t::now ();
+	for (const auto& worker : workers)
+	{
+		auto w = worker.get ();
+		threads.emplace_back ([w, &stop] { w->Run (stop); });
+	}
+
+	std::thread timer { [&opts, &stop]
+			{
+				const auto deadline = Clock_t::now () + std::chrono::seconds { opts.Duration_ };
+				while (!stop && Clock_t::now () < deadline)
+					std::this_thread::sleep_for (std::chrono::milliseconds { 50 });
+				stop = true;
+			} };
+
+	for (auto& thread : threads)
+		thread.join ();
+	const std::chrono::duration<double> elapsed = Clock_t::now () - start;
+
+	stop = true;
+	timer.join ();
+
+	Stats total;
+	for (const auto& worker : workers)
+		total.Merge (worker->Stats_);
+
+	Report (total, elapsed.count ());
+
+	return total.Errors_ ? 2 : 0;
+}
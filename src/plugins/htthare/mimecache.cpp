@@ -0,0 +1,72 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "mimecache.h"
+#include <QFileInfo>
+
+namespace LeechCraft
+{
+namespace HttHare
+{
+	namespace
+	{
+		const int MaxCachedMimes = 100 * 1000;
+	}
+
+	MimeCache::MimeCache ()
+	: Cache_ { MaxCachedMimes }
+	{
+	}
+
+	QByteArray MimeCache::GetMime (const QFileInfo& fi)
+	{
+		const auto& path = fi.absoluteFilePath ();
+		const auto& mtime = fi.lastModified ();
+		const auto size = fi.size ();
+
+		{
+			QMutexLocker locker { &Mutex_ };
+			if (const auto item = Cache_.object (path))
+				if (item->MTime_ == mtime && item->Size_ == size)
+					return item->Mime_;
+		}
+
+		QByteArray mime;
+		{
+			// libmagic handles aren't reentrant.
+			QMutexLocker locker { &DetectorMutex_ };
+			mime = Detector_ (path);
+		}
+
+		QMutexLocker locker { &Mutex_ };
+		Cache_.insert (path, new Item { mtime, size, mime });
+		return mime;
+	}
+}
+}
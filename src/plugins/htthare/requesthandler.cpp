@@ -46,10 +46,8 @@
 #include <QString>
 #include <QtDebug>
 #include <QFileInfo>
-#include <QDir>
 #include <QDateTime>
 #include <util/util.h>
-#include <util/sys/mimedetector.h>
 #include "connection.h"
 #include "storagemanager.h"
 #include "iconresolver.h"
@@ -81,6 +79,8 @@ namespace HttHare
 		if (req.size () < 2)
 			return ErrorResponse (400, "Bad Request");
 
+		const auto& version = req.value (2).toUpper ();
+
 		const auto& verb = req.at (0).toLower ();
 		Url_ = QUrl::fromEncoded (req.at (1));
 
@@ -92,6 +92,8 @@ namespace HttHare
 			Headers_ [line.left (colonPos)] = line.mid (colonPos + 1).trimmed ();
 		}
 
+		KeepAlive_ = ShouldKeepAlive (version);
+
 #ifdef QT_DEBUG
 		qDebug () << Q_FUNC_INFO << "got request";
 		qDebug () << req << Url_;
@@ -126,6 +128,43 @@ namespace HttHare
 		return mgr->Translate (locales, "LeechCraft::HttHare::RequestHandler", msg);
 	}
 
+	QString RequestHandler::GetHeader (const QString& name) const
+	{
+		for (auto i = Headers_.begin (); i != Headers_.end (); ++i)
+			if (!i.key ().compare (name, Qt::CaseInsensitive))
+				return i.value ();
+
+		return {};
+	}
+
+	bool RequestHandler::ShouldKeepAlive (const QByteArray& version) const
+	{
+		if (!Conn_->CanKeepAlive ())
+			return false;
+
+		// We never read request bodies, so whatever follows the headers
+		// can't be treated as the next request.
+		if (GetHeader ("Content-Length").toLongLong () > 0 ||
+				!GetHeader ("Transfer-Encoding").isEmpty ())
+			return false;
+
+		const auto& connTokens = GetHeader ("Connection").toLower ().split (',');
+		auto hasToken = [&connTokens] (const QString& token)
+		{
+			for (const auto& item : connTokens)
+				if (item.trimmed () == token)
+					return true;
+			return false;
+		};
+
+		if (version == "HTTP/1.1")
+			return !hasToken ("close");
+		else if (version == "HTTP/1.0")
+			return hasToken ("keep-alive");
+		else
+			return false;
+	}
+
 	void RequestHandler::ErrorResponse (int code,
 			const QByteArray& reason, const QByteArray& full)
 	{
@@ -148,76 +187,49 @@ namespace HttHare
 
 	namespace
 	{
-		QString NormalizeClass (QString mime)
-		{
-			return mime.replace ('/', '_')
-					.replace ('-', '_')
-					.replace ('.', '_')
-					.replace ('+', '_');
-		}
-
-		const auto IconSize = 16;
+		// Requests to this prefix are served by HTThare itself instead of
+		// the storage.
+		const QString AssetsPrefix = "/.htthare/";
+		const QString IconsStylesheet = "icons.css";
+		const QString IconsImage = "icons.png";
+
+		// Assets URLs are versioned, so they never change.
+		const QByteArray AssetsCacheControl = "public, max-age=31536000";
 	}
 
-	QByteArray RequestHandler::MakeDirResponse (const QFileInfo& fi, const QString& path, const QUrl& url)
+	QByteArray RequestHandler::MakeDirResponse (const QFileInfo& fi, const QUrl& url)
 	{
-		const auto& entries = QDir { path }
-				.entryInfoList (QDir::AllEntries | QDir::NoDot,
-						QDir::Name | QDir::DirsFirst);
+		const auto& entries = Conn_->GetStorageManager ().GetListing (fi);
 
-		struct MimeInfo
-		{
-			QString MimeType_;
-		};
-		QHash<QString, QByteArray> mimeCache;
-		QList<MimeInfo> mimes;
-		Util::MimeDetector detector;
-		for (const auto& entry : entries)
-		{
-			const auto& type = detector (entry.filePath ());
+		QList<QByteArray> mimes;
+		for (const auto& entry : *entries)
+			if (!mimes.contains (entry.Mime_))
+				mimes << entry.Mime_;
 
-			if (!mimeCache.contains (type))
-			{
-				QByteArray image;
-				QMetaObject::invokeMethod (Conn_->GetIconResolver (),
-						"resolveMime",
-						Qt::BlockingQueuedConnection,
-						Q_ARG (QString, type),
-						Q_ARG (QByteArray&, image),
-						Q_ARG (int, IconSize));
-				mimeCache [type] = image;
-			}
-
-			mimes.append ({ type });
-		}
+		// Icons that aren't resolved yet will show up after a reload.
+		const auto resolver = Conn_->GetIconResolver ();
+		resolver->RequestIcons (mimes);
+		const auto& cssUrl = AssetsPrefix + IconsStylesheet +
+				"?v=" + QString::number (resolver->GetVersion ());
 
 		QString result;
-		result += "<html><head><title>" + fi.fileName () + "</title><style>";
-		for (auto pos = mimeCache.begin (); pos != mimeCache.end (); ++pos)
-		{
-			result += "." + NormalizeClass (pos.key ()) + " {";
-			result += "background-image: url('" + pos.value () + "');";
-			result += "background-repeat: no-repeat;";
-			result += "padding-left: " + QString::number (IconSize + 4) + ";";
-			result += "}";
-		}
-		result += "</style></head><body><h1>" + Tr ("Listing of %1").arg (url.toString ()) + "</h1>";
+		result += "<html><head><title>" + fi.fileName () + "</title>";
+		result += "<link rel='stylesheet' type='text/css' href='" + cssUrl + "'/>";
+		result += "</head><body><h1>" + Tr ("Listing of %1").arg (url.toString ()) + "</h1>";
 		result += "<table style='width: 100%'><tr>";
 		result += QString ("<th style='width: 60%'>%1</th><th style='width: 20%'>%2</th><th style='width: 20%'>%3</th>")
 					.arg (Tr ("Name"))
 					.arg (Tr ("Size"))
 					.arg (Tr ("Created"));
 
-		for (int i = 0; i < entries.size (); ++i)
+		for (const auto& item : *entries)
 		{
-			const auto& item = entries.at (i);
+			auto link = QUrl::toPercentEncoding (item.Name_, {}, "'");
 
-			auto link = QUrl::toPercentEncoding (item.fileName (), {}, "'");
-
-			result += "<tr><td class=" + NormalizeClass (mimes.at (i).MimeType_) + "><a href='";
-			result += link + "'>" + item.fileName () + "</a></td>";
-			result += "<td>" + Util::MakePrettySize (item.size ()) + "</td>";
-			result += "<td>" + item.created ().toString (Qt::SystemLocaleShortDate) + "</td></tr>";
+			result += "<tr><td class=" + IconResolver::GetClassName (item.Mime_) + "><a href='";
+			result += link + "'>" + item.Name_ + "</a></td>";
+			result += "<td>" + Util::MakePrettySize (item.Size_) + "</td>";
+			result += "<td>" + item.Created_.toString (Qt::SystemLocaleShortDate) + "</td></tr>";
 		}
 
 		result += "</table></body></html>";
@@ -387,6 +399,9 @@ namespace HttHare
 
 	void RequestHandler::HandleRequest (Verb verb)
 	{
+		if (Url_.path ().startsWith (AssetsPrefix))
+			return WriteAsset (Url_.path ().mid (AssetsPrefix.size ()), verb);
+
 		QString path;
 		try
 		{
@@ -441,6 +456,30 @@ namespace HttHare
 			WriteFile (path, fi, verb);
 	}
 
+	void RequestHandler::WriteAsset (const QString& name, Verb verb)
+	{
+		const auto resolver = Conn_->GetIconResolver ();
+
+		if (name == IconsStylesheet)
+		{
+			ResponseHeaders_.append ({ "Content-Type", "text/css; charset=utf-8" });
+			ResponseBody_ = resolver->GetStylesheet (IconsImage + "?v=" +
+					QString::number (resolver->GetVersion ()));
+		}
+		else if (name == IconsImage)
+		{
+			ResponseHeaders_.append ({ "Content-Type", "image/png" });
+			ResponseBody_ = resolver->GetImage ();
+		}
+		else
+			return ErrorResponse (404, "Not found");
+
+		ResponseLine_ = "HTTP/1.1 200 OK\r\n";
+		ResponseHeaders_.append ({ "Cache-Control", AssetsCacheControl });
+
+		DefaultWrite (verb);
+	}
+
 	void RequestHandler::WriteDir (const QString& path, const QFileInfo& fi, RequestHandler::Verb verb)
 	{
 		if (Url_.path ().endsWith ('/'))
@@ -448,7 +487,7 @@ namespace HttHare
 			ResponseLine_ = "HTTP/1.1 200 OK\r\n";
 
 			ResponseHeaders_.append ({ "Content-Type", "text/html; charset=utf-8" });
-			ResponseBody_ = MakeDirResponse (fi, path, Url_);
+			ResponseBody_ = MakeDirResponse (fi, Url_);
 
 			DefaultWrite (verb);
 		}
@@ -459,7 +498,7 @@ namespace HttHare
 			auto url = Url_;
 			url.setPath (url.path () + '/');
 			ResponseHeaders_.append ({ "Location", url.toString ().toUtf8 () });
-			ResponseBody_ = MakeDirResponse (fi, path, url);
+			ResponseBody_ = MakeDirResponse (fi, url);
 
 			DefaultWrite (verb);
 		}
@@ -469,7 +508,7 @@ namespace HttHare
 	{
 		auto ranges = ParseRanges (Headers_.value ("Range"), fi.size ());
 
-		const auto& mime = Util::MimeDetector {} (path);
+		const auto& mime = Conn_->GetStorageManager ().GetMime (fi);
 		ResponseHeaders_.append ({ "Content-Type", mime });
 
 		if (ranges.isEmpty ())
@@ -489,24 +528,28 @@ namespace HttHare
 		}
 
 		auto c = Conn_;
+		const auto& buffers = ToBuffers (verb);
+		const auto& data = GetResponseData ();
+		const auto keepAlive = KeepAlive_;
 		boost::asio::async_write (c->GetSocket (),
-				ToBuffers (verb),
-				c->GetStrand ().wrap ([c, path, verb, ranges] (boost::system::error_code ec, ulong) mutable -> void
+				buffers,
+				c->GetStrand ().wrap ([c, data, keepAlive, path, verb, ranges] (boost::system::error_code ec, ulong) mutable -> void
 					{
 						if (ec)
+						{
 							qWarning () << Q_FUNC_INFO
 									<< ec.message ().c_str ();
-
-						auto& s = c->GetSocket ();
-
-						std::shared_ptr<void> shutdownGuard = std::shared_ptr<void> (nullptr,
-								[&s, &ec] (void*)
-								{
-									s.shutdown (boost::asio::socket_base::shutdown_both, ec);
-								});
+							c->FinishRequest (false);
+							return;
+						}
 
 						if (verb != Verb::Get)
+						{
+							c->FinishRequest (keepAlive);
 							return;
+						}
+
+						auto& s = c->GetSocket ();
 
 						std::shared_ptr<QFile> file { new QFile { path } };
 						file->open (QIODevice::ReadOnly);
@@ -525,7 +568,13 @@ namespace HttHare
 							0,
 							headRange,
 							ranges,
-							[c, shutdownGuard] (boost::system::error_code, ulong) {}
+							[c, keepAlive] (boost::system::error_code ec, ulong)
+							{
+								if (ec)
+									qWarning () << Q_FUNC_INFO
+											<< ec.message ().c_str ();
+								c->FinishRequest (keepAlive && !ec);
+							}
 						} (ec, 0);
 					}));
 	}
@@ -533,16 +582,18 @@ namespace HttHare
 	void RequestHandler::DefaultWrite (Verb verb)
 	{
 		auto c = Conn_;
+		const auto& buffers = ToBuffers (verb);
+		const auto& data = GetResponseData ();
+		const auto keepAlive = KeepAlive_;
 		boost::asio::async_write (c->GetSocket (),
-				ToBuffers (verb),
-				c->GetStrand ().wrap ([c] (const boost::system::error_code& ec, ulong)
+				buffers,
+				c->GetStrand ().wrap ([c, data, keepAlive] (const boost::system::error_code& ec, ulong)
 					{
 						if (ec)
 							qWarning () << Q_FUNC_INFO
 									<< ec.message ().c_str ();
 
-						boost::system::error_code iec;
-						c->GetSocket ().shutdown (boost::asio::socket_base::shutdown_both, iec);
+						c->FinishRequest (keepAlive && !ec);
 					}));
 	}
 
@@ -570,9 +621,13 @@ namespace HttHare
 		const bool hasContentLength = std::find_if (ResponseHeaders_.begin (), ResponseHeaders_.end (),
 				[] (decltype (ResponseHeaders_.at (0)) pair)
 					{ return pair.first.toLower () == "content-length"; }) != ResponseHeaders_.end ();
+		const bool isImage = std::find_if (ResponseHeaders_.begin (), ResponseHeaders_.end (),
+				[] (decltype (ResponseHeaders_.at (0)) pair)
+					{ return pair.first.toLower () == "content-type" && pair.second.startsWith ("image/"); }) != ResponseHeaders_.end ();
 
 		const auto& splitAe = Headers_.value ("Accept-Encoding").split (',');
 		if (verb == Verb::Get &&
+				!isImage &&
 				!ResponseBody_.isEmpty () &&
 				SupportsDeflate (splitAe))
 		{
@@ -584,6 +639,17 @@ namespace HttHare
 		if (!hasContentLength)
 			ResponseHeaders_.append ({ "Content-Length", QByteArray::number (ResponseBody_.size ()) });
 
+		if (KeepAlive_)
+		{
+			const auto& params = Conn_->GetKeepAliveParams ();
+			ResponseHeaders_.append ({ "Connection", "keep-alive" });
+			ResponseHeaders_.append ({ "Keep-Alive",
+					"timeout=" + QByteArray::number (static_cast<qint64> (params.Timeout_.count ())) +
+					", max=" + QByteArray::number (params.MaxRequests_) });
+		}
+		else
+			ResponseHeaders_.append ({ "Connection", "close" });
+
 		CookedRH_.clear ();
 		for (const auto& pair : ResponseHeaders_)
 			CookedRH_ += pair.first + ": " + pair.second + "\r\n";
@@ -604,5 +670,12 @@ namespace HttHare
 
 		return result;
 	}
+
+	QList<QByteArray> RequestHandler::GetResponseData () const
+	{
+		// The handler itself is gone by the time the write completes, so
+		// the write handler keeps the (implicitly shared) data alive.
+		return { ResponseLine_, CookedRH_, ResponseBody_ };
+	}
 }
 }
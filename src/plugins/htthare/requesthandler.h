@@ -59,6 +59,8 @@ namespace HttHare
 		QByteArray CookedRH_;
 		QByteArray ResponseBody_;
 
+		bool KeepAlive_ = false;
+
 		enum class Verb
 		{
 			Get,
@@ -70,15 +72,19 @@ namespace HttHare
 		void operator() (QByteArray);
 	private:
 		QString Tr (const char*);
+		QString GetHeader (const QString&) const;
+		bool ShouldKeepAlive (const QByteArray&) const;
 
 		void ErrorResponse (int, const QByteArray&, const QByteArray& = QByteArray ());
-		QByteArray MakeDirResponse (const QFileInfo&, const QString&, const QUrl&);
+		QByteArray MakeDirResponse (const QFileInfo&, const QUrl&);
 
 		void HandleRequest (Verb);
+		void WriteAsset (const QString&, Verb);
 		void WriteDir (const QString&, const QFileInfo&, Verb);
 		void WriteFile (const QString&, const QFileInfo&, Verb);
 		void DefaultWrite (Verb);
 		std::vector<boost::asio::const_buffer> ToBuffers (Verb);
+		QList<QByteArray> GetResponseData () const;
 	};
 }
 }
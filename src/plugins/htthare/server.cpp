@@ -30,9 +30,9 @@
 #include "server.h"
 #include <QString>
 #include <QtDebug>
-#include "connection.h"
 #include "iconresolver.h"
 #include "trmanager.h"
+#include "xmlsettingsmanager.h"
 
 namespace LeechCraft
 {
@@ -40,9 +40,23 @@ namespace HttHare
 {
 	namespace ip = boost::asio::ip;
 
+	namespace
+	{
+		KeepAliveParams GetKeepAliveParams ()
+		{
+			const auto& xsm = XmlSettingsManager::Instance ();
+			return
+			{
+				std::chrono::seconds { xsm.property ("KeepAliveTimeout").toInt () },
+				xsm.property ("MaxKeepAliveRequests").toInt ()
+			};
+		}
+	}
+
 	Server::Server (const QList<QPair<QString, QString>>& addresses)
 	: IconResolver_ { new IconResolver  }
 	, TrManager_ { new TrManager }
+	, KeepAlive_ (GetKeepAliveParams ())
 	{
 		ip::tcp::resolver resolver { IoService_ };
 
@@ -97,7 +111,7 @@ namespace HttHare
 
 	void Server::StartAccept ()
 	{
-		Connection_ptr connection { new Connection { IoService_, StorageMgr_, IconResolver_, TrManager_ } };
+		Connection_ptr connection { new Connection { IoService_, StorageMgr_, IconResolver_, TrManager_, KeepAlive_ } };
 
 		for (auto& acceptor : Acceptors_)
 			acceptor->async_accept (connection->GetSocket (),
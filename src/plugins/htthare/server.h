@@ -32,6 +32,7 @@
 #include <thread>
 #include <boost/asio.hpp>
 #include "storagemanager.h"
+#include "connection.h"
 
 template<typename T>
 class QSet;
@@ -56,6 +57,8 @@ namespace HttHare
 
 		IconResolver * const IconResolver_;
 		TrManager * const TrManager_;
+
+		const KeepAliveParams KeepAlive_;
 	public:
 		Server (const QList<QPair<QString, QString>>& addresses);
 		~Server ();
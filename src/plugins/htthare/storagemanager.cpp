@@ -32,6 +32,7 @@
 #include <QUrl>
 #include <QDir>
 #include <QtDebug>
+#include "mimecache.h"
 
 namespace LeechCraft
 {
@@ -42,6 +43,12 @@ namespace HttHare
 	}
 
 	StorageManager::StorageManager ()
+	: Mimes_ { new MimeCache }
+	, Dirs_ { new DirCache { *Mimes_ } }
+	{
+	}
+
+	StorageManager::~StorageManager ()
 	{
 	}
 
@@ -58,5 +65,15 @@ namespace HttHare
 
 		return path;
 	}
+
+	QByteArray StorageManager::GetMime (const QFileInfo& fi) const
+	{
+		return Mimes_->GetMime (fi);
+	}
+
+	DirListing_ptr StorageManager::GetListing (const QFileInfo& fi) const
+	{
+		return Dirs_->GetListing (fi);
+	}
 }
 }
@@ -30,9 +30,12 @@
 #pragma once
 
 #include <stdexcept>
+#include <memory>
 #include <QUrl>
+#include "dircache.h"
 
 class QString;
+class QFileInfo;
 
 namespace LeechCraft
 {
@@ -44,12 +47,20 @@ namespace HttHare
 		~AccessDeniedException () noexcept;
 	};
 
+	class MimeCache;
+
 	class StorageManager
 	{
+		const std::unique_ptr<MimeCache> Mimes_;
+		const std::unique_ptr<DirCache> Dirs_;
 	public:
 		StorageManager ();
+		~StorageManager ();
 
 		QString ResolvePath (QUrl) const;
+
+		QByteArray GetMime (const QFileInfo&) const;
+		DirListing_ptr GetListing (const QFileInfo&) const;
 	};
 }
 }
@@ -111,6 +111,13 @@ namespace Imgaste
 					<< e.Entity_;
 	}
 
+	QList<EntityRoutingRule> Plugin::GetEntityRoutingRules () const
+	{
+		EntityRoutingRule rule;
+		rule.Mimes_ << "x-leechcraft/data-filter-request";
+		return { rule };
+	}
+
 	QString Plugin::GetFilterVerb () const
 	{
 		return tr ("Upload image");
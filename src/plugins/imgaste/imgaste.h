@@ -32,6 +32,7 @@
 #include <QObject>
 #include <interfaces/iinfo.h>
 #include <interfaces/ientityhandler.h>
+#include <interfaces/ientityroutingrules.h>
 #include <interfaces/idatafilter.h>
 #include <interfaces/ijobholder.h>
 
@@ -45,11 +46,12 @@ namespace Imgaste
 	class Plugin : public QObject
 				 , public IInfo
 				 , public IEntityHandler
+				 , public IEntityRoutingRules
 				 , public IDataFilter
 				 , public IJobHolder
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IEntityHandler IDataFilter IJobHolder)
+		Q_INTERFACES (IInfo IEntityHandler IEntityRoutingRules IDataFilter IJobHolder)
 
 		LC_PLUGIN_METADATA ("org.LeechCraft.Imgaste")
 
@@ -68,6 +70,8 @@ namespace Imgaste
 		EntityTestHandleResult CouldHandle (const Entity&) const;
 		void Handle (Entity);
 
+		QList<EntityRoutingRule> GetEntityRoutingRules () const;
+
 		QString GetFilterVerb () const;
 		QList<FilterVariant> GetFilterVariants () const;
 
@@ -160,7 +160,8 @@ namespace Kinotify
 			return;
 
 		Priority prio = static_cast<Priority> (e.Additional_ ["Priority"].toInt ());
-		if (prio == PLog_)
+		if (prio == PLog_ ||
+				e.Additional_ ["Text"].toString ().isEmpty ())
 			return;
 
 		const auto& sender = e.Additional_ ["org.LC.AdvNotifications.SenderID"].toString ();
@@ -233,6 +234,17 @@ namespace Kinotify
 		}
 	}
 
+	QList<EntityRoutingRule> Plugin::GetEntityRoutingRules () const
+	{
+		// CouldHandle()'s checks of the priority and the text are
+		// repeated in Handle(), so the notifications can be routed here
+		// without querying this plugin.
+		EntityRoutingRule rule;
+		rule.Mimes_ << "x-leechcraft/notification";
+		rule.StaticResult_ = EntityTestHandleResult { EntityTestHandleResult::PHigh };
+		return { rule };
+	}
+
 	Util::XmlSettingsDialog_ptr Plugin::GetSettingsDialog () const
 	{
 		return SettingsDialog_;
@@ -0,0 +1,91 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "componenthashes.h"
+#include <QCoreApplication>
+#include <QSettings>
+#include <QUrl>
+
+namespace LeechCraft
+{
+namespace LackMan
+{
+	QString ComponentHashes::MakeKey (const QUrl& repoUrl, const QString& component)
+	{
+		return repoUrl.toString () + '#' + component;
+	}
+
+	bool ComponentHashes::IsUnchanged (const QString& key, const QByteArray& hash) const
+	{
+		return !hash.isEmpty () && GetHash (key) == hash;
+	}
+
+	void ComponentHashes::Expect (int componentId,
+			const QString& key, const QByteArray& hash, int scheduled)
+	{
+		Pending_.remove (componentId);
+
+		if (!scheduled)
+			SetHash (key, hash);
+		else if (scheduled > 0)
+			Pending_ [componentId] = { key, hash, scheduled };
+	}
+
+	void ComponentHashes::HandlePackageFetched (int componentId)
+	{
+		const auto pos = Pending_.find (componentId);
+		if (pos == Pending_.end () || --pos->Remaining_)
+			return;
+
+		SetHash (pos->Key_, pos->Hash_);
+		Pending_.erase (pos);
+	}
+
+	void ComponentHashes::Forget (int componentId)
+	{
+		Pending_.remove (componentId);
+	}
+
+	QByteArray ComponentHashes::GetHash (const QString& key) const
+	{
+		QSettings settings (QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "_LackMan");
+		return settings.value ("ComponentHashes").toMap ().value (key).toByteArray ();
+	}
+
+	void ComponentHashes::SetHash (const QString& key, const QByteArray& hash)
+	{
+		QSettings settings (QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "_LackMan");
+		auto hashes = settings.value ("ComponentHashes").toMap ();
+		hashes [key] = hash;
+		settings.setValue ("ComponentHashes", hashes);
+	}
+}
+}
@@ -0,0 +1,71 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+
+class QUrl;
+
+namespace LeechCraft
+{
+namespace LackMan
+{
+	/** Keeps the hashes of the last processed Packages.xml.gz of each
+	 * repository component.
+	 *
+	 * A hash is only committed once every new package scheduled for the
+	 * component has been fetched, so a component whose processing was
+	 * interrupted is fully processed again next time.
+	 */
+	class ComponentHashes
+	{
+		struct Pending
+		{
+			QString Key_;
+			QByteArray Hash_;
+			int Remaining_;
+		};
+		QHash<int, Pending> Pending_;
+	public:
+		static QString MakeKey (const QUrl& repoUrl, const QString& component);
+
+		bool IsUnchanged (const QString& key, const QByteArray& hash) const;
+
+		void Expect (int componentId, const QString& key, const QByteArray& hash, int scheduled);
+		void HandlePackageFetched (int componentId);
+		void Forget (int componentId);
+	private:
+		QByteArray GetHash (const QString& key) const;
+		void SetHash (const QString& key, const QByteArray& hash);
+	};
+}
+}
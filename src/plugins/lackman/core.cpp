@@ -107,14 +107,18 @@ namespace LackMan
 				SLOT (handleInfoFetched (const RepoInfo&)));
 		connect (RepoInfoFetcher_,
 				SIGNAL (componentFetched (const PackageShortInfoList&,
-						const QString&, int)),
+						const QString&, int, const QByteArray&)),
 				this,
 				SLOT (handleComponentFetched (const PackageShortInfoList&,
-						const QString&, int)));
+						const QString&, int, const QByteArray&)));
 		connect (RepoInfoFetcher_,
 				SIGNAL (packageFetched (const PackageInfo&, int)),
 				this,
 				SLOT (handlePackageFetched (const PackageInfo&, int)));
+		connect (RepoInfoFetcher_,
+				SIGNAL (packageFetchFailed (int)),
+				this,
+				SLOT (handlePackageFetchFailed (int)));
 		connect (PackageProcessor_,
 				SIGNAL (packageInstallError (int, const QString&)),
 				this,
@@ -137,6 +141,9 @@ namespace LackMan
 				SLOT (timeredUpdateAllRequested ()));
 		XmlSettingsManager::Instance ()->RegisterObject ("UpdatesCheckInterval",
 				this, "handleUpdatesIntervalChanged");
+		XmlSettingsManager::Instance ()->RegisterObject ("MaxConcurrentPackageFetches",
+				this, "handleMaxPackageFetchesChanged");
+		handleMaxPackageFetchesChanged ();
 	}
 
 	Core& Core::Instance ()
@@ -531,10 +538,7 @@ namespace LackMan
 
 	QString Core::NormalizePackageName (const QString& packageName) const
 	{
-		QString normalized = packageName.simplified ();
-		normalized.remove (' ');
-		normalized.remove ('\t');
-		return normalized;
+		return LackMan::NormalizePackageName (packageName);
 	}
 
 	QStringList Core::GetAllTags () const
@@ -669,7 +673,7 @@ namespace LackMan
 		}
 	}
 
-	void Core::HandleNewPackages (const PackageShortInfoList& shortInfos,
+	int Core::HandleNewPackages (const PackageShortInfoList& shortInfos,
 			int componentId, const QString& component, const QUrl& repoUrl)
 	{
 		QMap<QString, QList<QString>> PackageName2NewVersions_;
@@ -695,7 +699,7 @@ namespace LackMan
 								.arg (info.Name_)
 								.arg (version),
 							PCritical_));
-					return;
+					return -1;
 				}
 
 				if (packageId == -1)
@@ -724,7 +728,7 @@ namespace LackMan
 								.arg (version)
 								.arg (component),
 							PCritical_));
-					return;
+					return -1;
 				}
 			}
 
@@ -748,6 +752,8 @@ namespace LackMan
 						"open LackMan tab to view them.",
 						0, newPackages),
 					PInfo_));
+
+		return PackageName2NewVersions_.size ();
 	}
 
 	void Core::PerformRemoval (int packageId)
@@ -936,6 +942,12 @@ namespace LackMan
 		UpdatesEnabled_ = hours;
 	}
 
+	void Core::handleMaxPackageFetchesChanged ()
+	{
+		RepoInfoFetcher_->SetMaxPackageFetches (XmlSettingsManager::Instance ()->
+				property ("MaxConcurrentPackageFetches").toInt ());
+	}
+
 	void Core::timeredUpdateAllRequested ()
 	{
 		updateAllRequested ();
@@ -1064,7 +1076,7 @@ namespace LackMan
 	}
 
 	void Core::handleComponentFetched (const PackageShortInfoList& shortInfos,
-			const QString& component, int repoId)
+			const QString& component, int repoId, const QByteArray& hash)
 	{
 		int componentId = -1;
 		QUrl repoUrl;
@@ -1110,6 +1122,22 @@ namespace LackMan
 			return;
 		}
 
+		// The hash is only recorded after all the new packages of the
+		// component have been fetched, so nothing is lost if the same
+		// contents are skipped later.
+		const auto& hashKey = ComponentHashes::MakeKey (repoUrl, component);
+		if (!presentPackages.isEmpty () &&
+				ComponentHashes_.IsUnchanged (hashKey, hash))
+		{
+			qDebug () << Q_FUNC_INFO
+					<< "component"
+					<< component
+					<< "of"
+					<< repoUrl
+					<< "is unchanged";
+			return;
+		}
+
 		for (int presentPId : presentPackages)
 		{
 			PackageShortInfo psi;
@@ -1166,7 +1194,8 @@ namespace LackMan
 			}
 		}
 
-		HandleNewPackages (shortInfos, componentId, component, repoUrl);
+		const int scheduled = HandleNewPackages (shortInfos, componentId, component, repoUrl);
+		ComponentHashes_.Expect (componentId, hashKey, hash, scheduled);
 	}
 
 	void Core::handlePackageFetched (const PackageInfo& pInfo,
@@ -1200,9 +1229,13 @@ namespace LackMan
 			}
 
 			emit tagsUpdated (GetAllTags ());
+
+			ComponentHashes_.HandlePackageFetched (componentId);
 		}
 		catch (const std::runtime_error& e)
 		{
+			ComponentHashes_.Forget (componentId);
+
 			pInfo.Dump ();
 			qWarning () << Q_FUNC_INFO
 					<< e.what ();
@@ -1232,6 +1265,11 @@ namespace LackMan
 		}
 	}
 
+	void Core::handlePackageFetchFailed (int componentId)
+	{
+		ComponentHashes_.Forget (componentId);
+	}
+
 	void Core::handlePackageInstallError (int packageId, const QString& error)
 	{
 		QString packageName;
@@ -31,8 +31,10 @@
 #define PLUGINS_LACKMAN_CORE_H
 #include <QObject>
 #include <QModelIndex>
+#include <QHash>
 #include <interfaces/iinfo.h>
 #include "repoinfo.h"
+#include "componenthashes.h"
 
 class QAbstractItemModel;
 class QStandardItemModel;
@@ -65,6 +67,8 @@ namespace LackMan
 		UpdatesNotificationManager *UpdatesNotificationManager_ = nullptr;
 		bool UpdatesEnabled_;
 
+		ComponentHashes ComponentHashes_;
+
 		enum ReposColumns
 		{
 			RCURL
@@ -107,7 +111,7 @@ namespace LackMan
 		InstalledDependencyInfoList GetLackManInstalledPackages () const;
 		InstalledDependencyInfoList GetAllInstalledPackages () const;
 		void PopulatePluginsModel ();
-		void HandleNewPackages (const PackageShortInfoList& shorts,
+		int HandleNewPackages (const PackageShortInfoList& shorts,
 				int componentId, const QString& component, const QUrl& repoUrl);
 		void PerformRemoval (int);
 		void UpdateRowFor (int);
@@ -119,6 +123,7 @@ namespace LackMan
 	public slots:
 		void updateAllRequested ();
 		void handleUpdatesIntervalChanged ();
+		void handleMaxPackageFetchesChanged ();
 		void timeredUpdateAllRequested ();
 		void upgradeAllRequested ();
 		void cancelPending ();
@@ -128,8 +133,9 @@ namespace LackMan
 	private slots:
 		void handleInfoFetched (const RepoInfo&);
 		void handleComponentFetched (const PackageShortInfoList&,
-				const QString&, int);
+				const QString&, int, const QByteArray&);
 		void handlePackageFetched (const PackageInfo&, int);
+		void handlePackageFetchFailed (int);
 		void handlePackageInstallError (int, const QString&);
 		void handlePackageInstalled (int);
 		void handlePackageUpdated (int from, int to);
@@ -0,0 +1,118 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "gunzip.h"
+#include <stdexcept>
+#include <memory>
+#include <zlib.h>
+#include <QIODevice>
+#include <QCryptographicHash>
+
+namespace LeechCraft
+{
+namespace LackMan
+{
+	namespace
+	{
+		const int ChunkSize = 64 * 1024;
+
+		std::string MakeError (const char *context, const z_stream& stream)
+		{
+			std::string result { context };
+			if (stream.msg)
+				result += std::string { ": " } + stream.msg;
+			return result;
+		}
+	}
+
+	QByteArray Gunzip (QIODevice *device, QCryptographicHash *hash)
+	{
+		z_stream stream {};
+
+		// 16 is for the gzip header and trailer instead of the zlib ones.
+		if (inflateInit2 (&stream, 16 + MAX_WBITS) != Z_OK)
+			throw std::runtime_error { MakeError ("cannot initialize zlib", stream) };
+
+		std::shared_ptr<void> guard { nullptr, [&stream] (void*) { inflateEnd (&stream); } };
+
+		QByteArray result;
+		QByteArray input;
+		char output [ChunkSize];
+
+		bool streamEnded = false;
+		bool needsInput = true;
+		while (true)
+		{
+			// zlib may have more output pending even if all the input has
+			// been consumed, which is signaled by the full output buffer.
+			if (!stream.avail_in && needsInput)
+			{
+				input = device->read (ChunkSize);
+				if (input.isEmpty ())
+					break;
+
+				if (hash)
+					hash->addData (input);
+
+				stream.next_in = reinterpret_cast<Bytef*> (input.data ());
+				stream.avail_in = input.size ();
+			}
+
+			// Another gzip member follows the previous one.
+			if (streamEnded)
+			{
+				if (inflateReset (&stream) != Z_OK)
+					throw std::runtime_error { MakeError ("cannot reset zlib", stream) };
+				streamEnded = false;
+			}
+
+			stream.next_out = reinterpret_cast<Bytef*> (output);
+			stream.avail_out = ChunkSize;
+
+			const auto rc = inflate (&stream, Z_NO_FLUSH);
+			if (rc == Z_STREAM_END)
+				streamEnded = true;
+			else if (rc != Z_OK && rc != Z_BUF_ERROR)
+				throw std::runtime_error { MakeError ("corrupted gzip data", stream) };
+
+			result.append (output, ChunkSize - stream.avail_out);
+			needsInput = streamEnded || stream.avail_out != 0;
+
+			// No progress is possible with some input left.
+			if (rc == Z_BUF_ERROR && stream.avail_in && needsInput)
+				throw std::runtime_error { MakeError ("corrupted gzip data", stream) };
+		}
+
+		if (!streamEnded)
+			throw std::runtime_error { "truncated or empty gzip data" };
+
+		return result;
+	}
+}
+}
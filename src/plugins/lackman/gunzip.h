@@ -0,0 +1,59 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+
+class QIODevice;
+class QCryptographicHash;
+
+namespace LeechCraft
+{
+namespace LackMan
+{
+	/** @brief Decompresses the gzip stream read from the \em device.
+	 *
+	 * The device should be already opened for reading. The data is
+	 * read and inflated in chunks, so the compressed data is never kept
+	 * in memory as a whole. If \em hash is not null, it is additionally
+	 * fed with the compressed data.
+	 *
+	 * Concatenated gzip members are supported, as produced by
+	 * <code>cat a.gz b.gz</code>.
+	 *
+	 * @param[in] device The device to read the compressed data from.
+	 * @param[in] hash The hash to update with the compressed data.
+	 * @return The decompressed data.
+	 *
+	 * @throw std::runtime_error If the data is not a valid gzip stream.
+	 */
+	QByteArray Gunzip (QIODevice *device, QCryptographicHash *hash = nullptr);
+}
+}
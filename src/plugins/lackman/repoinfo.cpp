@@ -154,5 +154,13 @@ namespace LackMan
 	{
 		return qHash (QString::number (dep.Type_) + dep.Name_ + dep.Version_);
 	}
+
+	QString NormalizePackageName (const QString& packageName)
+	{
+		QString normalized = packageName.simplified ();
+		normalized.remove (' ');
+		normalized.remove ('\t');
+		return normalized;
+	}
 }
 }
@@ -228,6 +228,11 @@ namespace LackMan
 	typedef QList<InstalledDependencyInfo> InstalledDependencyInfoList;
 
 	uint qHash (const Dependency&);
+
+	/** Returns the package name as it is used in the mirror file
+	 * names, that is, with all the whitespace removed.
+	 */
+	QString NormalizePackageName (const QString&);
 }
 }
 
@@ -28,16 +28,85 @@
  **********************************************************************/
 
 #include "repoinfofetcher.h"
+#include <stdexcept>
+#include <algorithm>
 #include <QTimer>
+#include <QFile>
+#include <QCryptographicHash>
+#include <QtConcurrentRun>
 #include <util/sys/paths.h>
 #include <util/xpc/util.h>
-#include "core.h"
+#include <util/threads/futures.h>
+#include "gunzip.h"
 #include "xmlparsers.h"
 
 namespace LeechCraft
 {
 namespace LackMan
 {
+	namespace
+	{
+		template<typename T>
+		struct UnpackResult
+		{
+			T Value_;
+			QByteArray Hash_;
+			QString UnpackError_;
+			QString ParseError_;
+		};
+
+		/* Decompresses and parses the downloaded file in a worker thread.
+		 * The file is removed on success and kept otherwise, so that it
+		 * could be inspected.
+		 */
+		template<typename T, typename F>
+		QFuture<UnpackResult<T>> Unpack (const QString& filename, F parser)
+		{
+			return QtConcurrent::run ([filename, parser] () -> UnpackResult<T>
+					{
+						UnpackResult<T> result;
+
+						QFile file { filename };
+						if (!file.open (QIODevice::ReadOnly))
+						{
+							result.UnpackError_ = file.errorString ();
+							return result;
+						}
+
+						QByteArray data;
+						QCryptographicHash hash { QCryptographicHash::Sha1 };
+						try
+						{
+							data = Gunzip (&file, &hash);
+						}
+						catch (const std::exception& e)
+						{
+							result.UnpackError_ = QString::fromUtf8 (e.what ());
+							return result;
+						}
+						result.Hash_ = hash.result ();
+
+						try
+						{
+							result.Value_ = parser (data);
+						}
+						catch (const QString& error)
+						{
+							result.ParseError_ = error;
+							return result;
+						}
+						catch (const std::exception& e)
+						{
+							result.ParseError_ = QString::fromUtf8 (e.what ());
+							return result;
+						}
+
+						file.remove ();
+						return result;
+					});
+		}
+	}
+
 	RepoInfoFetcher::RepoInfoFetcher (QObject *parent)
 	: QObject (parent)
 	{
@@ -154,6 +223,12 @@ namespace LackMan
 				Qt::UniqueConnection);
 	}
 
+	void RepoInfoFetcher::SetMaxPackageFetches (int maxFetches)
+	{
+		MaxPackageFetches_ = std::max (1, maxFetches);
+		rotatePackageFetchQueue ();
+	}
+
 	void RepoInfoFetcher::ScheduleFetchPackageInfo (const QUrl& url,
 			const QString& name,
 			const QList<QString>& newVers,
@@ -183,7 +258,7 @@ namespace LackMan
 		QString location = Util::GetTemporaryName ("lackman_XXXXXX.gz");
 		QUrl packageUrl = baseUrl;
 		packageUrl.setPath (packageUrl.path () +
-				Core::Instance ().NormalizePackageName (packageName) + ".xml.gz");
+				NormalizePackageName (packageName) + ".xml.gz");
 
 		PendingPackage pp =
 		{
@@ -211,6 +286,7 @@ namespace LackMan
 					tr ("Could not find plugin to fetch package information at %1.")
 						.arg (packageUrl.toString ()),
 					PCritical_));
+			emit packageFetchFailed (componentId);
 			return;
 		}
 
@@ -235,14 +311,12 @@ namespace LackMan
 
 	void RepoInfoFetcher::rotatePackageFetchQueue ()
 	{
-		if (ScheduledPackages_.isEmpty ())
-			return;
-
-		const auto& f = ScheduledPackages_.takeFirst ();
-		FetchPackageInfo (f.BaseUrl_, f.PackageName_, f.NewVersions_, f.ComponentId_);
-
-		if (!ScheduledPackages_.isEmpty ())
-			QTimer::singleShot (50, this, SLOT (rotatePackageFetchQueue ()));
+		while (!ScheduledPackages_.isEmpty () &&
+				PendingPackages_.size () + UnpackingPackages_ < MaxPackageFetches_)
+		{
+			const auto& f = ScheduledPackages_.takeFirst ();
+			FetchPackageInfo (f.BaseUrl_, f.PackageName_, f.NewVersions_, f.ComponentId_);
+		}
 	}
 
 	void RepoInfoFetcher::handleRIFinished (int id)
@@ -250,25 +324,37 @@ namespace LackMan
 		if (!PendingRIs_.contains (id))
 			return;
 
-		PendingRI pri = PendingRIs_.take (id);
-
-		QString name = pri.Location_;
-		QProcess *unarch = new QProcess (this);
-		unarch->setProperty ("URL", pri.URL_);
-		unarch->setProperty ("Filename", name);
-		connect (unarch,
-				SIGNAL (finished (int, QProcess::ExitStatus)),
-				this,
-				SLOT (handleRepoUnarchFinished (int, QProcess::ExitStatus)));
-		connect (unarch,
-				SIGNAL (error (QProcess::ProcessError)),
-				this,
-				SLOT (handleUnarchError (QProcess::ProcessError)));
-#ifdef Q_OS_WIN32
-		unarch->start ("7za", QStringList ("e") << "-so" << name);
-#else
-		unarch->start ("gunzip", QStringList ("-c") << name);
-#endif
+		const auto& pri = PendingRIs_.take (id);
+		const auto& url = pri.URL_;
+		Util::Sequence (this,
+				Unpack<RepoInfo> (pri.Location_,
+						[url] (const QByteArray& data) { return ParseRepoInfo (url, QString (data)); })) >>
+				[this, pri] (const UnpackResult<RepoInfo>& result)
+				{
+					if (!result.UnpackError_.isEmpty ())
+					{
+						emit gotEntity (Util::MakeNotification (tr ("Repository unpack error"),
+								tr ("Unable to unpack the repository file: %1. "
+									"Problematic file is at %2.")
+									.arg (result.UnpackError_)
+									.arg (pri.Location_),
+								PCritical_));
+						return;
+					}
+
+					if (!result.ParseError_.isEmpty ())
+					{
+						qWarning () << Q_FUNC_INFO
+								<< result.ParseError_;
+						emit gotEntity (Util::MakeNotification (tr ("Repository parse error"),
+								tr ("Unable to parse repository description: %1.")
+									.arg (result.ParseError_),
+								PCritical_));
+						return;
+					}
+
+					emit infoFetched (result.Value_);
+				};
 	}
 
 	void RepoInfoFetcher::handleRIRemoved (int id)
@@ -299,26 +385,35 @@ namespace LackMan
 		if (!PendingComponents_.contains (id))
 			return;
 
-		PendingComponent pc = PendingComponents_.take (id);
-
-		QProcess *unarch = new QProcess (this);
-		unarch->setProperty ("Component", pc.Component_);
-		unarch->setProperty ("Filename", pc.Location_);
-		unarch->setProperty ("URL", pc.URL_);
-		unarch->setProperty ("RepoID", pc.RepoID_);
-		connect (unarch,
-				SIGNAL (finished (int, QProcess::ExitStatus)),
-				this,
-				SLOT (handleComponentUnarchFinished (int, QProcess::ExitStatus)));
-		connect (unarch,
-				SIGNAL (error (QProcess::ProcessError)),
-				this,
-				SLOT (handleUnarchError (QProcess::ProcessError)));
-#ifdef Q_OS_WIN32
-		unarch->start ("7za", QStringList ("e") << "-so" << pc.Location_);
-#else
-		unarch->start ("gunzip", QStringList ("-c") << pc.Location_);
-#endif
+		const auto& pc = PendingComponents_.take (id);
+		Util::Sequence (this, Unpack<PackageShortInfoList> (pc.Location_, &ParseComponent)) >>
+				[this, pc] (const UnpackResult<PackageShortInfoList>& result)
+				{
+					if (!result.UnpackError_.isEmpty ())
+					{
+						emit gotEntity (Util::MakeNotification (tr ("Component unpack error"),
+								tr ("Unable to unpack the component file: %1. "
+									"Problematic file is at %2.")
+									.arg (result.UnpackError_)
+									.arg (pc.Location_),
+								PCritical_));
+						return;
+					}
+
+					if (!result.ParseError_.isEmpty ())
+					{
+						qWarning () << Q_FUNC_INFO
+								<< result.ParseError_;
+						emit gotEntity (Util::MakeNotification (tr ("Component parse error"),
+								tr ("Unable to parse component %1 description file. "
+									"More information is available in logs.")
+									.arg (pc.Component_),
+								PCritical_));
+						return;
+					}
+
+					emit componentFetched (result.Value_, pc.Component_, pc.RepoID_, result.Hash_);
+				};
 	}
 
 	void RepoInfoFetcher::handleComponentRemoved (int id)
@@ -349,25 +444,47 @@ namespace LackMan
 		if (!PendingPackages_.contains (id))
 			return;
 
-		PendingPackage pp = PendingPackages_ [id];
-
-		QProcess *unarch = new QProcess (this);
-		unarch->setProperty ("Filename", pp.Location_);
-		unarch->setProperty ("URL", pp.URL_);
-		unarch->setProperty ("TaskID", id);
-		connect (unarch,
-				SIGNAL (finished (int, QProcess::ExitStatus)),
-				this,
-				SLOT (handlePackageUnarchFinished (int, QProcess::ExitStatus)));
-		connect (unarch,
-				SIGNAL (error (QProcess::ProcessError)),
-				this,
-				SLOT (handleUnarchError (QProcess::ProcessError)));
-#ifdef Q_OS_WIN32
-		unarch->start ("7za", QStringList ("e") << "-so" << pp.Location_);
-#else
-		unarch->start ("gunzip", QStringList ("-c") << pp.Location_);
-#endif
+		const auto& pp = PendingPackages_.take (id);
+		++UnpackingPackages_;
+
+		const auto& baseUrl = pp.BaseURL_;
+		const auto& name = pp.PackageName_;
+		const auto& versions = pp.NewVersions_;
+		Util::Sequence (this,
+				Unpack<PackageInfo> (pp.Location_,
+						[baseUrl, name, versions] (const QByteArray& data)
+							{ return ParsePackage (data, baseUrl, name, versions); })) >>
+				[this, pp] (const UnpackResult<PackageInfo>& result)
+				{
+					--UnpackingPackages_;
+					rotatePackageFetchQueue ();
+
+					if (!result.UnpackError_.isEmpty ())
+					{
+						emit gotEntity (Util::MakeNotification (tr ("Package unpack error"),
+								tr ("Unable to unpack the package file: %1. "
+									"Problematic file is at %2.")
+									.arg (result.UnpackError_)
+									.arg (pp.Location_),
+								PCritical_));
+						emit packageFetchFailed (pp.ComponentId_);
+						return;
+					}
+
+					if (!result.ParseError_.isEmpty ())
+					{
+						qWarning () << Q_FUNC_INFO
+								<< result.ParseError_;
+						emit gotEntity (Util::MakeNotification (tr ("Package parse error"),
+								tr ("Unable to parse package description file. "
+									"More information is available in logs."),
+								PCritical_));
+						emit packageFetchFailed (pp.ComponentId_);
+						return;
+					}
+
+					emit packageFetched (result.Value_, pp.ComponentId_);
+				};
 	}
 
 	void RepoInfoFetcher::handlePackageRemoved (int id)
@@ -375,7 +492,10 @@ namespace LackMan
 		if (!PendingPackages_.contains (id))
 			return;
 
-		PendingPackages_.remove (id);
+		const auto& pp = PendingPackages_.take (id);
+		emit packageFetchFailed (pp.ComponentId_);
+
+		rotatePackageFetchQueue ();
 	}
 
 	void RepoInfoFetcher::handlePackageError (int id, IDownload::Error)
@@ -383,7 +503,7 @@ namespace LackMan
 		if (!PendingPackages_.contains (id))
 			return;
 
-		PendingPackage pp = PendingPackages_.take (id);
+		const auto& pp = PendingPackages_.take (id);
 
 		QFile::remove (pp.Location_);
 
@@ -391,145 +511,9 @@ namespace LackMan
 				tr ("Error fetching package from %1.")
 					.arg (pp.URL_.toString ()),
 				PCritical_));
-	}
-
-	void RepoInfoFetcher::handleRepoUnarchFinished (int exitCode,
-			QProcess::ExitStatus)
-	{
-		sender ()->deleteLater ();
-
-		if (exitCode)
-		{
-			emit gotEntity (Util::MakeNotification (tr ("Repository unpack error"),
-					tr ("Unable to unpack the repository file. gunzip error: %1. "
-						"Problematic file is at %2.")
-						.arg (exitCode)
-						.arg (sender ()->property ("Filename").toString ()),
-					PCritical_));
-			return;
-		}
-
-		QByteArray data = qobject_cast<QProcess*> (sender ())->readAllStandardOutput ();
-		QFile::remove (sender ()->property ("Filename").toString ());
-
-		RepoInfo info;
-		try
-		{
-			info = ParseRepoInfo (sender ()->property ("URL").toUrl (), QString (data));
-		}
-		catch (const QString& error)
-		{
-			qWarning () << Q_FUNC_INFO
-					<< error;
-			emit gotEntity (Util::MakeNotification (tr ("Repository parse error"),
-					tr ("Unable to parse repository description: %1.")
-						.arg (error),
-					PCritical_));
-			return;
-		}
-
-		emit infoFetched (info);
-	}
-
-	void RepoInfoFetcher::handleComponentUnarchFinished (int exitCode,
-			QProcess::ExitStatus)
-	{
-		sender ()->deleteLater ();
-
-		if (exitCode)
-		{
-			emit gotEntity (Util::MakeNotification (tr ("Component unpack error"),
-					tr ("Unable to unpack the component file. gunzip error: %1. "
-						"Problematic file is at %2.")
-						.arg (exitCode)
-						.arg (sender ()->property ("Filename").toString ()),
-					PCritical_));
-			return;
-		}
-
-		QByteArray data = qobject_cast<QProcess*> (sender ())->readAllStandardOutput ();
-		QFile::remove (sender ()->property ("Filename").toString ());
-
-		PackageShortInfoList infos;
-		try
-		{
-			infos = ParseComponent (data);
-		}
-		catch (const std::exception& e)
-		{
-			qWarning () << Q_FUNC_INFO
-					<< e.what ();
-			emit gotEntity (Util::MakeNotification (tr ("Component parse error"),
-					tr ("Unable to parse component %1 description file. "
-						"More information is available in logs.")
-						.arg (sender ()->property ("Component").toString ()),
-					PCritical_));
-			return;
-		}
-
-		emit componentFetched (infos,
-				sender ()->property ("Component").toString (),
-				sender ()->property ("RepoID").toInt ());
-	}
-
-	void RepoInfoFetcher::handlePackageUnarchFinished (int exitCode,
-			QProcess::ExitStatus)
-	{
-		sender ()->deleteLater ();
+		emit packageFetchFailed (pp.ComponentId_);
 
-		int id = sender ()->property ("TaskID").toInt ();
-		PendingPackage pp = PendingPackages_.take (id);
-
-		if (exitCode)
-		{
-			emit gotEntity (Util::MakeNotification (tr ("Component unpack error"),
-					tr ("Unable to unpack the component file. gunzip error: %1. "
-						"Problematic file is at %2.")
-						.arg (exitCode)
-						.arg (sender ()->property ("Filename").toString ()),
-					PCritical_));
-			return;
-		}
-
-		QByteArray data = qobject_cast<QProcess*> (sender ())->readAllStandardOutput ();
-		QFile::remove (sender ()->property ("Filename").toString ());
-
-		PackageInfo packageInfo;
-		try
-		{
-			packageInfo = ParsePackage (data, pp.BaseURL_, pp.PackageName_, pp.NewVersions_);
-		}
-		catch (const std::exception& e)
-		{
-			qWarning () << Q_FUNC_INFO
-					<< e.what ();
-			emit gotEntity (Util::MakeNotification (tr ("Package parse error"),
-					tr ("Unable to parse package description file. "
-						"More information is available in logs."),
-					PCritical_));
-			return;
-		}
-
-		emit packageFetched (packageInfo, pp.ComponentId_);
-	}
-
-	void RepoInfoFetcher::handleUnarchError (QProcess::ProcessError error)
-	{
-		sender ()->deleteLater ();
-
-		qWarning () << Q_FUNC_INFO
-				<< "unable to unpack for"
-				<< sender ()->property ("URL").toUrl ()
-				<< sender ()->property ("Filename").toString ()
-				<< "with"
-				<< error
-				<< qobject_cast<QProcess*> (sender ())->readAllStandardError ();
-		emit gotEntity (Util::MakeNotification (tr ("Component unpack error"),
-					tr ("Unable to unpack file. Exit code: %1. "
-						"Problematic file is at %2.")
-						.arg (error)
-						.arg (sender ()->property ("Filename").toString ()),
-					PCritical_));
+		rotatePackageFetchQueue ();
 	}
 }
 }
@@ -31,7 +31,6 @@
 #define PLUGINS_LACKMAN_REPOINFOFETCHER_H
 #include <QObject>
 #include <QUrl>
-#include <QProcess>
 #include <QHash>
 #include <interfaces/idownload.h>
 #include "repoinfo.h"
@@ -79,9 +78,13 @@ namespace LackMan
 			int ComponentId_;
 		};
 		QHash<int, PendingPackage> PendingPackages_;
+		int UnpackingPackages_ = 0;
+		int MaxPackageFetches_ = 4;
 	public:
 		RepoInfoFetcher (QObject*);
 
+		void SetMaxPackageFetches (int);
+
 		void FetchFor (QUrl);
 		void FetchComponent (QUrl, int, const QString& component);
 		void ScheduleFetchPackageInfo (const QUrl& url,
@@ -105,19 +108,15 @@ namespace LackMan
 		void handlePackageFinished (int);
 		void handlePackageRemoved (int);
 		void handlePackageError (int, IDownload::Error);
-
-		void handleRepoUnarchFinished (int, QProcess::ExitStatus);
-		void handleComponentUnarchFinished (int, QProcess::ExitStatus);
-		void handlePackageUnarchFinished (int, QProcess::ExitStatus);
-		void handleUnarchError (QProcess::ProcessError);
 	signals:
 		void delegateEntity (const LeechCraft::Entity&, int*, QObject**);
 		void gotEntity (const LeechCraft::Entity&);
 
 		void infoFetched (const RepoInfo&);
 		void componentFetched (const PackageShortInfoList& packages,
-				const QString& component, int repoId);
+				const QString& component, int repoId, const QByteArray& hash);
 		void packageFetched (const PackageInfo&, int componentId);
+		void packageFetchFailed (int componentId);
 	};
 }
 }
@@ -0,0 +1,239 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "gunziptest.h"
+#include <stdexcept>
+#include <zlib.h>
+#include <QtTest>
+#include <QBuffer>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include <QtConcurrentMap>
+#include "../gunzip.h"
+#include "../xmlparsers.h"
+
+QTEST_MAIN (LeechCraft::LackMan::GunzipTest)
+
+namespace LeechCraft
+{
+namespace LackMan
+{
+	namespace
+	{
+		const int MirrorPackages = 500;
+
+		QByteArray Gzip (const QByteArray& data)
+		{
+			z_stream stream {};
+			if (deflateInit2 (&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+					16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				throw std::runtime_error { "cannot initialize zlib" };
+
+			QByteArray result;
+			result.resize (deflateBound (&stream, data.size ()));
+
+			stream.next_in = reinterpret_cast<Bytef*> (const_cast<char*> (data.constData ()));
+			stream.avail_in = data.size ();
+			stream.next_out = reinterpret_cast<Bytef*> (result.data ());
+			stream.avail_out = result.size ();
+
+			const auto rc = deflate (&stream, Z_FINISH);
+			deflateEnd (&stream);
+			if (rc != Z_STREAM_END)
+				throw std::runtime_error { "cannot compress" };
+
+			result.resize (result.size () - stream.avail_out);
+			return result;
+		}
+
+		QByteArray MakeData (int size)
+		{
+			QByteArray result;
+			result.reserve (size);
+			for (int i = 0; result.size () < size; ++i)
+				result += QByteArray::number (i * 7919 % 104729) + ' ';
+			result.resize (size);
+			return result;
+		}
+
+		QByteArray Gunzip (const QByteArray& data, QCryptographicHash *hash = nullptr)
+		{
+			QBuffer buffer;
+			buffer.setData (data);
+			buffer.open (QIODevice::ReadOnly);
+			return LackMan::Gunzip (&buffer, hash);
+		}
+
+		QByteArray MakePackage (int num)
+		{
+			QString longDescr;
+			for (int i = 0; i < 50; ++i)
+				longDescr += "A long description of the package, repeated a few times. ";
+
+			return QString (R"(<?xml version="1.0" encoding="UTF-8"?>
+<package type="plugin">
+	<description>Package %1</description>
+	<long>%2</long>
+	<images>
+		<thumbnail url="thumb%1.png"/>
+		<screenshot url="shot%1.png"/>
+		<icon url="icon%1.svg"/>
+	</images>
+	<tags>
+		<tag>tag%1</tag>
+		<tag>common</tag>
+	</tags>
+	<versions>
+		<version size="123456">0.6.%1</version>
+	</versions>
+	<maintainer>
+		<name>Maintainer</name>
+		<email>maintainer@example.com</email>
+	</maintainer>
+	<depends>
+		<depend thisVersion="0.6.%1" name="core" version="0.6"/>
+	</depends>
+</package>
+)")
+					.arg (num)
+					.arg (longDescr)
+					.toUtf8 ();
+		}
+
+		PackageInfo ParseMirrorFile (const QString& path)
+		{
+			QFile file { path };
+			if (!file.open (QIODevice::ReadOnly))
+				throw std::runtime_error { "cannot open file" };
+
+			const auto& name = QFileInfo { path }.baseName ();
+			return ParsePackage (LackMan::Gunzip (&file),
+					QUrl { "http://example.com/repo/" },
+					name,
+					{ name.mid (7) });
+		}
+	}
+
+	void GunzipTest::initTestCase ()
+	{
+		Mirror_ = std::make_shared<QTemporaryDir> ();
+		QVERIFY (Mirror_->isValid ());
+
+		for (int i = 0; i < MirrorPackages; ++i)
+		{
+			const auto& path = Mirror_->path () + QString ("/package%1.xml.gz").arg (i);
+
+			QFile file { path };
+			QVERIFY (file.open (QIODevice::WriteOnly));
+			file.write (Gzip (MakePackage (i)));
+
+			MirrorFiles_ << path;
+		}
+	}
+
+	void GunzipTest::testRoundTrip ()
+	{
+		for (int size : { 0, 1, 1000, 64 * 1024, 64 * 1024 + 1, 1024 * 1024 })
+		{
+			const auto& data = MakeData (size);
+			QCOMPARE (Gunzip (Gzip (data)), data);
+		}
+	}
+
+	void GunzipTest::testConcatenated ()
+	{
+		const auto& first = MakeData (100 * 1000);
+		const auto& second = MakeData (1000);
+		QCOMPARE (Gunzip (Gzip (first) + Gzip (second)), first + second);
+	}
+
+	void GunzipTest::testHash ()
+	{
+		const auto& compressed = Gzip (MakeData (200 * 1000));
+
+		QCryptographicHash hash { QCryptographicHash::Sha1 };
+		Gunzip (compressed, &hash);
+		QCOMPARE (hash.result (), QCryptographicHash::hash (compressed, QCryptographicHash::Sha1));
+	}
+
+	void GunzipTest::testCorrupted ()
+	{
+		QVERIFY_EXCEPTION_THROWN (Gunzip ("not a gzip file"), std::runtime_error);
+		QVERIFY_EXCEPTION_THROWN (Gunzip ({}), std::runtime_error);
+
+		auto compressed = Gzip (MakeData (10000));
+		compressed [compressed.size () / 2] = ~compressed [compressed.size () / 2];
+		QVERIFY_EXCEPTION_THROWN (Gunzip (compressed), std::runtime_error);
+	}
+
+	void GunzipTest::testTruncated ()
+	{
+		const auto& compressed = Gzip (MakeData (100 * 1000));
+		QVERIFY_EXCEPTION_THROWN (Gunzip (compressed.left (compressed.size () - 4)), std::runtime_error);
+		QVERIFY_EXCEPTION_THROWN (Gunzip (compressed.left (compressed.size () / 2)), std::runtime_error);
+	}
+
+	/* The way the package descriptions were processed before: one
+	 * external gunzip process per file, one file at a time.
+	 */
+	void GunzipTest::benchmarkMirrorExternal ()
+	{
+#ifdef Q_OS_WIN32
+		QSKIP ("gunzip is not available");
+#endif
+
+		QBENCHMARK_ONCE
+		{
+			for (const auto& path : MirrorFiles_)
+			{
+				QProcess unarch;
+				unarch.start ("gunzip", { "-c", path });
+				QVERIFY (unarch.waitForFinished ());
+
+				const auto& name = QFileInfo { path }.baseName ();
+				ParsePackage (unarch.readAllStandardOutput (),
+						QUrl { "http://example.com/repo/" },
+						name,
+						{ name.mid (7) });
+			}
+		}
+	}
+
+	void GunzipTest::benchmarkMirrorInProcess ()
+	{
+		QBENCHMARK_ONCE
+		{
+			const auto& infos = QtConcurrent::blockingMapped (MirrorFiles_, &ParseMirrorFile);
+			QCOMPARE (infos.size (), MirrorPackages);
+		}
+	}
+}
+}
@@ -0,0 +1,371 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "repoinfofetchertest.h"
+#include <stdexcept>
+#include <algorithm>
+#include <zlib.h>
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <interfaces/structures.h>
+#include <util/sll/delayedexecutor.h>
+#include "../repoinfofetcher.h"
+#include "../componenthashes.h"
+
+QTEST_MAIN (LeechCraft::LackMan::RepoInfoFetcherTest)
+
+namespace LeechCraft
+{
+namespace LackMan
+{
+	namespace
+	{
+		const int MirrorPackages = 40;
+		const int MaxFetches = 3;
+		const int Timeout = 20000;
+
+		QByteArray Gzip (const QByteArray& data)
+		{
+			z_stream stream {};
+			if (deflateInit2 (&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+					16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				throw std::runtime_error { "cannot initialize zlib" };
+
+			QByteArray result;
+			result.resize (deflateBound (&stream, data.size ()));
+
+			stream.next_in = reinterpret_cast<Bytef*> (const_cast<char*> (data.constData ()));
+			stream.avail_in = data.size ();
+			stream.next_out = reinterpret_cast<Bytef*> (result.data ());
+			stream.avail_out = result.size ();
+
+			const auto rc = deflate (&stream, Z_FINISH);
+			deflateEnd (&stream);
+			if (rc != Z_STREAM_END)
+				throw std::runtime_error { "cannot compress" };
+
+			result.resize (result.size () - stream.avail_out);
+			return result;
+		}
+
+		bool WriteGzipped (const QString& path, const QByteArray& data)
+		{
+			QFile file { path };
+			return file.open (QIODevice::WriteOnly) &&
+					file.write (Gzip (data)) > 0;
+		}
+
+		QString GetName (int num)
+		{
+			return QString ("package%1").arg (num);
+		}
+
+		QString GetVersion (int num)
+		{
+			return QString ("0.6.%1").arg (num);
+		}
+
+		QByteArray MakePackage (int num)
+		{
+			return QString (R"(<?xml version="1.0" encoding="UTF-8"?>
+<package type="plugin">
+	<description>Package %1</description>
+	<long>Long description of package %1.</long>
+	<tags>
+		<tag>tag%1</tag>
+	</tags>
+	<versions>
+		<version size="1024">%2</version>
+	</versions>
+	<maintainer>
+		<name>Maintainer</name>
+		<email>maintainer@example.com</email>
+	</maintainer>
+</package>
+)")
+					.arg (num)
+					.arg (GetVersion (num))
+					.toUtf8 ();
+		}
+
+		QByteArray MakeComponent (const QList<int>& nums)
+		{
+			QString result = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<packages>\n";
+			for (const auto num : nums)
+				result += QString ("\t<package><name>%1</name><versions><version>%2</version></versions></package>\n")
+						.arg (GetName (num))
+						.arg (GetVersion (num));
+			result += "</packages>\n";
+			return result.toUtf8 ();
+		}
+
+		void Connect (RepoInfoFetcher *fetcher, FakeDownloader *downloader, FetchRecorder *recorder)
+		{
+			QObject::connect (fetcher,
+					SIGNAL (delegateEntity (LeechCraft::Entity, int*, QObject**)),
+					downloader,
+					SLOT (handleDelegate (LeechCraft::Entity, int*, QObject**)),
+					Qt::DirectConnection);
+			QObject::connect (fetcher,
+					SIGNAL (packageFetched (PackageInfo, int)),
+					recorder,
+					SLOT (handlePackageFetched (PackageInfo, int)));
+			QObject::connect (fetcher,
+					SIGNAL (packageFetchFailed (int)),
+					recorder,
+					SLOT (handlePackageFetchFailed (int)));
+			QObject::connect (fetcher,
+					SIGNAL (componentFetched (PackageShortInfoList, QString, int, QByteArray)),
+					recorder,
+					SLOT (handleComponentFetched (PackageShortInfoList, QString, int, QByteArray)));
+		}
+
+		void ScheduleComponentPackages (RepoInfoFetcher *fetcher,
+				const QUrl& baseUrl, const PackageShortInfoList& packages, int componentId)
+		{
+			for (const auto& info : packages)
+				fetcher->ScheduleFetchPackageInfo (baseUrl, info.Name_, info.Versions_, componentId);
+		}
+	}
+
+	void FakeDownloader::handleDelegate (const Entity& e, int *id, QObject **pr)
+	{
+		const int jobId = ++LastId_;
+		*id = jobId;
+		*pr = this;
+
+		++Requests_;
+		MaxInFlight_ = std::max (MaxInFlight_, ++InFlight_);
+
+		QFile::remove (e.Location_);
+		const bool copied = QFile::copy (e.Entity_.toUrl ().toLocalFile (), e.Location_);
+
+		new Util::DelayedExecutor
+		{
+			[this, jobId, copied]
+			{
+				--InFlight_;
+				if (copied)
+					emit jobFinished (jobId);
+				else
+					emit jobError (jobId, IDownload::ENotFound);
+			},
+			5
+		};
+	}
+
+	void FetchRecorder::handlePackageFetched (const PackageInfo& info, int componentId)
+	{
+		Fetched_ << info.Name_;
+		if (Hashes_)
+			Hashes_->HandlePackageFetched (componentId);
+	}
+
+	void FetchRecorder::handlePackageFetchFailed (int componentId)
+	{
+		++Failed_;
+		if (Hashes_)
+			Hashes_->Forget (componentId);
+	}
+
+	void FetchRecorder::handleComponentFetched (const PackageShortInfoList& packages,
+			const QString&, int, const QByteArray& hash)
+	{
+		Packages_ = packages;
+		Hash_ = hash;
+		++Components_;
+	}
+
+	void RepoInfoFetcherTest::initTestCase ()
+	{
+		QCoreApplication::setOrganizationName ("LeechCraftTest");
+		QCoreApplication::setApplicationName ("lc_lackman_repoinfofetchertest");
+
+		Mirror_ = std::make_shared<QTemporaryDir> ();
+		QVERIFY (Mirror_->isValid ());
+
+		for (int i = 0; i < MirrorPackages; ++i)
+			QVERIFY (WriteGzipped (Mirror_->path () + '/' + GetName (i) + ".xml.gz", MakePackage (i)));
+
+		QVERIFY (QDir { Mirror_->path () }.mkdir ("component"));
+	}
+
+	void RepoInfoFetcherTest::cleanup ()
+	{
+		QSettings settings (QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "_LackMan");
+		settings.clear ();
+	}
+
+	void RepoInfoFetcherTest::testConcurrencyCap ()
+	{
+		RepoInfoFetcher fetcher { nullptr };
+		FakeDownloader downloader;
+		FetchRecorder recorder;
+		Connect (&fetcher, &downloader, &recorder);
+
+		fetcher.SetMaxPackageFetches (MaxFetches);
+
+		const auto& baseUrl = QUrl::fromLocalFile (Mirror_->path () + '/');
+		QStringList expected;
+		for (int i = 0; i < MirrorPackages; ++i)
+		{
+			fetcher.ScheduleFetchPackageInfo (baseUrl, GetName (i), { GetVersion (i) }, 1);
+			expected << GetName (i);
+		}
+
+		QTRY_COMPARE_WITH_TIMEOUT (recorder.Fetched_.size (), MirrorPackages, Timeout);
+		QCOMPARE (recorder.Failed_, 0);
+		QCOMPARE (downloader.Requests_, MirrorPackages);
+		QCOMPARE (downloader.MaxInFlight_, MaxFetches);
+
+		recorder.Fetched_.sort ();
+		expected.sort ();
+		QCOMPARE (recorder.Fetched_, expected);
+	}
+
+	void RepoInfoFetcherTest::testFailedPackage ()
+	{
+		RepoInfoFetcher fetcher { nullptr };
+		FakeDownloader downloader;
+		FetchRecorder recorder;
+		Connect (&fetcher, &downloader, &recorder);
+
+		fetcher.SetMaxPackageFetches (1);
+
+		const auto& baseUrl = QUrl::fromLocalFile (Mirror_->path () + '/');
+		for (int i = 0; i < 5; ++i)
+			fetcher.ScheduleFetchPackageInfo (baseUrl, GetName (i), { GetVersion (i) }, 1);
+		fetcher.ScheduleFetchPackageInfo (baseUrl, "missing", { "1.0" }, 1);
+		for (int i = 5; i < 10; ++i)
+			fetcher.ScheduleFetchPackageInfo (baseUrl, GetName (i), { GetVersion (i) }, 1);
+
+		// The failed download must free its slot, or the queue stalls.
+		QTRY_COMPARE_WITH_TIMEOUT (recorder.Fetched_.size (), 10, Timeout);
+		QCOMPARE (recorder.Failed_, 1);
+		QCOMPARE (downloader.MaxInFlight_, 1);
+	}
+
+	void RepoInfoFetcherTest::testUnchangedComponentSkipped ()
+	{
+		const auto& componentDir = Mirror_->path () + "/component";
+		QVERIFY (WriteGzipped (componentDir + "/Packages.xml.gz", MakeComponent ({ 0, 1, 2, 3, 4 })));
+
+		ComponentHashes hashes;
+		RepoInfoFetcher fetcher { nullptr };
+		FakeDownloader downloader;
+		FetchRecorder recorder;
+		recorder.Hashes_ = &hashes;
+		Connect (&fetcher, &downloader, &recorder);
+
+		const auto& repoUrl = QUrl::fromLocalFile (Mirror_->path () + '/');
+		const auto& key = ComponentHashes::MakeKey (repoUrl, "component");
+
+		fetcher.FetchComponent (QUrl::fromLocalFile (componentDir), 1, "component");
+		QTRY_COMPARE_WITH_TIMEOUT (recorder.Components_, 1, Timeout);
+		QCOMPARE (recorder.Packages_.size (), 5);
+
+		const auto firstHash = recorder.Hash_;
+		QVERIFY (!firstHash.isEmpty ());
+		QVERIFY (!hashes.IsUnchanged (key, firstHash));
+
+		hashes.Expect (1, key, firstHash, recorder.Packages_.size ());
+		ScheduleComponentPackages (&fetcher, repoUrl, recorder.Packages_, 1);
+
+		QTRY_COMPARE_WITH_TIMEOUT (recorder.Fetched_.size (), 5, Timeout);
+		QVERIFY (hashes.IsUnchanged (key, firstHash));
+
+		fetcher.FetchComponent (QUrl::fromLocalFile (componentDir), 1, "component");
+		QTRY_COMPARE_WITH_TIMEOUT (recorder.Components_, 2, Timeout);
+		QCOMPARE (recorder.Hash_, firstHash);
+		QVERIFY (hashes.IsUnchanged (key, recorder.Hash_));
+	}
+
+	void RepoInfoFetcherTest::testChangedComponentFetched ()
+	{
+		const auto& componentDir = Mirror_->path () + "/component";
+		QVERIFY (WriteGzipped (componentDir + "/Packages.xml.gz", MakeComponent ({ 0, 1 })));
+
+		ComponentHashes hashes;
+		RepoInfoFetcher fetcher { nullptr };
+		FakeDownloader downloader;
+		FetchRecorder recorder;
+		recorder.Hashes_ = &hashes;
+		Connect (&fetcher, &downloader, &recorder);
+
+		const auto& repoUrl = QUrl::fromLocalFile (Mirror_->path () + '/');
+		const auto& key = ComponentHashes::MakeKey (repoUrl, "component");
+
+		fetcher.FetchComponent (QUrl::fromLocalFile (componentDir), 1, "component");
+		QTRY_COMPARE_WITH_TIMEOUT (recorder.Components_, 1, Timeout);
+		hashes.Expect (1, key, recorder.Hash_, 0);
+		QVERIFY (hashes.IsUnchanged (key, recorder.Hash_));
+
+		QVERIFY (WriteGzipped (componentDir + "/Packages.xml.gz", MakeComponent ({ 0, 1, 2 })));
+
+		fetcher.FetchComponent (QUrl::fromLocalFile (componentDir), 1, "component");
+		QTRY_COMPARE_WITH_TIMEOUT (recorder.Components_, 2, Timeout);
+		QCOMPARE (recorder.Packages_.size (), 3);
+		QVERIFY (!hashes.IsUnchanged (key, recorder.Hash_));
+	}
+
+	void RepoInfoFetcherTest::testIncompleteComponentNotCommitted ()
+	{
+		const auto& componentDir = Mirror_->path () + "/component";
+		auto component = MakeComponent ({ 0, 1, 2 });
+		component.replace ("</packages>",
+				"\t<package><name>missing</name><versions><version>1.0</version></versions></package>\n</packages>");
+		QVERIFY (WriteGzipped (componentDir + "/Packages.xml.gz", component));
+
+		ComponentHashes hashes;
+		RepoInfoFetcher fetcher { nullptr };
+		FakeDownloader downloader;
+		FetchRecorder recorder;
+		recorder.Hashes_ = &hashes;
+		Connect (&fetcher, &downloader, &recorder);
+
+		const auto& repoUrl = QUrl::fromLocalFile (Mirror_->path () + '/');
+		const auto& key = ComponentHashes::MakeKey (repoUrl, "component");
+
+		fetcher.FetchComponent (QUrl::fromLocalFile (componentDir), 1, "component");
+		QTRY_COMPARE_WITH_TIMEOUT (recorder.Components_, 1, Timeout);
+		QCOMPARE (recorder.Packages_.size (), 4);
+
+		hashes.Expect (1, key, recorder.Hash_, recorder.Packages_.size ());
+		ScheduleComponentPackages (&fetcher, repoUrl, recorder.Packages_, 1);
+
+		QTRY_COMPARE_WITH_TIMEOUT (recorder.Fetched_.size () + recorder.Failed_, 4, Timeout);
+		QCOMPARE (recorder.Failed_, 1);
+		QVERIFY (!hashes.IsUnchanged (key, recorder.Hash_));
+	}
+}
+}
@@ -0,0 +1,107 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QObject>
+#include <QStringList>
+#include <interfaces/idownload.h>
+#include "../repoinfo.h"
+
+class QTemporaryDir;
+
+namespace LeechCraft
+{
+struct Entity;
+
+namespace LackMan
+{
+	/** Serves the download requests of RepoInfoFetcher from the local
+	 * file system, finishing each of them asynchronously like a real
+	 * downloader does.
+	 */
+	class FakeDownloader : public QObject
+	{
+		Q_OBJECT
+
+		int LastId_ = 0;
+		int InFlight_ = 0;
+	public:
+		int MaxInFlight_ = 0;
+		int Requests_ = 0;
+	public slots:
+		void handleDelegate (const LeechCraft::Entity&, int*, QObject**);
+	signals:
+		void jobFinished (int);
+		void jobRemoved (int);
+		void jobError (int, IDownload::Error);
+	};
+
+	class ComponentHashes;
+
+	/** Records what RepoInfoFetcher reports and feeds the package
+	 * results into ComponentHashes the same way Core does.
+	 */
+	class FetchRecorder : public QObject
+	{
+		Q_OBJECT
+	public:
+		ComponentHashes *Hashes_ = nullptr;
+
+		QStringList Fetched_;
+		int Failed_ = 0;
+
+		PackageShortInfoList Packages_;
+		QByteArray Hash_;
+		int Components_ = 0;
+	public slots:
+		void handlePackageFetched (const PackageInfo&, int);
+		void handlePackageFetchFailed (int);
+		void handleComponentFetched (const PackageShortInfoList&,
+				const QString&, int, const QByteArray&);
+	};
+
+	class RepoInfoFetcherTest : public QObject
+	{
+		Q_OBJECT
+
+		std::shared_ptr<QTemporaryDir> Mirror_;
+	private slots:
+		void initTestCase ();
+		void cleanup ();
+
+		void testConcurrencyCap ();
+		void testFailedPackage ();
+		void testUnchangedComponentSkipped ();
+		void testChangedComponentFetched ();
+		void testIncompleteComponentNotCommitted ();
+	};
+}
+}
@@ -235,6 +235,14 @@ namespace Liznoo
 		}
 	}
 
+	QList<EntityRoutingRule> Plugin::GetEntityRoutingRules () const
+	{
+		EntityRoutingRule rule;
+		rule.Mimes_ << "x-leechcraft/power-management";
+		rule.StaticResult_ = EntityTestHandleResult { EntityTestHandleResult::PIdeal };
+		return { rule };
+	}
+
 	QList<QAction*> Plugin::GetActions (ActionsEmbedPlace place) const
 	{
 		QList<QAction*> result;
@@ -34,6 +34,7 @@
 #include <interfaces/iinfo.h>
 #include <interfaces/ihavesettings.h>
 #include <interfaces/ientityhandler.h>
+#include <interfaces/ientityroutingrules.h>
 #include <interfaces/iactionsexporter.h>
 #include "batteryhistory.h"
 #include "batteryinfo.h"
@@ -69,10 +70,11 @@ namespace Liznoo
 				 , public IInfo
 				 , public IHaveSettings
 				 , public IEntityHandler
+				 , public IEntityRoutingRules
 				 , public IActionsExporter
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IHaveSettings IEntityHandler IActionsExporter)
+		Q_INTERFACES (IInfo IHaveSettings IEntityHandler IEntityRoutingRules IActionsExporter)
 
 		LC_PLUGIN_METADATA ("org.LeechCraft.Liznoo")
 
@@ -106,6 +108,8 @@ namespace Liznoo
 		EntityTestHandleResult CouldHandle (const Entity& entity) const;
 		void Handle (Entity entity);
 
+		QList<EntityRoutingRule> GetEntityRoutingRules () const;
+
 		QList<QAction*> GetActions (ActionsEmbedPlace) const;
 		QMap<QString, QList<QAction*>> GetMenuActions () const;
 	private:
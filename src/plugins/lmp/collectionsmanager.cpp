@@ -59,15 +59,20 @@ namespace LMP
 		return Sorter_;
 	}
 
+	QModelIndex CollectionsManager::MapToSource (const QModelIndex& index) const
+	{
+		auto srcIdx = Model_->mapToSource (Sorter_->mapToSource (index));
+		if (auto proxyModel = qobject_cast<const QSortFilterProxyModel*> (srcIdx.model ()))
+			srcIdx = proxyModel->mapToSource (srcIdx);
+		return srcIdx;
+	}
+
 	void CollectionsManager::Enqueue (const QList<QModelIndex>& indexes, Player *player)
 	{
 		QList<AudioSource> sources;
 		for (const auto& idx : indexes)
 		{
-			auto srcIdx = Model_->mapToSource (Sorter_->mapToSource (idx));
-			if (auto proxyModel = qobject_cast<const QSortFilterProxyModel*> (srcIdx.model ()))
-				srcIdx = proxyModel->mapToSource (srcIdx);
-
+			const auto& srcIdx = MapToSource (idx);
 			const auto& urls = dynamic_cast<const ICollectionModel*> (srcIdx.model ())->ToSourceUrls ({ srcIdx });
 			for (const auto& url : urls)
 				sources << url;
@@ -58,6 +58,7 @@ namespace LMP
 		void Add (QAbstractItemModel*);
 
 		QAbstractItemModel* GetModel () const;
+		QModelIndex MapToSource (const QModelIndex&) const;
 
 		void Enqueue (const QList<QModelIndex>&, Player*);
 	};
@@ -63,11 +63,17 @@ namespace LMP
 		protected:
 			bool filterAcceptsRow (int sourceRow, const QModelIndex& sourceParent) const
 			{
+				const auto& pattern = filterRegExp ().pattern ();
+				if (pattern.isEmpty ())
+					return true;
+
 				const auto& source = sourceModel ()->index (sourceRow, 0, sourceParent);
-				const auto type = source.data (LocalCollectionModel::Role::Node).toInt ();
 
-				const auto& pattern = filterRegExp ().pattern ();
+				const auto& collIdx = Core::Instance ().GetCollectionsManager ()->MapToSource (source);
+				if (const auto collModel = qobject_cast<const LocalCollectionModel*> (collIdx.model ()))
+					return collModel->IsFilterMatch (collIdx, pattern);
 
+				const auto type = source.data (LocalCollectionModel::Role::Node).toInt ();
 				if (type != LocalCollectionModel::NodeType::Track)
 					for (int i = 0, rc = sourceModel ()->rowCount (source); i < rc; ++i)
 						if (filterAcceptsRow (i, source))
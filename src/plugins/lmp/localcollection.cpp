@@ -93,7 +93,7 @@ namespace LMP
 
 	void LocalCollection::FinalizeInit ()
 	{
-		CollectionModel_->FinalizeInit ();
+		CollectionModel_->FinalizeInit (Core::Instance ().GetProxy ());
 	}
 
 	bool LocalCollection::IsReady () const
@@ -28,41 +28,191 @@
  **********************************************************************/
 
 #include "localcollectionmodel.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
 #include <numeric>
 #include <QUrl>
 #include <QMimeData>
 #include <interfaces/core/iiconthememanager.h>
-#include "core.h"
-#include "localcollection.h"
 
 namespace LeechCraft
 {
 namespace LMP
 {
+	namespace
+	{
+		quintptr MakeNodeID (LocalCollectionModel::NodeType type, int node)
+		{
+			return (static_cast<quintptr> (node) << 2) | type;
+		}
+
+		LocalCollectionModel::NodeType GetNodeType (const QModelIndex& index)
+		{
+			return static_cast<LocalCollectionModel::NodeType> (index.internalId () & 0x3);
+		}
+
+		int GetNode (const QModelIndex& index)
+		{
+			return static_cast<int> (index.internalId () >> 2);
+		}
+
+		QString MakeAlbumText (int year, const QString& name)
+		{
+			return QString::fromUtf8 ("%1 — %2")
+					.arg (year)
+					.arg (name);
+		}
+
+		QString MakeTrackText (const Collection::Track& track)
+		{
+			return QString::fromUtf8 ("%1 — %2")
+					.arg (track.Number_)
+					.arg (track.Name_);
+		}
+
+		QString MakeSearchString (const QStringList& strings)
+		{
+			return strings.join ("\n").toLower ();
+		}
+
+		template<typename Node>
+		int AllocateNode (QVector<Node>& nodes, QVector<int>& freeNodes, const Node& node)
+		{
+			if (freeNodes.isEmpty ())
+			{
+				nodes.append (node);
+				return nodes.size () - 1;
+			}
+
+			const auto pos = freeNodes.last ();
+			freeNodes.removeLast ();
+			nodes [pos] = node;
+			return pos;
+		}
+
+		template<typename Node>
+		void FreeNode (QVector<Node>& nodes, QVector<int>& freeNodes, int pos)
+		{
+			nodes [pos] = Node {};
+			freeNodes << pos;
+		}
+
+		template<typename Node>
+		void RemoveChild (QVector<int>& children, QVector<Node>& nodes, int row)
+		{
+			children.remove (row);
+			for (int i = row; i < children.size (); ++i)
+				nodes [children.at (i)].Row_ = i;
+		}
+	}
+
 	LocalCollectionModel::LocalCollectionModel (QObject *parent)
-	: DndActionsMixin<QStandardItemModel> { parent }
+	: DndActionsMixin<QAbstractItemModel> { parent }
 	{
 		setSupportedDragActions (Qt::CopyAction);
 	}
 
-	QStringList LocalCollectionModel::mimeTypes () const
+	QModelIndex LocalCollectionModel::index (int row, int column, const QModelIndex& parent) const
 	{
-		return { "text/uri-list" };
+		if (!hasIndex (row, column, parent))
+			return {};
+
+		if (!parent.isValid ())
+			return createIndex (row, column, MakeNodeID (NodeType::Artist, RootArtists_.at (row)));
+
+		const auto parentNode = GetNode (parent);
+		switch (GetNodeType (parent))
+		{
+		case NodeType::Artist:
+			return createIndex (row, column,
+					MakeNodeID (NodeType::Album, Artists_.at (parentNode).Albums_.at (row)));
+		case NodeType::Album:
+			return createIndex (row, column,
+					MakeNodeID (NodeType::Track, Albums_.at (parentNode).Tracks_.at (row)));
+		case NodeType::Track:
+			break;
+		}
+
+		return {};
 	}
 
-	namespace
+	QModelIndex LocalCollectionModel::parent (const QModelIndex& index) const
 	{
-		QStringList CollectPaths (const QModelIndex& index, const QAbstractItemModel *model)
+		if (!index.isValid ())
+			return {};
+
+		const auto node = GetNode (index);
+		switch (GetNodeType (index))
 		{
-			const auto type = index.data (LocalCollectionModel::Role::Node).toInt ();
-			if (type == LocalCollectionModel::NodeType::Track)
-				return { index.data (LocalCollectionModel::Role::TrackPath).toString () };
+		case NodeType::Artist:
+			break;
+		case NodeType::Album:
+			return MakeIndex (NodeType::Artist, Albums_.at (node).Artist_);
+		case NodeType::Track:
+			return MakeIndex (NodeType::Album, Tracks_.at (node).Album_);
+		}
 
-			QStringList paths;
-			for (int i = 0; i < model->rowCount (index); ++i)
-				paths += CollectPaths (model->index (i, 0, index), model);
-			return paths;
+		return {};
+	}
+
+	int LocalCollectionModel::rowCount (const QModelIndex& parent) const
+	{
+		if (!parent.isValid ())
+			return RootArtists_.size ();
+
+		if (parent.column ())
+			return 0;
+
+		const auto node = GetNode (parent);
+		switch (GetNodeType (parent))
+		{
+		case NodeType::Artist:
+			return Artists_.at (node).Albums_.size ();
+		case NodeType::Album:
+			return Albums_.at (node).Tracks_.size ();
+		case NodeType::Track:
+			break;
 		}
+
+		return 0;
+	}
+
+	int LocalCollectionModel::columnCount (const QModelIndex&) const
+	{
+		return 1;
+	}
+
+	QVariant LocalCollectionModel::data (const QModelIndex& index, int role) const
+	{
+		if (!index.isValid ())
+			return {};
+
+		const auto node = GetNode (index);
+		switch (GetNodeType (index))
+		{
+		case NodeType::Artist:
+			return GetNodeData (Artists_.at (node), role);
+		case NodeType::Album:
+			return GetNodeData (Albums_.at (node), role);
+		case NodeType::Track:
+			return GetNodeData (Tracks_.at (node), role);
+		}
+
+		return {};
+	}
+
+	Qt::ItemFlags LocalCollectionModel::flags (const QModelIndex& index) const
+	{
+		if (!index.isValid ())
+			return Qt::NoItemFlags;
+
+		return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled;
+	}
+
+	QStringList LocalCollectionModel::mimeTypes () const
+	{
+		return { "text/uri-list" };
 	}
 
 	QMimeData* LocalCollectionModel::mimeData (const QModelIndexList& indexes) const
@@ -70,7 +220,7 @@ namespace LMP
 		QList<QUrl> urls;
 		for (const auto& index : indexes)
 		{
-			const auto& paths = CollectPaths (index, this);
+			const auto& paths = CollectPaths (index);
 			std::transform (paths.begin (), paths.end (), std::back_inserter (urls),
 					[] (const QString& path) { return QUrl::fromLocalFile (path); });
 		}
@@ -86,7 +236,7 @@ namespace LMP
 	{
 		const auto& paths = std::accumulate (indexes.begin (), indexes.end (), QStringList {},
 				[this] (const QStringList& paths, decltype (indexes.front ()) item)
-					{ return paths + CollectPaths (item, this); });
+					{ return paths + CollectPaths (item); });
 
 		QList<QUrl> result;
 		result.reserve (paths.size ());
@@ -95,122 +245,401 @@ namespace LMP
 		return result;
 	}
 
-	void LocalCollectionModel::FinalizeInit ()
+	void LocalCollectionModel::FinalizeInit (const ICoreProxy_ptr& proxy)
 	{
-		ArtistIcon_ = Core::Instance ().GetProxy ()->
-				GetIconThemeManager ()->GetIcon ("view-media-artist");
+		ArtistIcon_ = proxy->GetIconThemeManager ()->GetIcon ("view-media-artist");
 	}
 
-	namespace
+	void LocalCollectionModel::AddArtists (const Collection::Artists_t& artists)
 	{
-		template<typename T, typename U, typename Init, typename Parent>
-		QStandardItem* GetItem (T& c, U idx, Init f, Parent parent)
+		const auto isReset = RootArtists_.isEmpty ();
+		if (isReset)
+			beginResetModel ();
+
+		auto insertRows = [this, isReset] (const QModelIndex& parent,
+				int first, int count, const std::function<void ()>& inserter)
 		{
-			auto item = c [idx];
-			if (item)
-				return item;
+			if (!isReset)
+				beginInsertRows (parent, first, first + count - 1);
+			inserter ();
 
-			item = new QStandardItem ();
-			item->setEditable (false);
-			f (item);
-			parent->appendRow (item);
-			c [idx] = item;
-			return item;
-		}
-	}
+			// The views may query IsFilterMatch() from endInsertRows (),
+			// so the matches must already cover the new nodes.
+			InvalidateFilterMatches ();
+
+			if (!isReset)
+				endInsertRows ();
+		};
 
-	void LocalCollectionModel::AddArtists (const Collection::Artists_t& artists)
-	{
 		for (const auto& artist : artists)
 		{
-			auto artistItem = GetItem (Artist2Item_,
-					artist.ID_,
-					[this, &artist] (QStandardItem *item)
-					{
-						item->setIcon (ArtistIcon_);
-						item->setText (artist.Name_);
-						item->setData (artist.Name_, Role::ArtistName);
-						item->setData (NodeType::Artist, Role::Node);
-					},
-					this);
-			for (auto album : artist.Albums_)
+			auto artistNode = ArtistID2Node_.value (artist.ID_, -1);
+			if (artistNode == -1)
 			{
-				auto albumItem = GetItem (Album2Item_,
-						album->ID_,
-						[album, artist] (QStandardItem *item)
+				const auto row = RootArtists_.size ();
+				insertRows ({}, row, 1,
+						[&]
 						{
-							item->setText (QString::fromUtf8 ("%1 — %2")
-									.arg (album->Year_)
-									.arg (album->Name_));
-							item->setData (album->Year_, Role::AlbumYear);
-							item->setData (album->Name_, Role::AlbumName);
-							item->setData (artist.Name_, Role::ArtistName);
-							item->setData (NodeType::Album, Role::Node);
-							if (!album->CoverPath_.isEmpty ())
-								item->setData (album->CoverPath_, Role::AlbumArt);
-						},
-						artistItem);
+							artistNode = AllocateNode (Artists_, FreeArtists_, {
+									artist.ID_,
+									artist.Name_,
+									MakeSearchString ({ artist.Name_ }),
+									{},
+									row
+								});
+							RootArtists_ << artistNode;
+							ArtistID2Node_ [artist.ID_] = artistNode;
+						});
+			}
 
-				for (const auto& track : album->Tracks_)
+			for (const auto& album : artist.Albums_)
+			{
+				auto albumNode = AlbumID2Node_.value (album->ID_, -1);
+				if (albumNode == -1)
 				{
-					const QString& name = QString::fromUtf8 ("%1 — %2")
-							.arg (track.Number_)
-							.arg (track.Name_);
-					auto item = new QStandardItem (name);
-					item->setEditable (false);
-					item->setData (album->Year_, Role::AlbumYear);
-					item->setData (album->Name_, Role::AlbumName);
-					item->setData (artist.Name_, Role::ArtistName);
-					item->setData (track.Number_, Role::TrackNumber);
-					item->setData (track.Name_, Role::TrackTitle);
-					item->setData (track.FilePath_, Role::TrackPath);
-					item->setData (track.Genres_, Role::TrackGenres);
-					item->setData (track.Length_, Role::TrackLength);
-					item->setData (NodeType::Track, Role::Node);
-					albumItem->appendRow (item);
-
-					Track2Item_ [track.ID_] = item;
+					const auto row = Artists_.at (artistNode).Albums_.size ();
+					insertRows (MakeIndex (NodeType::Artist, artistNode), row, 1,
+							[&]
+							{
+								albumNode = AllocateNode (Albums_, FreeAlbums_, {
+										album->ID_,
+										album->Name_,
+										album->Year_,
+										album->CoverPath_,
+										MakeSearchString ({
+												MakeAlbumText (album->Year_, album->Name_),
+												album->Name_,
+												QString::number (album->Year_)
+											}),
+										artistNode,
+										{},
+										row
+									});
+								Artists_ [artistNode].Albums_ << albumNode;
+								AlbumID2Node_ [album->ID_] = albumNode;
+							});
 				}
+
+				QList<Collection::Track> newTracks;
+				for (const auto& track : album->Tracks_)
+					if (!TrackID2Node_.contains (track.ID_))
+						newTracks << track;
+				if (newTracks.isEmpty ())
+					continue;
+
+				const auto firstRow = Albums_.at (albumNode).Tracks_.size ();
+				insertRows (MakeIndex (NodeType::Album, albumNode), firstRow, newTracks.size (),
+						[&]
+						{
+							auto row = firstRow;
+							for (const auto& track : newTracks)
+							{
+								const auto trackNode = AllocateNode (Tracks_, FreeTracks_, {
+										track,
+										MakeSearchString ({ MakeTrackText (track), track.Name_ }),
+										albumNode,
+										row++
+									});
+								Albums_ [albumNode].Tracks_ << trackNode;
+								TrackID2Node_ [track.ID_] = trackNode;
+							}
+						});
 			}
 		}
+
+		if (isReset)
+			endResetModel ();
 	}
 
 	void LocalCollectionModel::Clear ()
 	{
-		clear ();
+		beginResetModel ();
+
+		Artists_.clear ();
+		Albums_.clear ();
+		Tracks_.clear ();
+		RootArtists_.clear ();
+
+		FreeArtists_.clear ();
+		FreeAlbums_.clear ();
+		FreeTracks_.clear ();
+
+		ArtistID2Node_.clear ();
+		AlbumID2Node_.clear ();
+		TrackID2Node_.clear ();
 
-		Artist2Item_.clear ();
-		Album2Item_.clear ();
-		Track2Item_.clear ();
+		InvalidateFilterMatches ();
+
+		endResetModel ();
 	}
 
 	void LocalCollectionModel::RemoveTrack (int id)
 	{
-		auto item = Track2Item_.take (id);
-		item->parent ()->removeRow (item->row ());
+		if (!TrackID2Node_.contains (id))
+			return;
+
+		const auto trackNode = TrackID2Node_.take (id);
+		const auto albumNode = Tracks_.at (trackNode).Album_;
+		const auto row = Tracks_.at (trackNode).Row_;
+
+		beginRemoveRows (MakeIndex (NodeType::Album, albumNode), row, row);
+		RemoveChild (Albums_ [albumNode].Tracks_, Tracks_, row);
+		FreeNode (Tracks_, FreeTracks_, trackNode);
+		InvalidateFilterMatches ();
+		endRemoveRows ();
 	}
 
 	void LocalCollectionModel::RemoveAlbum (int id)
 	{
-		auto item = Album2Item_.take (id);
-		item->parent ()->removeRow (item->row ());
+		if (!AlbumID2Node_.contains (id))
+			return;
+
+		const auto albumNode = AlbumID2Node_.take (id);
+		const auto artistNode = Albums_.at (albumNode).Artist_;
+		const auto row = Albums_.at (albumNode).Row_;
+
+		beginRemoveRows (MakeIndex (NodeType::Artist, artistNode), row, row);
+		RemoveChild (Artists_ [artistNode].Albums_, Albums_, row);
+		for (const auto trackNode : Albums_.at (albumNode).Tracks_)
+		{
+			TrackID2Node_.remove (Tracks_.at (trackNode).Track_.ID_);
+			FreeNode (Tracks_, FreeTracks_, trackNode);
+		}
+		FreeNode (Albums_, FreeAlbums_, albumNode);
+		InvalidateFilterMatches ();
+		endRemoveRows ();
 	}
 
 	QVariant LocalCollectionModel::GetTrackData (int trackId, LocalCollectionModel::Role role) const
 	{
-		const auto item = Track2Item_.value (trackId);
-		return item ? item->data (role) : QVariant ();
+		const auto trackNode = TrackID2Node_.value (trackId, -1);
+		return trackNode >= 0 ? GetNodeData (Tracks_.at (trackNode), role) : QVariant ();
 	}
 
 	void LocalCollectionModel::RemoveArtist (int id)
 	{
-		removeRow (Artist2Item_.take (id)->row ());
+		if (!ArtistID2Node_.contains (id))
+			return;
+
+		const auto artistNode = ArtistID2Node_.take (id);
+		const auto row = Artists_.at (artistNode).Row_;
+
+		beginRemoveRows ({}, row, row);
+		RemoveChild (RootArtists_, Artists_, row);
+		for (const auto albumNode : Artists_.at (artistNode).Albums_)
+		{
+			for (const auto trackNode : Albums_.at (albumNode).Tracks_)
+			{
+				TrackID2Node_.remove (Tracks_.at (trackNode).Track_.ID_);
+				FreeNode (Tracks_, FreeTracks_, trackNode);
+			}
+
+			AlbumID2Node_.remove (Albums_.at (albumNode).ID_);
+			FreeNode (Albums_, FreeAlbums_, albumNode);
+		}
+		FreeNode (Artists_, FreeArtists_, artistNode);
+		InvalidateFilterMatches ();
+		endRemoveRows ();
 	}
 
 	void LocalCollectionModel::SetAlbumArt (int id, const QString& path)
 	{
-		if (Album2Item_.contains (id))
-			Album2Item_ [id]->setData (path, Role::AlbumArt);
+		const auto albumNode = AlbumID2Node_.value (id, -1);
+		if (albumNode < 0)
+			return;
+
+		Albums_ [albumNode].CoverPath_ = path;
+
+		const auto& index = MakeIndex (NodeType::Album, albumNode);
+		emit dataChanged (index, index);
+	}
+
+	bool LocalCollectionModel::IsFilterMatch (const QModelIndex& index, const QString& pattern) const
+	{
+		if (pattern.isEmpty () || !index.isValid ())
+			return true;
+
+		if (FilterMatches_.Pattern_.isNull () ||
+				FilterMatches_.Pattern_.compare (pattern, Qt::CaseInsensitive))
+			RebuildFilterMatches (pattern);
+
+		const auto node = GetNode (index);
+		switch (GetNodeType (index))
+		{
+		case NodeType::Artist:
+			return FilterMatches_.Artists_.testBit (node);
+		case NodeType::Album:
+			return FilterMatches_.Albums_.testBit (node);
+		case NodeType::Track:
+			return FilterMatches_.Tracks_.testBit (node);
+		}
+
+		return false;
+	}
+
+	QModelIndex LocalCollectionModel::MakeIndex (NodeType type, int node) const
+	{
+		int row = 0;
+		switch (type)
+		{
+		case NodeType::Artist:
+			row = Artists_.at (node).Row_;
+			break;
+		case NodeType::Album:
+			row = Albums_.at (node).Row_;
+			break;
+		case NodeType::Track:
+			row = Tracks_.at (node).Row_;
+			break;
+		}
+
+		return createIndex (row, 0, MakeNodeID (type, node));
+	}
+
+	QVariant LocalCollectionModel::GetNodeData (const ArtistNode& artist, int role) const
+	{
+		switch (role)
+		{
+		case Qt::DisplayRole:
+		case Role::ArtistName:
+			return artist.Name_;
+		case Qt::DecorationRole:
+			return ArtistIcon_;
+		case Role::Node:
+			return NodeType::Artist;
+		default:
+			return {};
+		}
+	}
+
+	QVariant LocalCollectionModel::GetNodeData (const AlbumNode& album, int role) const
+	{
+		switch (role)
+		{
+		case Qt::DisplayRole:
+			return MakeAlbumText (album.Year_, album.Name_);
+		case Role::AlbumYear:
+			return album.Year_;
+		case Role::AlbumName:
+			return album.Name_;
+		case Role::ArtistName:
+			return Artists_.at (album.Artist_).Name_;
+		case Role::AlbumArt:
+			return album.CoverPath_.isEmpty () ?
+					QVariant () :
+					QVariant (album.CoverPath_);
+		case Role::Node:
+			return NodeType::Album;
+		default:
+			return {};
+		}
+	}
+
+	QVariant LocalCollectionModel::GetNodeData (const TrackNode& trackNode, int role) const
+	{
+		const auto& track = trackNode.Track_;
+		switch (role)
+		{
+		case Qt::DisplayRole:
+			return MakeTrackText (track);
+		case Role::AlbumYear:
+			return Albums_.at (trackNode.Album_).Year_;
+		case Role::AlbumName:
+			return Albums_.at (trackNode.Album_).Name_;
+		case Role::ArtistName:
+			return Artists_.at (Albums_.at (trackNode.Album_).Artist_).Name_;
+		case Role::TrackNumber:
+			return track.Number_;
+		case Role::TrackTitle:
+			return track.Name_;
+		case Role::TrackPath:
+			return track.FilePath_;
+		case Role::TrackGenres:
+			return track.Genres_;
+		case Role::TrackLength:
+			return track.Length_;
+		case Role::Node:
+			return NodeType::Track;
+		default:
+			return {};
+		}
+	}
+
+	QStringList LocalCollectionModel::CollectPaths (const QModelIndex& index) const
+	{
+		if (!index.isValid ())
+			return {};
+
+		auto collectAlbum = [this] (int albumNode)
+		{
+			QStringList paths;
+			for (const auto trackNode : Albums_.at (albumNode).Tracks_)
+				paths << Tracks_.at (trackNode).Track_.FilePath_;
+			return paths;
+		};
+
+		const auto node = GetNode (index);
+		switch (GetNodeType (index))
+		{
+		case NodeType::Artist:
+		{
+			QStringList paths;
+			for (const auto albumNode : Artists_.at (node).Albums_)
+				paths += collectAlbum (albumNode);
+			return paths;
+		}
+		case NodeType::Album:
+			return collectAlbum (node);
+		case NodeType::Track:
+			return { Tracks_.at (node).Track_.FilePath_ };
+		}
+
+		return {};
+	}
+
+	void LocalCollectionModel::RebuildFilterMatches (const QString& pattern) const
+	{
+		const auto& lowerPattern = pattern.toLower ();
+
+		FilterMatches_.Pattern_ = pattern;
+		FilterMatches_.Artists_.fill (false, Artists_.size ());
+		FilterMatches_.Albums_.fill (false, Albums_.size ());
+		FilterMatches_.Tracks_.fill (false, Tracks_.size ());
+
+		for (const auto artistNode : RootArtists_)
+		{
+			const auto& artist = Artists_.at (artistNode);
+			const auto artistMatches = artist.SearchString_.contains (lowerPattern);
+
+			bool anyAlbumMatches = false;
+			for (const auto albumNode : artist.Albums_)
+			{
+				const auto& album = Albums_.at (albumNode);
+				const auto albumMatches = artistMatches || album.SearchString_.contains (lowerPattern);
+
+				bool anyTrackMatches = false;
+				for (const auto trackNode : album.Tracks_)
+					if (albumMatches || Tracks_.at (trackNode).SearchString_.contains (lowerPattern))
+					{
+						FilterMatches_.Tracks_.setBit (trackNode);
+						anyTrackMatches = true;
+					}
+
+				if (albumMatches || anyTrackMatches)
+				{
+					FilterMatches_.Albums_.setBit (albumNode);
+					anyAlbumMatches = true;
+				}
+			}
+
+			if (artistMatches || anyAlbumMatches)
+				FilterMatches_.Artists_.setBit (artistNode);
+		}
+	}
+
+	void LocalCollectionModel::InvalidateFilterMatches ()
+	{
+		FilterMatches_ = FilterMatches {};
 	}
 }
 }
@@ -29,9 +29,13 @@
 
 #pragma once
 
-#include <QStandardItemModel>
+#include <QAbstractItemModel>
+#include <QBitArray>
 #include <QHash>
+#include <QIcon>
+#include <QVector>
 #include <util/models/dndactionsmixin.h>
+#include <interfaces/core/icoreproxy.h>
 #include "interfaces/lmp/icollectionmodel.h"
 #include "interfaces/lmp/collectiontypes.h"
 
@@ -39,16 +43,82 @@ namespace LeechCraft
 {
 namespace LMP
 {
-	class LocalCollectionModel : public Util::DndActionsMixin<QStandardItemModel>
+	/** @brief The model of the local collection tree.
+	 *
+	 * Artists, albums and tracks are kept in flat arrays of nodes
+	 * referring to each other by their positions in those arrays, and
+	 * the model indexes are built on demand from these positions. Thus
+	 * no per-row objects are allocated, and only the parts of the tree
+	 * actually visited by the views and proxy models are ever touched.
+	 * The slots of the removed nodes are reused by the nodes added
+	 * later.
+	 *
+	 * Each node also keeps a lowercase search string used by
+	 * IsFilterMatch() to filter the tree without walking it via the
+	 * proxy models.
+	 */
+	class LocalCollectionModel : public Util::DndActionsMixin<QAbstractItemModel>
 							   , public ICollectionModel
 	{
 		Q_OBJECT
 
 		QIcon ArtistIcon_;
 
-		QHash<int, QStandardItem*> Artist2Item_;
-		QHash<int, QStandardItem*> Album2Item_;
-		QHash<int, QStandardItem*> Track2Item_;
+		struct ArtistNode
+		{
+			int ID_;
+			QString Name_;
+			QString SearchString_;
+
+			QVector<int> Albums_;
+			int Row_;
+		};
+
+		struct AlbumNode
+		{
+			int ID_;
+			QString Name_;
+			int Year_;
+			QString CoverPath_;
+			QString SearchString_;
+
+			int Artist_;
+			QVector<int> Tracks_;
+			int Row_;
+		};
+
+		struct TrackNode
+		{
+			Collection::Track Track_;
+			QString SearchString_;
+
+			int Album_;
+			int Row_;
+		};
+
+		QVector<ArtistNode> Artists_;
+		QVector<AlbumNode> Albums_;
+		QVector<TrackNode> Tracks_;
+
+		QVector<int> RootArtists_;
+
+		QVector<int> FreeArtists_;
+		QVector<int> FreeAlbums_;
+		QVector<int> FreeTracks_;
+
+		QHash<int, int> ArtistID2Node_;
+		QHash<int, int> AlbumID2Node_;
+		QHash<int, int> TrackID2Node_;
+
+		struct FilterMatches
+		{
+			QString Pattern_;
+
+			QBitArray Artists_;
+			QBitArray Albums_;
+			QBitArray Tracks_;
+		};
+		mutable FilterMatches FilterMatches_;
 	public:
 		enum NodeType
 		{
@@ -73,12 +143,19 @@ namespace LMP
 
 		LocalCollectionModel (QObject*);
 
+		QModelIndex index (int, int, const QModelIndex& = {}) const;
+		QModelIndex parent (const QModelIndex&) const;
+		int rowCount (const QModelIndex& = {}) const;
+		int columnCount (const QModelIndex& = {}) const;
+		QVariant data (const QModelIndex&, int) const;
+		Qt::ItemFlags flags (const QModelIndex&) const;
+
 		QStringList mimeTypes () const;
 		QMimeData* mimeData (const QModelIndexList&) const;
 
 		QList<QUrl> ToSourceUrls (const QList<QModelIndex>&) const;
 
-		void FinalizeInit ();
+		void FinalizeInit (const ICoreProxy_ptr&);
 
 		void AddArtists (const Collection::Artists_t&);
 		void Clear ();
@@ -88,6 +165,27 @@ namespace LMP
 
 		void SetAlbumArt (int, const QString&);
 		QVariant GetTrackData (int trackId, Role) const;
+
+		/** @brief Checks whether the node at the given index matches the
+		 * filter string.
+		 *
+		 * A node matches if the pattern is a case-insensitive substring
+		 * of its or its ancestors' text, or if any of its descendants
+		 * matches. The matches for the whole tree are computed once per
+		 * pattern and are reused for the subsequent calls.
+		 */
+		bool IsFilterMatch (const QModelIndex&, const QString& pattern) const;
+	private:
+		QModelIndex MakeIndex (NodeType, int node) const;
+
+		QVariant GetNodeData (const ArtistNode&, int) const;
+		QVariant GetNodeData (const AlbumNode&, int) const;
+		QVariant GetNodeData (const TrackNode&, int) const;
+
+		QStringList CollectPaths (const QModelIndex&) const;
+
+		void RebuildFilterMatches (const QString&) const;
+		void InvalidateFilterMatches ();
 	};
 }
 }
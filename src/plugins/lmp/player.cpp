@@ -128,6 +128,7 @@ namespace LMP
 	struct Player::ResolveJobResult
 	{
 		ResolveResult_t Resolved_;
+		bool ShouldSort_;
 		bool ShouldClear_;
 	};
 
@@ -246,7 +247,8 @@ namespace LMP
 	{
 		Sorter_.Criteria_ = criteria;
 
-		AddToPlaylistModel ({}, true, false);
+		if (!CurrentQueue_.IsEmpty ())
+			Enqueue (GetQueue (), EnqueueSort | EnqueueReplace);
 
 		XmlSettingsManager::Instance ().setProperty ("SortingCriteria", SaveCriteria (criteria));
 	}
@@ -291,7 +293,7 @@ namespace LMP
 	{
 		UnsetRadio ();
 
-		if (CurrentQueue_.isEmpty ())
+		if (CurrentQueue_.IsEmpty ())
 			emit shouldClearFiltering ();
 
 		Playlist parsedSources;
@@ -326,7 +328,7 @@ namespace LMP
 
 	QList<AudioSource> Player::GetQueue () const
 	{
-		return CurrentQueue_;
+		return CurrentQueue_.ToList ();
 	}
 
 	QList<AudioSource> Player::GetIndexSources (const QModelIndex& index) const
@@ -375,9 +377,11 @@ namespace LMP
 		{
 			Url2Info_.remove (source.ToUrl ());
 
-			if (!CurrentQueue_.removeAll (source))
+			if (!CurrentQueue_.Remove (source))
 				continue;
 
+			RemoveFromGroups (source);
+
 			RemoveFromOneShotQueue (source);
 
 			auto item = Items_.take (source);
@@ -385,19 +389,7 @@ namespace LMP
 			if (parent)
 			{
 				if (parent->rowCount () == 1)
-				{
-					for (const auto& key : AlbumRoots_.keys ())
-					{
-						auto& items = AlbumRoots_ [key];
-						if (!items.contains (parent))
-							continue;
-
-						items.removeAll (parent);
-						if (items.isEmpty ())
-							AlbumRoots_.remove (key);
-					}
 					PlaylistModel_->removeRow (parent->row ());
-				}
 				else
 				{
 					const auto& info = item->data (Role::Info).value<MediaInfo> ();
@@ -747,6 +739,22 @@ namespace LMP
 					[&] (const AudioSource& source) { return PairResolve (getter, source); });
 		}
 
+		template<typename Sorter>
+		bool IsLessResolved (const Sorter& sorter, const ResolvedSource_t& s1, const ResolvedSource_t& s2)
+		{
+			const auto leftUseful = !s1.second.IsUseless ();
+			const auto rightUseful = !s2.second.IsUseless ();
+
+			if (leftUseful && !rightUseful)
+				return true;
+			else if (!leftUseful && rightUseful)
+				return false;
+			else if (!leftUseful || !rightUseful)
+				return s1.first.ToUrl () < s2.first.ToUrl ();
+			else
+				return sorter (s1.second, s2.second);
+		}
+
 		template<typename Sorter, typename NonLocalGetter>
 		ResolveResult_t PairResolveSort (const QList<AudioSource>& sources,
 				Sorter sorter, NonLocalGetter nonLocalGetter, bool sort)
@@ -758,19 +766,7 @@ namespace LMP
 
 			std::sort (result.begin (), result.end (),
 					[sorter] (const ResolvedSource_t& s1, const ResolvedSource_t& s2)
-					{
-						const auto leftUseful = !s1.second.IsUseless ();
-						const auto rightUseful = !s2.second.IsUseless ();
-
-						if (leftUseful && !rightUseful)
-							return true;
-						else if (!leftUseful && rightUseful)
-							return false;
-						else if (!leftUseful || !rightUseful)
-							return s1.first.ToUrl () < s2.first.ToUrl ();
-						else
-							return sorter (s1.second, s2.second);
-					});
+						{ return IsLessResolved (sorter, s1, s2); });
 
 			return result;
 		}
@@ -778,15 +774,6 @@ namespace LMP
 
 	void Player::AddToPlaylistModel (QList<AudioSource> sources, bool sort, bool clear)
 	{
-		if (!CurrentQueue_.isEmpty () && !clear)
-		{
-			EnqueueFlags flags { EnqueueReplace };
-			if (sort)
-				flags |= EnqueueSort;
-			Enqueue (CurrentQueue_ + sources, flags);
-			return;
-		}
-
 		emit playerAvailable (false);
 
 		const auto future = QtConcurrent::run ([=]
@@ -800,6 +787,7 @@ namespace LMP
 									return Url2Info_.value (source.ToUrl ());
 								},
 								sort),
+						sort,
 						clear
 					};
 				});
@@ -900,60 +888,82 @@ namespace LMP
 		Core::Instance ().GetProxy ()->GetEntityManager ()->HandleEntity (e);
 	}
 
-	template<typename T>
-	AudioSource Player::GetRandomBy (AudioSources_t::const_iterator pos,
-			std::function<T (AudioSources_t::const_iterator, AudioSources_t)> feature) const
+	void Player::UpdateGroups (const AudioSource& source)
+	{
+		const auto& info = GetMediaInfo (source);
+		AlbumGroups_.Set (source, info.Album_);
+		ArtistGroups_.Set (source, info.Artist_);
+	}
+
+	void Player::RemoveFromGroups (const AudioSource& source)
+	{
+		AlbumGroups_.Remove (source);
+		ArtistGroups_.Remove (source);
+	}
+
+	void Player::ClearGroups ()
 	{
-		auto randPos = [&feature, this] (const QList<AudioSource>& sources) -> int
+		AlbumGroups_.Clear ();
+		ArtistGroups_.Clear ();
+	}
+
+	AudioSource Player::GetRandomSource (const AudioSource& current) const
+	{
+		const auto size = CurrentQueue_.GetSize ();
+		const auto curIdx = CurrentQueue_.IndexOf (current);
+		if (curIdx < 0 || size < 2)
+			return CurrentQueue_.At (std::uniform_int_distribution<int> (0, size - 1) (PRG_));
+
+		// Pick one of the other sources, skipping over the current one.
+		auto idx = std::uniform_int_distribution<int> (0, size - 2) (PRG_);
+		if (idx >= curIdx)
+			++idx;
+		return CurrentQueue_.At (idx);
+	}
+
+	AudioSource Player::GetRandomBy (const AudioSource& current, const QueueGroups& groups) const
+	{
+		const auto isQueued = groups.Contains (current);
+		const auto& curKey = groups.GetKey (current);
+		if (isQueued)
 		{
-			const auto begin = sources.begin ();
-			QHash<T, QList<int>> fVals;
-			for (auto i = begin, end = sources.end (); i != end; ++i)
-				fVals [feature (i, sources)] << std::distance (begin, i);
+			const auto& next = CurrentQueue_.GetNext (current);
+			if (!next.IsEmpty () && groups.GetKey (next) == curKey)
+				return next;
+		}
 
-			auto fIdx = std::uniform_int_distribution<int> (0, fVals.size () - 1) (PRG_);
+		const auto count = groups.GetGroupsCount ();
+		if (!count)
+			return {};
 
-			auto fPos = fVals.begin ();
-			std::advance (fPos, fIdx);
-			const auto& positions = *fPos;
-			if (positions.size () < 2)
-				return positions [0];
+		int groupIdx = 0;
+		if (!isQueued || count < 2)
+			groupIdx = std::uniform_int_distribution<int> (0, count - 1) (PRG_);
+		else
+		{
+			groupIdx = std::uniform_int_distribution<int> (0, count - 2) (PRG_);
+			if (groupIdx >= groups.GetGroupIndex (curKey))
+				++groupIdx;
+		}
 
-			auto posIdx = std::uniform_int_distribution<int> (0, positions.size () - 1) (PRG_);
-			return positions [posIdx];
-		};
-		auto rand = [&randPos] (const QList<AudioSource>& sources)
-			{ return sources.at (randPos (sources)); };
-
-		if (pos == CurrentQueue_.end ())
-			return rand (CurrentQueue_);
-
-		const auto& current = feature (pos, CurrentQueue_);
-		++pos;
-		if (pos != CurrentQueue_.end () && feature (pos, CurrentQueue_) == current)
-			return *pos;
-
-		decltype (CurrentQueue_) modifiedQueue;
-		for (auto i = CurrentQueue_.begin (); i != CurrentQueue_.end (); ++i)
-			if (feature (i, CurrentQueue_) != current)
-				modifiedQueue << *i;
-		if (modifiedQueue.isEmpty ())
-			return rand (CurrentQueue_);
-
-		const auto& origFeature = feature (pos, modifiedQueue);
-		pos = modifiedQueue.begin () + randPos (modifiedQueue);
-		while (pos != modifiedQueue.begin ())
+		// Start from the first queued source of the chosen group.
+		AudioSource first;
+		int firstIdx = CurrentQueue_.GetSize ();
+		for (const auto& source : groups.GetGroup (groups.GetGroupKey (groupIdx)))
 		{
-			if (feature (pos - 1, modifiedQueue) != origFeature)
-				break;
-			--pos;
+			const auto idx = CurrentQueue_.IndexOf (source);
+			if (idx >= 0 && idx < firstIdx)
+			{
+				first = source;
+				firstIdx = idx;
+			}
 		}
-		return *pos;
+		return first;
 	}
 
 	AudioSource Player::GetNextSource (const AudioSource& current)
 	{
-		if (CurrentQueue_.isEmpty ())
+		if (CurrentQueue_.IsEmpty ())
 			return {};
 
 		if (!CurrentOneShotQueue_.isEmpty ())
@@ -963,53 +973,46 @@ namespace LMP
 			return first;
 		}
 
-		auto pos = std::find (CurrentQueue_.begin (), CurrentQueue_.end (), current);
+		const auto isQueued = CurrentQueue_.Contains (current);
 
 		switch (PlayMode_)
 		{
 		case PlayMode::Sequential:
-			if (pos == CurrentQueue_.end ())
-				return CurrentQueue_.value (0);
-			else if (++pos != CurrentQueue_.end ())
-				return *pos;
-			else
-				return {};
+			return isQueued ?
+					CurrentQueue_.GetNext (current) :
+					CurrentQueue_.At (0);
 		case PlayMode::Shuffle:
-			return GetRandomBy<int> (pos,
-					[this] (AudioSources_t::const_iterator pos, const AudioSources_t& sources)
-						{ return pos - sources.begin (); });
+			return GetRandomSource (current);
 		case PlayMode::ShuffleAlbums:
-			return GetRandomBy<QString> (pos,
-					[this] (AudioSources_t::const_iterator pos, const AudioSources_t&)
-						{ return GetMediaInfo (*pos).Album_; });
+			return GetRandomBy (current, AlbumGroups_);
 		case PlayMode::ShuffleArtists:
-			return GetRandomBy<QString> (pos,
-					[this] (AudioSources_t::const_iterator pos, const AudioSources_t&)
-						{ return GetMediaInfo (*pos).Artist_; });
+			return GetRandomBy (current, ArtistGroups_);
 		case PlayMode::RepeatTrack:
 			return current;
 		case PlayMode::RepeatAlbum:
 		{
-			if (pos == CurrentQueue_.end ())
-				return CurrentQueue_.value (0);
-
-			const auto& curAlbum = GetMediaInfo (*pos).Album_;
-			++pos;
-			if (pos == CurrentQueue_.end () ||
-					GetMediaInfo (*pos).Album_ != curAlbum)
-			{
-				do
-					--pos;
-				while (pos >= CurrentQueue_.begin () &&
-						GetMediaInfo (*pos).Album_ == curAlbum);
-				++pos;
-			}
-			return *pos;
+			if (!isQueued)
+				return CurrentQueue_.At (0);
+
+			const auto& curAlbum = GetMediaInfo (current).Album_;
+			const auto& next = CurrentQueue_.GetNext (current);
+			if (!next.IsEmpty () && GetMediaInfo (next).Album_ == curAlbum)
+				return next;
+
+			auto first = current;
+			for (auto prev = CurrentQueue_.GetPrevious (first);
+					!prev.IsEmpty () && GetMediaInfo (prev).Album_ == curAlbum;
+					prev = CurrentQueue_.GetPrevious (prev))
+				first = prev;
+			return first;
 		}
 		case PlayMode::RepeatWhole:
-			if (pos == CurrentQueue_.end () || ++pos == CurrentQueue_.end ())
-				pos = CurrentQueue_.begin ();
-			return *pos;
+		{
+			const auto& next = isQueued ?
+					CurrentQueue_.GetNext (current) :
+					AudioSource {};
+			return next.IsEmpty () ? CurrentQueue_.At (0) : next;
+		}
 		}
 
 		return {};
@@ -1017,17 +1020,15 @@ namespace LMP
 
 	void Player::MarkAsCurrent (QStandardItem *curItem)
 	{
+		const auto prevItem = Items_.value (CurrentItemSource_);
+		if (prevItem && prevItem != curItem)
+			prevItem->setData (false, Role::IsCurrent);
+
+		CurrentItemSource_.Clear ();
 		if (curItem)
-			curItem->setData (true, Role::IsCurrent);
-		for (auto item : Items_)
 		{
-			if (item == curItem)
-				continue;
-			if (item->data (Role::IsCurrent).toBool ())
-			{
-				item->setData (false, Role::IsCurrent);
-				break;
-			}
+			curItem->setData (true, Role::IsCurrent);
+			CurrentItemSource_ = curItem->data (Role::Source).value<AudioSource> ();
 		}
 	}
 
@@ -1071,19 +1072,14 @@ namespace LMP
 
 		AudioSource next;
 		if (PlayMode_ == PlayMode::Shuffle)
-		{
 			next = GetNextSource (current);
-			if (next.IsEmpty ())
-				return;
-		}
 		else
-		{
-			const auto pos = std::find (CurrentQueue_.begin (), CurrentQueue_.end (), current);
-			if (pos == CurrentQueue_.begin ())
-				return;
+			next = CurrentQueue_.Contains (current) ?
+					CurrentQueue_.GetPrevious (current) :
+					CurrentQueue_.At (0);
 
-			next = pos == CurrentQueue_.end () ? CurrentQueue_.value (0) : *(pos - 1);
-		}
+		if (next.IsEmpty ())
+			return;
 
 		if (Source_->GetState () != SourceState::Stopped)
 			emit aboutToStopInternally ();
@@ -1121,7 +1117,7 @@ namespace LMP
 		{
 			const auto& current = Source_->GetCurrentSource ();
 			if (current.IsEmpty ())
-				Source_->SetCurrentSource (CurrentQueue_.value (0));
+				Source_->SetCurrentSource (CurrentQueue_.At (0));
 			Source_->Play ();
 		}
 	}
@@ -1147,8 +1143,8 @@ namespace LMP
 			PlaylistModel_->removeRows (0, rc);
 
 		Items_.clear ();
-		AlbumRoots_.clear ();
-		CurrentQueue_.clear ();
+		CurrentQueue_.Clear ();
+		ClearGroups ();
 		Url2Info_.clear ();
 		CurrentOneShotQueue_.clear ();
 		Source_->ClearQueue ();
@@ -1180,122 +1176,187 @@ namespace LMP
 			item->setText (text);
 			item->setData (QVariant::fromValue (info), Player::Role::Info);
 		}
+
+		QString GetGroupingAlbum (const QStandardItem *item)
+		{
+			const auto& source = item->data (Player::Role::Source).value<AudioSource> ();
+			if (source.GetType () != AudioSource::Type::File)
+				return {};
+
+			const auto& album = item->data (Player::Role::Info).value<MediaInfo> ().Album_;
+			return album.simplified ().isEmpty () ? QString () : album;
+		}
+
+		int GetItemLength (const QStandardItem *item)
+		{
+			return item->data (Player::Role::Info).value<MediaInfo> ().Length_;
+		}
 	}
 
-	void Player::ContinueAfterSorted (const ResolveJobResult& result)
+	QStandardItem* Player::MakeItem (const AudioSource& source, const MediaInfo& info) const
 	{
-		const auto& sources = result.Resolved_;
+		auto item = new QStandardItem ();
+		item->setEditable (false);
+		item->setData (QVariant::fromValue (source), Role::Source);
+		item->setData (source == CurrentStopSource_, Role::IsStop);
 
-		CurrentQueue_.clear ();
+		const auto oneShotPos = CurrentOneShotQueue_.indexOf (source);
+		if (oneShotPos >= 0)
+			item->setData (oneShotPos, Role::OneShotPos);
 
-		QMetaObject::invokeMethod (PlaylistModel_, "modelAboutToBeReset");
-
-		if (result.ShouldClear_)
+		switch (source.GetType ())
 		{
-			if (const auto rc = PlaylistModel_->rowCount ())
-				PlaylistModel_->removeRows (0, rc);
-			Items_.clear ();
-			AlbumRoots_.clear ();
+		case AudioSource::Type::Stream:
+			item->setText (tr ("Stream"));
+			break;
+		case AudioSource::Type::Url:
+		{
+			const auto& url = source.ToUrl ();
+
+			auto urlInfo = Core::Instance ().TryURLResolve (url);
+			if (!urlInfo && Url2Info_.contains (url))
+				urlInfo = Url2Info_ [url];
+
+			if (urlInfo)
+				FillItem (item, *urlInfo);
+			else
+				item->setText (url.toString ());
+			break;
+		}
+		case AudioSource::Type::File:
+			FillItem (item, info);
+			break;
+		default:
+			item->setText ("unknown");
+			break;
 		}
 
-		PlaylistModel_->blockSignals (true);
+		return item;
+	}
 
-		QString prevAlbumRoot;
+	void Player::InsertItem (QStandardItem *item, const AudioSource& source)
+	{
+		const auto prevItem = Items_.value (CurrentQueue_.GetPrevious (source));
+		const auto nextItem = Items_.value (CurrentQueue_.GetNext (source));
+		const auto prevGroup = prevItem ? prevItem->parent () : nullptr;
+		const auto nextGroup = nextItem ? nextItem->parent () : nullptr;
 
-		QList<QStandardItem*> managedRulesItems;
+		const auto& album = GetGroupingAlbum (item);
+		if (!album.isEmpty () && prevItem && GetGroupingAlbum (prevItem) == album)
+		{
+			if (prevGroup)
+			{
+				prevGroup->insertRow (prevItem->row () + 1, item);
+				IncAlbumLength (prevGroup, GetItemLength (item));
+			}
+			else
+			{
+				const auto row = prevItem->row ();
+				MakeAlbumGroup (row, { PlaylistModel_->takeRow (row).value (0), item });
+			}
+			return;
+		}
 
-		for (const auto& sourcePair : sources)
+		if (!album.isEmpty () && nextItem && GetGroupingAlbum (nextItem) == album)
 		{
-			const auto& source = sourcePair.first;
-			CurrentQueue_ << source;
+			if (nextGroup)
+			{
+				nextGroup->insertRow (nextItem->row (), item);
+				IncAlbumLength (nextGroup, GetItemLength (item));
+			}
+			else
+			{
+				const auto row = nextItem->row ();
+				MakeAlbumGroup (row, { item, PlaylistModel_->takeRow (row).value (0) });
+			}
+			return;
+		}
 
-			auto item = new QStandardItem ();
-			item->setEditable (false);
-			item->setData (QVariant::fromValue (source), Role::Source);
-			item->setData (source == CurrentStopSource_, Role::IsStop);
+		if (prevGroup && prevGroup == nextGroup)
+			SplitAlbumGroup (prevGroup, nextItem->row ());
 
-			const auto oneShotPos = CurrentOneShotQueue_.indexOf (source);
-			if (oneShotPos >= 0)
-				item->setData (oneShotPos, Role::OneShotPos);
+		const auto prevTopItem = prevGroup ? prevGroup : prevItem;
+		PlaylistModel_->insertRow (prevTopItem ? prevTopItem->row () + 1 : 0, item);
+	}
 
-			switch (source.GetType ())
-			{
-			case AudioSource::Type::Stream:
-				item->setText (tr ("Stream"));
-				PlaylistModel_->appendRow (item);
-				break;
-			case AudioSource::Type::Url:
-			{
-				const auto& url = source.ToUrl ();
+	void Player::MakeAlbumGroup (int row, const QList<QStandardItem*>& items)
+	{
+		const auto& info = items.value (0)->data (Role::Info).value<MediaInfo> ();
 
-				auto info = Core::Instance ().TryURLResolve (url);
-				if (!info && Url2Info_.contains (url))
-					info = Url2Info_ [url];
+		const auto albumItem = MakeAlbumItem (info);
+		for (const auto item : items)
+		{
+			albumItem->appendRow (item);
+			IncAlbumLength (albumItem, GetItemLength (item));
+		}
+		PlaylistModel_->insertRow (row, albumItem);
 
-				if (info)
-					FillItem (item, *info);
-				else
-					item->setText (url.toString ());
+		LoadAlbumArt (albumItem, info);
 
-				PlaylistModel_->appendRow (item);
-				break;
-			}
-			case AudioSource::Type::File:
-			{
-				const auto& info = sourcePair.second;
+		emit insertedAlbum (albumItem->index ());
+	}
 
-				managedRulesItems << item;
+	void Player::SplitAlbumGroup (QStandardItem *albumItem, int firstRow)
+	{
+		QList<QStandardItem*> tail;
+		for (int row = albumItem->rowCount () - 1; row >= firstRow; --row)
+		{
+			const auto item = albumItem->takeRow (row).value (0);
+			IncAlbumLength (albumItem, -GetItemLength (item));
+			tail.prepend (item);
+		}
 
-				const auto& albumID = info.Album_;
-				FillItem (item, info);
-				if (albumID != prevAlbumRoot ||
-						AlbumRoots_ [albumID].isEmpty ())
-				{
-					PlaylistModel_->appendRow (item);
+		const auto row = albumItem->row () + 1;
+		if (tail.size () == 1)
+			PlaylistModel_->insertRow (row, tail.front ());
+		else if (!tail.isEmpty ())
+			MakeAlbumGroup (row, tail);
+	}
 
-					if (!info.Album_.simplified ().isEmpty ())
-						AlbumRoots_ [albumID] << item;
-				}
-				else if (AlbumRoots_ [albumID].last ()->data (Role::IsAlbum).toBool ())
-				{
-					IncAlbumLength (AlbumRoots_ [albumID].last (), info.Length_);
-					AlbumRoots_ [albumID].last ()->appendRow (item);
-				}
-				else
-				{
-					auto albumItem = MakeAlbumItem (info);
+	void Player::ContinueAfterSorted (const ResolveJobResult& result)
+	{
+		if (result.ShouldClear_)
+		{
+			CurrentQueue_.Clear ();
+			ClearGroups ();
 
-					const int row = AlbumRoots_ [albumID].last ()->row ();
-					const auto& existing = PlaylistModel_->takeRow (row);
-					albumItem->appendRow (existing);
-					albumItem->appendRow (item);
-					PlaylistModel_->insertRow (row, albumItem);
+			QMetaObject::invokeMethod (PlaylistModel_, "modelAboutToBeReset");
+
+			if (const auto rc = PlaylistModel_->rowCount ())
+				PlaylistModel_->removeRows (0, rc);
+			Items_.clear ();
 
-					LoadAlbumArt (albumItem, info);
+			PlaylistModel_->blockSignals (true);
+		}
 
-					const auto& existingInfo = existing.at (0)->data (Role::Info).value<MediaInfo> ();
-					albumItem->setData (existingInfo.Length_, Role::AlbumLength);
-					IncAlbumLength (albumItem, info.Length_);
+		const auto mergeSorted = result.ShouldSort_ &&
+				!result.ShouldClear_ &&
+				!Sorter_.Criteria_.isEmpty ();
 
-					emit insertedAlbum (albumItem->index ());
+		for (const auto& sourcePair : result.Resolved_)
+		{
+			const auto& source = sourcePair.first;
 
-					AlbumRoots_ [albumID].last () = albumItem;
-				}
-				prevAlbumRoot = albumID;
-				break;
-			}
-			default:
-				item->setText ("unknown");
-				PlaylistModel_->appendRow (item);
-				break;
-			}
+			const auto pos = mergeSorted ?
+					CurrentQueue_.FindFirst ([this, &sourcePair] (const AudioSource& other)
+							{ return IsLessResolved (Sorter_, sourcePair, { other, GetMediaInfo (other) }); }) :
+					CurrentQueue_.GetSize ();
+			if (!CurrentQueue_.Insert (pos, source))
+				continue;
 
+			const auto item = MakeItem (source, sourcePair.second);
 			Items_ [source] = item;
+			InsertItem (item, source);
+
+			UpdateGroups (source);
 		}
 
-		PlaylistModel_->blockSignals (false);
+		if (result.ShouldClear_)
+		{
+			PlaylistModel_->blockSignals (false);
 
-		QMetaObject::invokeMethod (PlaylistModel_, "modelReset");
+			QMetaObject::invokeMethod (PlaylistModel_, "modelReset");
+		}
 
 		SaveOnLoadPlaylist ();
 
@@ -1303,14 +1364,8 @@ namespace LMP
 		{
 			const auto& songUrl = XmlSettingsManager::Instance ().property ("LastSong").toByteArray ();
 			const auto& song = QUrl::fromEncoded (songUrl);
-			if (!song.isEmpty ())
-			{
-				const auto pos = std::find_if (CurrentQueue_.begin (), CurrentQueue_.end (),
-						[&song] (decltype (CurrentQueue_.front ()) item)
-							{ return song == item.ToUrl (); });
-				if (pos != CurrentQueue_.end ())
-					Source_->SetCurrentSource (*pos);
-			}
+			if (!song.isEmpty () && CurrentQueue_.Contains (AudioSource { song }))
+				Source_->SetCurrentSource (AudioSource { song });
 
 			if (FirstPlaylistRestore_ &&
 					XmlSettingsManager::Instance ().property ("AutoContinuePlayback").toBool ())
@@ -1318,14 +1373,13 @@ namespace LMP
 			FirstPlaylistRestore_ = false;
 		}
 
-		const auto& currentSource = Source_->GetCurrentSource ();
-		if (Items_.contains (currentSource))
-			Items_ [currentSource]->setData (true, Role::IsCurrent);
+		if (const auto currentItem = Items_.value (Source_->GetCurrentSource ()))
+			MarkAsCurrent (currentItem);
 	}
 
 	void Player::SaveOnLoadPlaylist () const
 	{
-		const auto playlist = Util::Map (CurrentQueue_,
+		const auto playlist = Util::Map (CurrentQueue_.ToList (),
 				[this] (const AudioSource& source)
 				{
 					boost::optional<MediaInfo> info;
@@ -1656,7 +1710,7 @@ namespace LMP
 		{
 		case SourceState::Stopped:
 			emit songChanged ({});
-			if (!CurrentQueue_.contains (Source_->GetCurrentSource ()))
+			if (!CurrentQueue_.Contains (Source_->GetCurrentSource ()))
 				Source_->SetCurrentSource ({});
 			break;
 		default:
@@ -1719,6 +1773,7 @@ namespace LMP
 		else
 		{
 			FillItem (curItem, info);
+			UpdateGroups (source);
 			emit songChanged (info);
 		}
 
@@ -43,6 +43,8 @@
 #include "engine/audiosource.h"
 #include "mediainfo.h"
 #include "sortingcriteria.h"
+#include "playqueue.h"
+#include "queuegroups.h"
 
 class QModelIndex;
 class QStandardItem;
@@ -77,9 +79,11 @@ namespace LMP
 
 		mutable std::mt19937 PRG_;
 
-		QList<AudioSource> CurrentQueue_;
+		PlayQueue CurrentQueue_;
+		QueueGroups AlbumGroups_;
+		QueueGroups ArtistGroups_;
 		QHash<AudioSource, QStandardItem*> Items_;
-		QHash<QString, QList<QStandardItem*>> AlbumRoots_;
+		AudioSource CurrentItemSource_;
 
 		AudioSource CurrentStopSource_;
 		QList<AudioSource> CurrentOneShotQueue_;
@@ -198,14 +202,22 @@ namespace LMP
 
 		void EmitStateChange (SourceState);
 
-		template<typename T>
-		AudioSource GetRandomBy (AudioSources_t::const_iterator,
-				std::function<T (AudioSources_t::const_iterator, AudioSources_t)>) const;
+		void UpdateGroups (const AudioSource&);
+		void RemoveFromGroups (const AudioSource&);
+		void ClearGroups ();
+
+		AudioSource GetRandomSource (const AudioSource&) const;
+		AudioSource GetRandomBy (const AudioSource&, const QueueGroups&) const;
 
 		AudioSource GetNextSource (const AudioSource&);
 
 		void MarkAsCurrent (QStandardItem*);
 
+		QStandardItem* MakeItem (const AudioSource&, const MediaInfo&) const;
+		void InsertItem (QStandardItem*, const AudioSource&);
+		void MakeAlbumGroup (int, const QList<QStandardItem*>&);
+		void SplitAlbumGroup (QStandardItem*, int);
+
 		void ContinueAfterSorted (const ResolveJobResult&);
 
 		void SaveOnLoadPlaylist () const;
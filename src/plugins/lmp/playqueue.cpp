@@ -0,0 +1,300 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "playqueue.h"
+#include <algorithm>
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	PlayQueue::PlayQueue ()
+	: PRG_ { std::random_device {} () }
+	{
+	}
+
+	PlayQueue::~PlayQueue ()
+	{
+		Clear ();
+	}
+
+	int PlayQueue::GetSize () const
+	{
+		return GetSize (Root_);
+	}
+
+	bool PlayQueue::IsEmpty () const
+	{
+		return !Root_;
+	}
+
+	bool PlayQueue::Contains (const AudioSource& source) const
+	{
+		return Nodes_.contains (source);
+	}
+
+	int PlayQueue::IndexOf (const AudioSource& source) const
+	{
+		const auto node = Nodes_.value (source);
+		return node ? GetRank (node) : -1;
+	}
+
+	AudioSource PlayQueue::At (int pos) const
+	{
+		if (pos < 0 || pos >= GetSize ())
+			return {};
+
+		auto node = Root_;
+		while (node)
+		{
+			const int leftSize = GetSize (node->Left_);
+			if (pos < leftSize)
+				node = node->Left_;
+			else if (pos == leftSize)
+				return node->Source_;
+			else
+			{
+				pos -= leftSize + 1;
+				node = node->Right_;
+			}
+		}
+
+		return {};
+	}
+
+	AudioSource PlayQueue::GetNext (const AudioSource& source) const
+	{
+		auto node = Nodes_.value (source);
+		if (!node)
+			return {};
+
+		if (node->Right_)
+		{
+			node = node->Right_;
+			while (node->Left_)
+				node = node->Left_;
+			return node->Source_;
+		}
+
+		while (node->Parent_ && node->Parent_->Right_ == node)
+			node = node->Parent_;
+
+		node = node->Parent_;
+		return node ? node->Source_ : AudioSource {};
+	}
+
+	AudioSource PlayQueue::GetPrevious (const AudioSource& source) const
+	{
+		auto node = Nodes_.value (source);
+		if (!node)
+			return {};
+
+		if (node->Left_)
+		{
+			node = node->Left_;
+			while (node->Right_)
+				node = node->Right_;
+			return node->Source_;
+		}
+
+		while (node->Parent_ && node->Parent_->Left_ == node)
+			node = node->Parent_;
+
+		node = node->Parent_;
+		return node ? node->Source_ : AudioSource {};
+	}
+
+	int PlayQueue::FindFirst (const std::function<bool (const AudioSource&)>& pred) const
+	{
+		int result = GetSize ();
+
+		int offset = 0;
+		auto node = Root_;
+		while (node)
+		{
+			const int leftSize = GetSize (node->Left_);
+			if (pred (node->Source_))
+			{
+				result = offset + leftSize;
+				node = node->Left_;
+			}
+			else
+			{
+				offset += leftSize + 1;
+				node = node->Right_;
+			}
+		}
+
+		return result;
+	}
+
+	bool PlayQueue::Insert (int pos, const AudioSource& source)
+	{
+		if (Nodes_.contains (source))
+			return false;
+
+		const auto node = new Node { source, static_cast<quint32> (PRG_ ()), 1, nullptr, nullptr, nullptr };
+		Nodes_ [source] = node;
+
+		pos = std::max (0, std::min (pos, GetSize ()));
+
+		Node *left = nullptr;
+		Node *right = nullptr;
+		Split (Root_, pos, left, right);
+		Root_ = Merge (Merge (left, node), right);
+		Root_->Parent_ = nullptr;
+
+		return true;
+	}
+
+	bool PlayQueue::Append (const AudioSource& source)
+	{
+		return Insert (GetSize (), source);
+	}
+
+	bool PlayQueue::Remove (const AudioSource& source)
+	{
+		const auto node = Nodes_.take (source);
+		if (!node)
+			return false;
+
+		Node *left = nullptr;
+		Node *rest = nullptr;
+		Split (Root_, GetRank (node), left, rest);
+
+		Node *removed = nullptr;
+		Node *right = nullptr;
+		Split (rest, 1, removed, right);
+		delete removed;
+
+		Root_ = Merge (left, right);
+		if (Root_)
+			Root_->Parent_ = nullptr;
+
+		return true;
+	}
+
+	void PlayQueue::Clear ()
+	{
+		qDeleteAll (Nodes_);
+		Nodes_.clear ();
+		Root_ = nullptr;
+	}
+
+	QList<AudioSource> PlayQueue::ToList () const
+	{
+		QList<AudioSource> result;
+		result.reserve (GetSize ());
+
+		QList<const Node*> stack;
+		const Node *node = Root_;
+		while (node || !stack.isEmpty ())
+		{
+			while (node)
+			{
+				stack << node;
+				node = node->Left_;
+			}
+
+			node = stack.takeLast ();
+			result << node->Source_;
+			node = node->Right_;
+		}
+
+		return result;
+	}
+
+	int PlayQueue::GetSize (const Node *node)
+	{
+		return node ? node->Size_ : 0;
+	}
+
+	void PlayQueue::Update (Node *node)
+	{
+		node->Size_ = 1 + GetSize (node->Left_) + GetSize (node->Right_);
+		if (node->Left_)
+			node->Left_->Parent_ = node;
+		if (node->Right_)
+			node->Right_->Parent_ = node;
+	}
+
+	int PlayQueue::GetRank (const Node *node)
+	{
+		int rank = GetSize (node->Left_);
+		for (; node->Parent_; node = node->Parent_)
+			if (node->Parent_->Right_ == node)
+				rank += GetSize (node->Parent_->Left_) + 1;
+		return rank;
+	}
+
+	void PlayQueue::Split (Node *node, int count, Node*& left, Node*& right)
+	{
+		if (!node)
+		{
+			left = right = nullptr;
+			return;
+		}
+
+		const int leftSize = GetSize (node->Left_);
+		if (leftSize < count)
+		{
+			Split (node->Right_, count - leftSize - 1, node->Right_, right);
+			left = node;
+		}
+		else
+		{
+			Split (node->Left_, count, left, node->Left_);
+			right = node;
+		}
+
+		Update (node);
+	}
+
+	PlayQueue::Node* PlayQueue::Merge (Node *left, Node *right)
+	{
+		if (!left)
+			return right;
+		if (!right)
+			return left;
+
+		if (left->Priority_ > right->Priority_)
+		{
+			left->Right_ = Merge (left->Right_, right);
+			Update (left);
+			return left;
+		}
+		else
+		{
+			right->Left_ = Merge (left, right->Left_);
+			Update (right);
+			return right;
+		}
+	}
+}
+}
@@ -0,0 +1,131 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <random>
+#include <QHash>
+#include <QList>
+#include "engine/audiosource.h"
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	/** @brief The play queue of unique sources.
+	 *
+	 * The sources are kept in a treap ordered by their position, with
+	 * each node also being reachable directly by its source. Thus
+	 * inserting and removing sources at arbitrary positions, getting a
+	 * source by its position and getting the position, the next or the
+	 * previous source of a given source are all logarithmic, while
+	 * checking whether a source is in the queue is constant.
+	 */
+	class PlayQueue
+	{
+		struct Node
+		{
+			AudioSource Source_;
+			quint32 Priority_;
+
+			int Size_;
+			Node *Left_;
+			Node *Right_;
+			Node *Parent_;
+		};
+
+		Node *Root_ = nullptr;
+		QHash<AudioSource, Node*> Nodes_;
+
+		std::mt19937 PRG_;
+	public:
+		PlayQueue ();
+		~PlayQueue ();
+
+		PlayQueue (const PlayQueue&) = delete;
+		PlayQueue& operator= (const PlayQueue&) = delete;
+
+		int GetSize () const;
+		bool IsEmpty () const;
+
+		bool Contains (const AudioSource&) const;
+
+		/** @brief Returns the position of the source, or -1 if it is not
+		 * in the queue.
+		 */
+		int IndexOf (const AudioSource&) const;
+
+		/** @brief Returns the source at the position, or an empty one if
+		 * the position is out of range.
+		 */
+		AudioSource At (int) const;
+
+		/** @brief Returns the source after the given one, or an empty
+		 * one if it is the last one or is not in the queue.
+		 */
+		AudioSource GetNext (const AudioSource&) const;
+
+		/** @brief Returns the source before the given one, or an empty
+		 * one if it is the first one or is not in the queue.
+		 */
+		AudioSource GetPrevious (const AudioSource&) const;
+
+		/** @brief Returns the first position whose source the predicate
+		 * is true for.
+		 *
+		 * The predicate should be false for some prefix of the queue and
+		 * true for the rest of it, like "the new source should go before
+		 * this one" for a sorted queue. Returns GetSize() if the
+		 * predicate is false for all the sources.
+		 */
+		int FindFirst (const std::function<bool (const AudioSource&)>&) const;
+
+		/** @brief Inserts the source before the given position.
+		 *
+		 * The position is clamped to [0; GetSize()]. Returns false and
+		 * does nothing if the source is already in the queue.
+		 */
+		bool Insert (int, const AudioSource&);
+		bool Append (const AudioSource&);
+
+		bool Remove (const AudioSource&);
+		void Clear ();
+
+		QList<AudioSource> ToList () const;
+	private:
+		static int GetSize (const Node*);
+		static void Update (Node*);
+		static int GetRank (const Node*);
+
+		static void Split (Node*, int, Node*&, Node*&);
+		static Node* Merge (Node*, Node*);
+	};
+}
+}
@@ -0,0 +1,123 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "queuegroups.h"
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	void QueueGroups::Set (const AudioSource& source, const QString& key)
+	{
+		const auto pos = Source2Key_.constFind (source);
+		if (pos != Source2Key_.constEnd ())
+		{
+			if (*pos == key)
+				return;
+
+			Remove (source);
+		}
+
+		Source2Key_ [source] = key;
+
+		auto& group = Key2Sources_ [key];
+		if (group.isEmpty ())
+		{
+			Key2Index_ [key] = Keys_.size ();
+			Keys_ << key;
+		}
+		group << source;
+	}
+
+	void QueueGroups::Remove (const AudioSource& source)
+	{
+		const auto pos = Source2Key_.find (source);
+		if (pos == Source2Key_.end ())
+			return;
+
+		const auto key = *pos;
+		Source2Key_.erase (pos);
+
+		auto& group = Key2Sources_ [key];
+		group.remove (source);
+		if (!group.isEmpty ())
+			return;
+
+		Key2Sources_.remove (key);
+
+		// Move the last group to the place of the removed one.
+		const auto index = Key2Index_.take (key);
+		const auto& lastKey = Keys_.last ();
+		if (index != Keys_.size () - 1)
+		{
+			Keys_ [index] = lastKey;
+			Key2Index_ [lastKey] = index;
+		}
+		Keys_.removeLast ();
+	}
+
+	void QueueGroups::Clear ()
+	{
+		Source2Key_.clear ();
+		Key2Sources_.clear ();
+		Keys_.clear ();
+		Key2Index_.clear ();
+	}
+
+	bool QueueGroups::Contains (const AudioSource& source) const
+	{
+		return Source2Key_.contains (source);
+	}
+
+	QString QueueGroups::GetKey (const AudioSource& source) const
+	{
+		return Source2Key_.value (source);
+	}
+
+	int QueueGroups::GetGroupsCount () const
+	{
+		return Keys_.size ();
+	}
+
+	QString QueueGroups::GetGroupKey (int index) const
+	{
+		return Keys_.value (index);
+	}
+
+	int QueueGroups::GetGroupIndex (const QString& key) const
+	{
+		return Key2Index_.value (key, -1);
+	}
+
+	QSet<AudioSource> QueueGroups::GetGroup (const QString& key) const
+	{
+		return Key2Sources_.value (key);
+	}
+}
+}
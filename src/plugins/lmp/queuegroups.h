@@ -0,0 +1,81 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include "engine/audiosource.h"
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	/** @brief Groups the queued sources by a key like their album or
+	 * artist.
+	 *
+	 * Both the group of a source and the members of a group are
+	 * available in constant time, and the groups are also accessible
+	 * by their index for picking a random one.
+	 */
+	class QueueGroups
+	{
+		QHash<AudioSource, QString> Source2Key_;
+		QHash<QString, QSet<AudioSource>> Key2Sources_;
+
+		QVector<QString> Keys_;
+		QHash<QString, int> Key2Index_;
+	public:
+		/** @brief Puts the source to the group with the given key.
+		 *
+		 * If the source is already in some other group, it is moved.
+		 */
+		void Set (const AudioSource&, const QString& key);
+		void Remove (const AudioSource&);
+		void Clear ();
+
+		bool Contains (const AudioSource&) const;
+		QString GetKey (const AudioSource&) const;
+
+		int GetGroupsCount () const;
+		QString GetGroupKey (int) const;
+
+		/** @brief Returns the index of the group, or -1 if there is no
+		 * such group.
+		 *
+		 * The indexes of the groups may change when any group is
+		 * removed.
+		 */
+		int GetGroupIndex (const QString& key) const;
+
+		QSet<AudioSource> GetGroup (const QString& key) const;
+	};
+}
+}
@@ -0,0 +1,261 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "localcollectionmodeltest.h"
+#include <QtTest>
+#if QT_VERSION >= QT_VERSION_CHECK (5, 11, 0)
+#include <QAbstractItemModelTester>
+#endif
+#include "../localcollectionmodel.h"
+
+QTEST_MAIN (LeechCraft::LMP::LocalCollectionModelTest)
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	namespace
+	{
+		Collection::Track MakeTrack (int id, int number, const QString& name)
+		{
+			return { id, number, name, 180, {}, QString ("/music/%1.ogg").arg (id) };
+		}
+
+		Collection::Album_ptr MakeAlbum (int id, const QString& name, int year, const QList<Collection::Track>& tracks)
+		{
+			return std::make_shared<Collection::Album> (Collection::Album { id, name, year, {}, tracks });
+		}
+
+		Collection::Artist MakeArtist (int id, const QString& name, const QList<Collection::Album_ptr>& albums)
+		{
+			return { id, name, albums };
+		}
+
+		int GetNodeType (const QModelIndex& index)
+		{
+			return index.data (LocalCollectionModel::Role::Node).toInt ();
+		}
+
+		void CheckTree (const LocalCollectionModel& model, const QModelIndex& parent = {})
+		{
+			for (int row = 0; row < model.rowCount (parent); ++row)
+			{
+				const auto& child = model.index (row, 0, parent);
+				QVERIFY (child.isValid ());
+				QCOMPARE (child.row (), row);
+				QCOMPARE (model.parent (child), parent);
+				QCOMPARE (model.index (row, 0, model.parent (child)), child);
+
+				switch (GetNodeType (child))
+				{
+				case LocalCollectionModel::NodeType::Artist:
+					QVERIFY (!parent.isValid ());
+					break;
+				case LocalCollectionModel::NodeType::Album:
+					QCOMPARE (GetNodeType (parent), static_cast<int> (LocalCollectionModel::NodeType::Artist));
+					QCOMPARE (child.data (LocalCollectionModel::Role::ArtistName),
+							parent.data (LocalCollectionModel::Role::ArtistName));
+					break;
+				case LocalCollectionModel::NodeType::Track:
+					QCOMPARE (GetNodeType (parent), static_cast<int> (LocalCollectionModel::NodeType::Album));
+					QCOMPARE (child.data (LocalCollectionModel::Role::AlbumName),
+							parent.data (LocalCollectionModel::Role::AlbumName));
+					QCOMPARE (model.rowCount (child), 0);
+					break;
+				}
+
+				CheckTree (model, child);
+			}
+		}
+	}
+
+	void LocalCollectionModelTest::init ()
+	{
+		Model_ = std::make_shared<LocalCollectionModel> (nullptr);
+#if QT_VERSION >= QT_VERSION_CHECK (5, 11, 0)
+		Tester_ = std::make_shared<QAbstractItemModelTester> (Model_.get (),
+				QAbstractItemModelTester::FailureReportingMode::QtTest);
+#endif
+	}
+
+	void LocalCollectionModelTest::cleanup ()
+	{
+		Tester_.reset ();
+		Model_.reset ();
+
+		InsertedPattern_.clear ();
+		InsertedMatches_.clear ();
+	}
+
+	void LocalCollectionModelTest::testAddRemoveReAdd ()
+	{
+		auto& model = *Model_;
+		model.AddArtists ({
+				MakeArtist (1, "Alpha", { MakeAlbum (10, "First", 2001, { MakeTrack (100, 1, "One"), MakeTrack (101, 2, "Two") }) }),
+				MakeArtist (2, "Beta", { MakeAlbum (20, "Second", 2002, { MakeTrack (200, 1, "Three") }) })
+			});
+		CheckTree (model);
+		QCOMPARE (model.rowCount (), 2);
+
+		const auto& alpha = model.index (0, 0);
+		const auto& first = model.index (0, 0, alpha);
+		const auto alphaId = alpha.internalId ();
+		const auto firstId = first.internalId ();
+		const auto oneId = model.index (0, 0, first).internalId ();
+
+		model.RemoveTrack (101);
+		CheckTree (model);
+		QCOMPARE (model.rowCount (model.index (0, 0, model.index (0, 0))), 1);
+		QVERIFY (!model.GetTrackData (101, LocalCollectionModel::Role::TrackTitle).isValid ());
+
+		model.RemoveArtist (1);
+		CheckTree (model);
+		QCOMPARE (model.rowCount (), 1);
+		QCOMPARE (model.index (0, 0).data ().toString (), QString ("Beta"));
+		QVERIFY (!model.GetTrackData (100, LocalCollectionModel::Role::TrackTitle).isValid ());
+
+		// The new nodes take the slots freed by the removal.
+		model.AddArtists ({ MakeArtist (3, "Gamma", { MakeAlbum (30, "Third", 2003, { MakeTrack (300, 1, "Four") }) }) });
+		CheckTree (model);
+		QCOMPARE (model.rowCount (), 2);
+
+		const auto& gamma = model.index (1, 0);
+		const auto& third = model.index (0, 0, gamma);
+		QCOMPARE (gamma.data ().toString (), QString ("Gamma"));
+		QCOMPARE (gamma.internalId (), alphaId);
+		QCOMPARE (third.data (LocalCollectionModel::Role::AlbumName).toString (), QString ("Third"));
+		QCOMPARE (third.internalId (), firstId);
+		QCOMPARE (model.index (0, 0, third).internalId (), oneId);
+		QCOMPARE (model.index (0, 0, third).data (LocalCollectionModel::Role::ArtistName).toString (), QString ("Gamma"));
+
+		// The removed IDs can be added again.
+		model.AddArtists ({ MakeArtist (1, "Alpha", { MakeAlbum (10, "First", 2001, { MakeTrack (101, 2, "Two") }) }) });
+		CheckTree (model);
+		QCOMPARE (model.rowCount (), 3);
+		QCOMPARE (model.index (2, 0).data ().toString (), QString ("Alpha"));
+		QCOMPARE (model.GetTrackData (101, LocalCollectionModel::Role::TrackTitle).toString (), QString ("Two"));
+		QCOMPARE (model.GetTrackData (300, LocalCollectionModel::Role::AlbumName).toString (), QString ("Third"));
+		QVERIFY (!model.GetTrackData (100, LocalCollectionModel::Role::TrackTitle).isValid ());
+	}
+
+	void LocalCollectionModelTest::testParentIndexRoundTrip ()
+	{
+		auto& model = *Model_;
+		model.AddArtists ({
+				MakeArtist (1, "Alpha", { MakeAlbum (10, "First", 2001, { MakeTrack (100, 1, "One") }) }),
+				MakeArtist (2, "Beta", {})
+			});
+
+		// A new album of an existing artist, new tracks of an existing
+		// album and an album of a new artist.
+		model.AddArtists ({
+				MakeArtist (1, "Alpha",
+					{
+						MakeAlbum (10, "First", 2001, { MakeTrack (100, 1, "One"), MakeTrack (101, 2, "Two"), MakeTrack (102, 3, "Three") }),
+						MakeAlbum (11, "Second", 2002, { MakeTrack (110, 1, "Four") })
+					}),
+				MakeArtist (2, "Beta", { MakeAlbum (20, "Third", 2003, { MakeTrack (200, 1, "Five") }) }),
+				MakeArtist (3, "Gamma", { MakeAlbum (30, "Fourth", 2004, { MakeTrack (300, 1, "Six") }) })
+			});
+		CheckTree (model);
+
+		QCOMPARE (model.rowCount (), 3);
+		const auto& alpha = model.index (0, 0);
+		QCOMPARE (model.rowCount (alpha), 2);
+		QCOMPARE (model.rowCount (model.index (0, 0, alpha)), 3);
+		QCOMPARE (model.index (2, 0, model.index (0, 0, alpha)).data (LocalCollectionModel::Role::TrackTitle).toString (),
+				QString ("Three"));
+
+		// Removing a middle row renumbers the rows after it.
+		model.RemoveAlbum (10);
+		CheckTree (model);
+		QCOMPARE (model.rowCount (alpha), 1);
+		QCOMPARE (model.index (0, 0, alpha).data (LocalCollectionModel::Role::AlbumName).toString (), QString ("Second"));
+
+		model.RemoveArtist (1);
+		CheckTree (model);
+		QCOMPARE (model.index (0, 0).data ().toString (), QString ("Beta"));
+		QCOMPARE (model.index (1, 0).data ().toString (), QString ("Gamma"));
+	}
+
+	void LocalCollectionModelTest::testFilterAfterIncrementalInsert ()
+	{
+		auto& model = *Model_;
+		const QString pattern { "SECOND" };
+
+		model.AddArtists ({
+				MakeArtist (1, "Alpha", { MakeAlbum (10, "First", 2001, { MakeTrack (100, 1, "One") }) }),
+				MakeArtist (2, "Beta", { MakeAlbum (20, "Other", 2002, { MakeTrack (200, 1, "Two") }) })
+			});
+
+		const auto& alpha = model.index (0, 0);
+		const auto& first = model.index (0, 0, alpha);
+		QVERIFY (!model.IsFilterMatch (alpha, pattern));
+		QVERIFY (!model.IsFilterMatch (first, pattern));
+
+		// The proxy models check the new rows as soon as they are inserted.
+		InsertedPattern_ = pattern;
+		connect (&model,
+				SIGNAL (rowsInserted (QModelIndex, int, int)),
+				this,
+				SLOT (handleRowsInserted (QModelIndex, int, int)));
+
+		model.AddArtists ({ MakeArtist (1, "Alpha", { MakeAlbum (11, "Second", 2003, { MakeTrack (110, 1, "Three") }) }) });
+		QCOMPARE (InsertedMatches_, (QList<bool> { true, true }));
+
+		const auto& second = model.index (1, 0, alpha);
+		QVERIFY (model.IsFilterMatch (alpha, pattern));
+		QVERIFY (!model.IsFilterMatch (first, pattern));
+		QVERIFY (!model.IsFilterMatch (model.index (0, 0, first), pattern));
+		QVERIFY (model.IsFilterMatch (second, pattern));
+		QVERIFY (model.IsFilterMatch (model.index (0, 0, second), pattern));
+		QVERIFY (!model.IsFilterMatch (model.index (1, 0), pattern));
+
+		InsertedMatches_.clear ();
+		model.AddArtists ({ MakeArtist (2, "Beta", { MakeAlbum (20, "Other", 2002, { MakeTrack (201, 2, "Second Wind") }) }) });
+		QCOMPARE (InsertedMatches_, (QList<bool> { true }));
+
+		const auto& other = model.index (0, 0, model.index (1, 0));
+		QVERIFY (model.IsFilterMatch (model.index (1, 0), pattern));
+		QVERIFY (model.IsFilterMatch (other, pattern));
+		QVERIFY (!model.IsFilterMatch (model.index (0, 0, other), pattern));
+		QVERIFY (model.IsFilterMatch (model.index (1, 0, other), pattern));
+
+		model.RemoveTrack (201);
+		QVERIFY (!model.IsFilterMatch (model.index (1, 0), pattern));
+		QVERIFY (!model.IsFilterMatch (other, pattern));
+	}
+
+	void LocalCollectionModelTest::handleRowsInserted (const QModelIndex& parent, int from, int to)
+	{
+		for (int row = from; row <= to; ++row)
+			InsertedMatches_ << Model_->IsFilterMatch (Model_->index (row, 0, parent), InsertedPattern_);
+	}
+}
+}
@@ -0,0 +1,210 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "playqueuetest.h"
+#include <algorithm>
+#include <random>
+#include <QtTest>
+#include "../playqueue.h"
+
+QTEST_MAIN (LeechCraft::LMP::PlayQueueTest)
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	namespace
+	{
+		AudioSource MakeSource (int num)
+		{
+			return AudioSource { QString ("/music/%1.ogg").arg (num, 6, 10, QChar ('0')) };
+		}
+
+		void CheckConsistent (const PlayQueue& queue, const QList<AudioSource>& reference)
+		{
+			QCOMPARE (queue.GetSize (), reference.size ());
+			QCOMPARE (queue.ToList (), reference);
+
+			for (int i = 0; i < reference.size (); ++i)
+			{
+				const auto& source = reference.at (i);
+				QCOMPARE (queue.IndexOf (source), i);
+				QCOMPARE (queue.At (i), source);
+				QCOMPARE (queue.GetPrevious (source), reference.value (i - 1));
+				QCOMPARE (queue.GetNext (source), reference.value (i + 1));
+			}
+		}
+	}
+
+	void PlayQueueTest::testAppend ()
+	{
+		PlayQueue queue;
+		QVERIFY (queue.IsEmpty ());
+
+		QList<AudioSource> reference;
+		for (int i = 0; i < 100; ++i)
+		{
+			QVERIFY (queue.Append (MakeSource (i)));
+			reference << MakeSource (i);
+		}
+
+		QVERIFY (!queue.IsEmpty ());
+		CheckConsistent (queue, reference);
+
+		queue.Clear ();
+		QVERIFY (queue.IsEmpty ());
+		QCOMPARE (queue.IndexOf (MakeSource (0)), -1);
+	}
+
+	void PlayQueueTest::testDuplicates ()
+	{
+		PlayQueue queue;
+		QVERIFY (queue.Append (MakeSource (0)));
+		QVERIFY (queue.Append (MakeSource (1)));
+		QVERIFY (!queue.Insert (0, MakeSource (1)));
+		QVERIFY (!queue.Append (MakeSource (0)));
+
+		CheckConsistent (queue, { MakeSource (0), MakeSource (1) });
+
+		QVERIFY (queue.Remove (MakeSource (0)));
+		QVERIFY (!queue.Remove (MakeSource (0)));
+		QVERIFY (!queue.Contains (MakeSource (0)));
+		QVERIFY (queue.Insert (1, MakeSource (0)));
+
+		CheckConsistent (queue, { MakeSource (1), MakeSource (0) });
+	}
+
+	void PlayQueueTest::testRandomOps ()
+	{
+		std::mt19937 gen { 42 };
+
+		PlayQueue queue;
+		QList<AudioSource> reference;
+		for (int i = 0; i < 2000; ++i)
+		{
+			if (!reference.isEmpty () && gen () % 3 == 0)
+			{
+				const auto pos = std::uniform_int_distribution<int> (0, reference.size () - 1) (gen);
+				QVERIFY (queue.Remove (reference.takeAt (pos)));
+			}
+			else
+			{
+				const auto pos = std::uniform_int_distribution<int> (0, reference.size ()) (gen);
+				QVERIFY (queue.Insert (pos, MakeSource (i)));
+				reference.insert (pos, MakeSource (i));
+			}
+		}
+
+		CheckConsistent (queue, reference);
+	}
+
+	void PlayQueueTest::testNeighbours ()
+	{
+		PlayQueue queue;
+		QVERIFY (queue.GetNext (MakeSource (0)).IsEmpty ());
+		QVERIFY (queue.At (0).IsEmpty ());
+
+		queue.Append (MakeSource (0));
+		QVERIFY (queue.GetNext (MakeSource (0)).IsEmpty ());
+		QVERIFY (queue.GetPrevious (MakeSource (0)).IsEmpty ());
+		QVERIFY (queue.GetNext (MakeSource (1)).IsEmpty ());
+		QVERIFY (queue.At (-1).IsEmpty ());
+		QVERIFY (queue.At (1).IsEmpty ());
+	}
+
+	void PlayQueueTest::testFindFirst ()
+	{
+		PlayQueue queue;
+		QCOMPARE (queue.FindFirst ([] (const AudioSource&) { return true; }), 0);
+
+		for (int i = 0; i < 100; i += 2)
+			queue.Append (MakeSource (i));
+
+		const auto isAfter = [] (int num)
+		{
+			const auto& path = MakeSource (num).ToUrl ();
+			return [path] (const AudioSource& other) { return path < other.ToUrl (); };
+		};
+
+		QCOMPARE (queue.FindFirst (isAfter (-1)), 0);
+		QCOMPARE (queue.FindFirst (isAfter (0)), 1);
+		QCOMPARE (queue.FindFirst (isAfter (41)), 21);
+		QCOMPARE (queue.FindFirst (isAfter (42)), 22);
+		QCOMPARE (queue.FindFirst (isAfter (99)), 50);
+	}
+
+	namespace
+	{
+		const int BenchmarkSize = 50000;
+	}
+
+	void PlayQueueTest::benchmarkSortedInsert ()
+	{
+		std::mt19937 gen { 42 };
+		QList<int> nums;
+		for (int i = 0; i < BenchmarkSize; ++i)
+			nums << i;
+		std::shuffle (nums.begin (), nums.end (), gen);
+
+		QBENCHMARK_ONCE
+		{
+			PlayQueue queue;
+			for (const auto num : nums)
+			{
+				const auto& source = MakeSource (num);
+				const auto& url = source.ToUrl ();
+				queue.Insert (queue.FindFirst ([&url] (const AudioSource& other) { return url < other.ToUrl (); }),
+						source);
+			}
+			QCOMPARE (queue.At (BenchmarkSize - 1), MakeSource (BenchmarkSize - 1));
+		}
+	}
+
+	void PlayQueueTest::benchmarkLookup ()
+	{
+		PlayQueue queue;
+		QList<AudioSource> sources;
+		for (int i = 0; i < BenchmarkSize; ++i)
+		{
+			sources << MakeSource (i);
+			queue.Append (sources.last ());
+		}
+
+		QBENCHMARK
+		{
+			for (int i = 0; i < BenchmarkSize; i += 97)
+			{
+				const auto& source = sources.at (i);
+				QCOMPARE (queue.IndexOf (source), i);
+				QCOMPARE (queue.GetNext (source), sources.value (i + 1));
+			}
+		}
+	}
+}
+}
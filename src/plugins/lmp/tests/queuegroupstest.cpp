@@ -0,0 +1,156 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "queuegroupstest.h"
+#include <random>
+#include <QtTest>
+#include "../queuegroups.h"
+
+QTEST_MAIN (LeechCraft::LMP::QueueGroupsTest)
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	namespace
+	{
+		AudioSource MakeSource (int num)
+		{
+			return AudioSource { QString ("/music/%1.ogg").arg (num, 6, 10, QChar ('0')) };
+		}
+
+		void CheckConsistent (const QueueGroups& groups, const QHash<AudioSource, QString>& reference)
+		{
+			QHash<QString, QSet<AudioSource>> refGroups;
+			for (auto i = reference.begin (); i != reference.end (); ++i)
+			{
+				QVERIFY (groups.Contains (i.key ()));
+				QCOMPARE (groups.GetKey (i.key ()), i.value ());
+				refGroups [i.value ()] << i.key ();
+			}
+
+			QCOMPARE (groups.GetGroupsCount (), refGroups.size ());
+
+			QSet<QString> seenKeys;
+			for (int i = 0; i < groups.GetGroupsCount (); ++i)
+			{
+				const auto& key = groups.GetGroupKey (i);
+				QCOMPARE (groups.GetGroupIndex (key), i);
+				QCOMPARE (groups.GetGroup (key), refGroups.value (key));
+				seenKeys << key;
+			}
+			QCOMPARE (seenKeys.size (), refGroups.size ());
+		}
+	}
+
+	void QueueGroupsTest::testSet ()
+	{
+		QueueGroups groups;
+		groups.Set (MakeSource (0), "first");
+		groups.Set (MakeSource (1), "first");
+		groups.Set (MakeSource (2), "second");
+
+		CheckConsistent (groups,
+				{
+					{ MakeSource (0), "first" },
+					{ MakeSource (1), "first" },
+					{ MakeSource (2), "second" }
+				});
+		QVERIFY (!groups.Contains (MakeSource (3)));
+		QCOMPARE (groups.GetGroupIndex ("third"), -1);
+	}
+
+	void QueueGroupsTest::testMove ()
+	{
+		QueueGroups groups;
+		groups.Set (MakeSource (0), "first");
+		groups.Set (MakeSource (1), "second");
+		groups.Set (MakeSource (0), "second");
+
+		CheckConsistent (groups,
+				{
+					{ MakeSource (0), "second" },
+					{ MakeSource (1), "second" }
+				});
+	}
+
+	void QueueGroupsTest::testRemove ()
+	{
+		QueueGroups groups;
+		for (int i = 0; i < 6; ++i)
+			groups.Set (MakeSource (i), QString::number (i / 2));
+
+		groups.Remove (MakeSource (0));
+		groups.Remove (MakeSource (1));
+		groups.Remove (MakeSource (4));
+		groups.Remove (MakeSource (42));
+
+		CheckConsistent (groups,
+				{
+					{ MakeSource (2), "1" },
+					{ MakeSource (3), "1" },
+					{ MakeSource (5), "2" }
+				});
+
+		groups.Clear ();
+		QCOMPARE (groups.GetGroupsCount (), 0);
+		QVERIFY (!groups.Contains (MakeSource (2)));
+	}
+
+	void QueueGroupsTest::testRandomOps ()
+	{
+		std::mt19937 gen { 42 };
+		std::uniform_int_distribution<int> sourceDist { 0, 199 };
+		std::uniform_int_distribution<int> keyDist { 0, 19 };
+		std::uniform_int_distribution<int> opDist { 0, 2 };
+
+		QueueGroups groups;
+		QHash<AudioSource, QString> reference;
+		for (int i = 0; i < 5000; ++i)
+		{
+			const auto& source = MakeSource (sourceDist (gen));
+			if (opDist (gen))
+			{
+				const auto& key = QString::number (keyDist (gen));
+				groups.Set (source, key);
+				reference [source] = key;
+			}
+			else
+			{
+				groups.Remove (source);
+				reference.remove (source);
+			}
+
+			if (!(i % 100))
+				CheckConsistent (groups, reference);
+		}
+		CheckConsistent (groups, reference);
+	}
+}
+}
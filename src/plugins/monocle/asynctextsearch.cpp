@@ -0,0 +1,93 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "asynctextsearch.h"
+#include <functional>
+#include <QFutureWatcher>
+#include <QtConcurrentMap>
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	AsyncTextSearch::AsyncTextSearch (const TextLayerCache_ptr& cache, const QString& text,
+			Qt::CaseSensitivity cs, const QList<int>& pages, QObject *parent)
+	: QObject { parent }
+	, Watcher_ { new QFutureWatcher<PageResult> { this } }
+	{
+		connect (Watcher_,
+				SIGNAL (resultReadyAt (int)),
+				this,
+				SLOT (handleResultReadyAt (int)));
+		connect (Watcher_,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleFinished ()));
+
+		const std::function<PageResult (int)> search = [cache, text, cs] (int page)
+				{
+					return PageResult { page, FindInPageText (*cache->GetPageText (page), text, cs) };
+				};
+		Watcher_->setFuture (QtConcurrent::mapped (pages, search));
+	}
+
+	void AsyncTextSearch::Cancel ()
+	{
+		disconnect (Watcher_,
+				0,
+				this,
+				0);
+		Watcher_->cancel ();
+
+		deleteLater ();
+	}
+
+	void AsyncTextSearch::FlushReadyResults ()
+	{
+		while (ReadyResults_.contains (NextResultIdx_))
+		{
+			const auto& result = ReadyResults_.take (NextResultIdx_++);
+			if (!result.Rects_.isEmpty ())
+				emit gotPageResults (result.Page_, result.Rects_);
+		}
+	}
+
+	void AsyncTextSearch::handleResultReadyAt (int idx)
+	{
+		ReadyResults_ [idx] = Watcher_->resultAt (idx);
+		FlushReadyResults ();
+	}
+
+	void AsyncTextSearch::handleFinished ()
+	{
+		FlushReadyResults ();
+		emit finished ();
+	}
+}
+}
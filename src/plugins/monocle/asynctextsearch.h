@@ -0,0 +1,84 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QRectF>
+#include "textlayercache.h"
+
+template<typename T>
+class QFutureWatcher;
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	/** Searches the pages of a document in the given order on the
+	 * global thread pool.
+	 *
+	 * The results of each page are reported as soon as the page and all
+	 * the pages preceding it in the search order are processed. Pages
+	 * without any occurrences aren't reported at all.
+	 */
+	class AsyncTextSearch : public QObject
+	{
+		Q_OBJECT
+	public:
+		struct PageResult
+		{
+			int Page_;
+			QList<QRectF> Rects_;
+		};
+	private:
+		QFutureWatcher<PageResult> * const Watcher_;
+
+		QHash<int, PageResult> ReadyResults_;
+		int NextResultIdx_ = 0;
+	public:
+		AsyncTextSearch (const TextLayerCache_ptr&, const QString&,
+				Qt::CaseSensitivity, const QList<int>& pages, QObject* = nullptr);
+
+		/** Stops processing the remaining pages and schedules deletion
+		 * of this object. No signals are emitted after this call.
+		 */
+		void Cancel ();
+	private:
+		void FlushReadyResults ();
+	private slots:
+		void handleResultReadyAt (int);
+		void handleFinished ();
+	signals:
+		void gotPageResults (int page, const QList<QRectF>& rects);
+		void finished ();
+	};
+}
+}
@@ -0,0 +1,372 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "documentcache.h"
+#include <algorithm>
+#include <stdexcept>
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSet>
+#include <QtConcurrentRun>
+#include <QtDebug>
+#include "util/monocle/documentcachedir.h"
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	namespace
+	{
+		const quint8 PageSizesVersion = 1;
+
+		const QString PageSizesFileName = "pages";
+		const QString AccessedFileName = "accessed";
+
+		const int MaxDecodedPagesCost = 64 * 1024;
+
+		QString GetPagePrefix (int page)
+		{
+			return QString { "page_%1_" }.arg (page);
+		}
+
+		QString GetPageFileName (int page, const QSize& size)
+		{
+			return GetPagePrefix (page) + QString { "%1x%2.png" }
+					.arg (size.width ())
+					.arg (size.height ());
+		}
+
+		void RemovePageFiles (QDir dir, int page, QSet<QString>& files)
+		{
+			for (const auto& name : dir.entryList ({ GetPagePrefix (page) + "*.png" }, QDir::Files))
+			{
+				dir.remove (name);
+				files.remove (name);
+			}
+		}
+	}
+
+	/* The renderings are written to the disk in the thread pool, so the
+	 * set of the files on the disk and the writes themselves are guarded
+	 * by the mutex. Each RemoveRenderedPages() call bumps the generation
+	 * of the page, and the writes started before that are dropped.
+	 */
+	struct DocumentCache::DiskState
+	{
+		QMutex Lock_;
+		QSet<QString> Files_;
+		QHash<int, quint64> Generations_;
+	};
+
+	DocumentCache::DocumentCache (const IDocument_ptr& doc, const QString& path)
+	: DecodedPages_ { MaxDecodedPagesCost }
+	, DiskState_ { std::make_shared<DiskState> () }
+	{
+		IsValid_ = GetDocumentCacheDir (path, Dir_);
+
+		if (IsValid_)
+		{
+			// Only the modification time of this file matters, it is used
+			// by CleanupCaches() to find out the least recently used caches.
+			QFile accessed { Dir_.filePath (AccessedFileName) };
+			if (accessed.open (QIODevice::WriteOnly))
+				accessed.write (QDateTime::currentDateTime ().toString (Qt::ISODate).toUtf8 ());
+
+			for (const auto& name : Dir_.entryList ({ "page_*.png" }, QDir::Files))
+				DiskState_->Files_ << name;
+
+			if (LoadPageSizes ())
+				return;
+		}
+
+		const auto numPages = doc->GetNumPages ();
+		PageSizes_.reserve (numPages);
+		for (int i = 0; i < numPages; ++i)
+			PageSizes_ << doc->GetPageSize (i);
+
+		if (IsValid_)
+			SavePageSizes ();
+	}
+
+	int DocumentCache::GetNumPages () const
+	{
+		return PageSizes_.size ();
+	}
+
+	QSize DocumentCache::GetPageSize (int page) const
+	{
+		return PageSizes_.value (page);
+	}
+
+	QImage DocumentCache::GetRenderedPage (int page, const QSize& size) const
+	{
+		if (const auto image = DecodedPages_.object (GetPageFileName (page, size)))
+			return *image;
+
+		return {};
+	}
+
+	bool DocumentCache::HasRenderedPage (int page, const QSize& size) const
+	{
+		const auto& name = GetPageFileName (page, size);
+		if (DecodedPages_.contains (name))
+			return true;
+
+		if (!IsValid_)
+			return false;
+
+		QMutexLocker locker { &DiskState_->Lock_ };
+		return DiskState_->Files_.contains (name);
+	}
+
+	QImage DocumentCache::LoadRenderedPage (int page, const QSize& size) const
+	{
+		if (!IsValid_)
+			return {};
+
+		const auto& name = GetPageFileName (page, size);
+		const auto& filename = Dir_.filePath (name);
+
+		QByteArray data;
+		quint64 generation = 0;
+		{
+			QMutexLocker locker { &DiskState_->Lock_ };
+			if (!DiskState_->Files_.contains (name))
+				return {};
+
+			generation = DiskState_->Generations_.value (page);
+
+			QFile file { filename };
+			if (file.open (QIODevice::ReadOnly))
+				data = file.readAll ();
+		}
+
+		QImage image;
+		if (image.loadFromData (data, "PNG"))
+			return image;
+
+		qWarning () << Q_FUNC_INFO
+				<< "unable to load"
+				<< filename;
+
+		QMutexLocker locker { &DiskState_->Lock_ };
+		if (DiskState_->Generations_.value (page) == generation &&
+				DiskState_->Files_.remove (name))
+			QFile::remove (filename);
+		return {};
+	}
+
+	void DocumentCache::SaveRenderedPage (int page, const QSize& size, const QImage& image)
+	{
+		if (image.isNull ())
+			return;
+
+		const auto& name = GetPageFileName (page, size);
+
+		const auto& prefix = GetPagePrefix (page);
+		for (const auto& key : DecodedPages_.keys ())
+			if (key != name && key.startsWith (prefix))
+				DecodedPages_.remove (key);
+		DecodedPages_.insert (name, new QImage { image }, std::max (1, image.byteCount () / 1024));
+
+		if (!IsValid_)
+			return;
+
+		quint64 generation = 0;
+		{
+			QMutexLocker locker { &DiskState_->Lock_ };
+			if (DiskState_->Files_.contains (name))
+				return;
+
+			generation = DiskState_->Generations_.value (page);
+		}
+
+		const auto state = DiskState_;
+		const auto dir = Dir_;
+		QtConcurrent::run ([state, dir, page, name, image, generation]
+				{
+					QByteArray data;
+					QBuffer buffer { &data };
+					buffer.open (QIODevice::WriteOnly);
+					if (!image.save (&buffer, "PNG"))
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "unable to encode"
+								<< name;
+						return;
+					}
+
+					QMutexLocker locker { &state->Lock_ };
+					if (state->Generations_.value (page) != generation)
+						return;
+
+					RemovePageFiles (dir, page, state->Files_);
+
+					QFile file { dir.filePath (name) };
+					if (!file.open (QIODevice::WriteOnly) ||
+							file.write (data) != data.size ())
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "unable to save"
+								<< file.fileName ()
+								<< file.errorString ();
+						file.remove ();
+						return;
+					}
+
+					state->Files_ << name;
+				});
+	}
+
+	void DocumentCache::RemoveRenderedPages (int page)
+	{
+		const auto& prefix = GetPagePrefix (page);
+		for (const auto& key : DecodedPages_.keys ())
+			if (key.startsWith (prefix))
+				DecodedPages_.remove (key);
+
+		if (!IsValid_)
+			return;
+
+		QMutexLocker locker { &DiskState_->Lock_ };
+		++DiskState_->Generations_ [page];
+		RemovePageFiles (Dir_, page, DiskState_->Files_);
+	}
+
+	void DocumentCache::CleanupCaches (qint64 maxSize)
+	{
+		QDir root;
+		try
+		{
+			root = GetDocumentCacheRoot ();
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to get cache directory:"
+					<< e.what ();
+			return;
+		}
+
+		struct CacheInfo
+		{
+			QString Name_;
+			QDateTime Accessed_;
+			qint64 Size_;
+		};
+		QList<CacheInfo> caches;
+		qint64 totalSize = 0;
+
+		for (const auto& name : root.entryList (QDir::Dirs | QDir::NoDotAndDotDot))
+		{
+			const QDir dir { root.filePath (name) };
+
+			qint64 size = 0;
+			for (const auto& info : dir.entryInfoList (QDir::Files))
+				size += info.size ();
+			totalSize += size;
+
+			const QFileInfo accessed { dir.filePath (AccessedFileName) };
+			caches.append ({ name, accessed.lastModified (), size });
+		}
+
+		if (totalSize <= maxSize)
+			return;
+
+		std::sort (caches.begin (), caches.end (),
+				[] (const CacheInfo& left, const CacheInfo& right)
+					{ return left.Accessed_ < right.Accessed_; });
+
+		for (const auto& cache : caches)
+		{
+			if (totalSize <= maxSize)
+				break;
+
+			QDir dir { root.filePath (cache.Name_) };
+			for (const auto& name : dir.entryList (QDir::Files))
+				dir.remove (name);
+			root.rmdir (cache.Name_);
+
+			totalSize -= cache.Size_;
+		}
+	}
+
+	bool DocumentCache::LoadPageSizes ()
+	{
+		QFile file { Dir_.filePath (PageSizesFileName) };
+		if (!file.open (QIODevice::ReadOnly))
+			return false;
+
+		QDataStream stream { &file };
+
+		quint8 version = 0;
+		stream >> version;
+		if (version != PageSizesVersion)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown version"
+					<< version;
+			return false;
+		}
+
+		stream >> PageSizes_;
+		if (stream.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "corrupted page sizes in"
+					<< file.fileName ();
+			PageSizes_.clear ();
+			return false;
+		}
+
+		return true;
+	}
+
+	void DocumentCache::SavePageSizes ()
+	{
+		QFile file { Dir_.filePath (PageSizesFileName) };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream stream { &file };
+		stream << PageSizesVersion
+				<< PageSizes_;
+	}
+}
+}
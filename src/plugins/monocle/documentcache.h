@@ -0,0 +1,104 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QCache>
+#include <QDir>
+#include <QImage>
+#include <QVector>
+#include <QSize>
+#include "interfaces/monocle/idocument.h"
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	/** On-disk cache of the data that is costly to obtain from the
+	 * backends each time a document is opened: the page sizes and the
+	 * renderings of the pages at thumbnail scales.
+	 *
+	 * The cache of a document is keyed by the hash of its size,
+	 * modification time and the beginning of its contents, so it
+	 * survives renaming the file and is dropped if it changes.
+	 *
+	 * The recently used renderings are also kept decoded in memory, so
+	 * that repainting a page doesn't need to touch the disk.
+	 */
+	class DocumentCache
+	{
+		QDir Dir_;
+		bool IsValid_ = false;
+
+		QVector<QSize> PageSizes_;
+
+		QCache<QString, QImage> DecodedPages_;
+
+		struct DiskState;
+		const std::shared_ptr<DiskState> DiskState_;
+	public:
+		DocumentCache (const IDocument_ptr&, const QString& path);
+
+		int GetNumPages () const;
+		QSize GetPageSize (int) const;
+
+		/** Returns the rendering of the \em page at the given \em size
+		 * if it is kept in memory, or a null image otherwise.
+		 */
+		QImage GetRenderedPage (int page, const QSize& size) const;
+
+		/** Checks whether the rendering of the \em page at the given
+		 * \em size is available either in memory or on the disk.
+		 */
+		bool HasRenderedPage (int page, const QSize& size) const;
+
+		/** Loads the rendering of the \em page at the given \em size
+		 * from the disk. This function is thread-safe and is intended to
+		 * be called off the GUI thread. A null image is returned if the
+		 * rendering is not cached or can't be decoded.
+		 */
+		QImage LoadRenderedPage (int page, const QSize& size) const;
+
+		void SaveRenderedPage (int page, const QSize& size, const QImage&);
+		void RemoveRenderedPages (int page);
+
+		/** Removes the caches of the least recently opened documents
+		 * until the total size of the caches fits into \em maxSize
+		 * bytes. This function is thread-safe.
+		 */
+		static void CleanupCaches (qint64 maxSize);
+	private:
+		bool LoadPageSizes ();
+		void SavePageSizes ();
+	};
+
+	typedef std::shared_ptr<DocumentCache> DocumentCache_ptr;
+}
+}
@@ -91,6 +91,7 @@
 #include "coreloadproxy.h"
 #include "core.h"
 #include "searchtabwidget.h"
+#include "documentcachecleaner.h"
 
 namespace LeechCraft
 {
@@ -147,6 +148,10 @@ namespace Monocle
 
 		FindDialog_ = new FindDialog (SearchHandler_, Ui_.PagesView_);
 		FindDialog_->hide ();
+		connect (SearchHandler_,
+				SIGNAL (searchFinished (bool)),
+				this,
+				SLOT (handleSearchFinished (bool)));
 
 		SetupToolbar ();
 
@@ -387,6 +392,7 @@ namespace Monocle
 		Scene_.clear ();
 		Pages_.clear ();
 		CurrentDoc_ = IDocument_ptr ();
+		CurrentDocCache_.reset ();
 		CurrentDocPath_.clear ();
 
 		const auto& pos = Ui_.PagesView_->GetCurrentCenter ();
@@ -880,13 +886,15 @@ namespace Monocle
 		Pages_.clear ();
 
 		CurrentDoc_ = document;
+		CurrentDocCache_ = std::make_shared<DocumentCache> (document, path);
+		new DocumentCacheCleaner { document, this };
 		CurrentDocPath_ = path;
 		const auto& title = QFileInfo (path).fileName ();
 		emit changeTabName (this, title);
 
-		for (int i = 0, size = CurrentDoc_->GetNumPages (); i < size; ++i)
+		for (int i = 0, size = CurrentDocCache_->GetNumPages (); i < size; ++i)
 		{
-			auto item = new PageGraphicsItem (CurrentDoc_, i);
+			auto item = new PageGraphicsItem (CurrentDoc_, i, CurrentDocCache_->GetPageSize (i));
 			Scene_.addItem (item);
 			Pages_ << item;
 		}
@@ -930,7 +938,7 @@ namespace Monocle
 					SLOT (handlePageContentsChanged (int)));
 
 		BMWidget_->HandleDoc (CurrentDoc_);
-		ThumbsWidget_->HandleDoc (CurrentDoc_);
+		ThumbsWidget_->HandleDoc (CurrentDoc_, CurrentDocCache_);
 		SearchTabWidget_->HandleDoc (CurrentDoc_);
 
 		if (const auto ihoc = qobject_cast<IHaveOptionalContent*> (docObj))
@@ -946,6 +954,11 @@ namespace Monocle
 		ExportPDFAction_->setEnabled (qobject_cast<ISupportPainting*> (docObj));
 	}
 
+	void DocumentTab::handleSearchFinished (bool found)
+	{
+		FindDialog_->SetSuccessful (found);
+	}
+
 	void DocumentTab::handleNavigateRequested (QString path, int num, double x, double y)
 	{
 		if (!path.isEmpty ())
@@ -36,6 +36,7 @@
 #include <interfaces/idndtab.h>
 #include "interfaces/monocle/idocument.h"
 #include "docstatemanager.h"
+#include "documentcache.h"
 #include "ui_documenttab.h"
 
 class QDockWidget;
@@ -102,6 +103,7 @@ namespace Monocle
 		QTreeView *OptContentsWidget_ = nullptr;
 
 		IDocument_ptr CurrentDoc_;
+		DocumentCache_ptr CurrentDocCache_;
 		QString CurrentDocPath_;
 		QList<PageGraphicsItem*> Pages_;
 		QGraphicsScene Scene_;
@@ -170,6 +172,7 @@ namespace Monocle
 	private slots:
 		void handleLoaderReady (const IDocument_ptr&, const QString&);
 
+		void handleSearchFinished (bool);
 		void handleNavigateRequested (QString, int, double, double);
 		void handlePrintRequested ();
 
@@ -0,0 +1,104 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QtPlugin>
+#include <QList>
+#include <QRectF>
+#include <QString>
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	/** @brief Describes a single word on a page.
+	 *
+	 * @sa IHaveTextLayer
+	 */
+	struct TextLayerBox
+	{
+		/** @brief The text of the word.
+		 */
+		QString Text_;
+
+		/** @brief The bounding rectangle of the word.
+		 *
+		 * The rectangle is in page coordinates, that is, with width
+		 * from 0 to page's width and height from 0 to page's height.
+		 */
+		QRectF Rect_;
+
+		/** @brief Whether this word is followed by a whitespace.
+		 */
+		bool HasSpaceAfter_;
+	};
+
+	/** @brief The words of a page in reading order.
+	 */
+	typedef QList<TextLayerBox> TextLayer_t;
+
+	/** @brief Interface for documents exposing the positioned text of
+	 * their pages.
+	 *
+	 * Documents implementing this interface allow Monocle to search
+	 * them page by page in background threads, showing the results as
+	 * soon as they are found and caching the text of the already
+	 * searched pages. This is preferred to ISearchableDocument, which
+	 * is only used as a fallback if this interface isn't implemented.
+	 *
+	 * @sa ISearchableDocument
+	 */
+	class IHaveTextLayer
+	{
+	public:
+		/** @brief Virtual destructor.
+		 */
+		virtual ~IHaveTextLayer () {}
+
+		/** @brief Returns the words on the given page.
+		 *
+		 * The words should be returned in reading order, so that
+		 * joining them according to TextLayerBox::HasSpaceAfter_
+		 * yields the text of the page.
+		 *
+		 * This function is called from worker threads, possibly for
+		 * several different pages simultaneously, so it should be
+		 * thread-safe.
+		 *
+		 * @param[in] page The index of the page to query.
+		 * @return The words on the \em page along with their positions.
+		 */
+		virtual TextLayer_t GetTextLayer (int page) = 0;
+	};
+}
+}
+
+Q_DECLARE_INTERFACE (LeechCraft::Monocle::IHaveTextLayer,
+		"org.LeechCraft.Monocle.IHaveTextLayer/1.0");
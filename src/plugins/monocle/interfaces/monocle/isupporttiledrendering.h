@@ -0,0 +1,87 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QtPlugin>
+
+class QImage;
+class QRect;
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	/** @brief Interface for documents supporting rendering parts of
+	 * pages.
+	 *
+	 * This interface should be implemented by IDocument objects that can
+	 * render an arbitrary rectangle of a page without rendering the
+	 * whole page first.
+	 *
+	 * If this interface is implemented, Monocle renders pages shown at
+	 * high zoom levels by tiles, requesting only the tiles that are
+	 * visible. A low resolution rendering of the whole page obtained
+	 * via IDocument::RenderPage() is shown while the tiles are being
+	 * rendered.
+	 *
+	 * If the backend is threaded (see IBackendPlugin::IsThreaded()),
+	 * several tiles of the same page may be requested simultaneously
+	 * from different threads.
+	 *
+	 * @sa IDocument
+	 */
+	class ISupportTiledRendering
+	{
+	public:
+		/** @brief Virtual destructor.
+		 */
+		virtual ~ISupportTiledRendering () {}
+
+		/** @brief Renders the given rectangle of the given page.
+		 *
+		 * The \em rect is in the coordinates of the page scaled by
+		 * \em xScale and \em yScale, that is, in the coordinates of the
+		 * image that would be returned by IDocument::RenderPage() for
+		 * the same scales. The returned image should be of the same
+		 * size as \em rect.
+		 *
+		 * @param[in] page The index of the page to render.
+		 * @param[in] xScale The X-axis scale of the page.
+		 * @param[in] yScale The Y-axis scale of the page.
+		 * @param[in] rect The rectangle of the scaled page to render.
+		 * @return The image with the \em rect of the \em page.
+		 */
+		virtual QImage RenderPageRect (int page, double xScale, double yScale, const QRect& rect) = 0;
+	};
+}
+}
+
+Q_DECLARE_INTERFACE (LeechCraft::Monocle::ISupportTiledRendering,
+		"org.LeechCraft.Monocle.ISupportTiledRendering/1.0");
@@ -30,6 +30,7 @@
 #include "pagegraphicsitem.h"
 #include <limits>
 #include <cmath>
+#include <algorithm>
 #include <QtDebug>
 #include <QtConcurrentRun>
 #include <QFutureWatcher>
@@ -40,6 +41,9 @@
 #include <QGraphicsView>
 #include <QMenu>
 #include <QWidgetAction>
+#include <QPainter>
+#include <QTimer>
+#include "interfaces/monocle/isupporttiledrendering.h"
 #include "core.h"
 #include "pixmapcachemanager.h"
 #include "arbitraryrotationwidget.h"
@@ -49,17 +53,37 @@ namespace LeechCraft
 {
 namespace Monocle
 {
+	namespace
+	{
+		/* Pages larger than this (in pixels) are rendered by tiles if the
+		 * backend supports that.
+		 */
+		const int MaxUntiledArea = 2048 * 2048;
+
+		/* Maximum side of the low resolution rendering of a tiled page
+		 * that is shown while the tiles are being rendered.
+		 */
+		const int PreviewSide = 1024;
+	}
+
 	PageGraphicsItem::PageGraphicsItem (IDocument_ptr doc, int page, QGraphicsItem *parent)
+	: PageGraphicsItem (doc, page, doc->GetPageSize (page), parent)
+	{
+	}
+
+	PageGraphicsItem::PageGraphicsItem (IDocument_ptr doc, int page, const QSize& size, QGraphicsItem *parent)
 	: QGraphicsPixmapItem (parent)
 	, Doc_ (doc)
 	, PageNum_ (page)
+	, PageSize_ (size)
 	, XScale_ (1)
 	, YScale_ (1)
 	, Invalid_ (true)
 	, LayoutManager_ (0)
+	, TileRenderScheduled_ (false)
+	, TilesGeneration_ (std::make_shared<std::atomic<int>> (0))
 	{
 		setTransformationMode (Qt::SmoothTransformation);
-		setPixmap (QPixmap (Doc_->GetPageSize (page)));
 		setAcceptHoverEvents (true);
 	}
 
@@ -81,21 +105,30 @@ namespace Monocle
 		ReleaseHandler_ = handler;
 	}
 
+	void PageGraphicsItem::SetRenderCache (const DocumentCache_ptr& cache)
+	{
+		RenderCache_ = cache;
+	}
+
 	void PageGraphicsItem::SetScale (double xs, double ys)
 	{
 		if (std::abs (xs - XScale_) < std::numeric_limits<double>::epsilon () &&
 			std::abs (ys - YScale_) < std::numeric_limits<double>::epsilon ())
 			return;
 
+		prepareGeometryChange ();
+
+		const auto& oldPixmapScales = GetPixmapScales ();
+
 		XScale_ = xs;
 		YScale_ = ys;
 
-		auto size = Doc_->GetPageSize (PageNum_);
-		size.rwidth () *= xs;
-		size.rheight () *= ys;
-		setPixmap (QPixmap (size));
+		// The old pixmap is shown stretched until the new one is ready.
+		// Tiled pages keep the same low resolution pixmap at any scale.
+		if (GetPixmapScales () != oldPixmapScales)
+			Invalid_ = true;
 
-		Invalid_ = true;
+		ClearTiles ();
 
 		if (IsDisplayed ())
 			update ();
@@ -112,6 +145,11 @@ namespace Monocle
 		return PageNum_;
 	}
 
+	QSize PageGraphicsItem::GetPageSize () const
+	{
+		return PageSize_;
+	}
+
 	QRectF PageGraphicsItem::MapFromDoc (const QRectF& rect) const
 	{
 		return
@@ -148,10 +186,7 @@ namespace Monocle
 
 	void PageGraphicsItem::ClearPixmap ()
 	{
-		auto size = Doc_->GetPageSize (PageNum_);
-		size.rwidth () *= XScale_;
-		size.rheight () *= YScale_;
-		setPixmap (QPixmap (size));
+		setPixmap ({});
 
 		Invalid_ = true;
 	}
@@ -159,40 +194,79 @@ namespace Monocle
 	void PageGraphicsItem::UpdatePixmap ()
 	{
 		Invalid_ = true;
+		ClearTiles ();
+
+		if (RenderCache_)
+			RenderCache_->RemoveRenderedPages (PageNum_);
+
 		if (IsDisplayed ())
 			update ();
 	}
 
+	void PageGraphicsItem::ClearTile (const TileKey_t& key)
+	{
+		Tiles_.remove (key);
+	}
+
+	QRectF PageGraphicsItem::boundingRect () const
+	{
+		return { offset (), GetScaledSize () };
+	}
+
+	QPainterPath PageGraphicsItem::shape () const
+	{
+		QPainterPath path;
+		path.addRect (boundingRect ());
+		return path;
+	}
+
 	void PageGraphicsItem::paint (QPainter *painter,
-			const QStyleOptionGraphicsItem *option, QWidget *w)
+			const QStyleOptionGraphicsItem*, QWidget*)
 	{
 		if (Invalid_ && IsDisplayed ())
 		{
-			auto backendObj = Doc_->GetBackendPlugin ();
-			if (qobject_cast<IBackendPlugin*> (backendObj)->IsThreaded ())
+			const auto& cached = RenderCache_ && !IsTiled () ?
+					RenderCache_->GetRenderedPage (PageNum_, GetScaledSize ()) :
+					QImage {};
+			if (!cached.isNull ())
+				setPixmap (QPixmap::fromImage (cached));
+			else if (RenderCache_ && !IsTiled () &&
+					RenderCache_->HasRenderedPage (PageNum_, GetScaledSize ()))
+			{
+				if (!RenderFuture_)
+					RequestCachedRender ();
+			}
+			else if (IsThreaded ())
 			{
 				if (!RenderFuture_)
 					RequestThreadedRender ();
-
-				auto size = Doc_->GetPageSize (PageNum_);
-				size.rwidth () *= XScale_;
-				size.rheight () *= YScale_;
-				QPixmap px (size);
-				px.fill ();
-				setPixmap (px);
 			}
 			else
 			{
-				const auto& img = Doc_->RenderPage (PageNum_, XScale_, YScale_);
+				const auto& scales = GetPixmapScales ();
+				const auto& img = Doc_->RenderPage (PageNum_, scales.first, scales.second);
 				setPixmap (QPixmap::fromImage (img));
+				SaveToRenderCache (img);
 			}
 			Invalid_ = false;
 
 			Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
 		}
 
-		QGraphicsPixmapItem::paint (painter, option, w);
+		const auto& bounding = boundingRect ();
+		const auto& px = pixmap ();
+		if (px.isNull ())
+			painter->fillRect (bounding, Qt::white);
+		else
+		{
+			painter->setRenderHint (QPainter::SmoothPixmapTransform,
+					transformationMode () == Qt::SmoothTransformation);
+			painter->drawPixmap (bounding, px, px.rect ());
+		}
 		Core::Instance ().GetPixmapCacheManager ()->PixmapPainted (this);
+
+		if (IsTiled ())
+			PaintTiles (painter);
 	}
 
 	void PageGraphicsItem::mousePressEvent (QGraphicsSceneMouseEvent *event)
@@ -244,7 +318,75 @@ namespace Monocle
 		rotateMenu.exec (event->screenPos ());
 	}
 
+	QSize PageGraphicsItem::GetScaledSize () const
+	{
+		auto size = PageSize_;
+		size.rwidth () *= XScale_;
+		size.rheight () *= YScale_;
+		return size;
+	}
+
+	QPair<double, double> PageGraphicsItem::GetPixmapScales () const
+	{
+		if (!IsTiled ())
+			return { XScale_, YScale_ };
+
+		const auto& size = GetScaledSize ();
+		const auto factor = std::min (1.0,
+				static_cast<double> (PreviewSide) / std::max (size.width (), size.height ()));
+		return { XScale_ * factor, YScale_ * factor };
+	}
+
+	void PageGraphicsItem::SaveToRenderCache (const QImage& image)
+	{
+		if (RenderCache_ && !IsTiled ())
+			RenderCache_->SaveRenderedPage (PageNum_, GetScaledSize (), image);
+	}
+
+	bool PageGraphicsItem::IsThreaded () const
+	{
+		return qobject_cast<IBackendPlugin*> (Doc_->GetBackendPlugin ())->IsThreaded ();
+	}
+
 	void PageGraphicsItem::RequestThreadedRender ()
+	{
+		// C++14
+		const auto& scales = GetPixmapScales ();
+		auto xscale = scales.first;
+		auto yscale = scales.second;
+		SetRenderFuture (QtConcurrent::run ([this, xscale, yscale]
+				{
+					return RenderInfo
+					{
+						Doc_->RenderPage (PageNum_, xscale, yscale),
+						xscale,
+						yscale,
+						false
+					};
+				}));
+	}
+
+	void PageGraphicsItem::RequestCachedRender ()
+	{
+		const auto cache = RenderCache_;
+		const auto page = PageNum_;
+		const auto& size = GetScaledSize ();
+		const auto& scales = GetPixmapScales ();
+		auto xscale = scales.first;
+		auto yscale = scales.second;
+		SetRenderFuture (QtConcurrent::run ([cache, page, size, xscale, yscale]
+				{
+					return RenderInfo
+					{
+						cache->LoadRenderedPage (page, size),
+						xscale,
+						yscale,
+						true
+					};
+				}));
+	}
+
+	void PageGraphicsItem::SetRenderFuture (const QFuture<RenderInfo>& future)
 	{
 		RenderFuture_.reset (new QFutureWatcher<RenderInfo>,
 				[this] (QFutureWatcher<RenderInfo> *watcher)
@@ -256,19 +398,7 @@ namespace Monocle
 				SIGNAL (finished ()),
 				this,
 				SLOT (handlePixmapRendered ()));
-
-		// C++14
-		auto xscale = XScale_;
-		auto yscale = YScale_;
-		RenderFuture_->setFuture (QtConcurrent::run ([this, xscale, yscale]
-				{
-					return RenderInfo
-					{
-						Doc_->RenderPage (PageNum_, yscale, yscale),
-						xscale,
-						yscale
-					};
-				}));
+		RenderFuture_->setFuture (future);
 	}
 
 	bool PageGraphicsItem::IsDisplayed () const
@@ -287,6 +417,127 @@ namespace Monocle
 		return false;
 	}
 
+	QRectF PageGraphicsItem::GetVisibleRect () const
+	{
+		QRectF result;
+		for (auto view : scene ()->views ())
+		{
+			const auto& rect = view->viewport ()->rect ();
+			const auto& mapped = view->mapToScene (rect).boundingRect ();
+			result |= mapFromScene (mapped).boundingRect ();
+		}
+
+		return result & boundingRect ();
+	}
+
+	bool PageGraphicsItem::IsTiled () const
+	{
+		const auto& size = GetScaledSize ();
+		return static_cast<qint64> (size.width ()) * size.height () > MaxUntiledArea &&
+				qobject_cast<ISupportTiledRendering*> (Doc_->GetQObject ());
+	}
+
+	void PageGraphicsItem::PaintTiles (QPainter *painter)
+	{
+		const auto& visible = GetVisibleRect ().toAlignedRect ();
+		if (visible.isEmpty ())
+			return;
+
+		const auto cacheMgr = Core::Instance ().GetPixmapCacheManager ();
+
+		for (const auto& key : GetTilesInRect (visible))
+		{
+			const auto pos = Tiles_.find (key);
+			if (pos == Tiles_.end ())
+			{
+				if (!PendingTiles_.contains (key) && !QueuedTiles_.contains (key))
+					RequestTile (key);
+				continue;
+			}
+
+			painter->drawPixmap (GetTileRect (key, GetScaledSize ()).topLeft (), *pos);
+			cacheMgr->TilePainted (this, key);
+		}
+	}
+
+	void PageGraphicsItem::RequestTile (const TileKey_t& key)
+	{
+		const auto& rect = GetTileRect (key, GetScaledSize ());
+		if (rect.isEmpty ())
+			return;
+
+		// Non-threaded backends may only render on the GUI thread, so the
+		// tiles are rendered one per event loop iteration instead of
+		// blocking the painting.
+		if (!IsThreaded ())
+		{
+			QueuedTiles_ << key;
+			if (!TileRenderScheduled_)
+			{
+				TileRenderScheduled_ = true;
+				QTimer::singleShot (0, this, SLOT (renderQueuedTile ()));
+			}
+			return;
+		}
+
+		const auto xscale = XScale_;
+		const auto yscale = YScale_;
+
+		const auto watcher = new QFutureWatcher<RenderInfo> (this);
+		connect (watcher,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleTileRendered ()));
+		PendingTiles_ [key] = watcher;
+
+		// The tiles requested for a previous scale are skipped if they
+		// haven't been started yet.
+		const auto doc = Doc_;
+		const auto pageNum = PageNum_;
+		const auto generation = TilesGeneration_;
+		const int expectedGeneration = *generation;
+		watcher->setFuture (QtConcurrent::run ([=] () -> RenderInfo
+				{
+					if (*generation != expectedGeneration)
+						return RenderInfo { {}, xscale, yscale, false };
+
+					const auto tiled = qobject_cast<ISupportTiledRendering*> (doc->GetQObject ());
+					return RenderInfo
+					{
+						tiled->RenderPageRect (pageNum, xscale, yscale, rect),
+						xscale,
+						yscale,
+						false
+					};
+				}));
+	}
+
+	void PageGraphicsItem::AddTile (const TileKey_t& key, const QImage& image)
+	{
+		const auto& px = QPixmap::fromImage (image);
+		Tiles_ [key] = px;
+		Core::Instance ().GetPixmapCacheManager ()->TileAdded (this, key, px);
+	}
+
+	void PageGraphicsItem::ClearTiles ()
+	{
+		++*TilesGeneration_;
+
+		for (const auto watcher : PendingTiles_)
+		{
+			disconnect (watcher,
+					0,
+					this,
+					0);
+			watcher->deleteLater ();
+		}
+		PendingTiles_.clear ();
+		QueuedTiles_.clear ();
+
+		Tiles_.clear ();
+		Core::Instance ().GetPixmapCacheManager ()->TilesCleared (this);
+	}
+
 	void PageGraphicsItem::rotateCCW ()
 	{
 		LayoutManager_->AddRotation (-90, PageNum_);
@@ -321,16 +572,78 @@ namespace Monocle
 		const auto& result = RenderFuture_->result ();
 		RenderFuture_.reset ();
 
+		// The cached rendering might have turned out to be broken or
+		// might have been dropped by UpdatePixmap() while loading, so
+		// render the page from scratch in this case.
+		if (result.FromCache_ &&
+				(result.Result_.isNull () || !RenderCache_ ||
+				 !RenderCache_->HasRenderedPage (PageNum_, GetScaledSize ())))
+		{
+			Invalid_ = true;
+			if (IsDisplayed ())
+				update ();
+			return;
+		}
+
 		setPixmap (QPixmap::fromImage (result.Result_));
 
-		if (std::abs (result.XScale_ - XScale_) > std::numeric_limits<double>::epsilon () * XScale_ ||
-			std::abs (result.YScale_ - YScale_) > std::numeric_limits<double>::epsilon () * YScale_)
+		const auto& scales = GetPixmapScales ();
+		if (std::abs (result.XScale_ - scales.first) > std::numeric_limits<double>::epsilon () * scales.first ||
+			std::abs (result.YScale_ - scales.second) > std::numeric_limits<double>::epsilon () * scales.second)
 		{
-			UpdatePixmap ();
+			Invalid_ = true;
+			if (IsDisplayed ())
+				update ();
 			return;
 		}
 
 		Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+		SaveToRenderCache (result.Result_);
+	}
+
+	void PageGraphicsItem::handleTileRendered ()
+	{
+		const auto watcher = static_cast<QFutureWatcher<RenderInfo>*> (sender ());
+		watcher->deleteLater ();
+
+		const auto pos = std::find (PendingTiles_.begin (), PendingTiles_.end (), watcher);
+		if (pos == PendingTiles_.end ())
+			return;
+
+		const auto key = pos.key ();
+		PendingTiles_.erase (pos);
+
+		const auto& result = watcher->result ();
+		if (result.Result_.isNull () ||
+				result.XScale_ != XScale_ ||
+				result.YScale_ != YScale_)
+			return;
+
+		AddTile (key, result.Result_);
+		update (GetTileRect (key, GetScaledSize ()));
+	}
+
+	void PageGraphicsItem::renderQueuedTile ()
+	{
+		TileRenderScheduled_ = false;
+		if (QueuedTiles_.isEmpty ())
+			return;
+
+		const auto key = QueuedTiles_.takeFirst ();
+		if (!QueuedTiles_.isEmpty ())
+		{
+			TileRenderScheduled_ = true;
+			QTimer::singleShot (0, this, SLOT (renderQueuedTile ()));
+		}
+
+		// The view might have been scrolled away since the request.
+		const auto& rect = GetTileRect (key, GetScaledSize ());
+		if (!GetVisibleRect ().intersects (rect))
+			return;
+
+		const auto tiled = qobject_cast<ISupportTiledRendering*> (Doc_->GetQObject ());
+		AddTile (key, tiled->RenderPageRect (PageNum_, XScale_, YScale_, rect));
+		update (rect);
 	}
 }
 }
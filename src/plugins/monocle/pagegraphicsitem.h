@@ -31,9 +31,16 @@
 
 #include <functional>
 #include <memory>
+#include <atomic>
 #include <QGraphicsPixmapItem>
 #include <QPointer>
+#include <QHash>
 #include "interfaces/monocle/idocument.h"
+#include "pixmapcachemanager.h"
+#include "documentcache.h"
+
+template<typename T>
+class QFuture;
 
 template<typename T>
 class QFutureWatcher;
@@ -52,6 +59,9 @@ namespace Monocle
 
 		IDocument_ptr Doc_;
 		const int PageNum_;
+		const QSize PageSize_;
+
+		DocumentCache_ptr RenderCache_;
 
 		double XScale_;
 		double YScale_;
@@ -69,8 +79,15 @@ namespace Monocle
 			QImage Result_;
 			double XScale_;
 			double YScale_;
+			bool FromCache_;
 		};
 		std::shared_ptr<QFutureWatcher<RenderInfo>> RenderFuture_;
+
+		QHash<TileKey_t, QPixmap> Tiles_;
+		QHash<TileKey_t, QFutureWatcher<RenderInfo>*> PendingTiles_;
+		QList<TileKey_t> QueuedTiles_;
+		bool TileRenderScheduled_;
+		const std::shared_ptr<std::atomic<int>> TilesGeneration_;
 	public:
 		typedef std::function<void (QRectF)> RectSetter_f;
 	private:
@@ -82,14 +99,18 @@ namespace Monocle
 		QMap<QGraphicsItem*, RectInfo> Item2RectInfo_;
 	public:
 		PageGraphicsItem (IDocument_ptr, int, QGraphicsItem* = 0);
+		PageGraphicsItem (IDocument_ptr, int, const QSize&, QGraphicsItem* = 0);
 		~PageGraphicsItem ();
 
 		void SetLayoutManager (PagesLayoutManager*);
 
 		void SetReleaseHandler (std::function<void (int, QPointF)>);
 
+		void SetRenderCache (const DocumentCache_ptr&);
+
 		void SetScale (double, double);
 		int GetPageNum () const;
+		QSize GetPageSize () const;
 
 		QRectF MapFromDoc (const QRectF&) const;
 		QRectF MapToDoc (const QRectF&) const;
@@ -99,14 +120,33 @@ namespace Monocle
 
 		void ClearPixmap ();
 		void UpdatePixmap ();
+
+		void ClearTile (const TileKey_t&);
+
+		QRectF boundingRect () const;
+		QPainterPath shape () const;
 	protected:
 		void paint (QPainter*, const QStyleOptionGraphicsItem*, QWidget*);
 		void mousePressEvent (QGraphicsSceneMouseEvent*);
 		void mouseReleaseEvent (QGraphicsSceneMouseEvent*);
 		void contextMenuEvent (QGraphicsSceneContextMenuEvent*);
 	private:
+		QSize GetScaledSize () const;
+		QPair<double, double> GetPixmapScales () const;
+		bool IsThreaded () const;
+		void SaveToRenderCache (const QImage&);
+
 		void RequestThreadedRender ();
+		void RequestCachedRender ();
+		void SetRenderFuture (const QFuture<RenderInfo>&);
 		bool IsDisplayed () const;
+		QRectF GetVisibleRect () const;
+
+		bool IsTiled () const;
+		void PaintTiles (QPainter*);
+		void RequestTile (const TileKey_t&);
+		void AddTile (const TileKey_t&, const QImage&);
+		void ClearTiles ();
 	private slots:
 		void rotateCCW ();
 		void rotateCW ();
@@ -115,6 +155,8 @@ namespace Monocle
 		void updateRotation (double, int);
 
 		void handlePixmapRendered ();
+		void handleTileRendered ();
+		void renderQueuedTile ();
 	signals:
 		void rotateRequested (double);
 	};
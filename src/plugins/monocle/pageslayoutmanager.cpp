@@ -278,7 +278,7 @@ namespace Monocle
 			auto page = Pages_ [i];
 
 			const auto& size = GetRotatedSize (i) * scale;
-			const auto& srcSize = CurrentDoc_->GetPageSize (i) * scale;
+			const auto& srcSize = page->GetPageSize () * scale;
 			const auto yDiff = (size.height () - srcSize.height ()) / 2;
 
 			switch (LayMode_)
@@ -324,7 +324,7 @@ namespace Monocle
 
 	QSizeF PagesLayoutManager::GetRotatedSize (int page) const
 	{
-		const auto& origSize = CurrentDoc_->GetPageSize (page);
+		const auto& origSize = Pages_.at (page)->GetPageSize ();
 		const auto rotation = Pages_.at (page)->rotation ();
 		QTransform tf;
 		tf.rotate (rotation);
@@ -29,6 +29,10 @@
 
 #include "pixmapcachemanager.h"
 #include <numeric>
+#include <algorithm>
+#include <QSet>
+#include <QGraphicsScene>
+#include <QGraphicsView>
 #include <QtDebug>
 #include "xmlsettingsmanager.h"
 #include "pagegraphicsitem.h"
@@ -64,9 +68,13 @@ namespace Monocle
 	void PixmapCacheManager::PixmapChanged (PageGraphicsItem *item)
 	{
 		if (RecentlyUsed_.removeAll (item))
-			CurrentSize_ = std::accumulate (RecentlyUsed_.begin (), RecentlyUsed_.end (), 0,
+		{
+			const auto tilesSize = std::accumulate (RecentlyUsedTiles_.begin (), RecentlyUsedTiles_.end (), qint64 { 0 },
+					[] (qint64 size, const TileInfo& info) { return size + info.Size_; });
+			CurrentSize_ = std::accumulate (RecentlyUsed_.begin (), RecentlyUsed_.end (), tilesSize,
 					[] (qint64 size, decltype (RecentlyUsed_.front ()) item)
 						{ return size + GetPixmapSize (item->pixmap ()); });
+		}
 
 		RecentlyUsed_ << item;
 		CurrentSize_ += GetPixmapSize (item->pixmap ());
@@ -77,10 +85,82 @@ namespace Monocle
 	{
 		CurrentSize_ -= GetPixmapSize (item->pixmap ());
 		RecentlyUsed_.removeAll (item);
+
+		TilesCleared (item);
+	}
+
+	void PixmapCacheManager::TileAdded (PageGraphicsItem *item, const TileKey_t& key, const QPixmap& px)
+	{
+		const auto pos = FindTile (item, key);
+		if (pos != RecentlyUsedTiles_.end ())
+		{
+			CurrentSize_ -= pos->Size_;
+			RecentlyUsedTiles_.erase (pos);
+		}
+
+		const auto size = GetPixmapSize (px);
+		RecentlyUsedTiles_.append ({ item, key, static_cast<qint64> (size) });
+		CurrentSize_ += size;
+		CheckCache ();
+	}
+
+	void PixmapCacheManager::TilePainted (PageGraphicsItem *item, const TileKey_t& key)
+	{
+		const auto pos = FindTile (item, key);
+		if (pos == RecentlyUsedTiles_.end ())
+			return;
+
+		const auto info = *pos;
+		RecentlyUsedTiles_.erase (pos);
+		RecentlyUsedTiles_ << info;
+	}
+
+	void PixmapCacheManager::TilesCleared (PageGraphicsItem *item)
+	{
+		for (auto i = RecentlyUsedTiles_.begin (); i != RecentlyUsedTiles_.end (); )
+			if (i->Page_ == item)
+			{
+				CurrentSize_ -= i->Size_;
+				i = RecentlyUsedTiles_.erase (i);
+			}
+			else
+				++i;
+	}
+
+	auto PixmapCacheManager::FindTile (PageGraphicsItem *item, const TileKey_t& key) -> QList<TileInfo>::iterator
+	{
+		return std::find_if (RecentlyUsedTiles_.begin (), RecentlyUsedTiles_.end (),
+				[item, &key] (const TileInfo& info) { return info.Page_ == item && info.Key_ == key; });
+	}
+
+	/* The tiles painted most recently are most probably visible, so
+	 * evicting them would just make the page request them again. Thus as
+	 * many of them are kept as may fit into the views showing the pages.
+	 */
+	int PixmapCacheManager::GetMinKeptTiles () const
+	{
+		QSet<QGraphicsView*> views;
+		for (const auto& tile : RecentlyUsedTiles_)
+			if (const auto scene = tile.Page_->scene ())
+				for (const auto view : scene->views ())
+					views << view;
+
+		int result = 0;
+		for (const auto view : views)
+			result += GetMaxVisibleTiles (view->viewport ()->size ());
+		return result;
 	}
 
 	void PixmapCacheManager::CheckCache ()
 	{
+		const auto minKeptTiles = GetMinKeptTiles ();
+		while (MaxSize_ < CurrentSize_ && RecentlyUsedTiles_.size () > minKeptTiles)
+		{
+			const auto tile = RecentlyUsedTiles_.takeFirst ();
+			CurrentSize_ -= tile.Size_;
+			tile.Page_->ClearTile (tile.Key_);
+		}
+
 		while (MaxSize_ < CurrentSize_ && RecentlyUsed_.size () > 2)
 		{
 			auto page = RecentlyUsed_.takeFirst ();
@@ -30,6 +30,9 @@
 #pragma once
 
 #include <QObject>
+#include "tilegeometry.h"
+
+class QPixmap;
 
 namespace LeechCraft
 {
@@ -44,13 +47,27 @@ namespace Monocle
 		qint64 CurrentSize_;
 		qint64 MaxSize_;
 		QList<PageGraphicsItem*> RecentlyUsed_;
+
+		struct TileInfo
+		{
+			PageGraphicsItem *Page_;
+			TileKey_t Key_;
+			qint64 Size_;
+		};
+		QList<TileInfo> RecentlyUsedTiles_;
 	public:
 		PixmapCacheManager (QObject* = 0);
 
 		void PixmapPainted (PageGraphicsItem*);
 		void PixmapChanged (PageGraphicsItem*);
 		void PixmapDeleted (PageGraphicsItem*);
+
+		void TileAdded (PageGraphicsItem*, const TileKey_t&, const QPixmap&);
+		void TilePainted (PageGraphicsItem*, const TileKey_t&);
+		void TilesCleared (PageGraphicsItem*);
 	private:
+		QList<TileInfo>::iterator FindTile (PageGraphicsItem*, const TileKey_t&);
+		int GetMinKeptTiles () const;
 		void CheckCache ();
 	private slots:
 		void handleCacheSizeChanged ();
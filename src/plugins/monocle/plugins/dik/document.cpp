@@ -34,6 +34,7 @@
 #include <QTextDocument>
 #include <QTextFrameFormat>
 #include <QTextFrame>
+#include <util/monocle/textdocumentcache.h>
 #include "mobiparser.h"
 
 namespace LeechCraft
@@ -94,31 +95,42 @@ namespace Dik
 		if (!Parser_->IsValid ())
 			return;
 
-		QString contents;
-		try
-		{
-			contents = Parser_->GetText ();
-		}
-		catch (const std::exception&)
+		auto doc = new MobiTextDocument (Parser_);
+		doc->setUndoRedoEnabled (false);
+
+		// The images are still loaded from the parser on demand, so only
+		// the decompressed and fixed up markup comes from the cache.
+		const TextDocumentCache cache { filename, "mobi_1" };
+		TOCEntryLevel_t toc;
+		if (!cache.Load (doc, Info_, toc, [] (int) { return ILink_ptr (); }))
 		{
-			return;
+			QString contents;
+			try
+			{
+				contents = Parser_->GetText ();
+			}
+			catch (const std::exception&)
+			{
+				delete doc;
+				return;
+			}
+
+			if (contents.contains ("<html", Qt::CaseInsensitive))
+				doc->setHtml (Fix (contents));
+			else
+				doc->setPlainText (contents);
+
+			Info_ = Parser_->GetDocInfo ();
+			cache.Save (doc, Info_, toc);
 		}
 
-		auto doc = new MobiTextDocument (Parser_);
 		doc->setPageSize (QSize (600, 800));
-		doc->setUndoRedoEnabled (false);
-
-		if (contents.contains ("<html", Qt::CaseInsensitive))
-			doc->setHtml (Fix (contents));
-		else
-			doc->setPlainText (contents);
 
 		QTextFrameFormat format;
 		format.setMargin (30);
 		doc->rootFrame ()->setFrameFormat (format);
 
 		SetDocument (doc);
-		Info_ = Parser_->GetDocInfo ();
 	}
 
 	QObject* Document::GetBackendPlugin () const
@@ -32,7 +32,9 @@
 #include <QDomDocument>
 #include <QtDebug>
 #include <QTextDocument>
+#include <util/monocle/textdocumentcache.h>
 #include "fb2converter.h"
+#include "toclink.h"
 #include "xmlsettingsmanager.h"
 
 namespace LeechCraft
@@ -47,28 +49,20 @@ namespace FXB
 	{
 		SetSettings ();
 
-		QFile file (filename);
-		if (!file.open (QIODevice::ReadOnly))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to open file"
-					<< file.fileName ()
-					<< file.errorString ();
-			return;
-		}
+		const TextDocumentCache cache { filename, "fb2_1" };
 
-		QDomDocument doc;
-		if (!doc.setContent (file.readAll (), true))
+		auto textDoc = new QTextDocument;
+		const auto& makeLink = [this] (int page) { return ILink_ptr (new TOCLink (this, page)); };
+		if (cache.Load (textDoc, Info_, TOC_, makeLink))
+			FB2Converter::SetupDocument (textDoc);
+		else
 		{
-			qWarning () << Q_FUNC_INFO
-					<< "malformed XML in"
-					<< filename;
-			return;
+			delete textDoc;
+			textDoc = Convert (filename, cache);
+			if (!textDoc)
+				return;
 		}
 
-		FB2Converter conv (this, doc);
-		auto textDoc = conv.GetResult ();
-
 		const auto& defaultFont = XmlSettingsManager::Instance ()
 				.property ("DefaultFont").value<QFont> ();
 		textDoc->setDefaultFont (defaultFont);
@@ -79,8 +73,6 @@ namespace FXB
 			});
 
 		SetDocument (textDoc);
-		Info_ = conv.GetDocumentInfo ();
-		TOC_ = conv.GetTOC ();
 	}
 
 	QObject* Document::GetBackendPlugin () const
@@ -113,6 +105,38 @@ namespace FXB
 		emit navigateRequested (QString (), page, 0, 0.4);
 	}
 
+	QTextDocument* Document::Convert (const QString& filename, const TextDocumentCache& cache)
+	{
+		QFile file (filename);
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open file"
+					<< file.fileName ()
+					<< file.errorString ();
+			return nullptr;
+		}
+
+		QDomDocument doc;
+		if (!doc.setContent (file.readAll (), true))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "malformed XML in"
+					<< filename;
+			return nullptr;
+		}
+
+		FB2Converter conv (this, doc);
+		auto textDoc = conv.GetResult ();
+		Info_ = conv.GetDocumentInfo ();
+		TOC_ = conv.GetTOC ();
+
+		if (conv.GetError ().isEmpty ())
+			cache.Save (textDoc, Info_, TOC_, "image");
+
+		return textDoc;
+	}
+
 	void Document::SetSettings ()
 	{
 		auto setRenderHint = [this] (const QByteArray& option, QPainter::RenderHint hint)
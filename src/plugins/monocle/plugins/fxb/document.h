@@ -38,6 +38,8 @@ namespace LeechCraft
 {
 namespace Monocle
 {
+	class TextDocumentCache;
+
 namespace FXB
 {
 	class Document : public QObject
@@ -48,7 +50,8 @@ namespace FXB
 		Q_INTERFACES (LeechCraft::Monocle::IDocument
 				LeechCraft::Monocle::IHaveTOC
 				LeechCraft::Monocle::ISearchableDocument
-				LeechCraft::Monocle::ISupportPainting)
+				LeechCraft::Monocle::ISupportPainting
+				LeechCraft::Monocle::ISupportTiledRendering)
 
 		DocumentInfo Info_;
 		TOCEntryLevel_t TOC_;
@@ -67,6 +70,7 @@ namespace FXB
 
 		void RequestNavigation (int);
 	private:
+		QTextDocument* Convert (const QString&, const TextDocumentCache&);
 		void SetSettings ();
 	signals:
 		void navigateRequested (const QString&, int pageNum, double x, double y);
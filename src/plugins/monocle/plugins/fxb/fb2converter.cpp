@@ -56,8 +56,7 @@ namespace FXB
 	, Cursor_ (new QTextCursor (Result_))
 	, SectionLevel_ (0)
 	{
-		Result_->setPageSize (QSize (600, 800));
-		Result_->setUndoRedoEnabled (false);
+		SetupDocument (Result_);
 
 		const auto& docElem = FB2_.documentElement ();
 		if (docElem.tagName () != "FictionBook")
@@ -66,12 +65,6 @@ namespace FXB
 			return;
 		}
 
-		auto frameFmt = Result_->rootFrame ()->frameFormat ();
-		frameFmt.setMargin (20);
-		const auto& pal = qApp->palette ();
-		frameFmt.setBackground (pal.brush (QPalette::Base));
-		Result_->rootFrame ()->setFrameFormat (frameFmt);
-
 		Handlers_ ["section"] = [this] (const QDomElement& p) { HandleSection (p); };
 		Handlers_ ["title"] = [this] (const QDomElement& p) { HandleTitle (p); };
 		Handlers_ ["subtitle"] = [this] (const QDomElement& p) { HandleTitle (p, 1); };
@@ -175,6 +168,18 @@ namespace FXB
 		return TOC_;
 	}
 
+	void FB2Converter::SetupDocument (QTextDocument *doc)
+	{
+		doc->setPageSize (QSize (600, 800));
+		doc->setUndoRedoEnabled (false);
+
+		auto frameFmt = doc->rootFrame ()->frameFormat ();
+		frameFmt.setMargin (20);
+		const auto& pal = qApp->palette ();
+		frameFmt.setBackground (pal.brush (QPalette::Base));
+		doc->rootFrame ()->setFrameFormat (frameFmt);
+	}
+
 	QDomElement FB2Converter::FindBinary (const QString& refId) const
 	{
 		const auto& binaries = FB2_.elementsByTagName ("binary");
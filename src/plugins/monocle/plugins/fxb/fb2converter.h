@@ -80,6 +80,8 @@ namespace FXB
 		QTextDocument* GetResult () const;
 		DocumentInfo GetDocumentInfo () const;
 		TOCEntryLevel_t GetTOC () const;
+
+		static void SetupDocument (QTextDocument*);
 	private:
 		QDomElement FindBinary (const QString&) const;
 
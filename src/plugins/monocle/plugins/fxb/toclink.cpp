@@ -56,6 +56,31 @@ namespace FXB
 	{
 		Doc_->RequestNavigation (Page_);
 	}
+
+	QString TOCLink::GetDocumentFilename () const
+	{
+		return QString ();
+	}
+
+	int TOCLink::GetPageNumber () const
+	{
+		return Page_;
+	}
+
+	double TOCLink::NewX () const
+	{
+		return 0;
+	}
+
+	double TOCLink::NewY () const
+	{
+		return 0.4;
+	}
+
+	double TOCLink::NewZoom () const
+	{
+		return 0;
+	}
 }
 }
 }
@@ -42,6 +42,7 @@ namespace FXB
 
 	class TOCLink : public QObject
 				 , public ILink
+				 , public IPageLink
 	{
 		Q_OBJECT
 
@@ -54,6 +55,12 @@ namespace FXB
 		QRectF GetArea () const;
 
 		void Execute ();
+
+		QString GetDocumentFilename () const;
+		int GetPageNumber () const;
+		double NewX () const;
+		double NewY () const;
+		double NewZoom () const;
 	};
 }
 }
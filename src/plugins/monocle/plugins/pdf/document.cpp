@@ -55,6 +55,31 @@ namespace Monocle
 {
 namespace PDF
 {
+	namespace
+	{
+		void SetupRenderHints (Poppler::Document& doc)
+		{
+			auto setRenderHint = [&doc] (const QByteArray& optName, Poppler::Document::RenderHint hint)
+			{
+				doc.setRenderHint (hint,
+						XmlSettingsManager::Instance ().property (optName).toBool ());
+			};
+			setRenderHint ("EnableAntialiasing", Poppler::Document::Antialiasing);
+			setRenderHint ("EnableTextAntialiasing", Poppler::Document::TextAntialiasing);
+			setRenderHint ("EnableTextHinting", Poppler::Document::TextHinting);
+			setRenderHint ("EnableTextSlightHinting", Poppler::Document::TextSlightHinting);
+
+#if POPPLER_VERSION_MAJOR > 0 || POPPLER_VERSION_MINOR >= 24
+			const auto& enhanceMode = XmlSettingsManager::Instance ()
+					.property ("ThinLineEnhancement").toString ();
+			if (enhanceMode == "Solid")
+				doc.setRenderHint (Poppler::Document::ThinLineSolid);
+			else if (enhanceMode == "Shape")
+				doc.setRenderHint (Poppler::Document::ThinLineShape);
+#endif
+		}
+	}
+
 	Document::Document (const QString& path, QObject *plugin)
 	: PDocument_ (Poppler::Document::load (path))
 	, DocURL_ (QUrl::fromLocalFile (path))
@@ -63,24 +88,7 @@ namespace PDF
 		if (!PDocument_)
 			return;
 
-		auto setRenderHint = [this] (const QByteArray& optName, Poppler::Document::RenderHint hint)
-		{
-			PDocument_->setRenderHint (hint,
-					XmlSettingsManager::Instance ().property (optName).toBool ());
-		};
-		setRenderHint ("EnableAntialiasing", Poppler::Document::Antialiasing);
-		setRenderHint ("EnableTextAntialiasing", Poppler::Document::TextAntialiasing);
-		setRenderHint ("EnableTextHinting", Poppler::Document::TextHinting);
-		setRenderHint ("EnableTextSlightHinting", Poppler::Document::TextSlightHinting);
-
-#if POPPLER_VERSION_MAJOR > 0 || POPPLER_VERSION_MINOR >= 24
-		const auto& enhanceMode = XmlSettingsManager::Instance ()
-				.property ("ThinLineEnhancement").toString ();
-		if (enhanceMode == "Solid")
-			PDocument_->setRenderHint (Poppler::Document::ThinLineSolid);
-		else if (enhanceMode == "Shape")
-			PDocument_->setRenderHint (Poppler::Document::ThinLineShape);
-#endif
+		SetupRenderHints (*PDocument_);
 
 		BuildTOC ();
 	}
@@ -244,6 +252,22 @@ namespace PDF
 		page->renderToPainter (painter, 72 * xScale, 72 * yScale);
 	}
 
+	QImage Document::RenderPageRect (int num, double xScale, double yScale, const QRect& rect)
+	{
+		const auto& doc = AcquireWorkerDoc ();
+		if (!doc)
+			return {};
+
+		const auto guard = Util::MakeScopeGuard ([this, doc] { ReleaseWorkerDoc (doc); });
+
+		std::unique_ptr<Poppler::Page> page (doc->page (num));
+		if (!page)
+			return {};
+
+		return page->renderToImage (72 * xScale, 72 * yScale,
+				rect.x (), rect.y (), rect.width (), rect.height ());
+	}
+
 	QMap<int, QList<QRectF>> Document::GetTextPositions (const QString& text, Qt::CaseSensitivity cs)
 	{
 		typedef QMap<int, QList<QRectF>> Result_t;
@@ -290,6 +314,26 @@ namespace PDF
 		return result;
 	}
 
+	TextLayer_t Document::GetTextLayer (int pageNum)
+	{
+		const auto& doc = AcquireWorkerDoc ();
+		if (!doc)
+			return {};
+
+		const auto guard = Util::MakeScopeGuard ([this, doc] { ReleaseWorkerDoc (doc); });
+
+		std::unique_ptr<Poppler::Page> page (doc->page (pageNum));
+		if (!page)
+			return {};
+
+		TextLayer_t result;
+		const auto& boxes = page->textList ();
+		for (const auto box : boxes)
+			result.append (TextLayerBox { box->text (), box->boundingBox (), box->hasSpaceAfter () });
+		qDeleteAll (boxes);
+		return result;
+	}
+
 	auto Document::CanSave () const -> SaveQueryResult
 	{
 		if (PDocument_->isEncrypted ())
@@ -396,6 +440,28 @@ namespace PDF
 			return;
 		TOC_ = BuildTOCLevel (this, PDocument_, *doc);
 	}
+
+	PDocument_ptr Document::AcquireWorkerDoc ()
+	{
+		{
+			QMutexLocker locker { &WorkerDocsMutex_ };
+			if (!WorkerDocs_.isEmpty ())
+				return WorkerDocs_.takeLast ();
+		}
+
+		// Poppler documents can't be used from several threads at once,
+		// so each worker thread gets its own instance of the document.
+		const PDocument_ptr doc { Poppler::Document::load (DocURL_.toLocalFile ()) };
+		if (doc)
+			SetupRenderHints (*doc);
+		return doc;
+	}
+
+	void Document::ReleaseWorkerDoc (const PDocument_ptr& doc)
+	{
+		QMutexLocker locker { &WorkerDocsMutex_ };
+		WorkerDocs_ << doc;
+	}
 }
 }
 }
@@ -32,6 +32,7 @@
 #include <memory>
 #include <QObject>
 #include <QUrl>
+#include <QMutex>
 #include <interfaces/monocle/idocument.h>
 #include <interfaces/monocle/ihavetoc.h>
 #include <interfaces/monocle/ihavetextcontent.h>
@@ -39,8 +40,10 @@
 #include <interfaces/monocle/isupportannotations.h>
 #include <interfaces/monocle/isupportforms.h>
 #include <interfaces/monocle/isearchabledocument.h>
+#include <interfaces/monocle/ihavetextlayer.h>
 #include <interfaces/monocle/isaveabledocument.h>
 #include <interfaces/monocle/isupportpainting.h>
+#include <interfaces/monocle/isupporttiledrendering.h>
 #include <interfaces/monocle/ihaveoptionalcontent.h>
 
 namespace Poppler
@@ -65,7 +68,9 @@ namespace PDF
 				   , public ISupportAnnotations
 				   , public ISupportForms
 				   , public ISupportPainting
+				   , public ISupportTiledRendering
 				   , public ISearchableDocument
+				   , public IHaveTextLayer
 				   , public ISaveableDocument
 	{
 		Q_OBJECT
@@ -77,13 +82,18 @@ namespace PDF
 				LeechCraft::Monocle::ISupportAnnotations
 				LeechCraft::Monocle::ISupportForms
 				LeechCraft::Monocle::ISupportPainting
+				LeechCraft::Monocle::ISupportTiledRendering
 				LeechCraft::Monocle::ISearchableDocument
+				LeechCraft::Monocle::IHaveTextLayer
 				LeechCraft::Monocle::ISaveableDocument)
 
 		PDocument_ptr PDocument_;
 		TOCEntryLevel_t TOC_;
 		QUrl DocURL_;
 
+		QMutex WorkerDocsMutex_;
+		QList<PDocument_ptr> WorkerDocs_;
+
 		QObject *Plugin_;
 	public:
 		Document (const QString&, QObject*);
@@ -112,8 +122,12 @@ namespace PDF
 
 		void PaintPage (QPainter*, int, double, double);
 
+		QImage RenderPageRect (int, double, double, const QRect&);
+
 		QMap<int, QList<QRectF>> GetTextPositions (const QString&, Qt::CaseSensitivity);
 
+		TextLayer_t GetTextLayer (int);
+
 		SaveQueryResult CanSave () const;
 		bool Save (const QString& path);
 
@@ -121,6 +135,9 @@ namespace PDF
 		void RequestPrinting ();
 	private:
 		void BuildTOC ();
+
+		PDocument_ptr AcquireWorkerDoc ();
+		void ReleaseWorkerDoc (const PDocument_ptr&);
 	signals:
 		void navigateRequested (const QString&, int, double, double);
 		void printRequested (const QList<int>&);
@@ -0,0 +1,243 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "documentcachetest.h"
+#include <QtTest>
+#include <QTemporaryFile>
+#include <QTextDocument>
+#include <QThreadPool>
+#include <util/monocle/documentcachedir.h>
+#include <util/monocle/textdocumentadapter.h>
+#include "documentcache.h"
+
+QTEST_MAIN (LeechCraft::Monocle::DocumentCacheTest)
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	namespace
+	{
+		class TestDocument : public TextDocumentAdapter
+		{
+		public:
+			TestDocument ()
+			{
+				const auto doc = new QTextDocument;
+				doc->setPageSize ({ 200, 300 });
+
+				QString html;
+				for (int i = 0; i < 40; ++i)
+					html += QString ("<p>Paragraph %1 of the test document.</p>").arg (i);
+				doc->setHtml (html);
+
+				SetDocument (doc);
+			}
+
+			QObject* GetBackendPlugin () const
+			{
+				return nullptr;
+			}
+
+			QObject* GetQObject ()
+			{
+				return nullptr;
+			}
+
+			DocumentInfo GetDocumentInfo () const
+			{
+				return {};
+			}
+
+			QUrl GetDocURL () const
+			{
+				return {};
+			}
+
+			void navigateRequested (const QString&, int, double, double)
+			{
+			}
+
+			void printRequested (const QList<int>&)
+			{
+			}
+		};
+
+		/* The document file with the contents unique to the current test
+		 * function, so that each test gets its own cache directory, which
+		 * is removed when the test finishes.
+		 */
+		class TestFile
+		{
+			QTemporaryFile File_;
+		public:
+			TestFile ()
+			{
+				File_.open ();
+				File_.write (QTest::currentTestFunction ());
+				File_.flush ();
+			}
+
+			~TestFile ()
+			{
+				QThreadPool::globalInstance ()->waitForDone ();
+
+				QDir dir;
+				if (!GetDocumentCacheDir (GetPath (), dir))
+					return;
+
+				for (const auto& name : dir.entryList (QDir::Files))
+					dir.remove (name);
+				const auto& key = dir.dirName ();
+				dir.cdUp ();
+				dir.rmdir (key);
+			}
+
+			QString GetPath () const
+			{
+				return File_.fileName ();
+			}
+		};
+
+		QImage MakeImage (const QSize& size)
+		{
+			QImage image { size, QImage::Format_RGB32 };
+			image.fill (qRgb (255, 128, 0));
+			return image;
+		}
+	}
+
+	void DocumentCacheTest::pageSizes ()
+	{
+		TestFile file;
+		const auto doc = std::make_shared<TestDocument> ();
+		QVERIFY (doc->GetNumPages () > 1);
+
+		const DocumentCache cache { doc, file.GetPath () };
+		QCOMPARE (cache.GetNumPages (), doc->GetNumPages ());
+		for (int i = 0; i < doc->GetNumPages (); ++i)
+			QCOMPARE (cache.GetPageSize (i), doc->GetPageSize (i));
+	}
+
+	void DocumentCacheTest::renderedPageInMemory ()
+	{
+		TestFile file;
+		DocumentCache cache { std::make_shared<TestDocument> (), file.GetPath () };
+
+		const QSize size { 40, 60 };
+		const auto& image = MakeImage (size);
+		cache.SaveRenderedPage (1, size, image);
+
+		QVERIFY (cache.HasRenderedPage (1, size));
+		QCOMPARE (cache.GetRenderedPage (1, size), image);
+		QVERIFY (cache.GetRenderedPage (0, size).isNull ());
+	}
+
+	void DocumentCacheTest::renderedPageOnDisk ()
+	{
+		TestFile file;
+		const auto doc = std::make_shared<TestDocument> ();
+
+		const QSize size { 40, 60 };
+		const auto& image = MakeImage (size);
+		DocumentCache { doc, file.GetPath () }.SaveRenderedPage (1, size, image);
+		QThreadPool::globalInstance ()->waitForDone ();
+
+		const DocumentCache cache { doc, file.GetPath () };
+		QVERIFY (cache.GetRenderedPage (1, size).isNull ());
+		QVERIFY (cache.HasRenderedPage (1, size));
+		QCOMPARE (cache.LoadRenderedPage (1, size).convertToFormat (image.format ()), image);
+	}
+
+	void DocumentCacheTest::otherSizeReplaced ()
+	{
+		TestFile file;
+		const auto doc = std::make_shared<TestDocument> ();
+
+		const QSize oldSize { 40, 60 };
+		const QSize newSize { 80, 120 };
+		{
+			DocumentCache cache { doc, file.GetPath () };
+			cache.SaveRenderedPage (1, oldSize, MakeImage (oldSize));
+			QThreadPool::globalInstance ()->waitForDone ();
+			cache.SaveRenderedPage (1, newSize, MakeImage (newSize));
+			QThreadPool::globalInstance ()->waitForDone ();
+
+			QVERIFY (cache.GetRenderedPage (1, oldSize).isNull ());
+		}
+
+		const DocumentCache cache { doc, file.GetPath () };
+		QVERIFY (!cache.HasRenderedPage (1, oldSize));
+		QVERIFY (cache.HasRenderedPage (1, newSize));
+	}
+
+	void DocumentCacheTest::removeAfterSave ()
+	{
+		TestFile file;
+		const auto doc = std::make_shared<TestDocument> ();
+
+		const QSize size { 40, 60 };
+		{
+			DocumentCache cache { doc, file.GetPath () };
+			cache.SaveRenderedPage (1, size, MakeImage (size));
+			QThreadPool::globalInstance ()->waitForDone ();
+			cache.RemoveRenderedPages (1);
+
+			QVERIFY (!cache.HasRenderedPage (1, size));
+		}
+
+		const DocumentCache cache { doc, file.GetPath () };
+		QVERIFY (!cache.HasRenderedPage (1, size));
+	}
+
+	void DocumentCacheTest::removeDuringSave ()
+	{
+		TestFile file;
+		const auto doc = std::make_shared<TestDocument> ();
+
+		const QSize size { 400, 600 };
+		{
+			DocumentCache cache { doc, file.GetPath () };
+			for (int i = 0; i < 10; ++i)
+			{
+				cache.SaveRenderedPage (i, size, MakeImage (size));
+				cache.RemoveRenderedPages (i);
+			}
+			QThreadPool::globalInstance ()->waitForDone ();
+
+			for (int i = 0; i < 10; ++i)
+				QVERIFY (!cache.HasRenderedPage (i, size));
+		}
+
+		const DocumentCache cache { doc, file.GetPath () };
+		for (int i = 0; i < 10; ++i)
+			QVERIFY (!cache.HasRenderedPage (i, size));
+	}
+}
+}
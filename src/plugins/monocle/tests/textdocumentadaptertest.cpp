@@ -0,0 +1,122 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "textdocumentadaptertest.h"
+#include <QtTest>
+#include <QTextDocument>
+#include <util/monocle/textdocumentadapter.h>
+
+QTEST_MAIN (LeechCraft::Monocle::TextDocumentAdapterTest)
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	namespace
+	{
+		class TestDocument : public TextDocumentAdapter
+		{
+		public:
+			TestDocument ()
+			{
+				const auto doc = new QTextDocument;
+				doc->setPageSize ({ 200, 300 });
+
+				QString html;
+				for (int i = 0; i < 40; ++i)
+					html += QString ("<p>Paragraph %1 of the <b>test</b> document.</p>").arg (i);
+				doc->setHtml (html);
+
+				SetDocument (doc);
+			}
+
+			QObject* GetBackendPlugin () const
+			{
+				return nullptr;
+			}
+
+			QObject* GetQObject ()
+			{
+				return nullptr;
+			}
+
+			DocumentInfo GetDocumentInfo () const
+			{
+				return {};
+			}
+
+			QUrl GetDocURL () const
+			{
+				return {};
+			}
+
+			void navigateRequested (const QString&, int, double, double)
+			{
+			}
+
+			void printRequested (const QList<int>&)
+			{
+			}
+		};
+	}
+
+	void TextDocumentAdapterTest::tileSize ()
+	{
+		TestDocument doc;
+		const QRect rect { 10, 20, 64, 32 };
+		QCOMPARE (doc.RenderPageRect (0, 1, 1, rect).size (), rect.size ());
+	}
+
+	void TextDocumentAdapterTest::tileMatchesPage ()
+	{
+		TestDocument doc;
+		const QRect rect { 20, 40, 100, 120 };
+		QCOMPARE (doc.RenderPageRect (0, 1, 1, rect),
+				doc.RenderPage (0, 1, 1).copy (rect));
+	}
+
+	void TextDocumentAdapterTest::scaledTileMatchesPage ()
+	{
+		TestDocument doc;
+		const QRect rect { 128, 256, 128, 128 };
+		QCOMPARE (doc.RenderPageRect (0, 2, 2, rect),
+				doc.RenderPage (0, 2, 2).copy (rect));
+	}
+
+	void TextDocumentAdapterTest::tileOfNextPageMatchesPage ()
+	{
+		TestDocument doc;
+		QVERIFY (doc.GetNumPages () > 1);
+
+		const QRect rect { 0, 100, 200, 100 };
+		QCOMPARE (doc.RenderPageRect (1, 1, 1, rect),
+				doc.RenderPage (1, 1, 1).copy (rect));
+	}
+}
+}
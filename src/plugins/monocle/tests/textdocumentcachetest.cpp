@@ -0,0 +1,310 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "textdocumentcachetest.h"
+#include <QtTest>
+#include <QTemporaryFile>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QThreadPool>
+#include <interfaces/monocle/ilink.h>
+#include <util/monocle/documentcachedir.h>
+#include <util/monocle/textdocumentcache.h>
+
+QTEST_MAIN (LeechCraft::Monocle::TextDocumentCacheTest)
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	namespace
+	{
+		class TestLink : public ILink
+					   , public IPageLink
+		{
+			const int Page_;
+		public:
+			TestLink (int page)
+			: Page_ { page }
+			{
+			}
+
+			LinkType GetLinkType () const
+			{
+				return LinkType::PageLink;
+			}
+
+			QRectF GetArea () const
+			{
+				return {};
+			}
+
+			void Execute ()
+			{
+			}
+
+			QString GetDocumentFilename () const
+			{
+				return {};
+			}
+
+			int GetPageNumber () const
+			{
+				return Page_;
+			}
+
+			double NewX () const
+			{
+				return 0;
+			}
+
+			double NewY () const
+			{
+				return 0;
+			}
+
+			double NewZoom () const
+			{
+				return 0;
+			}
+		};
+
+		ILink_ptr MakeLink (int page)
+		{
+			return std::make_shared<TestLink> (page);
+		}
+
+		int GetPage (const TOCEntry& entry)
+		{
+			const auto pageLink = dynamic_cast<IPageLink*> (entry.Link_.get ());
+			return pageLink ? pageLink->GetPageNumber () : -1;
+		}
+
+		/* The document file with the contents unique to the current test
+		 * function, so that each test gets its own cache directory, which
+		 * is removed when the test finishes.
+		 */
+		class TestFile
+		{
+			QTemporaryFile File_;
+		public:
+			TestFile ()
+			{
+				File_.open ();
+				File_.write (QTest::currentTestFunction ());
+				File_.flush ();
+			}
+
+			~TestFile ()
+			{
+				QThreadPool::globalInstance ()->waitForDone ();
+
+				QDir dir;
+				if (!GetDocumentCacheDir (GetPath (), dir))
+					return;
+
+				for (const auto& name : dir.entryList (QDir::Files))
+					dir.remove (name);
+				const auto& key = dir.dirName ();
+				dir.cdUp ();
+				dir.rmdir (key);
+			}
+
+			QString GetPath () const
+			{
+				return File_.fileName ();
+			}
+		};
+
+		const QString Format = "test";
+
+		void SaveDocument (const QString& path, const QTextDocument& doc,
+				const DocumentInfo& info = DocumentInfo (), const TOCEntryLevel_t& toc = TOCEntryLevel_t ())
+		{
+			TextDocumentCache { path, Format }.Save (&doc, info, toc, "image");
+			QThreadPool::globalInstance ()->waitForDone ();
+		}
+
+		bool LoadDocument (const QString& path, QTextDocument& doc,
+				DocumentInfo& info, TOCEntryLevel_t& toc)
+		{
+			return TextDocumentCache { path, Format }.Load (&doc, info, toc, &MakeLink);
+		}
+
+		bool LoadDocument (const QString& path, QTextDocument& doc)
+		{
+			DocumentInfo info;
+			TOCEntryLevel_t toc;
+			return LoadDocument (path, doc, info, toc);
+		}
+	}
+
+	void TextDocumentCacheTest::noCache ()
+	{
+		TestFile file;
+
+		QTextDocument doc;
+		QVERIFY (!LoadDocument (file.GetPath (), doc));
+	}
+
+	void TextDocumentCacheTest::otherFormat ()
+	{
+		TestFile file;
+
+		QTextDocument doc;
+		doc.setHtml ("<p>Some text</p>");
+		SaveDocument (file.GetPath (), doc);
+
+		QTextDocument loaded;
+		DocumentInfo info;
+		TOCEntryLevel_t toc;
+		QVERIFY (!TextDocumentCache { file.GetPath (), "other" }.Load (&loaded, info, toc, &MakeLink));
+	}
+
+	void TextDocumentCacheTest::markup ()
+	{
+		TestFile file;
+
+		QTextDocument doc;
+		doc.setHtml ("<h1>Title</h1><p>Some <b>bold</b> and <i>italic</i> text.</p><p>Another paragraph.</p>");
+		SaveDocument (file.GetPath (), doc);
+
+		QTextDocument loaded;
+		QVERIFY (LoadDocument (file.GetPath (), loaded));
+		QCOMPARE (loaded.toPlainText (), doc.toPlainText ());
+		QCOMPARE (loaded.blockCount (), doc.blockCount ());
+
+		auto it = loaded.findBlockByNumber (1).begin ();
+		++it;
+		QCOMPARE (it.fragment ().text (), QString ("bold"));
+		QCOMPARE (it.fragment ().charFormat ().fontWeight (), static_cast<int> (QFont::Bold));
+	}
+
+	void TextDocumentCacheTest::defaultFont ()
+	{
+		TestFile file;
+
+		QTextDocument doc;
+		doc.setDefaultFont (QFont ("Serif", 14));
+		doc.setHtml ("<p>Some text</p>");
+		SaveDocument (file.GetPath (), doc);
+
+		QTextDocument loaded;
+		QVERIFY (LoadDocument (file.GetPath (), loaded));
+
+		const auto& format = loaded.begin ().begin ().fragment ().charFormat ();
+		QVERIFY (!format.hasProperty (QTextFormat::FontFamily));
+		QVERIFY (!format.hasProperty (QTextFormat::FontPointSize));
+	}
+
+	void TextDocumentCacheTest::info ()
+	{
+		TestFile file;
+
+		QTextDocument doc;
+		doc.setHtml ("<p>Some text</p>");
+
+		DocumentInfo info;
+		info.Title_ = "Title";
+		info.Subject_ = "Subject";
+		info.Description_ = "Description";
+		info.Author_ = "Author";
+		info.Genres_ << "genre1" << "genre2";
+		info.Keywords_ << "keyword";
+		info.Date_ = QDateTime (QDate (2014, 5, 1), QTime (12, 30));
+		SaveDocument (file.GetPath (), doc, info);
+
+		QTextDocument loaded;
+		DocumentInfo loadedInfo;
+		TOCEntryLevel_t toc;
+		QVERIFY (LoadDocument (file.GetPath (), loaded, loadedInfo, toc));
+		QCOMPARE (loadedInfo.Title_, info.Title_);
+		QCOMPARE (loadedInfo.Subject_, info.Subject_);
+		QCOMPARE (loadedInfo.Description_, info.Description_);
+		QCOMPARE (loadedInfo.Author_, info.Author_);
+		QCOMPARE (loadedInfo.Genres_, info.Genres_);
+		QCOMPARE (loadedInfo.Keywords_, info.Keywords_);
+		QCOMPARE (loadedInfo.Date_, info.Date_);
+	}
+
+	void TextDocumentCacheTest::toc ()
+	{
+		TestFile file;
+
+		QTextDocument doc;
+		doc.setHtml ("<p>Some text</p>");
+
+		TOCEntry child { MakeLink (5), "Child", {} };
+		TOCEntry noLink { {}, "No link", {} };
+		TOCEntry chapter { MakeLink (3), "Chapter", { child, noLink } };
+		TOCEntry appendix { MakeLink (7), "Appendix", {} };
+		SaveDocument (file.GetPath (), doc, {}, { chapter, appendix });
+
+		QTextDocument loaded;
+		DocumentInfo info;
+		TOCEntryLevel_t toc;
+		QVERIFY (LoadDocument (file.GetPath (), loaded, info, toc));
+
+		QCOMPARE (toc.size (), 2);
+		QCOMPARE (toc.at (0).Name_, QString ("Chapter"));
+		QCOMPARE (GetPage (toc.at (0)), 3);
+		QCOMPARE (toc.at (1).Name_, QString ("Appendix"));
+		QCOMPARE (GetPage (toc.at (1)), 7);
+		QVERIFY (toc.at (1).ChildLevel_.isEmpty ());
+
+		const auto& children = toc.at (0).ChildLevel_;
+		QCOMPARE (children.size (), 2);
+		QCOMPARE (children.at (0).Name_, QString ("Child"));
+		QCOMPARE (GetPage (children.at (0)), 5);
+		QCOMPARE (children.at (1).Name_, QString ("No link"));
+		QVERIFY (!children.at (1).Link_);
+	}
+
+	void TextDocumentCacheTest::images ()
+	{
+		TestFile file;
+
+		QImage image { 16, 8, QImage::Format_RGB32 };
+		image.fill (qRgb (0, 128, 255));
+
+		QTextDocument doc;
+		doc.addResource (QTextDocument::ImageResource, QUrl ("image://picture"), image);
+		doc.setHtml ("<p>Text <img src='image://picture'/> <img src='other://picture'/></p>");
+		SaveDocument (file.GetPath (), doc);
+
+		QTextDocument loaded;
+		QVERIFY (LoadDocument (file.GetPath (), loaded));
+
+		const auto& loadedImage = qvariant_cast<QImage> (loaded.resource (QTextDocument::ImageResource,
+				QUrl ("image://picture")));
+		QCOMPARE (loadedImage.convertToFormat (image.format ()), image);
+		QVERIFY (loaded.resource (QTextDocument::ImageResource, QUrl ("other://picture")).isNull ());
+	}
+}
+}
@@ -0,0 +1,106 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "textlayercachetest.h"
+#include <QtTest>
+#include "textlayercache.h"
+
+QTEST_MAIN (LeechCraft::Monocle::TextLayerCacheTest)
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	namespace
+	{
+		/* Two lines of text, each character being 10 units wide:
+		 *
+		 *   Hello world,
+		 *   hello Monocle
+		 */
+		PageText MakePage ()
+		{
+			const TextLayer_t layer
+			{
+				{ "Hello", { 0, 0, 50, 10 }, true },
+				{ "world,", { 60, 0, 60, 10 }, false },
+				{ "hello", { 0, 20, 50, 10 }, true },
+				{ "Monocle", { 60, 20, 70, 10 }, false }
+			};
+			return BuildPageText (layer);
+		}
+	}
+
+	void TextLayerCacheTest::singleWord ()
+	{
+		const auto& rects = FindInPageText (MakePage (), "world", Qt::CaseSensitive);
+		QCOMPARE (rects, (QList<QRectF> { { 60, 0, 50, 10 } }));
+	}
+
+	void TextLayerCacheTest::partialWord ()
+	{
+		const auto& rects = FindInPageText (MakePage (), "noc", Qt::CaseSensitive);
+		QCOMPARE (rects, (QList<QRectF> { { 80, 20, 30, 10 } }));
+	}
+
+	void TextLayerCacheTest::severalWords ()
+	{
+		const auto& rects = FindInPageText (MakePage (), "lo wor", Qt::CaseSensitive);
+		QCOMPARE (rects, (QList<QRectF> { { 30, 0, 60, 10 } }));
+	}
+
+	void TextLayerCacheTest::severalLines ()
+	{
+		const auto& rects = FindInPageText (MakePage (), "world, hello", Qt::CaseSensitive);
+		QCOMPARE (rects, (QList<QRectF> { { 60, 0, 60, 10 }, { 0, 20, 50, 10 } }));
+	}
+
+	void TextLayerCacheTest::caseSensitivity ()
+	{
+		const auto& page = MakePage ();
+		QCOMPARE (FindInPageText (page, "hello", Qt::CaseSensitive).size (), 1);
+		QCOMPARE (FindInPageText (page, "hello", Qt::CaseInsensitive).size (), 2);
+	}
+
+	void TextLayerCacheTest::noMatches ()
+	{
+		const auto& page = MakePage ();
+		QVERIFY (FindInPageText (page, "goodbye", Qt::CaseInsensitive).isEmpty ());
+		QVERIFY (FindInPageText (page, {}, Qt::CaseInsensitive).isEmpty ());
+		QVERIFY (FindInPageText ({}, "hello", Qt::CaseInsensitive).isEmpty ());
+	}
+
+	void TextLayerCacheTest::repeatedMatches ()
+	{
+		const TextLayer_t layer { { "aaaa", { 0, 0, 40, 10 }, false } };
+		const auto& rects = FindInPageText (BuildPageText (layer), "aa", Qt::CaseSensitive);
+		QCOMPARE (rects, (QList<QRectF> { { 0, 0, 20, 10 }, { 20, 0, 20, 10 } }));
+	}
+}
+}
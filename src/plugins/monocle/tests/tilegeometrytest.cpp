@@ -0,0 +1,88 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "tilegeometrytest.h"
+#include <QtTest>
+#include "tilegeometry.h"
+
+QTEST_MAIN (LeechCraft::Monocle::TileGeometryTest)
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	void TileGeometryTest::innerTileRect ()
+	{
+		QCOMPARE (GetTileRect (TileKey_t (1, 2), QSize (2000, 3000)), QRect (512, 1024, 512, 512));
+	}
+
+	void TileGeometryTest::edgeTileRect ()
+	{
+		QCOMPARE (GetTileRect (TileKey_t (3, 5), QSize (2000, 3000)), QRect (1536, 2560, 464, 440));
+	}
+
+	void TileGeometryTest::outerTileRect ()
+	{
+		QVERIFY (GetTileRect (TileKey_t (4, 0), QSize (2000, 3000)).isEmpty ());
+	}
+
+	void TileGeometryTest::noTilesInEmptyRect ()
+	{
+		QVERIFY (GetTilesInRect (QRect ()).isEmpty ());
+	}
+
+	void TileGeometryTest::singleTileInRect ()
+	{
+		QCOMPARE (GetTilesInRect (QRect (512, 512, 512, 512)), (QList<TileKey_t> { { 1, 1 } }));
+	}
+
+	void TileGeometryTest::tilesInRect ()
+	{
+		const QList<TileKey_t> expected
+		{
+			{ 0, 1 }, { 1, 1 }, { 2, 1 },
+			{ 0, 2 }, { 1, 2 }, { 2, 2 }
+		};
+		QCOMPARE (GetTilesInRect (QRect (500, 600, 600, 500)), expected);
+	}
+
+	void TileGeometryTest::noVisibleTilesInEmptyViewport ()
+	{
+		QCOMPARE (GetMaxVisibleTiles (QSize (0, 600)), 0);
+	}
+
+	void TileGeometryTest::maxVisibleTiles ()
+	{
+		// 1000 pixels touch at most 3 tiles of a page, and 4 at a page
+		// boundary; 500 pixels touch at most 2 and 3 respectively.
+		QCOMPARE (GetMaxVisibleTiles (QSize (1000, 500)), 12);
+		QCOMPARE (GetTilesInRect (QRect (500, 500, 1000, 500)).size (), 6);
+	}
+}
+}
@@ -0,0 +1,148 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "textlayercache.h"
+#include <algorithm>
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	namespace
+	{
+		bool IsSameLine (const QRectF& line, const QRectF& rect)
+		{
+			const auto center = rect.center ().y ();
+			return center >= line.top () && center <= line.bottom ();
+		}
+	}
+
+	PageText BuildPageText (const TextLayer_t& layer)
+	{
+		PageText result;
+		result.Boxes_.reserve (layer.size ());
+
+		for (int i = 0; i < layer.size (); ++i)
+		{
+			const auto& box = layer.at (i);
+			if (box.Text_.isEmpty ())
+				continue;
+
+			result.Boxes_.append ({ result.Text_.size (), box.Text_.size (), box.Rect_ });
+			result.Text_ += box.Text_;
+
+			const auto isLineEnd = i + 1 < layer.size () &&
+					!IsSameLine (box.Rect_, layer.at (i + 1).Rect_);
+			if (box.HasSpaceAfter_ || isLineEnd)
+				result.Text_ += ' ';
+		}
+
+		return result;
+	}
+
+	namespace
+	{
+		void AppendMatchRects (const PageText& page, int start, int end, QList<QRectF>& result)
+		{
+			const auto& boxes = page.Boxes_;
+			auto pos = std::upper_bound (boxes.begin (), boxes.end (), start,
+					[] (int offset, const PageText::Box& box) { return offset < box.Start_; });
+			if (pos != boxes.begin ())
+				--pos;
+
+			QRectF current;
+			bool hasCurrent = false;
+			for (; pos != boxes.end () && pos->Start_ < end; ++pos)
+			{
+				const auto from = std::max (start, pos->Start_) - pos->Start_;
+				const auto to = std::min (end, pos->Start_ + pos->Length_) - pos->Start_;
+				if (from >= to)
+					continue;
+
+				const auto& boxRect = pos->Rect_;
+				const auto charWidth = boxRect.width () / pos->Length_;
+				QRectF rect { boxRect };
+				rect.setLeft (boxRect.left () + charWidth * from);
+				rect.setRight (boxRect.left () + charWidth * to);
+
+				if (hasCurrent && IsSameLine (current, rect))
+					current |= rect;
+				else
+				{
+					if (hasCurrent)
+						result << current;
+					current = rect;
+					hasCurrent = true;
+				}
+			}
+
+			if (hasCurrent)
+				result << current;
+		}
+	}
+
+	QList<QRectF> FindInPageText (const PageText& page, const QString& text, Qt::CaseSensitivity cs)
+	{
+		QList<QRectF> result;
+		if (text.isEmpty ())
+			return result;
+
+		int pos = 0;
+		while ((pos = page.Text_.indexOf (text, pos, cs)) >= 0)
+		{
+			const auto end = pos + text.size ();
+			AppendMatchRects (page, pos, end, result);
+			pos = end;
+		}
+
+		return result;
+	}
+
+	TextLayerCache::TextLayerCache (const IDocument_ptr& doc, IHaveTextLayer *layer)
+	: Doc_ { doc }
+	, Layer_ { layer }
+	{
+	}
+
+	std::shared_ptr<const PageText> TextLayerCache::GetPageText (int page)
+	{
+		{
+			QMutexLocker locker { &PagesMutex_ };
+			if (const auto text = Pages_.value (page))
+				return text;
+		}
+
+		const std::shared_ptr<const PageText> text = std::make_shared<PageText> (BuildPageText (Layer_->GetTextLayer (page)));
+
+		QMutexLocker locker { &PagesMutex_ };
+		Pages_ [page] = text;
+		return text;
+	}
+}
+}
@@ -0,0 +1,87 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <QRectF>
+#include "interfaces/monocle/idocument.h"
+#include "interfaces/monocle/ihavetextlayer.h"
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	/** The text of a page joined into a single string, with each word
+	 * remembering its span in the string and its rectangle on the page.
+	 */
+	struct PageText
+	{
+		struct Box
+		{
+			int Start_;
+			int Length_;
+			QRectF Rect_;
+		};
+
+		QString Text_;
+		QVector<Box> Boxes_;
+	};
+
+	PageText BuildPageText (const TextLayer_t&);
+
+	/** Returns the rectangles covering each occurrence of the text,
+	 * one rectangle per line spanned by the occurrence.
+	 */
+	QList<QRectF> FindInPageText (const PageText&, const QString&, Qt::CaseSensitivity);
+
+	/** Thread-safe lazily filled per-page text cache of a document.
+	 *
+	 * The cache keeps the document alive, so that the background
+	 * searches may safely outlive the document tab.
+	 */
+	class TextLayerCache
+	{
+		const IDocument_ptr Doc_;
+		IHaveTextLayer * const Layer_;
+
+		QMutex PagesMutex_;
+		QHash<int, std::shared_ptr<const PageText>> Pages_;
+	public:
+		TextLayerCache (const IDocument_ptr&, IHaveTextLayer*);
+
+		std::shared_ptr<const PageText> GetPageText (int page);
+	};
+
+	typedef std::shared_ptr<TextLayerCache> TextLayerCache_ptr;
+}
+}
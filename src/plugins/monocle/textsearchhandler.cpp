@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "textsearchhandler.h"
+#include <algorithm>
 #include <QGraphicsView>
 #include <QGraphicsRectItem>
 #include <QtDebug>
@@ -35,6 +36,7 @@
 #include "interfaces/monocle/isearchabledocument.h"
 #include "pagegraphicsitem.h"
 #include "pageslayoutmanager.h"
+#include "asynctextsearch.h"
 
 namespace LeechCraft
 {
@@ -51,12 +53,21 @@ namespace Monocle
 
 	void TextSearchHandler::HandleDoc (IDocument_ptr doc, const QList<PageGraphicsItem*>& pages)
 	{
+		CancelSearch ();
+
 		Doc_ = doc;
 		Pages_ = pages;
 
+		const auto layer = doc ? qobject_cast<IHaveTextLayer*> (doc->GetQObject ()) : nullptr;
+		if (layer)
+			TextLayerCache_ = std::make_shared<TextLayerCache> (doc, layer);
+		else
+			TextLayerCache_.reset ();
+
 		CurrentHighlights_.clear ();
 		CurrentRectIndex_ = -1;
 		CurrentSearchString_.clear ();
+		CurrentResults_.clear ();
 	}
 
 	bool TextSearchHandler::Search (const QString& text, Util::FindNotification::FindFlags flags)
@@ -68,7 +79,7 @@ namespace Monocle
 			return RequestSearch (text, flags);
 
 		if (CurrentHighlights_.isEmpty ())
-			return false;
+			return CurrentSearch_ != nullptr;
 
 		if (flags & Util::FindNotification::FindBackwards)
 		{
@@ -102,8 +113,11 @@ namespace Monocle
 	{
 		if (CurrentSearchString_ != results.Text_)
 		{
+			CancelSearch ();
 			ClearHighlights ();
 			CurrentSearchString_ = results.Text_;
+			CurrentSearchFlags_ = results.FindFlags_;
+			CurrentResults_ = results.Positions_;
 			BuildHighlights (results.Positions_);
 		}
 
@@ -112,17 +126,29 @@ namespace Monocle
 
 	bool TextSearchHandler::RequestSearch (const QString& text, Util::FindNotification::FindFlags flags)
 	{
+		CancelSearch ();
 		ClearHighlights ();
+		CurrentRectIndex_ = -1;
 		CurrentSearchString_ = text;
+		CurrentSearchFlags_ = flags;
+		CurrentResults_.clear ();
+
+		const auto cs = flags & Util::FindNotification::FindCaseSensitively ?
+				Qt::CaseSensitive :
+				Qt::CaseInsensitive;
+
+		if (TextLayerCache_)
+		{
+			StartAsyncSearch (text, cs);
+			return true;
+		}
 
 		const auto searchable = qobject_cast<ISearchableDocument*> (Doc_->GetQObject ());
 		if (!searchable)
 			return false;
 
-		const auto cs = flags & Util::FindNotification::FindCaseSensitively ?
-				Qt::CaseSensitive :
-				Qt::CaseInsensitive;
 		const auto& map = searchable->GetTextPositions (text, cs);
+		CurrentResults_ = map;
 		emit gotSearchResults ({ text, flags, map });
 
 		BuildHighlights (map);
@@ -133,23 +159,55 @@ namespace Monocle
 		return !CurrentHighlights_.isEmpty ();
 	}
 
+	void TextSearchHandler::StartAsyncSearch (const QString& text, Qt::CaseSensitivity cs)
+	{
+		const auto numPages = Doc_->GetNumPages ();
+		const auto startPage = std::max (LayoutMgr_->GetCurrentPage (), 0);
+
+		QList<int> pages;
+		pages.reserve (numPages);
+		for (int i = 0; i < numPages; ++i)
+			pages << (startPage + i) % numPages;
+
+		CurrentSearch_ = new AsyncTextSearch { TextLayerCache_, text, cs, pages, this };
+		connect (CurrentSearch_,
+				SIGNAL (gotPageResults (int, QList<QRectF>)),
+				this,
+				SLOT (handlePageResults (int, QList<QRectF>)));
+		connect (CurrentSearch_,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleSearchFinished ()));
+	}
+
+	void TextSearchHandler::CancelSearch ()
+	{
+		if (!CurrentSearch_)
+			return;
+
+		CurrentSearch_->Cancel ();
+		CurrentSearch_ = nullptr;
+	}
+
+	QGraphicsRectItem* TextSearchHandler::MakeHighlight (PageGraphicsItem *page, const QRectF& rect)
+	{
+		const auto item = new QGraphicsRectItem (page);
+		item->setBrush (QBrush { Qt::yellow });
+		item->setZValue (1);
+		item->setOpacity (0.2);
+
+		page->RegisterChildRect (item, rect,
+				[item] (const QRectF& rect) { item->setRect (rect); });
+		return item;
+	}
+
 	void TextSearchHandler::BuildHighlights (const QMap<int, QList<QRectF>>& map)
 	{
-		const QBrush brush (Qt::yellow);
 		for (const auto& pair : Util::Stlize (map))
 		{
 			const auto page = Pages_.at (pair.first);
 			for (const auto& rect : pair.second)
-			{
-				const auto item = new QGraphicsRectItem (page);
-				item->setBrush (brush);
-				item->setZValue (1);
-				item->setOpacity (0.2);
-				CurrentHighlights_ << item;
-
-				page->RegisterChildRect (item, rect,
-						[item] (const QRectF& rect) { item->setRect (rect); });
-			}
+				CurrentHighlights_ << MakeHighlight (page, rect);
 		}
 	}
 
@@ -190,5 +248,34 @@ namespace Monocle
 			emit navigateRequested ({}, pageIdx, x, y);
 		}
 	}
+	void TextSearchHandler::handlePageResults (int pageIdx, const QList<QRectF>& rects)
+	{
+		// Pages arrive starting from the current one and wrapping around,
+		// while the highlights are kept ordered by page for navigation
+		// and for the indices used by SetPreparedResults().
+		int insertPos = 0;
+		for (auto it = CurrentResults_.begin (), end = CurrentResults_.lowerBound (pageIdx); it != end; ++it)
+			insertPos += it->size ();
+
+		CurrentResults_ [pageIdx] = rects;
+
+		const auto page = Pages_.at (pageIdx);
+		for (int i = 0; i < rects.size (); ++i)
+			CurrentHighlights_.insert (insertPos + i, MakeHighlight (page, rects.at (i)));
+
+		if (CurrentRectIndex_ < 0)
+			SelectItem (insertPos);
+		else if (CurrentRectIndex_ >= insertPos)
+			CurrentRectIndex_ += rects.size ();
+	}
+
+	void TextSearchHandler::handleSearchFinished ()
+	{
+		CurrentSearch_->deleteLater ();
+		CurrentSearch_ = nullptr;
+
+		emit gotSearchResults ({ CurrentSearchString_, CurrentSearchFlags_, CurrentResults_ });
+		emit searchFinished (!CurrentHighlights_.isEmpty ());
+	}
 }
 }
@@ -33,6 +33,7 @@
 #include <QMap>
 #include <util/gui/findnotification.h>
 #include "interfaces/monocle/idocument.h"
+#include "textlayercache.h"
 
 class QGraphicsRectItem;
 class QGraphicsView;
@@ -44,6 +45,7 @@ namespace Monocle
 {
 	class PageGraphicsItem;
 	class PagesLayoutManager;
+	class AsyncTextSearch;
 
 	struct TextSearchHandlerResults
 	{
@@ -63,7 +65,12 @@ namespace Monocle
 		IDocument_ptr Doc_;
 		QList<PageGraphicsItem*> Pages_;
 
+		TextLayerCache_ptr TextLayerCache_;
+		AsyncTextSearch *CurrentSearch_ = nullptr;
+
 		QString CurrentSearchString_;
+		Util::FindNotification::FindFlags CurrentSearchFlags_;
+		QMap<int, QList<QRectF>> CurrentResults_;
 
 		QList<QGraphicsRectItem*> CurrentHighlights_;
 		int CurrentRectIndex_;
@@ -76,15 +83,26 @@ namespace Monocle
 		void SetPreparedResults (const TextSearchHandlerResults&, int selectedItem);
 	private:
 		bool RequestSearch (const QString&, Util::FindNotification::FindFlags);
+		void StartAsyncSearch (const QString&, Qt::CaseSensitivity);
+		void CancelSearch ();
 
+		QGraphicsRectItem* MakeHighlight (PageGraphicsItem*, const QRectF&);
 		void BuildHighlights (const QMap<int, QList<QRectF>>&);
 		void ClearHighlights ();
 
 		void SelectItem (int);
+	private slots:
+		void handlePageResults (int, const QList<QRectF>&);
+		void handleSearchFinished ();
 	signals:
 		void navigateRequested (const QString&, int, double, double);
 
 		void gotSearchResults (const TextSearchHandlerResults&);
+
+		/** Emitted when a background search started by Search() has
+		 * processed all the pages.
+		 */
+		void searchFinished (bool found);
 	};
 }
 }
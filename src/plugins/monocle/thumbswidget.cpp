@@ -54,7 +54,7 @@ namespace Monocle
 				SLOT (handleRelayouted ()));
 	}
 
-	void ThumbsWidget::HandleDoc (IDocument_ptr doc)
+	void ThumbsWidget::HandleDoc (IDocument_ptr doc, const DocumentCache_ptr& cache)
 	{
 		Scene_.clear ();
 		CurrentAreaRects_.clear ();
@@ -64,9 +64,10 @@ namespace Monocle
 			return;
 
 		QList<PageGraphicsItem*> pages;
-		for (int i = 0, size = CurrentDoc_->GetNumPages (); i < size; ++i)
+		for (int i = 0, size = cache->GetNumPages (); i < size; ++i)
 		{
-			auto item = new PageGraphicsItem (CurrentDoc_, i);
+			auto item = new PageGraphicsItem (CurrentDoc_, i, cache->GetPageSize (i));
+			item->SetRenderCache (cache);
 			Scene_.addItem (item);
 			item->SetReleaseHandler ([this] (int page, const QPointF&) { emit pageClicked (page); });
 			pages << item;
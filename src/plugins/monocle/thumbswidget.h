@@ -31,6 +31,7 @@
 
 #include <QWidget>
 #include "interfaces/monocle/idocument.h"
+#include "documentcache.h"
 #include "ui_thumbswidget.h"
 
 namespace LeechCraft
@@ -55,7 +56,7 @@ namespace Monocle
 	public:
 		ThumbsWidget (QWidget* = 0);
 
-		void HandleDoc (IDocument_ptr);
+		void HandleDoc (IDocument_ptr, const DocumentCache_ptr&);
 	public slots:
 		void updatePagesVisibility (const QMap<int, QRect>&);
 		void handleCurrentPage (int);
@@ -0,0 +1,72 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "tilegeometry.h"
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	QRect GetTileRect (const TileKey_t& key, const QSize& scaledPageSize)
+	{
+		const QRect rect { key.first * TileSide, key.second * TileSide, TileSide, TileSide };
+		return rect & QRect { {}, scaledPageSize };
+	}
+
+	QList<TileKey_t> GetTilesInRect (const QRect& rect)
+	{
+		QList<TileKey_t> result;
+		if (rect.isEmpty ())
+			return result;
+
+		for (auto row = rect.top () / TileSide; row <= rect.bottom () / TileSide; ++row)
+			for (auto col = rect.left () / TileSide; col <= rect.right () / TileSide; ++col)
+				result.append ({ col, row });
+		return result;
+	}
+
+	namespace
+	{
+		int GetMaxTilesOnSpan (int span)
+		{
+			if (span <= 0)
+				return 0;
+
+			// A span not aligned to the tiles touches one more of them,
+			// and crossing the page boundary starts the next page's tiles.
+			return (span + TileSide - 2) / TileSide + 2;
+		}
+	}
+
+	int GetMaxVisibleTiles (const QSize& viewport)
+	{
+		return GetMaxTilesOnSpan (viewport.width ()) * GetMaxTilesOnSpan (viewport.height ());
+	}
+}
+}
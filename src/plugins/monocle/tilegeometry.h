@@ -0,0 +1,63 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QPair>
+#include <QList>
+#include <QRect>
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	/** The column and the row of a tile of a page.
+	 */
+	typedef QPair<int, int> TileKey_t;
+
+	const int TileSide = 512;
+
+	/** Returns the rectangle covered by the tile in the coordinates of
+	 * the scaled page of the given size.
+	 */
+	QRect GetTileRect (const TileKey_t&, const QSize& scaledPageSize);
+
+	/** Returns the keys of the tiles intersecting the given rectangle of
+	 * a scaled page.
+	 */
+	QList<TileKey_t> GetTilesInRect (const QRect&);
+
+	/** Returns an upper bound of the number of tiles visible in a
+	 * viewport of the given size. The viewport is assumed to be smaller
+	 * than a page, so that it crosses at most one page boundary along
+	 * each axis.
+	 */
+	int GetMaxVisibleTiles (const QSize& viewport);
+}
+}
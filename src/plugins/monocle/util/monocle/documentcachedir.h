@@ -0,0 +1,66 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QDir>
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	/** @brief Returns the root directory of the per-document caches.
+	 *
+	 * Each document has its own subdirectory under this root, and both
+	 * Monocle itself and the format backends may store their data
+	 * there. The whole subdirectory is removed when Monocle decides to
+	 * drop the cache of the document, so the files in it should be
+	 * plain files with names not clashing with each other.
+	 *
+	 * @return The root of the per-document caches.
+	 * @exception std::runtime_error If the directory can't be created.
+	 *
+	 * @sa GetDocumentCacheDir()
+	 */
+	QDir GetDocumentCacheRoot ();
+
+	/** @brief Returns the cache directory of the document at \em path.
+	 *
+	 * The directory is keyed by the hash of the size, modification time
+	 * and the beginning of the contents of the document, so it survives
+	 * renaming the file and is not used anymore if the file changes.
+	 * The directory is created if it doesn't exist yet.
+	 *
+	 * @param[in] path The path to the document file.
+	 * @param[out] dir The cache directory of the document.
+	 * @return Whether the cache directory is available.
+	 */
+	bool GetDocumentCacheDir (const QString& path, QDir& dir);
+}
+}
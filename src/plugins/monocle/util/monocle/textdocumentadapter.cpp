@@ -85,6 +85,33 @@ namespace Monocle
 		return image;
 	}
 
+	QImage TextDocumentAdapter::RenderPageRect (int page, double xScale, double yScale, const QRect& rect)
+	{
+		QImage image (rect.size (), QImage::Format_ARGB32);
+		image.fill (Qt::white);
+
+		const auto& size = Doc_->pageSize ();
+		const QRectF pageRect { 0, size.height () * page, size.width (), size.height () };
+		const QRectF docRect
+		{
+			rect.x () / xScale,
+			pageRect.top () + rect.y () / yScale,
+			rect.width () / xScale,
+			rect.height () / yScale
+		};
+
+		QPainter painter;
+		painter.begin (&image);
+		painter.setRenderHints (Hints_);
+		painter.translate (-rect.x (), -rect.y ());
+		painter.scale (xScale, yScale);
+		painter.translate (0, -pageRect.top ());
+		Doc_->drawContents (&painter, docRect & pageRect);
+		painter.end ();
+
+		return image;
+	}
+
 	QList<ILink_ptr> TextDocumentAdapter::GetPageLinks (int)
 	{
 		return QList<ILink_ptr> ();
@@ -34,6 +34,7 @@
 #include <interfaces/monocle/idocument.h>
 #include <interfaces/monocle/isupportpainting.h>
 #include <interfaces/monocle/isearchabledocument.h>
+#include <interfaces/monocle/isupporttiledrendering.h>
 
 class QTextDocument;
 
@@ -44,8 +45,9 @@ namespace Monocle
 	/** @brief Provides an adapter of QTextDocument to Monocle's IDocument.
 	 *
 	 * This class provides implementations for most of the IDocument's
-	 * methods, as well as methods of ISupportPainting and
-	 * ISearchableDocument, working over a QTextDocument.
+	 * methods, as well as methods of ISupportPainting,
+	 * ISearchableDocument and ISupportTiledRendering, working over a
+	 * QTextDocument.
 	 *
 	 * The document for this class to work on is passed either via the
 	 * constructor or by calling the SetDocument() method. The adapter
@@ -54,6 +56,7 @@ namespace Monocle
 	class TextDocumentAdapter : public IDocument
 							  , public ISupportPainting
 							  , public ISearchableDocument
+							  , public ISupportTiledRendering
 	{
 	protected:
 		/** @brief The adapted QTextDocument.
@@ -110,6 +113,26 @@ namespace Monocle
 		 */
 		QImage RenderPage (int page, double xScale, double yScale);
 
+		/** @brief Renders the given \em rect of the given \em page.
+		 *
+		 * Only the blocks of the document intersecting the \em rect
+		 * are painted. The hints set via SetRenderHint() are used during
+		 * rendering.
+		 *
+		 * @note If IsValid() returns false, the behavior is undefined.
+		 *
+		 * @param[in] page The index of the page to render.
+		 * @param[in] xScale The scale in the X dimension.
+		 * @param[in] yScale The scale in the Y dimension.
+		 * @param[in] rect The rectangle of the scaled page to render.
+		 *
+		 * @return The rendered image of the \em rect, of the same size
+		 * as \em rect.
+		 *
+		 * @sa RenderPage(), SetRenderHint()
+		 */
+		QImage RenderPageRect (int page, double xScale, double yScale, const QRect& rect);
+
 		/** @brief Returns the links found on the given \em page.
 		 *
 		 * The implementation currently always returns an empty list.
@@ -0,0 +1,270 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "textdocumentcache.h"
+#include <QDataStream>
+#include <QFile>
+#include <QImage>
+#include <QRegExp>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QUrl>
+#include <QtConcurrentRun>
+#include <QtDebug>
+#include <interfaces/monocle/ilink.h>
+#include "documentcachedir.h"
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	namespace
+	{
+		const quint8 MetaVersion = 1;
+
+		const QString MetaFileName = "meta";
+		const QString MarkupFileName = "markup.html";
+
+		QString GetImageFileName (int index)
+		{
+			return QString { "image_%1.png" }.arg (index);
+		}
+
+		void WriteTOC (QDataStream& out, const TOCEntryLevel_t& level)
+		{
+			out << static_cast<quint32> (level.size ());
+			for (const auto& entry : level)
+			{
+				const auto pageLink = dynamic_cast<IPageLink*> (entry.Link_.get ());
+				out << entry.Name_
+						<< static_cast<qint32> (pageLink ? pageLink->GetPageNumber () : -1);
+				WriteTOC (out, entry.ChildLevel_);
+			}
+		}
+
+		TOCEntryLevel_t ReadTOC (QDataStream& in, const TextDocumentCache::PageLinkMaker_f& linkMaker)
+		{
+			quint32 size = 0;
+			in >> size;
+
+			TOCEntryLevel_t level;
+			for (quint32 i = 0; i < size && in.status () == QDataStream::Ok; ++i)
+			{
+				TOCEntry entry;
+				qint32 page = -1;
+				in >> entry.Name_
+						>> page;
+				if (page >= 0)
+					entry.Link_ = linkMaker (page);
+				entry.ChildLevel_ = ReadTOC (in, linkMaker);
+				level << entry;
+			}
+			return level;
+		}
+
+		QStringList GetImageNames (const QTextDocument *doc, const QString& scheme)
+		{
+			QStringList result;
+			for (auto block = doc->begin (); block != doc->end (); block = block.next ())
+				for (auto it = block.begin (); !it.atEnd (); ++it)
+				{
+					const auto& format = it.fragment ().charFormat ();
+					if (!format.isImageFormat ())
+						continue;
+
+					const auto& name = format.toImageFormat ().name ();
+					if (QUrl { name }.scheme () == scheme && !result.contains (name))
+						result << name;
+				}
+			return result;
+		}
+
+		bool WriteFile (const QString& filename, const QByteArray& data)
+		{
+			QFile file { filename };
+			if (!file.open (QIODevice::WriteOnly) ||
+					file.write (data) != data.size ())
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to write"
+						<< filename
+						<< file.errorString ();
+				return false;
+			}
+			return true;
+		}
+	}
+
+	TextDocumentCache::TextDocumentCache (const QString& path, const QString& format)
+	: Prefix_ { "text_" + format + "_" }
+	{
+		IsValid_ = GetDocumentCacheDir (path, Dir_);
+	}
+
+	bool TextDocumentCache::Load (QTextDocument *doc, DocumentInfo& info,
+			TOCEntryLevel_t& toc, const PageLinkMaker_f& linkMaker) const
+	{
+		if (!IsValid_)
+			return false;
+
+		QFile metaFile { Dir_.filePath (Prefix_ + MetaFileName) };
+		if (!metaFile.open (QIODevice::ReadOnly))
+			return false;
+
+		QDataStream in { &metaFile };
+
+		quint8 version = 0;
+		in >> version;
+		if (version != MetaVersion)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown version"
+					<< version;
+			return false;
+		}
+
+		DocumentInfo cachedInfo;
+		QStringList imageNames;
+		in >> cachedInfo.Title_
+				>> cachedInfo.Subject_
+				>> cachedInfo.Description_
+				>> cachedInfo.Author_
+				>> cachedInfo.Genres_
+				>> cachedInfo.Keywords_
+				>> cachedInfo.Date_
+				>> imageNames;
+		const auto& cachedTOC = ReadTOC (in, linkMaker);
+		if (in.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "corrupted metadata in"
+					<< metaFile.fileName ();
+			return false;
+		}
+
+		QFile markupFile { Dir_.filePath (Prefix_ + MarkupFileName) };
+		if (!markupFile.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< markupFile.fileName ()
+					<< markupFile.errorString ();
+			return false;
+		}
+
+		QList<QImage> images;
+		for (int i = 0; i < imageNames.size (); ++i)
+		{
+			const QImage image { Dir_.filePath (Prefix_ + GetImageFileName (i)) };
+			if (image.isNull ())
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to load cached image"
+						<< imageNames.at (i);
+				return false;
+			}
+			images << image;
+		}
+
+		for (int i = 0; i < images.size (); ++i)
+			doc->addResource (QTextDocument::ImageResource, QUrl { imageNames.at (i) }, images.at (i));
+		doc->setHtml (QString::fromUtf8 (markupFile.readAll ()));
+
+		info = cachedInfo;
+		toc = cachedTOC;
+		return true;
+	}
+
+	void TextDocumentCache::Save (const QTextDocument *doc, const DocumentInfo& info,
+			const TOCEntryLevel_t& toc, const QString& imagesScheme) const
+	{
+		if (!IsValid_)
+			return;
+
+		QStringList imageNames;
+		QList<QImage> images;
+		if (!imagesScheme.isEmpty ())
+			for (const auto& name : GetImageNames (doc, imagesScheme))
+			{
+				const auto& image = qvariant_cast<QImage> (doc->resource (QTextDocument::ImageResource, QUrl { name }));
+				if (image.isNull ())
+					continue;
+
+				imageNames << name;
+				images << image;
+			}
+
+		QByteArray meta;
+		{
+			QDataStream out { &meta, QIODevice::WriteOnly };
+			out << MetaVersion
+					<< info.Title_
+					<< info.Subject_
+					<< info.Description_
+					<< info.Author_
+					<< info.Genres_
+					<< info.Keywords_
+					<< info.Date_
+					<< imageNames;
+			WriteTOC (out, toc);
+		}
+
+		// The default font of the document is exported as the style of
+		// the body, and it would become an explicit font of all the text
+		// when loading, so drop it to let the backend set the font.
+		auto html = doc->toHtml ("utf-8");
+		html.replace (QRegExp { "<body style=\"[^\"]*\"" }, "<body");
+		const auto& markup = html.toUtf8 ();
+
+		const auto dir = Dir_;
+		const auto prefix = Prefix_;
+		QtConcurrent::run ([dir, prefix, meta, markup, images]
+				{
+					// The metadata is written last, so a partially written
+					// cache is never picked up by Load().
+					QFile::remove (dir.filePath (prefix + MetaFileName));
+
+					for (int i = 0; i < images.size (); ++i)
+					{
+						const auto& filename = dir.filePath (prefix + GetImageFileName (i));
+						if (!images.at (i).save (filename, "PNG"))
+						{
+							qWarning () << Q_FUNC_INFO
+									<< "unable to save"
+									<< filename;
+							return;
+						}
+					}
+
+					if (WriteFile (dir.filePath (prefix + MarkupFileName), markup))
+						WriteFile (dir.filePath (prefix + MetaFileName), meta);
+				});
+	}
+}
+}
@@ -0,0 +1,118 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QDir>
+#include <interfaces/monocle/idocument.h>
+#include <interfaces/monocle/ihavetoc.h>
+
+class QTextDocument;
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	/** @brief On-disk cache of the documents converted to QTextDocument.
+	 *
+	 * Backends that convert their documents to a QTextDocument (for
+	 * example, to use it with TextDocumentAdapter) may use this class to
+	 * avoid parsing and converting the source document each time it is
+	 * opened. The cache stores the markup of the converted document,
+	 * its embedded images, the document metadata and the table of
+	 * contents.
+	 *
+	 * The cache lives in the per-document cache directory returned by
+	 * GetDocumentCacheDir(), so it is dropped together with the rest of
+	 * the cached data of the document.
+	 *
+	 * @sa GetDocumentCacheDir()
+	 */
+	class TextDocumentCache
+	{
+		QDir Dir_;
+		bool IsValid_ = false;
+
+		const QString Prefix_;
+	public:
+		/** @brief Creates a link to the given page of the document.
+		 *
+		 * This function is used to restore the links of the table of
+		 * contents when loading the document from the cache.
+		 */
+		typedef std::function<ILink_ptr (int)> PageLinkMaker_f;
+
+		/** @brief Constructs the cache for the document at \em path.
+		 *
+		 * The \em format string identifies the conversion used by the
+		 * backend. It should be changed whenever the backend changes the
+		 * way it converts the documents, so that the stale caches are
+		 * not used anymore.
+		 *
+		 * @param[in] path The path to the source document.
+		 * @param[in] format The identifier of the conversion.
+		 */
+		TextDocumentCache (const QString& path, const QString& format);
+
+		/** @brief Loads the cached document.
+		 *
+		 * The links in the restored table of contents are created by
+		 * \em linkMaker. Only the links implementing IPageLink are
+		 * preserved by Save(), other links are restored as null.
+		 *
+		 * @param[in] doc The document to fill with the cached markup.
+		 * @param[out] info The cached document metadata.
+		 * @param[out] toc The cached table of contents.
+		 * @param[in] linkMaker The function creating the page links.
+		 * @return Whether the document has been loaded from the cache.
+		 */
+		bool Load (QTextDocument *doc, DocumentInfo& info,
+				TOCEntryLevel_t& toc, const PageLinkMaker_f& linkMaker) const;
+
+		/** @brief Saves the document to the cache.
+		 *
+		 * The data is collected from the \em doc in the calling thread
+		 * and is written to the disk asynchronously.
+		 *
+		 * The images referenced by the document are stored as well if
+		 * the scheme of their names is \em imagesScheme. Images with
+		 * other schemes are expected to be loaded by the document from
+		 * the source file on demand.
+		 *
+		 * @param[in] doc The converted document.
+		 * @param[in] info The document metadata.
+		 * @param[in] toc The table of contents.
+		 * @param[in] imagesScheme The scheme of the embedded images.
+		 */
+		void Save (const QTextDocument *doc, const DocumentInfo& info,
+				const TOCEntryLevel_t& toc, const QString& imagesScheme = QString ()) const;
+	};
+}
+}
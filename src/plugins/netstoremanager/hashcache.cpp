@@ -0,0 +1,201 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "hashcache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QtDebug>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	namespace
+	{
+		const quint8 FormatVersion = 1;
+
+		quint64 GetInode (const QFileInfo& fi)
+		{
+#ifdef Q_OS_UNIX
+			struct stat st;
+			if (!stat (QFile::encodeName (fi.absoluteFilePath ()).constData (), &st))
+				return st.st_ino;
+#else
+			Q_UNUSED (fi)
+#endif
+			return 0;
+		}
+	}
+
+	HashCache::HashCache (const QString& filename)
+	: Filename_ (filename)
+	{
+		Load ();
+	}
+
+	QByteArray HashCache::Get (const QFileInfo& fi, HashAlgorithm algo) const
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		const auto pos = Entries_.find (fi.absoluteFilePath ());
+		if (pos == Entries_.end ())
+			return {};
+
+		if (pos->Size_ != fi.size () ||
+				pos->MTime_ != fi.lastModified ().toMSecsSinceEpoch () ||
+				pos->Inode_ != GetInode (fi))
+			return {};
+
+		return pos->Hashes_.value (static_cast<quint8> (algo));
+	}
+
+	void HashCache::Put (const QFileInfo& fi, HashAlgorithm algo, const QByteArray& hash)
+	{
+		const auto size = fi.size ();
+		const auto mtime = fi.lastModified ().toMSecsSinceEpoch ();
+		const auto inode = GetInode (fi);
+
+		QMutexLocker locker { &Mutex_ };
+
+		const auto& path = fi.absoluteFilePath ();
+		auto pos = Entries_.find (path);
+		if (pos == Entries_.end () ||
+				pos->Size_ != size || pos->MTime_ != mtime || pos->Inode_ != inode)
+			pos = Entries_.insert (path, { size, mtime, inode, {} });
+		pos->Hashes_ [static_cast<quint8> (algo)] = hash;
+
+		Dirty_ = true;
+	}
+
+	void HashCache::Retain (const QString& root, const QSet<QString>& alive)
+	{
+		const auto& prefix = root.endsWith ('/') ? root : root + '/';
+
+		QMutexLocker locker { &Mutex_ };
+		for (auto i = Entries_.begin (); i != Entries_.end (); )
+			if (i.key ().startsWith (prefix) && !alive.contains (i.key ()))
+			{
+				i = Entries_.erase (i);
+				Dirty_ = true;
+			}
+			else
+				++i;
+	}
+
+	void HashCache::Save ()
+	{
+		QMutexLocker locker { &Mutex_ };
+		if (!Dirty_ || Filename_.isEmpty ())
+			return;
+
+		QFile file { Filename_ };
+		if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Filename_
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream out { &file };
+		out << FormatVersion
+				<< static_cast<quint32> (Entries_.size ());
+		for (auto i = Entries_.begin (); i != Entries_.end (); ++i)
+			out << i.key ()
+					<< i->Size_
+					<< i->MTime_
+					<< i->Inode_
+					<< i->Hashes_;
+
+		Dirty_ = false;
+	}
+
+	void HashCache::Load ()
+	{
+		if (Filename_.isEmpty ())
+			return;
+
+		QFile file { Filename_ };
+		if (!file.exists ())
+			return;
+
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Filename_
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream in { &file };
+
+		quint8 version = 0;
+		in >> version;
+		if (version != FormatVersion)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown version"
+					<< version;
+			return;
+		}
+
+		quint32 count = 0;
+		in >> count;
+		for (quint32 i = 0; i < count && in.status () == QDataStream::Ok; ++i)
+		{
+			QString path;
+			Entry entry;
+			in >> path
+					>> entry.Size_
+					>> entry.MTime_
+					>> entry.Inode_
+					>> entry.Hashes_;
+			if (in.status () == QDataStream::Ok)
+				Entries_ [path] = entry;
+		}
+
+		if (in.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "corrupted cache"
+					<< Filename_;
+			Entries_.clear ();
+		}
+	}
+}
+}
@@ -0,0 +1,92 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include "interfaces/netstoremanager/isupportfilelistings.h"
+
+class QFileInfo;
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	/** Persistent cache of the hashes of local files.
+	 *
+	 * A cached hash is valid as long as the size, the modification time
+	 * and the inode of the file are the same as when it was hashed. An
+	 * empty file name makes the cache memory-only. The class is
+	 * thread-safe.
+	 */
+	class HashCache
+	{
+		const QString Filename_;
+
+		struct Entry
+		{
+			qint64 Size_;
+			qint64 MTime_;
+			quint64 Inode_;
+			QMap<quint8, QByteArray> Hashes_;
+		};
+
+		mutable QMutex Mutex_;
+		QHash<QString, Entry> Entries_;
+		bool Dirty_ = false;
+	public:
+		HashCache (const QString& filename);
+
+		HashCache (const HashCache&) = delete;
+		HashCache& operator= (const HashCache&) = delete;
+
+		/** Returns the cached hash of the file, or a null byte array if
+		 * the file is not cached or has changed since.
+		 */
+		QByteArray Get (const QFileInfo&, HashAlgorithm) const;
+		void Put (const QFileInfo&, HashAlgorithm, const QByteArray&);
+
+		/** Forgets the files in the \em root directory and its
+		 * subdirectories that are not in \em alive.
+		 */
+		void Retain (const QString& root, const QSet<QString>& alive);
+
+		void Save ();
+	private:
+		void Load ();
+	};
+
+	typedef std::shared_ptr<HashCache> HashCache_ptr;
+}
+}
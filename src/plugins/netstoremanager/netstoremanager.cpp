@@ -67,6 +67,8 @@ namespace NetStoreManager
 		qRegisterMetaTypeStreamOperators<Change> ("Change");
 		qRegisterMetaType<StorageItem> ("StorageItem");
 		qRegisterMetaTypeStreamOperators<StorageItem> ("StorageItem");
+		qRegisterMetaType<QList<StorageItem>> ("QList<StorageItem>");
+		qRegisterMetaType<Changes_t> ("QList<Change>");
 
 		XSD_.reset (new Util::XmlSettingsDialog);
 		XSD_->RegisterObject (&XmlSettingsManager::Instance (), "netstoremanagersettings.xml");
@@ -62,6 +62,14 @@ namespace DBox
 		return File_.read (ChunkSize_);
 	}
 
+	QByteArray ChunkIODevice::GetChunk (quint64 offset)
+	{
+		if (!File_.seek (offset))
+			return QByteArray ();
+
+		return GetNextChunk ();
+	}
+
 	qint64 ChunkIODevice::readData (char *data, qint64 maxlen)
 	{
 		return File_.read (data, maxlen);
@@ -53,6 +53,11 @@ namespace DBox
 		void close () override;
 
 		QByteArray GetNextChunk ();
+
+		/** Returns the chunk starting at the given \em offset, so that
+		 * an interrupted upload could be resumed from there.
+		 */
+		QByteArray GetChunk (quint64 offset);
 	protected:
 		qint64 readData (char *data, qint64 maxlen) override;
 		qint64 writeData (const char *data, qint64 len) override;
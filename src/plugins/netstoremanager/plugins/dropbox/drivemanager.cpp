@@ -51,6 +51,11 @@ namespace NetStoreManager
 {
 namespace DBox
 {
+	namespace
+	{
+		const int MaxChunkRetries = 3;
+	}
+
 	DriveManager::DriveManager (Account *acc, QObject *parent)
 	: QObject (parent)
 	, DirectoryId_ ("application/vnd.google-apps.folder")
@@ -318,22 +323,29 @@ namespace DBox
 	void DriveManager::RequestChunkUpload (const QString& filePath, const QString& parent,
 			const QString& uploadId, quint64 offset)
 	{
-		ChunkIODevice *chunkFile = new ChunkIODevice (filePath, this);
-		if (!chunkFile->open (QIODevice::ReadOnly))
+		ChunkIODevice chunkFile (filePath);
+		if (!chunkFile.open (QIODevice::ReadOnly))
 		{
 			qWarning () << Q_FUNC_INFO
 					<< "unable to open file: "
-					<< chunkFile->errorString ();
+					<< chunkFile.errorString ();
+			emit uploadError (tr ("Unable to open file."), filePath);
 			return;
 		}
 		emit uploadStatusChanged (tr ("Uploading..."), filePath);
 
 		QFileInfo info (filePath);
+		const bool isLast = !uploadId.isEmpty () &&
+				offset >= static_cast<quint64> (info.size ());
+		const auto& chunk = isLast ?
+				QByteArray () :
+				chunkFile.GetChunk (offset);
+
 		QUrl url;
-		if (!chunkFile->atEnd () && uploadId.isEmpty ())
+		if (!isLast && uploadId.isEmpty ())
 			url = QString ("https://api-content.dropbox.com/1/chunked_upload?access_token=%1")
 					.arg (Account_->GetAccessToken ());
-		else if (!chunkFile->atEnd ())
+		else if (!isLast)
 			url = QString ("https://api-content.dropbox.com/1/chunked_upload?access_token=%1&upload_id=%2&offset=%3")
 					.arg (Account_->GetAccessToken ())
 					.arg (uploadId)
@@ -347,23 +359,22 @@ namespace DBox
 
 		QNetworkRequest request (url);
 		request.setPriority (QNetworkRequest::LowPriority);
-		request.setHeader (QNetworkRequest::ContentLengthHeader, info.size ());
+		request.setHeader (QNetworkRequest::ContentLengthHeader, chunk.size ());
 		request.setHeader (QNetworkRequest::ContentTypeHeader, "application/json");
 
 		QNetworkReply *reply = Core::Instance ().GetProxy ()->
-				GetNetworkAccessManager ()->put (request, chunkFile->GetNextChunk ());
+				GetNetworkAccessManager ()->put (request, chunk);
 		Reply2FilePath_ [reply] = filePath;
 		Reply2ParentId_ [reply] = parent.isEmpty () ? "/" : parent;
-		if (offset)
-			Reply2Offset_ [reply] = offset;
+		Reply2Offset_ [reply] = offset;
+		Reply2UploadId_ [reply] = uploadId;
+
+		// Errors are handled in handleChunkUploadFinished(), since a
+		// failed chunk is retried instead of failing the whole upload.
 		connect (reply,
 				SIGNAL (finished ()),
 				this,
 				SLOT (handleChunkUploadFinished ()));
-		connect (reply,
-				SIGNAL (error (QNetworkReply::NetworkError)),
-				this,
-				SLOT (handleUploadError (QNetworkReply::NetworkError)));
 		connect (reply,
 				SIGNAL (uploadProgress (qint64, qint64)),
 				this,
@@ -579,33 +590,56 @@ namespace DBox
 			return;
 		reply->deleteLater ();
 
+		const auto& filePath = Reply2FilePath_.take (reply);
+		const auto& parentId = Reply2ParentId_.take (reply);
+		const auto& uploadId = Reply2UploadId_.take (reply);
+		const auto offset = Reply2Offset_.take (reply);
+
 		const auto& res = Util::ParseJson (reply, Q_FUNC_INFO);
-		if (res.isNull ())
+		const auto& map = res.toMap ();
+
+		// Dropbox replies with the offset it expects next both after a
+		// successful chunk and on an offset mismatch, so just go on from
+		// there.
+		if (map.contains ("upload_id") && map.contains ("offset"))
+		{
+			if (reply->error () == QNetworkReply::NoError)
+				ChunkRetries_.remove (filePath);
+
+			RequestChunkUpload (filePath,
+					parentId,
+					map ["upload_id"].toString (),
+					map ["offset"].toULongLong ());
 			return;
+		}
 
-		const auto& map = res.toMap ();
-		if (!map.contains ("error"))
+		if (reply->error () == QNetworkReply::NoError && map.contains ("path"))
 		{
-			if (map.contains ("offset"))
-			{
-				const quint64 offset = map ["offset"].toULongLong ();
-				const QString uploadId = map ["upload_id"].toString ();
-				RequestChunkUpload (Reply2FilePath_.take (reply),
-						Reply2ParentId_.take (reply),
-						uploadId,
-						offset);
-			}
-			else if (map.contains ("path"))
-			{
-				qDebug () << Q_FUNC_INFO
-						<< "file uploaded successfully";
-				emit gotNewItem (CreateDBoxItem (res));
-				emit finished (Reply2Id_.take (reply), Reply2FilePath_.take (reply));
-			}
+			qDebug () << Q_FUNC_INFO
+					<< "file uploaded successfully";
+			ChunkRetries_.remove (filePath);
+			emit gotNewItem (CreateDBoxItem (res));
+			emit finished (Reply2Id_.take (reply), filePath);
 			return;
 		}
 
-		ParseError (map);
+		if (reply->error () != QNetworkReply::NoError &&
+				++ChunkRetries_ [filePath] <= MaxChunkRetries)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "retrying chunk at"
+					<< offset
+					<< "of"
+					<< filePath
+					<< reply->errorString ();
+			RequestChunkUpload (filePath, parentId, uploadId, offset);
+			return;
+		}
+
+		ChunkRetries_.remove (filePath);
+		if (map.contains ("error"))
+			ParseError (map);
+		emit uploadError (tr ("Error uploading file."), filePath);
 	}
 
 	void DriveManager::handleUploadProgress (qint64 uploaded, qint64 total)
@@ -96,6 +96,8 @@ namespace DBox
 		QHash<QNetworkReply*, QString> Reply2FilePath_;
 		QHash<QNetworkReply*, QString> Reply2ParentId_;
 		QHash<QNetworkReply*, quint64> Reply2Offset_;
+		QHash<QNetworkReply*, QString> Reply2UploadId_;
+		QHash<QString, int> ChunkRetries_;
 		bool SecondRequestIfNoItems_;
 		const int ChunkUploadBound_;
 
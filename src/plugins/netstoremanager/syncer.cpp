@@ -30,26 +30,48 @@
 #include "syncer.h"
 #include <future>
 #include <QCryptographicHash>
+#include <QDirIterator>
 #include <QFileInfo>
+#include <QFuture>
+#include <QSet>
+#include <QtConcurrentRun>
+#include <QTimer>
 #include <QStandardItem>
 #include <QtDebug>
 #include <QUuid>
 #include "interfaces/netstoremanager/istorageaccount.h"
+#include "syncexecutor.h"
 #include "utils.h"
+#include "xmlsettingsmanager.h"
 
 namespace LeechCraft
 {
 namespace NetStoreManager
 {
+	namespace
+	{
+		const int SyncDebounceDelay = 2000;
+		const int MaxSyncDelay = 10000;
+	}
+
 	Syncer::Syncer (const QString& dirPath, const QString& remotePath,
-			IStorageAccount *isa, QObject *parent)
+			IStorageAccount *isa, const HashCache_ptr& hashCache, QObject *parent)
 	: QObject (parent)
 	, LocalPath_ (dirPath)
 	, RemotePath_ (remotePath)
 	, Started_ (false)
 	, Account_ (isa)
 	, SFLAccount_ (qobject_cast<ISupportFileListings*> (isa->GetQObject ()))
+	, HashCache_ (hashCache)
+	, SyncTimer_ (new QTimer (this))
+	, MaxUploads_ (XmlSettingsManager::Instance ().property ("MaxConcurrentUploads").toInt ())
 	{
+		SyncTimer_->setSingleShot (true);
+		SyncTimer_->setInterval (SyncDebounceDelay);
+		connect (SyncTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (sync ()));
 	}
 
 	QByteArray Syncer::GetAccountID () const
@@ -164,56 +186,137 @@ namespace NetStoreManager
 		}
 	}
 
+	QString Syncer::ToRemotePath (const QString& relativePath) const
+	{
+		return RemotePath_.isEmpty () ?
+				relativePath :
+				RemotePath_ + "/" + relativePath;
+	}
+
 	Snapshot_t Syncer::CreateSnapshot ()
 	{
+		const auto algo = SFLAccount_->GetCheckSumAlgorithm ();
+		const auto qtAlgo = NSMHashType2QtCryproHashAlgorithm (algo);
+
 		Snapshot_t snapshot;
+		QSet<QString> alive;
 
-		for (const auto& fi : QDir (LocalPath_).entryInfoList (QDir::NoDotAndDotDot | QDir::AllEntries))
+		struct PendingHash
 		{
-			const QString path = fi.absoluteFilePath ().remove (LocalPath_ + "/");
-			Change change;
-			StorageItem storage;
-			if (!Id2Path_.right.count (path))
-				change.ItemID_ = Id2Path_.right.at (path);
-			else
-			{
-				change.ItemID_ = QUuid::createUuid ().toByteArray ();
+			QByteArray ChangeId_;
+			QFileInfo FileInfo_;
+			QFuture<QByteArray> Future_;
+		};
+		QList<PendingHash> pending;
+
+		const auto& root = QDir (LocalPath_).absolutePath ();
+		QDirIterator it (root,
+				QDir::NoDotAndDotDot | QDir::AllEntries | QDir::Hidden,
+				QDirIterator::Subdirectories);
+		while (it.hasNext ())
+		{
+			it.next ();
+			const auto& fi = it.fileInfo ();
+			if (fi.isSymLink ())
+				continue;
 
-				storage.IsDirectory_ = fi.isDir ();
-				storage.Name_ = fi.fileName ();
-				storage.ModifyDate_ = fi.lastModified ();
-				storage.ID_ = change.ItemID_;
-			}
+			const auto& absPath = fi.absoluteFilePath ();
+			const auto& path = absPath.mid (root.size () + 1);
+			const auto& remotePath = ToRemotePath (path);
+
+			Change change;
+			change.ID_ = path.toUtf8 ();
+			change.Deleted_ = false;
+			change.ItemID_ = Id2Path_.right.count (remotePath) ?
+					Id2Path_.right.at (remotePath) :
+					QUuid::createUuid ().toByteArray ();
+
+			auto& storage = change.Item_;
+			storage.ID_ = change.ItemID_;
+			storage.IsDirectory_ = fi.isDir ();
+			storage.Name_ = fi.fileName ();
+			storage.ModifyDate_ = fi.lastModified ();
 
 			if (fi.isFile ())
 			{
-				QFile file (fi.absoluteFilePath ());
-				if (file.open (QIODevice::ReadOnly))
-				{
-					const auto& ba = file.readAll ();
-					storage.Hash_ = QCryptographicHash::hash (ba,
-							NSMHashType2QtCryproHashAlgorithm (SFLAccount_->GetCheckSumAlgorithm ()));
-					file.close ();
-				}
-				else
-					qWarning () << Q_FUNC_INFO
-							<< "unable to open file for hash calculation";
-
 				storage.Size_ = fi.size ();
+				alive << absPath;
+
+				storage.Hash_ = HashCache_->Get (fi, algo);
+				if (storage.Hash_.isNull ())
+					pending.append ({
+							change.ID_,
+							fi,
+							QtConcurrent::run ([absPath, qtAlgo]
+								{ return Utils::HashFile (absPath, qtAlgo); })
+						});
 			}
 
-			change.Item_ = storage;
 			snapshot [change.ID_] = change;
 		}
 
+		for (auto& item : pending)
+		{
+			const auto& hash = item.Future_.result ();
+			if (hash.isNull ())
+				continue;
+
+			snapshot [item.ChangeId_].Item_.Hash_ = hash;
+			HashCache_->Put (item.FileInfo_, algo, hash);
+		}
+
+		HashCache_->Retain (root, alive);
+		HashCache_->Save ();
+
 		return snapshot;
 	}
 
 	Snapshot_t Syncer::CreateDiffSnapshot (const Snapshot_t& newSnapshot,
 			const Snapshot_t& oldSnapshot)
 	{
-		Snapshot_t diffSnapshot;
-		return diffSnapshot;
+		return DiffSnapshots (newSnapshot, oldSnapshot);
+	}
+
+	RemoteState_t Syncer::GetRemoteState () const
+	{
+		RemoteState_t result;
+
+		const auto& ids = GetRemoteIds ();
+		for (auto i = ids.begin (); i != ids.end (); ++i)
+			if (!i.key ().isEmpty ())
+				result [i.key ()] = Id2Item_ [i.value ()];
+
+		return result;
+	}
+
+	QHash<QString, QByteArray> Syncer::GetRemoteIds () const
+	{
+		QHash<QString, QByteArray> result;
+
+		const auto& prefix = RemotePath_.isEmpty () ? QString () : RemotePath_ + "/";
+		for (const auto& pair : Id2Path_.left)
+			if (pair.second.startsWith (prefix))
+				result [pair.second.mid (prefix.size ())] = pair.first;
+
+		result [QString ()] = Id2Path_.right.count (RemotePath_) ?
+				Id2Path_.right.at (RemotePath_) :
+				QByteArray ();
+
+		return result;
+	}
+
+	void Syncer::ScheduleSync ()
+	{
+		if (!Started_)
+			return;
+
+		// Bursts of changes are coalesced into one sync, but a steady
+		// stream of them shouldn't postpone it forever.
+		if (!SyncTimer_->isActive ())
+			FirstScheduled_.start ();
+
+		if (FirstScheduled_.elapsed () < MaxSyncDelay)
+			SyncTimer_->start ();
 	}
 
 	void Syncer::start ()
@@ -222,16 +325,16 @@ namespace NetStoreManager
 			return;
 
 		Started_ = true;
-		QStringList path = RemotePath_.split ('/');
-		CreateRemotePath (path);
+		if (!RemotePath_.isEmpty ())
+			CreateRemotePath (RemotePath_.split ('/'));
 
-		const auto& newSnapshot = CreateSnapshot ();
-		//TODO create diff
+		sync ();
 	}
 
 	void Syncer::stop ()
 	{
 		CallsQueue_.clear ();
+		SyncTimer_->stop ();
 		Started_ = false;
 	}
 
@@ -335,74 +438,94 @@ namespace NetStoreManager
 			CallsQueue_.dequeue () ();
 	}
 
-	void Syncer::localDirWasCreated (const QString& path)
+	void Syncer::localDirWasCreated (const QString&)
 	{
-		if (!SFLAccount_)
-			return;
-
-		QString dirPath = path;
-		QString parentPath = QFileInfo (dirPath).dir ().absolutePath ();
-		dirPath.replace (LocalPath_, RemotePath_);
-		parentPath.replace (LocalPath_, RemotePath_);
+		ScheduleSync ();
+	}
 
-// 		if (Id2Path_.right.count (parentPath))
-// 			CreateRemotePath (dirPath.split ("/"));
-// 		else
-// 			CallsQueue_ << [this, path] () { localDirWasCreated (path); };
+	void Syncer::localDirWasRemoved (const QString&)
+	{
+		ScheduleSync ();
 	}
 
-	void Syncer::localDirWasRemoved (const QString& path)
+	void Syncer::localFileWasCreated (const QString&)
 	{
-		if (!SFLAccount_)
-			return;
+		ScheduleSync ();
+	}
 
-		QString dirPath = path;
-		dirPath.replace (LocalPath_, RemotePath_);
-		if (!Id2Path_.right.count (dirPath))
-			return;
+	void Syncer::localFileWasRemoved (const QString&)
+	{
+		ScheduleSync ();
+	}
 
-// 		DeleteRemotePath (dirPath.split ('/'));
+	void Syncer::localFileWasUpdated (const QString&)
+	{
+		ScheduleSync ();
 	}
 
-	void Syncer::localFileWasCreated (const QString& path)
+	void Syncer::localFileWasRenamed (const QString&, const QString&)
 	{
-		QString filePath = path;
-		QString dirPath = QFileInfo (filePath).dir ().absolutePath ();
-		filePath.replace (LocalPath_, RemotePath_);
-		dirPath.replace (LocalPath_, RemotePath_);
-		const QByteArray& id = Id2Path_.right.at (dirPath);
-// 		if (Id2Path_.right.count (dirPath))
-// 			Account_->Upload (path, id);
-// 		else
-// 			CallsQueue_ << [this, path, id] () { localFileWasCreated (path); };
+		ScheduleSync ();
 	}
 
-	void Syncer::localFileWasRemoved (const QString& path)
+	void Syncer::sync ()
 	{
-		if (!SFLAccount_)
+		if (!Started_)
 			return;
 
-		QString filePath = path;
-		filePath.replace (LocalPath_, RemotePath_);
-// 		DeleteRemotePath (filePath.split ('/'));
-	}
+		if (Executor_)
+		{
+			SyncAgain_ = true;
+			return;
+		}
 
-	void Syncer::localFileWasUpdated (const QString& path)
-	{
-		qDebug () << Q_FUNC_INFO << path;
+		// Wait till the remote directory is created by start().
+		if (!RemotePath_.isEmpty () && !Id2Path_.right.count (RemotePath_))
+		{
+			ScheduleSync ();
+			return;
+		}
+
+		const auto& newSnapshot = CreateSnapshot ();
+		const auto& diff = CreateDiffSnapshot (newSnapshot, Snapshot_);
+		const auto& plan = MakeSyncPlan (diff, GetRemoteState ());
+		if (plan.isEmpty ())
+		{
+			Snapshot_ = newSnapshot;
+			return;
+		}
+
+		PendingSnapshot_ = newSnapshot;
+
+		Executor_ = new SyncExecutor (Account_, QDir (LocalPath_).absolutePath (),
+				GetRemoteIds (), plan);
+		Executor_->SetMaxUploads (MaxUploads_);
+		Executor_->moveToThread (Account_->GetQObject ()->thread ());
+		connect (Executor_,
+				SIGNAL (finished (bool)),
+				this,
+				SLOT (handleExecutorFinished (bool)));
+		QMetaObject::invokeMethod (Executor_, "start", Qt::QueuedConnection);
 	}
 
-	void Syncer::localFileWasRenamed (const QString& oldName, const QString& newName)
+	void Syncer::handleExecutorFinished (bool success)
 	{
-		QString filePath = oldName;
-		filePath.replace (LocalPath_, RemotePath_);
-// 		if (Id2Path_.right.count (filePath))
-// 			SFLAccount_->Rename (Id2Path_.right.at (filePath),
-// 					QFileInfo (newName).fileName ());
-// 		else
-// 			CallsQueue_ << [this, oldName, newName] ()
-// 					{ localFileWasRenamed (oldName, newName); };
-	}
+		Executor_->deleteLater ();
+		Executor_ = nullptr;
 
+		// On failure the old snapshot is kept, so the next sync retries
+		// whatever hasn't been done.
+		if (success)
+			Snapshot_ = PendingSnapshot_;
+		else
+			ScheduleSync ();
+		PendingSnapshot_.clear ();
+
+		if (SyncAgain_)
+		{
+			SyncAgain_ = false;
+			ScheduleSync ();
+		}
+	}
 }
 }
@@ -37,14 +37,20 @@
 
 #include <QObject>
 #include <QQueue>
+#include <QElapsedTimer>
 #include "interfaces/netstoremanager/isupportfilelistings.h"
 #include "syncmanager.h"
+#include "hashcache.h"
+#include "syncplan.h"
+
+class QTimer;
 
 namespace LeechCraft
 {
 namespace NetStoreManager
 {
 	class IStorageAccount;
+	class SyncExecutor;
 
 	class Syncer : public QObject
 	{
@@ -61,9 +67,19 @@ namespace NetStoreManager
 
 		Snapshot_t Snapshot_;
 
+		const HashCache_ptr HashCache_;
+
+		QTimer * const SyncTimer_;
+		QElapsedTimer FirstScheduled_;
+
+		const int MaxUploads_;
+		SyncExecutor *Executor_ = nullptr;
+		Snapshot_t PendingSnapshot_;
+		bool SyncAgain_ = false;
+
 	public:
 		explicit Syncer (const QString& dirPath, const QString& remotePath,
-				IStorageAccount *isa, QObject *parent = 0);
+				IStorageAccount *isa, const HashCache_ptr& hashCache, QObject *parent = 0);
 
 		QByteArray GetAccountID () const;
 		QString GetLocalPath () const;
@@ -77,9 +93,14 @@ namespace NetStoreManager
 		void CreateRemotePath (const QStringList& path);
 		void DeleteRemotePath (const QStringList& path);
 		void RenameItem (const StorageItem& item, const QString& path);
+		QString ToRemotePath (const QString& relativePath) const;
 		Snapshot_t CreateSnapshot ();
 		Snapshot_t CreateDiffSnapshot (const Snapshot_t& newSnapshot,
 				const Snapshot_t& oldSnapshot);
+		RemoteState_t GetRemoteState () const;
+		QHash<QString, QByteArray> GetRemoteIds () const;
+
+		void ScheduleSync ();
 
 	public slots:
 		void start ();
@@ -95,6 +116,9 @@ namespace NetStoreManager
 		void localFileWasRemoved (const QString& path);
 		void localFileWasUpdated (const QString& path);
 		void localFileWasRenamed (const QString& oldName, const QString& newName);
+	private slots:
+		void sync ();
+		void handleExecutorFinished (bool success);
 	};
 }
 }
@@ -0,0 +1,286 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "syncexecutor.h"
+#include <algorithm>
+#include <QTimer>
+#include <QtDebug>
+#include "interfaces/netstoremanager/istorageaccount.h"
+#include "interfaces/netstoremanager/isupportfilelistings.h"
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	namespace
+	{
+		const int MaxUploadAttempts = 3;
+		const int DirectoryTimeout = 60 * 1000;
+
+		QString GetParentPath (const QString& path)
+		{
+			const auto pos = path.lastIndexOf ('/');
+			return pos >= 0 ? path.left (pos) : QString ();
+		}
+
+		QString GetName (const QString& path)
+		{
+			return path.section ('/', -1);
+		}
+	}
+
+	SyncExecutor::SyncExecutor (IStorageAccount *account, const QString& localPath,
+			const QHash<QString, QByteArray>& path2id, const SyncPlan_t& plan, QObject *parent)
+	: QObject (parent)
+	, Account_ (account)
+	, SFLAccount_ (qobject_cast<ISupportFileListings*> (account->GetQObject ()))
+	, LocalPath_ (localPath)
+	, MaxUploads_ (3)
+	, Path2Id_ (path2id)
+	, Queue_ (plan)
+	, DirectoryTimeout_ (new QTimer (this))
+	{
+		DirectoryTimeout_->setSingleShot (true);
+		DirectoryTimeout_->setInterval (DirectoryTimeout);
+		connect (DirectoryTimeout_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (handleDirectoryTimeout ()));
+
+		const auto accObj = account->GetQObject ();
+		connect (accObj,
+				SIGNAL (gotNewItem (StorageItem, QByteArray)),
+				this,
+				SLOT (handleGotNewItem (StorageItem, QByteArray)));
+		connect (accObj,
+				SIGNAL (upFinished (QByteArray, QString)),
+				this,
+				SLOT (handleUpFinished (QByteArray, QString)));
+		connect (accObj,
+				SIGNAL (upError (QString, QString)),
+				this,
+				SLOT (handleUpError (QString, QString)));
+	}
+
+	void SyncExecutor::SetMaxUploads (int max)
+	{
+		MaxUploads_ = std::max (max, 1);
+	}
+
+	QHash<QString, QByteArray> SyncExecutor::GetPathIds () const
+	{
+		return Path2Id_;
+	}
+
+	void SyncExecutor::start ()
+	{
+		if (!SFLAccount_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "account doesn't support file listings";
+			Failed_ = true;
+			Queue_.clear ();
+		}
+
+		Process ();
+	}
+
+	void SyncExecutor::Process ()
+	{
+		while (!Queue_.isEmpty () && PendingDirectory_.isEmpty ())
+		{
+			const auto type = Queue_.first ().Type_;
+			const bool isUpload = type == SyncAction::Type::Upload ||
+					type == SyncAction::Type::Update;
+			if (isUpload && RunningUploads_.size () >= MaxUploads_)
+				return;
+
+			const auto action = Queue_.takeFirst ();
+			switch (type)
+			{
+			case SyncAction::Type::CreateDirectory:
+				CreateDirectory (action);
+				break;
+			case SyncAction::Type::Move:
+				Move (action);
+				break;
+			case SyncAction::Type::Delete:
+				SFLAccount_->MoveToTrash ({ action.ItemId_ });
+				Path2Id_.remove (action.Path_);
+				break;
+			case SyncAction::Type::Upload:
+			case SyncAction::Type::Update:
+				StartUpload (action);
+				break;
+			}
+		}
+
+		if (Queue_.isEmpty () &&
+				PendingDirectory_.isEmpty () &&
+				RunningUploads_.isEmpty () &&
+				!Finished_)
+		{
+			Finished_ = true;
+			emit finished (!Failed_);
+		}
+	}
+
+	void SyncExecutor::CreateDirectory (const SyncAction& action)
+	{
+		QByteArray parentId;
+		if (!GetParentId (action.Path_, parentId))
+		{
+			Failed_ = true;
+			return;
+		}
+
+		PendingDirectory_ = action.Path_;
+		PendingDirectoryParent_ = parentId;
+		DirectoryTimeout_->start ();
+
+		SFLAccount_->CreateDirectory (GetName (action.Path_), parentId);
+	}
+
+	void SyncExecutor::Move (const SyncAction& action)
+	{
+		if (GetParentPath (action.Path_) != GetParentPath (action.OldPath_))
+		{
+			QByteArray parentId;
+			if (!GetParentId (action.Path_, parentId))
+			{
+				Failed_ = true;
+				return;
+			}
+
+			SFLAccount_->Move ({ action.ItemId_ }, parentId);
+		}
+
+		const auto& name = GetName (action.Path_);
+		if (name != GetName (action.OldPath_))
+			SFLAccount_->Rename (action.ItemId_, name);
+
+		Path2Id_.remove (action.OldPath_);
+		Path2Id_ [action.Path_] = action.ItemId_;
+	}
+
+	void SyncExecutor::StartUpload (const SyncAction& action)
+	{
+		QByteArray parentId;
+		if (!GetParentId (action.Path_, parentId))
+		{
+			Failed_ = true;
+			return;
+		}
+
+		const auto& localPath = LocalPath_ + "/" + action.Path_;
+		RunningUploads_ [localPath] = action;
+
+		Account_->Upload (localPath,
+				parentId,
+				action.Type_ == SyncAction::Type::Update ?
+						UploadType::Update :
+						UploadType::Upload,
+				action.ItemId_);
+	}
+
+	bool SyncExecutor::GetParentId (const QString& path, QByteArray& id) const
+	{
+		const auto& parent = GetParentPath (path);
+		if (!Path2Id_.contains (parent))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown parent directory for"
+					<< path;
+			return false;
+		}
+
+		id = Path2Id_ [parent];
+		return true;
+	}
+
+	void SyncExecutor::handleGotNewItem (const StorageItem& item, const QByteArray& parentId)
+	{
+		if (PendingDirectory_.isEmpty () ||
+				!item.IsDirectory_ ||
+				item.Name_ != GetName (PendingDirectory_) ||
+				parentId != PendingDirectoryParent_)
+			return;
+
+		DirectoryTimeout_->stop ();
+		Path2Id_ [PendingDirectory_] = item.ID_;
+		PendingDirectory_.clear ();
+
+		Process ();
+	}
+
+	void SyncExecutor::handleUpFinished (const QByteArray& id, const QString& filepath)
+	{
+		if (!RunningUploads_.contains (filepath))
+			return;
+
+		const auto& action = RunningUploads_.take (filepath);
+		Path2Id_ [action.Path_] = id;
+
+		Process ();
+	}
+
+	void SyncExecutor::handleUpError (const QString& error, const QString& filepath)
+	{
+		if (!RunningUploads_.contains (filepath))
+			return;
+
+		const auto& action = RunningUploads_.take (filepath);
+		qWarning () << Q_FUNC_INFO
+				<< "error uploading"
+				<< filepath
+				<< error;
+
+		if (++UploadAttempts_ [filepath] < MaxUploadAttempts)
+			Queue_ << action;
+		else
+			Failed_ = true;
+
+		Process ();
+	}
+
+	void SyncExecutor::handleDirectoryTimeout ()
+	{
+		qWarning () << Q_FUNC_INFO
+				<< "timed out creating"
+				<< PendingDirectory_;
+
+		// The actions inside this directory will fail as well, since its
+		// ID is unknown.
+		Failed_ = true;
+		PendingDirectory_.clear ();
+
+		Process ();
+	}
+}
+}
@@ -0,0 +1,104 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include "syncplan.h"
+
+class QTimer;
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	class IStorageAccount;
+	class ISupportFileListings;
+
+	/** Applies a sync plan to the remote storage.
+	 *
+	 * The directories are created one by one, since the following
+	 * actions need their IDs, and the uploads are run concurrently.
+	 * Failed uploads are retried a few times before the whole run is
+	 * considered failed.
+	 *
+	 * The executor should live in the thread of the storage account.
+	 */
+	class SyncExecutor : public QObject
+	{
+		Q_OBJECT
+
+		IStorageAccount * const Account_;
+		ISupportFileListings * const SFLAccount_;
+		const QString LocalPath_;
+		int MaxUploads_;
+
+		QHash<QString, QByteArray> Path2Id_;
+		SyncPlan_t Queue_;
+
+		QHash<QString, SyncAction> RunningUploads_;
+		QHash<QString, int> UploadAttempts_;
+
+		QString PendingDirectory_;
+		QByteArray PendingDirectoryParent_;
+		QTimer * const DirectoryTimeout_;
+
+		bool Failed_ = false;
+		bool Finished_ = false;
+	public:
+		/** \em path2id maps the paths relative to the synced directory
+		 * to the remote IDs. The empty path corresponds to the remote
+		 * directory the local one is synced to.
+		 */
+		SyncExecutor (IStorageAccount *account, const QString& localPath,
+				const QHash<QString, QByteArray>& path2id, const SyncPlan_t& plan,
+				QObject *parent = 0);
+
+		void SetMaxUploads (int);
+
+		QHash<QString, QByteArray> GetPathIds () const;
+	public slots:
+		void start ();
+	private:
+		void Process ();
+		void CreateDirectory (const SyncAction&);
+		void Move (const SyncAction&);
+		void StartUpload (const SyncAction&);
+		bool GetParentId (const QString& path, QByteArray& id) const;
+	private slots:
+		void handleGotNewItem (const StorageItem& item, const QByteArray& parentId);
+		void handleUpFinished (const QByteArray& id, const QString& filepath);
+		void handleUpError (const QString& error, const QString& filepath);
+		void handleDirectoryTimeout ();
+	signals:
+		void finished (bool success);
+	};
+}
+}
@@ -31,6 +31,7 @@
 #include <QtDebug>
 #include <QSettings>
 #include <QThread>
+#include <util/sys/paths.h>
 #include "accountsmanager.h"
 #include "syncer.h"
 #if defined (Q_OS_LINUX)
@@ -45,9 +46,28 @@ namespace LeechCraft
 namespace NetStoreManager
 {
 
+	namespace
+	{
+		QString GetHashCachePath ()
+		{
+			try
+			{
+				return Util::GetUserDir (Util::UserDir::Cache, "netstoremanager").filePath ("hashes");
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to get cache directory:"
+						<< e.what ();
+				return QString ();
+			}
+		}
+	}
+
 	SyncManager::SyncManager (AccountsManager *am, QObject *parent)
 	: QObject (parent)
 	, AM_ (am)
+	, HashCache_ (std::make_shared<HashCache> (GetHashCachePath ()))
 	{
 #if defined (Q_OS_LINUX)
 		FilesWatcher_ = new FilesWatcherInotify (this);
@@ -85,23 +105,11 @@ namespace NetStoreManager
 				SLOT (handleEntryWasRenamed (QString, QString)));
 
 		for (auto account : AM_->GetAccounts ())
-		{
-// 			auto isfl = qobject_cast<ISupportFileListings*> (account->GetQObject ());
-// 			if (!isfl)
-// 				continue;
-// 			connect (account->GetQObject (),
-// 					SIGNAL (gotListing (QList<StorageItem>)),
-// 					this,
-// 					SLOT (handleGotListing (QList<StorageItem>)));
-// 			connect (account->GetQObject (),
-// 					SIGNAL (gotNewItem (StorageItem, QByteArray)),
-// 					this,
-// 					SLOT (handleGotNewItem (StorageItem, QByteArray)));
-// 			connect (account->GetQObject (),
-// 					SIGNAL (gotChanges (QList<Change>)),
-// 					this,
-// 					SLOT (handleGotChanges (QList<Change>)));
-		}
+			handleAccountAdded (account->GetQObject ());
+		connect (AM_,
+				SIGNAL (accountAdded (QObject*)),
+				this,
+				SLOT (handleAccountAdded (QObject*)));
 	}
 
 	void SyncManager::Release ()
@@ -123,6 +131,8 @@ namespace NetStoreManager
 			syncer->deleteLater ();
 			thread->deleteLater ();
 		}
+
+		HashCache_->Save ();
 	}
 
 	void SyncManager::handleDirectoriesToSyncUpdated (const QList<SyncerInfo>& infos)
@@ -149,9 +159,23 @@ namespace NetStoreManager
 			}
 			else
 			{
+				auto isfl = acc ?
+						qobject_cast<ISupportFileListings*> (acc->GetQObject ()) :
+						0;
+				if (!isfl)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "account"
+							<< info.AccountId_
+							<< "doesn't exist or doesn't support file listings";
+					continue;
+				}
+
 				auto syncer = CreateSyncer (acc, info.LocalDirectory_, info.RemoteDirectory_);
 				AccountID2Syncer_ [info.AccountId_] = syncer;
-// 				syncer->start ();
+
+				// The syncer is started once it gets the listing.
+				isfl->RefreshListing ();
 			}
 		}
 
@@ -162,7 +186,7 @@ namespace NetStoreManager
 			const QString& baseDir, const QString& remoteDir)
 	{
 		QThread *thread = new QThread (this);
-		Syncer *syncer = new Syncer (baseDir, remoteDir, isa);
+		Syncer *syncer = new Syncer (baseDir, remoteDir, isa, HashCache_);
 		syncer->moveToThread (thread);
 		thread->start ();
 		Syncer2Thread_ [syncer] = thread;
@@ -197,82 +221,129 @@ namespace NetStoreManager
 
 	void SyncManager::handleDirWasCreated (const QString& path)
 	{
-// 		if (auto syncer = GetSyncerByLocalPath (path))
-// 			syncer->localDirWasCreated (path);
+		if (auto syncer = GetSyncerByLocalPath (path))
+			QMetaObject::invokeMethod (syncer,
+					"localDirWasCreated",
+					Qt::QueuedConnection,
+					Q_ARG (QString, path));
 	}
 
 	void SyncManager::handleDirWasRemoved (const QString& path)
 	{
-// 		if (auto syncer = GetSyncerByLocalPath (path))
-// 			syncer->localDirWasRemoved (path);
+		if (auto syncer = GetSyncerByLocalPath (path))
+			QMetaObject::invokeMethod (syncer,
+					"localDirWasRemoved",
+					Qt::QueuedConnection,
+					Q_ARG (QString, path));
 	}
 
 	void SyncManager::handleFileWasCreated (const QString& path)
 	{
-// 		if (auto syncer = GetSyncerByLocalPath (path))
-// 			syncer->localFileWasCreated (path);
+		if (auto syncer = GetSyncerByLocalPath (path))
+			QMetaObject::invokeMethod (syncer,
+					"localFileWasCreated",
+					Qt::QueuedConnection,
+					Q_ARG (QString, path));
 	}
 
 	void SyncManager::handleFileWasRemoved (const QString& path)
 	{
-// 		if (auto syncer = GetSyncerByLocalPath (path))
-// 			syncer->localFileWasRemoved (path);
+		if (auto syncer = GetSyncerByLocalPath (path))
+			QMetaObject::invokeMethod (syncer,
+					"localFileWasRemoved",
+					Qt::QueuedConnection,
+					Q_ARG (QString, path));
 	}
 
 	void SyncManager::handleFileWasUpdated (const QString& path)
 	{
-// 		if (auto syncer = GetSyncerByLocalPath (path))
-// 			syncer->localFileWasUpdated (path);
+		if (auto syncer = GetSyncerByLocalPath (path))
+			QMetaObject::invokeMethod (syncer,
+					"localFileWasUpdated",
+					Qt::QueuedConnection,
+					Q_ARG (QString, path));
 	}
 
 	void SyncManager::handleEntryWasMoved (const QString& oldPath,
 			const QString& newPath)
 	{
-		qDebug () << Q_FUNC_INFO << oldPath << newPath;
+		handleEntryWasRenamed (oldPath, newPath);
 	}
 
 	void SyncManager::handleEntryWasRenamed (const QString& oldName,
 			const QString& newName)
 	{
-// 		if (auto syncer = GetSyncerByLocalPath (oldName))
-// 			syncer->localFileWasRenamed (oldName, newName);
+		if (auto syncer = GetSyncerByLocalPath (oldName))
+			QMetaObject::invokeMethod (syncer,
+					"localFileWasRenamed",
+					Qt::QueuedConnection,
+					Q_ARG (QString, oldName),
+					Q_ARG (QString, newName));
+	}
+
+	void SyncManager::handleAccountAdded (QObject *accObj)
+	{
+		if (!qobject_cast<ISupportFileListings*> (accObj))
+			return;
+
+		connect (accObj,
+				SIGNAL (gotListing (QList<StorageItem>)),
+				this,
+				SLOT (handleGotListing (QList<StorageItem>)));
+		connect (accObj,
+				SIGNAL (gotNewItem (StorageItem, QByteArray)),
+				this,
+				SLOT (handleGotNewItem (StorageItem, QByteArray)));
+		connect (accObj,
+				SIGNAL (gotChanges (QList<Change>)),
+				this,
+				SLOT (handleGotChanges (QList<Change>)));
 	}
 
 	void SyncManager::handleGotListing (const QList<StorageItem>& items)
 	{
-// 		auto isa = qobject_cast<IStorageAccount*> (sender ());
-// 		if (!isa)
-// 			return;
-//
-// 		if (auto syncer = GetSyncerByID (isa->GetUniqueID ()))
-// 		{
-// 			syncer->handleGotItems (items);
-// 			if (!syncer->IsStarted ())
-// 				syncer->start ();
-// 		}
+		auto isa = qobject_cast<IStorageAccount*> (sender ());
+		if (!isa)
+			return;
+
+		if (auto syncer = GetSyncerByID (isa->GetUniqueID ()))
+		{
+			QMetaObject::invokeMethod (syncer,
+					"handleGotItems",
+					Qt::QueuedConnection,
+					Q_ARG (QList<StorageItem>, items));
+			QMetaObject::invokeMethod (syncer,
+					"start",
+					Qt::QueuedConnection);
+		}
 	}
 
 	void SyncManager::handleGotNewItem (const StorageItem& item,
 			const QByteArray& parentId)
 	{
-// 		auto isa = qobject_cast<IStorageAccount*> (sender ());
-// 		if (!isa)
-// 			return;
-//
-// 		if (auto syncer = GetSyncerByID (isa->GetUniqueID ()))
-// 			syncer->handleGotNewItem (item, parentId);
+		auto isa = qobject_cast<IStorageAccount*> (sender ());
+		if (!isa)
+			return;
+
+		if (auto syncer = GetSyncerByID (isa->GetUniqueID ()))
+			QMetaObject::invokeMethod (syncer,
+					"handleGotNewItem",
+					Qt::QueuedConnection,
+					Q_ARG (StorageItem, item),
+					Q_ARG (QByteArray, parentId));
 	}
 
 	void SyncManager::handleGotChanges (const QList<Change>& changes)
 	{
-// 		auto isa = qobject_cast<IStorageAccount*> (sender ());
-// 		if (!isa)
-// 			return;
-//
-// 		if (auto syncer = GetSyncerByID (isa->GetUniqueID ()))
-// 			syncer->handleGotChanges (changes);
-	}
+		auto isa = qobject_cast<IStorageAccount*> (sender ());
+		if (!isa)
+			return;
 
+		if (auto syncer = GetSyncerByID (isa->GetUniqueID ()))
+			QMetaObject::invokeMethod (syncer,
+					"handleGotChanges",
+					Qt::QueuedConnection,
+					Q_ARG (QList<Change>, changes));
+	}
 }
 }
-
@@ -34,6 +34,7 @@
 #include "interfaces/netstoremanager/istorageaccount.h"
 #include "interfaces/netstoremanager/isupportfilelistings.h"
 #include "syncwidget.h"
+#include "hashcache.h"
 
 typedef QList<LeechCraft::NetStoreManager::Change> Changes_t;
 Q_DECLARE_METATYPE (Changes_t)
@@ -58,6 +59,7 @@ namespace NetStoreManager
 		FilesWatcherBase *FilesWatcher_;
 		QHash<QString, Syncer*> AccountID2Syncer_;
 		QHash<Syncer*, QThread*> Syncer2Thread_;
+		HashCache_ptr HashCache_;
 
 	public:
 		SyncManager (AccountsManager *am, QObject *parent = 0);
@@ -83,6 +85,8 @@ namespace NetStoreManager
 		void handleEntryWasMoved (const QString& oldPath, const QString& newPath);
 		void handleEntryWasRenamed (const QString& oldName, const QString& newName);
 
+		void handleAccountAdded (QObject *accObj);
+
 		void handleGotListing (const QList<StorageItem>& items);
 		void handleGotNewItem (const StorageItem& item, const QByteArray& parentId);
 		void handleGotChanges (const QList<Change>& changes);
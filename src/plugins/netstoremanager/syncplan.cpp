@@ -0,0 +1,214 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "syncplan.h"
+#include <algorithm>
+#include <QSet>
+#include <QStringList>
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	bool operator== (const SyncAction& left, const SyncAction& right)
+	{
+		return left.Type_ == right.Type_ &&
+				left.Path_ == right.Path_ &&
+				left.OldPath_ == right.OldPath_ &&
+				left.ItemId_ == right.ItemId_;
+	}
+
+	namespace
+	{
+		bool IsSameEntry (const StorageItem& left, const StorageItem& right)
+		{
+			if (left.IsDirectory_ != right.IsDirectory_)
+				return false;
+
+			if (left.IsDirectory_)
+				return true;
+
+			return left.Size_ == right.Size_ && left.Hash_ == right.Hash_;
+		}
+
+		bool HasSameContents (const StorageItem& local, const StorageItem& remote)
+		{
+			return !local.Hash_.isEmpty () &&
+					local.Size_ == remote.Size_ &&
+					local.Hash_ == remote.Hash_;
+		}
+
+		QString GetParentPath (const QString& path)
+		{
+			const auto pos = path.lastIndexOf ('/');
+			return pos >= 0 ? path.left (pos) : QString ();
+		}
+
+		bool HasAncestorIn (const QString& path, const QSet<QString>& dirs)
+		{
+			for (auto parent = GetParentPath (path); !parent.isEmpty (); parent = GetParentPath (parent))
+				if (dirs.contains (parent))
+					return true;
+			return false;
+		}
+	}
+
+	Snapshot_t DiffSnapshots (const Snapshot_t& newSnapshot, const Snapshot_t& oldSnapshot)
+	{
+		Snapshot_t diff;
+
+		for (auto i = newSnapshot.begin (); i != newSnapshot.end (); ++i)
+		{
+			const auto pos = oldSnapshot.find (i.key ());
+			if (pos == oldSnapshot.end () ||
+					!IsSameEntry (pos->Item_, i->Item_))
+				diff [i.key ()] = *i;
+		}
+
+		for (auto i = oldSnapshot.begin (); i != oldSnapshot.end (); ++i)
+			if (!newSnapshot.contains (i.key ()))
+			{
+				auto change = *i;
+				change.Deleted_ = true;
+				diff [i.key ()] = change;
+			}
+
+		return diff;
+	}
+
+	SyncPlan_t MakeSyncPlan (const Snapshot_t& diff, const RemoteState_t& remote)
+	{
+		QStringList deleted;
+		QStringList addedDirs;
+		QStringList addedFiles;
+		for (auto i = diff.begin (); i != diff.end (); ++i)
+		{
+			const auto& path = QString::fromUtf8 (i.key ());
+			if (i->Deleted_)
+				deleted << path;
+			else if (i->Item_.IsDirectory_)
+				addedDirs << path;
+			else
+				addedFiles << path;
+		}
+
+		// The hash iteration order is random, sort for stable plans.
+		std::sort (deleted.begin (), deleted.end ());
+		std::sort (addedFiles.begin (), addedFiles.end ());
+		std::sort (addedDirs.begin (), addedDirs.end (),
+				[] (const QString& left, const QString& right)
+				{
+					const auto leftDepth = left.count ('/');
+					const auto rightDepth = right.count ('/');
+					return leftDepth == rightDepth ? left < right : leftDepth < rightDepth;
+				});
+
+		auto getItem = [&diff] (const QString& path) -> const StorageItem&
+			{ return diff.find (path.toUtf8 ())->Item_; };
+
+		SyncPlan_t dirs;
+		for (const auto& path : addedDirs)
+		{
+			const auto pos = remote.find (path);
+			if (pos == remote.end () || !pos->IsDirectory_)
+				dirs.append ({ SyncAction::Type::CreateDirectory, path, {}, {} });
+		}
+
+		SyncPlan_t moves;
+		QSet<QString> movedTargets;
+		QStringList stillDeleted;
+		for (const auto& oldPath : deleted)
+		{
+			const auto& oldItem = getItem (oldPath);
+			const auto remotePos = remote.find (oldPath);
+
+			if (!oldItem.IsDirectory_ &&
+					!oldItem.Hash_.isEmpty () &&
+					remotePos != remote.end ())
+			{
+				// Prefer the candidate with the same name, so that moving
+				// a couple of identical files keeps their names.
+				const auto& oldName = oldPath.section ('/', -1);
+				QString target;
+				for (const auto& newPath : addedFiles)
+				{
+					if (movedTargets.contains (newPath) ||
+							remote.contains (newPath) ||
+							!IsSameEntry (getItem (newPath), oldItem))
+						continue;
+
+					if (target.isEmpty () || newPath.section ('/', -1) == oldName)
+						target = newPath;
+					if (newPath.section ('/', -1) == oldName)
+						break;
+				}
+
+				if (!target.isEmpty ())
+				{
+					movedTargets << target;
+					moves.append ({ SyncAction::Type::Move, target, oldPath, remotePos->ID_ });
+					continue;
+				}
+			}
+
+			stillDeleted << oldPath;
+		}
+
+		QSet<QString> deletedDirs;
+		for (const auto& path : stillDeleted)
+			if (getItem (path).IsDirectory_)
+				deletedDirs << path;
+
+		SyncPlan_t deletions;
+		for (const auto& path : stillDeleted)
+		{
+			const auto pos = remote.find (path);
+			if (pos == remote.end () || HasAncestorIn (path, deletedDirs))
+				continue;
+
+			deletions.append ({ SyncAction::Type::Delete, path, {}, pos->ID_ });
+		}
+
+		SyncPlan_t uploads;
+		for (const auto& path : addedFiles)
+		{
+			if (movedTargets.contains (path))
+				continue;
+
+			const auto pos = remote.find (path);
+			if (pos == remote.end ())
+				uploads.append ({ SyncAction::Type::Upload, path, {}, {} });
+			else if (!pos->IsDirectory_ && !HasSameContents (getItem (path), *pos))
+				uploads.append ({ SyncAction::Type::Update, path, {}, pos->ID_ });
+		}
+
+		return dirs + moves + deletions + uploads;
+	}
+}
+}
@@ -0,0 +1,102 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QList>
+#include <QHash>
+#include <QString>
+#include "syncmanager.h"
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	/** A single operation on the remote storage needed to bring it in
+	 * sync with the local directory.
+	 *
+	 * All paths are relative to the synced directory.
+	 */
+	struct SyncAction
+	{
+		enum class Type
+		{
+			CreateDirectory,
+			Move,
+			Delete,
+			Upload,
+			Update
+		};
+
+		Type Type_;
+
+		/** The path of the local entry, or the new path for moves.
+		 */
+		QString Path_;
+
+		/** The old path of the entry for moves.
+		 */
+		QString OldPath_;
+
+		/** The ID of the remote item for moves, updates and deletions.
+		 */
+		QByteArray ItemId_;
+	};
+
+	bool operator== (const SyncAction&, const SyncAction&);
+
+	typedef QList<SyncAction> SyncPlan_t;
+
+	/** Maps paths relative to the synced directory to the items in the
+	 * remote storage.
+	 */
+	typedef QHash<QString, StorageItem> RemoteState_t;
+
+	/** Returns the entries of \em newSnapshot that are added or changed
+	 * compared to \em oldSnapshot, plus the entries of \em oldSnapshot
+	 * that are missing in the new one, marked as deleted.
+	 *
+	 * Both snapshots should be keyed by the relative paths of the
+	 * entries.
+	 */
+	Snapshot_t DiffSnapshots (const Snapshot_t& newSnapshot, const Snapshot_t& oldSnapshot);
+
+	/** Builds the minimal plan applying the local \em diff to the
+	 * \em remote state.
+	 *
+	 * A file deleted at one path and added at another one with the same
+	 * contents becomes a move. Deleting a directory implies deleting its
+	 * children, and files whose contents already match the remote ones
+	 * are skipped. The directories are created first, parents before
+	 * children, then the moves and deletions follow, and the uploads
+	 * come last.
+	 */
+	SyncPlan_t MakeSyncPlan (const Snapshot_t& diff, const RemoteState_t& remote);
+}
+}
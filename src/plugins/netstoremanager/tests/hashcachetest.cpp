@@ -0,0 +1,170 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "hashcachetest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include "hashcache.h"
+#include "utils.h"
+
+QTEST_MAIN (LeechCraft::NetStoreManager::HashCacheTest)
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	namespace
+	{
+		QString WriteFile (const QTemporaryDir& dir, const QString& name, const QByteArray& data)
+		{
+			const auto& path = dir.path () + "/" + name;
+			QFile file (path);
+			file.open (QIODevice::WriteOnly | QIODevice::Truncate);
+			file.write (data);
+			return path;
+		}
+
+		QByteArray MakeData (int size)
+		{
+			QByteArray result;
+			result.reserve (size);
+			for (int i = 0; i < size; ++i)
+				result.append (static_cast<char> (i * 31 % 251));
+			return result;
+		}
+	}
+
+	void HashCacheTest::streamingHash ()
+	{
+		QTemporaryDir dir;
+
+		// Spans several chunks and ends in the middle of one.
+		const auto& data = MakeData (3 * 1024 * 1024 + 123);
+		const auto& path = WriteFile (dir, "file", data);
+
+		QCOMPARE (Utils::HashFile (path, QCryptographicHash::Md5),
+				QCryptographicHash::hash (data, QCryptographicHash::Md5));
+
+		const auto& emptyPath = WriteFile (dir, "empty", {});
+		QCOMPARE (Utils::HashFile (emptyPath, QCryptographicHash::Sha1),
+				QCryptographicHash::hash ({}, QCryptographicHash::Sha1));
+	}
+
+	void HashCacheTest::missingFile ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (Utils::HashFile (dir.path () + "/missing", QCryptographicHash::Md5).isNull ());
+	}
+
+	void HashCacheTest::cacheHit ()
+	{
+		QTemporaryDir dir;
+		const QFileInfo fi (WriteFile (dir, "file", "contents"));
+
+		HashCache cache { QString {} };
+		QVERIFY (cache.Get (fi, HashAlgorithm::Md5).isNull ());
+
+		cache.Put (fi, HashAlgorithm::Md5, "hash");
+		QCOMPARE (cache.Get (QFileInfo (fi.absoluteFilePath ()), HashAlgorithm::Md5), QByteArray ("hash"));
+	}
+
+	void HashCacheTest::invalidation ()
+	{
+		QTemporaryDir dir;
+		const auto& path = WriteFile (dir, "file", "contents");
+
+		HashCache cache { QString {} };
+		cache.Put (QFileInfo (path), HashAlgorithm::Md5, "hash");
+
+		WriteFile (dir, "file", "other contents");
+		QVERIFY (cache.Get (QFileInfo (path), HashAlgorithm::Md5).isNull ());
+
+		cache.Put (QFileInfo (path), HashAlgorithm::Md5, "hash2");
+		QCOMPARE (cache.Get (QFileInfo (path), HashAlgorithm::Md5), QByteArray ("hash2"));
+
+		// Same size, but a different modification time.
+		QTest::qSleep (1100);
+		WriteFile (dir, "file", "other_contents");
+		QVERIFY (cache.Get (QFileInfo (path), HashAlgorithm::Md5).isNull ());
+	}
+
+	void HashCacheTest::algorithms ()
+	{
+		QTemporaryDir dir;
+		const QFileInfo fi (WriteFile (dir, "file", "contents"));
+
+		HashCache cache { QString {} };
+		cache.Put (fi, HashAlgorithm::Md5, "md5");
+		QVERIFY (cache.Get (fi, HashAlgorithm::Sha1).isNull ());
+
+		cache.Put (fi, HashAlgorithm::Sha1, "sha1");
+		QCOMPARE (cache.Get (fi, HashAlgorithm::Md5), QByteArray ("md5"));
+		QCOMPARE (cache.Get (fi, HashAlgorithm::Sha1), QByteArray ("sha1"));
+	}
+
+	void HashCacheTest::persistence ()
+	{
+		QTemporaryDir dir;
+		const QFileInfo fi (WriteFile (dir, "file", "contents"));
+		const auto& cachePath = dir.path () + "/cache";
+
+		{
+			HashCache cache (cachePath);
+			cache.Put (fi, HashAlgorithm::Md5, "hash");
+			cache.Save ();
+		}
+
+		HashCache cache (cachePath);
+		QCOMPARE (cache.Get (fi, HashAlgorithm::Md5), QByteArray ("hash"));
+
+		WriteFile (dir, "cache", "garbage");
+		HashCache corrupted (cachePath);
+		QVERIFY (corrupted.Get (fi, HashAlgorithm::Md5).isNull ());
+	}
+
+	void HashCacheTest::retain ()
+	{
+		QTemporaryDir dir;
+		QDir (dir.path ()).mkdir ("sub");
+		const QFileInfo kept (WriteFile (dir, "sub/kept", "1"));
+		const QFileInfo dropped (WriteFile (dir, "sub/dropped", "2"));
+		const QFileInfo outside (WriteFile (dir, "outside", "3"));
+
+		HashCache cache { QString {} };
+		for (const auto& fi : { kept, dropped, outside })
+			cache.Put (fi, HashAlgorithm::Md5, "hash");
+
+		cache.Retain (dir.path () + "/sub", { kept.absoluteFilePath () });
+
+		QVERIFY (!cache.Get (kept, HashAlgorithm::Md5).isNull ());
+		QVERIFY (cache.Get (dropped, HashAlgorithm::Md5).isNull ());
+		QVERIFY (!cache.Get (outside, HashAlgorithm::Md5).isNull ());
+	}
+}
+}
@@ -0,0 +1,293 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "mockstorageaccount.h"
+#include <algorithm>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	MockStorageAccount::MockStorageAccount (const QString& root, QObject *parent)
+	: QObject (parent)
+	, Root_ (root)
+	{
+	}
+
+	QByteArray MockStorageAccount::AddItem (const QString& path)
+	{
+		const auto& id = "id" + QByteArray::number (++LastId_);
+		Id2Path_ [id] = path;
+		return id;
+	}
+
+	QString MockStorageAccount::GetPath (const QByteArray& id) const
+	{
+		return Id2Path_.value (id);
+	}
+
+	void MockStorageAccount::SetFailures (const QString& name, int count)
+	{
+		Failures_ [name] = count;
+	}
+
+	int MockStorageAccount::GetMaxConcurrentUploads () const
+	{
+		return MaxConcurrentUploads_;
+	}
+
+	int MockStorageAccount::GetUploadsCount () const
+	{
+		return UploadsCount_;
+	}
+
+	QObject* MockStorageAccount::GetParentPlugin () const
+	{
+		return 0;
+	}
+
+	QObject* MockStorageAccount::GetQObject ()
+	{
+		return this;
+	}
+
+	QByteArray MockStorageAccount::GetUniqueID () const
+	{
+		return "mock";
+	}
+
+	QString MockStorageAccount::GetAccountName () const
+	{
+		return "Mock";
+	}
+
+	AccountFeatures MockStorageAccount::GetAccountFeatures () const
+	{
+		return FileListings;
+	}
+
+	void MockStorageAccount::Upload (const QString& filepath,
+			const QByteArray& parentId, UploadType, const QByteArray& id)
+	{
+		++UploadsCount_;
+		Uploads_.enqueue ({ filepath, parentId, id });
+		MaxConcurrentUploads_ = std::max (MaxConcurrentUploads_, Uploads_.size ());
+
+		QMetaObject::invokeMethod (this, "processUpload", Qt::QueuedConnection);
+	}
+
+	void MockStorageAccount::Download (const QByteArray&, const QString&, TaskParameters, bool)
+	{
+	}
+
+	ListingOps MockStorageAccount::GetListingOps () const
+	{
+		return ListingOp::Delete | ListingOp::TrashSupporting | ListingOp::DirectorySupport;
+	}
+
+	HashAlgorithm MockStorageAccount::GetCheckSumAlgorithm () const
+	{
+		return HashAlgorithm::Md5;
+	}
+
+	void MockStorageAccount::RefreshListing ()
+	{
+		QHash<QString, QByteArray> path2Id;
+		for (auto i = Id2Path_.begin (); i != Id2Path_.end (); ++i)
+			path2Id [*i] = i.key ();
+
+		QList<StorageItem> items;
+		for (auto i = Id2Path_.begin (); i != Id2Path_.end (); ++i)
+		{
+			if (i->isEmpty ())
+				continue;
+
+			const auto pos = i->lastIndexOf ('/');
+
+			StorageItem item;
+			item.ID_ = i.key ();
+			item.ParentID_ = path2Id.value (pos >= 0 ? i->left (pos) : QString ());
+			item.Name_ = i->mid (pos + 1);
+			item.IsDirectory_ = QFileInfo (GetFullPath (i.key ())).isDir ();
+			items << item;
+		}
+
+		emit gotListing (items);
+	}
+
+	void MockStorageAccount::RefreshChildren (const QByteArray&)
+	{
+	}
+
+	void MockStorageAccount::Delete (const QList<QByteArray>& ids, bool)
+	{
+		MoveToTrash (ids);
+	}
+
+	void MockStorageAccount::MoveToTrash (const QList<QByteArray>& ids)
+	{
+		for (const auto& id : ids)
+		{
+			const auto& fullPath = GetFullPath (id);
+			if (QFileInfo (fullPath).isDir ())
+				QDir (fullPath).removeRecursively ();
+			else
+				QFile::remove (fullPath);
+
+			const auto& path = Id2Path_.take (id);
+			for (auto i = Id2Path_.begin (); i != Id2Path_.end (); )
+				if (i->startsWith (path + "/"))
+					i = Id2Path_.erase (i);
+				else
+					++i;
+		}
+	}
+
+	void MockStorageAccount::RestoreFromTrash (const QList<QByteArray>&)
+	{
+	}
+
+	void MockStorageAccount::Copy (const QList<QByteArray>&, const QByteArray&)
+	{
+	}
+
+	void MockStorageAccount::Move (const QList<QByteArray>& ids, const QByteArray& newParentId)
+	{
+		const auto& parentPath = Id2Path_.value (newParentId);
+		for (const auto& id : ids)
+		{
+			const auto& name = Id2Path_.value (id).section ('/', -1);
+			SetPath (id, parentPath.isEmpty () ? name : parentPath + "/" + name);
+		}
+	}
+
+	void MockStorageAccount::RequestUrl (const QByteArray&)
+	{
+	}
+
+	void MockStorageAccount::CreateDirectory (const QString& name, const QByteArray& parentId)
+	{
+		Directories_.enqueue ({ name, parentId });
+		QMetaObject::invokeMethod (this, "processDirectory", Qt::QueuedConnection);
+	}
+
+	void MockStorageAccount::Rename (const QByteArray& id, const QString& newName)
+	{
+		const auto& path = Id2Path_.value (id);
+		const auto pos = path.lastIndexOf ('/');
+		SetPath (id, pos >= 0 ? path.left (pos + 1) + newName : newName);
+	}
+
+	void MockStorageAccount::RequestChanges ()
+	{
+	}
+
+	QString MockStorageAccount::GetFullPath (const QByteArray& id) const
+	{
+		const auto& path = Id2Path_.value (id);
+		return path.isEmpty () ? Root_ : Root_ + "/" + path;
+	}
+
+	void MockStorageAccount::SetPath (const QByteArray& id, const QString& newPath)
+	{
+		const auto& oldPath = Id2Path_.value (id);
+		if (!QDir (Root_).rename (oldPath, newPath))
+			qWarning () << Q_FUNC_INFO
+					<< "unable to move"
+					<< oldPath
+					<< "to"
+					<< newPath;
+
+		for (auto i = Id2Path_.begin (); i != Id2Path_.end (); ++i)
+			if (*i == oldPath)
+				*i = newPath;
+			else if (i->startsWith (oldPath + "/"))
+				*i = newPath + i->mid (oldPath.size ());
+	}
+
+	void MockStorageAccount::processUpload ()
+	{
+		if (Uploads_.isEmpty ())
+			return;
+
+		const auto upload = Uploads_.dequeue ();
+		const auto& name = QFileInfo (upload.LocalPath_).fileName ();
+
+		if (Failures_.value (name) > 0)
+		{
+			--Failures_ [name];
+			emit upError ("injected failure", upload.LocalPath_);
+			return;
+		}
+
+		auto id = upload.Id_;
+		if (id.isEmpty ())
+		{
+			const auto& parentPath = Id2Path_.value (upload.ParentId_);
+			id = AddItem (parentPath.isEmpty () ? name : parentPath + "/" + name);
+		}
+
+		const auto& target = GetFullPath (id);
+		QFile::remove (target);
+		if (!QFile::copy (upload.LocalPath_, target))
+		{
+			emit upError ("unable to copy", upload.LocalPath_);
+			return;
+		}
+
+		emit upFinished (id, upload.LocalPath_);
+	}
+
+	void MockStorageAccount::processDirectory ()
+	{
+		if (Directories_.isEmpty ())
+			return;
+
+		const auto& pair = Directories_.dequeue ();
+		const auto& parentPath = Id2Path_.value (pair.second);
+		const auto& path = parentPath.isEmpty () ?
+				pair.first :
+				parentPath + "/" + pair.first;
+
+		if (!QDir (Root_).mkpath (path))
+			return;
+
+		StorageItem item;
+		item.ID_ = AddItem (path);
+		item.ParentID_ = pair.second;
+		item.Name_ = pair.first;
+		item.IsDirectory_ = true;
+		emit gotNewItem (item, pair.second);
+	}
+}
+}
@@ -0,0 +1,139 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QQueue>
+#include <interfaces/netstoremanager/istorageaccount.h>
+#include <interfaces/netstoremanager/isupportfilelistings.h>
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	/** A storage account backed by a local directory.
+	 *
+	 * The uploads and directory creations complete asynchronously, like
+	 * in the real accounts, while the other operations are applied
+	 * immediately, and RefreshListing() emits the registered items
+	 * right away. The item IDs are opaque and stay the same when items
+	 * are moved or renamed.
+	 */
+	class MockStorageAccount : public QObject
+							, public IStorageAccount
+							, public ISupportFileListings
+	{
+		Q_OBJECT
+		Q_INTERFACES (LeechCraft::NetStoreManager::IStorageAccount
+				LeechCraft::NetStoreManager::ISupportFileListings)
+
+		const QString Root_;
+
+		QHash<QByteArray, QString> Id2Path_;
+		int LastId_ = 0;
+
+		struct PendingUpload
+		{
+			QString LocalPath_;
+			QByteArray ParentId_;
+			QByteArray Id_;
+		};
+		QQueue<PendingUpload> Uploads_;
+		QQueue<QPair<QString, QByteArray>> Directories_;
+
+		QHash<QString, int> Failures_;
+		int MaxConcurrentUploads_ = 0;
+		int UploadsCount_ = 0;
+	public:
+		MockStorageAccount (const QString& root, QObject *parent = 0);
+
+		/** Registers the already existing remote item at \em path
+		 * relative to the root and returns its ID. The root itself has
+		 * the empty path.
+		 */
+		QByteArray AddItem (const QString& path);
+		QString GetPath (const QByteArray& id) const;
+
+		/** Makes the next \em count uploads of the file \em name fail.
+		 */
+		void SetFailures (const QString& name, int count);
+
+		int GetMaxConcurrentUploads () const;
+		int GetUploadsCount () const;
+
+		QObject* GetParentPlugin () const;
+		QObject* GetQObject ();
+		QByteArray GetUniqueID () const;
+		QString GetAccountName () const;
+		AccountFeatures GetAccountFeatures () const;
+		void Upload (const QString& filepath,
+				const QByteArray& parentId, UploadType ut, const QByteArray& id);
+		void Download (const QByteArray& id, const QString& filepath,
+				TaskParameters tp, bool open);
+
+		ListingOps GetListingOps () const;
+		HashAlgorithm GetCheckSumAlgorithm () const;
+		void RefreshListing ();
+		void RefreshChildren (const QByteArray& parentId);
+		void Delete (const QList<QByteArray>& ids, bool ask);
+		void MoveToTrash (const QList<QByteArray>& ids);
+		void RestoreFromTrash (const QList<QByteArray>& ids);
+		void Copy (const QList<QByteArray>& ids, const QByteArray& newParentId);
+		void Move (const QList<QByteArray>& ids, const QByteArray& newParentId);
+		void RequestUrl (const QByteArray& id);
+		void CreateDirectory (const QString& name, const QByteArray& parentId);
+		void Rename (const QByteArray& id, const QString& newName);
+		void RequestChanges ();
+	private:
+		QString GetFullPath (const QByteArray& id) const;
+		void SetPath (const QByteArray& id, const QString& newPath);
+	private slots:
+		void processUpload ();
+		void processDirectory ();
+	signals:
+		void upError (const QString& error, const QString& filepath);
+		void upFinished (const QByteArray& id, const QString& filepath);
+		void upProgress (quint64 done, quint64 total, const QString& filepath);
+		void upStatusChanged (const QString& status, const QString& filepath);
+
+		void gotListing (const QList<StorageItem>& items);
+		void listingUpdated (const QByteArray& parentId);
+		void gotFileUrl (const QUrl& url, const QByteArray& id);
+
+		void gotChanges (const QList<Change>& changes);
+
+		void gotNewItem (const StorageItem& item, const QByteArray& parentId);
+
+		void downloadFile (const QUrl& url, const QString& filePath,
+			TaskParameters tp, bool open);
+	};
+}
+}
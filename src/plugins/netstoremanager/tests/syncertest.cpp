@@ -0,0 +1,128 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "syncertest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include "syncer.h"
+#include "mockstorageaccount.h"
+
+QTEST_MAIN (LeechCraft::NetStoreManager::SyncerTest)
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	namespace
+	{
+		// The first sync may be postponed by the debounce timer.
+		const int SyncTimeout = 10000;
+
+		void WriteFile (const QString& root, const QString& path, const QByteArray& data)
+		{
+			QDir { root }.mkpath (QFileInfo { path }.path ());
+
+			QFile file { root + "/" + path };
+			QVERIFY (file.open (QIODevice::WriteOnly));
+			file.write (data);
+		}
+
+		QByteArray ReadFile (const QString& root, const QString& path)
+		{
+			QFile file { root + "/" + path };
+			if (!file.open (QIODevice::ReadOnly))
+				return {};
+			return file.readAll ();
+		}
+
+		/** Feeds the syncer with the account's listing and starts it,
+		 * the same way SyncManager does.
+		 */
+		void Start (MockStorageAccount& account, Syncer& syncer)
+		{
+			QObject::connect (&account,
+					SIGNAL (gotListing (QList<StorageItem>)),
+					&syncer,
+					SLOT (handleGotItems (QList<StorageItem>)));
+			QObject::connect (&account,
+					SIGNAL (gotNewItem (StorageItem, QByteArray)),
+					&syncer,
+					SLOT (handleGotNewItem (StorageItem, QByteArray)));
+
+			account.RefreshListing ();
+			syncer.start ();
+		}
+	}
+
+	void SyncerTest::syncToNewRemoteDir ()
+	{
+		QTemporaryDir local;
+		QTemporaryDir remote;
+		WriteFile (local.path (), "dir/nested", "nested");
+		WriteFile (local.path (), "top", "top");
+
+		MockStorageAccount account { remote.path () };
+		account.AddItem ("other");
+		QDir { remote.path () }.mkdir ("other");
+
+		Syncer syncer { local.path (), "Sync/Docs", &account, std::make_shared<HashCache> (QString ()) };
+		Start (account, syncer);
+		QVERIFY (syncer.IsStarted ());
+
+		QTRY_COMPARE_WITH_TIMEOUT (ReadFile (remote.path (), "Sync/Docs/top"), QByteArray ("top"), SyncTimeout);
+		QTRY_COMPARE_WITH_TIMEOUT (ReadFile (remote.path (), "Sync/Docs/dir/nested"), QByteArray ("nested"), SyncTimeout);
+		QVERIFY (QFileInfo { remote.path () + "/other" }.isDir ());
+	}
+
+	void SyncerTest::syncToExistingRemoteDir ()
+	{
+		QTemporaryDir local;
+		QTemporaryDir remote;
+		WriteFile (local.path (), "first", "first");
+		WriteFile (local.path (), "second", "second");
+
+		MockStorageAccount account { remote.path () };
+		account.AddItem ("Sync");
+		QDir { remote.path () }.mkdir ("Sync");
+
+		Syncer syncer { local.path (), "Sync", &account, std::make_shared<HashCache> (QString ()) };
+		Start (account, syncer);
+
+		QTRY_COMPARE_WITH_TIMEOUT (ReadFile (remote.path (), "Sync/second"), QByteArray ("second"), SyncTimeout);
+		QTRY_COMPARE_WITH_TIMEOUT (ReadFile (remote.path (), "Sync/first"), QByteArray ("first"), SyncTimeout);
+		QCOMPARE (account.GetUploadsCount (), 2);
+
+		WriteFile (local.path (), "late", "late");
+		syncer.localFileWasCreated (local.path () + "/late");
+
+		QTRY_COMPARE_WITH_TIMEOUT (ReadFile (remote.path (), "Sync/late"), QByteArray ("late"), SyncTimeout);
+		QCOMPARE (account.GetUploadsCount (), 3);
+	}
+}
+}
@@ -0,0 +1,210 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "syncexecutortest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include "syncexecutor.h"
+#include "mockstorageaccount.h"
+
+QTEST_MAIN (LeechCraft::NetStoreManager::SyncExecutorTest)
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	namespace
+	{
+		typedef SyncAction::Type Type;
+
+		void WriteFile (const QString& root, const QString& path, const QByteArray& data)
+		{
+			QDir { root }.mkpath (QFileInfo { path }.path ());
+
+			QFile file { root + "/" + path };
+			QVERIFY (file.open (QIODevice::WriteOnly));
+			file.write (data);
+		}
+
+		QByteArray ReadFile (const QString& root, const QString& path)
+		{
+			QFile file { root + "/" + path };
+			if (!file.open (QIODevice::ReadOnly))
+				return {};
+			return file.readAll ();
+		}
+
+		QHash<QString, QByteArray> MakeRootIds (const QByteArray& rootId)
+		{
+			QHash<QString, QByteArray> result;
+			result [QString ()] = rootId;
+			return result;
+		}
+
+		bool Run (SyncExecutor& executor)
+		{
+			QSignalSpy spy { &executor, SIGNAL (finished (bool)) };
+			QMetaObject::invokeMethod (&executor, "start", Qt::QueuedConnection);
+			if (!spy.wait (5000) || spy.size () != 1)
+				return false;
+			return spy.at (0).at (0).toBool ();
+		}
+
+		SyncPlan_t MakeUploads (const QString& local, int count)
+		{
+			SyncPlan_t plan;
+			for (int i = 0; i < count; ++i)
+			{
+				const auto& name = QString ("file%1").arg (i);
+				WriteFile (local, name, name.toUtf8 ());
+				plan.append ({ Type::Upload, name, {}, {} });
+			}
+			return plan;
+		}
+	}
+
+	void SyncExecutorTest::createAndUpload ()
+	{
+		QTemporaryDir local;
+		QTemporaryDir remote;
+		WriteFile (local.path (), "dir/sub/nested", "nested");
+		WriteFile (local.path (), "top", "top");
+
+		MockStorageAccount account { remote.path () };
+		const auto& rootId = account.AddItem ({});
+
+		const SyncPlan_t plan
+		{
+			{ Type::CreateDirectory, "dir", {}, {} },
+			{ Type::CreateDirectory, "dir/sub", {}, {} },
+			{ Type::Upload, "dir/sub/nested", {}, {} },
+			{ Type::Upload, "top", {}, {} }
+		};
+		SyncExecutor executor { &account, local.path (), MakeRootIds (rootId), plan };
+		QVERIFY (Run (executor));
+
+		QCOMPARE (ReadFile (remote.path (), "dir/sub/nested"), QByteArray ("nested"));
+		QCOMPARE (ReadFile (remote.path (), "top"), QByteArray ("top"));
+
+		const auto& ids = executor.GetPathIds ();
+		QCOMPARE (account.GetPath (ids ["dir/sub"]), QString ("dir/sub"));
+		QCOMPARE (account.GetPath (ids ["dir/sub/nested"]), QString ("dir/sub/nested"));
+	}
+
+	void SyncExecutorTest::concurrencyLimit ()
+	{
+		QTemporaryDir local;
+		QTemporaryDir remote;
+
+		MockStorageAccount account { remote.path () };
+		const auto& rootId = account.AddItem ({});
+
+		SyncExecutor executor { &account, local.path (), MakeRootIds (rootId), MakeUploads (local.path (), 7) };
+		executor.SetMaxUploads (2);
+		QVERIFY (Run (executor));
+
+		QCOMPARE (account.GetUploadsCount (), 7);
+		QCOMPARE (account.GetMaxConcurrentUploads (), 2);
+		QCOMPARE (ReadFile (remote.path (), "file6"), QByteArray ("file6"));
+	}
+
+	void SyncExecutorTest::retryFailedUpload ()
+	{
+		QTemporaryDir local;
+		QTemporaryDir remote;
+
+		MockStorageAccount account { remote.path () };
+		const auto& rootId = account.AddItem ({});
+		account.SetFailures ("file0", 2);
+
+		SyncExecutor executor { &account, local.path (), MakeRootIds (rootId), MakeUploads (local.path (), 2) };
+		QVERIFY (Run (executor));
+
+		QCOMPARE (account.GetUploadsCount (), 4);
+		QCOMPARE (ReadFile (remote.path (), "file0"), QByteArray ("file0"));
+	}
+
+	void SyncExecutorTest::giveUpAfterRetries ()
+	{
+		QTemporaryDir local;
+		QTemporaryDir remote;
+
+		MockStorageAccount account { remote.path () };
+		const auto& rootId = account.AddItem ({});
+		account.SetFailures ("file0", 10);
+
+		SyncExecutor executor { &account, local.path (), MakeRootIds (rootId), MakeUploads (local.path (), 2) };
+		QVERIFY (!Run (executor));
+
+		QCOMPARE (account.GetUploadsCount (), 4);
+		QCOMPARE (ReadFile (remote.path (), "file1"), QByteArray ("file1"));
+		QVERIFY (!QFile::exists (remote.path () + "/file0"));
+	}
+
+	void SyncExecutorTest::moveAndDelete ()
+	{
+		QTemporaryDir local;
+		QTemporaryDir remote;
+		WriteFile (remote.path (), "a/file", "moved");
+		WriteFile (remote.path (), "gone/inner", "inner");
+		WriteFile (remote.path (), "old", "old");
+		QDir { remote.path () }.mkdir ("b");
+
+		MockStorageAccount account { remote.path () };
+		const QHash<QString, QByteArray> path2id
+		{
+			{ QString (), account.AddItem ({}) },
+			{ "a", account.AddItem ("a") },
+			{ "a/file", account.AddItem ("a/file") },
+			{ "b", account.AddItem ("b") },
+			{ "gone", account.AddItem ("gone") },
+			{ "old", account.AddItem ("old") }
+		};
+
+		const SyncPlan_t plan
+		{
+			{ Type::Move, "b/renamed", "a/file", path2id ["a/file"] },
+			{ Type::Delete, "gone", {}, path2id ["gone"] },
+			{ Type::Delete, "old", {}, path2id ["old"] }
+		};
+		SyncExecutor executor { &account, local.path (), path2id, plan };
+		QVERIFY (Run (executor));
+
+		QCOMPARE (ReadFile (remote.path (), "b/renamed"), QByteArray ("moved"));
+		QVERIFY (!QFile::exists (remote.path () + "/a/file"));
+		QVERIFY (!QFile::exists (remote.path () + "/gone"));
+		QVERIFY (!QFile::exists (remote.path () + "/old"));
+
+		const auto& ids = executor.GetPathIds ();
+		QVERIFY (!ids.contains ("a/file"));
+		QCOMPARE (ids ["b/renamed"], path2id ["a/file"]);
+		QCOMPARE (account.GetPath (ids ["b/renamed"]), QString ("b/renamed"));
+	}
+}
+}
@@ -0,0 +1,257 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "syncplantest.h"
+#include <QtTest>
+#include "syncplan.h"
+
+QTEST_MAIN (LeechCraft::NetStoreManager::SyncPlanTest)
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	namespace
+	{
+		typedef SyncAction::Type Type;
+
+		Change MakeFile (const QString& path, const QByteArray& hash, quint64 size = 10)
+		{
+			Change change;
+			change.ID_ = path.toUtf8 ();
+			change.Deleted_ = false;
+			change.Item_.Name_ = path.section ('/', -1);
+			change.Item_.Hash_ = hash;
+			change.Item_.Size_ = size;
+			return change;
+		}
+
+		Change MakeDir (const QString& path)
+		{
+			auto change = MakeFile (path, {}, 0);
+			change.Item_.IsDirectory_ = true;
+			return change;
+		}
+
+		Snapshot_t MakeSnapshot (const QList<Change>& changes)
+		{
+			Snapshot_t result;
+			for (const auto& change : changes)
+				result [change.ID_] = change;
+			return result;
+		}
+
+		StorageItem MakeRemote (const QByteArray& id, const QByteArray& hash, quint64 size = 10, bool isDir = false)
+		{
+			StorageItem item;
+			item.ID_ = id;
+			item.Hash_ = hash;
+			item.Size_ = size;
+			item.IsDirectory_ = isDir;
+			return item;
+		}
+	}
+
+	void SyncPlanTest::diffSnapshots ()
+	{
+		const auto& oldSnapshot = MakeSnapshot ({
+				MakeFile ("same", "h1"),
+				MakeFile ("changed", "h2"),
+				MakeFile ("removed", "h3"),
+				MakeDir ("dir")
+			});
+		const auto& newSnapshot = MakeSnapshot ({
+				MakeFile ("same", "h1"),
+				MakeFile ("changed", "h2'"),
+				MakeFile ("added", "h4"),
+				MakeDir ("dir")
+			});
+
+		const auto& diff = DiffSnapshots (newSnapshot, oldSnapshot);
+		QCOMPARE (diff.size (), 3);
+		QVERIFY (!diff ["changed"].Deleted_);
+		QCOMPARE (diff ["changed"].Item_.Hash_, QByteArray ("h2'"));
+		QVERIFY (!diff ["added"].Deleted_);
+		QVERIFY (diff ["removed"].Deleted_);
+	}
+
+	void SyncPlanTest::uploadNew ()
+	{
+		const auto& diff = MakeSnapshot ({
+				MakeDir ("dir"),
+				MakeFile ("dir/file", "h1"),
+				MakeFile ("top", "h2")
+			});
+
+		const SyncPlan_t expected
+		{
+			{ Type::CreateDirectory, "dir", {}, {} },
+			{ Type::Upload, "dir/file", {}, {} },
+			{ Type::Upload, "top", {}, {} }
+		};
+		QCOMPARE (MakeSyncPlan (diff, {}), expected);
+	}
+
+	void SyncPlanTest::directoriesOrder ()
+	{
+		const auto& diff = MakeSnapshot ({
+				MakeDir ("b/c/d"),
+				MakeDir ("b"),
+				MakeDir ("a/z"),
+				MakeDir ("b/c"),
+				MakeDir ("a")
+			});
+
+		RemoteState_t remote;
+		remote ["a"] = MakeRemote ("id_a", {}, 0, true);
+
+		const SyncPlan_t expected
+		{
+			{ Type::CreateDirectory, "b", {}, {} },
+			{ Type::CreateDirectory, "a/z", {}, {} },
+			{ Type::CreateDirectory, "b/c", {}, {} },
+			{ Type::CreateDirectory, "b/c/d", {}, {} }
+		};
+		QCOMPARE (MakeSyncPlan (diff, remote), expected);
+	}
+
+	void SyncPlanTest::skipIdentical ()
+	{
+		const auto& diff = MakeSnapshot ({ MakeFile ("file", "h1") });
+
+		RemoteState_t remote;
+		remote ["file"] = MakeRemote ("id", "h1");
+
+		QVERIFY (MakeSyncPlan (diff, remote).isEmpty ());
+	}
+
+	void SyncPlanTest::updateChanged ()
+	{
+		const auto& diff = MakeSnapshot ({
+				MakeFile ("hash", "h1"),
+				MakeFile ("size", "h2", 20),
+				MakeFile ("nohash", "h3")
+			});
+
+		RemoteState_t remote;
+		remote ["hash"] = MakeRemote ("id1", "other");
+		remote ["size"] = MakeRemote ("id2", "h2", 10);
+		remote ["nohash"] = MakeRemote ("id3", {});
+
+		const SyncPlan_t expected
+		{
+			{ Type::Update, "hash", {}, "id1" },
+			{ Type::Update, "nohash", {}, "id3" },
+			{ Type::Update, "size", {}, "id2" }
+		};
+		QCOMPARE (MakeSyncPlan (diff, remote), expected);
+	}
+
+	void SyncPlanTest::move ()
+	{
+		auto removed = MakeFile ("a/file", "h1");
+		removed.Deleted_ = true;
+
+		const auto& diff = MakeSnapshot ({
+				removed,
+				MakeDir ("b"),
+				MakeFile ("b/renamed", "h1")
+			});
+
+		RemoteState_t remote;
+		remote ["a"] = MakeRemote ("id_a", {}, 0, true);
+		remote ["a/file"] = MakeRemote ("id_file", "h1");
+
+		const SyncPlan_t expected
+		{
+			{ Type::CreateDirectory, "b", {}, {} },
+			{ Type::Move, "b/renamed", "a/file", "id_file" }
+		};
+		QCOMPARE (MakeSyncPlan (diff, remote), expected);
+	}
+
+	void SyncPlanTest::moveKeepsName ()
+	{
+		auto removed = MakeFile ("old/copy2", "h1");
+		removed.Deleted_ = true;
+
+		const auto& diff = MakeSnapshot ({
+				removed,
+				MakeFile ("new/copy1", "h1"),
+				MakeFile ("new/copy2", "h1")
+			});
+
+		RemoteState_t remote;
+		remote ["old"] = MakeRemote ("id_old", {}, 0, true);
+		remote ["new"] = MakeRemote ("id_new", {}, 0, true);
+		remote ["old/copy2"] = MakeRemote ("id_copy2", "h1");
+
+		const SyncPlan_t expected
+		{
+			{ Type::Move, "new/copy2", "old/copy2", "id_copy2" },
+			{ Type::Upload, "new/copy1", {}, {} }
+		};
+		QCOMPARE (MakeSyncPlan (diff, remote), expected);
+	}
+
+	void SyncPlanTest::deleteCollapsed ()
+	{
+		QList<Change> removed
+		{
+			MakeDir ("dir"),
+			MakeDir ("dir/sub"),
+			MakeFile ("dir/sub/file", "h1"),
+			MakeFile ("file", "h2")
+		};
+		for (auto& change : removed)
+			change.Deleted_ = true;
+
+		RemoteState_t remote;
+		remote ["dir"] = MakeRemote ("id_dir", {}, 0, true);
+		remote ["dir/sub"] = MakeRemote ("id_sub", {}, 0, true);
+		remote ["dir/sub/file"] = MakeRemote ("id_file1", "h1");
+		remote ["file"] = MakeRemote ("id_file2", "h2");
+
+		const SyncPlan_t expected
+		{
+			{ Type::Delete, "dir", {}, "id_dir" },
+			{ Type::Delete, "file", {}, "id_file2" }
+		};
+		QCOMPARE (MakeSyncPlan (MakeSnapshot (removed), remote), expected);
+	}
+
+	void SyncPlanTest::deleteOnlyRemote ()
+	{
+		auto removed = MakeFile ("never_uploaded", "h1");
+		removed.Deleted_ = true;
+
+		QVERIFY (MakeSyncPlan (MakeSnapshot ({ removed }), {}).isEmpty ());
+	}
+}
+}
@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "utils.h"
+#include <QtDebug>
 
 namespace LeechCraft
 {
@@ -73,6 +74,42 @@ namespace Utils
 		return result;
 	}
 
+	QByteArray HashFile (const QString& path, QCryptographicHash::Algorithm algo)
+	{
+		QFile file (path);
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< path
+					<< file.errorString ();
+			return QByteArray ();
+		}
+
+		const qint64 chunkSize = 1024 * 1024;
+		QByteArray buffer (chunkSize, Qt::Uninitialized);
+
+		QCryptographicHash hash (algo);
+		while (true)
+		{
+			const auto read = file.read (buffer.data (), chunkSize);
+			if (read < 0)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error reading"
+						<< path
+						<< file.errorString ();
+				return QByteArray ();
+			}
+			if (!read)
+				break;
+
+			hash.addData (buffer.constData (), read);
+		}
+
+		return hash.result ();
+	}
+
 }
 }
 }
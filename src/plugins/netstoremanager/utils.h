@@ -31,6 +31,7 @@
 
 #include <QString>
 #include <QDir>
+#include <QCryptographicHash>
 #include "interfaces/netstoremanager/isupportfilelistings.h"
 
 namespace LeechCraft
@@ -41,6 +42,12 @@ namespace Utils
 {
 	QStringList ScanDir (QDir::Filters filter, const QString& path, bool recursive = false);
 	bool RemoveDirectoryContent (const QString& dirPath);
+
+	/** Hashes the file at \em path reading it by chunks.
+	 *
+	 * Returns a null byte array if the file can't be read.
+	 */
+	QByteArray HashFile (const QString& path, QCryptographicHash::Algorithm algo);
 }
 }
 }
@@ -160,6 +160,14 @@ namespace Otlozhu
 		mgr->GetTodoStorage ()->AddItem (item);
 	}
 
+	QList<EntityRoutingRule> Plugin::GetEntityRoutingRules () const
+	{
+		EntityRoutingRule rule;
+		rule.Mimes_ << "x-leechcraft/todo-item";
+		rule.StaticResult_ = EntityTestHandleResult { EntityTestHandleResult::PIdeal };
+		return { rule };
+	}
+
 	Util::XmlSettingsDialog_ptr Plugin::GetSettingsDialog () const
 	{
 		return XSD_;
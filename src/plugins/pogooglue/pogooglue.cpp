@@ -104,6 +104,13 @@ namespace Pogooglue
 		GoogleIt (str);
 	}
 
+	QList<EntityRoutingRule> Plugin::GetEntityRoutingRules () const
+	{
+		EntityRoutingRule rule;
+		rule.Mimes_ << "x-leechcraft/data-filter-request";
+		return { rule };
+	}
+
 	QString Plugin::GetFilterVerb () const
 	{
 		return tr ("Google it!");
@@ -33,6 +33,7 @@
 #include <QObject>
 #include <interfaces/iinfo.h>
 #include <interfaces/ientityhandler.h>
+#include <interfaces/ientityroutingrules.h>
 #include <interfaces/idatafilter.h>
 
 namespace LeechCraft
@@ -42,10 +43,11 @@ namespace Pogooglue
 	class Plugin : public QObject
 				 , public IInfo
 				 , public IEntityHandler
+				 , public IEntityRoutingRules
 				 , public IDataFilter
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IEntityHandler IDataFilter)
+		Q_INTERFACES (IInfo IEntityHandler IEntityRoutingRules IDataFilter)
 
 		LC_PLUGIN_METADATA ("org.LeechCraft.Pogooglue")
 	public:
@@ -60,6 +62,8 @@ namespace Pogooglue
 		EntityTestHandleResult CouldHandle (const Entity& entity) const;
 		void Handle (Entity entity);
 
+		QList<EntityRoutingRule> GetEntityRoutingRules () const;
+
 		QString GetFilterVerb () const;
 		QList<FilterVariant> GetFilterVariants () const;
 	private:
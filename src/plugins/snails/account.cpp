@@ -616,6 +616,11 @@ namespace Snails
 			});
 	}
 
+	void Account::handleFolderSyncState (const QStringList& folder, const FolderSyncState& state)
+	{
+		Core::Instance ().GetStorage ()->SetFolderSyncState (this, folder, state);
+	}
+
 	void Account::handleMessageCountFetched (int count, int unread, const QStringList& folder)
 	{
 		const auto storedCount = Core::Instance ().GetStorage ()->GetNumMessages (this, folder);
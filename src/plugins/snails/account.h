@@ -57,6 +57,7 @@ namespace Snails
 	class FoldersModel;
 	class MailModelsManager;
 	struct Folder;
+	struct FolderSyncState;
 
 	class Account : public QObject
 	{
@@ -180,6 +181,7 @@ namespace Snails
 		void handleMessagesRemoved (const QList<QByteArray>&, const QStringList&);
 
 		void handleFolderSyncFinished (const QStringList&, const QByteArray&);
+		void handleFolderSyncState (const QStringList&, const LeechCraft::Snails::FolderSyncState&);
 		void handleMessageCountFetched (int, int, const QStringList&);
 
 		void handleGotFolders (const QList<LeechCraft::Snails::Folder>&);
@@ -32,10 +32,12 @@
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
+#include <QRegExp>
 #include <QtDebug>
 #include <util/db/dblock.h>
 #include <util/sll/qtutil.h>
-#include "account.h"
+#include "message.h"
+#include "searchquery.h"
 
 bool operator< (const QStringList& left, const QStringList& right)
 {
@@ -53,9 +55,9 @@ namespace LeechCraft
 {
 namespace Snails
 {
-	AccountDatabase::AccountDatabase (const QDir& dir, Account *acc, QObject *parent)
+	AccountDatabase::AccountDatabase (const QDir& dir, const QString& connectionName, QObject *parent)
 	: QObject { parent }
-	, DB_ { std::make_shared<QSqlDatabase> (QSqlDatabase::addDatabase ("QSQLITE", "SnailsStorage_" + acc->GetID ())) }
+	, DB_ { std::make_shared<QSqlDatabase> (QSqlDatabase::addDatabase ("QSQLITE", connectionName)) }
 	{
 		if (!DB_->isValid ())
 		{
@@ -185,6 +187,7 @@ namespace Snails
 					*existing :
 					AddMessageUnfoldered (msg);
 			AddMessageToFolder (msgTableId, GetFolder (folder), msg->GetFolderID ());
+			SetMessageInfo (msgTableId, msg);
 		}
 
 		lock.Good ();
@@ -196,16 +199,366 @@ namespace Snails
 		Util::DBLock lock { *DB_ };
 		lock.Init ();
 
+		QueryRemoveFromIndex_.bindValue (":msgId", msgId);
+		QueryRemoveFromIndex_.bindValue (":path", folder.join ("/"));
+		Util::DBLock::Execute (QueryRemoveFromIndex_);
+
 		QueryRemoveMessage_.bindValue (":msgId", msgId);
 		QueryRemoveMessage_.bindValue (":path", folder.join ("/"));
 		Util::DBLock::Execute (QueryRemoveMessage_);
 
+		QueryRemoveMsgLocation_.bindValue (":msgId", msgId);
+		QueryRemoveMsgLocation_.bindValue (":path", folder.join ("/"));
+		Util::DBLock::Execute (QueryRemoveMsgLocation_);
+
 		if (continuation)
 			continuation ();
 
 		lock.Good ();
 	}
 
+	void AccountDatabase::SetMessageLocation (const QByteArray& msgId,
+			const QStringList& folder, const SegmentLocation& loc)
+	{
+		QuerySetMsgLocation_.bindValue (":folderId", AddFolder (folder));
+		QuerySetMsgLocation_.bindValue (":msgId", msgId);
+		QuerySetMsgLocation_.bindValue (":segment", loc.Segment_);
+		QuerySetMsgLocation_.bindValue (":offset", loc.Offset_);
+		QuerySetMsgLocation_.bindValue (":size", loc.Size_);
+		Util::DBLock::Execute (QuerySetMsgLocation_);
+	}
+
+	void AccountDatabase::UpdateMessageLocation (int locationId,
+			const SegmentLocation& from, const SegmentLocation& to)
+	{
+		QueryUpdateMsgLocation_.bindValue (":id", locationId);
+		QueryUpdateMsgLocation_.bindValue (":oldSegment", from.Segment_);
+		QueryUpdateMsgLocation_.bindValue (":oldOffset", from.Offset_);
+		QueryUpdateMsgLocation_.bindValue (":segment", to.Segment_);
+		QueryUpdateMsgLocation_.bindValue (":offset", to.Offset_);
+		QueryUpdateMsgLocation_.bindValue (":size", to.Size_);
+		Util::DBLock::Execute (QueryUpdateMsgLocation_);
+	}
+
+	namespace
+	{
+		SegmentLocation LocationFromQuery (const QSqlQuery& query, int startCol)
+		{
+			return
+			{
+				query.value (startCol).toInt (),
+				query.value (startCol + 1).toLongLong (),
+				query.value (startCol + 2).toLongLong ()
+			};
+		}
+	}
+
+	boost::optional<SegmentLocation> AccountDatabase::GetMessageLocation (const QByteArray& msgId, const QStringList& folder)
+	{
+		QueryGetMsgLocation_.bindValue (":msgId", msgId);
+		QueryGetMsgLocation_.bindValue (":path", folder.join ("/"));
+		Util::DBLock::Execute (QueryGetMsgLocation_);
+
+		boost::optional<SegmentLocation> result;
+		if (QueryGetMsgLocation_.next ())
+			result = LocationFromQuery (QueryGetMsgLocation_, 0);
+		QueryGetMsgLocation_.finish ();
+		return result;
+	}
+
+	QHash<QByteArray, SegmentLocation> AccountDatabase::GetMessageLocations (const QStringList& folder)
+	{
+		QueryGetFolderLocations_.bindValue (":path", folder.join ("/"));
+		Util::DBLock::Execute (QueryGetFolderLocations_);
+
+		QHash<QByteArray, SegmentLocation> result;
+		while (QueryGetFolderLocations_.next ())
+			result [QueryGetFolderLocations_.value (0).toByteArray ()] = LocationFromQuery (QueryGetFolderLocations_, 1);
+		QueryGetFolderLocations_.finish ();
+		return result;
+	}
+
+	QList<SegmentLocation> AccountDatabase::GetAllMessageLocations ()
+	{
+		Util::DBLock::Execute (QueryGetAllLocations_);
+
+		QList<SegmentLocation> result;
+		while (QueryGetAllLocations_.next ())
+			result << LocationFromQuery (QueryGetAllLocations_, 0);
+		QueryGetAllLocations_.finish ();
+		return result;
+	}
+
+	QList<QPair<int, SegmentLocation>> AccountDatabase::GetSegmentLocations (int segment)
+	{
+		QueryGetSegmentLocations_.bindValue (":segment", segment);
+		Util::DBLock::Execute (QueryGetSegmentLocations_);
+
+		QList<QPair<int, SegmentLocation>> result;
+		while (QueryGetSegmentLocations_.next ())
+			result << qMakePair (QueryGetSegmentLocations_.value (0).toInt (),
+					LocationFromQuery (QueryGetSegmentLocations_, 1));
+		QueryGetSegmentLocations_.finish ();
+		return result;
+	}
+
+	QHash<int, qint64> AccountDatabase::GetSegmentsUsage ()
+	{
+		Util::DBLock::Execute (QueryGetSegmentsUsage_);
+
+		QHash<int, qint64> result;
+		while (QueryGetSegmentsUsage_.next ())
+			result [QueryGetSegmentsUsage_.value (0).toInt ()] = QueryGetSegmentsUsage_.value (1).toLongLong ();
+		QueryGetSegmentsUsage_.finish ();
+		return result;
+	}
+
+	QList<QPair<int, SegmentLocation>> AccountDatabase::GetUnindexedMessageLocations (int afterId, int limit)
+	{
+		QueryGetUnindexedLocations_.bindValue (":afterId", afterId);
+		QueryGetUnindexedLocations_.bindValue (":limit", limit);
+		Util::DBLock::Execute (QueryGetUnindexedLocations_);
+
+		QList<QPair<int, SegmentLocation>> result;
+		while (QueryGetUnindexedLocations_.next ())
+			result << qMakePair (QueryGetUnindexedLocations_.value (0).toInt (),
+					LocationFromQuery (QueryGetUnindexedLocations_, 1));
+		QueryGetUnindexedLocations_.finish ();
+		return result;
+	}
+
+	QHash<QByteArray, bool> AccountDatabase::GetReadStatuses (const QStringList& folder)
+	{
+		QueryGetReadStatuses_.bindValue (":path", folder.join ("/"));
+		Util::DBLock::Execute (QueryGetReadStatuses_);
+
+		QHash<QByteArray, bool> result;
+		while (QueryGetReadStatuses_.next ())
+			result [QueryGetReadStatuses_.value (0).toByteArray ()] = QueryGetReadStatuses_.value (1).toBool ();
+		QueryGetReadStatuses_.finish ();
+		return result;
+	}
+
+	QList<MessageInfo> AccountDatabase::GetMessageInfos (const QStringList& folder, MessageListCursor& cursor, int limit)
+	{
+		QueryGetMsgInfos_.bindValue (":path", folder.join ("/"));
+		QueryGetMsgInfos_.bindValue (":isStart", cursor.IsStart_);
+		QueryGetMsgInfos_.bindValue (":lessDate", cursor.Date_);
+		QueryGetMsgInfos_.bindValue (":sameDate", cursor.Date_);
+		QueryGetMsgInfos_.bindValue (":id", cursor.Id_);
+		QueryGetMsgInfos_.bindValue (":limit", limit);
+		Util::DBLock::Execute (QueryGetMsgInfos_);
+
+		QList<MessageInfo> result;
+		while (QueryGetMsgInfos_.next ())
+		{
+			MessageInfo info;
+			info.FolderId_ = QueryGetMsgInfos_.value (0).toByteArray ();
+			info.MessageId_ = QueryGetMsgInfos_.value (1).toByteArray ();
+			info.IsRead_ = QueryGetMsgInfos_.value (2).toBool ();
+			info.From_ = QueryGetMsgInfos_.value (3).toString ();
+			info.Subject_ = QueryGetMsgInfos_.value (4).toString ();
+			info.Date_ = QDateTime::fromTime_t (QueryGetMsgInfos_.value (5).toUInt ());
+			info.Size_ = QueryGetMsgInfos_.value (6).toULongLong ();
+			info.HasAttachments_ = QueryGetMsgInfos_.value (7).toBool ();
+
+			for (const auto& ref : QueryGetMsgInfos_.value (8).toString ().split (' ', QString::SkipEmptyParts))
+				info.References_ << ref.toUtf8 ();
+
+			result << info;
+
+			cursor.IsStart_ = false;
+			cursor.Date_ = QueryGetMsgInfos_.value (9).toLongLong ();
+			cursor.Id_ = QueryGetMsgInfos_.value (10).toInt ();
+		}
+		QueryGetMsgInfos_.finish ();
+		return result;
+	}
+
+	void AccountDatabase::UpdateMessageInfo (const Message_ptr& msg)
+	{
+		Util::DBLock lock { *DB_ };
+		lock.Init ();
+
+		for (const auto& folder : msg->GetFolders ())
+			if (const auto tableId = GetMsgTableId (msg->GetFolderID (), folder))
+				SetMessageInfo (*tableId, msg);
+
+		lock.Good ();
+	}
+
+	bool AccountDatabase::HasMissingMessageInfos ()
+	{
+		Util::DBLock::Execute (QueryHasMissingInfos_);
+
+		const auto result = QueryHasMissingInfos_.next () &&
+				QueryHasMissingInfos_.value (0).toBool ();
+		QueryHasMissingInfos_.finish ();
+		return result;
+	}
+
+	QList<QPair<int, SegmentLocation>> AccountDatabase::GetMissingInfoMessageLocations (int afterId, int limit)
+	{
+		QueryGetMissingInfoLocations_.bindValue (":afterId", afterId);
+		QueryGetMissingInfoLocations_.bindValue (":limit", limit);
+		Util::DBLock::Execute (QueryGetMissingInfoLocations_);
+
+		QList<QPair<int, SegmentLocation>> result;
+		while (QueryGetMissingInfoLocations_.next ())
+			result << qMakePair (QueryGetMissingInfoLocations_.value (0).toInt (),
+					LocationFromQuery (QueryGetMissingInfoLocations_, 1));
+		QueryGetMissingInfoLocations_.finish ();
+		return result;
+	}
+
+	void AccountDatabase::AddPlaceholderMessageInfos ()
+	{
+		QSqlQuery query { *DB_ };
+		query.prepare (R"d(
+					INSERT INTO msgheaders
+					(MsgId, Date, Size, HasAttachments)
+					SELECT messages.Id, 0, 0, 0 FROM messages
+					LEFT JOIN msgheaders ON msgheaders.MsgId = messages.Id
+					WHERE msgheaders.MsgId IS NULL
+				)d");
+		Util::DBLock::Execute (query);
+	}
+
+	boost::optional<FolderSyncState> AccountDatabase::GetFolderSyncState (const QStringList& folder)
+	{
+		QueryGetSyncState_.bindValue (":path", folder.join ("/"));
+		Util::DBLock::Execute (QueryGetSyncState_);
+
+		boost::optional<FolderSyncState> result;
+		if (QueryGetSyncState_.next ())
+		{
+			FolderSyncState state;
+			state.UIDValidity_ = QueryGetSyncState_.value (0).toUInt ();
+			state.HighestModSeq_ = QueryGetSyncState_.value (1).toULongLong ();
+			state.UIDNext_ = QueryGetSyncState_.value (2).toUInt ();
+			result = state;
+		}
+		QueryGetSyncState_.finish ();
+		return result;
+	}
+
+	void AccountDatabase::SetFolderSyncState (const QStringList& folder, const FolderSyncState& state)
+	{
+		QuerySetSyncState_.bindValue (":folderId", AddFolder (folder));
+		QuerySetSyncState_.bindValue (":uidValidity", state.UIDValidity_);
+		QuerySetSyncState_.bindValue (":highestModSeq", state.HighestModSeq_);
+		QuerySetSyncState_.bindValue (":uidNext", state.UIDNext_);
+		Util::DBLock::Execute (QuerySetSyncState_);
+	}
+
+	namespace
+	{
+		QString JoinAddresses (const Message::Addresses_t& addrs)
+		{
+			QStringList result;
+			for (const auto& addr : addrs)
+				result << addr.first << addr.second;
+			return result.join (" ");
+		}
+
+		QString GetIndexedBody (const Message_ptr& msg)
+		{
+			const auto& body = msg->GetBody ();
+			if (!body.isEmpty ())
+				return body;
+
+			auto html = msg->GetHTMLBody ();
+			html.remove (QRegExp { "<[^>]*>" });
+			return html;
+		}
+
+		QString GetIndexedAttachments (const Message_ptr& msg)
+		{
+			const auto& atts = msg->GetAttachments ();
+			if (atts.isEmpty ())
+				return {};
+
+			QStringList result { AttachmentMarker };
+			for (const auto& att : atts)
+				result << att.GetName ();
+			return result.join (" ");
+		}
+	}
+
+	SearchIndexEntry MakeSearchIndexEntry (const Message_ptr& msg)
+	{
+		return
+		{
+			msg->GetFolderID (),
+			msg->GetFolders (),
+			JoinAddresses (msg->GetAddresses (Message::Address::From)),
+			JoinAddresses (msg->GetAddresses (Message::Address::To) +
+					msg->GetAddresses (Message::Address::Cc) +
+					msg->GetAddresses (Message::Address::Bcc)),
+			msg->GetSubject (),
+			GetIndexedBody (msg),
+			GetIndexedAttachments (msg)
+		};
+	}
+
+	void AccountDatabase::IndexMessage (const Message_ptr& msg)
+	{
+		IndexMessage (MakeSearchIndexEntry (msg));
+	}
+
+	void AccountDatabase::IndexMessage (const SearchIndexEntry& entry)
+	{
+		Util::DBLock lock { *DB_ };
+		lock.Init ();
+
+		for (const auto& folder : entry.Folders_)
+		{
+			QueryGetMsg2FolderId_.bindValue (":msgId", entry.MsgId_);
+			QueryGetMsg2FolderId_.bindValue (":path", folder.join ("/"));
+			Util::DBLock::Execute (QueryGetMsg2FolderId_);
+
+			const auto hasRow = QueryGetMsg2FolderId_.next ();
+			const auto docId = hasRow ? QueryGetMsg2FolderId_.value (0).toInt () : 0;
+			QueryGetMsg2FolderId_.finish ();
+			if (!hasRow)
+				continue;
+
+			QueryRemoveFromIndex_.bindValue (":msgId", entry.MsgId_);
+			QueryRemoveFromIndex_.bindValue (":path", folder.join ("/"));
+			Util::DBLock::Execute (QueryRemoveFromIndex_);
+
+			QueryAddToIndex_.bindValue (":docId", docId);
+			QueryAddToIndex_.bindValue (":sender", entry.Sender_);
+			QueryAddToIndex_.bindValue (":recipients", entry.Recipients_);
+			QueryAddToIndex_.bindValue (":subject", entry.Subject_);
+			QueryAddToIndex_.bindValue (":body", entry.Body_);
+			QueryAddToIndex_.bindValue (":attachments", entry.Attachments_);
+			Util::DBLock::Execute (QueryAddToIndex_);
+		}
+
+		lock.Good ();
+	}
+
+	QList<QByteArray> AccountDatabase::Search (const QStringList& folder, const QString& match, int offset, int limit)
+	{
+		QuerySearch_.bindValue (":match", match);
+		QuerySearch_.bindValue (":path", folder.join ("/"));
+		QuerySearch_.bindValue (":limit", limit);
+		QuerySearch_.bindValue (":offset", offset);
+		Util::DBLock::Execute (QuerySearch_);
+
+		QList<QByteArray> result;
+		while (QuerySearch_.next ())
+			result << QuerySearch_.value (0).toByteArray ();
+		QuerySearch_.finish ();
+		return result;
+	}
+
+	QSqlDatabase& AccountDatabase::GetDB () const
+	{
+		return *DB_;
+	}
+
 	int AccountDatabase::AddMessageUnfoldered (const Message_ptr& msg)
 	{
 		const auto& uniqueId = msg->GetMessageID ();
@@ -228,6 +581,26 @@ namespace Snails
 		QuerySetMsgRead_.bindValue (":id", tableId);
 		QuerySetMsgRead_.bindValue (":isRead", msg->IsRead ());
 		Util::DBLock::Execute (QuerySetMsgRead_);
+
+		SetMessageInfo (tableId, msg);
+	}
+
+	void AccountDatabase::SetMessageInfo (int tableId, const Message_ptr& msg)
+	{
+		const auto& info = GetMessageInfo (msg);
+
+		QStringList refs;
+		for (const auto& ref : info.References_)
+			refs << QString::fromUtf8 (ref);
+
+		QuerySetMsgInfo_.bindValue (":msgTableId", tableId);
+		QuerySetMsgInfo_.bindValue (":from", info.From_);
+		QuerySetMsgInfo_.bindValue (":subject", info.Subject_);
+		QuerySetMsgInfo_.bindValue (":date", static_cast<qlonglong> (info.Date_.toTime_t ()));
+		QuerySetMsgInfo_.bindValue (":size", info.Size_);
+		QuerySetMsgInfo_.bindValue (":hasAttachments", info.HasAttachments_);
+		QuerySetMsgInfo_.bindValue (":refs", refs.join (" "));
+		Util::DBLock::Execute (QuerySetMsgInfo_);
 	}
 
 	void AccountDatabase::AddMessageToFolder (int msgTableId, int folderTableId, const QByteArray& msgId)
@@ -265,6 +638,45 @@ namespace Snails
 					FolderMessageId TEXT NOT NULL
 					)
 				)d";
+		table2queries ["foldersync"] <<
+				R"d(
+					CREATE TABLE foldersync (
+					FolderId INTEGER PRIMARY KEY REFERENCES folders (Id) ON DELETE CASCADE,
+					UIDValidity INTEGER NOT NULL,
+					HighestModSeq INTEGER NOT NULL,
+					UIDNext INTEGER NOT NULL
+					)
+				)d";
+		table2queries ["msgheaders"] <<
+				R"d(
+					CREATE TABLE msgheaders (
+					MsgId INTEGER PRIMARY KEY REFERENCES messages (Id) ON DELETE CASCADE,
+					FromName TEXT,
+					Subject TEXT,
+					Date INTEGER NOT NULL,
+					Size INTEGER NOT NULL,
+					HasAttachments BOOL NOT NULL,
+					Refs TEXT
+					);
+				)d" <<
+				R"d(
+					CREATE INDEX idx_msgheaders_date ON msgheaders (Date);
+				)d";
+		table2queries ["msg2segment"] <<
+				R"d(
+					CREATE TABLE msg2segment (
+					Id INTEGER PRIMARY KEY AUTOINCREMENT,
+					FolderId INTEGER NOT NULL REFERENCES folders (Id) ON DELETE CASCADE,
+					FolderMessageId TEXT NOT NULL,
+					Segment INTEGER NOT NULL,
+					Offset INTEGER NOT NULL,
+					Size INTEGER NOT NULL,
+					UNIQUE (FolderId, FolderMessageId) ON CONFLICT REPLACE
+					)
+				)d" <<
+				R"d(
+					CREATE INDEX idx_msg2segment_segment ON msg2segment (Segment, Offset);
+				)d";
 
 		QSqlQuery query { *DB_ };
 		for (const auto& pair : Util::Stlize (table2queries))
@@ -278,6 +690,50 @@ namespace Snails
 
 		query.exec ("PRAGMA foreign_keys = ON;");
 		query.exec ("PRAGMA synchronous = OFF;");
+
+		// Older databases have been created without this index.
+		if (!query.exec ("CREATE INDEX IF NOT EXISTS idx_msg2folder_folder ON msg2folder (FolderId);"))
+			Util::DBLock::DumpError (query);
+
+		if (!DB_->tables ().contains ("msgsearch"))
+			InitSearchTable ();
+	}
+
+	void AccountDatabase::InitSearchTable ()
+	{
+		/* The docid of a row in the index is the ID of the corresponding
+		 * msg2folder row, so a message is indexed once per folder.
+		 *
+		 * The unicode61 tokenizer may be unavailable in older SQLite
+		 * versions, so the default one is used as a fallback.
+		 */
+		const QString createTemplate
+		{
+			R"d(
+				CREATE VIRTUAL TABLE msgsearch USING fts4 (
+				Sender,
+				Recipients,
+				Subject,
+				Body,
+				Attachments%1
+				);
+			)d"
+		};
+
+		QSqlQuery query { *DB_ };
+		if (query.exec (createTemplate.arg (", tokenize=unicode61")))
+			return;
+
+		qWarning () << Q_FUNC_INFO
+				<< "unable to create the index with the unicode61 tokenizer, falling back to the default one";
+		if (!query.exec (createTemplate.arg (QString {})))
+		{
+			Util::DBLock::DumpError (query);
+			throw std::runtime_error ("Query execution failed for search index creation.");
+		}
+
+		// The messages stored before the index has been introduced are
+		// indexed by the storage maintenance, see FillSearchIndex().
 	}
 
 	void AccountDatabase::PrepareQueries ()
@@ -358,6 +814,188 @@ namespace Snails
 					VALUES
 					(:msgTableId, :folderId, :msgId)
 				)d");
+
+		QuerySetMsgLocation_ = QSqlQuery { *DB_ };
+		QuerySetMsgLocation_.prepare (R"d(
+					INSERT INTO msg2segment
+					(FolderId, FolderMessageId, Segment, Offset, Size)
+					VALUES
+					(:folderId, :msgId, :segment, :offset, :size)
+				)d");
+
+		QueryUpdateMsgLocation_ = QSqlQuery { *DB_ };
+		QueryUpdateMsgLocation_.prepare (R"d(
+					UPDATE msg2segment
+					SET Segment = :segment, Offset = :offset, Size = :size
+					WHERE Id = :id AND Segment = :oldSegment AND Offset = :oldOffset
+				)d");
+
+		QueryGetMsgLocation_ = QSqlQuery { *DB_ };
+		QueryGetMsgLocation_.prepare (R"d(
+					SELECT msg2segment.Segment, msg2segment.Offset, msg2segment.Size
+					FROM msg2segment, folders
+					WHERE msg2segment.FolderId = folders.Id
+					AND folders.FolderPath = :path
+					AND msg2segment.FolderMessageId = :msgId
+				)d");
+
+		QueryGetFolderLocations_ = QSqlQuery { *DB_ };
+		QueryGetFolderLocations_.prepare (R"d(
+					SELECT msg2segment.FolderMessageId, msg2segment.Segment, msg2segment.Offset, msg2segment.Size
+					FROM msg2segment, folders
+					WHERE msg2segment.FolderId = folders.Id
+					AND folders.FolderPath = :path
+				)d");
+
+		QueryGetAllLocations_ = QSqlQuery { *DB_ };
+		QueryGetAllLocations_.prepare (R"d(
+					SELECT Segment, Offset, Size FROM msg2segment
+					ORDER BY Segment, Offset
+				)d");
+
+		QueryGetSegmentLocations_ = QSqlQuery { *DB_ };
+		QueryGetSegmentLocations_.prepare (R"d(
+					SELECT Id, Segment, Offset, Size FROM msg2segment
+					WHERE Segment = :segment
+					ORDER BY Offset
+				)d");
+
+		QueryGetSegmentsUsage_ = QSqlQuery { *DB_ };
+		QueryGetSegmentsUsage_.prepare (R"d(
+					SELECT Segment, SUM(Size) FROM msg2segment
+					GROUP BY Segment
+				)d");
+
+		QueryGetUnindexedLocations_ = QSqlQuery { *DB_ };
+		QueryGetUnindexedLocations_.prepare (R"d(
+					SELECT msg2folder.Id, msg2segment.Segment, msg2segment.Offset, msg2segment.Size
+					FROM msg2folder
+					JOIN msg2segment ON msg2segment.FolderId = msg2folder.FolderId
+						AND msg2segment.FolderMessageId = msg2folder.FolderMessageId
+					LEFT JOIN msgsearch ON msgsearch.docid = msg2folder.Id
+					WHERE msg2folder.Id > :afterId
+					AND msgsearch.docid IS NULL
+					ORDER BY msg2folder.Id
+					LIMIT :limit
+				)d");
+
+		QueryGetReadStatuses_ = QSqlQuery { *DB_ };
+		QueryGetReadStatuses_.prepare (R"d(
+					SELECT msg2folder.FolderMessageId, messages.IsRead
+					FROM msg2folder, folders, messages
+					WHERE folders.FolderPath = :path
+					AND folders.Id = msg2folder.FolderId
+					AND messages.Id = msg2folder.MsgId
+				)d");
+
+		QueryGetSyncState_ = QSqlQuery { *DB_ };
+		QueryGetSyncState_.prepare (R"d(
+					SELECT foldersync.UIDValidity, foldersync.HighestModSeq, foldersync.UIDNext
+					FROM foldersync, folders
+					WHERE folders.FolderPath = :path
+					AND folders.Id = foldersync.FolderId
+				)d");
+
+		QuerySetSyncState_ = QSqlQuery { *DB_ };
+		QuerySetSyncState_.prepare (R"d(
+					INSERT OR REPLACE INTO foldersync
+					(FolderId, UIDValidity, HighestModSeq, UIDNext)
+					VALUES
+					(:folderId, :uidValidity, :highestModSeq, :uidNext)
+				)d");
+
+		QuerySetMsgInfo_ = QSqlQuery { *DB_ };
+		QuerySetMsgInfo_.prepare (R"d(
+					INSERT OR REPLACE INTO msgheaders
+					(MsgId, FromName, Subject, Date, Size, HasAttachments, Refs)
+					VALUES
+					(:msgTableId, :from, :subject, :date, :size, :hasAttachments, :refs)
+				)d");
+
+		QueryGetMsgInfos_ = QSqlQuery { *DB_ };
+		QueryGetMsgInfos_.prepare (R"d(
+					SELECT msg2folder.FolderMessageId, messages.UniqueId, messages.IsRead,
+						msgheaders.FromName, msgheaders.Subject, msgheaders.Date,
+						msgheaders.Size, msgheaders.HasAttachments, msgheaders.Refs,
+						IFNULL(msgheaders.Date, 0) AS SortDate, msg2folder.Id
+					FROM msg2folder
+					JOIN folders ON folders.Id = msg2folder.FolderId
+					JOIN messages ON messages.Id = msg2folder.MsgId
+					LEFT JOIN msgheaders ON msgheaders.MsgId = msg2folder.MsgId
+					WHERE folders.FolderPath = :path
+					AND (:isStart
+						OR SortDate < :lessDate
+						OR (SortDate = :sameDate AND msg2folder.Id < :id))
+					ORDER BY SortDate DESC, msg2folder.Id DESC
+					LIMIT :limit
+				)d");
+
+		QueryHasMissingInfos_ = QSqlQuery { *DB_ };
+		QueryHasMissingInfos_.prepare (R"d(
+					SELECT EXISTS (SELECT 1 FROM messages
+						LEFT JOIN msgheaders ON msgheaders.MsgId = messages.Id
+						WHERE msgheaders.MsgId IS NULL)
+				)d");
+
+		QueryGetMissingInfoLocations_ = QSqlQuery { *DB_ };
+		QueryGetMissingInfoLocations_.prepare (R"d(
+					SELECT msg2folder.Id, msg2segment.Segment, msg2segment.Offset, msg2segment.Size
+					FROM msg2folder
+					JOIN msg2segment ON msg2segment.FolderId = msg2folder.FolderId
+						AND msg2segment.FolderMessageId = msg2folder.FolderMessageId
+					LEFT JOIN msgheaders ON msgheaders.MsgId = msg2folder.MsgId
+					WHERE msg2folder.Id > :afterId
+					AND msgheaders.MsgId IS NULL
+					ORDER BY msg2folder.Id
+					LIMIT :limit
+				)d");
+
+		QueryGetMsg2FolderId_ = QSqlQuery { *DB_ };
+		QueryGetMsg2FolderId_.prepare (R"d(
+					SELECT msg2folder.Id FROM msg2folder, folders
+					WHERE msg2folder.FolderId = folders.Id
+					AND folders.FolderPath = :path
+					AND msg2folder.FolderMessageId = :msgId
+				)d");
+
+		QueryRemoveFromIndex_ = QSqlQuery { *DB_ };
+		QueryRemoveFromIndex_.prepare (R"d(
+					DELETE FROM msgsearch
+					WHERE docid =
+						(SELECT msg2folder.Id
+							FROM msg2folder, folders
+							WHERE msg2folder.FolderMessageId = :msgId
+							AND folders.FolderPath = :path
+							AND msg2folder.FolderId = folders.Id)
+				)d");
+
+		QueryAddToIndex_ = QSqlQuery { *DB_ };
+		QueryAddToIndex_.prepare (R"d(
+					INSERT INTO msgsearch
+					(docid, Sender, Recipients, Subject, Body, Attachments)
+					VALUES
+					(:docId, :sender, :recipients, :subject, :body, :attachments)
+				)d");
+
+		QuerySearch_ = QSqlQuery { *DB_ };
+		QuerySearch_.prepare (R"d(
+					SELECT msg2folder.FolderMessageId
+					FROM msgsearch
+					JOIN msg2folder ON msg2folder.Id = msgsearch.docid
+					JOIN folders ON folders.Id = msg2folder.FolderId
+					LEFT JOIN msgheaders ON msgheaders.MsgId = msg2folder.MsgId
+					WHERE msgsearch MATCH :match
+					AND folders.FolderPath = :path
+					ORDER BY IFNULL(msgheaders.Date, 0) DESC, msg2folder.Id DESC
+					LIMIT :limit OFFSET :offset
+				)d");
+
+		QueryRemoveMsgLocation_ = QSqlQuery { *DB_ };
+		QueryRemoveMsgLocation_.prepare (R"d(
+					DELETE FROM msg2segment
+					WHERE FolderMessageId = :msgId
+					AND FolderId = (SELECT Id FROM folders WHERE FolderPath = :path)
+				)d");
 	}
 
 	int AccountDatabase::AddFolder (const QStringList& folder)
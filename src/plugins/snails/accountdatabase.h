@@ -35,6 +35,10 @@
 #include <QSqlQuery>
 #include <QStringList>
 #include <QMap>
+#include <QHash>
+#include "segmentstore.h"
+#include "incrementalsync.h"
+#include "messageinfo.h"
 
 class QSqlDatabase;
 typedef std::shared_ptr<QSqlDatabase> QSqlDatabase_ptr;
@@ -45,11 +49,27 @@ namespace LeechCraft
 {
 namespace Snails
 {
-	class Account;
-
 	class Message;
 	typedef std::shared_ptr<Message> Message_ptr;
 
+	/* The full-text search index columns of a message. Building them
+	 * involves stripping the HTML body, so it is done by the workers
+	 * that already have the message, via MakeSearchIndexEntry().
+	 */
+	struct SearchIndexEntry
+	{
+		QByteArray MsgId_;
+		QList<QStringList> Folders_;
+
+		QString Sender_;
+		QString Recipients_;
+		QString Subject_;
+		QString Body_;
+		QString Attachments_;
+	};
+
+	SearchIndexEntry MakeSearchIndexEntry (const Message_ptr&);
+
 	class AccountDatabase : public QObject
 	{
 		const QSqlDatabase_ptr DB_;
@@ -76,9 +96,38 @@ namespace Snails
 		QSqlQuery QueryAddMsgUnfoldered_;
 		QSqlQuery QueryAddMsgToFolder_;
 
+		QSqlQuery QuerySetMsgLocation_;
+		QSqlQuery QueryUpdateMsgLocation_;
+		QSqlQuery QueryGetMsgLocation_;
+		QSqlQuery QueryGetFolderLocations_;
+		QSqlQuery QueryGetAllLocations_;
+		QSqlQuery QueryGetSegmentLocations_;
+		QSqlQuery QueryGetSegmentsUsage_;
+		QSqlQuery QueryGetUnindexedLocations_;
+		QSqlQuery QueryGetMissingInfoLocations_;
+		QSqlQuery QueryRemoveMsgLocation_;
+
+		QSqlQuery QueryGetReadStatuses_;
+		QSqlQuery QueryGetSyncState_;
+		QSqlQuery QuerySetSyncState_;
+
+		QSqlQuery QuerySetMsgInfo_;
+		QSqlQuery QueryGetMsgInfos_;
+		QSqlQuery QueryHasMissingInfos_;
+
+		QSqlQuery QueryGetMsg2FolderId_;
+		QSqlQuery QueryRemoveFromIndex_;
+		QSqlQuery QueryAddToIndex_;
+		QSqlQuery QuerySearch_;
+
 		QMap<QStringList, int> KnownFolders_;
 	public:
-		AccountDatabase (const QDir&, Account*, QObject* = nullptr);
+		/* Opens the database of the account in the given directory via
+		 * the connection with the given name, which should be unique for
+		 * each thread the database is used from. The connection is not
+		 * removed when the object is destroyed.
+		 */
+		AccountDatabase (const QDir&, const QString& connectionName, QObject* = nullptr);
 
 		QList<QByteArray> GetIDs (const QStringList& folder);
 		int GetMessageCount (const QStringList& folder);
@@ -91,12 +140,88 @@ namespace Snails
 
 		boost::optional<int> GetMsgTableId (const QByteArray& uniqueId);
 		boost::optional<int> GetMsgTableId (const QByteArray& msgId, const QStringList& folder);
+
+		void SetMessageLocation (const QByteArray& msgId, const QStringList& folder, const SegmentLocation&);
+		/* Moves the location with the given ID from the old place to the
+		 * new one, unless it has been changed or removed in the meantime.
+		 */
+		void UpdateMessageLocation (int locationId, const SegmentLocation& from, const SegmentLocation& to);
+		boost::optional<SegmentLocation> GetMessageLocation (const QByteArray& msgId, const QStringList& folder);
+		QHash<QByteArray, SegmentLocation> GetMessageLocations (const QStringList& folder);
+		QList<SegmentLocation> GetAllMessageLocations ();
+
+		/* Returns the list of (location ID, location) pairs for the given
+		 * segment, suitable for passing to UpdateMessageLocation().
+		 */
+		QList<QPair<int, SegmentLocation>> GetSegmentLocations (int segment);
+
+		/* Returns the number of bytes referenced by the index in each
+		 * segment.
+		 */
+		QHash<int, qint64> GetSegmentsUsage ();
+
+		/* Returns at most limit (ID, location) pairs of the stored
+		 * messages that are missing from the full-text search index,
+		 * starting after the given ID, in the order of IDs. The IDs are
+		 * opaque and only useful for passing back as afterId.
+		 */
+		QList<QPair<int, SegmentLocation>> GetUnindexedMessageLocations (int afterId, int limit);
+
+		QHash<QByteArray, bool> GetReadStatuses (const QStringList& folder);
+
+		/* Returns at most limit message list entries of the given folder
+		 * following the cursor, newest first, and advances the cursor
+		 * past them.
+		 */
+		QList<MessageInfo> GetMessageInfos (const QStringList& folder, MessageListCursor& cursor, int limit);
+
+		/* Updates the message list entry for an already stored message.
+		 * AddMessage() takes care of this for new and updated messages,
+		 * so this is only needed to fill the entries for the messages
+		 * stored before the entries have been introduced.
+		 */
+		void UpdateMessageInfo (const Message_ptr&);
+
+		/* Returns whether there are stored messages without message list
+		 * entries.
+		 */
+		bool HasMissingMessageInfos ();
+
+		/* Returns at most limit (ID, location) pairs of the stored
+		 * messages without message list entries, starting after the
+		 * given ID, in the order of IDs, like
+		 * GetUnindexedMessageLocations() does.
+		 */
+		QList<QPair<int, SegmentLocation>> GetMissingInfoMessageLocations (int afterId, int limit);
+
+		/* Adds empty message list entries for the messages still having
+		 * none, like the ones whose contents are missing from the store.
+		 */
+		void AddPlaceholderMessageInfos ();
+
+		boost::optional<FolderSyncState> GetFolderSyncState (const QStringList& folder);
+		void SetFolderSyncState (const QStringList& folder, const FolderSyncState&);
+
+		/* Puts the message into the full-text search index of each
+		 * folder it belongs to, replacing the previously indexed data.
+		 */
+		void IndexMessage (const Message_ptr&);
+		void IndexMessage (const SearchIndexEntry&);
+
+		/* Returns at most limit IDs of messages in the given folder
+		 * matching the given FTS4 MATCH expression, newest first.
+		 */
+		QList<QByteArray> Search (const QStringList& folder, const QString& match, int offset, int limit);
+
+		QSqlDatabase& GetDB () const;
 	private:
 		int AddMessageUnfoldered (const Message_ptr&);
 		void UpdateMessage (int, const Message_ptr&);
+		void SetMessageInfo (int, const Message_ptr&);
 		void AddMessageToFolder (int msgTableId, int folderTableId, const QByteArray& msgId);
 
 		void InitTables ();
+		void InitSearchTable ();
 		void PrepareQueries ();
 
 		int AddFolder (const QStringList&);
@@ -114,6 +114,10 @@ namespace Snails
 				SIGNAL (folderSyncFinished (QStringList, QByteArray)),
 				A_,
 				SLOT (handleFolderSyncFinished (QStringList, QByteArray)));
+		connect (W_,
+				SIGNAL (gotFolderSyncState (QStringList, LeechCraft::Snails::FolderSyncState)),
+				A_,
+				SLOT (handleFolderSyncState (QStringList, LeechCraft::Snails::FolderSyncState)));
 	}
 }
 }
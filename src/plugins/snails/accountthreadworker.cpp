@@ -621,19 +621,12 @@ namespace Snails
 		if (!messages.size ())
 			return {};
 
-		const int desiredFlags = vmime::net::fetchAttributes::FLAGS |
-					vmime::net::fetchAttributes::SIZE |
-					vmime::net::fetchAttributes::UID |
-					vmime::net::fetchAttributes::FULL_HEADER |
-					vmime::net::fetchAttributes::STRUCTURE |
-					vmime::net::fetchAttributes::ENVELOPE;
-
 		try
 		{
 			const auto& context = tr ("Fetching headers for %1")
 					.arg (A_->GetName ());
 
-			folder->fetchMessages (messages, desiredFlags, MkPgListener (context));
+			FetchMessageHeaders (folder, messages, MkPgListener (context));
 		}
 		catch (const vmime::exceptions::operation_not_supported& ons)
 		{
@@ -661,6 +654,69 @@ namespace Snails
 		return newMessages;
 	}
 
+	bool AccountThreadWorker::SyncFolderIncrementally (const QStringList& folderName, const VmimeFolder_ptr& folder)
+	{
+		const auto storage = Core::Instance ().GetStorage ();
+
+		IncrementalSyncPlan plan;
+		try
+		{
+			const auto& context = tr ("Fetching flags for %1")
+					.arg (A_->GetName ());
+			plan = FetchIncrementalSyncPlan (folder,
+					storage->LoadReadStatuses (A_, folderName),
+					MkPgListener (context));
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to fetch flags for"
+					<< folderName
+					<< e.what ();
+			return false;
+		}
+
+		qDebug () << Q_FUNC_INFO
+				<< folderName
+				<< "new:"
+				<< plan.New_.size ()
+				<< "vanished:"
+				<< plan.Vanished_.size ()
+				<< "changed:"
+				<< plan.ReadChanged_.size ();
+
+		if (!plan.New_.isEmpty ())
+		{
+			MessageVector_t newMessages;
+			try
+			{
+				newMessages = GetMessagesByUIDs (folder, plan.New_);
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "cannot get new messages because:"
+						<< e.what ();
+				return false;
+			}
+
+			emit gotMsgHeaders (FetchVmimeMessages (newMessages, folder, folderName), folderName);
+		}
+
+		if (!plan.ReadChanged_.isEmpty ())
+		{
+			auto updated = storage->LoadMessages (A_, folderName, plan.ReadChanged_.keys ());
+			for (const auto& msg : updated)
+				msg->SetRead (plan.ReadChanged_.value (msg->GetFolderID ()));
+			emit gotUpdatedMessages (updated, folderName);
+		}
+
+		if (!plan.Vanished_.isEmpty ())
+			emit gotMessagesRemoved (plan.Vanished_, folderName);
+
+		return true;
+	}
+
 	void AccountThreadWorker::FetchMessagesInFolder (const QStringList& folderName,
 			const VmimeFolder_ptr& folder, const QByteArray& lastId)
 	{
@@ -675,6 +731,40 @@ namespace Snails
 
 		qDebug () << Q_FUNC_INFO << folderName << folder.get () << lastId;
 
+		int serverCount = 0;
+		boost::optional<FolderSyncState> serverState;
+		if (lastId.isEmpty ())
+			serverState = GetServerSyncState (folder, serverCount);
+
+		if (serverState)
+		{
+			const auto storage = Core::Instance ().GetStorage ();
+			const auto& storedState = storage->GetFolderSyncState (A_, folderName);
+			const auto localCount = storage->GetNumMessages (A_, folderName);
+
+			switch (ChooseSyncMode (storedState, *serverState, serverCount, localCount))
+			{
+			case SyncMode::UpToDate:
+				qDebug () << Q_FUNC_INFO
+						<< folderName
+						<< "is up to date";
+				return;
+			case SyncMode::Incremental:
+				if (SyncFolderIncrementally (folderName, folder))
+				{
+					emit gotFolderSyncState (folderName, *serverState);
+					return;
+				}
+				qWarning () << Q_FUNC_INFO
+						<< "incremental sync failed for"
+						<< folderName
+						<< "falling back to full sync";
+				break;
+			case SyncMode::Full:
+				break;
+			}
+		}
+
 		auto messages = GetMessagesInFolder (folder, lastId);
 		auto newMessages = FetchVmimeMessages (messages, folder, folderName);
 		auto existing = Core::Instance ().GetStorage ()->LoadIDs (A_, folderName);
@@ -724,6 +814,9 @@ namespace Snails
 
 		if (lastId.isEmpty ())
 			emit gotMessagesRemoved (existing, folderName);
+
+		if (serverState)
+			emit gotFolderSyncState (folderName, *serverState);
 	}
 
 	namespace
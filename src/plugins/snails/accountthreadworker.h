@@ -40,6 +40,7 @@
 #include "progresslistener.h"
 #include "message.h"
 #include "account.h"
+#include "foldersyncfetcher.h"
 
 class QTimer;
 
@@ -52,8 +53,6 @@ namespace Snails
 
 	struct Folder;
 
-	using MessageVector_t = std::vector<vmime::shared_ptr<vmime::net::message>>;
-	using VmimeFolder_ptr = vmime::shared_ptr<vmime::net::folder>;
 	using CertList_t = std::vector<vmime::shared_ptr<vmime::security::cert::X509Certificate>>;
 
 	class AccountThreadWorker : public QObject
@@ -97,6 +96,7 @@ namespace Snails
 		void FetchMessagesIMAP (const QList<QStringList>&, const QByteArray&);
 		QList<Message_ptr> FetchVmimeMessages (MessageVector_t, const VmimeFolder_ptr&, const QStringList&);
 		void FetchMessagesInFolder (const QStringList&, const VmimeFolder_ptr&, const QByteArray&);
+		bool SyncFolderIncrementally (const QStringList&, const VmimeFolder_ptr&);
 
 		void SyncIMAPFolders (vmime::shared_ptr<vmime::net::store>);
 		QList<Message_ptr> FetchFullMessages (const std::vector<vmime::shared_ptr<vmime::net::message>>&);
@@ -154,6 +154,8 @@ namespace Snails
 		void gotFolders (const QList<LeechCraft::Snails::Folder>&);
 
 		void folderSyncFinished (const QStringList& folder, const QByteArray& lastRequestedId);
+
+		void gotFolderSyncState (const QStringList& folder, const LeechCraft::Snails::FolderSyncState& state);
 	};
 }
 }
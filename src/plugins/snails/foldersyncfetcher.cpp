@@ -0,0 +1,110 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "foldersyncfetcher.h"
+#include <QtDebug>
+#include <vmime/net/imap/IMAPFolderStatus.hpp>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	boost::optional<FolderSyncState> GetServerSyncState (const VmimeFolder_ptr& folder, int& count)
+	{
+		try
+		{
+			const auto& status = vmime::dynamicCast<vmime::net::imap::IMAPFolderStatus> (folder->getStatus ());
+			if (!status)
+				return {};
+
+			count = status->getMessageCount ();
+
+			FolderSyncState state;
+			state.UIDValidity_ = status->getUIDValidity ();
+			state.HighestModSeq_ = status->getHighestModSeq ();
+			state.UIDNext_ = status->getUIDNext ();
+			return state;
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to get folder status:"
+					<< e.what ();
+			return {};
+		}
+	}
+
+	IncrementalSyncPlan FetchIncrementalSyncPlan (const VmimeFolder_ptr& folder,
+			const QHash<QByteArray, bool>& localStatuses,
+			vmime::utility::progressListener *listener)
+	{
+		auto messages = folder->getMessages (vmime::net::messageSet::byUID ("1", "*"));
+		folder->fetchMessages (messages,
+				vmime::net::fetchAttributes::FLAGS | vmime::net::fetchAttributes::UID,
+				listener);
+
+		QHash<QByteArray, bool> serverStatuses;
+		for (const auto& msg : messages)
+		{
+			const QByteArray uid { static_cast<vmime::string> (msg->getUID ()).c_str () };
+			serverStatuses [uid] = msg->getFlags () & vmime::net::message::FLAG_SEEN;
+		}
+
+		return PlanIncrementalSync (localStatuses, serverStatuses);
+	}
+
+	MessageVector_t GetMessagesByUIDs (const VmimeFolder_ptr& folder, const QList<QByteArray>& uids)
+	{
+		if (uids.isEmpty ())
+			return {};
+
+		std::vector<vmime::net::message::uid> vmimeUids;
+		vmimeUids.reserve (uids.size ());
+		for (const auto& uid : uids)
+			vmimeUids.push_back (uid.constData ());
+
+		return folder->getMessages (vmime::net::messageSet::byUID (vmimeUids));
+	}
+
+	void FetchMessageHeaders (const VmimeFolder_ptr& folder, MessageVector_t& messages,
+			vmime::utility::progressListener *listener)
+	{
+		if (messages.empty ())
+			return;
+
+		const int desiredFlags = vmime::net::fetchAttributes::FLAGS |
+					vmime::net::fetchAttributes::SIZE |
+					vmime::net::fetchAttributes::UID |
+					vmime::net::fetchAttributes::FULL_HEADER |
+					vmime::net::fetchAttributes::STRUCTURE |
+					vmime::net::fetchAttributes::ENVELOPE;
+		folder->fetchMessages (messages, desiredFlags, listener);
+	}
+}
+}
@@ -0,0 +1,85 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+#include <boost/optional.hpp>
+#include <vmime/net/message.hpp>
+#include <vmime/net/folder.hpp>
+#include "incrementalsync.h"
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	using MessageVector_t = std::vector<vmime::shared_ptr<vmime::net::message>>;
+	using VmimeFolder_ptr = vmime::shared_ptr<vmime::net::folder>;
+
+	/* The server-facing steps of the folder sync. They only talk to the
+	 * given opened folder and don't touch the account or the storage,
+	 * so they can be run against any IMAP server.
+	 */
+
+	/** Returns the sync state of the folder from its STATUS, storing the
+	 * number of messages in the folder to count, or an empty optional if
+	 * the status is unavailable.
+	 */
+	boost::optional<FolderSyncState> GetServerSyncState (const VmimeFolder_ptr& folder, int& count);
+
+	/** Fetches the UIDs and flags (but nothing else) of all the messages
+	 * in the folder and plans the incremental sync against the locally
+	 * known read statuses.
+	 *
+	 * Throws on network or protocol errors.
+	 */
+	IncrementalSyncPlan FetchIncrementalSyncPlan (const VmimeFolder_ptr& folder,
+			const QHash<QByteArray, bool>& localStatuses,
+			vmime::utility::progressListener *listener = nullptr);
+
+	/** Returns the messages with the given UIDs without fetching any of
+	 * their attributes.
+	 *
+	 * Throws on network or protocol errors.
+	 */
+	MessageVector_t GetMessagesByUIDs (const VmimeFolder_ptr& folder, const QList<QByteArray>& uids);
+
+	/** Fetches everything needed to show the messages in the message
+	 * list (headers, envelope, structure, flags and size) in a single
+	 * request.
+	 *
+	 * Throws on network or protocol errors.
+	 */
+	void FetchMessageHeaders (const VmimeFolder_ptr& folder, MessageVector_t& messages,
+			vmime::utility::progressListener *listener = nullptr);
+}
+}
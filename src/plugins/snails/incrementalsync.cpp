@@ -0,0 +1,92 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "incrementalsync.h"
+#include <algorithm>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	bool operator== (const FolderSyncState& s1, const FolderSyncState& s2)
+	{
+		return s1.UIDValidity_ == s2.UIDValidity_ &&
+				s1.HighestModSeq_ == s2.HighestModSeq_ &&
+				s1.UIDNext_ == s2.UIDNext_;
+	}
+
+	SyncMode ChooseSyncMode (const boost::optional<FolderSyncState>& stored,
+			const FolderSyncState& server, int serverCount, int localCount)
+	{
+		if (!stored ||
+				!server.UIDValidity_ ||
+				stored->UIDValidity_ != server.UIDValidity_)
+			return SyncMode::Full;
+
+		// Without CONDSTORE flag changes can't be detected, so the
+		// flags should be refetched anyway.
+		if (server.HighestModSeq_ &&
+				*stored == server &&
+				serverCount == localCount)
+			return SyncMode::UpToDate;
+
+		return SyncMode::Incremental;
+	}
+
+	bool IncrementalSyncPlan::IsEmpty () const
+	{
+		return New_.isEmpty () && Vanished_.isEmpty () && ReadChanged_.isEmpty ();
+	}
+
+	IncrementalSyncPlan PlanIncrementalSync (const QHash<QByteArray, bool>& local,
+			const QHash<QByteArray, bool>& server)
+	{
+		IncrementalSyncPlan plan;
+
+		for (auto i = server.begin (), end = server.end (); i != end; ++i)
+		{
+			const auto localPos = local.find (i.key ());
+			if (localPos == local.end ())
+				plan.New_ << i.key ();
+			else if (*localPos != *i)
+				plan.ReadChanged_ [i.key ()] = *i;
+		}
+
+		for (auto i = local.begin (), end = local.end (); i != end; ++i)
+			if (!server.contains (i.key ()))
+				plan.Vanished_ << i.key ();
+
+		std::sort (plan.New_.begin (), plan.New_.end (),
+				[] (const QByteArray& left, const QByteArray& right)
+					{ return left.toULongLong () < right.toULongLong (); });
+
+		return plan;
+	}
+}
+}
@@ -0,0 +1,108 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+#include <QMetaType>
+#include <boost/optional.hpp>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	/** The IMAP state of a folder as of the last successful sync.
+	 */
+	struct FolderSyncState
+	{
+		quint32 UIDValidity_ = 0;
+
+		/** HIGHESTMODSEQ of the folder, or 0 if the server doesn't
+		 * support CONDSTORE.
+		 */
+		quint64 HighestModSeq_ = 0;
+
+		quint32 UIDNext_ = 0;
+	};
+
+	bool operator== (const FolderSyncState&, const FolderSyncState&);
+
+	enum class SyncMode
+	{
+		/** Fetch the headers of all the messages in the folder.
+		 */
+		Full,
+
+		/** Nothing has changed since the last sync.
+		 */
+		UpToDate,
+
+		/** Fetch just the UIDs and flags of the messages to find out
+		 * the vanished messages and flag changes, and fetch the headers
+		 * of the new messages only.
+		 */
+		Incremental
+	};
+
+	SyncMode ChooseSyncMode (const boost::optional<FolderSyncState>& stored,
+			const FolderSyncState& server, int serverCount, int localCount);
+
+	struct IncrementalSyncPlan
+	{
+		/** The UIDs of the messages whose headers should be fetched,
+		 * in ascending order.
+		 */
+		QList<QByteArray> New_;
+
+		/** The UIDs of the locally stored messages that are no longer
+		 * present on the server.
+		 */
+		QList<QByteArray> Vanished_;
+
+		/** The UIDs of the messages whose read status has changed,
+		 * mapped to the new status.
+		 */
+		QHash<QByteArray, bool> ReadChanged_;
+
+		bool IsEmpty () const;
+	};
+
+	/** Builds the incremental sync plan by comparing the read statuses
+	 * of locally stored messages with the ones on the server.
+	 *
+	 * Both hashes are keyed by message UIDs.
+	 */
+	IncrementalSyncPlan PlanIncrementalSync (const QHash<QByteArray, bool>& local,
+			const QHash<QByteArray, bool>& server);
+}
+}
+
+Q_DECLARE_METATYPE (LeechCraft::Snails::FolderSyncState)
@@ -29,19 +29,22 @@
 
 #include "mailmodel.h"
 #include <QIcon>
+#include <QtConcurrentRun>
+#include <QFutureWatcher>
 #include <util/util.h>
-#include <util/sll/prelude.h>
 #include <interfaces/core/iiconthememanager.h>
 #include "core.h"
+#include "storage.h"
 #include "messagelistactionsmanager.h"
+#include "messagethreader.h"
 
 namespace LeechCraft
 {
 namespace Snails
 {
-	struct MailModel::TreeNode : std::enable_shared_from_this<TreeNode>
+	struct MailModel::TreeNode
 	{
-		Message_ptr Msg_;
+		MessageInfo Info_;
 
 		TreeNode_wptr Parent_;
 		QList<TreeNode_ptr> Children_;
@@ -62,25 +65,39 @@ namespace Snails
 			{
 				qWarning () << Q_FUNC_INFO
 						<< "unknown row for item"
-						<< Msg_->GetFolderID ();
+						<< Info_.FolderId_;
 				return -1;
 			}
 
 			return std::distance (parent->Children_.begin (), pos);
 		}
 
+		bool IsDescendantOf (const TreeNode *node) const
+		{
+			for (auto parent = Parent_.lock (); parent; parent = parent->Parent_.lock ())
+				if (parent.get () == node)
+					return true;
+			return false;
+		}
+
 		TreeNode () = default;
 
-		TreeNode (const Message_ptr& msg, const TreeNode_ptr& parent)
-		: Msg_ { msg }
+		TreeNode (const MessageInfo& info, const TreeNode_ptr& parent)
+		: Info_ { info }
 		, Parent_ { parent }
 		{
 		}
 	};
 
-	MailModel::MailModel (const MessageListActionsManager *actsMgr, QObject *parent)
+	namespace
+	{
+		const int FetchChunkSize = 500;
+	}
+
+	MailModel::MailModel (const MessageListActionsManager *actsMgr, Account *acc, QObject *parent)
 	: QAbstractItemModel { parent }
 	, ActionsMgr_ { actsMgr }
+	, Acc_ { acc }
 	, Headers_ { tr ("From"), {}, {}, {}, tr ("Subject"), tr ("Date"), tr ("Size")  }
 	, Folder_ { "INBOX" }
 	, Root_ { std::make_shared<TreeNode> () }
@@ -106,7 +123,7 @@ namespace Snails
 		if (structItem == Root_.get ())
 			return {};
 
-		const auto& msg = structItem->Msg_;
+		const auto& info = structItem->Info_;
 
 		const auto column = static_cast<Column> (index.column ());
 
@@ -134,7 +151,7 @@ namespace Snails
 			switch (column)
 			{
 			case Column::StatusIcon:
-				if (!msg->IsRead ())
+				if (!info.IsRead_)
 					iconName = "mail-unread-new";
 				else if (structItem->UnreadChildren_.size ())
 					iconName = "mail-unread";
@@ -142,7 +159,7 @@ namespace Snails
 					iconName = "mail-read";
 				break;
 			case Column::AttachIcon:
-				if (!msg->GetAttachments ().isEmpty ())
+				if (info.HasAttachments_)
 					iconName = "mail-attachment";
 			default:
 				break;
@@ -154,9 +171,9 @@ namespace Snails
 			return Core::Instance ().GetProxy ()->GetIconThemeManager ()->GetIcon (iconName);
 		}
 		case ID:
-			return msg->GetFolderID ();
+			return info.FolderId_;
 		case IsRead:
-			return msg->IsRead ();
+			return info.IsRead_;
 		case UnreadChildrenCount:
 			return structItem->UnreadChildren_.size ();
 		default:
@@ -166,25 +183,22 @@ namespace Snails
 		switch (column)
 		{
 		case Column::From:
-		{
-			const auto& addr = msg->GetAddress (Message::Address::From);
-			return addr.first.isEmpty () ? addr.second : addr.first;
-		}
+			return info.From_;
 		case Column::Subject:
 			if (role != MessageActions)
-				return msg->GetSubject ();
+				return info.Subject_;
 			else
-				return QVariant::fromValue (MsgId2Actions_.value (msg->GetFolderID ()));
+				return QVariant::fromValue (GetMessageActions (info.FolderId_));
 		case Column::Date:
 			if (role == Sort)
-				return msg->GetDate ();
+				return info.Date_;
 			else
-				return msg->GetDate ().toLocalTime ().toString ();
+				return info.Date_.toLocalTime ().toString ();
 		case Column::Size:
 			if (role == Sort)
-				return msg->GetSize ();
+				return info.Size_;
 			else
-				return Util::MakePrettySize (msg->GetSize ());
+				return Util::MakePrettySize (info.Size_);
 		case Column::UnreadChildren:
 			if (const auto unread = structItem->UnreadChildren_.size ())
 				return unread;
@@ -244,6 +258,56 @@ namespace Snails
 		return structItem->Children_.size ();
 	}
 
+	bool MailModel::canFetchMore (const QModelIndex& parent) const
+	{
+		return !parent.isValid () && IsLazy_ && HasMoreInfos_;
+	}
+
+	void MailModel::fetchMore (const QModelIndex& parent)
+	{
+		if (!canFetchMore (parent))
+			return;
+
+		QList<MessageInfo> infos;
+		auto cursor = FetchCursor_;
+		try
+		{
+			infos = Core::Instance ().GetStorage ()->LoadMessageInfos (Acc_,
+					Folder_, cursor, FetchChunkSize);
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to fetch messages for"
+					<< Folder_
+					<< e.what ();
+			HasMoreInfos_ = false;
+			return;
+		}
+
+		FetchCursor_ = cursor;
+		HasMoreInfos_ = infos.size () == FetchChunkSize;
+
+		// Older messages might have been appended before their chunk.
+		for (auto i = infos.begin (); i != infos.end (); )
+			if (FolderId2Node_.contains (i->FolderId_))
+				i = infos.erase (i);
+			else
+				++i;
+
+		if (infos.isEmpty ())
+			return;
+
+		for (const auto& info : infos)
+			if (!info.MessageId_.isEmpty ())
+				MsgId2FolderId_ [info.MessageId_] = info.FolderId_;
+
+		AppendFlat (infos);
+		ScheduleThreading ();
+
+		emit messageListUpdated ();
+	}
+
 	void MailModel::SetFolder (const QStringList& folder)
 	{
 		Folder_ = folder;
@@ -254,20 +318,46 @@ namespace Snails
 		return Folder_;
 	}
 
+	void MailModel::SetLazyLoading (bool lazy)
+	{
+		IsLazy_ = lazy;
+		HasMoreInfos_ = lazy;
+	}
+
 	Message_ptr MailModel::GetMessage (const QByteArray& id) const
 	{
-		return GetMessageByFolderId (id);
+		if (!FolderId2Node_.contains (id))
+			return {};
+
+		try
+		{
+			return Core::Instance ().GetStorage ()->LoadMessage (Acc_, Folder_, id);
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to load"
+					<< id
+					<< e.what ();
+			return {};
+		}
 	}
 
 	void MailModel::Clear ()
 	{
-		if (Messages_.isEmpty ())
+		IsLazy_ = false;
+		HasMoreInfos_ = false;
+		FetchCursor_ = {};
+
+		// Results of the threading jobs in progress are stale now.
+		++Generation_;
+
+		if (Root_->Children_.isEmpty ())
 			return;
 
-		beginRemoveRows ({}, 0, Messages_.size () - 1);
-		Messages_.clear ();
+		beginRemoveRows ({}, 0, Root_->Children_.size () - 1);
 		Root_->Children_.clear ();
-		FolderId2Nodes_.clear ();
+		FolderId2Node_.clear ();
 		MsgId2FolderId_.clear ();
 		endRemoveRows ();
 
@@ -305,74 +395,61 @@ namespace Snails
 				[] (const Message_ptr& left, const Message_ptr& right)
 					{ return left->GetDate () < right->GetDate (); });
 
-		Messages_ += messages;
-
+		QList<MessageInfo> infos;
 		for (const auto& msg : messages)
 		{
-			const auto& msgId = msg->GetMessageID ();
-			if (!msgId.isEmpty ())
-				MsgId2FolderId_ [msgId] = msg->GetFolderID ();
+			const auto& info = GetMessageInfo (msg);
+			infos << info;
 
-			const auto& acts = ActionsMgr_->GetMessageActions (msg);
-			if (!acts.isEmpty ())
-				MsgId2Actions_ [msg->GetFolderID ()] = acts;
+			if (!info.MessageId_.isEmpty ())
+				MsgId2FolderId_ [info.MessageId_] = info.FolderId_;
+
+			MsgId2Actions_ [info.FolderId_] = ActionsMgr_->GetMessageActions (msg);
 		}
 
-		for (const auto& msg : messages)
-			if (!AppendStructured (msg))
-			{
-				const auto& node = std::make_shared<TreeNode> (msg, Root_);
-				beginInsertRows ({}, Root_->Children_.size (), Root_->Children_.size ());
-				Root_->Children_.append (node);
-				FolderId2Nodes_ [msg->GetFolderID ()] << node;
-				endInsertRows ();
-			}
+		for (const auto& info : infos)
+			if (!AppendStructured (info))
+				AppendFlat ({ info });
+
+		ScheduleThreading ();
 
 		emit messageListUpdated ();
 	}
 
 	bool MailModel::Update (const Message_ptr& msg)
 	{
-		const auto pos = std::find_if (Messages_.begin (), Messages_.end (),
-				[&msg] (const Message_ptr& other)
-					{ return other->GetFolderID () == msg->GetFolderID (); });
-		if (pos == Messages_.end ())
+		const auto& node = FolderId2Node_.value (msg->GetFolderID ());
+		if (!node)
 			return false;
 
-		if (*pos != msg)
-		{
-			const auto readChanged = (*pos)->IsRead () != msg->IsRead ();
+		const auto readChanged = node->Info_.IsRead_ != msg->IsRead ();
 
-			*pos = msg;
-			for (const auto& indexPair : GetIndexes (msg->GetFolderID (), { 0, columnCount () - 1 }))
-			{
-				for (const auto& index : indexPair)
-					static_cast<TreeNode*> (index.internalPointer ())->Msg_ = msg;
-				emit dataChanged (indexPair.value (0), indexPair.value (1));
-			}
+		node->Info_ = GetMessageInfo (msg);
+		if (!node->Info_.MessageId_.isEmpty ())
+			MsgId2FolderId_ [node->Info_.MessageId_] = node->Info_.FolderId_;
+		MsgId2Actions_ [node->Info_.FolderId_] = ActionsMgr_->GetMessageActions (msg);
 
-			if (readChanged)
-				UpdateParentReadCount (msg->GetFolderID (), !msg->IsRead ());
-		}
+		EmitRowChanged (node);
+
+		if (readChanged)
+			UpdateParentReadCount (msg->GetFolderID (), !msg->IsRead ());
 
 		return true;
 	}
 
 	bool MailModel::Remove (const QByteArray& id)
 	{
-		const auto msgPos = std::find_if (Messages_.begin (), Messages_.end (),
-				[&id] (const Message_ptr& other) { return other->GetFolderID () == id; });
-		if (msgPos == Messages_.end ())
+		const auto& node = FolderId2Node_.value (id);
+		if (!node)
 			return false;
 
 		UpdateParentReadCount (id, false);
 
-		for (const auto& node : FolderId2Nodes_.value (id))
-			RemoveNode (node);
+		RemoveNode (node);
 
-		FolderId2Nodes_.remove (id);
-		MsgId2FolderId_.remove ((*msgPos)->GetMessageID ());
-		Messages_.erase (msgPos);
+		FolderId2Node_.remove (id);
+		MsgId2FolderId_.remove (node->Info_.MessageId_);
+		MsgId2Actions_.remove (id);
 
 		return true;
 	}
@@ -380,30 +457,66 @@ namespace Snails
 	void MailModel::MarkUnavailable (const QList<QByteArray>& ids)
 	{
 		for (const auto& id : ids)
-			for (const auto& node : FolderId2Nodes_.value (id))
-			{
-				if (node->IsAvailable_ == false)
-					continue;
+		{
+			const auto& node = FolderId2Node_.value (id);
+			if (!node || !node->IsAvailable_)
+				continue;
 
-				node->IsAvailable_ = false;
-				EmitRowChanged (node);
-			}
+			node->IsAvailable_ = false;
+			EmitRowChanged (node);
+		}
 	}
 
-	void MailModel::UpdateParentReadCount (const QByteArray& folderId, bool addUnread)
+	void MailModel::AppendFlat (const QList<MessageInfo>& infos)
 	{
-		QList<TreeNode_ptr> nodes;
-		for (const auto& node : FolderId2Nodes_.value (folderId))
+		if (infos.isEmpty ())
+			return;
+
+		const auto startRow = Root_->Children_.size ();
+		beginInsertRows ({}, startRow, startRow + infos.size () - 1);
+		for (const auto& info : infos)
 		{
-			const auto& parent = node->Parent_.lock ();
-			if (parent != Root_)
-				nodes << parent;
+			const auto& node = std::make_shared<TreeNode> (info, Root_);
+			Root_->Children_ << node;
+			FolderId2Node_ [info.FolderId_] = node;
 		}
+		endInsertRows ();
+	}
 
-		for (int i = 0; i < nodes.size (); ++i)
-		{
-			const auto& item = nodes.at (i);
+	bool MailModel::AppendStructured (const MessageInfo& info)
+	{
+		const auto& refs = info.References_;
+		if (refs.isEmpty ())
+			return false;
+
+		TreeNode_ptr parentNode;
+		for (int i = refs.size () - 1; i >= 0 && !parentNode; --i)
+			parentNode = FolderId2Node_.value (MsgId2FolderId_.value (refs.at (i)));
+		if (!parentNode)
+			return false;
+
+		const auto row = parentNode->Children_.size ();
 
+		const auto& node = std::make_shared<TreeNode> (info, parentNode);
+		beginInsertRows (GetIndex (parentNode, 0), row, row);
+		parentNode->Children_ << node;
+		FolderId2Node_ [info.FolderId_] = node;
+		endInsertRows ();
+
+		if (!info.IsRead_)
+			UpdateParentReadCount (info.FolderId_, true);
+
+		return true;
+	}
+
+	void MailModel::UpdateParentReadCount (const QByteArray& folderId, bool addUnread)
+	{
+		const auto& node = FolderId2Node_.value (folderId);
+		if (!node)
+			return;
+
+		for (auto item = node->Parent_.lock (); item && item != Root_; item = item->Parent_.lock ())
+		{
 			bool emitUpdate = false;
 			if (addUnread && !item->UnreadChildren_.contains (folderId))
 			{
@@ -414,15 +527,7 @@ namespace Snails
 				emitUpdate = true;
 
 			if (emitUpdate)
-			{
-				const auto& leftIdx = createIndex (item->Row (), 0, item.get ());
-				const auto& rightIdx = createIndex (item->Row (), columnCount () - 1, item.get ());
-				emit dataChanged (leftIdx, rightIdx);
-			}
-
-			const auto& parent = item->Parent_.lock ();
-			if (parent != Root_)
-				nodes << parent;
+				EmitRowChanged (item);
 		}
 	}
 
@@ -460,43 +565,78 @@ namespace Snails
 		endRemoveRows ();
 	}
 
-	bool MailModel::AppendStructured (const Message_ptr& msg)
+	void MailModel::ScheduleThreading ()
 	{
-		auto refs = msg->GetReferences ();
-		for (const auto& replyTo : msg->GetInReplyTo ())
-			if (!refs.contains (replyTo))
-				refs << replyTo;
-
-		if (refs.isEmpty ())
-			return false;
-
-		QByteArray folderId;
-		for (int i = refs.size () - 1; i >= 0; --i)
+		if (IsThreading_)
 		{
-			folderId = MsgId2FolderId_.value (refs.at (i));
-			if (!folderId.isEmpty ())
-				break;
+			IsThreadingPending_ = true;
+			return;
 		}
-		if (folderId.isEmpty ())
-			return false;
 
-		const auto& indexes = GetIndexes (folderId, 0);
-		for (const auto& parentIndex : indexes)
+		QList<ThreadCandidate> candidates;
+		for (const auto& node : Root_->Children_)
+			if (!node->Info_.References_.isEmpty ())
+				candidates.append (ThreadCandidate { node->Info_.FolderId_, node->Info_.References_ });
+
+		if (candidates.isEmpty ())
+			return;
+
+		IsThreading_ = true;
+		IsThreadingPending_ = false;
+
+		auto watcher = new QFutureWatcher<QHash<QByteArray, QByteArray>> { this };
+		watcher->setProperty ("Generation", Generation_);
+		connect (watcher,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleThreadingFinished ()));
+		watcher->setFuture (QtConcurrent::run (ResolveThreadParents, candidates, MsgId2FolderId_));
+	}
+
+	void MailModel::ApplyThreading (const QHash<QByteArray, QByteArray>& child2parent)
+	{
+		for (auto i = child2parent.begin (); i != child2parent.end (); ++i)
 		{
-			const auto parentNode = static_cast<TreeNode*> (parentIndex.internalPointer ());
-			const auto row = parentNode->Children_.size ();
+			const auto& node = FolderId2Node_.value (i.key ());
+			const auto& parentNode = FolderId2Node_.value (i.value ());
+			if (!node || !parentNode)
+				continue;
 
-			const auto& node = std::make_shared<TreeNode> (msg, parentNode->shared_from_this ());
-			beginInsertRows (parentIndex, row, row);
+			// Already threaded, or would make a cycle with an existing thread.
+			if (node->Parent_.lock () != Root_ ||
+					parentNode == node ||
+					parentNode->IsDescendantOf (node.get ()))
+				continue;
+
+			const auto row = node->Row ();
+			const auto destRow = parentNode->Children_.size ();
+			beginMoveRows ({}, row, row, GetIndex (parentNode, 0), destRow);
+			Root_->Children_.removeAt (row);
+			node->Parent_ = parentNode;
 			parentNode->Children_ << node;
-			FolderId2Nodes_ [msg->GetFolderID ()] << node;
-			endInsertRows ();
-		}
+			endMoveRows ();
 
-		if (!msg->IsRead ())
-			UpdateParentReadCount (msg->GetFolderID (), true);
+			auto unread = node->UnreadChildren_;
+			if (!node->Info_.IsRead_)
+				unread << node->Info_.FolderId_;
+			for (const auto& id : unread)
+				UpdateParentReadCount (id, true);
+		}
+	}
 
-		return !indexes.isEmpty ();
+	QList<MessageListActionInfo> MailModel::GetMessageActions (const QByteArray& id) const
+	{
+		const auto pos = MsgId2Actions_.find (id);
+		if (pos != MsgId2Actions_.end ())
+			return *pos;
+
+		// Computed on demand, since this needs the full message headers.
+		const auto& msg = GetMessage (id);
+		const auto& actions = msg ?
+				ActionsMgr_->GetMessageActions (msg) :
+				QList<MessageListActionInfo> {};
+		MsgId2Actions_ [id] = actions;
+		return actions;
 	}
 
 	void MailModel::EmitRowChanged (const TreeNode_ptr& node)
@@ -510,30 +650,21 @@ namespace Snails
 		return createIndex (node->Row (), column, node.get ());
 	}
 
-	QList<QModelIndex> MailModel::GetIndexes (const QByteArray& folderId, int column) const
+	void MailModel::handleThreadingFinished ()
 	{
-		return Util::Map (FolderId2Nodes_.value (folderId),
-				[this, column] (const auto& node) { return GetIndex (node, column); });
-	}
+		auto watcher = dynamic_cast<QFutureWatcher<QHash<QByteArray, QByteArray>>*> (sender ());
+		watcher->deleteLater ();
 
-	QList<QList<QModelIndex>> MailModel::GetIndexes (const QByteArray& folderId, const QList<int>& columns) const
-	{
-		return Util::Map (FolderId2Nodes_.value (folderId),
-				[this, &columns] (const auto& node)
-				{
-					return Util::Map (columns,
-							[this, &node] (auto column) { return GetIndex (node, column); });
-				});
-	}
+		IsThreading_ = false;
 
-	Message_ptr MailModel::GetMessageByFolderId (const QByteArray& id) const
-	{
-		const auto pos = std::find_if (Messages_.begin (), Messages_.end (),
-				[&id] (const Message_ptr& msg) { return msg->GetFolderID () == id; });
-		if (pos == Messages_.end ())
-			return {};
+		if (watcher->property ("Generation").toULongLong () == Generation_)
+		{
+			ApplyThreading (watcher->result ());
+			if (!IsThreadingPending_)
+				return;
+		}
 
-		return *pos;
+		ScheduleThreading ();
 	}
 }
 }
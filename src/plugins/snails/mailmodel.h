@@ -33,18 +33,30 @@
 #include <QAbstractItemModel>
 #include <QList>
 #include "message.h"
+#include "messageinfo.h"
 #include "messagelistactioninfo.h"
 
 namespace LeechCraft
 {
 namespace Snails
 {
+	class Account;
 	class MessageListActionsManager;
+
+	/** @brief The threaded list of messages in a folder.
+	 *
+	 * The model keeps just a MessageInfo per message. In the lazy
+	 * loading mode the infos are fetched from the storage in chunks as
+	 * the view is scrolled, and the thread structure for the fetched
+	 * messages is computed in a separate thread, so even huge folders
+	 * open instantly.
+	 */
 	class MailModel : public QAbstractItemModel
 	{
 		Q_OBJECT
 
 		const MessageListActionsManager * const ActionsMgr_;
+		Account * const Acc_;
 
 		const QStringList Headers_;
 
@@ -55,11 +67,18 @@ namespace Snails
 		typedef std::weak_ptr<TreeNode> TreeNode_wptr;
 		const TreeNode_ptr Root_;
 
-		QList<Message_ptr> Messages_;
-		QHash<QByteArray, QList<TreeNode_ptr>> FolderId2Nodes_;
+		QHash<QByteArray, TreeNode_ptr> FolderId2Node_;
 		QHash<QByteArray, QByteArray> MsgId2FolderId_;
 
-		QHash<QByteArray, QList<MessageListActionInfo>> MsgId2Actions_;
+		mutable QHash<QByteArray, QList<MessageListActionInfo>> MsgId2Actions_;
+
+		bool IsLazy_ = false;
+		bool HasMoreInfos_ = false;
+		MessageListCursor FetchCursor_;
+
+		quint64 Generation_ = 0;
+		bool IsThreading_ = false;
+		bool IsThreadingPending_ = false;
 	public:
 		enum class Column
 		{
@@ -83,7 +102,7 @@ namespace Snails
 			MessageActions
 		};
 
-		MailModel (const MessageListActionsManager*, QObject* = 0);
+		MailModel (const MessageListActionsManager*, Account*, QObject* = 0);
 
 		QVariant headerData (int, Qt::Orientation, int) const;
 		int columnCount (const QModelIndex& = {}) const;
@@ -93,9 +112,17 @@ namespace Snails
 		QModelIndex parent (const QModelIndex&) const;
 		int rowCount (const QModelIndex& = {}) const;
 
+		bool canFetchMore (const QModelIndex&) const;
+		void fetchMore (const QModelIndex&);
+
 		void SetFolder (const QStringList&);
 		QStringList GetCurrentFolder () const;
 
+		/** Enables fetching the messages of the current folder from the
+		 * storage as the view requests them. Clear() disables it.
+		 */
+		void SetLazyLoading (bool);
+
 		Message_ptr GetMessage (const QByteArray&) const;
 
 		void Clear ();
@@ -107,17 +134,23 @@ namespace Snails
 
 		void MarkUnavailable (const QList<QByteArray>&);
 	private:
+		void AppendFlat (const QList<MessageInfo>&);
+		bool AppendStructured (const MessageInfo&);
+
 		void UpdateParentReadCount (const QByteArray&, bool);
 
 		void RemoveNode (const TreeNode_ptr&);
-		bool AppendStructured (const Message_ptr&);
+
+		void ScheduleThreading ();
+		void ApplyThreading (const QHash<QByteArray, QByteArray>&);
+
+		QList<MessageListActionInfo> GetMessageActions (const QByteArray&) const;
 
 		void EmitRowChanged (const TreeNode_ptr&);
 
 		QModelIndex GetIndex (const TreeNode_ptr& node, int column) const;
-		QList<QModelIndex> GetIndexes (const QByteArray& folderId, int column) const;
-		QList<QList<QModelIndex>> GetIndexes (const QByteArray& folderId, const QList<int>& columns) const;
-		Message_ptr GetMessageByFolderId (const QByteArray&) const;
+	private slots:
+		void handleThreadingFinished ();
 	signals:
 		void messageListUpdated ();
 	};
@@ -28,11 +28,13 @@
  **********************************************************************/
 
 #include "mailmodelsmanager.h"
+#include <util/sll/delayedexecutor.h>
 #include "account.h"
 #include "mailmodel.h"
 #include "core.h"
 #include "storage.h"
 #include "messagelistactionsmanager.h"
+#include "searchquery.h"
 
 namespace LeechCraft
 {
@@ -43,11 +45,15 @@ namespace Snails
 	, Acc_ { acc }
 	, MsgListActionsMgr_ { new MessageListActionsManager { Acc_, this } }
 	{
+		connect (Core::Instance ().GetStorage (),
+				SIGNAL (maintenanceFinished (Account*)),
+				this,
+				SLOT (handleStorageMaintained (Account*)));
 	}
 
 	MailModel* MailModelsManager::CreateModel ()
 	{
-		auto model = new MailModel { MsgListActionsMgr_, Acc_ };
+		auto model = new MailModel { MsgListActionsMgr_, Acc_, Acc_ };
 		Models_ << model;
 
 		connect (model,
@@ -69,6 +75,7 @@ namespace Snails
 			return;
 		}
 
+		Searches_.remove (mailModel);
 		mailModel->Clear ();
 
 		qDebug () << Q_FUNC_INFO << path;
@@ -76,27 +83,46 @@ namespace Snails
 			return;
 
 		mailModel->SetFolder (path);
+		mailModel->SetLazyLoading (true);
+		mailModel->fetchMore ({});
 
-		const auto storage = Core::Instance ().GetStorage ();
-		const auto& ids = storage->LoadIDs (Acc_, path);
+		const auto& ids = Core::Instance ().GetStorage ()->LoadIDs (Acc_, path);
+		Acc_->Synchronize (path, ids.isEmpty () ? QByteArray {} : ids.last ());
+	}
 
-		try
+	void MailModelsManager::ShowSearchResults (const QStringList& path,
+			const QString& query, MailModel *mailModel)
+	{
+		if (!Models_.contains (mailModel))
 		{
-			mailModel->Append (storage->LoadMessages (Acc_, path, ids));
+			qWarning () << Q_FUNC_INFO
+					<< "unmanaged model"
+					<< mailModel
+					<< Models_;
+			return;
 		}
-		catch (const std::exception& e)
+
+		const auto& match = BuildFTSQuery (query);
+		if (match.isEmpty () || path.isEmpty ())
 		{
-			qWarning () << Q_FUNC_INFO
-					<< e.what ();
+			ShowFolder (path, mailModel);
+			return;
 		}
 
-		Acc_->Synchronize (path, ids.isEmpty () ? QByteArray {} : ids.last ());
+		mailModel->Clear ();
+		mailModel->SetFolder (path);
+
+		const auto searchId = ++LastSearchId_;
+		Searches_ [mailModel] = searchId;
+
+		FetchSearchChunk (mailModel, searchId, path, match, 0);
 	}
 
 	void MailModelsManager::Append (const QList<Message_ptr>& messages)
 	{
 		for (const auto model : Models_)
-			model->Append (messages);
+			if (!Searches_.contains (model))
+				model->Append (messages);
 	}
 
 	void MailModelsManager::Update (const QList<Message_ptr>& messages)
@@ -113,9 +139,65 @@ namespace Snails
 				model->Remove (id);
 	}
 
+	namespace
+	{
+		const int SearchChunkSize = 200;
+	}
+
+	void MailModelsManager::FetchSearchChunk (MailModel *mailModel, quint64 searchId,
+			const QStringList& folder, const QString& match, int offset)
+	{
+		// The search has been superseded, or the model has been destroyed.
+		if (Searches_.value (mailModel) != searchId)
+			return;
+
+		const auto storage = Core::Instance ().GetStorage ();
+
+		QList<QByteArray> ids;
+		try
+		{
+			ids = storage->Search (Acc_, folder, match, offset, SearchChunkSize);
+			mailModel->Append (storage->LoadMessages (Acc_, folder, ids));
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "search failed for"
+					<< match
+					<< e.what ();
+			return;
+		}
+
+		if (ids.size () < SearchChunkSize)
+			return;
+
+		Util::ExecuteLater ([=]
+				{ FetchSearchChunk (mailModel, searchId, folder, match, offset + SearchChunkSize); });
+	}
+
 	void MailModelsManager::handleModelDestroyed (QObject *modelObj)
 	{
-		Models_.removeAll (static_cast<MailModel*> (modelObj));
+		const auto model = static_cast<MailModel*> (modelObj);
+		Models_.removeAll (model);
+		Searches_.remove (model);
+	}
+
+	void MailModelsManager::handleStorageMaintained (Account *acc)
+	{
+		if (acc != Acc_)
+			return;
+
+		for (const auto model : Models_)
+		{
+			const auto& folder = model->GetCurrentFolder ();
+			if (Searches_.contains (model) || folder.isEmpty ())
+				continue;
+
+			model->Clear ();
+			model->SetFolder (folder);
+			model->SetLazyLoading (true);
+			model->fetchMore ({});
+		}
 	}
 }
 }
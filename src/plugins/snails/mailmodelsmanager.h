@@ -31,6 +31,8 @@
 
 #include <memory>
 #include <QObject>
+#include <QHash>
+#include <QStringList>
 
 namespace LeechCraft
 {
@@ -51,6 +53,12 @@ namespace Snails
 		MessageListActionsManager * const MsgListActionsMgr_;
 
 		QList<MailModel*> Models_;
+
+		/* Models currently showing search results, mapped to the ID of
+		 * the search being streamed into them.
+		 */
+		QHash<MailModel*, quint64> Searches_;
+		quint64 LastSearchId_ = 0;
 	public:
 		MailModelsManager (Account*);
 
@@ -58,11 +66,24 @@ namespace Snails
 
 		void ShowFolder (const QStringList&, MailModel*);
 
+		/** Replaces the contents of the model with the messages of the
+		 * folder matching the query, see BuildFTSQuery() for the syntax.
+		 *
+		 * The results are appended to the model in chunks from the event
+		 * loop, so the first matches show up without waiting for the
+		 * whole result set.
+		 */
+		void ShowSearchResults (const QStringList&, const QString& query, MailModel*);
+
 		void Append (const QList<Message_ptr>&);
 		void Update (const QList<Message_ptr>&);
 		void Remove (const QList<QByteArray>&);
+	private:
+		void FetchSearchChunk (MailModel*, quint64 searchId,
+				const QStringList& folder, const QString& match, int offset);
 	private slots:
 		void handleModelDestroyed (QObject*);
+		void handleStorageMaintained (Account*);
 	};
 }
 }
@@ -35,6 +35,7 @@
 #include <QMenu>
 #include <QFileDialog>
 #include <QToolButton>
+#include <QLineEdit>
 #include <util/util.h>
 #include <util/tags/categoryselector.h>
 #include <util/sys/extensionsdata.h>
@@ -290,11 +291,30 @@ namespace Snails
 		SetMsgActionsEnabled (false);
 	}
 
+	void MailTab::FillSearchActions ()
+	{
+		SearchEdit_ = new QLineEdit;
+		SearchEdit_->setPlaceholderText (tr ("Search..."));
+		SearchEdit_->setToolTip (tr ("Search messages in the current folder. "
+				"Use <em>from:</em>, <em>to:</em>, <em>subject:</em> and <em>body:</em> "
+				"to restrict a term to the corresponding field, <em>has:attachment</em> "
+				"to find messages with attachments and double quotes to search for phrases. "
+				"Press Enter to search, clear the field to show the whole folder."));
+		SearchEdit_->setMaximumWidth (300);
+		TabToolbar_->addWidget (SearchEdit_);
+		connect (SearchEdit_,
+				SIGNAL (returnPressed ()),
+				this,
+				SLOT (handleSearch ()));
+	}
+
 	void MailTab::FillTabToolbarActions ()
 	{
 		FillCommonActions ();
 		TabToolbar_->addSeparator ();
 		FillMailActions ();
+		TabToolbar_->addSeparator ();
+		FillSearchActions ();
 	}
 
 	QList<QByteArray> MailTab::GetSelectedIds () const
@@ -606,6 +626,8 @@ namespace Snails
 
 	void MailTab::handleCurrentTagChanged (const QModelIndex& sidx)
 	{
+		SearchEdit_->clear ();
+
 		const auto& folder = sidx.data (FoldersModel::Role::FolderPath).toStringList ();
 		CurrAcc_->GetMailModelsManager ()->ShowFolder (folder, MailModel_.get ());
 		Ui_.MailTree_->setCurrentIndex ({});
@@ -931,6 +953,18 @@ namespace Snails
 		CurrAcc_->Synchronize (MailModel_->GetCurrentFolder (), {});
 	}
 
+	void MailTab::handleSearch ()
+	{
+		if (!CurrAcc_)
+			return;
+
+		CurrAcc_->GetMailModelsManager ()->ShowSearchResults (MailModel_->GetCurrentFolder (),
+				SearchEdit_->text (), MailModel_.get ());
+		Ui_.MailTree_->setCurrentIndex ({});
+
+		handleMailSelected ();
+	}
+
 	void MailTab::handleMessageBodyFetched (Message_ptr msg)
 	{
 		const auto& cur = Ui_.MailTree_->currentIndex ();
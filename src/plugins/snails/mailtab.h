@@ -40,6 +40,7 @@ class QStandardItemModel;
 class QStandardItem;
 class QSortFilterProxyModel;
 class QToolButton;
+class QLineEdit;
 
 namespace LeechCraft
 {
@@ -72,6 +73,8 @@ namespace Snails
 		QMenu *MsgAttachments_;
 		QToolButton *MsgAttachmentsButton_;
 
+		QLineEdit *SearchEdit_;
+
 		TabClassInfo TabClass_;
 		QObject *PMT_;
 
@@ -97,6 +100,7 @@ namespace Snails
 	private:
 		void FillCommonActions ();
 		void FillMailActions ();
+		void FillSearchActions ();
 		void FillTabToolbarActions ();
 		QList<QByteArray> GetSelectedIds () const;
 
@@ -127,6 +131,7 @@ namespace Snails
 		void handleAttachment (const QByteArray&, const QStringList&, const QString&);
 		void handleFetchNewMail ();
 		void handleRefreshFolder ();
+		void handleSearch ();
 
 		void handleMessageBodyFetched (Message_ptr);
 	signals:
@@ -0,0 +1,86 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	class Message;
+	using Message_ptr = std::shared_ptr<Message>;
+
+	/** @brief The subset of message data shown in the message list.
+	 *
+	 * Unlike Message, this is cheap to keep around for every message in
+	 * a folder and is loaded directly from the account database without
+	 * deserializing the stored messages.
+	 */
+	struct MessageInfo
+	{
+		QByteArray FolderId_;
+		QByteArray MessageId_;
+
+		/** The References IDs followed by the In-Reply-To IDs, used for
+		 * threading.
+		 */
+		QList<QByteArray> References_;
+
+		QString From_;
+		QString Subject_;
+		QDateTime Date_;
+		quint64 Size_ = 0;
+
+		bool IsRead_ = false;
+		bool HasAttachments_ = false;
+	};
+
+	/** @brief The position in the newest-first message list of a
+	 * folder.
+	 *
+	 * The list is paged by the (date, ID) pair of the last returned
+	 * entry rather than by an offset, so that messages added or removed
+	 * while the list is being fetched don't shift the following pages.
+	 * A default-constructed cursor points to the newest message.
+	 */
+	struct MessageListCursor
+	{
+		bool IsStart_ = true;
+		qint64 Date_ = 0;
+		int Id_ = 0;
+	};
+
+	MessageInfo GetMessageInfo (const Message_ptr&);
+}
+}
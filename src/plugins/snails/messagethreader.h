@@ -0,0 +1,70 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	/** A message that is not a part of any thread yet.
+	 */
+	struct ThreadCandidate
+	{
+		QByteArray FolderId_;
+
+		/** The message IDs this message refers to, the closest ancestor
+		 * being the last one.
+		 */
+		QList<QByteArray> References_;
+	};
+
+	/** @brief Finds the thread parents for the given messages.
+	 *
+	 * For each candidate, the closest ancestor out of its references
+	 * that is present in the msgId2folderId map is chosen as its parent.
+	 * Links that would make a candidate its own ancestor are dropped.
+	 *
+	 * This function doesn't touch any shared state and is thus safe to
+	 * be run in a separate thread.
+	 *
+	 * @param[in] candidates The messages to find parents for.
+	 * @param[in] msgId2folderId The map from message IDs to folder IDs
+	 * of all the messages in the folder.
+	 * @return The map from folder IDs of the candidates to the folder
+	 * IDs of their parents.
+	 */
+	QHash<QByteArray, QByteArray> ResolveThreadParents (const QList<ThreadCandidate>& candidates,
+			const QHash<QByteArray, QByteArray>& msgId2folderId);
+}
+}
@@ -0,0 +1,75 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include "message.h"
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	/** Messages of an account that are being written to its segment
+	 * store.
+	 *
+	 * Each batch gets its own sequence number, so a batch that finishes
+	 * late doesn't record the messages removed meanwhile or those that
+	 * have been saved again by a newer batch.
+	 */
+	class PendingSaves
+	{
+		struct Entry
+		{
+			Message_ptr Msg_;
+			quint64 Seq_;
+		};
+		QHash<QByteArray, Entry> Entries_;
+		quint64 LastSeq_ = 0;
+	public:
+		/** Registers the \em msgs and returns the sequence number of the
+		 * batch. Messages without a folder ID are ignored.
+		 */
+		quint64 Add (const QList<Message_ptr>& msgs);
+
+		void Remove (const QByteArray& id);
+
+		Message_ptr Get (const QByteArray& id) const;
+		QList<Message_ptr> GetAll () const;
+
+		/** Returns whether \em msg saved by the batch \em seq is still
+		 * pending, dropping it if so. Otherwise the message has been
+		 * removed or saved again after this batch, and the result of
+		 * this batch should be discarded.
+		 */
+		bool Finish (const Message_ptr& msg, quint64 seq);
+	};
+}
+}
@@ -0,0 +1,164 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "searchquery.h"
+#include <algorithm>
+#include <QStringList>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	const QString AttachmentMarker { "lcsnailshasattachment" };
+
+	namespace
+	{
+		struct Token
+		{
+			QString Field_;
+			QString Text_;
+		};
+
+		QList<Token> Tokenize (const QString& query)
+		{
+			QList<Token> result;
+
+			Token current;
+			bool inQuotes = false;
+
+			auto flush = [&result, &current]
+			{
+				if (!current.Text_.isEmpty () || !current.Field_.isEmpty ())
+					result << current;
+				current = Token {};
+			};
+
+			for (const auto ch : query)
+			{
+				if (ch == '"')
+				{
+					inQuotes = !inQuotes;
+					if (!inQuotes)
+						flush ();
+				}
+				else if (inQuotes)
+					current.Text_ += ch;
+				else if (ch.isSpace ())
+					flush ();
+				else if (ch == ':' && current.Field_.isEmpty () && !current.Text_.isEmpty ())
+				{
+					current.Field_ = current.Text_.toLower ();
+					current.Text_.clear ();
+				}
+				else
+					current.Text_ += ch;
+			}
+			flush ();
+
+			return result;
+		}
+
+		QStringList Sanitize (QString text)
+		{
+			for (auto& ch : text)
+				if (!ch.isLetterOrNumber () && ch != '*' && ch != '@' && ch != '.' && ch != '-' && ch != '_')
+					ch = ' ';
+
+			const bool isPrefix = text.trimmed ().endsWith ('*');
+			text.remove ('*');
+
+			QStringList words;
+			for (const auto& word : text.split (' ', QString::SkipEmptyParts))
+				if (std::any_of (word.begin (), word.end (), [] (QChar ch) { return ch.isLetterOrNumber (); }))
+					words << word;
+
+			if (isPrefix && !words.isEmpty ())
+				words.last () += '*';
+			return words;
+		}
+
+		QString MakeTerm (const QString& column, const QStringList& words)
+		{
+			if (column.isEmpty ())
+				return '"' + words.join (" ") + '"';
+
+			// FTS4 only allows bare terms after a column filter, and the
+			// words left after Sanitize() can't be parsed as operators
+			// there.
+			QStringList terms;
+			for (const auto& word : words)
+				terms << column + ':' + word;
+			return terms.join (" ");
+		}
+
+		QString Field2Column (const QString& field)
+		{
+			if (field == "from")
+				return "Sender";
+			if (field == "to" || field == "cc")
+				return "Recipients";
+			if (field == "subject")
+				return "Subject";
+			if (field == "body")
+				return "Body";
+			return {};
+		}
+	}
+
+	QString BuildFTSQuery (const QString& query)
+	{
+		QStringList parts;
+
+		for (const auto& token : Tokenize (query))
+		{
+			if (token.Field_ == "has")
+			{
+				if (token.Text_.toLower ().startsWith ("attachment"))
+				{
+					parts << "Attachments:" + AttachmentMarker;
+					continue;
+				}
+			}
+
+			const auto& column = Field2Column (token.Field_);
+
+			// An unknown prefix is just a part of the text being searched for.
+			const auto& words = Sanitize (column.isEmpty () && !token.Field_.isEmpty () ?
+					token.Field_ + ' ' + token.Text_ :
+					token.Text_);
+			if (words.isEmpty ())
+				continue;
+
+			parts << MakeTerm (column, words);
+		}
+
+		return parts.join (" ");
+	}
+}
+}
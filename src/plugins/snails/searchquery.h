@@ -0,0 +1,66 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QString>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	/** The token put into the attachments column of the full-text
+	 * index for every message having at least one attachment.
+	 */
+	extern const QString AttachmentMarker;
+
+	/** @brief Translates a user-entered search string to an FTS4 MATCH
+	 * expression.
+	 *
+	 * The following field prefixes are recognized:
+	 * - <code>from:</code> restricts the term to the sender;
+	 * - <code>to:</code> and <code>cc:</code> restrict the term to the
+	 *   recipients;
+	 * - <code>subject:</code> restricts the term to the subject;
+	 * - <code>body:</code> restricts the term to the message text;
+	 * - <code>has:attachment</code> matches messages with attachments.
+	 *
+	 * Double-quoted strings without a field prefix are searched as
+	 * phrases. FTS4 can't restrict a phrase to a column, so with a
+	 * field prefix each word of the string has to be present in that
+	 * field, in any order. A trailing asterisk makes the last word a
+	 * prefix query. All terms are implicitly ANDed.
+	 *
+	 * @param[in] query The search string as entered by the user.
+	 * @return The MATCH expression, or an empty string if there is
+	 * nothing to search for.
+	 */
+	QString BuildFTSQuery (const QString& query);
+}
+}
@@ -0,0 +1,339 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "segmentstore.h"
+#include <stdexcept>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		const quint32 RecordMagic = 0x534e5331;
+		const qint64 HeaderSize = 2 * sizeof (quint32);
+	}
+
+	class SegmentStore::Mapping
+	{
+		QFile File_;
+	public:
+		uchar *Data_ = nullptr;
+		qint64 Size_ = 0;
+
+		Mapping (const QString& path)
+		: File_ { path }
+		{
+			if (!File_.open (QIODevice::ReadOnly))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to open"
+						<< path
+						<< File_.errorString ();
+				return;
+			}
+
+			Size_ = File_.size ();
+			if (Size_)
+				Data_ = File_.map (0, Size_);
+
+			if (!Data_)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to map"
+						<< path
+						<< File_.errorString ();
+				Size_ = 0;
+			}
+		}
+
+		~Mapping ()
+		{
+			if (Data_)
+				File_.unmap (Data_);
+		}
+	};
+
+	SegmentStore::SegmentStore (const QDir& dir, qint64 maxSegmentSize)
+	: Dir_ { dir }
+	, MaxSegmentSize_ { maxSegmentSize }
+	{
+		const auto& segments = GetSegments ();
+		OpenSegment (segments.isEmpty () ? 0 : segments.last ());
+		RecoverCurrentSegment ();
+	}
+
+	SegmentLocation SegmentStore::Append (const QByteArray& data)
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		if (CurrentSize_ && CurrentSize_ + HeaderSize + data.size () > MaxSegmentSize_)
+			OpenSegment (CurrentSegment_ + 1);
+
+		QByteArray header (HeaderSize, 0);
+		const auto headerData = reinterpret_cast<uchar*> (header.data ());
+		qToBigEndian (RecordMagic, headerData);
+		qToBigEndian (static_cast<quint32> (data.size ()), headerData + sizeof (quint32));
+
+		const SegmentLocation loc { CurrentSegment_, CurrentSize_, data.size () };
+
+		if (CurrentFile_->write (header) != HeaderSize ||
+				CurrentFile_->write (data) != data.size ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write to"
+					<< CurrentFile_->fileName ()
+					<< CurrentFile_->errorString ();
+			throw std::runtime_error ("Unable to write to the segment file.");
+		}
+
+		CurrentSize_ += HeaderSize + data.size ();
+		return loc;
+	}
+
+	void SegmentStore::Flush ()
+	{
+		QMutexLocker locker { &Mutex_ };
+		CurrentFile_->flush ();
+	}
+
+	QByteArray SegmentStore::Read (const SegmentLocation& loc) const
+	{
+		const auto& mapping = GetMapping (loc.Segment_, loc.Offset_ + HeaderSize + loc.Size_);
+		if (!mapping)
+			throw std::runtime_error ("Unable to map the segment file.");
+
+		const auto record = mapping->Data_ + loc.Offset_;
+		if (qFromBigEndian<quint32> (record) != RecordMagic ||
+				qFromBigEndian<quint32> (record + sizeof (quint32)) != loc.Size_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "record header mismatch at"
+					<< loc.Segment_
+					<< loc.Offset_
+					<< loc.Size_;
+			throw std::runtime_error ("Segment record header mismatch.");
+		}
+
+		return { reinterpret_cast<const char*> (record + HeaderSize), static_cast<int> (loc.Size_) };
+	}
+
+	QList<int> SegmentStore::GetSegments () const
+	{
+		QList<int> result;
+		for (const auto& name : Dir_.entryList ({ "*.seg" }, QDir::Files, QDir::Name))
+		{
+			bool ok = false;
+			const auto num = name.section ('.', 0, 0).toInt (&ok);
+			if (ok)
+				result << num;
+		}
+		return result;
+	}
+
+	int SegmentStore::GetCurrentSegment () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return CurrentSegment_;
+	}
+
+	qint64 SegmentStore::GetSegmentSize (int segment) const
+	{
+		return QFileInfo { GetSegmentPath (segment) }.size ();
+	}
+
+	void SegmentStore::RemoveSegment (int segment)
+	{
+		QWriteLocker removalLocker { &RemovalLock_ };
+		QMutexLocker locker { &Mutex_ };
+		if (segment == CurrentSegment_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "refusing to remove the current segment"
+					<< segment;
+			return;
+		}
+
+		Mappings_.remove (segment);
+
+		QFile file { GetSegmentPath (segment) };
+		if (!file.remove ())
+			qWarning () << Q_FUNC_INFO
+					<< "unable to remove"
+					<< file.fileName ()
+					<< file.errorString ();
+	}
+
+	void SegmentStore::Compact (int segment, const QList<QPair<int, SegmentLocation>>& live,
+			const RelocationHandler_f& handler, int batchSize)
+	{
+		{
+			QMutexLocker locker { &Mutex_ };
+			if (segment == CurrentSegment_)
+				OpenSegment (CurrentSegment_ + 1);
+		}
+
+		QList<SegmentRelocation> batch;
+		for (const auto& pair : live)
+		{
+			batch.append ({ pair.first, pair.second, Append (Read (pair.second)) });
+			if (batch.size () < batchSize)
+				continue;
+
+			Flush ();
+			handler (batch);
+			batch.clear ();
+		}
+
+		Flush ();
+		if (!batch.isEmpty ())
+			handler (batch);
+
+		RemoveSegment (segment);
+	}
+
+	QReadWriteLock& SegmentStore::GetRemovalLock () const
+	{
+		return RemovalLock_;
+	}
+
+	QString SegmentStore::GetSegmentPath (int segment) const
+	{
+		return Dir_.filePath (QString ("%1.seg").arg (segment, 6, 10, QChar ('0')));
+	}
+
+	void SegmentStore::OpenSegment (int segment)
+	{
+		if (CurrentFile_)
+			CurrentFile_->flush ();
+
+		const auto& file = std::make_shared<QFile> (GetSegmentPath (segment));
+		if (!file->open (QIODevice::WriteOnly | QIODevice::Append))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file->fileName ()
+					<< file->errorString ();
+			throw std::runtime_error ("Unable to open the segment file.");
+		}
+
+		CurrentSegment_ = segment;
+		CurrentFile_ = file;
+		CurrentSize_ = file->size ();
+	}
+
+	void SegmentStore::RecoverCurrentSegment ()
+	{
+		QFile file { GetSegmentPath (CurrentSegment_) };
+		if (!file.open (QIODevice::ReadOnly))
+			return;
+
+		const auto size = file.size ();
+		qint64 pos = 0;
+		bool isGarbage = false;
+		while (size - pos >= HeaderSize)
+		{
+			file.seek (pos);
+			const auto& header = file.read (HeaderSize);
+			if (header.size () != HeaderSize)
+				break;
+
+			const auto headerData = reinterpret_cast<const uchar*> (header.constData ());
+			if (qFromBigEndian<quint32> (headerData) != RecordMagic)
+			{
+				isGarbage = true;
+				break;
+			}
+
+			const auto recordEnd = pos + HeaderSize + qFromBigEndian<quint32> (headerData + sizeof (quint32));
+			if (recordEnd > size)
+				break;
+
+			pos = recordEnd;
+		}
+		file.close ();
+
+		if (pos == size)
+			return;
+
+		if (isGarbage)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "bad record header in"
+					<< file.fileName ()
+					<< "at"
+					<< pos
+					<< "; switching to a new segment";
+			OpenSegment (CurrentSegment_ + 1);
+			return;
+		}
+
+		qWarning () << Q_FUNC_INFO
+				<< "truncating incomplete record in"
+				<< file.fileName ()
+				<< "at"
+				<< pos
+				<< "of"
+				<< size;
+		if (!CurrentFile_->resize (pos))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to truncate"
+					<< CurrentFile_->fileName ()
+					<< CurrentFile_->errorString ();
+			OpenSegment (CurrentSegment_ + 1);
+			return;
+		}
+		CurrentSize_ = pos;
+	}
+
+	SegmentStore::Mapping_ptr SegmentStore::GetMapping (int segment, qint64 minSize) const
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		const auto pos = Mappings_.constFind (segment);
+		if (pos != Mappings_.constEnd () && (*pos)->Size_ >= minSize)
+			return *pos;
+
+		if (segment == CurrentSegment_)
+			CurrentFile_->flush ();
+
+		const auto& mapping = std::make_shared<Mapping> (GetSegmentPath (segment));
+		if (mapping->Size_ < minSize)
+			return {};
+
+		Mappings_ [segment] = mapping;
+		return mapping;
+	}
+}
+}
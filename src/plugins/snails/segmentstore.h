@@ -0,0 +1,137 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <functional>
+#include <QDir>
+#include <QHash>
+#include <QMutex>
+#include <QReadWriteLock>
+
+class QFile;
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	struct SegmentLocation
+	{
+		int Segment_;
+		qint64 Offset_;
+		qint64 Size_;
+	};
+
+	struct SegmentRelocation
+	{
+		int Key_;
+		SegmentLocation Old_;
+		SegmentLocation New_;
+	};
+
+	/* Append-only storage of blobs packed into a few large segment
+	 * files instead of one file per blob.
+	 *
+	 * Each record is prefixed by a small header (magic and payload
+	 * size), so segments may be validated and scanned without the
+	 * external index. The index itself (blob key to SegmentLocation)
+	 * is kept by the caller.
+	 *
+	 * Segments are read via memory mapping. Appending and reading is
+	 * thread-safe.
+	 *
+	 * If the last segment ends with an incomplete record (say, after a
+	 * crash in the middle of Append()), the record is cut off on
+	 * opening. If it contains garbage instead, it is left as is, and
+	 * new records go to a fresh segment.
+	 */
+	class SegmentStore
+	{
+		const QDir Dir_;
+		const qint64 MaxSegmentSize_;
+
+		mutable QMutex Mutex_;
+		mutable QReadWriteLock RemovalLock_ { QReadWriteLock::Recursive };
+
+		int CurrentSegment_ = 0;
+		std::shared_ptr<QFile> CurrentFile_;
+		qint64 CurrentSize_ = 0;
+
+		class Mapping;
+		typedef std::shared_ptr<Mapping> Mapping_ptr;
+		mutable QHash<int, Mapping_ptr> Mappings_;
+	public:
+		typedef std::function<void (QList<SegmentRelocation>)> RelocationHandler_f;
+
+		SegmentStore (const QDir& dir, qint64 maxSegmentSize = 64 * 1024 * 1024);
+
+		SegmentStore (const SegmentStore&) = delete;
+		SegmentStore& operator= (const SegmentStore&) = delete;
+
+		SegmentLocation Append (const QByteArray&);
+		void Flush ();
+
+		QByteArray Read (const SegmentLocation&) const;
+
+		QList<int> GetSegments () const;
+		int GetCurrentSegment () const;
+		qint64 GetSegmentSize (int) const;
+
+		void RemoveSegment (int);
+
+		/* Copies the given live records of the segment to the end of the
+		 * store and removes the segment. The keys are opaque to the
+		 * store and are just passed back to the handler.
+		 *
+		 * The handler is called with at most batchSize relocations at a
+		 * time, after they have been flushed to disk, so that the caller
+		 * may update its index. The segment is removed only after all
+		 * records have been relocated; if reading any of them fails, an
+		 * exception is thrown and the segment is kept.
+		 */
+		void Compact (int segment, const QList<QPair<int, SegmentLocation>>& live,
+				const RelocationHandler_f& handler, int batchSize = 500);
+
+		/* Readers resolving locations via an external index should hold
+		 * this lock for reading from the lookup until the last Read(),
+		 * so that a segment isn't removed by a compaction running in
+		 * another thread in between.
+		 */
+		QReadWriteLock& GetRemovalLock () const;
+	private:
+		QString GetSegmentPath (int) const;
+		void OpenSegment (int);
+		void RecoverCurrentSegment ();
+		Mapping_ptr GetMapping (int, qint64 minSize) const;
+	};
+
+	typedef std::shared_ptr<SegmentStore> SegmentStore_ptr;
+}
+}
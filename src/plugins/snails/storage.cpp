@@ -30,19 +30,22 @@
 #include "storage.h"
 #include <stdexcept>
 #include <QFile>
+#include <QFileInfo>
 #include <QApplication>
-#include <QtConcurrentMap>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDataStream>
 #include <QtConcurrentRun>
 #include <QFutureWatcher>
+#include <QReadLocker>
 #include <util/db/dblock.h>
 #include <util/sys/paths.h>
+#include <util/threads/futures.h>
 #include "xmlsettingsmanager.h"
 #include "account.h"
 #include "accountdatabase.h"
+#include "storagemaintenance.h"
 
 namespace LeechCraft
 {
@@ -50,14 +53,12 @@ namespace Snails
 {
 	namespace
 	{
-		template<typename T>
-		QByteArray Serialize (const T& t)
+		struct SavedMessage_t
 		{
-			QByteArray result;
-			QDataStream stream (&result, QIODevice::WriteOnly);
-			stream << t;
-			return result;
-		}
+			Message_ptr Msg_;
+			SegmentLocation Loc_;
+			SearchIndexEntry Index_;
+		};
 	}
 
 	Storage::Storage (QObject *parent)
@@ -68,66 +69,56 @@ namespace Snails
 		SDir_ = Util::CreateIfNotExists ("snails/storage");
 	}
 
+	Storage::~Storage ()
+	{
+		for (auto future : Maintenance_)
+			future.waitForFinished ();
+	}
+
 	namespace
 	{
-		QList<Message_ptr> MessageSaverProc (QList<Message_ptr> msgs, const QDir dir)
+		QList<SavedMessage_t> MessageSaverProc (QList<Message_ptr> msgs, const SegmentStore_ptr store)
 		{
+			QList<SavedMessage_t> result;
 			for (const auto& msg : msgs)
 			{
 				if (msg->GetFolderID ().isEmpty ())
 					continue;
 
-				const QString dirName = msg->GetFolderID ().toHex ().right (3);
-
-				QDir msgDir = dir;
-				if (!dir.exists (dirName))
-					msgDir.mkdir (dirName);
-				if (!msgDir.cd (dirName))
+				try
+				{
+					const auto& loc = store->Append (qCompress (msg->Serialize (), MessageCompressionLevel));
+					result.append ({ msg, loc, MakeSearchIndexEntry (msg) });
+				}
+				catch (const std::exception& e)
 				{
 					qWarning () << Q_FUNC_INFO
-							<< "unable to cd into"
-							<< msgDir.filePath (dirName);
-					continue;
+							<< "unable to save"
+							<< msg->GetFolderID ()
+							<< e.what ();
 				}
-
-				QFile file (msgDir.filePath (msg->GetFolderID ().toHex ()));
-				file.open (QIODevice::WriteOnly);
-				file.write (qCompress (msg->Serialize (), 9));
 			}
 
-			return msgs;
+			store->Flush ();
+
+			return result;
 		}
 	}
 
 	void Storage::SaveMessages (Account *acc, const QStringList& folder, const QList<Message_ptr>& msgs)
 	{
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.exists (subdir))
-				dir.mkdir (subdir);
+		const auto& store = StoreForAccount (acc);
 
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
-
-		for (const auto& msg : msgs)
-			PendingSaveMessages_ [acc] [msg->GetFolderID ()] = msg;
+		const auto seq = PendingSaveMessages_ [acc].Add (msgs);
 
-		auto watcher = new QFutureWatcher<QList<Message_ptr>> ();
-		FutureWatcher2Account_ [watcher] = acc;
+		auto watcher = new QFutureWatcher<QList<SavedMessage_t>> ();
+		FutureWatcher2Save_ [watcher] = { acc, folder, seq };
 
 		connect (watcher,
 				SIGNAL (finished ()),
 				this,
 				SLOT (handleMessagesSaved ()));
-		auto future = QtConcurrent::run (MessageSaverProc, msgs, dir);
+		auto future = QtConcurrent::run (MessageSaverProc, msgs, store);
 		watcher->setFuture (future);
 
 		for (const auto& msg : msgs)
@@ -144,49 +135,21 @@ namespace Snails
 	{
 		MessageSet result;
 
-		const QDir& dir = DirForAccount (acc);
-		for (const auto& str : dir.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
+		const auto& base = BaseForAccount (acc);
+		const auto& store = StoreForAccount (acc);
+
+		QReadLocker locker { &store->GetRemovalLock () };
+		for (const auto& msg : ReadMessages (store, base->GetAllMessageLocations ()))
 		{
-			QDir subdir = dir;
-			if (!subdir.cd (str))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< str;
+			if (!msg)
 				continue;
-			}
-
-			for (const auto& str : subdir.entryList (QDir::NoDotAndDotDot | QDir::Files))
-			{
-				QFile file (subdir.filePath (str));
-				if (!file.open (QIODevice::ReadOnly))
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "unable to open"
-							<< str
-							<< file.errorString ();
-					continue;
-				}
 
-				const auto& msg = std::make_shared<Message> ();
-				try
-				{
-					msg->Deserialize (qUncompress (file.readAll ()));
-				}
-				catch (const std::exception& e)
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "error deserializing the message from"
-							<< file.fileName ()
-							<< e.what ();
-					continue;
-				}
-				result << msg;
-				UpdateCaches (msg);
-			}
+			result << msg;
+			UpdateCaches (msg);
 		}
+		locker.unlock ();
 
-		for (const auto& msg : PendingSaveMessages_ [acc])
+		for (const auto& msg : PendingSaveMessages_ [acc].GetAll ())
 		{
 			result << msg;
 			UpdateCaches (msg);
@@ -197,99 +160,89 @@ namespace Snails
 
 	Message_ptr Storage::LoadMessage (Account *acc, const QStringList& folder, const QByteArray& id)
 	{
-		if (PendingSaveMessages_ [acc].contains (id))
-			return PendingSaveMessages_ [acc] [id];
+		if (const auto& pending = PendingSaveMessages_ [acc].Get (id))
+			return pending;
 
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
+		const auto& store = StoreForAccount (acc);
+		QReadLocker locker { &store->GetRemovalLock () };
+
+		const auto& loc = BaseForAccount (acc)->GetMessageLocation (id, folder);
+		if (!loc)
 		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
+			qWarning () << Q_FUNC_INFO
+					<< "no stored message"
+					<< id
+					<< "in"
+					<< folder;
+			throw std::runtime_error ("Unable to find the message in the storage");
 		}
 
-		const auto& msg = LoadMessage (acc, dir, id);
+		const auto& msg = ReadMessage (store, *loc);
+		locker.unlock ();
+
 		UpdateCaches (msg);
 		return msg;
 	}
 
-	Message_ptr Storage::LoadMessage (Account *acc, QDir dir, const QByteArray& id) const
+	QList<Message_ptr> Storage::LoadMessages (Account *acc, const QStringList& folder, const QList<QByteArray>& ids)
 	{
-		if (PendingSaveMessages_ [acc].contains (id))
-			return PendingSaveMessages_ [acc] [id];
+		const auto& pending = PendingSaveMessages_ [acc];
+		const auto& store = StoreForAccount (acc);
 
-		if (!dir.cd (id.toHex ().right (3)))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to cd to"
-					<< dir.filePath (id.toHex ().right (3));
-			throw std::runtime_error ("Unable to cd to the directory");
-		}
+		QReadLocker locker { &store->GetRemovalLock () };
+		const auto& folderLocs = BaseForAccount (acc)->GetMessageLocations (folder);
 
-		QFile file (dir.filePath (id.toHex ()));
-		if (!file.open (QIODevice::ReadOnly))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to open"
-					<< file.fileName ()
-					<< file.errorString ();
-			throw std::runtime_error ("Unable to open the message file");
-		}
+		QList<Message_ptr> ordered;
 
-		const auto& msg = std::make_shared<Message> ();
-		try
-		{
-			msg->Deserialize (qUncompress (file.readAll ()));
-		}
-		catch (const std::exception& e)
+		QList<SegmentLocation> locs;
+		QList<int> locPositions;
+		for (const auto& id : ids)
 		{
-			qWarning () << Q_FUNC_INFO
-					<< "error deserializing the message from"
-					<< file.fileName ()
-					<< e.what ();
-			throw;
-		}
-
-		return msg;
-	}
+			if (const auto& pendingMsg = pending.Get (id))
+			{
+				ordered << pendingMsg;
+				continue;
+			}
 
-	QList<Message_ptr> Storage::LoadMessages (Account *acc, const QStringList& folder, const QList<QByteArray>& ids)
-	{
-		auto rootDir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!rootDir.cd (subdir))
+			const auto locPos = folderLocs.find (id);
+			if (locPos == folderLocs.end ())
 			{
 				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< rootDir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
+						<< "no stored message"
+						<< id
+						<< "in"
+						<< folder;
+				continue;
 			}
+
+			locPositions << ordered.size ();
+			ordered << Message_ptr {};
+			locs << *locPos;
 		}
 
-		QList<Message_ptr> result;
-		auto future = QtConcurrent::mapped (ids,
-				std::function<Message_ptr (QByteArray)>
-				{
-					[this, acc, rootDir] (const QByteArray& id)
-						{ return LoadMessage (acc, rootDir, id); }
-				});
+		const auto& read = ReadMessages (store, locs);
+		locker.unlock ();
 
-		for (const auto& item : future.results ())
-			result << item;
+		for (int i = 0; i < read.size (); ++i)
+			ordered [locPositions.at (i)] = read.at (i);
 
-		for (const auto& msg : result)
-			UpdateCaches (msg);
+		QList<Message_ptr> result;
+		for (const auto& msg : ordered)
+		{
+			if (!msg)
+				continue;
 
+			result << msg;
+			UpdateCaches (msg);
+		}
 		return result;
 	}
 
+	QList<MessageInfo> Storage::LoadMessageInfos (Account *acc, const QStringList& folder, MessageListCursor& cursor, int count)
+	{
+		return BaseForAccount (acc)->GetMessageInfos (folder, cursor, count);
+	}
+
 	QList<QByteArray> Storage::LoadIDs (Account *acc, const QStringList& folder)
 	{
 		return BaseForAccount (acc)->GetIDs (folder);
@@ -297,32 +250,14 @@ namespace Snails
 
 	void Storage::RemoveMessage (Account *acc, const QStringList& folder, const QByteArray& id)
 	{
-		PendingSaveMessages_ [acc].remove (id);
+		PendingSaveMessages_ [acc].Remove (id);
 
-		BaseForAccount (acc)->RemoveMessage (id, folder,
-				[this, acc, folder, id] { RemoveMessageFile (acc, folder, id); });
+		BaseForAccount (acc)->RemoveMessage (id, folder);
 	}
 
-	int Storage::GetNumMessages (Account *acc) const
+	int Storage::GetNumMessages (Account *acc)
 	{
-		int result = 0;
-
-		const QDir& dir = DirForAccount (acc);
-		for (const auto& str : dir.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
-		{
-			QDir subdir = dir;
-			if (!subdir.cd (str))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< str;
-				continue;
-			}
-
-			result += subdir.entryList (QDir::NoDotAndDotDot | QDir::Files).size ();
-		}
-
-		return result;
+		return BaseForAccount (acc)->GetMessageCount ();
 	}
 
 	int Storage::GetNumMessages (Account *acc, const QStringList& folder)
@@ -335,7 +270,7 @@ namespace Snails
 		return BaseForAccount (acc)->GetUnreadMessageCount (folder);
 	}
 
-	bool Storage::HasMessagesIn (Account *acc) const
+	bool Storage::HasMessagesIn (Account *acc)
 	{
 		return GetNumMessages (acc);
 	}
@@ -348,41 +283,25 @@ namespace Snails
 		return LoadMessage (acc, folder, id)->IsRead ();
 	}
 
-	void Storage::RemoveMessageFile (Account *acc, const QStringList& folder, const QByteArray& id)
+	QHash<QByteArray, bool> Storage::LoadReadStatuses (Account *acc, const QStringList& folder)
 	{
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
+		return BaseForAccount (acc)->GetReadStatuses (folder);
+	}
 
-		if (!dir.cd (id.toHex ().right (3)))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to cd to"
-					<< dir.filePath (id.toHex ().right (3));
-			throw std::runtime_error ("Unable to cd to the directory");
-		}
+	QList<QByteArray> Storage::Search (Account *acc, const QStringList& folder,
+			const QString& match, int offset, int limit)
+	{
+		return BaseForAccount (acc)->Search (folder, match, offset, limit);
+	}
 
-		QFile file (dir.filePath (id.toHex ()));
-		if (!file.exists ())
-			return;
+	boost::optional<FolderSyncState> Storage::GetFolderSyncState (Account *acc, const QStringList& folder)
+	{
+		return BaseForAccount (acc)->GetFolderSyncState (folder);
+	}
 
-		qDebug () << "removing" << file.fileName () << file.size ();
-		if (!file.remove ())
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to remove the file:"
-					<< file.errorString ();
-			throw std::runtime_error ("Unable to remove the file");
-		}
+	void Storage::SetFolderSyncState (Account *acc, const QStringList& folder, const FolderSyncState& state)
+	{
+		BaseForAccount (acc)->SetFolderSyncState (folder, state);
 	}
 
 	QDir Storage::DirForAccount (Account *acc) const
@@ -409,11 +328,48 @@ namespace Snails
 			return AccountBases_ [acc];
 
 		const auto& dir = DirForAccount (acc);
-		const auto& base = std::make_shared<AccountDatabase> (dir, acc);
+		const auto& base = std::make_shared<AccountDatabase> (dir, QString { "SnailsStorage_" + acc->GetID () });
 		AccountBases_ [acc] = base;
+
+		StartMaintenance (acc, StoreForAccount (acc));
+
 		return base;
 	}
 
+	SegmentStore_ptr Storage::StoreForAccount (Account *acc)
+	{
+		if (AccountStores_.contains (acc))
+			return AccountStores_ [acc];
+
+		auto dir = DirForAccount (acc);
+		if (!dir.exists ("segments"))
+			dir.mkdir ("segments");
+		if (!dir.cd ("segments"))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to cd into"
+					<< dir.filePath ("segments");
+			throw std::runtime_error ("Unable to cd to the dir");
+		}
+
+		const auto& store = std::make_shared<SegmentStore> (dir);
+		AccountStores_ [acc] = store;
+		return store;
+	}
+
+	void Storage::StartMaintenance (Account *acc, const SegmentStore_ptr& store)
+	{
+		const auto& future = QtConcurrent::run (RunStorageMaintenance,
+				DirForAccount (acc),
+				acc->GetName (),
+				QString { "SnailsStorageMaintenance_" + acc->GetID () },
+				store);
+		Maintenance_ [acc] = future;
+
+		Util::Sequence (this, future) >>
+				[this, acc] { emit maintenanceFinished (acc); };
+	}
+
 	void Storage::AddMessage (Message_ptr msg, Account *acc)
 	{
 		const auto& base = BaseForAccount (acc);
@@ -427,11 +383,10 @@ namespace Snails
 
 	void Storage::handleMessagesSaved ()
 	{
-		auto watcher = dynamic_cast<QFutureWatcher<QList<Message_ptr>>*> (sender ());
+		auto watcher = dynamic_cast<QFutureWatcher<QList<SavedMessage_t>>*> (sender ());
 		watcher->deleteLater ();
 
-		auto acc = FutureWatcher2Account_.take (watcher);
-		if (!acc)
+		if (!FutureWatcher2Save_.contains (watcher))
 		{
 			qWarning () << Q_FUNC_INFO
 					<< "no account for future watcher"
@@ -439,11 +394,26 @@ namespace Snails
 			return;
 		}
 
-		auto& hash = PendingSaveMessages_ [acc];
+		const auto& save = FutureWatcher2Save_.take (watcher);
+
+		auto& pending = PendingSaveMessages_ [save.Acc_];
+
+		const auto& base = BaseForAccount (save.Acc_);
+		Util::DBLock lock { base->GetDB () };
+		lock.Init ();
+
+		for (const auto& saved : watcher->result ())
+		{
+			// The message might have been removed or saved again while
+			// this batch was being written.
+			if (!pending.Finish (saved.Msg_, save.Seq_))
+				continue;
+
+			base->SetMessageLocation (saved.Msg_->GetFolderID (), save.Folder_, saved.Loc_);
+			base->IndexMessage (saved.Index_);
+		}
 
-		auto messages = watcher->result ();
-		for (const auto& msg : messages)
-			hash.remove (msg->GetFolderID ());
+		lock.Good ();
 	}
 }
 }
@@ -34,7 +34,12 @@
 #include <QSettings>
 #include <QHash>
 #include <QSet>
+#include <QFuture>
 #include "message.h"
+#include "segmentstore.h"
+#include "incrementalsync.h"
+#include "messageinfo.h"
+#include "pendingsaves.h"
 
 namespace LeechCraft
 {
@@ -54,11 +59,21 @@ namespace Snails
 		QHash<QByteArray, bool> IsMessageRead_;
 
 		QHash<Account*, AccountDatabase_ptr> AccountBases_;
-		QHash<Account*, QHash<QByteArray, Message_ptr>> PendingSaveMessages_;
+		QHash<Account*, SegmentStore_ptr> AccountStores_;
+		QHash<Account*, PendingSaves> PendingSaveMessages_;
 
-		QHash<QObject*, Account*> FutureWatcher2Account_;
+		struct PendingSave
+		{
+			Account *Acc_;
+			QStringList Folder_;
+			quint64 Seq_;
+		};
+		QHash<QObject*, PendingSave> FutureWatcher2Save_;
+
+		QHash<Account*, QFuture<void>> Maintenance_;
 	public:
 		Storage (QObject* = 0);
+		~Storage ();
 
 		void SaveMessages (Account*, const QStringList& folders, const QList<Message_ptr>&);
 
@@ -66,26 +81,45 @@ namespace Snails
 		Message_ptr LoadMessage (Account*, const QStringList& folder, const QByteArray& id);
 		QList<Message_ptr> LoadMessages (Account*, const QStringList& folder, const QList<QByteArray>& ids);
 
+		QList<MessageInfo> LoadMessageInfos (Account*, const QStringList& folder, MessageListCursor& cursor, int count);
+
 		QList<QByteArray> LoadIDs (Account*, const QStringList& folder);
 		void RemoveMessage (Account*, const QStringList&, const QByteArray&);
 
-		int GetNumMessages (Account*) const;
+		int GetNumMessages (Account*);
 		int GetNumMessages (Account*, const QStringList& folder);
 		int GetNumUnread (Account*, const QStringList& folder);
-		bool HasMessagesIn (Account*) const;
+		bool HasMessagesIn (Account*);
 
 		bool IsMessageRead (Account*, const QStringList& folder, const QByteArray&);
-	private:
-		Message_ptr LoadMessage (Account*, QDir, const QByteArray&) const;
-		void RemoveMessageFile (Account*, const QStringList&, const QByteArray&);
+		QHash<QByteArray, bool> LoadReadStatuses (Account*, const QStringList& folder);
+
+		/* Returns IDs of messages in the folder matching the given FTS4
+		 * MATCH expression, see BuildFTSQuery().
+		 */
+		QList<QByteArray> Search (Account*, const QStringList& folder,
+				const QString& match, int offset, int limit);
+
+		boost::optional<FolderSyncState> GetFolderSyncState (Account*, const QStringList& folder);
+		void SetFolderSyncState (Account*, const QStringList& folder, const FolderSyncState&);
 	private:
 		QDir DirForAccount (Account*) const;
 		AccountDatabase_ptr BaseForAccount (Account*);
+		SegmentStore_ptr StoreForAccount (Account*);
+
+		void StartMaintenance (Account*, const SegmentStore_ptr&);
 
 		void AddMessage (Message_ptr, Account*);
 		void UpdateCaches (Message_ptr);
 	private slots:
 		void handleMessagesSaved ();
+	signals:
+		/** Emitted when the legacy files migration, segments compaction
+		 * and other startup maintenance of the account storage started
+		 * on its first access is finished, so messages that have been
+		 * migrated meanwhile are available now.
+		 */
+		void maintenanceFinished (Account*);
 	};
 }
 }
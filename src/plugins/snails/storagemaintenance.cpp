@@ -0,0 +1,346 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "storagemaintenance.h"
+#include <stdexcept>
+#include <functional>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QtConcurrentMap>
+#include <QtDebug>
+#include <util/db/dblock.h>
+#include "accountdatabase.h"
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		/* Segments whose live data occupies less than this fraction of
+		 * their size are rewritten on startup.
+		 */
+		const double CompactionThreshold = 0.5;
+
+		/* The number of records committed to the index in a single
+		 * transaction during migration and compaction, so that the
+		 * main connection isn't locked out of the database for long.
+		 */
+		const int MaintenanceBatchSize = 500;
+	}
+
+	Message_ptr ReadMessage (const SegmentStore_ptr& store, const SegmentLocation& loc)
+	{
+		const auto& msg = std::make_shared<Message> ();
+		try
+		{
+			msg->Deserialize (qUncompress (store->Read (loc)));
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "error deserializing the message from"
+					<< loc.Segment_
+					<< loc.Offset_
+					<< e.what ();
+			throw;
+		}
+		return msg;
+	}
+
+	QList<Message_ptr> ReadMessages (const SegmentStore_ptr& store, const QList<SegmentLocation>& locs)
+	{
+		auto future = QtConcurrent::mapped (locs,
+				std::function<Message_ptr (SegmentLocation)>
+				{
+					[store] (const SegmentLocation& loc) -> Message_ptr
+					{
+						try
+						{
+							return ReadMessage (store, loc);
+						}
+						catch (const std::exception&)
+						{
+							return {};
+						}
+					}
+				});
+
+		return future.results ();
+	}
+
+	namespace
+	{
+		struct LegacyFile
+		{
+			QStringList Folder_;
+			QString Path_;
+		};
+
+		void CollectLegacyFiles (const QDir& dir, const QStringList& folder, QList<LegacyFile>& result)
+		{
+			for (const auto& name : dir.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
+			{
+				if (folder.isEmpty () && name == "segments")
+					continue;
+
+				QDir subdir = dir;
+				if (!subdir.cd (name))
+					continue;
+
+				// Folder path components are hex-encoded, so they are
+				// always of even length, unlike the 3-char buckets.
+				if (name.size () == 3)
+				{
+					for (const auto& file : subdir.entryList (QDir::Files))
+						result.append (LegacyFile { folder, subdir.filePath (file) });
+					continue;
+				}
+
+				const auto& elem = QString::fromUtf8 (QByteArray::fromHex (name.toLatin1 ()));
+				CollectLegacyFiles (subdir, folder + QStringList { elem }, result);
+			}
+		}
+
+		void RemoveLegacyFiles (const QList<LegacyFile>& files)
+		{
+			for (const auto& legacy : files)
+			{
+				QFile::remove (legacy.Path_);
+
+				auto dir = QFileInfo { legacy.Path_ }.dir ();
+				const auto& bucket = dir.dirName ();
+				if (dir.cdUp ())
+					dir.rmdir (bucket);
+			}
+		}
+	}
+
+	void MigrateLegacyFiles (const QDir& accDir, const QString& accName,
+			const AccountDatabase_ptr& base, const SegmentStore_ptr& store)
+	{
+		QList<LegacyFile> files;
+		CollectLegacyFiles (accDir, {}, files);
+		if (files.isEmpty ())
+			return;
+
+		qDebug () << Q_FUNC_INFO
+				<< "migrating"
+				<< files.size ()
+				<< "message files to segments for"
+				<< accName;
+
+		for (int batchStart = 0; batchStart < files.size (); batchStart += MaintenanceBatchSize)
+		{
+			const auto& batch = files.mid (batchStart, MaintenanceBatchSize);
+
+			Util::DBLock lock { base->GetDB () };
+			lock.Init ();
+
+			for (const auto& legacy : batch)
+			{
+				QFile file { legacy.Path_ };
+				if (!file.open (QIODevice::ReadOnly))
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to open"
+							<< legacy.Path_
+							<< file.errorString ();
+					continue;
+				}
+
+				const auto& data = qUncompress (file.readAll ());
+				if (data.isEmpty ())
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to uncompress"
+							<< legacy.Path_;
+					continue;
+				}
+
+				const auto& id = QByteArray::fromHex (QFileInfo { legacy.Path_ }.fileName ().toLatin1 ());
+				const auto& loc = store->Append (qCompress (data, MessageCompressionLevel));
+				base->SetMessageLocation (id, legacy.Folder_, loc);
+			}
+
+			store->Flush ();
+			lock.Good ();
+
+			RemoveLegacyFiles (batch);
+		}
+	}
+
+	void CompactSegments (const AccountDatabase_ptr& base, const SegmentStore_ptr& store)
+	{
+		const auto& usage = base->GetSegmentsUsage ();
+		const auto current = store->GetCurrentSegment ();
+
+		for (const auto segment : store->GetSegments ())
+		{
+			if (segment == current)
+				continue;
+
+			const auto size = store->GetSegmentSize (segment);
+			const auto live = usage.value (segment);
+			if (size && live >= size * CompactionThreshold)
+				continue;
+
+			qDebug () << Q_FUNC_INFO
+					<< "compacting segment"
+					<< segment
+					<< "with"
+					<< live
+					<< "live bytes of"
+					<< size;
+
+			try
+			{
+				store->Compact (segment, base->GetSegmentLocations (segment),
+						[&base] (const QList<SegmentRelocation>& relocations)
+						{
+							Util::DBLock lock { base->GetDB () };
+							lock.Init ();
+							for (const auto& reloc : relocations)
+								base->UpdateMessageLocation (reloc.Key_, reloc.Old_, reloc.New_);
+							lock.Good ();
+						},
+						MaintenanceBatchSize);
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to compact segment"
+						<< segment
+						<< e.what ();
+			}
+		}
+	}
+
+	namespace
+	{
+		typedef std::function<QList<QPair<int, SegmentLocation>> (int afterId, int limit)> LocationsGetter_f;
+
+		/* Walks the locations returned by the getter by ascending ID a
+		 * batch at a time, passing each message that could be read to
+		 * the handler within a transaction per batch. Returns the number
+		 * of such messages.
+		 */
+		int ForEachMessageBatch (const AccountDatabase_ptr& base, const SegmentStore_ptr& store,
+				const LocationsGetter_f& getter, int batchSize,
+				const std::function<void (Message_ptr)>& handler)
+		{
+			int lastId = 0;
+			int handled = 0;
+			while (true)
+			{
+				const auto& batch = getter (lastId, batchSize);
+				if (batch.isEmpty ())
+					break;
+
+				lastId = batch.last ().first;
+
+				QList<SegmentLocation> locs;
+				for (const auto& pair : batch)
+					locs << pair.second;
+				const auto& msgs = ReadMessages (store, locs);
+
+				Util::DBLock lock { base->GetDB () };
+				lock.Init ();
+				for (const auto& msg : msgs)
+					if (msg)
+					{
+						handler (msg);
+						++handled;
+					}
+				lock.Good ();
+
+				if (batch.size () < batchSize)
+					break;
+			}
+			return handled;
+		}
+	}
+
+	void FillMessageInfos (const AccountDatabase_ptr& base, const SegmentStore_ptr& store, int batchSize)
+	{
+		if (!base->HasMissingMessageInfos ())
+			return;
+
+		const auto filled = ForEachMessageBatch (base, store,
+				[base] (int afterId, int limit) { return base->GetMissingInfoMessageLocations (afterId, limit); },
+				batchSize,
+				[base] (const Message_ptr& msg) { base->UpdateMessageInfo (msg); });
+
+		// The ones left are missing from the store or failed to load.
+		base->AddPlaceholderMessageInfos ();
+
+		qDebug () << Q_FUNC_INFO
+				<< "filled message list entries for"
+				<< filled
+				<< "stored messages";
+	}
+
+	void FillSearchIndex (const AccountDatabase_ptr& base, const SegmentStore_ptr& store, int batchSize)
+	{
+		const auto indexed = ForEachMessageBatch (base, store,
+				[base] (int afterId, int limit) { return base->GetUnindexedMessageLocations (afterId, limit); },
+				batchSize,
+				[base] (const Message_ptr& msg) { base->IndexMessage (msg); });
+
+		if (indexed)
+			qDebug () << Q_FUNC_INFO
+					<< "indexed"
+					<< indexed
+					<< "stored messages";
+	}
+
+	void RunStorageMaintenance (const QDir& accDir, const QString& accName,
+			const QString& connName, const SegmentStore_ptr& store)
+	{
+		try
+		{
+			const auto& base = std::make_shared<AccountDatabase> (accDir, connName);
+			MigrateLegacyFiles (accDir, accName, base, store);
+			CompactSegments (base, store);
+			FillMessageInfos (base, store);
+			FillSearchIndex (base, store);
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "storage maintenance failed for"
+					<< accName
+					<< e.what ();
+		}
+
+		QSqlDatabase::removeDatabase (connName);
+	}
+}
+}
@@ -0,0 +1,92 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QList>
+#include "message.h"
+#include "segmentstore.h"
+
+class QDir;
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	class AccountDatabase;
+	typedef std::shared_ptr<AccountDatabase> AccountDatabase_ptr;
+
+	/* Messages are (de)compressed on each sync and folder open, so
+	 * favour speed over ratio here.
+	 */
+	const int MessageCompressionLevel = 1;
+
+	/* Reads and deserializes the message at the given location, throwing
+	 * if it can't be read.
+	 */
+	Message_ptr ReadMessage (const SegmentStore_ptr&, const SegmentLocation&);
+
+	/* Reads the messages concurrently and returns them in the order of
+	 * the locations, with null pointers in place of the ones that failed
+	 * to load.
+	 */
+	QList<Message_ptr> ReadMessages (const SegmentStore_ptr&, const QList<SegmentLocation>&);
+
+	/* Moves the messages stored as separate files by older versions
+	 * into the segment store.
+	 */
+	void MigrateLegacyFiles (const QDir& accDir, const QString& accName,
+			const AccountDatabase_ptr&, const SegmentStore_ptr&);
+
+	/* Rewrites the segments that are mostly occupied by removed
+	 * messages.
+	 */
+	void CompactSegments (const AccountDatabase_ptr&, const SegmentStore_ptr&);
+
+	/* Fills the message list entries for the messages stored before
+	 * the entries have been introduced, reading batchSize messages at a
+	 * time.
+	 */
+	void FillMessageInfos (const AccountDatabase_ptr&, const SegmentStore_ptr&, int batchSize = 200);
+
+	/* Puts the stored messages missing from the full-text search index
+	 * (like the ones stored before the index has been introduced) into
+	 * the index, reading batchSize messages at a time.
+	 */
+	void FillSearchIndex (const AccountDatabase_ptr&, const SegmentStore_ptr&, int batchSize = 200);
+
+	/* Runs all of the above for the account storage in the given
+	 * directory, using its own database connection with the given name.
+	 * Meant to be run in a separate thread.
+	 */
+	void RunStorageMaintenance (const QDir& accDir, const QString& accName,
+			const QString& connName, const SegmentStore_ptr&);
+}
+}
@@ -0,0 +1,478 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "fakeimapserver.h"
+#include <memory>
+#include <algorithm>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QRegExp>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		const QByteArray Capabilities = "IMAP4rev1 CONDSTORE";
+
+		void Write (QTcpSocket& socket, const QByteArray& data)
+		{
+			socket.write (data);
+			socket.waitForBytesWritten (1000);
+		}
+
+		QByteArray Quote (QByteArray str)
+		{
+			str.replace ('\\', "\\\\");
+			str.replace ('"', "\\\"");
+			return '"' + str + '"';
+		}
+
+		QByteArray Join (const QList<QByteArray>& parts)
+		{
+			QByteArray result;
+			for (const auto& part : parts)
+			{
+				if (!result.isEmpty ())
+					result += ' ';
+				result += part;
+			}
+			return result;
+		}
+
+		QByteArray Literal (const QByteArray& data)
+		{
+			return '{' + QByteArray::number (data.size ()) + "}\r\n" + data;
+		}
+
+		QByteArray MakeMessageId (const FakeImapMessage& msg)
+		{
+			return '<' + QByteArray::number (msg.UID_) + "@fake.example.com>";
+		}
+
+		QByteArray MakeHeader (const FakeImapMessage& msg)
+		{
+			return "From: Alice <alice@example.com>\r\n"
+					"To: Bob <bob@example.com>\r\n"
+					"Subject: " + msg.Subject_ + "\r\n"
+					"Message-ID: " + MakeMessageId (msg) + "\r\n"
+					"Date: Mon, 19 Oct 2026 12:00:00 +0000\r\n"
+					"MIME-Version: 1.0\r\n"
+					"Content-Type: text/plain; charset=us-ascii\r\n"
+					"\r\n";
+		}
+
+		QByteArray MakeBody (const FakeImapMessage& msg)
+		{
+			return "Message #" + QByteArray::number (msg.UID_) + "\r\n";
+		}
+
+		QByteArray MakeEnvelope (const FakeImapMessage& msg)
+		{
+			const QByteArray alice = "((\"Alice\" NIL \"alice\" \"example.com\"))";
+			const QByteArray bob = "((\"Bob\" NIL \"bob\" \"example.com\"))";
+			return "(\"Mon, 19 Oct 2026 12:00:00 +0000\" " + Quote (msg.Subject_) + ' ' +
+					alice + ' ' + alice + ' ' + alice + ' ' + bob +
+					" NIL NIL NIL " + Quote (MakeMessageId (msg)) + ')';
+		}
+
+		QByteArray MakeBodyStructure (const FakeImapMessage& msg)
+		{
+			return "(\"TEXT\" \"PLAIN\" (\"CHARSET\" \"us-ascii\") NIL NIL \"7BIT\" " +
+					QByteArray::number (MakeBody (msg).size ()) + " 1)";
+		}
+
+		/* Splits the FETCH items list (with or without the enclosing
+		 * parens) into separate items, keeping the sections like
+		 * BODY.PEEK[HEADER.FIELDS (Subject)] intact.
+		 */
+		QStringList SplitFetchItems (QByteArray items)
+		{
+			items = items.trimmed ();
+			if (items.startsWith ('(') && items.endsWith (')'))
+				items = items.mid (1, items.size () - 2);
+
+			QStringList result;
+			QByteArray current;
+			int depth = 0;
+			for (const char c : items)
+			{
+				if (c == '[' || c == '(')
+					++depth;
+				else if (c == ']' || c == ')')
+					--depth;
+
+				if (c == ' ' && !depth)
+				{
+					if (!current.isEmpty ())
+						result << QString::fromLatin1 (current);
+					current.clear ();
+				}
+				else
+					current += c;
+			}
+			if (!current.isEmpty ())
+				result << QString::fromLatin1 (current);
+			return result;
+		}
+
+		/* Returns the items list of FETCH args following the sequence
+		 * set, dropping modifiers like (CHANGEDSINCE n).
+		 */
+		QByteArray GetFetchItems (const QByteArray& args)
+		{
+			if (!args.startsWith ('('))
+				return args.left (args.indexOf (' '));
+
+			int depth = 0;
+			for (int i = 0; i < args.size (); ++i)
+			{
+				const auto c = args.at (i);
+				if (c == '(' || c == '[')
+					++depth;
+				else if ((c == ')' || c == ']') && !--depth)
+					return args.left (i + 1);
+			}
+			return args;
+		}
+
+		bool InSequenceSet (const QByteArray& set, quint32 value, quint32 max)
+		{
+			for (const auto& range : set.split (','))
+			{
+				const auto& bounds = range.split (':');
+				auto toNum = [max] (const QByteArray& str) { return str == "*" ? max : str.toUInt (); };
+
+				const auto first = toNum (bounds.value (0));
+				const auto last = toNum (bounds.value (bounds.size () - 1));
+				if (value >= std::min (first, last) && value <= std::max (first, last))
+					return true;
+			}
+			return false;
+		}
+	}
+
+	FakeImapServer::~FakeImapServer ()
+	{
+		Stop ();
+	}
+
+	quint16 FakeImapServer::Start ()
+	{
+		start ();
+		Started_.acquire ();
+		return Port_;
+	}
+
+	void FakeImapServer::Stop ()
+	{
+		{
+			QMutexLocker locker { &Mutex_ };
+			Stopped_ = true;
+		}
+		wait ();
+	}
+
+	void FakeImapServer::SetMessages (const QList<FakeImapMessage>& messages)
+	{
+		QMutexLocker locker { &Mutex_ };
+		Messages_ = messages;
+	}
+
+	void FakeImapServer::SetState (quint32 uidValidity, quint64 highestModSeq)
+	{
+		QMutexLocker locker { &Mutex_ };
+		UIDValidity_ = uidValidity;
+		HighestModSeq_ = highestModSeq;
+	}
+
+	QStringList FakeImapServer::GetCommands () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Commands_;
+	}
+
+	QList<FakeImapFetch> FakeImapServer::GetFetches () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Fetches_;
+	}
+
+	void FakeImapServer::ClearLog ()
+	{
+		QMutexLocker locker { &Mutex_ };
+		Commands_.clear ();
+		Fetches_.clear ();
+	}
+
+	void FakeImapServer::run ()
+	{
+		QTcpServer server;
+		if (server.listen (QHostAddress::LocalHost))
+			Port_ = server.serverPort ();
+		else
+			qWarning () << Q_FUNC_INFO
+					<< "unable to listen:"
+					<< server.errorString ();
+		Started_.release ();
+
+		if (!Port_)
+			return;
+
+		while (!IsStopped ())
+		{
+			if (!server.waitForNewConnection (100))
+				continue;
+
+			const std::unique_ptr<QTcpSocket> socket { server.nextPendingConnection () };
+			Serve (*socket);
+			socket->disconnectFromHost ();
+		}
+	}
+
+	bool FakeImapServer::IsStopped () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Stopped_;
+	}
+
+	bool FakeImapServer::ReadLine (QTcpSocket& socket, QByteArray& line)
+	{
+		while (!socket.canReadLine ())
+		{
+			if (IsStopped () || socket.state () != QAbstractSocket::ConnectedState)
+				return false;
+			socket.waitForReadyRead (100);
+		}
+
+		line = socket.readLine ();
+		return true;
+	}
+
+	bool FakeImapServer::ReadCommand (QTcpSocket& socket, QByteArray& command)
+	{
+		if (!ReadLine (socket, command))
+			return false;
+
+		// Synchronizing literals: {n}\r\n, the client waits for a
+		// continuation request before sending the n octets.
+		QRegExp literalRx { "\\{(\\d+)\\}\\r?\\n$" };
+		while (literalRx.indexIn (QString::fromLatin1 (command)) != -1)
+		{
+			const auto size = literalRx.cap (1).toInt ();
+			command.chop (literalRx.matchedLength ());
+			Write (socket, "+ Ready for literal data\r\n");
+
+			while (socket.bytesAvailable () < size)
+			{
+				if (IsStopped () || socket.state () != QAbstractSocket::ConnectedState)
+					return false;
+				socket.waitForReadyRead (100);
+			}
+			command += Quote (socket.read (size));
+
+			QByteArray rest;
+			if (!ReadLine (socket, rest))
+				return false;
+			command += rest;
+		}
+
+		command = command.trimmed ();
+		return true;
+	}
+
+	void FakeImapServer::Serve (QTcpSocket& socket)
+	{
+		Write (socket, "* OK [CAPABILITY " + Capabilities + "] Fake IMAP server ready\r\n");
+
+		QByteArray line;
+		while (ReadCommand (socket, line))
+		{
+			const auto tagEnd = line.indexOf (' ');
+			if (tagEnd <= 0)
+			{
+				Write (socket, "* BAD Missing tag\r\n");
+				continue;
+			}
+
+			const auto& tag = line.left (tagEnd);
+			auto rest = line.mid (tagEnd + 1);
+
+			auto nextToken = [&rest]
+			{
+				const auto end = rest.indexOf (' ');
+				const auto& token = end == -1 ? rest : rest.left (end);
+				rest = end == -1 ? QByteArray {} : rest.mid (end + 1);
+				return token.toUpper ();
+			};
+
+			auto command = nextToken ();
+			if (command == "UID")
+				command += ' ' + nextToken ();
+
+			if (!Handle (socket, tag, command, rest))
+				return;
+		}
+	}
+
+	bool FakeImapServer::Handle (QTcpSocket& socket,
+			const QByteArray& tag, const QByteArray& command, const QByteArray& args)
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		Commands_ << QString::fromLatin1 (args.isEmpty () ? command : command + ' ' + args);
+
+		const auto count = Messages_.size ();
+		const quint32 uidNext = Messages_.isEmpty () ? 1 : Messages_.last ().UID_ + 1;
+		const auto unseen = std::count_if (Messages_.begin (), Messages_.end (),
+				[] (const FakeImapMessage& msg) { return !msg.Seen_; });
+
+		if (command == "CAPABILITY")
+			Write (socket, "* CAPABILITY " + Capabilities + "\r\n");
+		else if (command == "LOGOUT")
+		{
+			Write (socket, "* BYE Fake IMAP server logging out\r\n");
+			Write (socket, tag + " OK LOGOUT completed\r\n");
+			return false;
+		}
+		else if (command == "LIST" || command == "LSUB")
+		{
+			if (args.endsWith ("\"\""))
+				Write (socket, "* " + command + " (\\Noselect) \"/\" \"\"\r\n");
+			else
+				Write (socket, "* " + command + " (\\HasNoChildren) \"/\" \"INBOX\"\r\n");
+		}
+		else if (command == "SELECT" || command == "EXAMINE")
+		{
+			Write (socket, "* FLAGS (\\Seen \\Answered \\Flagged \\Deleted \\Draft)\r\n");
+			Write (socket, "* " + QByteArray::number (count) + " EXISTS\r\n");
+			Write (socket, "* 0 RECENT\r\n");
+			Write (socket, "* OK [UIDVALIDITY " + QByteArray::number (UIDValidity_) + "] UIDs valid\r\n");
+			Write (socket, "* OK [UIDNEXT " + QByteArray::number (uidNext) + "] Predicted next UID\r\n");
+			Write (socket, "* OK [HIGHESTMODSEQ " + QByteArray::number (HighestModSeq_) + "] Highest\r\n");
+			Write (socket, tag + (command == "SELECT" ? " OK [READ-WRITE]" : " OK [READ-ONLY]") +
+					' ' + command + " completed\r\n");
+			return true;
+		}
+		else if (command == "STATUS")
+		{
+			QList<QByteArray> items;
+			auto addItem = [&items, &args] (const QByteArray& name, quint64 value)
+			{
+				if (args.toUpper ().contains (name))
+					items << name + ' ' + QByteArray::number (value);
+			};
+			addItem ("MESSAGES", count);
+			addItem ("RECENT", 0);
+			addItem ("UIDNEXT", uidNext);
+			addItem ("UIDVALIDITY", UIDValidity_);
+			addItem ("UNSEEN", unseen);
+			addItem ("HIGHESTMODSEQ", HighestModSeq_);
+
+			Write (socket, "* STATUS \"INBOX\" (" + Join (items) + ")\r\n");
+		}
+		else if (command == "FETCH" || command == "UID FETCH")
+			HandleFetch (socket, command == "UID FETCH", args);
+
+		Write (socket, tag + " OK " + command + " completed\r\n");
+		return true;
+	}
+
+	void FakeImapServer::HandleFetch (QTcpSocket& socket, bool byUid, const QByteArray& args)
+	{
+		const auto setEnd = args.indexOf (' ');
+		const auto& set = args.left (setEnd);
+		const auto& items = SplitFetchItems (GetFetchItems (args.mid (setEnd + 1)));
+
+		FakeImapFetch fetch { byUid, items, {} };
+
+		quint32 max = Messages_.size ();
+		if (byUid)
+			max = Messages_.isEmpty () ? 0 : Messages_.last ().UID_;
+
+		for (int i = 0; i < Messages_.size (); ++i)
+		{
+			const auto& msg = Messages_.at (i);
+			const auto seq = static_cast<quint32> (i + 1);
+			if (!InSequenceSet (set, byUid ? msg.UID_ : seq, max))
+				continue;
+
+			fetch.UIDs_ << msg.UID_;
+
+			QList<QByteArray> parts;
+			if (byUid && !items.contains ("UID", Qt::CaseInsensitive))
+				parts << "UID " + QByteArray::number (msg.UID_);
+
+			for (const auto& itemStr : items)
+			{
+				const auto& item = itemStr.toLatin1 ().toUpper ();
+				if (item == "UID")
+					parts << "UID " + QByteArray::number (msg.UID_);
+				else if (item == "FLAGS")
+					parts << (msg.Seen_ ? "FLAGS (\\Seen)" : "FLAGS ()");
+				else if (item == "RFC822.SIZE")
+					parts << "RFC822.SIZE " + QByteArray::number (MakeHeader (msg).size () + MakeBody (msg).size ());
+				else if (item == "INTERNALDATE")
+					parts << "INTERNALDATE \"19-Oct-2026 12:00:00 +0000\"";
+				else if (item == "ENVELOPE")
+					parts << "ENVELOPE " + MakeEnvelope (msg);
+				else if (item == "BODYSTRUCTURE" || item == "BODY")
+					parts << item + ' ' + MakeBodyStructure (msg);
+				else if (item == "MODSEQ")
+					parts << "MODSEQ (" + QByteArray::number (HighestModSeq_) + ')';
+				else if (item == "RFC822.HEADER")
+					parts << "RFC822.HEADER " + Literal (MakeHeader (msg));
+				else if (item == "RFC822")
+					parts << "RFC822 " + Literal (MakeHeader (msg) + MakeBody (msg));
+				else if (item.startsWith ("BODY[") || item.startsWith ("BODY.PEEK["))
+				{
+					const auto sectionStart = item.indexOf ('[') + 1;
+					const auto& section = item.mid (sectionStart, item.indexOf (']') - sectionStart);
+
+					QByteArray data;
+					if (section.startsWith ("HEADER"))
+						data = MakeHeader (msg);
+					else if (section == "TEXT")
+						data = MakeBody (msg);
+					else
+						data = MakeHeader (msg) + MakeBody (msg);
+
+					parts << "BODY[" + itemStr.toLatin1 ().mid (sectionStart, section.size ()) + "] " + Literal (data);
+				}
+			}
+
+			Write (socket, "* " + QByteArray::number (seq) + " FETCH (" + Join (parts) + ")\r\n");
+		}
+
+		Fetches_ << fetch;
+	}
+}
+}
@@ -0,0 +1,109 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QThread>
+#include <QMutex>
+#include <QSemaphore>
+#include <QStringList>
+#include <QList>
+
+class QTcpSocket;
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	struct FakeImapMessage
+	{
+		quint32 UID_;
+		bool Seen_;
+		QByteArray Subject_;
+	};
+
+	/* A single FETCH (or UID FETCH) command as seen by the server.
+	 */
+	struct FakeImapFetch
+	{
+		bool ByUID_;
+		QStringList Items_;
+		QList<quint32> UIDs_;
+	};
+
+	/* A minimal IMAP4rev1 server with a single INBOX folder, serving
+	 * just enough of the protocol for vmime to log in, select the folder,
+	 * query its STATUS and FETCH the messages. Every command received is
+	 * logged, so tests can check what the client has actually asked for.
+	 *
+	 * The server runs in its own thread with blocking sockets, so the
+	 * (blocking) vmime client can be driven from the test thread.
+	 */
+	class FakeImapServer : public QThread
+	{
+		mutable QMutex Mutex_;
+
+		QList<FakeImapMessage> Messages_;
+		quint32 UIDValidity_ = 1;
+		quint64 HighestModSeq_ = 1;
+
+		QStringList Commands_;
+		QList<FakeImapFetch> Fetches_;
+
+		QSemaphore Started_;
+		quint16 Port_ = 0;
+		bool Stopped_ = false;
+	public:
+		~FakeImapServer ();
+
+		/* Starts listening on a random localhost port and returns it, or
+		 * 0 on failure.
+		 */
+		quint16 Start ();
+		void Stop ();
+
+		void SetMessages (const QList<FakeImapMessage>&);
+		void SetState (quint32 uidValidity, quint64 highestModSeq);
+
+		QStringList GetCommands () const;
+		QList<FakeImapFetch> GetFetches () const;
+		void ClearLog ();
+	protected:
+		void run ();
+	private:
+		bool IsStopped () const;
+		bool ReadLine (QTcpSocket&, QByteArray&);
+		bool ReadCommand (QTcpSocket&, QByteArray&);
+
+		void Serve (QTcpSocket&);
+		bool Handle (QTcpSocket&, const QByteArray& tag, const QByteArray& command, const QByteArray& args);
+		void HandleFetch (QTcpSocket&, bool byUid, const QByteArray& args);
+	};
+}
+}
@@ -0,0 +1,220 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "incrementalsynctest.h"
+#include <algorithm>
+#include <QtTest>
+#include <QMap>
+#include "incrementalsync.h"
+
+QTEST_MAIN (LeechCraft::Snails::IncrementalSyncTest)
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		/* A stand-in for an IMAP mailbox keeping just the state
+		 * relevant for the incremental sync.
+		 */
+		class FakeMailbox
+		{
+			FolderSyncState State_;
+			QMap<quint32, bool> Messages_;
+		public:
+			FakeMailbox (bool condstore = true)
+			{
+				State_.UIDValidity_ = 42;
+				State_.UIDNext_ = 1;
+				State_.HighestModSeq_ = condstore ? 1 : 0;
+			}
+
+			FolderSyncState GetState () const
+			{
+				return State_;
+			}
+
+			int GetCount () const
+			{
+				return Messages_.size ();
+			}
+
+			QByteArray Append (bool read = false)
+			{
+				const auto uid = State_.UIDNext_++;
+				Messages_ [uid] = read;
+				BumpModSeq ();
+				return QByteArray::number (uid);
+			}
+
+			void SetRead (const QByteArray& uid, bool read)
+			{
+				Messages_ [uid.toUInt ()] = read;
+				BumpModSeq ();
+			}
+
+			void Expunge (const QByteArray& uid)
+			{
+				Messages_.remove (uid.toUInt ());
+				BumpModSeq ();
+			}
+
+			void Recreate ()
+			{
+				++State_.UIDValidity_;
+			}
+
+			QHash<QByteArray, bool> FetchFlags () const
+			{
+				QHash<QByteArray, bool> result;
+				for (auto i = Messages_.begin (); i != Messages_.end (); ++i)
+					result [QByteArray::number (i.key ())] = i.value ();
+				return result;
+			}
+		private:
+			void BumpModSeq ()
+			{
+				if (State_.HighestModSeq_)
+					++State_.HighestModSeq_;
+			}
+		};
+	}
+
+	void IncrementalSyncTest::firstSyncIsFull ()
+	{
+		FakeMailbox box;
+		box.Append ();
+
+		QCOMPARE (ChooseSyncMode ({}, box.GetState (), box.GetCount (), 0), SyncMode::Full);
+	}
+
+	void IncrementalSyncTest::uidValidityChangeIsFull ()
+	{
+		FakeMailbox box;
+		box.Append ();
+		const auto stored = box.GetState ();
+
+		box.Recreate ();
+
+		QCOMPARE (ChooseSyncMode (stored, box.GetState (), box.GetCount (), 1), SyncMode::Full);
+	}
+
+	void IncrementalSyncTest::noCondstoreIsIncremental ()
+	{
+		FakeMailbox box { false };
+		box.Append ();
+		const auto stored = box.GetState ();
+
+		QCOMPARE (ChooseSyncMode (stored, box.GetState (), box.GetCount (), 1), SyncMode::Incremental);
+	}
+
+	void IncrementalSyncTest::unchangedIsUpToDate ()
+	{
+		FakeMailbox box;
+		box.Append ();
+		box.Append ();
+		const auto stored = box.GetState ();
+
+		QCOMPARE (ChooseSyncMode (stored, box.GetState (), box.GetCount (), 2), SyncMode::UpToDate);
+	}
+
+	void IncrementalSyncTest::countMismatchIsIncremental ()
+	{
+		FakeMailbox box;
+		box.Append ();
+		box.Append ();
+		const auto stored = box.GetState ();
+
+		QCOMPARE (ChooseSyncMode (stored, box.GetState (), box.GetCount (), 1), SyncMode::Incremental);
+	}
+
+	void IncrementalSyncTest::planNewMessages ()
+	{
+		FakeMailbox box;
+		box.Append ();
+		const auto& local = box.FetchFlags ();
+
+		for (int i = 0; i < 10; ++i)
+			box.Append ();
+		const auto& plan = PlanIncrementalSync (local, box.FetchFlags ());
+
+		QCOMPARE (plan.New_.size (), 10);
+		QCOMPARE (plan.New_.first (), QByteArray { "2" });
+		QCOMPARE (plan.New_.last (), QByteArray { "11" });
+		QVERIFY (plan.Vanished_.isEmpty ());
+		QVERIFY (plan.ReadChanged_.isEmpty ());
+	}
+
+	void IncrementalSyncTest::planExpunged ()
+	{
+		FakeMailbox box;
+		const auto& first = box.Append ();
+		box.Append ();
+		const auto& third = box.Append ();
+		const auto& local = box.FetchFlags ();
+
+		box.Expunge (first);
+		box.Expunge (third);
+		auto plan = PlanIncrementalSync (local, box.FetchFlags ());
+		std::sort (plan.Vanished_.begin (), plan.Vanished_.end ());
+
+		QCOMPARE (plan.Vanished_, (QList<QByteArray> { first, third }));
+		QVERIFY (plan.New_.isEmpty ());
+		QVERIFY (plan.ReadChanged_.isEmpty ());
+	}
+
+	void IncrementalSyncTest::planFlagChanges ()
+	{
+		FakeMailbox box;
+		const auto& first = box.Append ();
+		const auto& second = box.Append (true);
+		const auto& local = box.FetchFlags ();
+
+		box.SetRead (first, true);
+		box.SetRead (second, false);
+		const auto& plan = PlanIncrementalSync (local, box.FetchFlags ());
+
+		QCOMPARE (plan.ReadChanged_.size (), 2);
+		QCOMPARE (plan.ReadChanged_.value (first), true);
+		QCOMPARE (plan.ReadChanged_.value (second), false);
+		QVERIFY (plan.New_.isEmpty ());
+		QVERIFY (plan.Vanished_.isEmpty ());
+	}
+
+	void IncrementalSyncTest::planUpToDate ()
+	{
+		FakeMailbox box;
+		box.Append ();
+		box.Append (true);
+
+		QVERIFY (PlanIncrementalSync (box.FetchFlags (), box.FetchFlags ()).IsEmpty ());
+	}
+}
+}
@@ -0,0 +1,106 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "messagethreadertest.h"
+#include <QtTest>
+#include "messagethreader.h"
+
+QTEST_MAIN (LeechCraft::Snails::MessageThreaderTest)
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		using Links_t = QHash<QByteArray, QByteArray>;
+
+		/* Message IDs are the folder IDs prefixed with "msg".
+		 */
+		Links_t MakeIdsMap (const QList<QByteArray>& folderIds)
+		{
+			Links_t result;
+			for (const auto& id : folderIds)
+				result ["msg" + id] = id;
+			return result;
+		}
+	}
+
+	void MessageThreaderTest::noReferences ()
+	{
+		const auto& result = ResolveThreadParents ({ { "1", {} } }, MakeIdsMap ({ "1", "2" }));
+		QCOMPARE (result, Links_t {});
+	}
+
+	void MessageThreaderTest::unknownReferences ()
+	{
+		const auto& result = ResolveThreadParents ({ { "1", { "msg3", "msg4" } } }, MakeIdsMap ({ "1", "2" }));
+		QCOMPARE (result, Links_t {});
+	}
+
+	void MessageThreaderTest::closestAncestorWins ()
+	{
+		const auto& result = ResolveThreadParents ({ { "3", { "msg1", "msg2" } } }, MakeIdsMap ({ "1", "2", "3" }));
+		QCOMPARE (result, (Links_t { { "3", "2" } }));
+	}
+
+	void MessageThreaderTest::fallbackToFartherAncestor ()
+	{
+		const auto& result = ResolveThreadParents ({ { "3", { "msg1", "msg2" } } }, MakeIdsMap ({ "1", "3" }));
+		QCOMPARE (result, (Links_t { { "3", "1" } }));
+	}
+
+	void MessageThreaderTest::selfReference ()
+	{
+		const auto& result = ResolveThreadParents ({ { "1", { "msg1" } } }, MakeIdsMap ({ "1" }));
+		QCOMPARE (result, Links_t {});
+	}
+
+	void MessageThreaderTest::cyclesBroken ()
+	{
+		const auto& result = ResolveThreadParents ({
+					{ "1", { "msg2" } },
+					{ "2", { "msg1" } }
+				},
+				MakeIdsMap ({ "1", "2" }));
+		QCOMPARE (result, (Links_t { { "1", "2" } }));
+	}
+
+	void MessageThreaderTest::chainsResolved ()
+	{
+		const auto& result = ResolveThreadParents ({
+					{ "3", { "msg1", "msg2" } },
+					{ "2", { "msg1" } },
+					{ "4", { "msg1", "msg2", "msg3" } }
+				},
+				MakeIdsMap ({ "1", "2", "3", "4" }));
+		QCOMPARE (result, (Links_t { { "2", "1" }, { "3", "2" }, { "4", "3" } }));
+	}
+}
+}
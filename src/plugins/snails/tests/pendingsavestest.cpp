@@ -0,0 +1,112 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "pendingsavestest.h"
+#include <QtTest>
+#include "message.h"
+#include "pendingsaves.h"
+
+QTEST_MAIN (LeechCraft::Snails::PendingSavesTest)
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		Message_ptr MakeMessage (const QByteArray& id)
+		{
+			const auto& msg = std::make_shared<Message> ();
+			msg->SetFolderID (id);
+			return msg;
+		}
+	}
+
+	void PendingSavesTest::finishSaved ()
+	{
+		const auto& first = MakeMessage ("1");
+		const auto& second = MakeMessage ("2");
+
+		PendingSaves saves;
+		const auto seq = saves.Add ({ first, second, MakeMessage ({}) });
+		QCOMPARE (saves.GetAll ().size (), 2);
+		QVERIFY (saves.Get ("1") == first);
+
+		QVERIFY (saves.Finish (first, seq));
+		QVERIFY (!saves.Get ("1"));
+		QVERIFY (saves.Get ("2") == second);
+
+		QVERIFY (saves.Finish (second, seq));
+		QVERIFY (saves.GetAll ().isEmpty ());
+	}
+
+	void PendingSavesTest::removeDuringSave ()
+	{
+		const auto& msg = MakeMessage ("1");
+
+		PendingSaves saves;
+		const auto seq = saves.Add ({ msg });
+		saves.Remove ("1");
+
+		QVERIFY (!saves.Finish (msg, seq));
+		QVERIFY (!saves.Get ("1"));
+	}
+
+	void PendingSavesTest::newerSaveWins ()
+	{
+		const auto& older = MakeMessage ("1");
+		const auto& newer = MakeMessage ("1");
+
+		PendingSaves saves;
+		const auto olderSeq = saves.Add ({ older });
+		const auto newerSeq = saves.Add ({ newer });
+
+		QVERIFY (!saves.Finish (older, olderSeq));
+		QVERIFY (saves.Get ("1") == newer);
+
+		QVERIFY (saves.Finish (newer, newerSeq));
+		QVERIFY (!saves.Get ("1"));
+	}
+
+	void PendingSavesTest::sameMessageSavedTwice ()
+	{
+		const auto& msg = MakeMessage ("1");
+
+		PendingSaves saves;
+		const auto firstSeq = saves.Add ({ msg });
+		const auto secondSeq = saves.Add ({ msg });
+
+		QVERIFY (!saves.Finish (msg, firstSeq));
+		QVERIFY (saves.Get ("1") == msg);
+
+		QVERIFY (saves.Finish (msg, secondSeq));
+		QVERIFY (!saves.Get ("1"));
+	}
+}
+}
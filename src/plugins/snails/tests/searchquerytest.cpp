@@ -0,0 +1,95 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "searchquerytest.h"
+#include <QtTest>
+#include "searchquery.h"
+
+QTEST_MAIN (LeechCraft::Snails::SearchQueryTest)
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	void SearchQueryTest::emptyQuery ()
+	{
+		QCOMPARE (BuildFTSQuery ({}), QString {});
+		QCOMPARE (BuildFTSQuery ("   "), QString {});
+		QCOMPARE (BuildFTSQuery ("\"\" from:"), QString {});
+	}
+
+	void SearchQueryTest::plainTerms ()
+	{
+		QCOMPARE (BuildFTSQuery ("hello  world"), QString { "\"hello\" \"world\"" });
+	}
+
+	void SearchQueryTest::fieldTerms ()
+	{
+		QCOMPARE (BuildFTSQuery ("from:alice@example.com subject:report"),
+				QString { "Sender:alice@example.com Subject:report" });
+		QCOMPARE (BuildFTSQuery ("To:bob cc:carol body:invoice"),
+				QString { "Recipients:bob Recipients:carol Body:invoice" });
+	}
+
+	void SearchQueryTest::quotedPhrases ()
+	{
+		QCOMPARE (BuildFTSQuery ("\"quarterly report\""), QString { "\"quarterly report\"" });
+		QCOMPARE (BuildFTSQuery ("subject:\"quarterly  report\" draft"),
+				QString { "Subject:quarterly Subject:report \"draft\"" });
+	}
+
+	void SearchQueryTest::prefixTerms ()
+	{
+		QCOMPARE (BuildFTSQuery ("repo*"), QString { "\"repo*\"" });
+		QCOMPARE (BuildFTSQuery ("from:ali*"), QString { "Sender:ali*" });
+	}
+
+	void SearchQueryTest::hasAttachment ()
+	{
+		QCOMPARE (BuildFTSQuery ("has:attachment"), "Attachments:" + AttachmentMarker);
+		QCOMPARE (BuildFTSQuery ("has:attachments from:bob"),
+				"Attachments:" + AttachmentMarker + " Sender:bob");
+	}
+
+	void SearchQueryTest::unknownField ()
+	{
+		QCOMPARE (BuildFTSQuery ("foo:bar"), QString { "\"foo bar\"" });
+		QCOMPARE (BuildFTSQuery ("has:cats"), QString { "\"has cats\"" });
+	}
+
+	void SearchQueryTest::operatorsEscaped ()
+	{
+		QCOMPARE (BuildFTSQuery ("cats OR dogs"), QString { "\"cats\" \"OR\" \"dogs\"" });
+		QCOMPARE (BuildFTSQuery ("(foo) NEAR/3"), QString { "\"foo\" \"NEAR 3\"" });
+		QCOMPARE (BuildFTSQuery ("subject:\"cats OR dogs\""),
+				QString { "Subject:cats Subject:OR Subject:dogs" });
+		QCOMPARE (BuildFTSQuery ("subject:\"- cats\" body:@"), QString { "Subject:cats" });
+	}
+}
+}
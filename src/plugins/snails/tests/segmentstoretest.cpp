@@ -0,0 +1,300 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "segmentstoretest.h"
+#include <stdexcept>
+#include <QtTest>
+#include <QTemporaryDir>
+#include "segmentstore.h"
+
+QTEST_MAIN (LeechCraft::Snails::SegmentStoreTest)
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		QByteArray MakeRecord (int num)
+		{
+			return "record #" + QByteArray::number (num) + QByteArray (num % 7, 'x');
+		}
+
+		QString SegmentPath (const QTemporaryDir& dir, int segment)
+		{
+			return QDir { dir.path () }.filePath (QString ("%1.seg").arg (segment, 6, 10, QChar ('0')));
+		}
+
+		void AppendRaw (const QString& path, const QByteArray& data)
+		{
+			QFile file { path };
+			QVERIFY (file.open (QIODevice::WriteOnly | QIODevice::Append));
+			QCOMPARE (file.write (data), static_cast<qint64> (data.size ()));
+		}
+	}
+
+	void SegmentStoreTest::appendAndRead ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (dir.isValid ());
+
+		SegmentStore store { QDir { dir.path () } };
+
+		QList<SegmentLocation> locs;
+		for (int i = 0; i < 10; ++i)
+			locs << store.Append (MakeRecord (i));
+		store.Flush ();
+
+		for (int i = 0; i < locs.size (); ++i)
+		{
+			QCOMPARE (locs.at (i).Segment_, 0);
+			QCOMPARE (store.Read (locs.at (i)), MakeRecord (i));
+		}
+
+		QCOMPARE (store.GetSegments (), QList<int> { 0 });
+	}
+
+	void SegmentStoreTest::segmentRollover ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (dir.isValid ());
+
+		SegmentStore store { QDir { dir.path () }, 64 };
+
+		QList<SegmentLocation> locs;
+		for (int i = 0; i < 20; ++i)
+			locs << store.Append (MakeRecord (i));
+
+		QVERIFY (store.GetSegments ().size () > 1);
+		QCOMPARE (store.GetCurrentSegment (), store.GetSegments ().last ());
+
+		for (int i = 0; i < locs.size (); ++i)
+		{
+			QVERIFY (store.GetSegmentSize (locs.at (i).Segment_) <= 64 ||
+					locs.at (i).Offset_ == 0);
+			QCOMPARE (store.Read (locs.at (i)), MakeRecord (i));
+		}
+	}
+
+	void SegmentStoreTest::reopenContinuesSegment ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (dir.isValid ());
+
+		SegmentLocation first;
+		{
+			SegmentStore store { QDir { dir.path () } };
+			first = store.Append (MakeRecord (1));
+		}
+
+		SegmentStore store { QDir { dir.path () } };
+		const auto& second = store.Append (MakeRecord (2));
+
+		QCOMPARE (second.Segment_, first.Segment_);
+		QCOMPARE (second.Offset_, first.Offset_ + 8 + first.Size_);
+		QCOMPARE (store.Read (first), MakeRecord (1));
+		QCOMPARE (store.Read (second), MakeRecord (2));
+	}
+
+	void SegmentStoreTest::readPreservesOrder ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (dir.isValid ());
+
+		SegmentStore store { QDir { dir.path () }, 64 };
+
+		QList<SegmentLocation> locs;
+		for (int i = 0; i < 10; ++i)
+			locs.prepend (store.Append (MakeRecord (i)));
+
+		for (int i = 0; i < locs.size (); ++i)
+			QCOMPARE (store.Read (locs.at (i)), MakeRecord (locs.size () - i - 1));
+	}
+
+	void SegmentStoreTest::compaction ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (dir.isValid ());
+
+		SegmentStore store { QDir { dir.path () }, 256 };
+
+		QList<QPair<int, SegmentLocation>> live;
+		for (int i = 0; store.GetCurrentSegment () == 0; ++i)
+		{
+			const auto& loc = store.Append (MakeRecord (i));
+			if (loc.Segment_ != 0)
+				break;
+
+			if (i % 2)
+				live.append ({ i, loc });
+		}
+		QVERIFY (live.size () >= 3);
+
+		QList<SegmentRelocation> relocations;
+		int batches = 0;
+		store.Compact (0, live,
+				[&] (const QList<SegmentRelocation>& batch)
+				{
+					QVERIFY (batch.size () <= 2);
+					relocations += batch;
+					++batches;
+				},
+				2);
+
+		QCOMPARE (relocations.size (), live.size ());
+		QCOMPARE (batches, (live.size () + 1) / 2);
+		QVERIFY (!store.GetSegments ().contains (0));
+		QVERIFY (!QFile::exists (SegmentPath (dir, 0)));
+
+		for (int i = 0; i < relocations.size (); ++i)
+		{
+			const auto& reloc = relocations.at (i);
+			QCOMPARE (reloc.Key_, live.at (i).first);
+			QCOMPARE (reloc.Old_.Offset_, live.at (i).second.Offset_);
+			QVERIFY (reloc.New_.Segment_ != 0);
+			QCOMPARE (store.Read (reloc.New_), MakeRecord (reloc.Key_));
+		}
+	}
+
+	void SegmentStoreTest::compactionOfCurrentSegment ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (dir.isValid ());
+
+		SegmentStore store { QDir { dir.path () } };
+		const auto& loc = store.Append (MakeRecord (1));
+		store.Append (MakeRecord (2));
+
+		QList<SegmentRelocation> relocations;
+		store.Compact (0, { { 1, loc } },
+				[&] (const QList<SegmentRelocation>& batch) { relocations += batch; });
+
+		QCOMPARE (relocations.size (), 1);
+		QCOMPARE (relocations.at (0).New_.Segment_, 1);
+		QCOMPARE (store.GetCurrentSegment (), 1);
+		QCOMPARE (store.GetSegments (), QList<int> { 1 });
+		QCOMPARE (store.Read (relocations.at (0).New_), MakeRecord (1));
+	}
+
+	void SegmentStoreTest::compactionKeepsSegmentOnFailure ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (dir.isValid ());
+
+		SegmentStore store { QDir { dir.path () } };
+		auto loc = store.Append (MakeRecord (1));
+		store.Append (MakeRecord (2));
+		store.Flush ();
+
+		auto broken = loc;
+		++broken.Size_;
+
+		bool handlerCalled = false;
+		QVERIFY_EXCEPTION_THROWN (store.Compact (0, { { 1, loc }, { 2, broken } },
+					[&] (const QList<SegmentRelocation>&) { handlerCalled = true; }),
+				std::runtime_error);
+
+		QVERIFY (!handlerCalled);
+		QVERIFY (store.GetSegments ().contains (0));
+		QCOMPARE (store.Read (loc), MakeRecord (1));
+	}
+
+	void SegmentStoreTest::truncatedTailRecovered ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (dir.isValid ());
+
+		SegmentLocation loc;
+		qint64 goodSize = 0;
+		{
+			SegmentStore store { QDir { dir.path () } };
+			loc = store.Append (MakeRecord (1));
+			store.Flush ();
+			goodSize = store.GetSegmentSize (0);
+		}
+
+		// A header promising more data than there is, as if the
+		// process died in the middle of Append().
+		AppendRaw (SegmentPath (dir, 0), QByteArray::fromHex ("534e5331000000ff") + "partial");
+
+		SegmentStore store { QDir { dir.path () } };
+		QCOMPARE (store.GetCurrentSegment (), 0);
+		QCOMPARE (store.GetSegmentSize (0), goodSize);
+
+		const auto& next = store.Append (MakeRecord (2));
+		QCOMPARE (next.Offset_, goodSize);
+		QCOMPARE (store.Read (loc), MakeRecord (1));
+		QCOMPARE (store.Read (next), MakeRecord (2));
+	}
+
+	void SegmentStoreTest::garbageTailSkipped ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (dir.isValid ());
+
+		SegmentLocation loc;
+		{
+			SegmentStore store { QDir { dir.path () } };
+			loc = store.Append (MakeRecord (1));
+		}
+
+		const QByteArray garbage { "definitely not a segment record" };
+		AppendRaw (SegmentPath (dir, 0), garbage);
+		const auto corruptSize = QFileInfo { SegmentPath (dir, 0) }.size ();
+
+		SegmentStore store { QDir { dir.path () } };
+		QCOMPARE (store.GetCurrentSegment (), 1);
+		QCOMPARE (store.GetSegmentSize (0), corruptSize);
+
+		const auto& next = store.Append (MakeRecord (2));
+		QCOMPARE (next.Segment_, 1);
+		QCOMPARE (next.Offset_, 0ll);
+		QCOMPARE (store.Read (loc), MakeRecord (1));
+		QCOMPARE (store.Read (next), MakeRecord (2));
+	}
+
+	void SegmentStoreTest::headerMismatchThrows ()
+	{
+		QTemporaryDir dir;
+		QVERIFY (dir.isValid ());
+
+		SegmentStore store { QDir { dir.path () } };
+		store.Append (MakeRecord (1));
+		const auto& loc = store.Append (MakeRecord (2));
+
+		auto shifted = loc;
+		shifted.Offset_ += 1;
+		QVERIFY_EXCEPTION_THROWN (store.Read (shifted), std::runtime_error);
+
+		auto outOfRange = loc;
+		outOfRange.Offset_ += 1024;
+		QVERIFY_EXCEPTION_THROWN (store.Read (outOfRange), std::runtime_error);
+	}
+}
+}
@@ -0,0 +1,301 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "storagemaintenancetest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "accountdatabase.h"
+#include "message.h"
+#include "segmentstore.h"
+#include "storagemaintenance.h"
+
+QTEST_MAIN (LeechCraft::Snails::StorageMaintenanceTest)
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		const QStringList Folder { "INBOX" };
+
+		Message_ptr MakeMessage (int num)
+		{
+			const auto& msg = std::make_shared<Message> ();
+			msg->SetFolderID (QByteArray::number (num));
+			msg->SetMessageID ("<" + QByteArray::number (num) + "@example.com>");
+			msg->AddFolder (Folder);
+			msg->SetSubject (QString { "Quarterly report #%1" }.arg (num));
+			msg->SetBody ("Numbers are fine.");
+			msg->SetDate (QDateTime { QDate { 2026, 1, 1 } }.addSecs (num * 60));
+			msg->SetAddress (Message::Address::From, { "Alice", "alice@example.com" });
+			return msg;
+		}
+
+		SegmentLocation StoreMessage (AccountDatabase& base, SegmentStore& store, const Message_ptr& msg)
+		{
+			base.AddMessage (msg);
+
+			const auto& loc = store.Append (qCompress (msg->Serialize (), MessageCompressionLevel));
+			base.SetMessageLocation (msg->GetFolderID (), Folder, loc);
+			return loc;
+		}
+
+		void DropSearchIndex (AccountDatabase& base)
+		{
+			QSqlQuery query { base.GetDB () };
+			QVERIFY (query.exec ("DROP TABLE msgsearch"));
+		}
+
+		const QString Match { "Subject:quarterly" };
+
+		QStringList GetSubjects (const QList<MessageInfo>& infos)
+		{
+			QStringList result;
+			for (const auto& info : infos)
+				result << info.Subject_;
+			return result;
+		}
+	}
+
+	void StorageMaintenanceTest::init ()
+	{
+		Dir_ = std::make_shared<QTemporaryDir> ();
+		QVERIFY (Dir_->isValid ());
+		QVERIFY (QDir { Dir_->path () }.mkpath ("segments"));
+	}
+
+	void StorageMaintenanceTest::cleanup ()
+	{
+		for (const auto& name : Connections_)
+			QSqlDatabase::removeDatabase (name);
+		Connections_.clear ();
+
+		Dir_.reset ();
+	}
+
+	QString StorageMaintenanceTest::MakeConnectionName ()
+	{
+		const auto& name = "StorageMaintenanceTest_" + QString::number (Connections_.size ());
+		Connections_ << name;
+		return name;
+	}
+
+	void StorageMaintenanceTest::searchIndexFilledOnUpgrade ()
+	{
+		const QDir dir { Dir_->path () };
+		const auto& store = std::make_shared<SegmentStore> (dir.filePath ("segments"));
+
+		const int count = 25;
+
+		// A database created before the search index has been introduced.
+		{
+			AccountDatabase base { dir, MakeConnectionName () };
+			for (int i = 1; i <= count; ++i)
+				StoreMessage (base, *store, MakeMessage (i));
+			store->Flush ();
+
+			DropSearchIndex (base);
+		}
+
+		const auto& base = std::make_shared<AccountDatabase> (dir, MakeConnectionName ());
+		QVERIFY (base->Search (Folder, Match, 0, 100).isEmpty ());
+		QCOMPARE (base->GetUnindexedMessageLocations (0, 100).size (), count);
+
+		FillSearchIndex (base, store, 10);
+
+		QCOMPARE (base->Search (Folder, Match, 0, 100).size (), count);
+		QCOMPARE (base->Search (Folder, "Subject:7", 0, 100), QList<QByteArray> { "7" });
+		QVERIFY (base->GetUnindexedMessageLocations (0, 100).isEmpty ());
+	}
+
+	void StorageMaintenanceTest::searchIndexFillSkipsBroken ()
+	{
+		const QDir dir { Dir_->path () };
+		const auto& store = std::make_shared<SegmentStore> (dir.filePath ("segments"));
+
+		{
+			AccountDatabase base { dir, MakeConnectionName () };
+			for (int i = 1; i <= 3; ++i)
+				StoreMessage (base, *store, MakeMessage (i));
+
+			// Neither compressed nor a serialized message.
+			const auto& broken = MakeMessage (4);
+			base.AddMessage (broken);
+			base.SetMessageLocation (broken->GetFolderID (), Folder, store->Append ("garbage"));
+
+			for (int i = 5; i <= 7; ++i)
+				StoreMessage (base, *store, MakeMessage (i));
+			store->Flush ();
+
+			DropSearchIndex (base);
+		}
+
+		const auto& base = std::make_shared<AccountDatabase> (dir, MakeConnectionName ());
+
+		// Small batches, so that the broken message ends up in the
+		// middle of the walk rather than in its last batch.
+		FillSearchIndex (base, store, 2);
+
+		auto found = base->Search (Folder, Match, 0, 100);
+		std::sort (found.begin (), found.end ());
+		QCOMPARE (found, (QList<QByteArray> { "1", "2", "3", "5", "6", "7" }));
+
+		const auto& unindexed = base->GetUnindexedMessageLocations (0, 100);
+		QCOMPARE (unindexed.size (), 1);
+	}
+
+	void StorageMaintenanceTest::searchIndexFillKeepsIndexed ()
+	{
+		const QDir dir { Dir_->path () };
+		const auto& store = std::make_shared<SegmentStore> (dir.filePath ("segments"));
+		const auto& base = std::make_shared<AccountDatabase> (dir, MakeConnectionName ());
+
+		for (int i = 1; i <= 4; ++i)
+		{
+			const auto& msg = MakeMessage (i);
+			StoreMessage (*base, *store, msg);
+			if (i % 2)
+				base->IndexMessage (msg);
+		}
+		store->Flush ();
+
+		const auto& unindexed = base->GetUnindexedMessageLocations (0, 100);
+		QCOMPARE (unindexed.size (), 2);
+
+		FillSearchIndex (base, store);
+
+		QVERIFY (base->GetUnindexedMessageLocations (0, 100).isEmpty ());
+		QCOMPARE (base->Search (Folder, Match, 0, 100).size (), 4);
+	}
+
+	void StorageMaintenanceTest::searchOrderedByDate ()
+	{
+		const QDir dir { Dir_->path () };
+		const auto& base = std::make_shared<AccountDatabase> (dir, MakeConnectionName ());
+
+		// Older mail fetched later gets the greater row IDs.
+		for (auto i : { 3, 5, 1, 4, 2 })
+		{
+			const auto& msg = MakeMessage (i);
+			base->AddMessage (msg);
+			base->IndexMessage (MakeSearchIndexEntry (msg));
+		}
+
+		QCOMPARE (base->Search (Folder, Match, 0, 100),
+				(QList<QByteArray> { "5", "4", "3", "2", "1" }));
+		QCOMPARE (base->Search (Folder, Match, 1, 2),
+				(QList<QByteArray> { "4", "3" }));
+	}
+
+	void StorageMaintenanceTest::messageInfosFilledOnUpgrade ()
+	{
+		const QDir dir { Dir_->path () };
+		const auto& store = std::make_shared<SegmentStore> (dir.filePath ("segments"));
+
+		const int count = 7;
+
+		// A database created before the message list entries have been
+		// introduced, with one message missing from the store.
+		{
+			AccountDatabase base { dir, MakeConnectionName () };
+			for (int i = 1; i <= count; ++i)
+				StoreMessage (base, *store, MakeMessage (i));
+
+			const auto& broken = MakeMessage (count + 1);
+			base.AddMessage (broken);
+			base.SetMessageLocation (broken->GetFolderID (), Folder, store->Append ("garbage"));
+			store->Flush ();
+
+			QSqlQuery query { base.GetDB () };
+			QVERIFY (query.exec ("DELETE FROM msgheaders"));
+		}
+
+		const auto& base = std::make_shared<AccountDatabase> (dir, MakeConnectionName ());
+		QVERIFY (base->HasMissingMessageInfos ());
+		QCOMPARE (base->GetMissingInfoMessageLocations (0, 100).size (), count + 1);
+
+		FillMessageInfos (base, store, 3);
+
+		QVERIFY (!base->HasMissingMessageInfos ());
+
+		MessageListCursor cursor;
+		const auto& infos = base->GetMessageInfos (Folder, cursor, 100);
+		QCOMPARE (infos.size (), count + 1);
+
+		QStringList expected;
+		for (int i = count; i >= 1; --i)
+			expected << QString { "Quarterly report #%1" }.arg (i);
+		// The placeholder has no date, so it comes last.
+		expected << QString {};
+		QCOMPARE (GetSubjects (infos), expected);
+	}
+
+	void StorageMaintenanceTest::messageInfosPagedByKey ()
+	{
+		const QDir dir { Dir_->path () };
+		const auto& store = std::make_shared<SegmentStore> (dir.filePath ("segments"));
+		const auto& base = std::make_shared<AccountDatabase> (dir, MakeConnectionName ());
+
+		// Pairs of messages sharing the date, so that pages end in the
+		// middle of a date.
+		QStringList expected;
+		for (int i = 1; i <= 10; ++i)
+		{
+			const auto& msg = MakeMessage (i);
+			msg->SetDate (QDateTime { QDate { 2026, 1, 1 } }.addSecs ((i + 1) / 2 * 60));
+			base->AddMessage (msg);
+		}
+		for (auto i : { 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 })
+			expected << QString { "Quarterly report #%1" }.arg (i);
+
+		MessageListCursor cursor;
+		auto infos = base->GetMessageInfos (Folder, cursor, 3);
+		QCOMPARE (infos.size (), 3);
+
+		// New mail arriving and the already fetched mail being removed
+		// while the list is paged in must not shift the next pages.
+		base->AddMessage (MakeMessage (11));
+		base->RemoveMessage ("10", Folder);
+		base->RemoveMessage ("9", Folder);
+
+		while (true)
+		{
+			const auto& page = base->GetMessageInfos (Folder, cursor, 3);
+			infos += page;
+			if (page.size () < 3)
+				break;
+		}
+
+		QCOMPARE (GetSubjects (infos), expected);
+	}
+}
+}
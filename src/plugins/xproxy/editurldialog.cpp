@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "editurldialog.h"
+#include <QRegExp>
 #include "structures.h"
 
 namespace LeechCraft
@@ -44,10 +45,7 @@ namespace XProxy
 	{
 		auto rxPat = Ui_.TargetHost_->text ();
 		if (!rxPat.contains ("*") && !rxPat.contains ("^") && !rxPat.contains ("$"))
-		{
-			rxPat.prepend (".*");
-			rxPat.append (".*");
-		}
+			rxPat = ".*" + QRegExp::escape (rxPat) + ".*";
 
 		const Util::RegExp rx { rxPat, Qt::CaseInsensitive };
 		return
@@ -0,0 +1,227 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "hostsindex.h"
+
+namespace LeechCraft
+{
+namespace XProxy
+{
+	namespace
+	{
+		bool IsHostChar (QChar ch)
+		{
+			const auto c = ch.unicode ();
+			return (c >= 'a' && c <= 'z') ||
+					(c >= 'A' && c <= 'Z') ||
+					(c >= '0' && c <= '9') ||
+					c == '-' ||
+					c == '_';
+		}
+
+		bool ParseLiteral (const QString& pattern, QString& literal)
+		{
+			literal.clear ();
+			literal.reserve (pattern.size ());
+
+			for (int i = 0; i < pattern.size (); ++i)
+			{
+				auto ch = pattern.at (i);
+				if (ch == '\\')
+				{
+					if (++i == pattern.size ())
+						return false;
+
+					ch = pattern.at (i);
+					if (ch != '.' && ch != '-')
+						return false;
+				}
+				else if (!IsHostChar (ch))
+					return false;
+
+				literal += ch.toLower ();
+			}
+
+			return !literal.isEmpty ();
+		}
+	}
+
+	HostsIndex::Kind HostsIndex::Classify (const Util::RegExp& host, QString *literalPtr)
+	{
+		if (host.GetCaseSensitivity () != Qt::CaseInsensitive)
+			return Kind::Residual;
+
+		auto pattern = host.GetPattern ();
+
+		// Depending on the backend, Util::RegExp either searches the
+		// pattern or matches the whole string against it, so only the
+		// patterns anchored on both sides behave the same in both cases.
+		const bool startAnchor = pattern.startsWith ('^');
+		if (startAnchor)
+			pattern.remove (0, 1);
+
+		enum class Prefix
+		{
+			None,
+			Any,
+			Subdomain
+		} prefix = Prefix::None;
+
+		const QString subdomainPrefix { "(.*\\.)?" };
+		if (pattern.startsWith (subdomainPrefix))
+		{
+			prefix = Prefix::Subdomain;
+			pattern.remove (0, subdomainPrefix.size ());
+		}
+		else if (pattern.startsWith (".*"))
+		{
+			prefix = Prefix::Any;
+			pattern.remove (0, 2);
+		}
+
+		const bool endAnchor = pattern.endsWith ('$') && !pattern.endsWith ("\\$");
+		if (endAnchor)
+			pattern.chop (1);
+
+		const bool anySuffix = pattern.endsWith (".*") && !pattern.endsWith ("\\.*");
+		if (anySuffix)
+			pattern.chop (2);
+
+		const bool startFixed = startAnchor || prefix == Prefix::Any;
+		const bool endFixed = endAnchor || anySuffix;
+		if (!startFixed || !endFixed)
+			return Kind::Residual;
+
+		QString literal;
+		if (!ParseLiteral (pattern, literal))
+			return Kind::Residual;
+
+		if (literalPtr)
+			*literalPtr = literal;
+
+		switch (prefix)
+		{
+		case Prefix::None:
+			return anySuffix ? Kind::Residual : Kind::Exact;
+		case Prefix::Any:
+			return anySuffix ? Kind::Substring : Kind::Suffix;
+		case Prefix::Subdomain:
+			return anySuffix ? Kind::Residual : Kind::Subdomain;
+		}
+
+		return Kind::Residual;
+	}
+
+	void HostsIndex::Add (const Util::RegExp& host, int id)
+	{
+		if (host.GetPattern ().isEmpty ())
+			return;
+
+		QString literal;
+		switch (Classify (host, &literal))
+		{
+		case Kind::Exact:
+			Exact_ [literal] << id;
+			break;
+		case Kind::Suffix:
+			AddSuffix (literal, id);
+			break;
+		case Kind::Subdomain:
+			Exact_ [literal] << id;
+			AddSuffix ('.' + literal, id);
+			break;
+		case Kind::Substring:
+			Substrings_.append ({ literal, id });
+			break;
+		case Kind::Residual:
+			Residual_.append ({ host, id });
+			break;
+		}
+	}
+
+	void HostsIndex::Clear ()
+	{
+		Exact_.clear ();
+		SuffixTrie_.assign (1, {});
+		Substrings_.clear ();
+		Residual_.clear ();
+	}
+
+	QList<int> HostsIndex::Match (const QString& host) const
+	{
+		const auto& lowered = host.toLower ();
+
+		auto result = Exact_.value (lowered);
+
+		int node = 0;
+		for (int i = lowered.size () - 1; i >= 0; --i)
+		{
+			const auto& children = SuffixTrie_ [node].Children_;
+			const auto pos = children.find (lowered.at (i));
+			if (pos == children.end ())
+				break;
+
+			node = *pos;
+			result += SuffixTrie_ [node].Ids_;
+		}
+
+		for (const auto& pair : Substrings_)
+			if (lowered.contains (pair.first))
+				result << pair.second;
+
+		for (const auto& pair : Residual_)
+			if (pair.first.Matches (host))
+				result << pair.second;
+
+		return result;
+	}
+
+	void HostsIndex::AddSuffix (const QString& suffix, int id)
+	{
+		int node = 0;
+		for (int i = suffix.size () - 1; i >= 0; --i)
+		{
+			const auto ch = suffix.at (i);
+			const auto pos = SuffixTrie_ [node].Children_.find (ch);
+			if (pos != SuffixTrie_ [node].Children_.end ())
+			{
+				node = *pos;
+				continue;
+			}
+
+			SuffixTrie_.emplace_back ();
+			const int child = SuffixTrie_.size () - 1;
+			SuffixTrie_ [node].Children_ [ch] = child;
+			node = child;
+		}
+
+		SuffixTrie_ [node].Ids_ << id;
+	}
+}
+}
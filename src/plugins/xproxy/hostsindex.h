@@ -0,0 +1,90 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <util/sll/regexp.h>
+
+namespace LeechCraft
+{
+namespace XProxy
+{
+	/** Finds which of the host patterns match a given host without
+	 * running each pattern's regexp.
+	 *
+	 * Patterns are analyzed once when added. The ones that boil down to
+	 * a plain host name (like <code>^example\\.com$</code>) go into a
+	 * hash, the ones matching a domain suffix (like
+	 * <code>.*\\.example\\.com$</code> or
+	 * <code>^(.*\\.)?example\\.com$</code>) go into a trie over the
+	 * reversed host, the ones matching a substring (like
+	 * <code>.*example\\.com.*</code>) are checked as plain substrings,
+	 * and the rest is checked via the regexps themselves.
+	 *
+	 * Only case-insensitive patterns with escaped dots are compiled, so
+	 * that the result is always the same as of Util::RegExp::Matches().
+	 */
+	class HostsIndex
+	{
+		QHash<QString, QList<int>> Exact_;
+
+		struct TrieNode
+		{
+			QHash<QChar, int> Children_;
+			QList<int> Ids_;
+		};
+		std::vector<TrieNode> SuffixTrie_ = std::vector<TrieNode> (1);
+
+		QList<QPair<QString, int>> Substrings_;
+		QList<QPair<Util::RegExp, int>> Residual_;
+	public:
+		enum class Kind
+		{
+			Exact,
+			Suffix,
+			Subdomain,
+			Substring,
+			Residual
+		};
+
+		void Add (const Util::RegExp& host, int id);
+		void Clear ();
+
+		QList<int> Match (const QString& host) const;
+
+		static Kind Classify (const Util::RegExp& host, QString *literal = nullptr);
+	private:
+		void AddSuffix (const QString&, int);
+	};
+}
+}
@@ -30,6 +30,7 @@
 #include "proxiesstorage.h"
 #include <QSettings>
 #include <QCoreApplication>
+#include <QVector>
 #include <util/sll/qtutil.h>
 #include <util/sll/prelude.h>
 #include "urllistscript.h"
@@ -42,6 +43,7 @@ namespace XProxy
 	ProxiesStorage::ProxiesStorage (const ScriptsManager *manager, QObject *parent)
 	: QObject { parent }
 	, ScriptsMgr_ { manager }
+	, MatchesCache_ { 1024 }
 	{
 	}
 
@@ -65,29 +67,33 @@ namespace XProxy
 				reqPort = pos->second;
 		}
 
-		QList<Proxy> result;
-		for (const auto& pair : Proxies_)
+		const auto& cacheKey = reqHost + ':' + QString::number (reqPort) + '/' + proto;
+
+		QMutexLocker locker { &IndexLock_ };
+		if (const auto cached = MatchesCache_.object (cacheKey))
+			return *cached;
+
+		QVector<bool> matchedProxies (IndexedProxies_.size ());
+		for (const auto id : HostsIndex_.Match (reqHost))
 		{
-			if (result.contains (pair.first))
+			const auto& pair = IndexedTargets_.at (id);
+			const auto& target = pair.second;
+
+			if (target.Port_ && reqPort > 0 && target.Port_ != reqPort)
 				continue;
 
-			if (std::any_of (pair.second.begin (), pair.second.end (),
-					[&reqHost, reqPort, &proto] (const ReqTarget& target)
-					{
-						if (target.Port_ && reqPort > 0 && target.Port_ != reqPort)
-							return false;
+			if (!target.Protocols_.isEmpty () && !target.Protocols_.contains (proto))
+				continue;
 
-						if (!target.Protocols_.isEmpty () && !target.Protocols_.contains (proto))
-							return false;
+			matchedProxies [pair.first] = true;
+		}
 
-						if (!target.Host_.Matches (reqHost))
-							return false;
+		QList<Proxy> result;
+		for (int i = 0; i < IndexedProxies_.size (); ++i)
+			if (matchedProxies.at (i) && !result.contains (IndexedProxies_.at (i)))
+				result << IndexedProxies_.at (i);
 
-						return true;
-					}))
-				result << pair.first;
-		}
-		for (const auto& pair : Util::Stlize (Scripts_))
+		for (const auto& pair : IndexedScripts_)
 		{
 			if (result.contains (pair.first))
 				continue;
@@ -97,6 +103,8 @@ namespace XProxy
 						{ return script->Accepts (reqHost, reqPort, proto); }))
 				result << pair.first;
 		}
+
+		MatchesCache_.insert (cacheKey, new QList<Proxy> { result });
 		return result;
 	}
 
@@ -107,6 +115,8 @@ namespace XProxy
 					[this, &proxy] { Proxies_.append ({ proxy, {} }); },
 					[] (auto) {}
 				});
+
+		Reindex ();
 	}
 
 	void ProxiesStorage::UpdateProxy (const Proxy& oldProxy, const Proxy& newProxy)
@@ -128,12 +138,16 @@ namespace XProxy
 
 		const auto& oldScripts = Scripts_.take (oldProxy);
 		Scripts_ [newProxy] += oldScripts;
+
+		Reindex ();
 	}
 
 	void ProxiesStorage::RemoveProxy (const Proxy& proxy)
 	{
 		EraseFromProxiesList (proxy);
 		Scripts_.remove (proxy);
+
+		Reindex ();
 	}
 
 	QList<ReqTarget> ProxiesStorage::GetTargets (const Proxy& proxy) const
@@ -152,6 +166,8 @@ namespace XProxy
 					[this, &proxy, &targets] { Proxies_.append ({ proxy, targets }); },
 					[&proxy, &targets] (auto it) { it->second = targets; }
 				});
+
+		Reindex ();
 	}
 
 	QList<UrlListScript*> ProxiesStorage::GetScripts (const Proxy& proxy) const
@@ -164,12 +180,16 @@ namespace XProxy
 		Scripts_ [proxy] = lists;
 		for (const auto script : lists)
 			script->SetEnabled (true);
+
+		Reindex ();
 	}
 
 	void ProxiesStorage::Swap (int row1, int row2)
 	{
 		using std::swap;
 		swap (Proxies_ [row1], Proxies_ [row2]);
+
+		Reindex ();
 	}
 
 	void ProxiesStorage::LoadSettings ()
@@ -199,6 +219,8 @@ namespace XProxy
 						<< entry.first;
 
 		settings.endGroup ();
+
+		Reindex ();
 	}
 
 	void ProxiesStorage::SaveSettings () const
@@ -221,6 +243,41 @@ namespace XProxy
 		settings.endGroup ();
 	}
 
+	void ProxiesStorage::Reindex ()
+	{
+		QMutexLocker locker { &IndexLock_ };
+
+		HostsIndex_.Clear ();
+		IndexedProxies_.clear ();
+		IndexedTargets_.clear ();
+		for (const auto& pair : Proxies_)
+		{
+			const int row = IndexedProxies_.size ();
+			IndexedProxies_ << pair.first;
+
+			for (const auto& target : pair.second)
+			{
+				HostsIndex_.Add (target.Host_, IndexedTargets_.size ());
+				IndexedTargets_.append ({ row, target });
+			}
+		}
+
+		IndexedScripts_.clear ();
+		for (const auto& pair : Util::Stlize (Scripts_))
+		{
+			IndexedScripts_.append ({ pair.first, pair.second });
+
+			for (const auto script : pair.second)
+				connect (script,
+						SIGNAL (urlsChanged ()),
+						this,
+						SLOT (handleScriptUrlsChanged ()),
+						Qt::UniqueConnection);
+		}
+
+		MatchesCache_.clear ();
+	}
+
 	void ProxiesStorage::EraseFromProxiesList (const Proxy& proxy)
 	{
 		DoOnProxiesList (proxy,
@@ -259,5 +316,11 @@ namespace XProxy
 	{
 		return DoOnProxiesListImpl<R> (Proxies_, proxy, cont);
 	}
+
+	void ProxiesStorage::handleScriptUrlsChanged ()
+	{
+		QMutexLocker locker { &IndexLock_ };
+		MatchesCache_.clear ();
+	}
 }
 }
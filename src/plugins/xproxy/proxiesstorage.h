@@ -31,8 +31,11 @@
 
 #include <QObject>
 #include <QMap>
+#include <QCache>
+#include <QMutex>
 #include <util/sll/eithercont.h>
 #include "structures.h"
+#include "hostsindex.h"
 
 namespace LeechCraft
 {
@@ -43,10 +46,22 @@ namespace XProxy
 
 	class ProxiesStorage : public QObject
 	{
+		Q_OBJECT
+
 		const ScriptsManager * const ScriptsMgr_;
 
 		QList<QPair<Proxy, QList<ReqTarget>>> Proxies_;
 		QMap<Proxy, QList<UrlListScript*>> Scripts_;
+
+		// FindMatching() is called by Qt for each new connection from
+		// whatever thread it's made in, so it only uses the snapshot
+		// below, guarded by the mutex.
+		mutable QMutex IndexLock_;
+		HostsIndex HostsIndex_;
+		QList<Proxy> IndexedProxies_;
+		QList<QPair<int, ReqTarget>> IndexedTargets_;
+		QList<QPair<Proxy, QList<UrlListScript*>>> IndexedScripts_;
+		mutable QCache<QString, QList<Proxy>> MatchesCache_;
 	public:
 		ProxiesStorage (const ScriptsManager*, QObject* = nullptr);
 
@@ -70,6 +85,8 @@ namespace XProxy
 		void LoadSettings ();
 		void SaveSettings () const;
 	private:
+		void Reindex ();
+
 		void EraseFromProxiesList (const Proxy&);
 
 		template<typename R = void>
@@ -79,6 +96,8 @@ namespace XProxy
 		template<typename R = void>
 		R DoOnProxiesList (const Proxy&,
 				const Util::EitherCont<R (), R (decltype (Proxies_.constBegin ()))>&) const;
+	private slots:
+		void handleScriptUrlsChanged ();
 	};
 }
 }
@@ -0,0 +1,217 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "hostsindextest.h"
+#include <algorithm>
+#include <QtTest>
+#include "../hostsindex.h"
+
+QTEST_MAIN (LeechCraft::XProxy::HostsIndexTest)
+
+Q_DECLARE_METATYPE (LeechCraft::XProxy::HostsIndex::Kind)
+
+namespace LeechCraft
+{
+namespace XProxy
+{
+	namespace
+	{
+		const int BenchSitesCount = 2000;
+
+		Util::RegExp Rx (const QString& pattern)
+		{
+			return { pattern, Qt::CaseInsensitive };
+		}
+
+		QList<Util::RegExp> MakeBenchPatterns ()
+		{
+			QList<Util::RegExp> result;
+			for (int i = 0; i < BenchSitesCount; ++i)
+				switch (i % 4)
+				{
+				case 0:
+					result << Rx (QString { "^site%1\\.example\\.com$" }.arg (i));
+					break;
+				case 1:
+					result << Rx (QString { ".*\\.site%1\\.example\\.org$" }.arg (i));
+					break;
+				case 2:
+					result << Rx (QString { "^(.*\\.)?site%1\\.example\\.net$" }.arg (i));
+					break;
+				case 3:
+					result << Rx (QString { ".*site%1\\.example\\.info.*" }.arg (i));
+					break;
+				}
+			return result;
+		}
+
+		QStringList MakeBenchHosts ()
+		{
+			QStringList result;
+			for (int i = 0; i < BenchSitesCount; i += 7)
+				result << QString { "site%1.example.com" }.arg (i)
+						<< QString { "cdn.site%1.example.org" }.arg (i)
+						<< QString { "site%1.example.net" }.arg (i)
+						<< QString { "unrelated%1.example.com" }.arg (i);
+			return result;
+		}
+	}
+
+	void HostsIndexTest::classify_data ()
+	{
+		QTest::addColumn<QString> ("pattern");
+		QTest::addColumn<HostsIndex::Kind> ("kind");
+		QTest::addColumn<QString> ("literal");
+
+		QTest::newRow ("exact") << "^example\\.com$" << HostsIndex::Kind::Exact << "example.com";
+		QTest::newRow ("suffix") << ".*\\.example\\.com$" << HostsIndex::Kind::Suffix << ".example.com";
+		QTest::newRow ("anchored suffix") << "^.*\\.example\\.com$" << HostsIndex::Kind::Suffix << ".example.com";
+		QTest::newRow ("subdomain") << "^(.*\\.)?example\\.com$" << HostsIndex::Kind::Subdomain << "example.com";
+		QTest::newRow ("substring") << ".*example\\.com.*" << HostsIndex::Kind::Substring << "example.com";
+		QTest::newRow ("dashes") << "^my-host_1\\.example\\.com$" << HostsIndex::Kind::Exact << "my-host_1.example.com";
+		QTest::newRow ("upper case") << "^Example\\.COM$" << HostsIndex::Kind::Exact << "example.com";
+
+		QTest::newRow ("unescaped dot") << ".*example.com.*" << HostsIndex::Kind::Residual << "";
+		QTest::newRow ("unanchored") << "example\\.com" << HostsIndex::Kind::Residual << "";
+		QTest::newRow ("unanchored start") << "example\\.com$" << HostsIndex::Kind::Residual << "";
+		QTest::newRow ("unanchored end") << "^.*\\.example\\.com" << HostsIndex::Kind::Residual << "";
+		QTest::newRow ("unanchored subdomain") << "(.*\\.)?example\\.com$" << HostsIndex::Kind::Residual << "";
+		QTest::newRow ("prefix") << "^example\\..*" << HostsIndex::Kind::Residual << "";
+		QTest::newRow ("alternation") << "^(foo|bar)\\.com$" << HostsIndex::Kind::Residual << "";
+		QTest::newRow ("repeated dots") << "^example\\.*com$" << HostsIndex::Kind::Residual << "";
+		QTest::newRow ("everything") << ".*" << HostsIndex::Kind::Residual << "";
+		QTest::newRow ("empty literal") << "^.*$" << HostsIndex::Kind::Residual << "";
+	}
+
+	void HostsIndexTest::classify ()
+	{
+		QFETCH (QString, pattern);
+		QFETCH (HostsIndex::Kind, kind);
+		QFETCH (QString, literal);
+
+		QString parsed;
+		QCOMPARE (HostsIndex::Classify (Rx (pattern), &parsed), kind);
+		if (kind != HostsIndex::Kind::Residual)
+			QCOMPARE (parsed, literal);
+	}
+
+	void HostsIndexTest::matchesAsRegExp ()
+	{
+		const QList<Util::RegExp> patterns
+		{
+			Rx ("^example\\.com$"),
+			Rx (".*\\.example\\.com$"),
+			Rx ("^(.*\\.)?example\\.org$"),
+			Rx (".*ample\\.net.*"),
+			Rx (".*example.com.*"),
+			Rx ("^(foo|bar)\\.example\\.com$"),
+			Rx ("example\\.com"),
+			Rx ("^example\\.com$"),
+			{ "^Example\\.com$", Qt::CaseSensitive }
+		};
+
+		const QStringList hosts
+		{
+			"example.com",
+			"EXAMPLE.com",
+			"Example.com",
+			"www.example.com",
+			"foo.example.com",
+			"notexample.com",
+			"example-com",
+			"example.com.evil.org",
+			"example.org",
+			"www.example.org",
+			"wwwexample.org",
+			"example.net",
+			"sub.example.net.other",
+			"ample.net",
+			"",
+			"com"
+		};
+
+		HostsIndex index;
+		for (int i = 0; i < patterns.size (); ++i)
+			index.Add (patterns.at (i), i);
+
+		for (const auto& host : hosts)
+		{
+			QList<int> expected;
+			for (int i = 0; i < patterns.size (); ++i)
+				if (patterns.at (i).Matches (host))
+					expected << i;
+
+			auto actual = index.Match (host);
+			std::sort (actual.begin (), actual.end ());
+			actual.erase (std::unique (actual.begin (), actual.end ()), actual.end ());
+
+			QCOMPARE (actual, expected);
+		}
+	}
+
+	void HostsIndexTest::caseInsensitive ()
+	{
+		HostsIndex index;
+		index.Add (Rx ("^(.*\\.)?Example\\.COM$"), 0);
+
+		QCOMPARE (index.Match ("WWW.EXAMPLE.COM"), QList<int> { 0 });
+		QCOMPARE (index.Match ("example.com"), QList<int> { 0 });
+		QCOMPARE (index.Match ("example.co"), QList<int> {});
+	}
+
+	void HostsIndexTest::benchmarkIndex ()
+	{
+		const auto& patterns = MakeBenchPatterns ();
+		const auto& hosts = MakeBenchHosts ();
+
+		HostsIndex index;
+		for (int i = 0; i < patterns.size (); ++i)
+			index.Add (patterns.at (i), i);
+
+		QBENCHMARK
+		{
+			for (const auto& host : hosts)
+				index.Match (host);
+		}
+	}
+
+	void HostsIndexTest::benchmarkRegExps ()
+	{
+		const auto& patterns = MakeBenchPatterns ();
+		const auto& hosts = MakeBenchHosts ();
+
+		QBENCHMARK
+		{
+			for (const auto& host : hosts)
+				std::count_if (patterns.begin (), patterns.end (),
+						[&host] (const Util::RegExp& rx) { return rx.Matches (host); });
+		}
+	}
+}
+}
@@ -110,6 +110,8 @@ namespace XProxy
 		settings.setValue ("Urls", urls);
 		settings.setValue ("LastUpdate", LastUpdate_);
 		settings.endGroup ();
+
+		emit urlsChanged ();
 	}
 
 	void UrlListScript::SetUrlsImpl (const QStringList& urls)
@@ -29,7 +29,9 @@
 
 #include "customcookiejar.h"
 #include <memory>
+#include <algorithm>
 #include <QNetworkCookie>
+#include <QHostAddress>
 #include <QtDebug>
 #include <QDateTime>
 
@@ -37,11 +39,58 @@ namespace LeechCraft
 {
 namespace Util
 {
+	namespace
+	{
+		QString GetIndexDomain (const QString& domain)
+		{
+			return domain.startsWith ('.') ? domain.mid (1) : domain;
+		}
+
+		QByteArray GetCookieKey (const QNetworkCookie& cookie)
+		{
+			return cookie.domain ().toUtf8 () + '\0' +
+					cookie.path ().toUtf8 () + '\0' +
+					cookie.name ();
+		}
+
+		bool IsSameCookie (const QNetworkCookie& left, const QNetworkCookie& right)
+		{
+			return left.name () == right.name () &&
+					left.domain () == right.domain () &&
+					left.path () == right.path ();
+		}
+
+		bool IsParentPath (const QString& path, const QString& cookiePath)
+		{
+			if (cookiePath.isEmpty ())
+				return true;
+
+			if (!path.startsWith (cookiePath))
+				return false;
+
+			return path.size () == cookiePath.size () ||
+					cookiePath.endsWith ('/') ||
+					path.at (cookiePath.size ()) == '/';
+		}
+
+		bool IsExpired (const QNetworkCookie& cookie, const QDateTime& now)
+		{
+			return !cookie.isSessionCookie () && cookie.expirationDate () < now;
+		}
+
+		bool IsIpAddress (const QString& str)
+		{
+			QHostAddress address;
+			return address.setAddress (str);
+		}
+	}
+
 	CustomCookieJar::CustomCookieJar (QObject *parent)
 	: QNetworkCookieJar (parent)
 	, FilterTrackingCookies_ (false)
 	, Enabled_ (true)
 	, MatchDomainExactly_ (false)
+	, NeedsFullSave_ (false)
 	{
 	}
 
@@ -66,68 +115,102 @@ namespace Util
 
 	void CustomCookieJar::SetWhitelist (const QList<QRegExp>& list)
 	{
-		WL_ = list;
+		WL_.Set (list);
 	}
 
 	void CustomCookieJar::SetBlacklist (const QList<QRegExp>& list)
 	{
-		BL_ = list;
+		BL_.Set (list);
 	}
 
 	QByteArray CustomCookieJar::Save () const
 	{
-		QList<QNetworkCookie> cookies = allCookies ();
 		QByteArray result;
-		for (const auto& cookie : cookies)
-		{
-			if (cookie.isSessionCookie ())
-				continue;
+		for (const auto& cookies : Domain2Cookies_)
+			for (const auto& cookie : cookies)
+			{
+				if (cookie.isSessionCookie ())
+					continue;
 
-			result += cookie.toRawForm ();
-			result += "\n";
-		}
+				result += cookie.toRawForm ();
+				result += "\n";
+			}
 		return result;
 	}
 
 	void CustomCookieJar::Load (const QByteArray& data)
 	{
-		QList<QNetworkCookie> cookies, filteredCookies;
-		for (const auto& ba : data.split ('\n'))
-			cookies << QNetworkCookie::parseCookies (ba);
+		Domain2Cookies_.clear ();
 
 		const auto& now = QDateTime::currentDateTime ();
-		for (const auto& cookie : cookies)
-		{
-			if (FilterTrackingCookies_ &&
-					cookie.name ().startsWith ("__utm"))
-				continue;
+		for (const auto& ba : data.split ('\n'))
+			for (const auto& cookie : QNetworkCookie::parseCookies (ba))
+			{
+				if (FilterTrackingCookies_ &&
+						cookie.name ().startsWith ("__utm"))
+					continue;
 
-			if (cookie.expirationDate () < now)
-				continue;
+				// Expired cookies are how TakeChanges() marks removals.
+				if (IsExpired (cookie, now))
+					Remove (cookie);
+				else
+					Insert (cookie);
+			}
+
+		Changes_.clear ();
+		NeedsFullSave_ = false;
+	}
+
+	bool CustomCookieJar::HasChanges () const
+	{
+		return NeedsFullSave_ || !Changes_.isEmpty ();
+	}
+
+	bool CustomCookieJar::NeedsFullSave () const
+	{
+		return NeedsFullSave_;
+	}
 
-			filteredCookies << cookie;
+	QByteArray CustomCookieJar::TakeChanges ()
+	{
+		QByteArray result;
+		for (const auto& cookie : Changes_)
+		{
+			result += cookie.toRawForm ();
+			result += "\n";
 		}
-		setAllCookies (filteredCookies);
+
+		Changes_.clear ();
+		NeedsFullSave_ = false;
+
+		return result;
 	}
 
 	void CustomCookieJar::CollectGarbage ()
 	{
-		const auto& cookies = allCookies ();
-		QList<QNetworkCookie> result;
 		const auto& now = QDateTime::currentDateTime ();
-		for (const auto& cookie : cookies)
+
+		int before = 0;
+		int after = 0;
+		for (auto i = Domain2Cookies_.begin (); i != Domain2Cookies_.end (); )
 		{
-			if (!cookie.isSessionCookie () &&
-					cookie.expirationDate () < now)
-				continue;
+			before += i->size ();
 
-			if (result.contains (cookie))
-				continue;
+			// The removed cookies are expired, so they will be dropped
+			// on the next load anyway and need not be recorded.
+			auto& cookies = *i;
+			cookies.erase (std::remove_if (cookies.begin (), cookies.end (),
+						[&now] (const QNetworkCookie& cookie) { return IsExpired (cookie, now); }),
+					cookies.end ());
+
+			after += cookies.size ();
 
-			result << cookie;
+			if (cookies.isEmpty ())
+				i = Domain2Cookies_.erase (i);
+			else
+				++i;
 		}
-		qDebug () << Q_FUNC_INFO << cookies.size () << result.size ();
-		setAllCookies (result);
+		qDebug () << Q_FUNC_INFO << before << after;
 	}
 
 	QList<QNetworkCookie> CustomCookieJar::cookiesForUrl (const QUrl& url) const
@@ -135,11 +218,49 @@ namespace Util
 		if (!Enabled_)
 			return {};
 
-		QList<QNetworkCookie> filtered;
-		for (const auto& cookie : QNetworkCookieJar::cookiesForUrl (url))
-			if (!filtered.contains (cookie))
-				filtered << cookie;
-		return filtered;
+		const auto& host = url.host ();
+		const auto& path = url.path ().isEmpty () ? QString ("/") : url.path ();
+		const bool isSecure = url.scheme () == "https";
+		const auto& now = QDateTime::currentDateTime ();
+
+		// Only the host itself and its parent domains can have the
+		// cookies matching it.
+		QList<QNetworkCookie> result;
+		for (auto domain = host; !domain.isEmpty (); )
+		{
+			const auto pos = Domain2Cookies_.find (domain);
+			if (pos != Domain2Cookies_.end ())
+				for (const auto& cookie : *pos)
+				{
+					if (cookie.isSecure () && !isSecure)
+						continue;
+
+					if (!IsParentPath (path, cookie.path ()))
+						continue;
+
+					if (IsExpired (cookie, now))
+						continue;
+
+					// A cookie without the leading dot in the domain is
+					// only sent to the very same host.
+					if (!cookie.domain ().startsWith ('.') &&
+							cookie.domain () != host)
+						continue;
+
+					result << cookie;
+				}
+
+			const auto dotPos = domain.indexOf ('.');
+			if (dotPos < 0)
+				break;
+			domain = domain.mid (dotPos + 1);
+		}
+
+		std::stable_sort (result.begin (), result.end (),
+				[] (const QNetworkCookie& left, const QNetworkCookie& right)
+					{ return left.path ().size () > right.path ().size (); });
+
+		return result;
 	}
 
 	namespace
@@ -161,16 +282,81 @@ namespace Util
 			return idx > 0 && domain.at (idx - 1) == '.';
 		}
 
-		bool Check (const QList<QRegExp>& list, const QString& str)
+		QString GetDefaultPath (const QUrl& url)
 		{
-			for (auto& rx : list)
-				if (str == rx.pattern () || rx.exactMatch (str))
-					return true;
+			const auto& path = url.path ();
+			const auto pos = path.lastIndexOf ('/');
+			return pos > 0 ? path.left (pos) : QString ("/");
+		}
 
-			return false;
+		bool IsValidDomain (const QString& cookieDomain, const QUrl& url)
+		{
+			const auto& host = url.host ();
+			const auto& domain = GetIndexDomain (cookieDomain);
+			if (domain != host && !host.endsWith ('.' + domain))
+				return false;
+
+			// Refuse cookies for the whole public suffixes like .co.uk.
+			return '.' + domain != url.topLevelDomain ();
+		}
+	}
+
+	void CustomCookieJar::DomainList::Set (const QList<QRegExp>& list)
+	{
+		Exact_.clear ();
+		Patterns_.clear ();
+		Cache_.clear ();
+
+		const QString regexpChars { "\\^$.*+?()[]{}|" };
+		const QString wildcardChars { "*?[]" };
+		for (const auto& rx : list)
+		{
+			Exact_ << rx.pattern ();
+
+			QString special;
+			switch (rx.patternSyntax ())
+			{
+			case QRegExp::FixedString:
+				break;
+			case QRegExp::Wildcard:
+			case QRegExp::WildcardUnix:
+				special = wildcardChars;
+				break;
+			default:
+				special = regexpChars;
+				break;
+			}
+
+			// Patterns without special characters only match the same
+			// string, which is already covered by Exact_.
+			if (std::any_of (special.begin (), special.end (),
+					[&rx] (const QChar& c) { return rx.pattern ().contains (c); }))
+				Patterns_ << rx;
 		}
 	}
 
+	bool CustomCookieJar::DomainList::Matches (const QString& str)
+	{
+		if (Exact_.contains (str))
+			return true;
+
+		if (Patterns_.isEmpty ())
+			return false;
+
+		const auto pos = Cache_.find (str);
+		if (pos != Cache_.end ())
+			return *pos;
+
+		const bool result = std::any_of (Patterns_.begin (), Patterns_.end (),
+				[&str] (const QRegExp& rx) { return rx.exactMatch (str); });
+
+		if (Cache_.size () > 10000)
+			Cache_.clear ();
+		Cache_ [str] = result;
+
+		return result;
+	}
+
 	bool CustomCookieJar::setCookiesFromUrl (const QList<QNetworkCookie>& cookieList, const QUrl& url)
 	{
 		if (!Enabled_)
@@ -186,7 +372,7 @@ namespace Util
 			bool checkWhitelist = false;
 			std::shared_ptr<void> wlGuard (nullptr, [&] (void*)
 					{
-						if (checkWhitelist && Check (WL_, cookie.domain ()))
+						if (checkWhitelist && WL_.Matches (cookie.domain ()))
 							filtered << cookie;
 					});
 
@@ -203,11 +389,134 @@ namespace Util
 				continue;
 			}
 
-			if (!Check (BL_, cookie.domain ()))
+			if (!BL_.Matches (cookie.domain ()))
 				filtered << cookie;
 		}
 
-		return QNetworkCookieJar::setCookiesFromUrl (filtered, url);
+		const auto& now = QDateTime::currentDateTime ();
+		const auto& defaultPath = GetDefaultPath (url);
+
+		bool changed = false;
+		for (auto cookie : filtered)
+		{
+			if (cookie.path ().isEmpty ())
+				cookie.setPath (defaultPath);
+
+			cookie.setDomain (cookie.domain ().toLower ());
+			if (!cookie.domain ().startsWith ('.') &&
+					!IsIpAddress (cookie.domain ()))
+				cookie.setDomain ('.' + cookie.domain ());
+
+			if (!IsValidDomain (cookie.domain (), url))
+				continue;
+
+			if (IsExpired (cookie, now))
+				changed = Remove (cookie) || changed;
+			else
+				changed = Insert (cookie) || changed;
+		}
+		return changed;
+	}
+
+	QList<QNetworkCookie> CustomCookieJar::allCookies () const
+	{
+		QList<QNetworkCookie> result;
+		for (const auto& cookies : Domain2Cookies_)
+			result += cookies;
+		return result;
+	}
+
+	void CustomCookieJar::setAllCookies (const QList<QNetworkCookie>& cookies)
+	{
+		Domain2Cookies_.clear ();
+		for (const auto& cookie : cookies)
+			Insert (cookie);
+
+		Changes_.clear ();
+		NeedsFullSave_ = true;
+	}
+
+#if QT_VERSION >= 0x050000
+	bool CustomCookieJar::insertCookie (const QNetworkCookie& cookie)
+	{
+		return Insert (cookie);
+	}
+
+	bool CustomCookieJar::updateCookie (const QNetworkCookie& cookie)
+	{
+		return Insert (cookie);
+	}
+
+	bool CustomCookieJar::deleteCookie (const QNetworkCookie& cookie)
+	{
+		return Remove (cookie);
+	}
+#endif
+
+	bool CustomCookieJar::Insert (const QNetworkCookie& cookie)
+	{
+		auto& cookies = Domain2Cookies_ [GetIndexDomain (cookie.domain ())];
+
+		bool hadPersistent = false;
+		const auto pos = std::find_if (cookies.begin (), cookies.end (),
+				[&cookie] (const QNetworkCookie& other) { return IsSameCookie (cookie, other); });
+		if (pos != cookies.end ())
+		{
+			if (pos->toRawForm () == cookie.toRawForm ())
+				return false;
+
+			hadPersistent = !pos->isSessionCookie ();
+			*pos = cookie;
+		}
+		else
+			cookies << cookie;
+
+		RecordChange (cookie, hadPersistent);
+		return true;
+	}
+
+	bool CustomCookieJar::Remove (const QNetworkCookie& cookie)
+	{
+		const auto bucket = Domain2Cookies_.find (GetIndexDomain (cookie.domain ()));
+		if (bucket == Domain2Cookies_.end ())
+			return false;
+
+		auto& cookies = *bucket;
+		const auto pos = std::find_if (cookies.begin (), cookies.end (),
+				[&cookie] (const QNetworkCookie& other) { return IsSameCookie (cookie, other); });
+		if (pos == cookies.end ())
+			return false;
+
+		const bool wasPersistent = !pos->isSessionCookie ();
+		auto removed = *pos;
+		cookies.erase (pos);
+		if (cookies.isEmpty ())
+			Domain2Cookies_.erase (bucket);
+
+		if (wasPersistent)
+		{
+			removed.setExpirationDate (QDateTime::fromTime_t (0));
+			RecordChange (removed, true);
+		}
+		return true;
+	}
+
+	void CustomCookieJar::RecordChange (const QNetworkCookie& cookie, bool hadPersistent)
+	{
+		if (!cookie.isSessionCookie ())
+		{
+			Changes_ [GetCookieKey (cookie)] = cookie;
+			return;
+		}
+
+		// A session cookie isn't saved, but it may shadow a persistent one
+		// that needs to be removed from the saved data.
+		if (!hadPersistent)
+			return;
+
+		auto tombstone = cookie;
+		tombstone.setExpirationDate (QDateTime::fromTime_t (0));
+		Changes_ [GetCookieKey (cookie)] = tombstone;
 	}
 }
 }
@@ -30,7 +30,10 @@
 #pragma once
 
 #include <QNetworkCookieJar>
+#include <QNetworkCookie>
 #include <QByteArray>
+#include <QHash>
+#include <QSet>
 #include <QRegExp>
 #include "networkconfig.h"
 
@@ -43,6 +46,12 @@ namespace Util
 	 * Allows one to filter tracking cookies, filter duplicate cookies
 	 * and has unlimited storage period.
 	 *
+	 * The cookies are indexed by their domains, so looking up the
+	 * cookies for an URL only touches the cookies of the URL host and
+	 * its parent domains. The jar also keeps track of the changes since
+	 * the last save, so that they could be persisted incrementally, see
+	 * TakeChanges().
+	 *
 	 * @ingroup NetworkUtil
 	 */
 	class UTIL_NETWORK_API CustomCookieJar : public QNetworkCookieJar
@@ -53,8 +62,23 @@ namespace Util
 		bool Enabled_;
 		bool MatchDomainExactly_;
 
-		QList<QRegExp> WL_;
-		QList<QRegExp> BL_;
+		class DomainList
+		{
+			QSet<QString> Exact_;
+			QList<QRegExp> Patterns_;
+			QHash<QString, bool> Cache_;
+		public:
+			void Set (const QList<QRegExp>&);
+			bool Matches (const QString&);
+		};
+
+		DomainList WL_;
+		DomainList BL_;
+
+		QHash<QString, QList<QNetworkCookie>> Domain2Cookies_;
+
+		QHash<QByteArray, QNetworkCookie> Changes_;
+		bool NeedsFullSave_;
 	public:
 		/** @brief Constructs the cookie jar.
 		 *
@@ -131,20 +155,57 @@ namespace Util
 		QByteArray Save () const;
 
 		/** Restores the cookies from the array previously obtained
-		 * from Save().
+		 * from Save(), possibly followed by the results of
+		 * TakeChanges().
+		 *
+		 * The later cookies replace the earlier ones with the same
+		 * name, domain and path, and the expired ones are dropped.
 		 *
 		 * @param[in] data Serialized cookies.
 		 * @sa Save()
 		 */
 		void Load (const QByteArray& data);
 
-		/** Removes duplicate cookies.
+		/** @brief Returns whether the cookies changed since the last
+		 * TakeChanges() call.
+		 *
+		 * @return Whether there are unsaved changes.
+		 *
+		 * @sa NeedsFullSave()
+		 */
+		bool HasChanges () const;
+
+		/** @brief Returns whether the changes can't be expressed
+		 * incrementally.
+		 *
+		 * This is the case after the whole contents of the jar has been
+		 * replaced via setAllCookies(), so the result of Save() should
+		 * be written instead of the result of TakeChanges().
+		 *
+		 * @return Whether a full save is required.
+		 */
+		bool NeedsFullSave () const;
+
+		/** @brief Returns the persistent cookies changed since the
+		 * last call and forgets them.
+		 *
+		 * The result has the same format as the one of Save(), and the
+		 * removed cookies are represented by already expired ones, so
+		 * appending the result to the previously saved data and passing
+		 * the whole thing to Load() restores the current state.
+		 *
+		 * @return The serialized changed cookies.
+		 */
+		QByteArray TakeChanges ();
+
+		/** Removes expired cookies.
 		 */
 		void CollectGarbage ();
 
 		/** @brief Returns cookies for the given url.
 		 *
-		 * This function automatically filters out duplicate cookies.
+		 * The cookies are unique by their name, domain and path, and
+		 * the ones with longer paths come first.
 		 *
 		 * If the cookie jar is disabled, this function does nothing.
 		 *
@@ -163,8 +224,29 @@ namespace Util
 		 */
 		bool setCookiesFromUrl (const QList<QNetworkCookie>& cookieList, const QUrl& url);
 
-		using QNetworkCookieJar::allCookies;
-		using QNetworkCookieJar::setAllCookies;
+		/** @brief Returns all the cookies in the jar.
+		 *
+		 * @return The list of all cookies.
+		 */
+		QList<QNetworkCookie> allCookies () const;
+
+		/** @brief Replaces the contents of the jar with the given list.
+		 *
+		 * @param[in] cookies The new cookies.
+		 *
+		 * @sa NeedsFullSave()
+		 */
+		void setAllCookies (const QList<QNetworkCookie>& cookies);
+
+#if QT_VERSION >= 0x050000
+		bool insertCookie (const QNetworkCookie& cookie);
+		bool updateCookie (const QNetworkCookie& cookie);
+		bool deleteCookie (const QNetworkCookie& cookie);
+#endif
+	private:
+		bool Insert (const QNetworkCookie& cookie);
+		bool Remove (const QNetworkCookie& cookie);
+		void RecordChange (const QNetworkCookie& cookie, bool hadPersistent);
 	};
 }
 }
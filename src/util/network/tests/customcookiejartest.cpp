@@ -0,0 +1,261 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "customcookiejartest.h"
+#include <algorithm>
+#include <QtTest>
+#include <customcookiejar.h>
+
+QTEST_MAIN (LeechCraft::Util::CustomCookieJarTest)
+
+namespace LeechCraft
+{
+namespace Util
+{
+	namespace
+	{
+		QNetworkCookie MakeCookie (const QByteArray& name, const QByteArray& value,
+				const QString& domain = {}, const QString& path = {}, bool persistent = true)
+		{
+			QNetworkCookie cookie { name, value };
+			cookie.setDomain (domain);
+			cookie.setPath (path);
+			if (persistent)
+				cookie.setExpirationDate (QDateTime::currentDateTime ().addDays (1));
+			return cookie;
+		}
+
+		QStringList GetNames (const QList<QNetworkCookie>& cookies)
+		{
+			QStringList result;
+			for (const auto& cookie : cookies)
+				result << cookie.name ();
+			result.sort ();
+			return result;
+		}
+
+		QList<QByteArray> GetRawForms (const QList<QNetworkCookie>& cookies)
+		{
+			QList<QByteArray> result;
+			for (const auto& cookie : cookies)
+				if (!cookie.isSessionCookie ())
+					result << cookie.toRawForm ();
+			std::sort (result.begin (), result.end ());
+			return result;
+		}
+	}
+
+	void CustomCookieJarTest::testDomainMatching ()
+	{
+		CustomCookieJar jar;
+		jar.setCookiesFromUrl ({ MakeCookie ("parent", "1", "example.com") }, QUrl ("http://example.com/"));
+		jar.setCookiesFromUrl ({ MakeCookie ("child", "1") }, QUrl ("http://a.example.com/"));
+		jar.setCookiesFromUrl ({ MakeCookie ("other", "1") }, QUrl ("http://notexample.com/"));
+
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl ("http://b.a.example.com/"))),
+				QStringList ({ "child", "parent" }));
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl ("http://example.com/"))),
+				QStringList ({ "parent" }));
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl ("http://notexample.com/"))),
+				QStringList ({ "other" }));
+		QVERIFY (jar.cookiesForUrl (QUrl ("http://com/")).isEmpty ());
+
+		QVERIFY (!jar.setCookiesFromUrl ({ MakeCookie ("foreign", "1", "other.com") },
+					QUrl ("http://example.com/")));
+		QCOMPARE (jar.allCookies ().size (), 3);
+	}
+
+	void CustomCookieJarTest::testPathAndSecure ()
+	{
+		CustomCookieJar jar;
+		const QUrl url { "https://example.com/dir/page" };
+		jar.setCookiesFromUrl ({
+				MakeCookie ("root", "1", {}, "/"),
+				MakeCookie ("default", "1"),
+				MakeCookie ("deep", "1", {}, "/dir/sub")
+			}, url);
+
+		auto secure = MakeCookie ("secure", "1", {}, "/");
+		secure.setSecure (true);
+		jar.setCookiesFromUrl ({ secure }, url);
+
+		const auto& cookies = jar.cookiesForUrl (QUrl ("https://example.com/dir/other"));
+		QCOMPARE (GetNames (cookies), QStringList ({ "default", "root", "secure" }));
+		QCOMPARE (cookies.first ().name (), QByteArray ("default"));
+
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl ("http://example.com/directory"))),
+				QStringList ({ "root" }));
+	}
+
+	void CustomCookieJarTest::testReplace ()
+	{
+		CustomCookieJar jar;
+		const QUrl url { "http://example.com/" };
+		const auto& cookie = MakeCookie ("name", "1", {}, "/");
+
+		QVERIFY (jar.setCookiesFromUrl ({ cookie }, url));
+		QVERIFY (!jar.setCookiesFromUrl ({ cookie }, url));
+		QVERIFY (jar.setCookiesFromUrl ({ MakeCookie ("name", "2", {}, "/") }, url));
+
+		const auto& cookies = jar.cookiesForUrl (url);
+		QCOMPARE (cookies.size (), 1);
+		QCOMPARE (cookies.first ().value (), QByteArray ("2"));
+	}
+
+	void CustomCookieJarTest::testExpiredRemoves ()
+	{
+		CustomCookieJar jar;
+		const QUrl url { "http://example.com/" };
+		jar.setCookiesFromUrl ({ MakeCookie ("name", "1", {}, "/") }, url);
+
+		auto expired = MakeCookie ("name", "", {}, "/");
+		expired.setExpirationDate (QDateTime::currentDateTime ().addDays (-1));
+		QVERIFY (jar.setCookiesFromUrl ({ expired }, url));
+
+		QVERIFY (jar.cookiesForUrl (url).isEmpty ());
+		QVERIFY (jar.allCookies ().isEmpty ());
+	}
+
+	void CustomCookieJarTest::testPublicSuffix ()
+	{
+		CustomCookieJar jar;
+		QVERIFY (!jar.setCookiesFromUrl ({ MakeCookie ("super", "1", "com") },
+					QUrl ("http://example.com/")));
+		QVERIFY (!jar.setCookiesFromUrl ({ MakeCookie ("super", "1", "co.uk") },
+					QUrl ("http://example.co.uk/")));
+		QVERIFY (jar.allCookies ().isEmpty ());
+	}
+
+	void CustomCookieJarTest::testLists ()
+	{
+		CustomCookieJar jar;
+		jar.SetFilterTrackingCookies (true);
+		jar.SetBlacklist ({ QRegExp (".*\\.ads\\.com"), QRegExp ("tracker.org") });
+		jar.SetWhitelist ({ QRegExp ("good.org") });
+
+		jar.setCookiesFromUrl ({ MakeCookie ("a", "1") }, QUrl ("http://x.ads.com/"));
+		jar.setCookiesFromUrl ({ MakeCookie ("b", "1") }, QUrl ("http://tracker.org/"));
+		jar.setCookiesFromUrl ({ MakeCookie ("c", "1") }, QUrl ("http://fine.org/"));
+		jar.setCookiesFromUrl ({ MakeCookie ("__utma", "1") }, QUrl ("http://fine.org/"));
+		jar.setCookiesFromUrl ({ MakeCookie ("__utma", "1") }, QUrl ("http://good.org/"));
+
+		QCOMPARE (GetNames (jar.allCookies ()), QStringList ({ "__utma", "c" }));
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl ("http://good.org/"))), QStringList ({ "__utma" }));
+	}
+
+	void CustomCookieJarTest::testChanges ()
+	{
+		CustomCookieJar jar;
+		const QUrl url { "http://example.com/" };
+		QVERIFY (!jar.HasChanges ());
+
+		jar.setCookiesFromUrl ({ MakeCookie ("session", "1", {}, "/", false) }, url);
+		QVERIFY (!jar.HasChanges ());
+
+		jar.setCookiesFromUrl ({ MakeCookie ("persistent", "1", {}, "/") }, url);
+		QVERIFY (jar.HasChanges ());
+		QVERIFY (!jar.NeedsFullSave ());
+
+		const auto& changes = jar.TakeChanges ();
+		QVERIFY (changes.contains ("persistent=1"));
+		QVERIFY (!changes.contains ("session"));
+		QVERIFY (!jar.HasChanges ());
+		QVERIFY (jar.TakeChanges ().isEmpty ());
+
+		jar.setAllCookies ({});
+		QVERIFY (jar.HasChanges ());
+		QVERIFY (jar.NeedsFullSave ());
+		jar.TakeChanges ();
+		QVERIFY (!jar.NeedsFullSave ());
+	}
+
+	void CustomCookieJarTest::testSessionShadowing ()
+	{
+		CustomCookieJar jar;
+		const QUrl url { "http://example.com/" };
+		jar.setCookiesFromUrl ({ MakeCookie ("name", "1", {}, "/") }, url);
+		const auto& saved = jar.Save ();
+		jar.TakeChanges ();
+
+		jar.setCookiesFromUrl ({ MakeCookie ("name", "2", {}, "/", false) }, url);
+		QVERIFY (jar.HasChanges ());
+
+		CustomCookieJar restored;
+		restored.Load (saved + jar.TakeChanges ());
+		QVERIFY (restored.allCookies ().isEmpty ());
+	}
+
+	void CustomCookieJarTest::testIncrementalLoad ()
+	{
+		CustomCookieJar jar;
+		const QUrl url { "http://example.com/" };
+		jar.setCookiesFromUrl ({
+				MakeCookie ("kept", "1", {}, "/"),
+				MakeCookie ("changed", "1", {}, "/"),
+				MakeCookie ("removed", "1", {}, "/")
+			}, url);
+
+		auto data = jar.Save ();
+		jar.TakeChanges ();
+
+		auto removed = MakeCookie ("removed", "", {}, "/");
+		removed.setExpirationDate (QDateTime::currentDateTime ().addDays (-1));
+		jar.setCookiesFromUrl ({ MakeCookie ("changed", "2", {}, "/"), removed }, url);
+		data += jar.TakeChanges ();
+
+		jar.setCookiesFromUrl ({ MakeCookie ("added", "1", "example.com", "/") }, url);
+		data += jar.TakeChanges ();
+
+		CustomCookieJar restored;
+		restored.Load (data);
+		QCOMPARE (GetRawForms (restored.allCookies ()), GetRawForms (jar.allCookies ()));
+		QCOMPARE (GetNames (restored.allCookies ()), QStringList ({ "added", "changed", "kept" }));
+		QVERIFY (!restored.HasChanges ());
+	}
+
+	void CustomCookieJarTest::benchmarkCookiesForUrl ()
+	{
+		CustomCookieJar jar;
+
+		QList<QNetworkCookie> cookies;
+		for (int i = 0; i < 50000; ++i)
+			cookies << MakeCookie ("cookie" + QByteArray::number (i), "value",
+					QString (".domain%1.com").arg (i / 5), "/");
+		jar.setAllCookies (cookies);
+
+		const QUrl url { "http://www.domain42.com/path/to/resource.png" };
+		QCOMPARE (jar.cookiesForUrl (url).size (), 5);
+
+		QBENCHMARK
+		{
+			jar.cookiesForUrl (url);
+		}
+	}
+}
+}